@@ -2,19 +2,28 @@
 #include <velk/api/callback.h>
 #include <velk/api/event.h>
 #include <velk/api/function.h>
+#include <velk/api/future.h>
 #include <velk/api/hierarchy.h>
 #include <velk/api/hive/object_hive.h>
 #include <velk/api/hive/raw_hive.h>
 #include <velk/api/property.h>
 #include <velk/api/state.h>
 #include <velk/api/velk.h>
+#include <velk/ext/event.h>
 #include <velk/ext/object.h>
 #include <velk/interface/hive/intf_hive_store.h>
 #include <velk/interface/intf_metadata.h>
+#include <velk/plugins/animator/animator.h>
 
 #include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using namespace velk;
 
@@ -30,6 +39,7 @@ public:
         (EVT, on_changed),
         (FN, void, do_nothing),
         (FN, void, add, (int, x), (float, y)),
+        (FN, float, scale, (float, x)),
         (FN_RAW, raw_fn)
     )
 };
@@ -38,6 +48,39 @@ class BenchWidget : public ext::Object<BenchWidget, IBenchWidget>
 {
     void fn_do_nothing() override {}
     void fn_add(int, float) override {}
+    float fn_scale(float x) override { return x * 2.f; }
+    IAny::Ptr fn_raw_fn(FnArgs) override { return nullptr; }
+};
+
+// BenchWidget that reuses the memory of destroyed instances.
+class RecycledBenchWidget : public ext::Object<RecycledBenchWidget, IBenchWidget>
+{
+public:
+    VELK_RECYCLE_INSTANCES(1024);
+
+private:
+    void fn_do_nothing() override {}
+    void fn_add(int, float) override {}
+    float fn_scale(float x) override { return x * 2.f; }
+    IAny::Ptr fn_raw_fn(FnArgs) override { return nullptr; }
+};
+
+class IBenchArrayWidget : public Interface<IBenchArrayWidget>
+{
+public:
+    VELK_INTERFACE(
+        (ARR, float, samples)
+    )
+};
+
+class BenchArrayWidget : public ext::Object<BenchArrayWidget, IBenchArrayWidget>
+{};
+
+class ObservedBenchWidget : public ext::ObservedObject<ObservedBenchWidget, IBenchWidget>
+{
+    void fn_do_nothing() override {}
+    void fn_add(int, float) override {}
+    float fn_scale(float x) override { return x * 2.f; }
     IAny::Ptr fn_raw_fn(FnArgs) override { return nullptr; }
 };
 
@@ -50,10 +93,147 @@ static void ensureRegistered()
     static bool done = false;
     if (!done) {
         instance().type_registry().register_type<BenchWidget>();
+        instance().type_registry().register_type<ObservedBenchWidget>();
+        instance().type_registry().register_type<BenchArrayWidget>();
+        instance().type_registry().register_type<RecycledBenchWidget>();
         done = true;
     }
 }
 
+// ---------------------------------------------------------------------------
+// Startup
+// ---------------------------------------------------------------------------
+
+// Times the first instance() call, which constructs the VelkInstance and registers the built-in
+// types. Registered first so that it runs before any other benchmark touches the instance.
+static void BM_StartupInstance(benchmark::State& state)
+{
+    static bool measured = false;
+    if (measured) {
+        state.SkipWithError("the instance is constructed once per process");
+        return;
+    }
+    measured = true;
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+        benchmark::DoNotOptimize(&instance());
+        auto end = std::chrono::steady_clock::now();
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+    }
+}
+BENCHMARK(BM_StartupInstance)->Iterations(1)->UseManualTime()->Unit(benchmark::kMicrosecond);
+
+namespace {
+
+// Factory of a synthetic class: a BenchWidget registered under a class UID of its own.
+class SyntheticFactory : public ext::ObjectFactory<BenchWidget>
+{
+public:
+    explicit SyntheticFactory(uint64_t index)
+        : info_{Uid{0x5e17e7c0ffee0000ull, index},
+                "SyntheticWidget",
+                BenchWidget::get_factory().get_class_info().interfaces,
+                BenchWidget::get_factory().get_class_info().members,
+                BenchWidget::get_factory().get_class_info().memberTable}
+    {}
+    const ClassInfo& get_class_info() const override { return info_; }
+
+private:
+    ClassInfo info_;
+};
+
+std::vector<std::unique_ptr<SyntheticFactory>> make_synthetic_factories(int64_t count)
+{
+    std::vector<std::unique_ptr<SyntheticFactory>> factories;
+    for (int64_t i = 0; i < count; ++i) {
+        factories.push_back(std::make_unique<SyntheticFactory>(static_cast<uint64_t>(i)));
+    }
+    return factories;
+}
+
+} // namespace
+
+// Registers and unregisters range(0) synthetic types. range(1) = 0 registers them one by one,
+// 1 with a single register_types() call.
+static void BM_StartupRegisterTypes(benchmark::State& state)
+{
+    ensureRegistered();
+    auto factories = make_synthetic_factories(state.range(0));
+    std::vector<const IObjectFactory*> list;
+    for (auto& f : factories) {
+        list.push_back(f.get());
+    }
+    auto& types = instance().type_registry();
+    for (auto _ : state) {
+        if (state.range(1)) {
+            types.register_types({list.data(), list.size()});
+        } else {
+            for (auto* f : list) {
+                types.register_type(*f);
+            }
+        }
+        state.PauseTiming();
+        for (auto* f : list) {
+            types.unregister_type(*f);
+        }
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StartupRegisterTypes)
+    ->ArgsProduct({{1000, 10000}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Creates the first instance of each of 1000 freshly registered synthetic types and looks up one
+// of its members, which builds its ObjectStorage.
+static void BM_StartupFirstCreate(benchmark::State& state)
+{
+    ensureRegistered();
+    auto factories = make_synthetic_factories(1000);
+    std::vector<const IObjectFactory*> list;
+    for (auto& f : factories) {
+        list.push_back(f.get());
+    }
+    auto& types = instance().type_registry();
+    std::vector<IObject::Ptr> objects;
+    objects.reserve(list.size());
+    for (auto _ : state) {
+        state.PauseTiming();
+        types.register_types({list.data(), list.size()});
+        state.ResumeTiming();
+        for (auto* f : list) {
+            objects.push_back(instance().create<IObject>(f->get_class_info().uid));
+            benchmark::DoNotOptimize(interface_cast<IMetadata>(objects.back())->get_property("value"));
+        }
+        state.PauseTiming();
+        objects.clear();
+        for (auto* f : list) {
+            types.unregister_type(*f);
+        }
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(list.size()));
+}
+BENCHMARK(BM_StartupFirstCreate)->Unit(benchmark::kMicrosecond);
+
+// Loads the animator plugin from its library (dlopen/LoadLibrary and initialize()) and unloads it
+// again. range(0) = 1 also creates the first animator, the first object of a plugin type. The
+// system loader may keep the library mapped after an unload, in which case later loads mostly cost
+// initialize() and the type registration.
+static void BM_StartupLoadPlugin(benchmark::State& state)
+{
+    ensureRegistered();
+    auto& plugins = instance().plugin_registry();
+    for (auto _ : state) {
+        plugins.load_plugin_from_path(BENCH_ANIMATOR_DLL_PATH);
+        if (state.range(0)) {
+            benchmark::DoNotOptimize(instance().create<IAnimator>(ClassId::Animator));
+        }
+        plugins.unload_plugin(PluginId::AnimatorPlugin);
+    }
+}
+BENCHMARK(BM_StartupLoadPlugin)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
 // ---------------------------------------------------------------------------
 // Property get/set
 // ---------------------------------------------------------------------------
@@ -84,6 +264,84 @@ static void BM_PropertySetValue(benchmark::State& state)
 }
 BENCHMARK(BM_PropertySetValue);
 
+// Deferred writes to range(0) properties, four per property per frame, applied by one update().
+static void BM_PropertySetDeferred(benchmark::State& state)
+{
+    ensureRegistered();
+    std::vector<IObject::Ptr> objs;
+    std::vector<Property<float>> props;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        objs.push_back(instance().create<IObject>(BenchWidget::class_id()));
+        props.push_back(interface_cast<IBenchWidget>(objs.back())->value());
+    }
+    float v = 0.f;
+    for (auto _ : state) {
+        for (int pass = 0; pass < 4; ++pass) {
+            for (auto& prop : props) {
+                prop.set_value(v, Deferred);
+            }
+            v += 1.f;
+        }
+        instance().update();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 4);
+}
+BENCHMARK(BM_PropertySetDeferred)->Arg(1 << 10)->Arg(1 << 14);
+
+// Fills a 100k-element array property one element at a time, with an on_changed subscriber.
+static void BM_ArrayPropertyFillPerElement(benchmark::State& state)
+{
+    ensureRegistered();
+    auto obj = instance().create<IObject>(BenchArrayWidget::class_id());
+    auto samples = interface_cast<IBenchArrayWidget>(obj)->samples();
+    Callback handler([](FnArgs) -> ReturnValue { return ReturnValue::Success; });
+    samples.add_on_changed(handler);
+    for (auto _ : state) {
+        samples.clear();
+        for (int i = 0; i < 100000; ++i) {
+            samples.push_back(static_cast<float>(i));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 100000);
+}
+BENCHMARK(BM_ArrayPropertyFillPerElement)->Unit(benchmark::kMillisecond);
+
+// Fills the same array with one insert_range() and one notification.
+static void BM_ArrayPropertyFillRange(benchmark::State& state)
+{
+    ensureRegistered();
+    auto obj = instance().create<IObject>(BenchArrayWidget::class_id());
+    auto samples = interface_cast<IBenchArrayWidget>(obj)->samples();
+    Callback handler([](FnArgs) -> ReturnValue { return ReturnValue::Success; });
+    samples.add_on_changed(handler);
+    std::vector<float> values(100000);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<float>(i);
+    }
+    for (auto _ : state) {
+        samples.clear();
+        samples.insert_range(0, {values.data(), values.size()});
+    }
+    state.SetItemsProcessed(state.iterations() * 100000);
+}
+BENCHMARK(BM_ArrayPropertyFillRange)->Unit(benchmark::kMillisecond);
+
+// Defers one element write on a 1M-element array and applies it with update().
+static void BM_ArrayPropertyDeferredSetAt(benchmark::State& state)
+{
+    ensureRegistered();
+    auto obj = instance().create<IObject>(BenchArrayWidget::class_id());
+    auto samples = interface_cast<IBenchArrayWidget>(obj)->samples();
+    samples.resize(1000000);
+    float v = 0.f;
+    for (auto _ : state) {
+        samples.set_at(500000, v, Deferred);
+        instance().update();
+        v += 1.f;
+    }
+}
+BENCHMARK(BM_ArrayPropertyDeferredSetAt);
+
 // ---------------------------------------------------------------------------
 // Direct state access
 // ---------------------------------------------------------------------------
@@ -146,6 +404,19 @@ static void BM_FunctionInvokeTypedArgs(benchmark::State& state)
 }
 BENCHMARK(BM_FunctionInvokeTypedArgs);
 
+// Value arguments, each viewed by a stack-resident ext::AnyArg.
+static void BM_FunctionInvokeValueArgs(benchmark::State& state)
+{
+    ensureRegistered();
+    auto obj = instance().create<IObject>(BenchWidget::class_id());
+    auto* iw = interface_cast<IBenchWidget>(obj);
+    auto fn = iw->add();
+    for (auto _ : state) {
+        invoke_function(fn, 10, 3.14f);
+    }
+}
+BENCHMARK(BM_FunctionInvokeValueArgs);
+
 static void BM_FunctionInvokeRaw(benchmark::State& state)
 {
     ensureRegistered();
@@ -158,6 +429,48 @@ static void BM_FunctionInvokeRaw(benchmark::State& state)
 }
 BENCHMARK(BM_FunctionInvokeRaw);
 
+static void BM_FunctionCallTyped(benchmark::State& state)
+{
+    ensureRegistered();
+    auto obj = instance().create<IObject>(BenchWidget::class_id());
+    auto* iw = interface_cast<IBenchWidget>(obj);
+    auto fn = iw->add();
+    for (auto _ : state) {
+        fn.call(10, 3.14f);
+    }
+}
+BENCHMARK(BM_FunctionCallTyped);
+
+// Invokes a function returning a value: a new IAny::Ptr per call vs one reused result.
+static void BM_FunctionInvokeResult(benchmark::State& state)
+{
+    ensureRegistered();
+    auto obj = instance().create<IObject>(BenchWidget::class_id());
+    auto* iw = interface_cast<IBenchWidget>(obj);
+    auto fn = iw->scale();
+    Any<float> arg(1.5f);
+    const IAny* args[] = {arg};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fn.invoke(FnArgs{args, 1}));
+    }
+}
+BENCHMARK(BM_FunctionInvokeResult);
+
+static void BM_FunctionInvokeInto(benchmark::State& state)
+{
+    ensureRegistered();
+    auto obj = instance().create<IObject>(BenchWidget::class_id());
+    auto* iw = interface_cast<IBenchWidget>(obj);
+    auto fn = iw->scale();
+    Any<float> arg(1.5f);
+    const IAny* args[] = {arg};
+    Any<float> result;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fn.invoke_into(FnArgs{args, 1}, *result.get_any_interface()));
+    }
+}
+BENCHMARK(BM_FunctionInvokeInto);
+
 // ---------------------------------------------------------------------------
 // Event dispatch
 // ---------------------------------------------------------------------------
@@ -188,6 +501,141 @@ static void BM_EventDispatchDeferred(benchmark::State& state)
 }
 BENCHMARK(BM_EventDispatchDeferred);
 
+// Fires an event with range(0) deferred handlers and one argument, then runs update().
+// Threads queue 64 deferred calls each per iteration; the queue is drained once at the end.
+static void BM_DeferredQueueThreads(benchmark::State& state)
+{
+    static Callback* fn;
+    if (state.thread_index() == 0) {
+        fn = new Callback([](FnArgs) -> ReturnValue { return ReturnValue::Success; });
+    }
+    Any<int> value(1);
+    const IAny* args[] = {value};
+    for (auto _ : state) {
+        for (int i = 0; i < 64; ++i) {
+            fn->invoke({args, 1}, Deferred);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 64);
+
+    if (state.thread_index() == 0) {
+        instance().update();
+        delete fn;
+    }
+}
+BENCHMARK(BM_DeferredQueueThreads)->ThreadRange(1, 8)->Iterations(2000)->UseRealTime();
+
+static void BM_EventFanOutDeferred(benchmark::State& state)
+{
+    ensureRegistered();
+    auto obj = instance().create<IObject>(BenchWidget::class_id());
+    auto* iw = interface_cast<IBenchWidget>(obj);
+    Event evt = iw->on_changed();
+    std::vector<Callback> handlers;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        handlers.emplace_back([](FnArgs) -> ReturnValue { return ReturnValue::Success; });
+        evt.add_handler(handlers.back(), Deferred);
+    }
+    Any<float> arg(1.f);
+    const IAny* args[] = {arg};
+    for (auto _ : state) {
+        for (int i = 0; i < 16; ++i) {
+            evt.invoke(FnArgs{args, 1}, Immediate);
+        }
+        instance().update();
+    }
+    state.SetItemsProcessed(state.iterations() * 16);
+}
+BENCHMARK(BM_EventFanOutDeferred)->Arg(1)->Arg(4);
+
+class BenchBatchHandler : public ext::EventBatchHandler<BenchBatchHandler>
+{
+public:
+    void handle_batch(array_view<EventBatchEntry> batch) const override
+    {
+        for (auto& entry : batch) {
+            benchmark::DoNotOptimize(entry.args[0]);
+        }
+    }
+};
+
+// Fires 1024 events with one deferred handler each, then runs update().
+// range(0) = 0: a Callback per event, 1: one IEventBatchHandler shared by all events.
+static void BM_EventBatchDeferred(benchmark::State& state)
+{
+    ensureRegistered();
+    constexpr int count = 1024;
+    std::vector<IEvent::Ptr> events;
+    std::vector<Callback> handlers;
+    auto batch = ext::make_object<BenchBatchHandler, IEventBatchHandler>();
+    for (int i = 0; i < count; ++i) {
+        events.push_back(instance().create<IEvent>(ClassId::Event));
+        if (state.range(0)) {
+            events.back()->add_handler(batch, Deferred);
+        } else {
+            handlers.emplace_back([](FnArgs) -> ReturnValue { return ReturnValue::Success; });
+            events.back()->add_handler(handlers.back(), Deferred);
+        }
+    }
+    Any<float> arg(1.f);
+    const IAny* args[] = {arg};
+    for (auto _ : state) {
+        for (auto& event : events) {
+            event->invoke(FnArgs{args, 1});
+        }
+        instance().update();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_EventBatchDeferred)->Arg(0)->Arg(1);
+
+// Fires an event with range(0) handlers. range(1) selects how they are registered:
+// 0 = all Immediate, 1 = all Deferred, 2 = alternating Immediate and Deferred. The deferred
+// handlers run in the update() that follows each invoke.
+static void BM_EventFanOut(benchmark::State& state)
+{
+    ensureRegistered();
+    auto obj = instance().create<IObject>(BenchWidget::class_id());
+    Event evt = interface_cast<IBenchWidget>(obj)->on_changed();
+    const int64_t mode = state.range(1);
+    std::vector<Callback> handlers;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        handlers.emplace_back([](FnArgs) -> ReturnValue { return ReturnValue::Success; });
+        bool deferred = mode == 1 || (mode == 2 && i % 2);
+        evt.add_handler(handlers.back(), deferred ? Deferred : Immediate);
+    }
+    Any<float> arg(1.f);
+    const IAny* args[] = {arg};
+    for (auto _ : state) {
+        evt.invoke(FnArgs{args, 1}, Immediate);
+        if (mode) {
+            instance().update();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EventFanOut)->ArgsProduct({{1, 8, 50, 200}, {0, 1, 2}});
+
+// Adds and removes one handler on an event that already has range(0) handlers. Both scan the
+// handler list and copy it into a new one.
+static void BM_EventHandlerChurn(benchmark::State& state)
+{
+    ensureRegistered();
+    auto obj = instance().create<IObject>(BenchWidget::class_id());
+    Event evt = interface_cast<IBenchWidget>(obj)->on_changed();
+    std::vector<Callback> handlers;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        handlers.emplace_back([](FnArgs) -> ReturnValue { return ReturnValue::Success; });
+        evt.add_handler(handlers.back());
+    }
+    Callback extra([](FnArgs) -> ReturnValue { return ReturnValue::Success; });
+    for (auto _ : state) {
+        evt.add_handler(extra);
+        evt.remove_handler(extra);
+    }
+}
+BENCHMARK(BM_EventHandlerChurn)->Arg(0)->Arg(8)->Arg(50)->Arg(200);
+
 // ---------------------------------------------------------------------------
 // interface_cast
 // ---------------------------------------------------------------------------
@@ -202,6 +650,35 @@ static void BM_InterfaceCast(benchmark::State& state)
 }
 BENCHMARK(BM_InterfaceCast);
 
+template <int N>
+class IBenchCastTag : public Interface<IBenchCastTag<N>>
+{};
+
+template <class Seq>
+class BenchCastObject;
+
+template <int... Ns>
+class BenchCastObject<std::integer_sequence<int, Ns...>>
+    : public ext::ObjectCore<BenchCastObject<std::integer_sequence<int, Ns...>>, IBenchCastTag<Ns>...>
+{};
+
+/** Casts to the last interface and to a missing one of a class implementing N interfaces. */
+template <int N>
+static void BM_InterfaceCastTableSize(benchmark::State& state)
+{
+    auto obj = ext::make_object<BenchCastObject<std::make_integer_sequence<int, N>>>();
+    const IInterface* p = obj.get();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(p->get_interface(IBenchCastTag<N - 1>::UID));
+        benchmark::DoNotOptimize(p->get_interface(IBenchCastTag<N>::UID));
+    }
+}
+BENCHMARK_TEMPLATE(BM_InterfaceCastTableSize, 2);
+BENCHMARK_TEMPLATE(BM_InterfaceCastTableSize, 4);
+BENCHMARK_TEMPLATE(BM_InterfaceCastTableSize, 8);
+BENCHMARK_TEMPLATE(BM_InterfaceCastTableSize, 16);
+BENCHMARK_TEMPLATE(BM_InterfaceCastTableSize, 32);
+
 // ---------------------------------------------------------------------------
 // Metadata lookup
 // ---------------------------------------------------------------------------
@@ -219,6 +696,18 @@ static void BM_MetadataLookupCold(benchmark::State& state)
 }
 BENCHMARK(BM_MetadataLookupCold);
 
+template <class Widget>
+static void BM_ObjectCreateFirstAccess(benchmark::State& state)
+{
+    ensureRegistered();
+    for (auto _ : state) {
+        auto obj = instance().create<IObject>(Widget::class_id());
+        benchmark::DoNotOptimize(interface_cast<IMetadata>(obj)->get_event("on_changed"));
+    }
+}
+BENCHMARK_TEMPLATE(BM_ObjectCreateFirstAccess, BenchWidget);
+BENCHMARK_TEMPLATE(BM_ObjectCreateFirstAccess, ObservedBenchWidget);
+
 static void BM_MetadataLookupCached(benchmark::State& state)
 {
     ensureRegistered();
@@ -231,6 +720,19 @@ static void BM_MetadataLookupCached(benchmark::State& state)
 }
 BENCHMARK(BM_MetadataLookupCached);
 
+static void BM_MetadataLookupById(benchmark::State& state)
+{
+    ensureRegistered();
+    auto obj = instance().create<IObject>(BenchWidget::class_id());
+    auto* meta = interface_cast<IMetadata>(obj);
+    static constexpr MemberId id{"value"};
+    meta->get_member(id, MemberKind::Property); // prime the cache
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(meta->get_member(id, MemberKind::Property));
+    }
+}
+BENCHMARK(BM_MetadataLookupById);
+
 // ---------------------------------------------------------------------------
 // Object creation
 // ---------------------------------------------------------------------------
@@ -246,50 +748,326 @@ static void BM_ObjectCreate(benchmark::State& state)
 }
 BENCHMARK(BM_ObjectCreate);
 
-// ---------------------------------------------------------------------------
-// Control block allocation: pooled vs raw new/delete
-// ---------------------------------------------------------------------------
-
-static void BM_ControlBlockPooled(benchmark::State& state)
+// Replaces the oldest of 1024 live objects with a new one, as a particle system does, with
+// (1) or without (0) VELK_RECYCLE_INSTANCES(). Other allocations happen in between.
+static void BM_ObjectChurn(benchmark::State& state)
 {
+    ensureRegistered();
+    auto uid = state.range(0) ? RecycledBenchWidget::class_id() : BenchWidget::class_id();
+    std::vector<IObject::Ptr> objects(1024);
+    std::vector<std::unique_ptr<char[]>> noise(objects.size());
+    size_t next = 0;
     for (auto _ : state) {
-        auto* b = detail::alloc_control_block();
-        benchmark::DoNotOptimize(b);
-        detail::dealloc_control_block(b);
+        objects[next] = instance().create<IObject>(uid);
+        noise[next] = std::make_unique<char[]>(48);
+        next = (next + 1) % objects.size();
     }
+    benchmark::DoNotOptimize(objects.data());
 }
-BENCHMARK(BM_ControlBlockPooled);
+BENCHMARK(BM_ObjectChurn)->Arg(0)->Arg(1);
 
-static void BM_ControlBlockNewDelete(benchmark::State& state)
+static void BM_ObjectCreateWithHandle(benchmark::State& state)
 {
+    ensureRegistered();
+    auto handle = instance().type_registry().get_factory_handle<BenchWidget>();
     for (auto _ : state) {
-        auto* b = new control_block;
-        b->strong.store(1, std::memory_order_relaxed);
-        benchmark::DoNotOptimize(b);
-        delete b;
+        auto obj = handle.create();
+        benchmark::DoNotOptimize(obj.get());
     }
 }
-BENCHMARK(BM_ControlBlockNewDelete);
-
-// ---------------------------------------------------------------------------
-// Hive vs vector-of-structs comparison
-// ---------------------------------------------------------------------------
+BENCHMARK(BM_ObjectCreateWithHandle);
 
-class PlainData
+// Creates and releases 64 objects: one by one through a handle (0) or as one batch (1).
+static void BM_ObjectCreateBatch(benchmark::State& state)
 {
-public:
-    PlainData() : f0(0.f), f1(1.f), f2(2.f), f3(3.f), f4(4.f), i0(0), i1(1), i2(2), i3(3), i4(4) {}
-
-    float f0, f1, f2, f3, f4;
-    int i0, i1, i2, i3, i4;
-};
+    ensureRegistered();
+    auto handle = instance().type_registry().get_factory_handle<BenchWidget>();
+    IObject::Ptr objects[64];
+    for (auto _ : state) {
+        if (state.range(0)) {
+            handle.create_n(objects, 64);
+        } else {
+            for (auto& obj : objects) {
+                obj = handle.create();
+            }
+        }
+        benchmark::DoNotOptimize(objects[63].get());
+        for (auto& obj : objects) {
+            obj = nullptr;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(BM_ObjectCreateBatch)->Arg(0)->Arg(1);
 
-class HeapBase
+// Visits 200k objects created interleaved with other allocations (0) or as one batch (1).
+static void BM_ObjectVisitMany(benchmark::State& state)
 {
-public:
-    virtual ~HeapBase() = default;
-    virtual float sum_fields() const = 0;
-};
+    ensureRegistered();
+    auto handle = instance().type_registry().get_factory_handle<BenchWidget>();
+    std::vector<IObject::Ptr> objects(200'000);
+    std::vector<std::unique_ptr<char[]>> noise(objects.size());
+    if (state.range(0)) {
+        handle.create_n(objects.data(), objects.size());
+    }
+    for (size_t i = 0; i < objects.size(); ++i) {
+        if (!state.range(0)) {
+            objects[i] = handle.create();
+        }
+        noise[i] = std::make_unique<char[]>(48);
+    }
+    for (auto _ : state) {
+        for (auto& obj : objects) {
+            benchmark::DoNotOptimize(interface_cast<IBenchWidget>(obj));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * objects.size());
+}
+BENCHMARK(BM_ObjectVisitMany)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Copies and releases a shared_ptr to an object. range(0) = 1 creates it with ThreadConfined.
+static void BM_ObjectPtrCopy(benchmark::State& state)
+{
+    ensureRegistered();
+    auto flags = state.range(0) ? ObjectFlags::ThreadConfined : ObjectFlags::None;
+    auto obj = instance().create<IObject>(BenchWidget::class_id(), flags);
+    for (auto _ : state) {
+        IObject::Ptr copy = obj;
+        benchmark::DoNotOptimize(copy);
+    }
+}
+BENCHMARK(BM_ObjectPtrCopy)->Arg(0)->Arg(1);
+
+// Reads 1024 objects through weak references, locking (0) or peeking in a ReclaimScope (1).
+static void BM_WeakRead(benchmark::State& state)
+{
+    ensureRegistered();
+    std::vector<IObject::Ptr> objects;
+    std::vector<IObject::WeakPtr> weak;
+    for (int i = 0; i < 1024; ++i) {
+        objects.push_back(instance().create<IObject>(BenchWidget::class_id()));
+        weak.push_back(objects.back());
+    }
+    for (auto _ : state) {
+        if (state.range(0)) {
+            ReclaimScope scope;
+            for (auto& w : weak) {
+                benchmark::DoNotOptimize(w.peek(scope));
+            }
+        } else {
+            for (auto& w : weak) {
+                benchmark::DoNotOptimize(w.lock());
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * weak.size());
+}
+BENCHMARK(BM_WeakRead)->Arg(0)->Arg(1);
+
+static void BM_MembersOnFirstAccess(benchmark::State& state)
+{
+    ensureRegistered();
+    auto uid = BenchWidget::class_id();
+    for (auto _ : state) {
+        auto obj = instance().create<IObject>(uid);
+        auto* meta = interface_cast<IMetadata>(obj);
+        for (auto& m : meta->get_static_metadata()) {
+            benchmark::DoNotOptimize(meta->get_member(MemberId(m.name), m.kind));
+        }
+    }
+}
+BENCHMARK(BM_MembersOnFirstAccess);
+
+static void BM_MembersMaterializeAll(benchmark::State& state)
+{
+    ensureRegistered();
+    auto uid = BenchWidget::class_id();
+    for (auto _ : state) {
+        auto obj = instance().create<IObject>(uid);
+        benchmark::DoNotOptimize(interface_cast<IMetadata>(obj)->materialize_all());
+    }
+}
+BENCHMARK(BM_MembersMaterializeAll);
+
+static void BM_MemberReadManyObjects(benchmark::State& state)
+{
+    ensureRegistered();
+    static constexpr MemberId id{"value"};
+    std::vector<IObject::Ptr> objects(200'000);
+    for (auto& obj : objects) {
+        obj = instance().create<IObject>(BenchWidget::class_id());
+        auto* meta = interface_cast<IMetadata>(obj);
+        for (auto& m : meta->get_static_metadata()) {
+            meta->get_member(MemberId(m.name), m.kind);
+        }
+    }
+    for (auto _ : state) {
+        float sum = 0.f;
+        for (auto& obj : objects) {
+            auto* meta = interface_cast<IMetadata>(obj);
+            auto property = interface_pointer_cast<IProperty>(meta->get_member(id, MemberKind::Property));
+            float value;
+            property->get_value()->get_data(&value, sizeof(value), type_uid<float>());
+            sum += value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * objects.size());
+}
+BENCHMARK(BM_MemberReadManyObjects)->Unit(benchmark::kMillisecond);
+
+static void BM_AnyClone(benchmark::State& state)
+{
+    ext::AnyValue<float> value;
+    value.set_value(1.f);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(value.clone());
+    }
+}
+BENCHMARK(BM_AnyClone);
+
+static void BM_AnyCloneMany(benchmark::State& state)
+{
+    // Keeps the clones alive, so every clone takes a new slot.
+    ext::AnyValue<float> value;
+    std::vector<IAny::Ptr> clones(10'000);
+    for (auto _ : state) {
+        for (auto& c : clones) {
+            c = value.clone();
+        }
+        clones.assign(clones.size(), {});
+    }
+    state.SetItemsProcessed(state.iterations() * clones.size());
+}
+BENCHMARK(BM_AnyCloneMany);
+
+static void BM_AnyReadMany(benchmark::State& state)
+{
+    // Reads 200k float anys created interleaved with other allocations, as a property
+    // system creates them over time. Arg 1 takes them from the object pool.
+    uint32_t flags = state.range(0) ? ObjectFlags::Pooled : ObjectFlags::None;
+    std::vector<IAny::Ptr> anys(200'000);
+    std::vector<std::unique_ptr<char[]>> noise(anys.size());
+    for (size_t i = 0; i < anys.size(); ++i) {
+        anys[i] = interface_pointer_cast<IAny>(instance().create(type_uid<float>(), flags));
+        noise[i] = std::make_unique<char[]>(48);
+    }
+    for (auto _ : state) {
+        float sum = 0.f;
+        for (auto& any : anys) {
+            float value;
+            any->get_data(&value, sizeof(value), type_uid<float>());
+            sum += value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * anys.size());
+}
+BENCHMARK(BM_AnyReadMany)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+static void BM_AnyCopyFrom(benchmark::State& state)
+{
+    // Through IAny pointers, as property storage and deferred writes use them.
+    float field = 0.f;
+    ext::AnyRef<float> ref(&field);
+    IAny::Ptr a = Any<float>(1.f).clone();
+    IAny::Ptr b = Any<float>(2.f).clone();
+    IAny* dst = &ref;
+    benchmark::DoNotOptimize(dst);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dst->copy_from(*a));
+        benchmark::DoNotOptimize(dst->copy_from(*b));
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_AnyCopyFrom);
+
+// ---------------------------------------------------------------------------
+// Control block allocation: pooled vs raw new/delete
+// ---------------------------------------------------------------------------
+
+static void BM_ControlBlockPooled(benchmark::State& state)
+{
+    for (auto _ : state) {
+        auto* b = detail::alloc_control_block();
+        benchmark::DoNotOptimize(b);
+        detail::dealloc_control_block(b);
+    }
+}
+BENCHMARK(BM_ControlBlockPooled);
+
+static void BM_ControlBlockNewDelete(benchmark::State& state)
+{
+    for (auto _ : state) {
+        auto* b = new control_block;
+        b->strong.store(1, std::memory_order_relaxed);
+        benchmark::DoNotOptimize(b);
+        delete b;
+    }
+}
+BENCHMARK(BM_ControlBlockNewDelete);
+
+// Blocks allocated here and released on another thread, as in a producer/consumer pipeline.
+// Only the allocations are timed.
+static void BM_ControlBlockCrossThread(benchmark::State& state)
+{
+    std::vector<control_block*> blocks(1024);
+    for (auto _ : state) {
+        for (auto& b : blocks) {
+            b = detail::alloc_control_block();
+        }
+        state.PauseTiming();
+        std::thread([&] {
+            for (auto* b : blocks) {
+                detail::dealloc_control_block(b);
+            }
+        }).join();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * blocks.size());
+}
+BENCHMARK(BM_ControlBlockCrossThread);
+
+// Bursts of 16384 blocks, with fixed (0) or adaptive (1) pool capacity.
+static void BM_ControlBlockBurst(benchmark::State& state)
+{
+    auto saved = instance().get_block_pool_config();
+    BlockPoolConfig config;
+    config.maxCapacity = state.range(0) ? 16384 : 0;
+    instance().set_block_pool_config(config);
+    std::vector<control_block*> blocks(16384);
+    for (auto _ : state) {
+        for (auto& b : blocks) {
+            b = detail::alloc_control_block();
+        }
+        for (auto* b : blocks) {
+            detail::dealloc_control_block(b);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * blocks.size());
+    instance().set_block_pool_config(saved);
+}
+BENCHMARK(BM_ControlBlockBurst)->Arg(0)->Arg(1);
+
+// ---------------------------------------------------------------------------
+// Hive vs vector-of-structs comparison
+// ---------------------------------------------------------------------------
+
+class PlainData
+{
+public:
+    PlainData() : f0(0.f), f1(1.f), f2(2.f), f3(3.f), f4(4.f), i0(0), i1(1), i2(2), i3(3), i4(4) {}
+
+    float f0, f1, f2, f3, f4;
+    int i0, i1, i2, i3, i4;
+};
+
+class HeapBase
+{
+public:
+    virtual ~HeapBase() = default;
+    virtual float sum_fields() const = 0;
+};
 
 class HeapObject : public HeapBase
 {
@@ -442,6 +1220,58 @@ static void BM_CreateHive(benchmark::State& state)
 }
 BENCHMARK(BM_CreateHive);
 
+static void BM_CreateHiveBatch(benchmark::State& state)
+{
+    ensureRegistered();
+    ensureHiveRegistered();
+    auto registry = instance().create<IHiveStore>(ClassId::HiveStore);
+    auto hive = registry->get_hive<HiveData>();
+
+    std::vector<IObject::Ptr> teardown_refs(kHiveCount);
+    for (auto _ : state) {
+        hive->add_n(kHiveCount, teardown_refs.data());
+        benchmark::DoNotOptimize(teardown_refs.data());
+        // Teardown
+        state.PauseTiming();
+        for (auto& r : teardown_refs) {
+            hive->remove(*r);
+            r.reset();
+        }
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_CreateHiveBatch);
+
+// Destroys a hive holding 64K objects, a third of them zombies.
+static void BM_DestroyHive(benchmark::State& state)
+{
+    ensureRegistered();
+    ensureHiveRegistered();
+    constexpr size_t count = 64 * 1024;
+    std::vector<IObject::Ptr> zombies;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto registry = instance().create<IHiveStore>(ClassId::HiveStore);
+        auto hive = registry->get_hive<HiveData>();
+        std::vector<IObject::Ptr> objs(count);
+        hive->add_n(count, objs.data());
+        for (size_t i = 0; i < count; i += 3) {
+            hive->remove(*objs[i]);
+            zombies.push_back(std::move(objs[i]));
+        }
+        objs.clear();
+        state.ResumeTiming();
+
+        hive.reset();
+        registry.reset();
+
+        state.PauseTiming();
+        zombies.clear();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_DestroyHive);
+
 // --- Iteration speed: read all 10 fields, accumulate ---
 
 static void BM_IteratePlainVector(benchmark::State& state)
@@ -582,6 +1412,45 @@ static void BM_IterateHiveState(benchmark::State& state)
 }
 BENCHMARK(BM_IterateHiveState);
 
+static void BM_IterateHiveStateColumn(benchmark::State& state)
+{
+    ensureRegistered();
+    ensureHiveRegistered();
+    auto registry = instance().create<IHiveStore>(ClassId::HiveStore);
+    auto hive = registry->get_hive<HiveData>();
+    ObjectHive(hive).add_state_column<IHiveData>();
+
+    std::vector<IObject::Ptr> refs;
+    refs.reserve(kHiveCount);
+    for (size_t i = 0; i < kHiveCount; ++i) {
+        auto obj = hive->add();
+        auto* ps = interface_cast<IPropertyState>(obj);
+        auto* s = ps->get_property_state<IHiveData>();
+        s->f0 = static_cast<float>(i);
+        s->i0 = static_cast<int>(i);
+        refs.push_back(std::move(obj));
+    }
+
+    for (auto _ : state) {
+        float sum = 0.f;
+        ObjectHive(hive).for_each_column<IHiveData>(
+            [&](IHiveData::State* states, const uint64_t* active_bits, size_t count) {
+                for (size_t i = 0; i < count; ++i) {
+                    if (active_bits[i / 64] & (uint64_t(1) << (i % 64))) {
+                        auto& s = states[i];
+                        sum += s.f0 + s.f1 + s.f2 + s.f3 + s.f4;
+                        sum += static_cast<float>(s.i0 + s.i1 + s.i2 + s.i3 + s.i4);
+                    }
+                }
+                return true;
+            });
+        benchmark::DoNotOptimize(sum);
+    }
+
+    refs.clear();
+}
+BENCHMARK(BM_IterateHiveStateColumn);
+
 // --- Iteration speed: write all 10 fields ---
 
 static void BM_IterateWritePlainVector(benchmark::State& state)
@@ -924,6 +1793,72 @@ static void BM_ChurnHive(benchmark::State& state)
 }
 BENCHMARK(BM_ChurnHive);
 
+// Remove-heavy churn on a hive of range(0) objects spread over 64-slot pages, so that
+// every remove() has to resolve the owning page among thousands.
+static void BM_ChurnLargeHive(benchmark::State& state)
+{
+    ensureRegistered();
+    ensureHiveRegistered();
+    auto registry = instance().create<IHiveStore>(ClassId::HiveStore);
+    auto hive = registry->get_hive<HiveData>();
+    HivePageCapacity capacity;
+    capacity.page_3 = 64;
+    capacity.page_n = 64;
+    hive->set_page_capacity(capacity);
+
+    auto count = static_cast<size_t>(state.range(0));
+    std::vector<IObject::Ptr> refs;
+    refs.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        refs.push_back(hive->add());
+    }
+
+    for (auto _ : state) {
+        // Remove every 4th element, then refill the freed slots.
+        for (size_t i = 0; i < count; i += 4) {
+            hive->remove(*refs[i]);
+            refs[i].reset();
+        }
+        for (size_t i = 0; i < count; i += 4) {
+            refs[i] = hive->add();
+        }
+        benchmark::DoNotOptimize(hive.get());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count / 4));
+
+    hive->clear();
+}
+BENCHMARK(BM_ChurnLargeHive)->Arg(1 << 14)->Arg(1 << 17);
+
+// Concurrent spawn/despawn of 64 objects per thread; range(0) is the hive partition count (1 = regular hive).
+static void BM_SpawnHiveThreads(benchmark::State& state)
+{
+    static IHiveStore::Ptr registry;
+    static IObjectHive::Ptr hive;
+    if (state.thread_index() == 0) {
+        ensureRegistered();
+        ensureHiveRegistered();
+        registry = instance().create<IHiveStore>(ClassId::HiveStore);
+        hive = registry->get_partitioned_hive<HiveData>(static_cast<size_t>(state.range(0)));
+    }
+
+    std::vector<IObject::Ptr> refs(64);
+    for (auto _ : state) {
+        hive->add_n(refs.size(), refs.data());
+        for (auto& r : refs) {
+            hive->remove(*r);
+            r.reset();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(refs.size()));
+
+    if (state.thread_index() == 0) {
+        hive.reset();
+        registry.reset();
+    }
+}
+BENCHMARK(BM_SpawnHiveThreads)->Arg(1)->Arg(8)->ThreadRange(1, 8)->UseRealTime();
+
 // ---------------------------------------------------------------------------
 // RawHive<PlainData> benchmarks
 // ---------------------------------------------------------------------------
@@ -945,6 +1880,22 @@ static void BM_CreateRawHive(benchmark::State& state)
 }
 BENCHMARK(BM_CreateRawHive);
 
+static void BM_CreateRawHiveBatch(benchmark::State& state)
+{
+    ensureRegistered();
+    ensureHiveRegistered();
+    auto registry = instance().create<IHiveStore>(ClassId::HiveStore);
+
+    std::vector<PlainData*> out(kHiveCount);
+    for (auto _ : state) {
+        RawHive<PlainData> hive(
+            registry->get_raw_hive(type_uid<PlainData>(), sizeof(PlainData), alignof(PlainData)));
+        hive.emplace_n(kHiveCount, out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_CreateRawHiveBatch);
+
 static void BM_IterateRawHive(benchmark::State& state)
 {
     ensureRegistered();
@@ -973,7 +1924,7 @@ static void BM_IterateRawHive(benchmark::State& state)
 }
 BENCHMARK(BM_IterateRawHive);
 
-static void BM_IterateWriteRawHive(benchmark::State& state)
+static void BM_IterateRawHiveRuns(benchmark::State& state)
 {
     ensureRegistered();
     ensureHiveRegistered();
@@ -981,21 +1932,140 @@ static void BM_IterateWriteRawHive(benchmark::State& state)
     RawHive<PlainData> hive(
         registry->get_raw_hive(type_uid<PlainData>(), sizeof(PlainData), alignof(PlainData)));
 
-    std::vector<PlainData*> ptrs;
-    ptrs.reserve(kHiveCount);
     for (size_t i = 0; i < kHiveCount; ++i) {
-        ptrs.push_back(hive.emplace());
+        auto* p = hive.emplace();
+        p->f0 = static_cast<float>(i);
+        p->i0 = static_cast<int>(i);
     }
 
-    float counter = 0.f;
     for (auto _ : state) {
-        float v = counter;
-        hive.for_each([&](PlainData& d) {
-            d.f0 = v;
-            d.f1 = v;
-            d.f2 = v;
-            d.f3 = v;
-            d.f4 = v;
+        float sum = 0.f;
+        hive.for_each_run([&](PlainData* d, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                sum += d[i].f0 + d[i].f1 + d[i].f2 + d[i].f3 + d[i].f4;
+                sum += static_cast<float>(d[i].i0 + d[i].i1 + d[i].i2 + d[i].i3 + d[i].i4);
+            }
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_IterateRawHiveRuns);
+
+// Writes a snapshot of a hive with every other element removed and restores it densely.
+static void BM_SnapshotRawHive(benchmark::State& state)
+{
+    ensureRegistered();
+    ensureHiveRegistered();
+    auto registry = instance().create<IHiveStore>(ClassId::HiveStore);
+    RawHive<PlainData> hive(
+        registry->get_raw_hive(type_uid<PlainData>(), sizeof(PlainData), alignof(PlainData)));
+    auto other = instance().create<IHiveStore>(ClassId::HiveStore);
+    RawHive<PlainData> restored(
+        other->get_raw_hive(type_uid<PlainData>(), sizeof(PlainData), alignof(PlainData)));
+
+    std::vector<PlainData*> ptrs(kHiveCount);
+    hive.emplace_n(kHiveCount, ptrs.data());
+    for (size_t i = 0; i < kHiveCount; i += 2) {
+        hive.deallocate(ptrs[i]);
+    }
+    std::vector<uint8_t> data(hive.raw().snapshot(nullptr, 0));
+
+    for (auto _ : state) {
+        hive.raw().snapshot(data.data(), data.size());
+        restored.restore(data.data(), data.size());
+        benchmark::DoNotOptimize(data.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+BENCHMARK(BM_SnapshotRawHive);
+
+// Loads a 1M element snapshot file; range(0) selects restore() from memory (0) or adopt() of a mapping (1).
+static void BM_LoadRawHiveSnapshot(benchmark::State& state)
+{
+    ensureRegistered();
+    ensureHiveRegistered();
+    auto registry = instance().create<IHiveStore>(ClassId::HiveStore);
+    RawHive<PlainData> hive(
+        registry->get_raw_hive(type_uid<PlainData>(), sizeof(PlainData), alignof(PlainData)));
+    constexpr size_t count = size_t(1) << 20;
+    hive.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        hive.emplace()->f0 = static_cast<float>(i);
+    }
+    auto data = hive.snapshot();
+    hive.clear();
+    const char* path = "velk_benchmark.hive";
+    if (std::FILE* file = std::fopen(path, "wb")) {
+        std::fwrite(data.data(), 1, data.size(), file);
+        std::fclose(file);
+    }
+
+    for (auto _ : state) {
+        if (state.range(0)) {
+            auto mapping = instance().create<IHiveSnapshotMapping>(ClassId::HiveSnapshotMapping);
+            mapping->open(path);
+            hive.adopt(mapping);
+        } else {
+            hive.restore(data.data(), data.size());
+        }
+        benchmark::DoNotOptimize(hive.size());
+    }
+    hive.clear();
+    std::remove(path);
+}
+BENCHMARK(BM_LoadRawHiveSnapshot)->Arg(0)->Arg(1);
+
+// Iterates 4M elements; range(0) selects heap pages (0) or VirtualMemoryPageSource pages (1).
+static void BM_IterateLargeRawHive(benchmark::State& state)
+{
+    ensureRegistered();
+    ensureHiveRegistered();
+    auto registry = instance().create<IHiveStore>(ClassId::HiveStore);
+    if (state.range(0)) {
+        registry->set_default_page_source(
+            instance().create<IHivePageSource>(ClassId::VirtualMemoryPageSource));
+    }
+    RawHive<PlainData> hive(
+        registry->get_raw_hive(type_uid<PlainData>(), sizeof(PlainData), alignof(PlainData)));
+
+    constexpr size_t count = size_t(4) << 20;
+    hive.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto* p = hive.emplace();
+        p->f0 = static_cast<float>(i);
+    }
+
+    for (auto _ : state) {
+        float sum = 0.f;
+        hive.for_each([&](PlainData& d) { sum += d.f0 + d.f4; });
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_IterateLargeRawHive)->Arg(0)->Arg(1);
+
+static void BM_IterateWriteRawHive(benchmark::State& state)
+{
+    ensureRegistered();
+    ensureHiveRegistered();
+    auto registry = instance().create<IHiveStore>(ClassId::HiveStore);
+    RawHive<PlainData> hive(
+        registry->get_raw_hive(type_uid<PlainData>(), sizeof(PlainData), alignof(PlainData)));
+
+    std::vector<PlainData*> ptrs;
+    ptrs.reserve(kHiveCount);
+    for (size_t i = 0; i < kHiveCount; ++i) {
+        ptrs.push_back(hive.emplace());
+    }
+
+    float counter = 0.f;
+    for (auto _ : state) {
+        float v = counter;
+        hive.for_each([&](PlainData& d) {
+            d.f0 = v;
+            d.f1 = v;
+            d.f2 = v;
+            d.f3 = v;
+            d.f4 = v;
             int iv = static_cast<int>(v);
             d.i0 = iv;
             d.i1 = iv;
@@ -1010,6 +2080,45 @@ static void BM_IterateWriteRawHive(benchmark::State& state)
 }
 BENCHMARK(BM_IterateWriteRawHive);
 
+// Each thread increments its own element. Unpadded, the elements share a cache line which
+// bounces between the cores; Arg(64) pads every slot to a line of its own.
+static void BM_FalseSharingRawHive(benchmark::State& state)
+{
+    struct Counter
+    {
+        uint64_t value;
+    };
+    static IHiveStore::Ptr registry;
+    static std::unique_ptr<RawHive<Counter>> hive;
+    static std::vector<Counter*> counters;
+    if (state.thread_index() == 0) {
+        ensureRegistered();
+        ensureHiveRegistered();
+        registry = instance().create<IHiveStore>(ClassId::HiveStore);
+        hive = std::make_unique<RawHive<Counter>>(*registry);
+        hive->set_slot_alignment(static_cast<size_t>(state.range(0)));
+        counters.clear();
+        for (int i = 0; i < state.threads(); ++i) {
+            counters.push_back(hive->emplace());
+        }
+    }
+
+    for (auto _ : state) {
+        Counter* counter = counters[static_cast<size_t>(state.thread_index())];
+        for (int i = 0; i < 1000; ++i) {
+            benchmark::DoNotOptimize(++counter->value);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 1000);
+
+    if (state.thread_index() == 0) {
+        counters.clear();
+        hive.reset();
+        registry.reset();
+    }
+}
+BENCHMARK(BM_FalseSharingRawHive)->Arg(0)->Arg(HIVE_CACHE_LINE_SIZE)->Threads(4)->UseRealTime();
+
 static void BM_ChurnRawHive(benchmark::State& state)
 {
     ensureRegistered();
@@ -1045,9 +2154,9 @@ BENCHMARK(BM_ChurnRawHive);
 // Hierarchy benchmarks
 // ===========================================================================
 
-static Hierarchy build_tree(size_t count)
+static Hierarchy build_tree(size_t count, Uid classId = ClassId::Hierarchy)
 {
-    auto h = create_hierarchy();
+    auto h = create_hierarchy(classId);
     if (count == 0) {
         return h;
     }
@@ -1085,6 +2194,118 @@ static void BM_HierarchyBuildTree(benchmark::State& state)
 }
 BENCHMARK(BM_HierarchyBuildTree)->Range(64, 1024);
 
+static Uid hierarchy_impl(int64_t flat)
+{
+    return flat ? ClassId::FlatHierarchy : ClassId::Hierarchy;
+}
+
+// Builds and destroys a 4096-node tree of existing objects.
+// range(0) = 0: ClassId::Hierarchy, 1: ClassId::FlatHierarchy.
+static void BM_HierarchyBuildTreeImpl(benchmark::State& state)
+{
+    ensureRegistered();
+    std::vector<IObject::Ptr> nodes(4096);
+    for (auto& node : nodes) {
+        node = instance().create<IObject>(BenchWidget::class_id());
+    }
+    for (auto _ : state) {
+        auto h = create_hierarchy(hierarchy_impl(state.range(0)));
+        h.set_root(nodes[0]);
+        for (size_t i = 1; i < nodes.size(); ++i) {
+            h.add(nodes[(i - 1) / 2], nodes[i]);
+        }
+        benchmark::DoNotOptimize(h.size());
+    }
+}
+BENCHMARK(BM_HierarchyBuildTreeImpl)->Arg(0)->Arg(1);
+
+// Builds the same 4096-node tree with one add_subtree() call.
+// range(0) = 0: ClassId::Hierarchy, 1: ClassId::FlatHierarchy.
+static void BM_HierarchyAddSubtree(benchmark::State& state)
+{
+    ensureRegistered();
+    std::vector<IObject::Ptr> nodes(4096);
+    for (auto& node : nodes) {
+        node = instance().create<IObject>(BenchWidget::class_id());
+    }
+    std::vector<uint32_t> parents(nodes.size() - 1);
+    parents[0] = IHierarchy::OUTER_PARENT;
+    parents[1] = IHierarchy::OUTER_PARENT;
+    for (size_t i = 2; i < parents.size(); ++i) {
+        parents[i] = static_cast<uint32_t>(i / 2 - 1);
+    }
+    for (auto _ : state) {
+        auto h = create_hierarchy(hierarchy_impl(state.range(0)));
+        h.set_root(nodes[0]);
+        h.add_subtree(nodes[0], {nodes.data() + 1, parents.size()}, {parents.data(), parents.size()});
+        benchmark::DoNotOptimize(h.size());
+    }
+}
+BENCHMARK(BM_HierarchyAddSubtree)->Arg(0)->Arg(1);
+
+static void propagate_f1(const IHierarchy& h, const IObject::Ptr& obj, float parent)
+{
+    auto* data = interface_cast<IHiveData>(obj);
+    float world = parent * data->f0().get_value();
+    data->f1().set_value(world);
+    for (auto& child : h.children_of(obj)) {
+        propagate_f1(h, child, world);
+    }
+}
+
+// Recomputes f1 = parent's f1 * f0 below a changed object of a 4095-node tree.
+// range(0) = 0: root changed, inherited property; 1: leaf changed, inherited property;
+//            2: root changed, recursive children_of() walk.
+static void BM_HierarchyInheritedUpdate(benchmark::State& state)
+{
+    ensureHiveRegistered();
+    auto h = create_hierarchy();
+    std::vector<IObject::Ptr> nodes(4095);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i] = instance().create<IObject>(HiveData::class_id());
+        interface_cast<IHiveData>(nodes[i])->f0().set_value(1.f);
+        if (i == 0) {
+            h.set_root(nodes[0]);
+        } else {
+            h.add(nodes[(i - 1) / 2], nodes[i]);
+        }
+    }
+    auto mode = state.range(0);
+    if (mode != 2) {
+        h.add_inherited("f0", "f1", [](float parent, float local) { return parent * local; });
+    }
+    auto* changed = interface_cast<IHiveData>(mode == 1 ? nodes.back() : nodes[0]);
+    auto* ih = interface_cast<IHierarchy>(h.get());
+    float value = 1.f;
+    for (auto _ : state) {
+        value = value == 1.f ? 0.5f : 1.f;
+        changed->f0().set_value(value);
+        if (mode == 2) {
+            propagate_f1(*ih, nodes[0], 1.f);
+        }
+        instance().update();
+    }
+}
+BENCHMARK(BM_HierarchyInheritedUpdate)->Arg(0)->Arg(1)->Arg(2);
+
+// Visits every node of a 65536-node tree with traverse().
+// range(0) = 0: ClassId::Hierarchy, 1: ClassId::FlatHierarchy. range(1) = TraversalOrder.
+static void BM_HierarchyTraverse(benchmark::State& state)
+{
+    ensureRegistered();
+    auto h = build_tree(65536, hierarchy_impl(state.range(0)));
+    auto root = h.root().object();
+    auto order = static_cast<TraversalOrder>(state.range(1));
+    size_t depth = 0;
+    for (auto _ : state) {
+        depth = 0;
+        h.traverse<IObject>(root, order, [&](IObject&, size_t d) { depth += d; });
+        benchmark::DoNotOptimize(depth);
+    }
+    state.SetItemsProcessed(state.iterations() * 65536);
+}
+BENCHMARK(BM_HierarchyTraverse)->Args({0, 0})->Args({0, 1})->Args({1, 0})->Args({1, 1});
+
 static void BM_HierarchyParentOf(benchmark::State& state)
 {
     ensureRegistered();
@@ -1103,6 +2324,63 @@ static void BM_HierarchyParentOf(benchmark::State& state)
 }
 BENCHMARK(BM_HierarchyParentOf);
 
+// Looks up the parents of 1024 nodes of a 65536-node tree.
+// range(0) = 0: IHierarchy::parent_of(), 1: IHierarchySnapshot::parent_of(). range(1) = 0: Hierarchy,
+// 1: FlatHierarchy.
+static void BM_HierarchySnapshotParentOf(benchmark::State& state)
+{
+    ensureRegistered();
+    auto h = build_tree(65536, hierarchy_impl(state.range(1)));
+    std::vector<IObject::Ptr> objects;
+    h.traverse<IObject>(h.root().object(), TraversalOrder::PreOrder, [&](IObject& obj, size_t) {
+        if (objects.size() < 1024) {
+            objects.push_back(obj.get_self());
+        }
+    });
+    h.commit_snapshot();
+    auto snap = h.snapshot();
+    for (auto _ : state) {
+        if (state.range(0)) {
+            for (auto& object : objects) {
+                benchmark::DoNotOptimize(snap->parent_of(object).get());
+            }
+        } else {
+            for (auto& object : objects) {
+                benchmark::DoNotOptimize(h.parent_of(object));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * objects.size());
+}
+BENCHMARK(BM_HierarchySnapshotParentOf)->Args({0, 0})->Args({1, 0})->Args({0, 1})->Args({1, 1});
+
+// Publishes a snapshot of a 65536-node tree.
+// range(0) = 0: after adding or removing a leaf, 1: the first commit, which builds it all.
+// range(1) = 0: Hierarchy, 1: FlatHierarchy.
+static void BM_HierarchySnapshotCommit(benchmark::State& state)
+{
+    ensureRegistered();
+    auto h = build_tree(65536, hierarchy_impl(state.range(1)));
+    auto root = h.root().object();
+    IObject::Ptr leaf;
+    h.commit_snapshot();
+    for (auto _ : state) {
+        if (state.range(0)) {
+            state.PauseTiming();
+            h = build_tree(65536, hierarchy_impl(state.range(1)));
+            state.ResumeTiming();
+        } else if (leaf) {
+            h.remove(leaf);
+            leaf = {};
+        } else {
+            leaf = instance().create<IObject>(BenchWidget::class_id());
+            h.add(root, leaf);
+        }
+        benchmark::DoNotOptimize(h.commit_snapshot());
+    }
+}
+BENCHMARK(BM_HierarchySnapshotCommit)->Args({0, 0})->Args({1, 0})->Args({0, 1})->Args({1, 1});
+
 static void BM_HierarchyChildrenOf(benchmark::State& state)
 {
     ensureRegistered();
@@ -1120,6 +2398,82 @@ static void BM_HierarchyChildrenOf(benchmark::State& state)
 }
 BENCHMARK(BM_HierarchyChildrenOf);
 
+// Reads the children of a root with 10000 children.
+// range(0) = 0: children_of(), 1: view_children(). range(1) = 0: Hierarchy, 1: FlatHierarchy.
+static void BM_HierarchyWideChildren(benchmark::State& state)
+{
+    ensureRegistered();
+    auto h = create_hierarchy(hierarchy_impl(state.range(1)));
+    auto root = instance().create<IObject>(BenchWidget::class_id());
+    h.set_root(root);
+    for (size_t i = 0; i < 10000; ++i) {
+        h.add(root, instance().create<IObject>(BenchWidget::class_id()));
+    }
+    auto ih = h.get_hierarchy_interface();
+    size_t count = 0;
+    for (auto _ : state) {
+        count = 0;
+        if (state.range(0)) {
+            for (auto& child : ih->view_children(root)) {
+                count += child.get() != nullptr;
+            }
+        } else {
+            for (auto& child : ih->children_of(root)) {
+                count += child.get() != nullptr;
+            }
+        }
+        benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK(BM_HierarchyWideChildren)->Args({0, 0})->Args({1, 0})->Args({0, 1})->Args({1, 1});
+
+// Node::get_children() of a root with 8 children.
+// range(0) = 0: heap vectors, 1: the frame arena, reset every iteration as update() would.
+static void BM_NodeGetChildren(benchmark::State& state)
+{
+    ensureRegistered();
+    auto h = create_hierarchy();
+    auto root = instance().create<IObject>(BenchWidget::class_id());
+    h.set_root(root);
+    for (size_t i = 0; i < 8; ++i) {
+        h.add(root, instance().create<IObject>(BenchWidget::class_id()));
+    }
+    auto node = h.root();
+    auto* arena = frame_arena();
+    for (auto _ : state) {
+        if (state.range(0)) {
+            arena->reset();
+            benchmark::DoNotOptimize(node.get_children(arena));
+        } else {
+            benchmark::DoNotOptimize(node.get_children());
+        }
+    }
+}
+BENCHMARK(BM_NodeGetChildren)->Arg(0)->Arg(1);
+
+// Fills a temporary vector with 32 ints. range(0) = 0: vector, 1: arena_vector on the frame arena.
+static void BM_TemporaryVector(benchmark::State& state)
+{
+    auto* arena = frame_arena();
+    for (auto _ : state) {
+        if (state.range(0)) {
+            arena->reset();
+            arena_vector<int> v(arena);
+            for (int i = 0; i < 32; ++i) {
+                v.push_back(i);
+            }
+            benchmark::DoNotOptimize(v.data());
+        } else {
+            vector<int> v;
+            for (int i = 0; i < 32; ++i) {
+                v.push_back(i);
+            }
+            benchmark::DoNotOptimize(v.data());
+        }
+    }
+}
+BENCHMARK(BM_TemporaryVector)->Arg(0)->Arg(1);
+
 static void BM_HierarchyContains(benchmark::State& state)
 {
     ensureRegistered();
@@ -1212,3 +2566,828 @@ static void BM_HierarchyAddWithHandler(benchmark::State& state)
     }
 }
 BENCHMARK(BM_HierarchyAddWithHandler);
+
+// Adds and removes 256 leaves with one on_changed handler subscribed.
+// range(0) = 0: an event per mutation, 1: in one batch, delivered as one event.
+static void BM_HierarchyBatchedChanges(benchmark::State& state)
+{
+    ensureRegistered();
+    auto h = build_tree(64);
+    auto root_obj = h.root().object();
+    auto* ih = interface_cast<IHierarchy>(h.get());
+    Event evt = ih->on_changed();
+    evt.add_handler([](FnArgs) -> ReturnValue { return ReturnValue::Success; }, Immediate);
+    std::vector<IObject::Ptr> leaves;
+    for (size_t i = 0; i < 256; ++i) {
+        leaves.push_back(instance().create<IObject>(BenchWidget::class_id()));
+    }
+    for (auto _ : state) {
+        if (state.range(0)) {
+            ih->begin_batch();
+        }
+        for (auto& leaf : leaves) {
+            h.add(root_obj, leaf);
+        }
+        for (auto& leaf : leaves) {
+            h.remove(leaf);
+        }
+        if (state.range(0)) {
+            ih->end_batch();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * leaves.size() * 2);
+}
+BENCHMARK(BM_HierarchyBatchedChanges)->Arg(0)->Arg(1);
+
+// --- Large trees ---
+
+// Nodes and add_subtree() parents of a tree of range(0) nodes in which node i is a child of
+// node (i - 1) / fanout, i.e. a complete tree of the given fan-out in breadth-first order.
+struct LargeTree
+{
+    std::vector<IObject::Ptr> nodes;
+    std::vector<uint32_t> parents; ///< add_subtree() parents of nodes[1..], added under nodes[0].
+
+    LargeTree(size_t count, size_t fanout) : nodes(count), parents(count - 1)
+    {
+        for (auto& node : nodes) {
+            node = instance().create<IObject>(BenchWidget::class_id());
+        }
+        for (size_t i = 1; i < count; ++i) {
+            size_t parent = (i - 1) / fanout;
+            parents[i - 1] = parent ? static_cast<uint32_t>(parent - 1) : IHierarchy::OUTER_PARENT;
+        }
+    }
+
+    Hierarchy build(Uid classId) const
+    {
+        auto h = create_hierarchy(classId);
+        h.set_root(nodes[0]);
+        h.add_subtree(nodes[0], {nodes.data() + 1, parents.size()}, {parents.data(), parents.size()});
+        return h;
+    }
+};
+
+// The descendants of an object and their add_subtree() parents, captured in pre-order so that
+// the subtree can be added back after it was removed.
+struct CapturedSubtree
+{
+    std::vector<IObject::Ptr> objects;
+    std::vector<uint32_t> parents;
+
+    CapturedSubtree(const IHierarchy& h, const IObject::Ptr& top)
+    {
+        // Index in objects of the last object visited at each depth below top.
+        struct Ctx
+        {
+            CapturedSubtree* self;
+            std::vector<uint32_t> lastAtDepth;
+            size_t topDepth;
+        } ctx{this, {}, SIZE_MAX};
+        h.traverse(top, TraversalOrder::PreOrder, &ctx,
+                   [](void* c, const IObject::Ptr& obj, size_t depth) -> bool {
+                       auto& ctx = *static_cast<Ctx*>(c);
+                       if (ctx.topDepth == SIZE_MAX) {
+                           ctx.topDepth = depth;
+                       }
+                       size_t d = depth - ctx.topDepth;
+                       auto index = static_cast<uint32_t>(ctx.self->objects.size());
+                       ctx.self->objects.push_back(obj);
+                       ctx.self->parents.push_back(d ? ctx.lastAtDepth[d - 1] : IHierarchy::OUTER_PARENT);
+                       ctx.lastAtDepth.resize(d + 1);
+                       ctx.lastAtDepth[d] = index;
+                       return true;
+                   });
+    }
+};
+
+// Builds a tree of range(0) nodes of fan-out range(1) from existing objects with one
+// add_subtree() call. range(2) = 0: ClassId::Hierarchy, 1: ClassId::FlatHierarchy.
+static void BM_HierarchyLargeBuild(benchmark::State& state)
+{
+    ensureRegistered();
+    LargeTree tree(static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(1)));
+    for (auto _ : state) {
+        auto h = tree.build(hierarchy_impl(state.range(2)));
+        benchmark::DoNotOptimize(h.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HierarchyLargeBuild)
+    ->ArgsProduct({{100000, 1000000}, {2, 16, 1024}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+// Visits every node of the tree of BM_HierarchyLargeBuild with a pre-order traverse().
+// Fan-out 2 gives a deep tree, 1024 a wide and shallow one.
+static void BM_HierarchyLargeTraverse(benchmark::State& state)
+{
+    ensureRegistered();
+    LargeTree tree(static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(1)));
+    auto h = tree.build(hierarchy_impl(state.range(2)));
+    auto root = h.root().object();
+    size_t depth = 0;
+    for (auto _ : state) {
+        depth = 0;
+        h.traverse<IObject>(root, TraversalOrder::PreOrder, [&](IObject&, size_t d) { depth += d; });
+        benchmark::DoNotOptimize(depth);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HierarchyLargeTraverse)
+    ->ArgsProduct({{100000, 1000000}, {2, 16, 1024}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+// Removes the subtree of the first child of the root (about 1 / fan-out of the tree) from a
+// 100k-node tree. Adding it back is not timed.
+static void BM_HierarchyLargeRemoveSubtree(benchmark::State& state)
+{
+    ensureRegistered();
+    LargeTree tree(100000, static_cast<size_t>(state.range(0)));
+    auto h = tree.build(hierarchy_impl(state.range(1)));
+    auto* ih = interface_cast<IHierarchy>(h.get());
+    CapturedSubtree sub(*ih, tree.nodes[1]);
+    for (auto _ : state) {
+        ih->remove(tree.nodes[1]);
+        state.PauseTiming();
+        ih->add_subtree(tree.nodes[0], {sub.objects.data(), sub.objects.size()},
+                        {sub.parents.data(), sub.parents.size()});
+        state.ResumeTiming();
+    }
+    state.counters["subtree_nodes"] = static_cast<double>(sub.objects.size());
+}
+BENCHMARK(BM_HierarchyLargeRemoveSubtree)
+    ->ArgsProduct({{2, 16, 1024}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Moves the subtree of node 63 (2047 nodes) of a 100k-node binary tree back and forth
+// between its parent and the last leaf. The hierarchy has no move operation, so a move is a
+// remove() and an add_subtree().
+static void BM_HierarchyLargeReparent(benchmark::State& state)
+{
+    ensureRegistered();
+    LargeTree tree(100000, 2);
+    auto h = tree.build(hierarchy_impl(state.range(0)));
+    auto* ih = interface_cast<IHierarchy>(h.get());
+    const auto& moved = tree.nodes[63];
+    CapturedSubtree sub(*ih, moved);
+    IObject::Ptr parents[] = {ih->parent_of(moved), tree.nodes[tree.nodes.size() - 1]};
+    size_t target = 1;
+    for (auto _ : state) {
+        ih->remove(moved);
+        ih->add_subtree(parents[target], {sub.objects.data(), sub.objects.size()},
+                        {sub.parents.data(), sub.parents.size()});
+        target ^= 1;
+    }
+    state.counters["subtree_nodes"] = static_cast<double>(sub.objects.size());
+}
+BENCHMARK(BM_HierarchyLargeReparent)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// Reads the children of a root with 100k children, as BM_HierarchyWideChildren does for 10k.
+// range(0) = 0: children_of() copy, 1: view_children(), 2: child_at() per index.
+// range(1) = 0: ClassId::Hierarchy, 1: ClassId::FlatHierarchy.
+static void BM_HierarchyLargeWideChildren(benchmark::State& state)
+{
+    ensureRegistered();
+    constexpr size_t count = 100000;
+    LargeTree tree(count + 1, count);
+    auto h = tree.build(hierarchy_impl(state.range(1)));
+    auto* ih = interface_cast<IHierarchy>(h.get());
+    const auto& root = tree.nodes[0];
+    for (auto _ : state) {
+        switch (state.range(0)) {
+        case 0:
+            benchmark::DoNotOptimize(ih->children_of(root).size());
+            break;
+        case 1:
+            for (auto& child : ih->view_children(root)) {
+                benchmark::DoNotOptimize(child.get());
+            }
+            break;
+        default:
+            for (size_t i = 0; i < count; ++i) {
+                benchmark::DoNotOptimize(ih->child_at(root, i));
+            }
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+// child_at() of FlatHierarchy walks the sibling list, so its 100k calls are quadratic.
+BENCHMARK(BM_HierarchyLargeWideChildren)->ArgsProduct({{0, 1, 2}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+// Builds a 100k-node tree of fan-out 16 with one add() per node, with range(0) on_changed
+// handlers subscribed, to expose the per-mutation event cost.
+static void BM_HierarchyLargeBuildWithHandlers(benchmark::State& state)
+{
+    ensureRegistered();
+    LargeTree tree(100000, 16);
+    std::vector<Callback> handlers;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        handlers.emplace_back([](FnArgs) -> ReturnValue { return ReturnValue::Success; });
+    }
+    for (auto _ : state) {
+        auto h = create_hierarchy();
+        auto* ih = interface_cast<IHierarchy>(h.get());
+        Event evt = ih->on_changed();
+        for (auto& handler : handlers) {
+            evt.add_handler(handler, Immediate);
+        }
+        h.set_root(tree.nodes[0]);
+        for (size_t i = 1; i < tree.nodes.size(); ++i) {
+            h.add(tree.nodes[(i - 1) / 16], tree.nodes[i]);
+        }
+        benchmark::DoNotOptimize(h.size());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(tree.nodes.size()));
+}
+BENCHMARK(BM_HierarchyLargeBuildWithHandlers)->Arg(0)->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+
+// ===========================================================================
+// Future benchmarks
+// ===========================================================================
+
+// Resolves a future with range(0) continuations attached by then(), each resolving a chained future.
+static void BM_FutureResolve(benchmark::State& state)
+{
+    ensureRegistered();
+    int fired = 0;
+    for (auto _ : state) {
+        auto promise = make_promise();
+        auto future = promise.get_future<int>();
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            future.then([&](FnArgs) -> ReturnValue {
+                ++fired;
+                return ReturnValue::Success;
+            });
+        }
+        promise.set_value(1);
+        benchmark::DoNotOptimize(future.is_ready());
+    }
+    benchmark::DoNotOptimize(fired);
+}
+BENCHMARK(BM_FutureResolve)->Arg(0)->Arg(1)->Arg(4);
+
+// Joins 1000 pending futures and resolves them, with when_all() (range(0) == 1) or with a
+// counter decremented by a callback continuation per future (range(0) == 0).
+static void BM_FutureWhenAll(benchmark::State& state)
+{
+    ensureRegistered();
+    constexpr int count = 1000;
+    std::vector<Promise> promises;
+    std::vector<IFuture::Ptr> futures;
+    for (auto _ : state) {
+        state.PauseTiming();
+        promises.clear();
+        futures.clear();
+        for (int i = 0; i < count; ++i) {
+            promises.push_back(make_promise());
+            futures.push_back(promises.back().get_future<int>());
+        }
+        state.ResumeTiming();
+        if (state.range(0)) {
+            auto all = when_all({futures.data(), futures.size()});
+            for (auto& promise : promises) {
+                promise.set_value(1);
+            }
+            benchmark::DoNotOptimize(all.is_ready());
+        } else {
+            auto all = make_promise();
+            auto pending = std::make_shared<std::atomic<int>>(count);
+            for (auto& future : futures) {
+                future->add_continuation(Callback([all, pending](FnArgs) mutable -> ReturnValue {
+                    if (pending->fetch_sub(1) == 1) {
+                        all.complete();
+                    }
+                    return ReturnValue::Success;
+                }));
+            }
+            for (auto& promise : promises) {
+                promise.set_value(1);
+            }
+            benchmark::DoNotOptimize(all.get_future<void>().is_ready());
+        }
+    }
+}
+BENCHMARK(BM_FutureWhenAll)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// Creates a promise, fulfils it with an int and reads the result back.
+static void BM_PromiseCreateFulfil(benchmark::State& state)
+{
+    ensureRegistered();
+    for (auto _ : state) {
+        auto promise = make_promise();
+        auto future = promise.get_future<int>();
+        promise.set_value(1);
+        benchmark::DoNotOptimize(future.get_result().get_value());
+    }
+}
+BENCHMARK(BM_PromiseCreateFulfil);
+
+// Resolves a chain of range(0) typed then() continuations. range(1) = 0 runs them immediately
+// from set_value(), 1 defers them to update() calls until the end of the chain is ready.
+static void BM_FutureThenChain(benchmark::State& state)
+{
+    ensureRegistered();
+    const auto type = state.range(1) ? Deferred : Immediate;
+    for (auto _ : state) {
+        auto promise = make_promise();
+        auto future = promise.get_future<int>();
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            future = future.then([](int v) -> int { return v + 1; }, type);
+        }
+        promise.set_value(0);
+        while (!future.is_ready()) {
+            instance().update();
+        }
+        benchmark::DoNotOptimize(future.get_result().get_value());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FutureThenChain)->ArgsProduct({{1, 4, 16}, {0, 1}});
+
+// Round trip between two threads blocked in wait(): this thread completes a promise the worker
+// waits on, and the worker completes one this thread waits on. Measures the set_result() to
+// wait() wakeup latency in each direction.
+static void BM_FutureCrossThreadWakeup(benchmark::State& state)
+{
+    ensureRegistered();
+    struct Exchange
+    {
+        Promise ping = make_promise();
+        Promise pong = make_promise();
+    };
+    std::atomic<Exchange*> slot{nullptr};
+    std::atomic<bool> stop{false};
+    std::thread worker([&]() {
+        while (!stop.load(std::memory_order_acquire)) {
+            auto* exchange = slot.exchange(nullptr, std::memory_order_acq_rel);
+            if (!exchange) {
+                std::this_thread::yield();
+                continue;
+            }
+            exchange->ping.get_future<void>().wait();
+            exchange->pong.complete();
+        }
+    });
+    for (auto _ : state) {
+        Exchange exchange;
+        slot.store(&exchange, std::memory_order_release);
+        exchange.ping.complete();
+        exchange.pong.get_future<void>().wait();
+    }
+    stop.store(true, std::memory_order_release);
+    worker.join();
+}
+BENCHMARK(BM_FutureCrossThreadWakeup)->UseRealTime();
+
+// Joins range(0) pending futures with when_all() (range(1) = 0) or when_any() (range(1) = 1) and
+// resolves them all.
+static void BM_FutureFanIn(benchmark::State& state)
+{
+    ensureRegistered();
+    std::vector<Promise> promises;
+    std::vector<IFuture::Ptr> futures;
+    for (auto _ : state) {
+        state.PauseTiming();
+        promises.clear();
+        futures.clear();
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            promises.push_back(make_promise());
+            futures.push_back(promises.back().get_future<int>());
+        }
+        state.ResumeTiming();
+        if (state.range(1)) {
+            auto any = when_any({futures.data(), futures.size()});
+            for (auto& promise : promises) {
+                promise.set_value(1);
+            }
+            benchmark::DoNotOptimize(any.is_ready());
+        } else {
+            auto all = when_all({futures.data(), futures.size()});
+            for (auto& promise : promises) {
+                promise.set_value(1);
+            }
+            benchmark::DoNotOptimize(all.is_ready());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FutureFanIn)
+    ->ArgsProduct({{16, 1024, 65536}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Runs range(0) trivial async() tasks on a 4-worker pool and waits for all of them.
+static void BM_ThreadPoolAsync(benchmark::State& state)
+{
+    ensureRegistered();
+    auto pool = instance().create_thread_pool(4);
+    std::atomic<int> ran{0};
+    std::vector<IFuture::Ptr> futures;
+    for (auto _ : state) {
+        futures.clear();
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            futures.push_back(async(pool, [&]() { ran.fetch_add(1, std::memory_order_relaxed); }));
+        }
+        when_all({futures.data(), futures.size()}).wait();
+    }
+    benchmark::DoNotOptimize(ran.load());
+}
+BENCHMARK(BM_ThreadPoolAsync)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+// Ticks range(0) playing float tweens. The deferred notifications they queue are merged per
+// property, so they are flushed once at the end.
+static void BM_AnimatorTick(benchmark::State& state)
+{
+    ensureRegistered();
+    instance().plugin_registry().load_plugin_from_path(BENCH_ANIMATOR_DLL_PATH);
+    auto animator = instance().create<IAnimator>(ClassId::Animator);
+    std::vector<Property<float>> props;
+    std::vector<Animation> anims;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        props.push_back(create_property<float>(0.f));
+        anims.push_back(create_tween(*animator, props.back(), 0.f, 1.f, Duration::from_seconds(3600.f)));
+    }
+    UpdateInfo info{{}, {}, Duration{1}};
+    for (auto _ : state) {
+        animator->tick(info);
+    }
+    instance().update({});
+    benchmark::DoNotOptimize(props.front().get_value());
+}
+BENCHMARK(BM_AnimatorTick)->Arg(20000)->Unit(benchmark::kMicrosecond);
+
+// Ticks range(0) playing float tweens that each drive range(1) target properties, to separate
+// the per-animation cost from the per-target write-back.
+static void BM_AnimatorTickTargets(benchmark::State& state)
+{
+    ensureRegistered();
+    instance().plugin_registry().load_plugin_from_path(BENCH_ANIMATOR_DLL_PATH);
+    auto animator = instance().create<IAnimator>(ClassId::Animator);
+    std::vector<Property<float>> props;
+    std::vector<Animation> anims;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        props.push_back(create_property<float>(0.f));
+        anims.push_back(create_tween(*animator, props.back(), 0.f, 1.f, Duration::from_seconds(3600.f)));
+        for (int64_t t = 1; t < state.range(1); ++t) {
+            props.push_back(create_property<float>(0.f));
+            anims.back().add_target(props.back());
+        }
+    }
+    UpdateInfo info{{}, {}, Duration{1}};
+    for (auto _ : state) {
+        animator->tick(info);
+    }
+    instance().update({});
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(props.size()));
+    benchmark::DoNotOptimize(props.front().get_value());
+}
+BENCHMARK(BM_AnimatorTickTargets)
+    ->ArgsProduct({{100, 1000}, {1, 8}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Seeks 1000 float tracks of range(0) evenly spaced keyframes to a different position each
+// iteration, which measures the keyframe lookup for long keyframe lists.
+static void BM_AnimatorTickKeyframes(benchmark::State& state)
+{
+    ensureRegistered();
+    instance().plugin_registry().load_plugin_from_path(BENCH_ANIMATOR_DLL_PATH);
+    auto animator = instance().create<IAnimator>(ClassId::Animator);
+    std::vector<Keyframe<float>> keys;
+    for (int64_t k = 0; k < state.range(0); ++k) {
+        keys.push_back({Duration::from_milliseconds(10.f * static_cast<float>(k)), static_cast<float>(k)});
+    }
+    std::vector<Property<float>> props;
+    std::vector<Animation> anims;
+    for (int i = 0; i < 1000; ++i) {
+        props.push_back(create_property<float>(0.f));
+        anims.push_back(create_track<float>(*animator, props.back(), {keys.data(), keys.size()}));
+    }
+    float pos = 0.f;
+    for (auto _ : state) {
+        pos += 0.37f;
+        if (pos >= 1.f) {
+            pos -= 1.f;
+        }
+        for (auto& anim : anims) {
+            anim.seek(pos);
+        }
+    }
+    instance().update({});
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(anims.size()));
+    benchmark::DoNotOptimize(props.front().get_value());
+}
+BENCHMARK(BM_AnimatorTickKeyframes)->Arg(2)->Arg(64)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+namespace {
+
+struct NamedEasing
+{
+    const char* name;
+    easing::EasingFn fn;
+};
+
+const NamedEasing kEasings[] = {
+    {"linear", easing::linear},           {"in_quad", easing::in_quad},
+    {"out_quad", easing::out_quad},       {"in_out_quad", easing::in_out_quad},
+    {"in_cubic", easing::in_cubic},       {"out_cubic", easing::out_cubic},
+    {"in_out_cubic", easing::in_out_cubic}, {"in_sine", easing::in_sine},
+    {"out_sine", easing::out_sine},       {"in_out_sine", easing::in_out_sine},
+    {"in_expo", easing::in_expo},         {"out_expo", easing::out_expo},
+    {"in_out_expo", easing::in_out_expo}, {"in_elastic", easing::in_elastic},
+    {"out_elastic", easing::out_elastic}, {"out_bounce", easing::out_bounce},
+    {"in_bounce", easing::in_bounce},
+};
+
+constexpr int64_t kEasingCount = sizeof(kEasings) / sizeof(kEasings[0]);
+
+} // namespace
+
+// Ticks 10000 playing float tweens that all use the easing function kEasings[range(0)].
+static void BM_AnimatorEasing(benchmark::State& state)
+{
+    ensureRegistered();
+    instance().plugin_registry().load_plugin_from_path(BENCH_ANIMATOR_DLL_PATH);
+    const auto& ease = kEasings[state.range(0)];
+    auto animator = instance().create<IAnimator>(ClassId::Animator);
+    std::vector<Property<float>> props;
+    std::vector<Animation> anims;
+    for (int i = 0; i < 10000; ++i) {
+        props.push_back(create_property<float>(0.f));
+        anims.push_back(
+            create_tween(*animator, props.back(), 0.f, 1.f, Duration::from_seconds(3600.f), ease.fn));
+    }
+    UpdateInfo info{{}, {}, Duration::from_milliseconds(16.f)};
+    for (auto _ : state) {
+        animator->tick(info);
+    }
+    instance().update({});
+    state.SetLabel(ease.name);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(anims.size()));
+    benchmark::DoNotOptimize(props.front().get_value());
+}
+BENCHMARK(BM_AnimatorEasing)->DenseRange(0, kEasingCount - 1)->Unit(benchmark::kMicrosecond);
+
+// Advances the frame time of range(0) properties with a transition each, all animating toward
+// a target. range(1) = 1 also sets a new target on every property each frame, which restarts
+// its transition from the current value.
+static void BM_TransitionMany(benchmark::State& state)
+{
+    ensureRegistered();
+    instance().plugin_registry().load_plugin_from_path(BENCH_ANIMATOR_DLL_PATH);
+    const bool retarget = state.range(1) != 0;
+    std::vector<Property<float>> props;
+    std::vector<Transition> transitions;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        props.push_back(create_property<float>(0.f));
+        transitions.push_back(create_transition(props.back(), Duration::from_seconds(3600.f)));
+    }
+    Duration time = Duration::from_seconds(1.f);
+    instance().update(time);
+    for (auto& prop : props) {
+        prop.set_value(100.f);
+    }
+    float target = 100.f;
+    for (auto _ : state) {
+        if (retarget) {
+            target += 1.f;
+            for (auto& prop : props) {
+                prop.set_value(target);
+            }
+        }
+        time.us += Duration::from_milliseconds(16.f).us;
+        instance().update(time);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    benchmark::DoNotOptimize(props.front().get_value());
+    for (auto& tr : transitions) {
+        tr.remove();
+    }
+    instance().update(time);
+}
+BENCHMARK(BM_TransitionMany)
+    ->ArgsProduct({{100, 10000}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Splits one frame of 10000 playing float tweens into its stages by range(0):
+// 0 = interpolation only (the tweens have no targets), 1 = interpolation and write-back to one
+// target each, 2 = as 1 followed by the update() that flushes the deferred change notifications.
+static void BM_AnimatorTickCostSplit(benchmark::State& state)
+{
+    ensureRegistered();
+    instance().plugin_registry().load_plugin_from_path(BENCH_ANIMATOR_DLL_PATH);
+    const int64_t mode = state.range(0);
+    auto animator = instance().create<IAnimator>(ClassId::Animator);
+    std::vector<Property<float>> props;
+    std::vector<Animation> anims;
+    int handled = 0;
+    Callback handler([&handled](FnArgs) -> ReturnValue {
+        ++handled;
+        return ReturnValue::Success;
+    });
+    for (int i = 0; i < 10000; ++i) {
+        if (mode == 0) {
+            anims.push_back(create_tween(*animator, 0.f, 1.f, Duration::from_seconds(3600.f)));
+            anims.back().play();
+        } else {
+            props.push_back(create_property<float>(0.f));
+            props.back().add_on_changed(handler);
+            anims.push_back(create_tween(*animator, props.back(), 0.f, 1.f, Duration::from_seconds(3600.f)));
+        }
+    }
+    UpdateInfo info{{}, {}, Duration{1}};
+    for (auto _ : state) {
+        animator->tick(info);
+        if (mode == 2) {
+            instance().update({});
+        }
+    }
+    instance().update({});
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(anims.size()));
+    benchmark::DoNotOptimize(handled);
+}
+BENCHMARK(BM_AnimatorTickCostSplit)->DenseRange(0, 2)->Unit(benchmark::kMicrosecond);
+
+// Adds and removes one animation on an animator that already holds range(0) animations.
+static void BM_AnimatorAdd(benchmark::State& state)
+{
+    ensureRegistered();
+    instance().plugin_registry().load_plugin_from_path(BENCH_ANIMATOR_DLL_PATH);
+    auto animator = instance().create<IAnimator>(ClassId::Animator);
+    std::vector<Animation> anims;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        anims.push_back(create_tween(*animator, 0.f, 1.f, Duration::from_seconds(3600.f)));
+    }
+    auto extra = create_tween(*animator, 0.f, 1.f, Duration::from_seconds(3600.f));
+    IAnimation::Ptr anim = extra.get_animation_interface();
+    animator->remove(anim);
+    for (auto _ : state) {
+        animator->add(anim);
+        animator->remove(anim);
+    }
+    benchmark::DoNotOptimize(animator->count());
+}
+BENCHMARK(BM_AnimatorAdd)->Arg(1000)->Arg(100000);
+
+// ===========================================================================
+// Contention benchmarks
+// ===========================================================================
+
+// Concurrent allocate/deallocate of 64 slots per thread on one shared raw hive.
+// range(0) is the magazine size (0 = every operation takes the exclusive lock).
+static void BM_RawHiveChurnThreads(benchmark::State& state)
+{
+    static IHiveStore::Ptr registry;
+    static IRawHive::Ptr hive;
+    if (state.thread_index() == 0) {
+        registry = instance().create<IHiveStore>(ClassId::HiveStore);
+        hive = registry->get_raw_hive(type_uid<PlainData>(), sizeof(PlainData), alignof(PlainData));
+        hive->set_magazine_size(static_cast<size_t>(state.range(0)));
+    }
+
+    std::vector<void*> slots(64);
+    for (auto _ : state) {
+        for (auto& s : slots) {
+            s = hive->allocate();
+        }
+        for (auto* s : slots) {
+            hive->deallocate(s);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(slots.size()));
+
+    if (state.thread_index() == 0) {
+        hive.reset();
+        registry.reset();
+    }
+}
+BENCHMARK(BM_RawHiveChurnThreads)->Arg(0)->Arg(32)->ThreadRange(1, 8)->UseRealTime();
+
+// Deferred writes to 64 properties owned by each thread; the writes are applied by one
+// update() at the end.
+static void BM_PropertySetDeferredThreads(benchmark::State& state)
+{
+    ensureRegistered();
+    std::vector<IObject::Ptr> objs;
+    std::vector<Property<float>> props;
+    for (int i = 0; i < 64; ++i) {
+        objs.push_back(instance().create<IObject>(BenchWidget::class_id()));
+        props.push_back(interface_cast<IBenchWidget>(objs.back())->value());
+    }
+    float v = 0.f;
+    for (auto _ : state) {
+        for (auto& prop : props) {
+            prop.set_value(v, Deferred);
+        }
+        v += 1.f;
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(props.size()));
+
+    if (state.thread_index() == 0) {
+        instance().update();
+    }
+}
+BENCHMARK(BM_PropertySetDeferredThreads)->ThreadRange(1, 8)->Iterations(2000)->UseRealTime();
+
+// Concurrent create() and release of one object per iteration on every thread.
+static void BM_ObjectCreateThreads(benchmark::State& state)
+{
+    ensureRegistered();
+    for (auto _ : state) {
+        auto obj = instance().create<IObject>(BenchWidget::class_id());
+        benchmark::DoNotOptimize(obj.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ObjectCreateThreads)->ThreadRange(1, 8)->UseRealTime();
+
+// Thread 0 adds and removes a leaf under the root of a 1024-node tree while the other threads
+// walk the root's children and look up the parent of a leaf. Only reads are counted as items.
+// range(0) = 0: ClassId::Hierarchy, 1: ClassId::FlatHierarchy.
+static void BM_HierarchyReadDuringWrites(benchmark::State& state)
+{
+    // Set up by thread 0 and only used inside the loop, which every thread enters together.
+    static Hierarchy* h;
+    static IHierarchy* ih;
+    static IObject::Ptr root;
+    static IObject::Ptr leaf;
+    if (state.thread_index() == 0) {
+        ensureRegistered();
+        h = new Hierarchy(build_tree(1024, hierarchy_impl(state.range(0))));
+        ih = interface_cast<IHierarchy>(h->get());
+        root = h->root().object();
+        Node node = h->root();
+        while (node.child_count() > 0) {
+            node = node.child_at(0);
+        }
+        leaf = node.object();
+    }
+
+    int64_t reads = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            auto child = instance().create<IObject>(BenchWidget::class_id());
+            ih->add(root, child);
+            ih->remove(child);
+        } else {
+            size_t count = 0;
+            for (auto& child : ih->children_of(root)) {
+                benchmark::DoNotOptimize(child.get());
+                ++count;
+            }
+            benchmark::DoNotOptimize(ih->parent_of(leaf));
+            benchmark::DoNotOptimize(count);
+            ++reads;
+        }
+    }
+    state.SetItemsProcessed(reads);
+
+    if (state.thread_index() == 0) {
+        leaf.reset();
+        root.reset();
+        delete h;
+    }
+}
+BENCHMARK(BM_HierarchyReadDuringWrites)->Arg(0)->Arg(1)->ThreadRange(2, 8)->UseRealTime();
+
+// Objects created here and released on another thread, so that their last reference and
+// control block are dropped away from the creating thread. Only the creation is timed.
+static void BM_ObjectReleaseCrossThread(benchmark::State& state)
+{
+    ensureRegistered();
+    std::vector<IObject::Ptr> objs(1024);
+    for (auto _ : state) {
+        for (auto& obj : objs) {
+            obj = instance().create<IObject>(BenchWidget::class_id());
+        }
+        state.PauseTiming();
+        std::thread([&] {
+            for (auto& obj : objs) {
+                obj.reset();
+            }
+        }).join();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(objs.size()));
+}
+BENCHMARK(BM_ObjectReleaseCrossThread);
+
+// Copies and releases one shared_ptr to the same object from every thread, contending on its
+// reference count.
+static void BM_ObjectPtrCopyThreads(benchmark::State& state)
+{
+    static IObject::Ptr shared;
+    if (state.thread_index() == 0) {
+        ensureRegistered();
+        shared = instance().create<IObject>(BenchWidget::class_id());
+    }
+    for (auto _ : state) {
+        IObject::Ptr copy = shared;
+        benchmark::DoNotOptimize(copy.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        shared.reset();
+    }
+}
+BENCHMARK(BM_ObjectPtrCopyThreads)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,371 @@
+#include <velk/allocator.h>
+#include <velk/api/callback.h>
+#include <velk/api/property.h>
+#include <velk/api/velk.h>
+#include <velk/ext/object.h>
+#include <velk/string.h>
+#include <velk/interface/hive/intf_hive_store.h>
+#include <velk/interface/intf_metadata.h>
+#include <velk/interface/intf_object_storage.h>
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#elif defined(_WIN32) || defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Measures the heap memory objects actually occupy, by counting every allocation and reporting
+// the growth of the live bytes per created object. Each benchmark runs once and keeps its objects
+// alive until exit, so no object reuses memory another one released to a velk pool or hive.
+//
+// Counters (in the console, --benchmark_format=json or --benchmark_out):
+//   bytes_per_object       Sum of the two below.
+//   velk_bytes_per_object  Memory allocated through velk::IAllocator: objects, control blocks,
+//                          velk containers and hive pages. Pooled control blocks and recycled
+//                          object memory are not counted as in use.
+//   std_bytes_per_object   Memory of the standard containers velk uses internally, counted by a
+//                          replaced global operator new. Not available on Windows, where the
+//                          velk DLL does not use the operator new of the executable.
+//   allocs_per_object      Live allocations of both kinds.
+//
+// Sizes are the usable sizes the C runtime reports, so they include its rounding.
+
+using namespace velk;
+
+// ---------------------------------------------------------------------------
+// Allocation counting
+// ---------------------------------------------------------------------------
+
+namespace {
+
+std::atomic<int64_t> g_velkBytes{0};
+std::atomic<int64_t> g_velkAllocs{0};
+std::atomic<int64_t> g_stdBytes{0};
+std::atomic<int64_t> g_stdAllocs{0};
+
+constexpr size_t kMallocAlignment = alignof(std::max_align_t);
+
+size_t usable_size(void* ptr, size_t alignment)
+{
+#if defined(__APPLE__)
+    (void)alignment;
+    return malloc_size(ptr);
+#elif defined(_WIN32)
+    return alignment > kMallocAlignment ? _aligned_msize(ptr, alignment, 0) : _msize(ptr);
+#elif defined(__GLIBC__)
+    (void)alignment;
+    return malloc_usable_size(ptr);
+#else
+    (void)ptr;
+    (void)alignment;
+    return 0;
+#endif
+}
+
+class CountingAllocator final : public IAllocator
+{
+public:
+    void* allocate(size_t size, size_t alignment, MemoryTag) override
+    {
+        void* ptr;
+        if (alignment <= kMallocAlignment) {
+            ptr = std::malloc(size);
+        } else {
+#ifdef _WIN32
+            ptr = _aligned_malloc(size, alignment);
+#else
+            ptr = std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+        }
+        if (ptr) {
+            g_velkBytes.fetch_add(static_cast<int64_t>(usable_size(ptr, alignment)), std::memory_order_relaxed);
+            g_velkAllocs.fetch_add(1, std::memory_order_relaxed);
+        }
+        return ptr;
+    }
+
+    void deallocate(void* ptr, size_t alignment, MemoryTag) override
+    {
+        g_velkBytes.fetch_sub(static_cast<int64_t>(usable_size(ptr, alignment)), std::memory_order_relaxed);
+        g_velkAllocs.fetch_sub(1, std::memory_order_relaxed);
+#ifdef _WIN32
+        if (alignment > kMallocAlignment) {
+            _aligned_free(ptr);
+            return;
+        }
+#endif
+        std::free(ptr);
+    }
+};
+
+CountingAllocator g_allocator;
+
+// Installed before main(), ahead of the first velk allocation.
+const bool g_allocatorInstalled = set_allocator(&g_allocator);
+
+} // namespace
+
+#if !defined(_WIN32) && (defined(__APPLE__) || defined(__GLIBC__))
+
+// The array, nothrow and sized forms of the standard library forward to these.
+void* operator new(size_t size)
+{
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    g_stdBytes.fetch_add(static_cast<int64_t>(usable_size(ptr, 0)), std::memory_order_relaxed);
+    g_stdAllocs.fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (!ptr) {
+        return;
+    }
+    g_stdBytes.fetch_sub(static_cast<int64_t>(usable_size(ptr, 0)), std::memory_order_relaxed);
+    g_stdAllocs.fetch_sub(1, std::memory_order_relaxed);
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    ::operator delete(ptr);
+}
+
+#endif
+
+namespace {
+
+/** @brief Live heap memory at one point in time. */
+struct Footprint
+{
+    int64_t velkBytes{};
+    int64_t stdBytes{};
+    int64_t allocs{};
+};
+
+Footprint sample()
+{
+    // Pooled blocks and recycled objects are allocated but not in use by any object.
+    auto stats = instance().get_memory_stats();
+    Footprint f;
+    f.velkBytes = g_velkBytes.load(std::memory_order_relaxed) -
+                  static_cast<int64_t>(stats[MemoryCategory::PooledControlBlocks].bytes) -
+                  static_cast<int64_t>(stats[MemoryCategory::RecycledObjects].bytes);
+    f.stdBytes = g_stdBytes.load(std::memory_order_relaxed);
+    f.allocs = g_velkAllocs.load(std::memory_order_relaxed) + g_stdAllocs.load(std::memory_order_relaxed) -
+               static_cast<int64_t>(stats[MemoryCategory::PooledControlBlocks].count) -
+               static_cast<int64_t>(stats[MemoryCategory::RecycledObjects].count);
+    return f;
+}
+
+// Objects of finished benchmarks, kept alive so later benchmarks allocate fresh memory.
+std::vector<std::vector<IInterface::Ptr>>& retained()
+{
+    static std::vector<std::vector<IInterface::Ptr>> objects;
+    return objects;
+}
+
+constexpr int64_t kObjectCount = 10000;
+
+/**
+ * @brief Creates kObjectCount objects with @p create and reports the memory they added.
+ *
+ * @p create returns the object, which is kept alive to the end of the process.
+ */
+template <class Fn>
+void measure(benchmark::State& state, Fn&& create)
+{
+    if (!g_allocatorInstalled) {
+        state.SkipWithError("velk allocated memory before the counting allocator was installed");
+        return;
+    }
+    std::vector<IInterface::Ptr> objects;
+    objects.reserve(kObjectCount);
+    Footprint before;
+    Footprint after;
+    for (auto _ : state) {
+        before = sample();
+        for (int64_t i = 0; i < kObjectCount; ++i) {
+            objects.push_back(create());
+        }
+        after = sample();
+    }
+    auto perObject = [](int64_t bytes) { return static_cast<double>(bytes) / kObjectCount; };
+    int64_t velkBytes = after.velkBytes - before.velkBytes;
+    int64_t stdBytes = after.stdBytes - before.stdBytes;
+    state.counters["bytes_per_object"] = perObject(velkBytes + stdBytes);
+    state.counters["velk_bytes_per_object"] = perObject(velkBytes);
+    state.counters["std_bytes_per_object"] = perObject(stdBytes);
+    state.counters["allocs_per_object"] = perObject(after.allocs - before.allocs);
+    retained().push_back(std::move(objects));
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Representative classes
+// ---------------------------------------------------------------------------
+
+// The minimal object of docs/performance.md.
+class IToggle : public Interface<IToggle>
+{
+public:
+    VELK_INTERFACE(
+        (PROP, bool, enabled, false)
+    )
+};
+
+class Toggle : public ext::Object<Toggle, IToggle>
+{};
+
+// MyWidget of docs/performance.md, with 6 members over two interfaces.
+class IMyWidget : public Interface<IMyWidget>
+{
+public:
+    VELK_INTERFACE(
+        (PROP, float, width, 100.f),
+        (PROP, float, height, 50.f),
+        (EVT, on_clicked),
+        (FN, void, reset)
+    )
+};
+
+class ISerializable : public Interface<ISerializable>
+{
+public:
+    VELK_INTERFACE(
+        (PROP, string, name, ""),
+        (FN, void, serialize)
+    )
+};
+
+class MyWidget : public ext::Object<MyWidget, IMyWidget, ISerializable>
+{
+    void fn_reset() override {}
+    void fn_serialize() override {}
+};
+
+class ObservedMyWidget : public ext::ObservedObject<ObservedMyWidget, IMyWidget, ISerializable>
+{
+    void fn_reset() override {}
+    void fn_serialize() override {}
+};
+
+// Eight properties to observe.
+class IPropertyBank : public Interface<IPropertyBank>
+{
+public:
+    VELK_INTERFACE(
+        (PROP, float, p0, 0.f),
+        (PROP, float, p1, 0.f),
+        (PROP, float, p2, 0.f),
+        (PROP, float, p3, 0.f),
+        (PROP, float, p4, 0.f),
+        (PROP, float, p5, 0.f),
+        (PROP, float, p6, 0.f),
+        (PROP, float, p7, 0.f)
+    )
+};
+
+class PropertyBank : public ext::Object<PropertyBank, IPropertyBank>
+{};
+
+static void ensureRegistered()
+{
+    static bool done = false;
+    if (!done) {
+        instance().type_registry().register_type<Toggle>();
+        instance().type_registry().register_type<MyWidget>();
+        instance().type_registry().register_type<ObservedMyWidget>();
+        instance().type_registry().register_type<PropertyBank>();
+        done = true;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Footprints
+// ---------------------------------------------------------------------------
+
+// Objects from instance().create() whose metadata is never accessed.
+template <class T>
+static void BM_FootprintCreate(benchmark::State& state)
+{
+    ensureRegistered();
+    measure(state, [] { return instance().create(T::class_id()); });
+}
+BENCHMARK_TEMPLATE(BM_FootprintCreate, Toggle)->Iterations(1);
+BENCHMARK_TEMPLATE(BM_FootprintCreate, MyWidget)->Iterations(1);
+BENCHMARK_TEMPLATE(BM_FootprintCreate, ObservedMyWidget)->Iterations(1);
+
+// Objects whose ObjectStorage is materialized by looking up their first property.
+template <class T>
+static void BM_FootprintStorage(benchmark::State& state)
+{
+    ensureRegistered();
+    measure(state, [] {
+        auto obj = instance().create(T::class_id());
+        auto* meta = interface_cast<IMetadata>(obj);
+        meta->get_property(meta->get_static_metadata()[0].name);
+        return obj;
+    });
+}
+BENCHMARK_TEMPLATE(BM_FootprintStorage, Toggle)->Iterations(1);
+BENCHMARK_TEMPLATE(BM_FootprintStorage, MyWidget)->Iterations(1);
+BENCHMARK_TEMPLATE(BM_FootprintStorage, ObservedMyWidget)->Iterations(1);
+
+// Objects added to a hive of their class, which holds them in its own pages.
+template <class T>
+static void BM_FootprintHive(benchmark::State& state)
+{
+    ensureRegistered();
+    auto store = instance().create<IHiveStore>(ClassId::HiveStore);
+    auto hive = store->get_hive<T>();
+    measure(state, [&] { return interface_pointer_cast<IInterface>(hive->add()); });
+    retained().push_back({store, hive});
+}
+BENCHMARK_TEMPLATE(BM_FootprintHive, Toggle)->Iterations(1);
+BENCHMARK_TEMPLATE(BM_FootprintHive, MyWidget)->Iterations(1);
+
+// PropertyBank objects with an on_changed handler on range(0) of their 8 properties. All
+// objects share one handler, so the cost is the property and event instances.
+static void BM_FootprintObserved(benchmark::State& state)
+{
+    ensureRegistered();
+    Callback handler([](FnArgs) -> ReturnValue { return ReturnValue::Success; });
+    const auto observed = static_cast<size_t>(state.range(0));
+    measure(state, [&] {
+        auto obj = instance().create(PropertyBank::class_id());
+        auto* meta = interface_cast<IMetadata>(obj);
+        auto members = meta->get_static_metadata();
+        for (size_t i = 0; i < observed; ++i) {
+            Property<float>(meta->get_property(members[i].name)).add_on_changed(handler);
+        }
+        return obj;
+    });
+}
+BENCHMARK(BM_FootprintObserved)->Arg(0)->Arg(1)->Arg(4)->Arg(8)->Iterations(1);
+
+// MyWidget objects carrying range(0) Toggle attachments, which are counted with their host.
+static void BM_FootprintAttachments(benchmark::State& state)
+{
+    ensureRegistered();
+    const auto count = state.range(0);
+    measure(state, [&] {
+        auto obj = instance().create(MyWidget::class_id());
+        auto* storage = interface_cast<IObjectStorage>(obj);
+        for (int64_t i = 0; i < count; ++i) {
+            storage->add_attachment(instance().create(Toggle::class_id()));
+        }
+        return obj;
+    });
+}
+BENCHMARK(BM_FootprintAttachments)->Arg(1)->Arg(4)->Iterations(1);
@@ -148,6 +148,16 @@ TEST(InterpolatorTrait, CustomSpecialization)
     EXPECT_FLOAT_EQ(10.f, mid.y);
 }
 
+TEST(InterpolatorTrait, RawTypedInterpolator)
+{
+    Vec2 a{0.f, 0.f};
+    Vec2 b{10.f, 20.f};
+    Vec2 mid;
+    detail::raw_typed_interpolator<Vec2>(&a, &b, 0.25f, &mid);
+    EXPECT_FLOAT_EQ(2.5f, mid.x);
+    EXPECT_FLOAT_EQ(5.f, mid.y);
+}
+
 // ============================================================================
 // Plugin / Animator tests (require velk_animator.dll)
 // ============================================================================
@@ -188,6 +198,26 @@ TEST_F(AnimatorPluginTest, AnimatorTypeRegistered)
     EXPECT_NE(nullptr, animator);
 }
 
+TEST_F(AnimatorPluginTest, RawInterpolatorsRegistered)
+{
+    auto& types = instance().type_registry();
+    auto raw = types.find_raw_interpolator(type_uid<float>());
+    ASSERT_NE(nullptr, raw);
+    float a = 10.f, b = 20.f, r = 0.f;
+    raw(&a, &b, 0.5f, &r);
+    EXPECT_FLOAT_EQ(15.f, r);
+
+    types.register_interpolator<Vec2>(&detail::typed_interpolator<Vec2>,
+                                      &detail::raw_typed_interpolator<Vec2>);
+    EXPECT_NE(nullptr, types.find_raw_interpolator(type_uid<Vec2>()));
+    // Replacing the interpolator without a raw function drops the previous one.
+    types.register_interpolator<Vec2>(&detail::typed_interpolator<Vec2>);
+    EXPECT_NE(nullptr, types.find_interpolator(type_uid<Vec2>()));
+    EXPECT_EQ(nullptr, types.find_raw_interpolator(type_uid<Vec2>()));
+    types.unregister_interpolator<Vec2>();
+    EXPECT_EQ(nullptr, types.find_raw_interpolator(type_uid<Vec2>()));
+}
+
 TEST_F(AnimatorPluginTest, AnimationProperties)
 {
     auto obj = instance().create<IObject>(ClassId::AnimationTrack);
@@ -366,6 +396,99 @@ TEST_F(AnimatorTest, PauseAndResume)
     EXPECT_TRUE(h.is_finished());
 }
 
+TEST_F(AnimatorTest, IdleTracksWakeAndLeave)
+{
+    vector<Property<float>> props;
+    vector<Animation> anims;
+    for (int i = 0; i < 6; ++i) {
+        props.push_back(create_property<float>(0.f));
+        anims.push_back(create_tween(*animator_, props.back(), 0.f, 100.f, sec(1.f)));
+    }
+    animator_->tick(dt(0.25f));
+    for (auto& anim : anims) {
+        anim.pause();
+    }
+    animator_->tick(dt(0.25f)); // All of them move to the idle list.
+    animator_->tick(dt(0.25f));
+    flush();
+    EXPECT_EQ(6u, animator_->count());
+    EXPECT_EQ(0u, animator_->active_count());
+
+    // Woken and removed out of slot order.
+    animator_->set_lod(anims[3].get_animation_interface(), 2);
+    EXPECT_EQ(2u, animator_->get_lod(anims[3].get_animation_interface()));
+    anims[4].play();
+    anims[0].play();
+    animator_->remove(anims[1].get_animation_interface());
+    anims[5] = Animation();
+    props[5] = Property<float>(IProperty::Ptr{}); // Destroys the track installed on it.
+    anims[3].play();
+    EXPECT_EQ(4u, animator_->count());
+    EXPECT_EQ(3u, animator_->active_count());
+
+    // Adding twice keeps one entry; a removed track comes back.
+    animator_->add(anims[0].get_animation_interface());
+    animator_->add(anims[1].get_animation_interface());
+    anims[1].play();
+    EXPECT_EQ(5u, animator_->count());
+
+    animator_->tick(dt(0.25f));
+    flush();
+    for (int i : {0, 1, 3, 4}) {
+        EXPECT_NEAR(50.f, props[i].get_value(), 0.1f) << i;
+    }
+    EXPECT_NEAR(25.f, props[2].get_value(), 0.1f);
+    EXPECT_EQ(2u, animator_->get_lod(anims[3].get_animation_interface()));
+
+    anims[2].play();
+    animator_->tick(dt(0.75f));
+    flush();
+    for (int i : {0, 1, 3, 4}) {
+        EXPECT_FLOAT_EQ(100.f, props[i].get_value()) << i;
+    }
+    EXPECT_NEAR(100.f, props[2].get_value(), 0.1f);
+    EXPECT_EQ(0u, animator_->active_count());
+    EXPECT_EQ(5u, animator_->count());
+}
+
+TEST_F(AnimatorTest, StatsCountTick)
+{
+    auto a = create_property<float>(0.f);
+    auto b = create_property<float>(0.f);
+    auto c = create_property<float>(0.f);
+    create_tween(*animator_, a, 0.f, 100.f, sec(1.f));
+    create_tween(*animator_, b, 0.f, 100.f, sec(1.f));
+    auto hc = create_tween(*animator_, c, 0.f, 100.f, sec(1.f));
+
+    auto check = [&](size_t ticked, size_t batched, size_t skipped, size_t idle, size_t finished) {
+        auto& stats = animator_->get_stats();
+        EXPECT_EQ(ticked, stats.ticked);
+        EXPECT_EQ(batched, stats.batched);
+        EXPECT_EQ(skipped, stats.skipped);
+        EXPECT_EQ(idle, stats.idle);
+        EXPECT_EQ(finished, stats.finished);
+        EXPECT_EQ(ticked, stats.targetWrites);
+        EXPECT_GE(stats.time.us, 0);
+    };
+
+    animator_->tick(dt(0.5f)); // One by one, then into a batch.
+    check(3, 0, 0, 0, 0);
+    animator_->tick(dt(0.25f));
+    check(3, 3, 0, 0, 0);
+
+    animator_->set_lod(hc.get_animation_interface(), 1);
+    animator_->set_lod_interval(1, 0);
+    animator_->tick(dt(0.1f));
+    check(2, 2, 1, 0, 0);
+
+    animator_->tick(dt(0.5f)); // Reaching the end ticks the tracks on their own.
+    check(2, 0, 1, 0, 2);
+    animator_->tick(dt(0.1f));
+    check(0, 0, 1, 2, 0);
+    flush();
+    EXPECT_FLOAT_EQ(100.f, a.get_value());
+}
+
 TEST_F(AnimatorTest, Restart)
 {
     auto h = create_tween(*animator_, prop_, 0.f, 100.f, sec(1.f));
@@ -416,6 +539,292 @@ TEST_F(AnimatorTest, ProgressProperty)
     EXPECT_FLOAT_EQ(1.f, h.get_progress());
 }
 
+// ============================================================================
+// Batched tick tests (tracks playing for more than one tick)
+// ============================================================================
+
+TEST_F(AnimatorTest, BatchedTweensAdvance)
+{
+    vector<Property<float>> props;
+    vector<Animation> anims;
+    for (int i = 0; i < 8; ++i) {
+        props.push_back(create_property<float>(0.f));
+        anims.push_back(create_tween(*animator_, props.back(), 0.f, 10.f * (i + 1), sec(1.f)));
+    }
+    auto d = create_property<double>(0.0);
+    create_tween(*animator_, d, 0.0, 1.0, sec(1.f));
+
+    for (int step = 1; step <= 9; ++step) {
+        animator_->tick(dt(0.1f));
+        flush();
+        for (int i = 0; i < 8; ++i) {
+            EXPECT_NEAR(step * (i + 1), props[i].get_value(), 0.01f);
+        }
+        EXPECT_NEAR(step * 0.1f, anims[0].get_progress(), 1e-4f);
+        EXPECT_NEAR(step * 0.1, d.get_value(), 1e-4);
+    }
+    EXPECT_EQ(9u, animator_->active_count());
+    EXPECT_EQ(9u, animator_->count());
+
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_TRUE(anims[0].is_finished());
+    EXPECT_FLOAT_EQ(80.f, props[7].get_value());
+    EXPECT_DOUBLE_EQ(1.0, d.get_value());
+    EXPECT_EQ(0u, animator_->active_count());
+    EXPECT_EQ(9u, animator_->count());
+}
+
+TEST_F(AnimatorTest, BatchedTrackCrossesKeyframes)
+{
+    auto kfs = vector<Keyframe<float>>{
+        {sec(0.f), 0.f},
+        {sec(0.3f), 30.f, easing::linear},
+        {sec(0.6f), 0.f, easing::linear},
+    };
+    auto h = create_track(*animator_, prop_, kfs);
+    float expected[] = {10.f, 20.f, 30.f, 20.f, 10.f};
+    for (float value : expected) {
+        animator_->tick(dt(0.1f));
+        flush();
+        EXPECT_NEAR(value, prop_.get_value(), 0.01f);
+    }
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_TRUE(h.is_finished());
+    EXPECT_FLOAT_EQ(0.f, prop_.get_value());
+}
+
+TEST_F(AnimatorTest, BatchedTrackPauseSeekAndRemove)
+{
+    auto h = create_tween(*animator_, prop_, 0.f, 100.f, sec(1.f));
+    animator_->tick(dt(0.1f));
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_NEAR(20.f, prop_.get_value(), 0.01f);
+
+    h.pause();
+    EXPECT_EQ(0u, animator_->active_count());
+    EXPECT_EQ(1u, animator_->count());
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_NEAR(20.f, prop_.get_value(), 0.01f);
+
+    h.play();
+    h.seek(0.5f);
+    h.play();
+    animator_->tick(dt(0.1f));
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_NEAR(70.f, prop_.get_value(), 0.01f);
+    EXPECT_EQ(1u, animator_->active_count());
+
+    animator_->remove(h.get_animation_interface());
+    EXPECT_EQ(0u, animator_->count());
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_NEAR(70.f, prop_.get_value(), 0.01f);
+
+    animator_->add(h.get_animation_interface());
+    animator_->add(h.get_animation_interface());
+    animator_->tick(dt(0.1f));
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_NEAR(90.f, prop_.get_value(), 0.01f);
+    EXPECT_EQ(1u, animator_->count());
+}
+
+TEST_F(AnimatorTest, BatchedTrackDestroyedAndCancelled)
+{
+    {
+        auto other = create_property<float>(0.f);
+        create_tween(*animator_, other, 0.f, 100.f, sec(1.f));
+        animator_->tick(dt(0.1f));
+        animator_->tick(dt(0.1f));
+        // The property and with it the track are destroyed while the track is batched.
+    }
+    auto h = create_tween(*animator_, prop_, 0.f, 100.f, sec(1.f));
+    animator_->tick(dt(0.1f));
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_EQ(1u, animator_->count());
+
+    animator_->cancel_all();
+    EXPECT_EQ(0u, animator_->count());
+    float value = prop_.get_value();
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_FLOAT_EQ(value, prop_.get_value());
+}
+
+TEST_F(AnimatorTest, BatchedTweensUseEasing)
+{
+    easing::EasingFn eases[] = {easing::in_out_cubic, easing::in_out_quad, easing::out_bounce,
+                                [](float t) { return t * t * t * t; }};
+    vector<Property<float>> props;
+    for (auto ease : eases) {
+        // Enough tracks per easing for the vector kernels and their scalar remainder.
+        for (int i = 0; i < 6; ++i) {
+            props.push_back(create_property<float>(0.f));
+            create_tween(*animator_, props.back(), 0.f, 100.f, sec(1.f), ease);
+        }
+    }
+    for (int step = 1; step <= 9; ++step) {
+        animator_->tick(dt(0.1f));
+        flush();
+        for (size_t i = 0; i < props.size(); ++i) {
+            EXPECT_NEAR(100.f * eases[i / 6](step * 0.1f), props[i].get_value(), 0.01f);
+        }
+    }
+}
+
+TEST_F(AnimatorTest, ParallelTickMatchesSerial)
+{
+    auto pool = instance().create_thread_pool(3);
+    animator_->set_executor(pool);
+    EXPECT_EQ(IExecutor::Ptr(pool), animator_->get_executor());
+
+    // Enough tracks in two batches for several chunks each.
+    vector<Property<float>> props;
+    vector<Animation> anims;
+    for (int i = 0; i < 3000; ++i) {
+        props.push_back(create_property<float>(0.f));
+        anims.push_back(create_tween(*animator_, props.back(), 0.f, float(i), sec(1.f),
+                                     i % 2 ? easing::linear : easing::in_out_quad));
+    }
+    int notified = 0;
+    Callback onChanged([&]() { notified++; });
+    props[1].add_on_changed(onChanged);
+
+    for (int step = 1; step <= 9; ++step) {
+        if (step == 5) {
+            anims[3].pause();
+        }
+        animator_->tick(dt(0.1f));
+        flush();
+        EXPECT_EQ(step, notified);
+        for (int i : {0, 1, 2, 1500, 2999}) {
+            auto ease = i % 2 ? easing::linear : easing::in_out_quad;
+            EXPECT_NEAR(i * ease(step * 0.1f), props[i].get_value(), 0.01f * (i + 1));
+        }
+        EXPECT_NEAR(std::min(step, 4) * 0.3f, props[3].get_value(), 0.01f);
+    }
+    EXPECT_EQ(2999u, animator_->active_count());
+
+    animator_->set_executor(nullptr);
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_FLOAT_EQ(2999.f, props[2999].get_value());
+}
+
+TEST_F(AnimatorTest, BakedTrackInterpolatesSamples)
+{
+    auto kfs = vector<Keyframe<float>>{
+        {sec(0.f), 0.f},
+        {sec(0.5f), 100.f, easing::in_out_sine},
+        {sec(1.f), 0.f, easing::out_expo},
+    };
+    auto exact = create_track(*animator_, prop_, kfs);
+    auto baked_prop = create_property<float>(0.f);
+    auto baked = create_track(*animator_, baked_prop, kfs);
+    baked.set_sample_rate(200);
+    auto coarse_prop = create_property<float>(0.f);
+    auto coarse = create_track(*animator_, coarse_prop, kfs);
+    coarse.set_sample_rate(2);
+
+    for (int step = 1; step < 20; ++step) {
+        animator_->tick(dt(0.05f));
+        flush();
+        EXPECT_NEAR(prop_.get_value(), baked_prop.get_value(), 0.5f);
+    }
+    // Two samples per second: 0 at 0s, 100 at 0.5s, 0 at 1s, linear in between.
+    coarse.seek(0.25f);
+    flush();
+    EXPECT_NEAR(50.f, coarse_prop.get_value(), 0.01f);
+    coarse.seek(0.6f);
+    flush();
+    EXPECT_NEAR(80.f, coarse_prop.get_value(), 0.01f);
+
+    // Without a rate, the track evaluates the keyframes exactly again.
+    coarse.set_sample_rate(0);
+    coarse.seek(0.25f);
+    flush();
+    EXPECT_NEAR(100.f * easing::in_out_sine(0.5f), coarse_prop.get_value(), 0.01f);
+
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_TRUE(baked.is_finished());
+    EXPECT_FLOAT_EQ(0.f, baked_prop.get_value());
+}
+
+TEST_F(AnimatorTest, LodLevelsThrottleTicks)
+{
+    auto far_prop = create_property<float>(0.f);
+    auto frozen_prop = create_property<float>(0.f);
+    auto near = create_tween(*animator_, prop_, 0.f, 100.f, sec(1.f));
+    auto far = create_tween(*animator_, far_prop, 0.f, 100.f, sec(1.f));
+    auto frozen = create_tween(*animator_, frozen_prop, 0.f, 100.f, sec(1.f));
+    animator_->tick(dt(0.1f)); // All three join their batch.
+    animator_->set_lod(far.get_animation_interface(), 1);
+    animator_->set_lod(frozen.get_animation_interface(), 99);
+    EXPECT_EQ(1u, animator_->get_lod(far.get_animation_interface()));
+    EXPECT_EQ(IAnimator::LOD_COUNT - 1, animator_->get_lod(frozen.get_animation_interface()));
+    EXPECT_EQ(0u, animator_->get_lod(near.get_animation_interface()));
+    animator_->set_lod_interval(1, 3);
+    animator_->set_lod_interval(IAnimator::LOD_COUNT - 1, 0);
+    EXPECT_EQ(3u, animator_->get_lod_interval(1));
+
+    float far_expected[] = {10.f, 10.f, 40.f, 40.f, 40.f, 70.f};
+    for (int step = 0; step < 6; ++step) {
+        animator_->tick(dt(0.1f));
+        flush();
+        EXPECT_NEAR(10.f * (step + 2), prop_.get_value(), 0.01f);
+        // Every third tick, with the dt of all three.
+        EXPECT_NEAR(far_expected[step], far_prop.get_value(), 0.01f);
+        EXPECT_NEAR(10.f, frozen_prop.get_value(), 0.01f);
+    }
+    EXPECT_EQ(3u, animator_->active_count());
+
+    // Switching a level back updates all of its animations every tick again.
+    animator_->set_lod_interval(IAnimator::LOD_COUNT - 1, 1);
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_NEAR(20.f, frozen_prop.get_value(), 0.01f);
+    // The dt level 1 accumulated since its last update stays with the level.
+    animator_->set_lod(far.get_animation_interface(), 0);
+    animator_->tick(dt(0.1f));
+    flush();
+    EXPECT_NEAR(80.f, far_prop.get_value(), 0.01f);
+}
+
+TEST_F(AnimatorTest, TrackFindsSegmentAfterSkipsAndSeeks)
+{
+    // Keyframes every 0.1s with value 10 * time, so the value is 100 * elapsed wherever it lands.
+    vector<Keyframe<float>> kfs;
+    for (int i = 0; i <= 100; ++i) {
+        kfs.push_back({sec(i * 0.1f), i * 10.f, easing::linear});
+    }
+    auto h = create_track(*animator_, prop_, kfs);
+    float elapsed = 0.f;
+    for (float step : {0.05f, 0.05f, 0.1f, 0.35f, 1.2f, 0.01f}) {
+        elapsed += step;
+        animator_->tick(dt(step));
+        flush();
+        EXPECT_NEAR(100.f * elapsed, prop_.get_value(), 0.05f);
+    }
+    for (float p : {0.2f, 0.85f, 0.015f, 0.5f}) {
+        h.seek(p);
+        flush();
+        EXPECT_NEAR(1000.f * p, prop_.get_value(), 0.05f);
+    }
+    h.seek(0.3f);
+    h.play();
+    animator_->tick(dt(0.25f));
+    animator_->tick(dt(0.05f));
+    flush();
+    EXPECT_NEAR(330.f, prop_.get_value(), 0.05f);
+}
+
 // ============================================================================
 // AnimationTrack tests
 // ============================================================================
@@ -655,6 +1064,37 @@ TEST_F(ImplicitAnimationTest, OnChangedFiresDuringTick)
     tr.remove();
 }
 
+TEST_F(ImplicitAnimationTest, InlineTransitionNotifiesOncePerTick)
+{
+    auto tr = create_transition(prop_, sec(1.f));
+    auto other = create_property<float>(0.f);
+    tr.add_target(other);
+
+    int changeCount = 0;
+    Callback handler([&]() { changeCount++; });
+    prop_.add_on_changed(handler);
+
+    prop_.set_value(100.f);
+    other.set_value(10.f);
+    for (int step = 1; step <= 4; ++step) {
+        advance(0.25f);
+        EXPECT_EQ(step, changeCount);
+        EXPECT_NEAR(step * 25.f, prop_.get_value(), 0.01f);
+        EXPECT_NEAR(step * 2.5f, other.get_value(), 0.01f);
+    }
+
+    // A target released mid-transition is no longer notified.
+    prop_.set_value(0.f);
+    other.set_value(0.f);
+    other = Property<float>(IProperty::Ptr{});
+    advance(0.5f);
+    EXPECT_EQ(5, changeCount);
+    EXPECT_NEAR(50.f, prop_.get_value(), 0.01f);
+
+    prop_.remove_on_changed(handler);
+    tr.remove();
+}
+
 TEST_F(ImplicitAnimationTest, EasingApplied)
 {
     auto tr = create_transition(prop_, sec(1.f), easing::in_quad);
@@ -2,6 +2,7 @@
 #include <velk/api/velk.h>
 #include <velk/ext/any.h>
 #include <velk/interface/intf_any.h>
+#include <velk/string.h>
 
 #include <gtest/gtest.h>
 
@@ -60,6 +61,47 @@ TEST(AnyValue, CloneProducesIndependentCopy)
     EXPECT_FLOAT_EQ(clonedVal, 99.f);
 }
 
+TEST(AnyValue, ScalarAnysComeFromPoolOnRequest)
+{
+    auto pooled_any = [] {
+        return interface_pointer_cast<IAny>(instance().create(type_uid<float>(), ObjectFlags::Pooled));
+    };
+    auto is_pooled = [](const IAny::Ptr& any) {
+        auto* obj = interface_cast<IObject>(any);
+        return obj && (obj->get_object_flags() & ObjectFlags::HiveManaged);
+    };
+
+    // Clones and plain creates are allocated one by one.
+    ext::AnyValue<float> original;
+    original.set_value(2.f);
+    auto cloned = original.clone();
+    ASSERT_TRUE(cloned);
+    EXPECT_FALSE(is_pooled(cloned));
+    EXPECT_EQ(Any<const float>(cloned).get_value(), 2.f);
+    EXPECT_FALSE(is_pooled(instance().create_any(type_uid<float>())));
+
+    auto any = pooled_any();
+    ASSERT_TRUE(any);
+    EXPECT_TRUE(is_pooled(any));
+    EXPECT_FALSE(interface_cast<IObject>(any)->get_object_flags() & ObjectFlags::Pooled);
+
+    // A released slot is reused, unless a weak_ptr still refers to the released any.
+    const IAny* address = any.get();
+    any.reset();
+    auto reused = pooled_any();
+    EXPECT_EQ(reused.get(), address);
+    IAny::WeakPtr weak = reused;
+    reused.reset();
+    auto next = pooled_any();
+    EXPECT_NE(next.get(), address);
+    EXPECT_FALSE(weak.lock());
+
+    // Classes outside the pool ignore the flag.
+    auto text = interface_pointer_cast<IAny>(instance().create(type_uid<string>(), ObjectFlags::Pooled));
+    ASSERT_TRUE(text);
+    EXPECT_FALSE(is_pooled(text));
+}
+
 TEST(AnyRef, ReadWriteThroughExternalPointer)
 {
     float storage = 100.f;
@@ -120,3 +162,67 @@ TEST(AnyValue, CopyFromIncompatibleFails)
     ext::AnyValue<float> b;
     EXPECT_EQ(b.copy_from(a), ReturnValue::Fail);
 }
+
+namespace {
+
+/** @brief AnyCore with custom storage that counts its writes. */
+class CountingAny final : public ext::AnyCore<CountingAny, int>
+{
+public:
+    const int& get_value() const override { return data_; }
+    ReturnValue set_value(const int& value) override
+    {
+        ++writes;
+        return AnyCore::set_value(value);
+    }
+
+    int writes{};
+
+private:
+    int data_{};
+};
+
+} // namespace
+
+TEST(AnyValue, CopyFromSameTypeClasses)
+{
+    ext::AnyValue<int> value;
+    value.set_value(3);
+    int field = 0;
+    ext::AnyRef<int> ref(&field);
+
+    EXPECT_EQ(ref.copy_from(value), ReturnValue::Success);
+    EXPECT_EQ(field, 3);
+    EXPECT_EQ(ref.copy_from(value), ReturnValue::NothingToDo);
+    field = 5;
+    EXPECT_EQ(value.copy_from(ref), ReturnValue::Success);
+    EXPECT_EQ(value.get_value(), 5);
+
+    // A custom AnyCore reads and writes through its own overrides.
+    CountingAny counting;
+    EXPECT_EQ(counting.copy_from(ref), ReturnValue::Success);
+    EXPECT_EQ(counting.get_value(), 5);
+    EXPECT_EQ(counting.writes, 1);
+    EXPECT_EQ(value.copy_from(counting), ReturnValue::NothingToDo);
+}
+
+TEST(AnyArg, ViewsCallerValue)
+{
+    float value = 2.5f;
+    ext::AnyArg<float> arg(value);
+
+    float out = 0.f;
+    EXPECT_EQ(arg.get_data(&out, sizeof(out), type_uid<float>()), ReturnValue::Success);
+    EXPECT_FLOAT_EQ(out, 2.5f);
+    EXPECT_EQ(arg.get_data(&out, sizeof(out), type_uid<int>()), ReturnValue::Fail);
+    EXPECT_EQ(arg.set_data(&out, sizeof(out), type_uid<float>()), ReturnValue::ReadOnly);
+    EXPECT_FALSE(arg.get_self());
+
+    // Typed wrappers take a reference, which is a no-op without a control block.
+    EXPECT_FLOAT_EQ(Any<const float>(static_cast<const IAny&>(arg)).get_value(), 2.5f);
+
+    auto clone = arg.clone();
+    ASSERT_TRUE(clone);
+    value = 4.f;
+    EXPECT_FLOAT_EQ(Any<const float>(clone).get_value(), 2.5f);
+}
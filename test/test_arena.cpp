@@ -0,0 +1,157 @@
+#include <velk/api/velk.h>
+#include <velk/arena.h>
+
+#include <gtest/gtest.h>
+
+using namespace velk;
+
+namespace {
+
+struct Counted
+{
+    static int alive;
+    int value;
+
+    explicit Counted(int v = 0) : value(v) { ++alive; }
+    Counted(const Counted& o) : value(o.value) { ++alive; }
+    Counted(Counted&& o) noexcept : value(o.value) { ++alive; }
+    ~Counted() { --alive; }
+};
+int Counted::alive = 0;
+
+} // namespace
+
+TEST(Arena, ResetReusesBlocks)
+{
+    Arena arena;
+    EXPECT_TRUE(arena.empty());
+    void* first = arena.allocate(64, 8);
+    arena.allocate(Arena::block_size, 8);
+    size_t capacity = arena.capacity();
+    EXPECT_GE(capacity, Arena::block_size + 64);
+
+    arena.reset();
+    EXPECT_EQ(arena.allocate(64, 8), first);
+    arena.allocate(Arena::block_size, 8);
+    EXPECT_EQ(arena.capacity(), capacity);
+}
+
+TEST(Arena, HonorsAlignment)
+{
+    Arena arena;
+    arena.allocate(1, 1);
+    auto* p = arena.allocate(32, alignof(std::max_align_t));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % alignof(std::max_align_t), 0u);
+}
+
+TEST(Arena, ExtendsOnlyTheLatestAllocation)
+{
+    Arena arena;
+    void* a = arena.allocate(16, 8);
+    EXPECT_TRUE(arena.try_extend(a, 16, 64));
+    void* b = arena.allocate(16, 8);
+    EXPECT_EQ(static_cast<char*>(b), static_cast<char*>(a) + 64);
+    EXPECT_FALSE(arena.try_extend(a, 64, 128));
+    EXPECT_FALSE(arena.try_extend(b, 16, 2 * Arena::block_size));
+}
+
+TEST(Arena, ScopeRewinds)
+{
+    Arena arena;
+    arena.allocate(16, 8);
+    void* inner;
+    {
+        ArenaScope scope(&arena);
+        inner = arena.allocate(16, 8);
+        arena.allocate(2 * Arena::block_size, 8);
+    }
+    EXPECT_EQ(arena.allocate(16, 8), inner);
+}
+
+TEST(Arena, FrameArenaIsResetByUpdate)
+{
+    auto* arena = frame_arena();
+    ASSERT_NE(arena, nullptr);
+    instance().update();
+    void* p = arena->allocate(32, 8);
+    instance().update();
+    EXPECT_EQ(arena->allocate(32, 8), p);
+}
+
+TEST(ArenaVector, GrowsInPlace)
+{
+    Arena arena;
+    arena_vector<int> v(&arena);
+    for (int i = 0; i < 100; ++i) {
+        v.push_back(i);
+    }
+    ASSERT_EQ(v.size(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(v[i], i);
+    }
+    // Every growth extended the first buffer, so nothing else was allocated before it.
+    arena.reset();
+    EXPECT_EQ(arena.allocate(sizeof(int), alignof(int)), v.data());
+}
+
+TEST(ArenaVector, DestroysElements)
+{
+    Counted::alive = 0;
+    Arena arena;
+    {
+        arena_vector<Counted> v(&arena);
+        arena_vector<Counted> other(&arena);
+        other.emplace_back(-1);
+        for (int i = 0; i < 20; ++i) {
+            v.emplace_back(i);
+            // Interleaved growth makes v move to new buffers.
+            other.push_back(other.back());
+        }
+        EXPECT_EQ(Counted::alive, 41);
+        EXPECT_EQ(v.back().value, 19);
+        v.pop_back();
+        v.resize(5);
+        EXPECT_EQ(Counted::alive, 26);
+        arena_vector<Counted> moved(std::move(v));
+        EXPECT_TRUE(v.empty());
+        EXPECT_EQ(moved.size(), 5u);
+        EXPECT_EQ(moved[4].value, 4);
+    }
+    EXPECT_EQ(Counted::alive, 0);
+}
+
+TEST(ArenaVector, FallsBackToHeap)
+{
+    arena_vector<int> v(nullptr);
+    EXPECT_EQ(v.arena(), nullptr);
+    for (int i = 0; i < 50; ++i) {
+        v.push_back(i);
+    }
+    auto copy = v.to_vector();
+    ASSERT_EQ(copy.size(), 50u);
+    EXPECT_EQ(copy[49], 49);
+}
+
+TEST(ArenaVector, DefaultsToFrameArena)
+{
+    arena_vector<int> v;
+    EXPECT_EQ(v.arena(), frame_arena());
+}
+
+TEST(ArenaString, Appends)
+{
+    Arena arena;
+    arena_string s(&arena);
+    EXPECT_TRUE(s.empty());
+    EXPECT_STREQ(s.c_str(), "");
+    s += "hello";
+    s += ' ';
+    s.append("arena");
+    EXPECT_EQ(s.size(), 11u);
+    EXPECT_STREQ(s.c_str(), "hello arena");
+    EXPECT_TRUE(s == "hello arena");
+    s.clear();
+    EXPECT_STREQ(s.c_str(), "");
+    s += "x";
+    EXPECT_EQ(s.view(), string_view("x"));
+}
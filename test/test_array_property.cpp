@@ -284,6 +284,185 @@ TEST_F(ArrayPropertyTest, OnChangedFiresOnSetAt)
     EXPECT_EQ(callCount, 1);
 }
 
+// Change descriptors
+
+namespace {
+
+// Compares member by member; vector<T>::operator== would also compare the padding.
+bool same_changes(const vector<ArrayChange>& a, std::initializer_list<ArrayChange> b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    size_t i = 0;
+    for (auto& change : b) {
+        if (a[i].kind != change.kind || a[i].index != change.index || a[i].count != change.count) {
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_F(ArrayPropertyTest, OnChangedDescribesChanges)
+{
+    auto obj = instance().create<IObject>(ArrayWidget::class_id());
+    auto* iw = interface_cast<IArrayWidget>(obj);
+    ASSERT_NE(iw, nullptr);
+
+    auto presets = iw->presets();
+    vector<ArrayChange> changes;
+    Callback handler([&](FnArgs args) -> ReturnValue {
+        changes = get_array_changes(args);
+        return ReturnValue::Success;
+    });
+    presets.add_on_changed(handler);
+
+    presets.push_back(4.f);
+    EXPECT_TRUE(same_changes(changes, {{ArrayChangeKind::Inserted, 3, 1}}));
+    presets.set_at(1, 9.f);
+    EXPECT_TRUE(same_changes(changes, {{ArrayChangeKind::Updated, 1, 1}}));
+    presets.erase_range(0, 2);
+    EXPECT_TRUE(same_changes(changes, {{ArrayChangeKind::Removed, 0, 2}}));
+    presets.resize(5);
+    EXPECT_TRUE(same_changes(changes, {{ArrayChangeKind::Inserted, 2, 3}}));
+    presets.set_value(vector<float>{1.f, 2.f});
+    EXPECT_TRUE(same_changes(changes, {{ArrayChangeKind::Reset, 0, 2}}));
+}
+
+TEST_F(ArrayPropertyTest, DeferredChangesCoalescePerFrame)
+{
+    auto obj = instance().create<IObject>(ArrayWidget::class_id());
+    auto* iw = interface_cast<IArrayWidget>(obj);
+    ASSERT_NE(iw, nullptr);
+
+    auto items = iw->items();
+    int callCount = 0;
+    vector<ArrayChange> changes;
+    Callback handler([&](FnArgs args) -> ReturnValue {
+        callCount++;
+        changes = get_array_changes(args);
+        return ReturnValue::Success;
+    });
+    items.add_on_changed(handler);
+    callCount = 0;
+
+    // Applied and notified once by update().
+    for (int i = 0; i < 10; ++i) {
+        items.push_back(static_cast<float>(i), Deferred);
+    }
+    items.set_at(4, 40.f, Deferred);
+    items.erase_at(0, Deferred);
+    EXPECT_EQ(items.size(), 0u);
+    EXPECT_EQ(callCount, 0);
+
+    instance().update();
+    EXPECT_EQ(callCount, 1);
+    ASSERT_EQ(items.size(), 9u);
+    EXPECT_FLOAT_EQ(items.at(3), 40.f);
+    EXPECT_TRUE(
+        same_changes(changes, {{ArrayChangeKind::Inserted, 0, 10}, {ArrayChangeKind::Removed, 0, 1}}));
+
+    // A deferred whole-value write in the same frame turns the list into a Reset.
+    items.set_at(0, 1.f, Deferred);
+    items.set_value(vector<float>{7.f}, Deferred);
+    instance().update();
+    EXPECT_EQ(callCount, 2);
+    EXPECT_TRUE(same_changes(changes, {{ArrayChangeKind::Reset, 0, 1}}));
+}
+
+TEST_F(ArrayPropertyTest, DeferredOperationsReplayInOrder)
+{
+    auto obj = instance().create<IObject>(ArrayWidget::class_id());
+    auto* iw = interface_cast<IArrayWidget>(obj);
+    ASSERT_NE(iw, nullptr);
+
+    auto items = iw->items();
+    items.set_value({1.f, 2.f, 3.f});
+
+    // The range is copied at the call, so the caller's buffer may change before update().
+    float values[] = {10.f, 11.f};
+    EXPECT_EQ(items.insert_range(1, {values, 2}, Deferred), ReturnValue::Success);
+    values[0] = 0.f;
+    // Out of bounds when applied: skipped.
+    EXPECT_EQ(items.set_at(10, 5.f, Deferred), ReturnValue::Success);
+    EXPECT_EQ(items.erase_at(0, Deferred), ReturnValue::Success);
+    // An immediate write applies the logged operations first.
+    EXPECT_EQ(items.push_back(4.f), ReturnValue::Success);
+    EXPECT_TRUE(items.get_value() == (vector<float>{10.f, 11.f, 2.f, 3.f, 4.f}));
+
+    // A whole-value write drops the operations logged before it, but not those after it.
+    items.set_at(0, 7.f, Deferred);
+    items.set_value({5.f, 6.f}, Deferred);
+    items.push_back(8.f, Deferred);
+    instance().update();
+    EXPECT_TRUE(items.get_value() == (vector<float>{5.f, 6.f, 8.f}));
+}
+
+// Range operations
+
+TEST_F(ArrayPropertyTest, RangeOperationsNotifyOnce)
+{
+    auto obj = instance().create<IObject>(ArrayWidget::class_id());
+    auto* iw = interface_cast<IArrayWidget>(obj);
+    ASSERT_NE(iw, nullptr);
+
+    auto presets = iw->presets();
+    int callCount = 0;
+    Callback handler([&](FnArgs) -> ReturnValue {
+        callCount++;
+        return ReturnValue::Success;
+    });
+    presets.add_on_changed(handler);
+    callCount = 0;
+
+    const float inserted[] = {10.f, 11.f, 12.f, 13.f};
+    EXPECT_EQ(presets.insert_range(1, {inserted, 4}), ReturnValue::Success);
+    EXPECT_EQ(callCount, 1);
+    auto view = presets.view();
+    ASSERT_EQ(view.size(), 7u);
+    EXPECT_FLOAT_EQ(view[0], 1.f);
+    EXPECT_FLOAT_EQ(view[1], 10.f);
+    EXPECT_FLOAT_EQ(view[4], 13.f);
+    EXPECT_FLOAT_EQ(view[5], 2.f);
+
+    const float replaced[] = {20.f, 21.f};
+    EXPECT_EQ(presets.set_range(5, {replaced, 2}), ReturnValue::Success);
+    EXPECT_EQ(presets.set_range(5, {replaced, 2}), ReturnValue::NothingToDo);
+    EXPECT_EQ(callCount, 2);
+    EXPECT_FLOAT_EQ(presets.at(6), 21.f);
+
+    EXPECT_EQ(presets.erase_range(1, 4), ReturnValue::Success);
+    EXPECT_EQ(callCount, 3);
+    EXPECT_EQ(presets.get_value(), (vector<float>{1.f, 20.f, 21.f}));
+
+    EXPECT_EQ(presets.resize(5), ReturnValue::Success);
+    EXPECT_EQ(presets.resize(5), ReturnValue::NothingToDo);
+    EXPECT_EQ(callCount, 4);
+    EXPECT_FLOAT_EQ(presets.at(4), 0.f);
+}
+
+TEST_F(ArrayPropertyTest, RangeOperationsOutOfBounds)
+{
+    auto obj = instance().create<IObject>(ArrayWidget::class_id());
+    auto* iw = interface_cast<IArrayWidget>(obj);
+    ASSERT_NE(iw, nullptr);
+
+    auto presets = iw->presets();
+    const float values[] = {5.f, 6.f};
+    EXPECT_EQ(presets.set_range(2, {values, 2}), ReturnValue::InvalidArgument);
+    EXPECT_EQ(presets.insert_range(4, {values, 2}), ReturnValue::InvalidArgument);
+    EXPECT_EQ(presets.erase_range(1, 3), ReturnValue::InvalidArgument);
+    EXPECT_EQ(presets.size(), 3u);
+
+    auto* ap = interface_cast<IArrayProperty>(presets.get_property_interface());
+    ASSERT_NE(ap, nullptr);
+    EXPECT_EQ(ap->set_range(0, values, 2, type_uid<int>()), ReturnValue::InvalidArgument);
+    EXPECT_EQ(ap->array_data(type_uid<int>()), nullptr);
+}
+
 // MemberKind::ArrayProperty in static metadata
 
 TEST_F(ArrayPropertyTest, StaticMetadataKind)
@@ -33,12 +33,26 @@ public:
     }
 };
 
+// Test interface: array properties
+class ICApiArrays : public velk::Interface<ICApiArrays>
+{
+public:
+    VELK_INTERFACE(
+        (ARR, float, samples, 1.f, 2.f, 3.f),
+        (RARR, int32_t, ids, 7)
+    )
+};
+
+class CApiArrays : public velk::ext::Object<CApiArrays, ICApiArrays>
+{};
+
 class CApi : public ::testing::Test
 {
 protected:
     static void SetUpTestSuite()
     {
         ::velk::register_type<CApiWidget>(::velk::instance());
+        ::velk::register_type<CApiArrays>(::velk::instance());
     }
 };
 
@@ -248,6 +262,158 @@ TEST_F(CApi, PropertyOnChanged)
     velk_release(obj);
 }
 
+// Batched property get/set
+
+struct BatchObserver
+{
+    velk_property other;  // Read by the handler, to check it is written before notifying.
+    float seen = 0.f;
+    int calls = 0;
+};
+
+static void on_batch_changed(void* user_data, velk_property source)
+{
+    (void)source;
+    auto* observer = static_cast<BatchObserver*>(user_data);
+    velk_property_get_float(observer->other, &observer->seen);
+    observer->calls++;
+}
+
+TEST_F(CApi, PropertiesGetSetBatch)
+{
+    auto cpp_uid = CApiWidget::class_id();
+    velk_uid class_id = {cpp_uid.hi, cpp_uid.lo};
+    velk_object a = velk_create(class_id, 0);
+    velk_object b = velk_create(class_id, 0);
+    velk_property props[] = {velk_get_property(a, "width"), velk_get_property(b, "width"),
+                             velk_get_property(a, "count")};
+
+    BatchObserver observer{props[1]};
+    velk_event changed = velk_property_on_changed(props[0]);
+    velk_function handler = velk_create_callback(&on_batch_changed, &observer);
+    velk_event_add(changed, handler);
+
+    struct
+    {
+        float width_a;
+        float width_b;
+        int32_t count;
+    } values{1.f, 2.f, 3};
+    velk_uid types[] = {VELK_TYPE_FLOAT, VELK_TYPE_FLOAT, VELK_TYPE_INT32};
+    size_t sizes[] = {sizeof(float), sizeof(float), sizeof(int32_t)};
+    static_assert(sizeof(values) == sizeof(float) * 2 + sizeof(int32_t), "values must be packed");
+
+    EXPECT_EQ(velk_properties_set(props, types, sizes, &values, 3, nullptr), VELK_SUCCESS);
+    EXPECT_EQ(observer.calls, 1);
+    EXPECT_FLOAT_EQ(observer.seen, 2.f); // Later value already written when the first notifies.
+
+    values = {};
+    EXPECT_EQ(velk_properties_get(props, types, sizes, &values, 3, nullptr), VELK_SUCCESS);
+    EXPECT_FLOAT_EQ(values.width_a, 1.f);
+    EXPECT_FLOAT_EQ(values.width_b, 2.f);
+    EXPECT_EQ(values.count, 3);
+
+    // Unchanged values do not notify.
+    float floats[] = {1.f, 5.f};
+    EXPECT_EQ(velk_properties_set_float(props, floats, 2), VELK_SUCCESS);
+    EXPECT_EQ(observer.calls, 1);
+    floats[0] = floats[1] = 0.f;
+    EXPECT_EQ(velk_properties_get_float(props, floats, 2), VELK_SUCCESS);
+    EXPECT_FLOAT_EQ(floats[0], 1.f);
+    EXPECT_FLOAT_EQ(floats[1], 5.f);
+
+    // A property listed twice takes the later value and notifies once.
+    velk_property twice[] = {props[0], props[1], props[0]};
+    float repeated[] = {6.f, 7.f, 8.f};
+    EXPECT_EQ(velk_properties_set_float(twice, repeated, 3), VELK_SUCCESS);
+    EXPECT_EQ(observer.calls, 2);
+    EXPECT_FLOAT_EQ(observer.seen, 7.f);
+    EXPECT_EQ(velk_properties_get_float(twice, repeated, 1), VELK_SUCCESS);
+    EXPECT_FLOAT_EQ(repeated[0], 8.f);
+
+    velk_release(handler);
+    velk_release(changed);
+    for (auto* prop : props) {
+        velk_release(prop);
+    }
+    velk_release(b);
+    velk_release(a);
+}
+
+TEST_F(CApi, PropertiesBatchReportsEachResult)
+{
+    auto cpp_uid = CApiWidget::class_id();
+    velk_uid class_id = {cpp_uid.hi, cpp_uid.lo};
+    velk_object obj = velk_create(class_id, 0);
+    velk_property props[] = {velk_get_property(obj, "width"), nullptr, velk_get_property(obj, "count")};
+
+    // The mistyped count fails without stopping the others.
+    velk_uid types[] = {VELK_TYPE_FLOAT, VELK_TYPE_FLOAT, VELK_TYPE_FLOAT};
+    float values[] = {7.f, 8.f, 9.f};
+    velk_result results[3] = {};
+    EXPECT_NE(velk_properties_set_float(props, values, 3), VELK_SUCCESS);
+    size_t sizes[] = {sizeof(float), sizeof(float), sizeof(float)};
+    EXPECT_EQ(velk_properties_get(props, types, sizes, values, 3, results), VELK_INVALID_ARG);
+    EXPECT_EQ(results[0], VELK_SUCCESS);
+    EXPECT_EQ(results[1], VELK_INVALID_ARG);
+    EXPECT_LT(results[2], 0);
+    EXPECT_FLOAT_EQ(values[0], 7.f);
+
+    EXPECT_EQ(velk_properties_get(nullptr, types, sizes, values, 3, nullptr), VELK_INVALID_ARG);
+    EXPECT_EQ(velk_properties_set(props, types, sizes, values, 0, nullptr), VELK_SUCCESS);
+
+    velk_release(props[2]);
+    velk_release(props[0]);
+    velk_release(obj);
+}
+
+// Access by member index
+
+TEST_F(CApi, ResolveMemberAndAccessByIndex)
+{
+    auto cpp_uid = CApiWidget::class_id();
+    velk_uid class_id = {cpp_uid.hi, cpp_uid.lo};
+
+    size_t width = velk_resolve_member(class_id, "width");
+    size_t clicked = velk_resolve_member(class_id, "on_clicked");
+    size_t reset = velk_resolve_member(class_id, "reset");
+    ASSERT_NE(width, VELK_NO_MEMBER);
+    ASSERT_NE(clicked, VELK_NO_MEMBER);
+    ASSERT_NE(reset, VELK_NO_MEMBER);
+    EXPECT_EQ(velk_resolve_member(class_id, "missing"), VELK_NO_MEMBER);
+    EXPECT_EQ(velk_resolve_member(class_id, nullptr), VELK_NO_MEMBER);
+    EXPECT_EQ(velk_resolve_member(velk_uid{0, 0}, "width"), VELK_NO_MEMBER);
+
+    velk_object obj = velk_create(class_id, 0);
+    float value = 42.f;
+    EXPECT_EQ(velk_property_set_at(obj, width, &value, sizeof(value), VELK_TYPE_FLOAT), VELK_SUCCESS);
+    value = 0.f;
+    EXPECT_EQ(velk_property_get_at(obj, width, &value, sizeof(value), VELK_TYPE_FLOAT), VELK_SUCCESS);
+    EXPECT_FLOAT_EQ(value, 42.f);
+
+    // The index reaches the same instance as the name.
+    velk_property by_index = velk_property_at(obj, width);
+    velk_property by_name = velk_get_property(obj, "width");
+    EXPECT_EQ(by_index, by_name);
+
+    // Members of another kind, or past the end, are not properties.
+    EXPECT_EQ(velk_property_at(obj, reset), nullptr);
+    EXPECT_EQ(velk_property_get_at(obj, clicked, &value, sizeof(value), VELK_TYPE_FLOAT), VELK_INVALID_ARG);
+    EXPECT_EQ(velk_property_set_at(obj, 1000, &value, sizeof(value), VELK_TYPE_FLOAT), VELK_INVALID_ARG);
+
+    velk_event evt = velk_event_at(obj, clicked);
+    EXPECT_NE(evt, nullptr);
+    velk_function fn = velk_function_at(obj, reset);
+    ASSERT_NE(fn, nullptr);
+    EXPECT_EQ(velk_invoke(fn), VELK_SUCCESS);
+
+    velk_release(fn);
+    velk_release(evt);
+    velk_release(by_name);
+    velk_release(by_index);
+    velk_release(obj);
+}
+
 // Function invocation
 
 TEST_F(CApi, GetFunctionAndInvoke)
@@ -306,6 +472,38 @@ TEST_F(CApi, InvokeWithArgs)
     velk_release(obj);
 }
 
+TEST_F(CApi, InvokeFunctionWithPackedArgs)
+{
+    auto cpp_uid = CApiWidget::class_id();
+    velk_uid class_id = {cpp_uid.hi, cpp_uid.lo};
+
+    velk_object obj = velk_create(class_id, 0);
+    ASSERT_NE(obj, nullptr);
+    velk_function fn = velk_get_function(obj, "add");
+    ASSERT_NE(fn, nullptr);
+
+    velk_arg args[2] = {velk_arg_int32(5), velk_arg_int32(6)};
+    EXPECT_EQ(VELK_SUCCESS, velk_invoke_packed(fn, args, 2));
+
+    auto* iw = velk::interface_cast<ICApiWidget>(reinterpret_cast<velk::IInterface*>(obj));
+    ASSERT_NE(iw, nullptr);
+    EXPECT_EQ(static_cast<CApiWidget*>(iw)->last_add_result, 11);
+
+    velk_arg bad = velk_arg_int32(1);
+    bad.type = 42;
+    EXPECT_EQ(VELK_INVALID_ARG, velk_invoke_packed(fn, &bad, 1));
+    EXPECT_EQ(VELK_INVALID_ARG, velk_invoke_packed(fn, args, VELK_MAX_PACKED_ARGS + 1));
+    EXPECT_EQ(VELK_INVALID_ARG, velk_invoke_packed(nullptr, args, 2));
+
+    velk_function reset = velk_get_function(obj, "reset");
+    EXPECT_EQ(VELK_SUCCESS, velk_invoke_packed(reset, nullptr, 0));
+    EXPECT_EQ(static_cast<CApiWidget*>(iw)->reset_count, 1);
+
+    velk_release(reset);
+    velk_release(fn);
+    velk_release(obj);
+}
+
 TEST_F(CApi, GetFunctionNotFound)
 {
     auto cpp_uid = CApiWidget::class_id();
@@ -320,6 +518,171 @@ TEST_F(CApi, GetFunctionNotFound)
     velk_release(obj);
 }
 
+TEST_F(CApi, LookupByMemberId)
+{
+    auto cpp_uid = CApiWidget::class_id();
+    velk_uid class_id = {cpp_uid.hi, cpp_uid.lo};
+
+    velk_object obj = velk_create(class_id, 0);
+    ASSERT_NE(obj, nullptr);
+
+    velk_member_id width = velk_member_id_of("width");
+    EXPECT_EQ(width, velk::MemberId("width").hash);
+
+    // The same instance as the by-name lookup.
+    velk_property byId = velk_get_property_by_id(obj, width);
+    velk_property byName = velk_get_property(obj, "width");
+    ASSERT_NE(byId, nullptr);
+    EXPECT_EQ(byId, byName);
+
+    velk_event evt = velk_get_event_by_id(obj, velk_member_id_of("on_clicked"));
+    EXPECT_NE(evt, nullptr);
+    velk_function fn = velk_get_function_by_id(obj, velk_member_id_of("reset"));
+    ASSERT_NE(fn, nullptr);
+    EXPECT_GE(velk_invoke(fn), 0);
+
+    // The kind is part of the lookup.
+    EXPECT_EQ(velk_get_event_by_id(obj, width), nullptr);
+    EXPECT_EQ(velk_get_function_by_id(obj, velk_member_id_of("nonexistent")), nullptr);
+
+    velk_release(fn);
+    velk_release(evt);
+    velk_release(byName);
+    velk_release(byId);
+    velk_release(obj);
+}
+
+// Array property access
+
+TEST_F(CApi, ArrayPropertyLockReadAndWrite)
+{
+    auto cpp_uid = CApiArrays::class_id();
+    velk_object obj = velk_create({cpp_uid.hi, cpp_uid.lo}, 0);
+    ASSERT_NE(obj, nullptr);
+    velk_property samples = velk_get_property(obj, "samples");
+    ASSERT_NE(samples, nullptr);
+
+    int changed = 0;
+    velk_function cb = velk_create_callback(
+        [](void* ud, velk_property) { ++*static_cast<int*>(ud); }, &changed);
+    velk_event evt = velk_property_on_changed(samples);
+    velk_event_add(evt, cb);
+
+    velk_array_view view{};
+    ASSERT_EQ(VELK_SUCCESS, velk_array_property_lock_read(samples, VELK_TYPE_FLOAT, &view));
+    EXPECT_EQ(view.element_size, sizeof(float));
+    ASSERT_EQ(view.count, size_t(3));
+    EXPECT_FLOAT_EQ(static_cast<float*>(view.data)[2], 3.f);
+    velk_array_property_unlock_read(samples);
+
+    ASSERT_EQ(VELK_SUCCESS, velk_array_property_lock_write(samples, VELK_TYPE_FLOAT, &view));
+    auto* values = static_cast<float*>(view.data);
+    for (size_t i = 0; i < view.count; ++i) {
+        values[i] *= 10.f;
+    }
+    EXPECT_EQ(changed, 0);
+    EXPECT_EQ(VELK_SUCCESS, velk_array_property_unlock_write(samples));
+    EXPECT_EQ(changed, 1);
+
+    auto* iw = velk::interface_cast<ICApiArrays>(reinterpret_cast<velk::IInterface*>(obj));
+    ASSERT_NE(iw, nullptr);
+    EXPECT_FLOAT_EQ(iw->samples().at(1), 20.f);
+
+    EXPECT_EQ(VELK_INVALID_ARG, velk_array_property_lock_read(samples, VELK_TYPE_INT32, &view));
+    velk_property ids = velk_get_property(obj, "ids");
+    EXPECT_EQ(VELK_SUCCESS, velk_array_property_lock_read(ids, VELK_TYPE_INT32, &view));
+    velk_array_property_unlock_read(ids);
+    EXPECT_EQ(VELK_READ_ONLY, velk_array_property_lock_write(ids, VELK_TYPE_INT32, &view));
+    EXPECT_EQ(VELK_INVALID_ARG, velk_array_property_lock_read(nullptr, VELK_TYPE_FLOAT, &view));
+
+    velk_release(ids);
+    velk_release(evt);
+    velk_release(cb);
+    velk_release(samples);
+    velk_release(obj);
+}
+
+// Hives
+
+TEST_F(CApi, HiveAddRemoveAndStateIteration)
+{
+    auto cpp_uid = CApiWidget::class_id();
+    velk_uid class_id = {cpp_uid.hi, cpp_uid.lo};
+
+    velk_hive_store store = velk_hive_store_create();
+    ASSERT_NE(store, nullptr);
+    EXPECT_EQ(velk_hive_find(store, class_id), nullptr);
+
+    velk_hive hive = velk_hive_get(store, class_id);
+    ASSERT_NE(hive, nullptr);
+    velk_hive found = velk_hive_find(store, class_id);
+    EXPECT_EQ(found, hive);
+
+    velk_object objs[3];
+    for (auto& obj : objs) {
+        obj = velk_hive_add(hive);
+        ASSERT_NE(obj, nullptr);
+    }
+    EXPECT_EQ(velk_hive_size(hive), size_t(3));
+
+    velk_uid intf = {};
+    size_t width = velk_state_field_offset(class_id, "width", &intf);
+    ASSERT_NE(width, VELK_NO_FIELD);
+    EXPECT_EQ(intf.hi, ICApiWidget::UID.hi);
+    EXPECT_EQ(intf.lo, ICApiWidget::UID.lo);
+    EXPECT_EQ(width, offsetof(ICApiWidget::State, width));
+    EXPECT_EQ(velk_state_field_offset(class_id, "count", nullptr), offsetof(ICApiWidget::State, count));
+    EXPECT_EQ(velk_state_field_offset(class_id, "reset", nullptr), VELK_NO_FIELD);
+    EXPECT_EQ(velk_state_field_offset(class_id, "nonexistent", nullptr), VELK_NO_FIELD);
+
+    struct Ctx
+    {
+        size_t offset;
+        int visited;
+    } ctx{width, 0};
+    auto scale = [](void* user_data, velk_object, void* state) -> int32_t {
+        auto& c = *static_cast<Ctx*>(user_data);
+        *reinterpret_cast<float*>(static_cast<char*>(state) + c.offset) *= 2.f;
+        c.visited++;
+        return 1;
+    };
+    EXPECT_EQ(VELK_SUCCESS, velk_hive_for_each_state(hive, intf, scale, &ctx));
+    EXPECT_EQ(ctx.visited, 3);
+
+    velk_property p = velk_get_property(objs[1], "width");
+    float w = 0.f;
+    EXPECT_EQ(VELK_SUCCESS, velk_property_get_float(p, &w));
+    EXPECT_FLOAT_EQ(w, 200.f);
+    velk_release(p);
+
+    // Returning 0 stops the iteration.
+    ctx.visited = 0;
+    auto stop = [](void* user_data, velk_object, void*) -> int32_t {
+        static_cast<Ctx*>(user_data)->visited++;
+        return 0;
+    };
+    EXPECT_EQ(VELK_SUCCESS, velk_hive_for_each_state(hive, intf, stop, &ctx));
+    EXPECT_EQ(ctx.visited, 1);
+    EXPECT_EQ(VELK_INVALID_ARG, velk_hive_for_each_state(hive, class_id, stop, &ctx));
+
+    EXPECT_EQ(VELK_SUCCESS, velk_hive_remove(hive, objs[0]));
+    EXPECT_EQ(VELK_FAIL, velk_hive_remove(hive, objs[0]));
+    EXPECT_EQ(velk_hive_size(hive), size_t(2));
+
+    // An empty hive still rejects an interface its objects have no State for.
+    EXPECT_EQ(VELK_SUCCESS, velk_hive_remove(hive, objs[1]));
+    EXPECT_EQ(VELK_SUCCESS, velk_hive_remove(hive, objs[2]));
+    EXPECT_EQ(VELK_NOTHING_TO_DO, velk_hive_for_each_state(hive, intf, stop, &ctx));
+    EXPECT_EQ(VELK_INVALID_ARG, velk_hive_for_each_state(hive, class_id, stop, &ctx));
+
+    for (auto& obj : objs) {
+        velk_release(obj);
+    }
+    velk_release(found);
+    velk_release(hive);
+    velk_release(store);
+}
+
 // Update loop (smoke test)
 
 TEST_F(CApi, UpdateDoesNotCrash)
@@ -328,6 +691,16 @@ TEST_F(CApi, UpdateDoesNotCrash)
     velk_update(16000); // 16ms
 }
 
+TEST_F(CApi, TraceRecordingWritesFile)
+{
+    velk_trace_start(0);
+    velk_update(0);
+    velk_trace_stop();
+    auto path = ::testing::TempDir() + "velk_c_trace.json";
+    EXPECT_EQ(VELK_SUCCESS, velk_trace_write(path.c_str()));
+    EXPECT_EQ(VELK_FAIL, velk_trace_write(nullptr));
+}
+
 // Null safety
 
 TEST_F(CApi, NullHandlesReturnGracefully)
@@ -339,6 +712,8 @@ TEST_F(CApi, NullHandlesReturnGracefully)
     EXPECT_EQ(velk_get_property(nullptr, "x"), nullptr);
     EXPECT_EQ(velk_get_event(nullptr, "x"), nullptr);
     EXPECT_EQ(velk_get_function(nullptr, "x"), nullptr);
+    EXPECT_EQ(velk_member_id_of(nullptr), velk_member_id(0));
+    EXPECT_EQ(velk_get_property_by_id(nullptr, velk_member_id_of("x")), nullptr);
     EXPECT_EQ(velk_property_on_changed(nullptr), nullptr);
     EXPECT_EQ(velk_invoke(nullptr), VELK_INVALID_ARG);
 
@@ -0,0 +1,160 @@
+#include <velk/api/any.h>
+#include <velk/api/coroutine.h>
+#include <velk/api/future.h>
+#include <velk/api/velk.h>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <thread>
+
+using namespace velk;
+
+namespace {
+
+/** @brief Minimal eager, fire-and-forget coroutine type for driving FutureAwaiter. */
+struct Task
+{
+    struct promise_type
+    {
+        Task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/** @brief What a coroutine saw when it resumed after co_await. */
+struct Resumed
+{
+    std::atomic<bool> done{false};
+    std::thread::id thread;
+    bool valid{false};
+    int value{0};
+};
+
+Task await_int(Future<int> future, Resumed& out)
+{
+    auto result = co_await future;
+    out.thread = std::this_thread::get_id();
+    out.valid = static_cast<bool>(result);
+    out.value = result ? result.get_value() : 0;
+    out.done.store(true, std::memory_order_release);
+}
+
+Task await_int_on(Future<int> future, InvokeType type, Resumed& out)
+{
+    auto result = co_await resume_on(future, type);
+    out.thread = std::this_thread::get_id();
+    out.valid = static_cast<bool>(result);
+    out.value = result ? result.get_value() : 0;
+    out.done.store(true, std::memory_order_release);
+}
+
+Task await_void(Future<void> future, Resumed& out)
+{
+    co_await future;
+    out.thread = std::this_thread::get_id();
+    out.done.store(true, std::memory_order_release);
+}
+
+bool wait_done(const Resumed& r)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!r.done.load(std::memory_order_acquire)) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(Coroutine, ReadyFutureResumesWithoutSuspending)
+{
+    auto promise = make_promise();
+    auto future = promise.get_future<int>();
+    promise.set_value(42);
+
+    Resumed r;
+    await_int(future, r);
+    ASSERT_TRUE(r.done);
+    EXPECT_TRUE(r.valid);
+    EXPECT_EQ(r.value, 42);
+    EXPECT_EQ(r.thread, std::this_thread::get_id());
+}
+
+TEST(Coroutine, ImmediateResumesWhereFutureIsResolved)
+{
+    auto promise = make_promise();
+    Resumed r;
+    await_int(promise.get_future<int>(), r);
+    EXPECT_FALSE(r.done);
+
+    promise.set_value(7);
+    ASSERT_TRUE(r.done);
+    EXPECT_EQ(r.value, 7);
+    EXPECT_EQ(r.thread, std::this_thread::get_id());
+}
+
+TEST(Coroutine, VoidFutureResumes)
+{
+    auto promise = make_promise();
+    Resumed r;
+    await_void(promise.get_future<void>(), r);
+    EXPECT_FALSE(r.done);
+
+    promise.complete();
+    EXPECT_TRUE(r.done);
+}
+
+TEST(Coroutine, DeferredResumesOnUpdate)
+{
+    auto promise = make_promise();
+    auto future = promise.get_future<int>();
+    promise.set_value(3);
+
+    // Deferred suspends even on a ready future.
+    Resumed r;
+    await_int_on(future, Deferred, r);
+    EXPECT_FALSE(r.done);
+
+    instance().update();
+    ASSERT_TRUE(r.done);
+    EXPECT_TRUE(r.valid);
+    EXPECT_EQ(r.value, 3);
+    EXPECT_EQ(r.thread, std::this_thread::get_id());
+}
+
+TEST(Coroutine, PoolResumesOnWorker)
+{
+    auto promise = make_promise();
+    Resumed r;
+    await_int_on(promise.get_future<int>(), Pool, r);
+    EXPECT_FALSE(r.done);
+
+    promise.set_value(5);
+    ASSERT_TRUE(wait_done(r));
+    EXPECT_TRUE(r.valid);
+    EXPECT_EQ(r.value, 5);
+    EXPECT_NE(r.thread, std::this_thread::get_id());
+}
+
+TEST(Coroutine, CancelledFutureResumesWithoutResult)
+{
+    auto promise = make_promise();
+    auto future = promise.get_future<int>();
+    Resumed r;
+    await_int(future, r);
+    EXPECT_FALSE(r.done);
+
+    EXPECT_EQ(future.cancel(), ReturnValue::Success);
+    ASSERT_TRUE(r.done);
+    EXPECT_FALSE(r.valid);
+    EXPECT_TRUE(promise.is_cancelled());
+}
@@ -4,11 +4,18 @@
 #include <velk/api/function.h>
 #include <velk/api/function_context.h>
 #include <velk/api/velk.h>
+#include <velk/ext/event.h>
 #include <velk/interface/intf_event.h>
 #include <velk/interface/intf_function.h>
 #include <velk/interface/types.h>
+#include <velk/string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <gtest/gtest.h>
+#include <thread>
+#include <vector>
 
 using namespace velk;
 
@@ -108,6 +115,23 @@ TEST(InvokeFunction, VariadicWithValues)
     EXPECT_EQ(varB, 20);
 }
 
+TEST(InvokeFunction, DeferredValueArgsAreCloned)
+{
+    string received;
+    Callback fn([&](FnArgs args) -> ReturnValue {
+        received = Any<const string>(args[0]).get_value();
+        return ReturnValue::Success;
+    });
+
+    string value("queued");
+    ext::AnyArg<string> arg(value);
+    const IAny* args[] = {&arg};
+    fn.invoke({args, 1}, Deferred);
+    value = "changed";
+    instance().update();
+    EXPECT_EQ(received, "queued");
+}
+
 // --- invoke_function variadic with IAny* pointers ---
 
 TEST(InvokeFunction, VariadicWithAnyPointers)
@@ -343,6 +367,172 @@ TEST(Event, HandlerAddRemove)
     EXPECT_EQ(callCount, 1); // no longer called
 }
 
+TEST(Event, HandlerOrderAcrossListSizes)
+{
+    auto event = instance().create<IEvent>(ClassId::Event);
+    ASSERT_TRUE(event);
+
+    std::vector<int> order;
+    auto make = [&](int id) { return Callback([&order, id]() { order.push_back(id); }); };
+    std::vector<Callback> handlers;
+    for (int i = 0; i < 4; ++i) {
+        handlers.push_back(make(i));
+    }
+
+    // Grow from an empty list past the handlers stored inline, and shrink back.
+    std::vector<int> expected;
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(ReturnValue::Success, event->add_handler(handlers[i]));
+        EXPECT_EQ(ReturnValue::NothingToDo, event->add_handler(handlers[i]));
+        expected.push_back(i);
+        order.clear();
+        event->invoke({});
+        EXPECT_EQ(expected, order);
+    }
+    for (int i : {1, 3, 0}) {
+        EXPECT_EQ(ReturnValue::Success, event->remove_handler(handlers[i]));
+        EXPECT_EQ(ReturnValue::NothingToDo, event->remove_handler(handlers[i]));
+        expected.erase(std::find(expected.begin(), expected.end(), i));
+        order.clear();
+        event->invoke({});
+        EXPECT_EQ(expected, order);
+    }
+    EXPECT_TRUE(event->has_handlers());
+    EXPECT_EQ(ReturnValue::Success, event->remove_handler(handlers[2]));
+    EXPECT_FALSE(event->has_handlers());
+}
+
+TEST(Event, HandlerRemovingItselfDuringDispatch)
+{
+    auto event = instance().create<IEvent>(ClassId::Event);
+    ASSERT_TRUE(event);
+
+    int first = 0;
+    int second = 0;
+    IFunction::Ptr self;
+    {
+        Callback handler([&](FnArgs) -> ReturnValue {
+            ++first;
+            // Drops the last external reference too; the dispatch keeps the handler alive.
+            event->remove_handler(self);
+            self.reset();
+            return ReturnValue::Success;
+        });
+        self = handler;
+        event->add_handler(self);
+    }
+    Callback other([&](FnArgs) -> ReturnValue {
+        ++second;
+        return ReturnValue::Success;
+    });
+    event->add_handler(other);
+
+    event->invoke({});
+    event->invoke({});
+    EXPECT_EQ(1, first);
+    EXPECT_EQ(2, second);
+}
+
+TEST(Event, ConcurrentInvokeAndSubscribe)
+{
+    auto event = instance().create<IEvent>(ClassId::Event);
+    ASSERT_TRUE(event);
+
+    std::atomic<int> calls{0};
+    Callback counter([&](FnArgs) -> ReturnValue {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        return ReturnValue::Success;
+    });
+    event->add_handler(counter);
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> firing;
+    for (int t = 0; t < 4; ++t) {
+        firing.emplace_back([&] {
+            while (!done.load()) {
+                event->invoke({});
+            }
+        });
+    }
+    // Subscribe and unsubscribe while the other threads fire the event.
+    for (int i = 0; i < 2000; ++i) {
+        Callback transient([](FnArgs) -> ReturnValue { return ReturnValue::Success; });
+        EXPECT_EQ(ReturnValue::Success, event->add_handler(transient));
+        EXPECT_EQ(ReturnValue::Success, event->remove_handler(transient));
+    }
+    done.store(true);
+    for (auto& t : firing) {
+        t.join();
+    }
+    EXPECT_TRUE(event->has_handlers());
+    int before = calls.load();
+    event->invoke({});
+    EXPECT_EQ(before + 1, calls.load());
+}
+
+TEST(Event, ReplacedListStaysValidForDispatchOnOtherThread)
+{
+    auto event = instance().create<IEvent>(ClassId::Event);
+    ASSERT_TRUE(event);
+
+    std::atomic<bool> entered{false};
+    std::atomic<bool> replaced{false};
+    std::atomic<int> later{0};
+    Callback blocking([&](FnArgs) -> ReturnValue {
+        if (!entered.exchange(true)) {
+            while (!replaced.load()) {
+                std::this_thread::yield();
+            }
+        }
+        return ReturnValue::Success;
+    });
+    IFunction::Ptr removed = Callback([&](FnArgs) -> ReturnValue {
+        later.fetch_add(1);
+        return ReturnValue::Success;
+    });
+    event->add_handler(blocking);
+    event->add_handler(removed);
+
+    std::thread reader([&] { event->invoke({}); });
+    while (!entered.load()) {
+        std::this_thread::yield();
+    }
+    // The reader holds the list with both handlers; replace it a few times meanwhile.
+    event->remove_handler(removed);
+    removed.reset();
+    for (int i = 0; i < 4; ++i) {
+        Callback transient([](FnArgs) -> ReturnValue { return ReturnValue::Success; });
+        event->add_handler(transient);
+        event->remove_handler(transient);
+    }
+    replaced.store(true);
+    reader.join();
+    EXPECT_EQ(1, later.load());
+
+    event->invoke({});
+    EXPECT_EQ(1, later.load());
+}
+
+TEST(Event, ReaderRecordsOfExitedThreadsAreReused)
+{
+    auto event = instance().create<IEvent>(ClassId::Event);
+    ASSERT_TRUE(event);
+
+    std::atomic<int> calls{0};
+    Callback counter([&](FnArgs) -> ReturnValue {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        return ReturnValue::Success;
+    });
+    event->add_handler(counter);
+
+    // More threads than there are reader records; each hands its record back on exit.
+    constexpr int threadCount = 1500;
+    for (int i = 0; i < threadCount; ++i) {
+        std::thread([&] { event->invoke({}); }).join();
+    }
+    EXPECT_EQ(threadCount, calls.load());
+}
+
 TEST(Event, AddHandlerWithLambdaHelper)
 {
     int callCount = 0;
@@ -399,6 +589,16 @@ TEST(Event, AddHandlerWithZeroArityLambdaHelper)
     EXPECT_TRUE(called);
 }
 
+TEST(Callback, InvokeIntoCopiesCallbackResult)
+{
+    Callback fn([](const int& x) -> int { return x * 2; });
+    Any<int> arg(21);
+    const IAny* args[] = {arg};
+    Any<int> result;
+    EXPECT_EQ(ReturnValue::Success, fn.invoke_into({args, 1}, *result.get_any_interface()));
+    EXPECT_EQ(42, result.get_value());
+}
+
 // --- Deferred invocation ---
 
 TEST(Callback, DeferredInvocationQueuesAndExecutesOnUpdate)
@@ -416,3 +616,377 @@ TEST(Callback, DeferredInvocationQueuesAndExecutesOnUpdate)
     instance().update();
     EXPECT_EQ(callCount, 1); // Now called
 }
+
+TEST(Callback, CoalescedInvocationRunsLatestOncePerUpdate)
+{
+    std::vector<int> received;
+    Callback fn([&](const int& value) { received.push_back(value); });
+
+    for (int i = 1; i <= 3; ++i) {
+        Any<int> value(i);
+        const IAny* args[] = {value};
+        fn.invoke({args, 1}, DeferredCoalesced);
+    }
+    // Plain deferred invocations of the same function still run every time.
+    Any<int> plain(7);
+    const IAny* plainArgs[] = {plain};
+    fn.invoke({plainArgs, 1}, Deferred);
+    EXPECT_TRUE(received.empty());
+
+    // The coalesced call runs where it was first queued, with the latest args.
+    instance().update();
+    EXPECT_EQ((std::vector<int>{3, 7}), received);
+
+    received.clear();
+    Any<int> next(4);
+    const IAny* nextArgs[] = {next};
+    fn.invoke({nextArgs, 1}, DeferredCoalesced);
+    instance().update();
+    EXPECT_EQ((std::vector<int>{4}), received);
+}
+
+TEST(Callback, OnceInvocationRunsFirstOncePerUpdate)
+{
+    std::vector<int> received;
+    Callback fn([&](const int& value) { received.push_back(value); });
+    IFunction::ConstPtr target = fn;
+
+    for (int i = 1; i <= 3; ++i) {
+        Any<int> value(i);
+        const IAny* args[] = {value};
+        fn.invoke({args, 1}, DeferredOnce);
+        instance().queue_deferred_call(target, {args, 1}, DeferredOnce);
+    }
+    EXPECT_TRUE(received.empty());
+
+    // Only the first request runs, with its own args.
+    instance().update();
+    EXPECT_EQ((std::vector<int>{1}), received);
+
+    // Once it has run, the function can be queued again.
+    received.clear();
+    Any<int> next(4);
+    const IAny* nextArgs[] = {next};
+    fn.invoke({nextArgs, 1}, DeferredOnce);
+    fn.invoke({nextArgs, 1}, DeferredOnce);
+    instance().update();
+    EXPECT_EQ((std::vector<int>{4}), received);
+    instance().update();
+    EXPECT_EQ((std::vector<int>{4}), received);
+}
+
+TEST(Callback, OnceInvocationRequeuedFromItselfRunsNextUpdate)
+{
+    int calls = 0;
+    IFunction::ConstPtr self;
+    Callback fn([&](FnArgs) -> ReturnValue {
+        if (++calls == 1) {
+            self->invoke({}, DeferredOnce);
+        }
+        return ReturnValue::Success;
+    });
+    self = fn;
+
+    fn.invoke({}, DeferredOnce);
+    instance().update();
+    EXPECT_EQ(1, calls);
+    instance().update();
+    EXPECT_EQ(2, calls);
+}
+
+TEST(Callback, QueuedDeferredCallsCloneArgsAndCoalesce)
+{
+    std::vector<int> received;
+    Callback fn([&](const int& value) { received.push_back(value); });
+    IFunction::ConstPtr target = fn;
+
+    {
+        Any<int> first(1);
+        const IAny* args[] = {first};
+        instance().queue_deferred_call(target, {args, 1});
+    }
+    // A coalesced call replaces the args of a coalesced task queued through either entry point.
+    for (int i = 2; i <= 3; ++i) {
+        Any<int> value(i);
+        const IAny* args[] = {value};
+        DeferredTask task;
+        task.fn = target;
+        task.args = ::velk::make_shared<DeferredArgs>(FnArgs{args, 1});
+        task.coalesce = true;
+        instance().queue_deferred_tasks({&task, 1});
+        Any<int> later(i * 10);
+        const IAny* laterArgs[] = {later};
+        instance().queue_deferred_call(target, {laterArgs, 1}, DeferredCoalesced);
+    }
+    EXPECT_TRUE(received.empty());
+
+    instance().update();
+    EXPECT_EQ((std::vector<int>{1, 30}), received);
+}
+
+TEST(Callback, DeferredTasksFromManyThreadsKeepPerThreadOrder)
+{
+    constexpr int threadCount = 8;
+    constexpr int perThread = 500;
+    std::vector<int> received[threadCount];
+    Callback fn([&](const int& thread, const int& seq) { received[thread].push_back(seq); });
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threadCount; ++t) {
+        producers.emplace_back([&fn, t] {
+            for (int i = 0; i < perThread; ++i) {
+                Any<int> thread(t);
+                Any<int> seq(i);
+                const IAny* args[] = {thread, seq};
+                fn.invoke({args, 2}, Deferred);
+            }
+        });
+    }
+    for (auto& p : producers) {
+        p.join();
+    }
+
+    instance().update();
+    for (auto& seqs : received) {
+        ASSERT_EQ(static_cast<size_t>(perThread), seqs.size());
+        EXPECT_TRUE(std::is_sorted(seqs.begin(), seqs.end()));
+    }
+}
+
+TEST(Callback, DeferredLanesRunInPriorityOrder)
+{
+    std::vector<int> order;
+    Callback fn([&](const int& value) { order.push_back(value); });
+    auto queue = [&](int value, InvokeType type) {
+        Any<int> v(value);
+        const IAny* args[] = {v};
+        fn.invoke({args, 1}, type);
+    };
+    queue(1, Deferred | BackgroundPriority);
+    queue(2, Deferred);
+    queue(3, Deferred | HighPriority);
+    queue(4, Deferred | BackgroundPriority);
+    queue(5, Deferred | HighPriority);
+    queue(6, Deferred | NormalPriority);
+
+    instance().update();
+    EXPECT_EQ((std::vector<int>{3, 5, 2, 6, 1, 4}), order);
+}
+
+TEST(Callback, BudgetedUpdateCarriesOverRemainingTasks)
+{
+    std::vector<int> order;
+    Callback slow([&](const int& seq) {
+        order.push_back(seq);
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(200);
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    });
+    constexpr int count = 64;
+    for (int i = 0; i < count; ++i) {
+        Any<int> seq(i);
+        const IAny* args[] = {seq};
+        slow.invoke({args, 1}, Deferred);
+    }
+
+    instance().update({}, Duration{1000});
+    size_t first = order.size();
+    EXPECT_GE(first, 1u);
+    EXPECT_LT(first, static_cast<size_t>(count));
+
+    // Work queued after the carry-over runs after it.
+    Any<int> last(count);
+    const IAny* lastArgs[] = {last};
+    slow.invoke({lastArgs, 1}, Deferred);
+    instance().update();
+    ASSERT_EQ(static_cast<size_t>(count + 1), order.size());
+    for (int i = 0; i <= count; ++i) {
+        EXPECT_EQ(i, order[i]);
+    }
+}
+
+// Executor that runs each task on its own std::thread.
+class DeferredThreadExecutor : public ext::ObjectCore<DeferredThreadExecutor, IExecutor>
+{
+public:
+    size_t get_concurrency() const override { return 2; }
+    void parallel_for(size_t count, void* context, TaskFn task) override
+    {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([=] { task(context, i); });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        ++calls;
+    }
+    size_t calls{};
+};
+
+TEST(Callback, KeyedDeferredTasksRunOnExecutorInKeyOrder)
+{
+    auto executor = ext::make_object<DeferredThreadExecutor, IExecutor>();
+    instance().set_executor(executor);
+
+    constexpr int keyCount = 6;
+    constexpr int perKey = 200;
+    std::vector<int> received[keyCount];
+    std::atomic<int> unkeyedSeenByKeyed{0};
+    int unkeyed = 0;
+    Callback keyedFn([&](const int& key, const int& seq) {
+        received[key].push_back(seq);
+        unkeyedSeenByKeyed += unkeyed;
+    });
+    Callback unkeyedFn([&](FnArgs) -> ReturnValue {
+        ++unkeyed;
+        return ReturnValue::Success;
+    });
+
+    for (int i = 0; i < perKey; ++i) {
+        for (int key = 0; key < keyCount; ++key) {
+            Any<int> k(key);
+            Any<int> seq(i);
+            const IAny* args[] = {k, seq};
+            queue_deferred_task(keyedFn, {args, 2}, key + 1);
+        }
+    }
+    unkeyedFn.invoke({}, Deferred);
+
+    instance().update();
+    instance().set_executor({});
+
+    EXPECT_EQ(1u, static_cast<DeferredThreadExecutor*>(executor.get())->calls);
+    // Keyed tasks run after the unkeyed ones, and every key keeps its queue order.
+    EXPECT_EQ(keyCount * perKey, unkeyedSeenByKeyed.load());
+    for (auto& seqs : received) {
+        ASSERT_EQ(static_cast<size_t>(perKey), seqs.size());
+        EXPECT_TRUE(std::is_sorted(seqs.begin(), seqs.end()));
+    }
+}
+
+TEST(Event, DeferredHandlersFanOutOnUpdate)
+{
+    auto event = instance().create<IEvent>(ClassId::Event);
+    ASSERT_TRUE(event);
+
+    std::vector<int> received;
+    int removedCalls = 0;
+    Callback first([&](const int& value) { received.push_back(value); });
+    Callback second([&](const int& value) { received.push_back(value * 10); });
+    Callback removed([&](const int&) { ++removedCalls; });
+    event->add_handler(first, Deferred);
+    event->add_handler(second, Deferred);
+    event->add_handler(removed, Deferred);
+
+    {
+        // The args are cloned, so they do not need to outlive the invocation.
+        Any<int> one(1);
+        Any<int> two(2);
+        invoke_event(event, one);
+        invoke_event(event, two);
+    }
+    EXPECT_TRUE(received.empty());
+
+    // Handlers are looked up when update() runs the queued records.
+    event->remove_handler(removed);
+    instance().update();
+    EXPECT_EQ((std::vector<int>{1, 10, 2, 20}), received);
+    EXPECT_EQ(0, removedCalls);
+
+    received.clear();
+    instance().update();
+    EXPECT_TRUE(received.empty());
+}
+
+TEST(Event, CoalescedHandlersRunOncePerUpdate)
+{
+    auto event = instance().create<IEvent>(ClassId::Event);
+    ASSERT_TRUE(event);
+
+    std::vector<int> deferred;
+    std::vector<int> coalesced;
+    Callback deferredHandler([&](const int& value) { deferred.push_back(value); });
+    Callback coalescedHandler([&](const int& value) { coalesced.push_back(value); });
+    event->add_handler(coalescedHandler, DeferredCoalesced);
+    event->add_handler(deferredHandler, Deferred);
+
+    for (int i = 1; i <= 3; ++i) {
+        invoke_event(event, Any<int>(i));
+    }
+    instance().update();
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), deferred);
+    EXPECT_EQ((std::vector<int>{3}), coalesced);
+
+    // Removing the deferred handler leaves the coalesced partition intact.
+    deferred.clear();
+    coalesced.clear();
+    event->remove_handler(deferredHandler);
+    invoke_event(event, Any<int>(5));
+    invoke_event(event, Any<int>(6));
+    instance().update();
+    EXPECT_TRUE(deferred.empty());
+    EXPECT_EQ((std::vector<int>{6}), coalesced);
+}
+
+namespace {
+
+class RecordingBatchHandler : public ext::EventBatchHandler<RecordingBatchHandler>
+{
+public:
+    void handle_batch(array_view<EventBatchEntry> batch) const override
+    {
+        ++calls;
+        for (auto& entry : batch) {
+            Any<const int> value(entry.args[0]);
+            received.push_back({entry.source, value ? value.get_value() : -1});
+        }
+    }
+
+    mutable int calls{};
+    mutable std::vector<std::pair<const IEvent*, int>> received;
+};
+
+} // namespace
+
+TEST(Event, BatchHandlerReceivesAllInvocationsOncePerUpdate)
+{
+    auto first = instance().create<IEvent>(ClassId::Event);
+    auto second = instance().create<IEvent>(ClassId::Event);
+    auto coalesced = instance().create<IEvent>(ClassId::Event);
+    ASSERT_TRUE(first && second && coalesced);
+
+    auto handler = ext::make_object<RecordingBatchHandler, IEventBatchHandler>();
+    auto* recorder = static_cast<const RecordingBatchHandler*>(handler.get());
+    int plainCalls = 0;
+    Callback plain([&](const int&) { ++plainCalls; });
+    first->add_handler(handler, Deferred);
+    first->add_handler(plain, Deferred);
+    second->add_handler(handler, Deferred);
+    coalesced->add_handler(handler, DeferredCoalesced);
+
+    invoke_event(first, Any<int>(1));
+    invoke_event(coalesced, Any<int>(2));
+    invoke_event(second, Any<int>(3));
+    invoke_event(coalesced, Any<int>(4));
+    invoke_event(first, Any<int>(5));
+    EXPECT_EQ(0, recorder->calls);
+
+    instance().update();
+    EXPECT_EQ(1, recorder->calls);
+    EXPECT_EQ(2, plainCalls);
+    // The coalesced event appears once, at its first position, with its latest args.
+    std::vector<std::pair<const IEvent*, int>> expected{
+        {first.get(), 1}, {coalesced.get(), 4}, {second.get(), 3}, {first.get(), 5}};
+    EXPECT_EQ(expected, recorder->received);
+
+    instance().update();
+    EXPECT_EQ(1, recorder->calls);
+
+    // Invoking the handler directly delivers a batch of one without a source.
+    Any<int> direct(6);
+    invoke_function(handler, direct);
+    EXPECT_EQ(2, recorder->calls);
+    EXPECT_EQ(nullptr, recorder->received.back().first);
+    EXPECT_EQ(6, recorder->received.back().second);
+}
@@ -6,7 +6,9 @@
 #include <velk/interface/types.h>
 
 #include <gtest/gtest.h>
+#include <atomic>
 #include <thread>
+#include <vector>
 
 using namespace velk;
 
@@ -217,8 +219,51 @@ TEST(Future, MultipleContinuations)
     EXPECT_EQ(count, 3);
 }
 
+TEST(Future, ContinuationsFireInOrderAdded)
+{
+    auto promise = make_promise();
+    auto future = promise.get_future<int>();
+
+    std::vector<int> order;
+    for (int i = 0; i < 5; i++) {
+        future.then([&order, i](FnArgs) -> ReturnValue {
+            order.push_back(i);
+            return ReturnValue::Success;
+        });
+    }
+
+    promise.set_value(1);
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3, 4}));
+}
+
 // --- Thread safety ---
 
+TEST(Future, ContinuationsRaceWithSetValue)
+{
+    constexpr int ROUNDS = 200;
+    constexpr int CONTINUATIONS = 50;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto promise = make_promise();
+        auto future = promise.get_future<int>();
+        std::atomic<int> fired{0};
+
+        std::thread adder([&] {
+            for (int i = 0; i < CONTINUATIONS; i++) {
+                future.then([&](FnArgs) -> ReturnValue {
+                    fired++;
+                    return ReturnValue::Success;
+                });
+            }
+        });
+        std::thread setter([&] { promise.set_value(round); });
+        adder.join();
+        setter.join();
+
+        // Every continuation fired exactly once, whether added before or after the value.
+        ASSERT_EQ(fired.load(), CONTINUATIONS);
+    }
+}
+
 TEST(Future, WaitFromMultipleThreads)
 {
     auto promise = make_promise();
@@ -357,3 +402,255 @@ TEST(Future, FloatValue)
     EXPECT_TRUE(future.is_ready());
     EXPECT_FLOAT_EQ(future.get_result().get_value(), 3.14f);
 }
+
+// --- Moved results ---
+
+TEST(Future, SetResultAdoptsValue)
+{
+    auto future = instance().create_future();
+    auto* internal = interface_cast<IFutureInternal>(future);
+    ASSERT_NE(internal, nullptr);
+
+    auto value = ext::create_any_value(vector<float>{1.f, 2.f, 3.f});
+    const IAny* raw = value.get();
+    EXPECT_EQ(internal->set_result(std::move(value)), ReturnValue::Success);
+    EXPECT_EQ(future->get_result(), raw);
+    EXPECT_EQ(internal->set_result(ext::create_any_value(vector<float>{})), ReturnValue::NothingToDo);
+    EXPECT_EQ(future->get_result(), raw);
+}
+
+namespace {
+
+// Counts the copies made of it, to tell a moved value from a cloned one.
+struct CopyCounter
+{
+    CopyCounter() = default;
+    CopyCounter(const CopyCounter& other) : copies(other.copies + 1) {}
+    CopyCounter(CopyCounter&& other) noexcept = default;
+    CopyCounter& operator=(const CopyCounter& other)
+    {
+        copies = other.copies + 1;
+        return *this;
+    }
+    bool operator!=(const CopyCounter& other) const { return copies != other.copies; }
+
+    int copies = 0;
+};
+
+int copies_of(const IAny* any)
+{
+    auto* value = static_cast<const ext::AnyValue<CopyCounter>*>(any);
+    return value ? value->get_value().copies : -1;
+}
+
+} // namespace
+
+TEST(Future, SetValueMovesValue)
+{
+    auto promise = make_promise();
+    IFuture::Ptr future = promise.get_future<CopyCounter>();
+
+    EXPECT_EQ(promise.set_value(CopyCounter{}), ReturnValue::Success);
+    EXPECT_EQ(copies_of(future->get_result()), 0);
+}
+
+TEST(Future, SetValueMovesVector)
+{
+    auto promise = make_promise();
+    auto future = promise.get_future<vector<float>>();
+
+    EXPECT_EQ(promise.set_value(vector<float>{1.f, 2.f, 3.f, 4.f}), ReturnValue::Success);
+    EXPECT_EQ(ArrayAny<const float>(IAny::ConstPtr(future.get_result().clone())).size(), 4u);
+}
+
+TEST(Future, ThenAdoptsContinuationResult)
+{
+    auto promise = make_promise();
+    auto chained = promise.get_future<int>().then([](FnArgs) -> IAny::Ptr {
+        return ext::create_any_value(CopyCounter{});
+    });
+
+    promise.set_value(1);
+    IFuture::Ptr future = chained;
+    EXPECT_EQ(copies_of(future->get_result()), 0);
+}
+
+TEST(Future, DeferredContinuationReceivesStoredResult)
+{
+    auto promise = make_promise();
+    IFuture::Ptr future = promise.get_future<CopyCounter>();
+
+    const IAny* received = nullptr;
+    Future<CopyCounter>(future).then(
+        [&](FnArgs args) -> ReturnValue {
+            received = args[0];
+            return ReturnValue::Success;
+        },
+        Deferred);
+
+    promise.set_value(CopyCounter{});
+    instance().update();
+    EXPECT_EQ(received, future->get_result());
+}
+
+// --- when_all / when_any ---
+
+TEST(Future, WhenAllResolvesAfterLastInput)
+{
+    std::vector<Promise> promises;
+    std::vector<IFuture::Ptr> futures;
+    for (int i = 0; i < 3; ++i) {
+        promises.push_back(make_promise());
+        futures.push_back(promises.back().get_future<int>());
+    }
+    promises[1].set_value(1); // Ready before the join
+
+    auto all = when_all({futures.data(), futures.size()});
+    ASSERT_TRUE(all);
+    EXPECT_FALSE(all.is_ready());
+
+    promises[2].set_value(2);
+    EXPECT_FALSE(all.is_ready());
+    promises[0].set_value(0);
+    EXPECT_TRUE(all.is_ready());
+}
+
+TEST(Future, WhenAllEdgeCases)
+{
+    EXPECT_TRUE(when_all(array_view<IFuture::Ptr>{}).is_ready());
+
+    IFuture::Ptr futures[] = {make_promise().get_future<int>(), nullptr};
+    EXPECT_FALSE(when_all({futures, 2}));
+    EXPECT_FALSE(when_any(array_view<IFuture::Ptr>{}));
+}
+
+TEST(Future, WhenAnyResolvesWithFirstIndex)
+{
+    auto a = make_promise();
+    auto b = make_promise();
+    Future<int> futures[] = {a.get_future<int>(), b.get_future<int>()};
+
+    auto any = when_any(array_view<Future<int>>{futures, 2});
+    EXPECT_FALSE(any.is_ready());
+
+    b.set_value(2);
+    ASSERT_TRUE(any.is_ready());
+    EXPECT_EQ(any.get_result().get_value(), 1u);
+
+    a.set_value(1);
+    EXPECT_EQ(any.get_result().get_value(), 1u);
+}
+
+TEST(Future, WhenAllJoinsInputsResolvedFromThreads)
+{
+    constexpr int count = 1000;
+    std::vector<Promise> promises;
+    std::vector<IFuture::Ptr> futures;
+    for (int i = 0; i < count; ++i) {
+        promises.push_back(make_promise());
+        futures.push_back(promises.back().get_future<int>());
+    }
+
+    std::atomic<int> fired{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = t; i < count; i += 4) {
+                promises[i].set_value(i);
+            }
+        });
+    }
+    auto all = when_all({futures.data(), futures.size()});
+    all.then([&] { ++fired; });
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    all.wait();
+    EXPECT_EQ(fired.load(), 1);
+}
+
+// --- Cancellation ---
+
+TEST(Future, CancelResolvesWithoutResult)
+{
+    auto promise = make_promise();
+    auto future = promise.get_future<int>();
+
+    bool fired = false;
+    future.then([&](int) { fired = true; });
+
+    EXPECT_EQ(future.cancel(), ReturnValue::Success);
+    EXPECT_TRUE(future.is_cancelled());
+    EXPECT_TRUE(future.is_ready());
+    EXPECT_TRUE(promise.is_cancelled());
+    future.wait(); // Does not block
+
+    EXPECT_EQ(promise.set_value(1), ReturnValue::NothingToDo);
+    EXPECT_FALSE(fired);
+    EXPECT_FALSE(future.get_result());
+    EXPECT_EQ(future.cancel(), ReturnValue::NothingToDo);
+}
+
+TEST(Future, CancelAfterResolveDoesNothing)
+{
+    auto promise = make_promise();
+    auto future = promise.get_future<int>();
+    promise.set_value(1);
+
+    EXPECT_EQ(future.cancel(), ReturnValue::NothingToDo);
+    EXPECT_FALSE(future.is_cancelled());
+    EXPECT_EQ(future.get_result().get_value(), 1);
+}
+
+TEST(Future, CancelPropagatesDownChain)
+{
+    auto promise = make_promise();
+    int steps = 0;
+    auto head = promise.get_future<int>();
+    auto tail = head.then([&](int v) -> int { return ++steps, v; }).then([&](int v) -> int {
+        return ++steps, v;
+    });
+
+    head.cancel();
+    EXPECT_TRUE(tail.is_cancelled());
+
+    // Steps added to a cancelled future are cancelled right away.
+    auto late = head.then([&](int v) -> int { return ++steps, v; });
+    EXPECT_TRUE(late.is_cancelled());
+    EXPECT_EQ(steps, 0);
+}
+
+TEST(Future, CancelledThenStepIsSkipped)
+{
+    auto promise = make_promise();
+    int ran = 0;
+    auto step = promise.get_future<int>().then([&](int v) -> int { return ++ran, v; });
+    step.cancel();
+
+    promise.set_value(1);
+    EXPECT_EQ(ran, 0);
+}
+
+TEST(Future, DeferredStepCancelledWhileQueuedIsSkipped)
+{
+    auto promise = make_promise();
+    int ran = 0;
+    auto step = promise.get_future<int>().then([&](int v) -> int { return ++ran, v; }, Deferred);
+
+    promise.set_value(1);
+    step.cancel();
+    instance().update();
+    EXPECT_EQ(ran, 0);
+}
+
+TEST(Future, WhenAllCountsCancelledInputs)
+{
+    auto a = make_promise();
+    auto b = make_promise();
+    IFuture::Ptr futures[] = {a.get_future<int>(), b.get_future<int>()};
+    auto all = when_all({futures, 2});
+
+    a.set_value(1);
+    futures[1]->cancel();
+    EXPECT_TRUE(all.is_ready());
+}
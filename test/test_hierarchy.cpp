@@ -5,6 +5,12 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 using namespace velk;
 
 class IHierarchyTest : public Interface<IHierarchyTest>
@@ -18,6 +24,18 @@ public:
 class HierarchyTestObj : public ext::Object<HierarchyTestObj, IHierarchyTest>
 {};
 
+class IOpacityTest : public Interface<IOpacityTest>
+{
+public:
+    VELK_INTERFACE(
+        (PROP, float, opacity, 1.f),
+        (PROP, float, world_opacity, 1.f)
+    )
+};
+
+class OpacityObj : public ext::Object<OpacityObj, IOpacityTest>
+{};
+
 struct ListenerState
 {
     bool allow_join = true;
@@ -53,19 +71,73 @@ public:
     void on_hierarchy_left(const IHierarchy::Ptr&) override { state_.left_count++; }
 };
 
-class HierarchyTest : public ::testing::Test
+// Executor that runs each task on its own std::thread.
+class ThreadExecutor : public ext::ObjectCore<ThreadExecutor, IExecutor>
+{
+public:
+    size_t get_concurrency() const override { return 4; }
+    void parallel_for(size_t count, void* context, TaskFn task) override
+    {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([=] { task(context, i); });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        calls += count;
+    }
+    size_t calls{};
+};
+
+// Runs every test against each IHierarchy implementation.
+class HierarchyTest : public ::testing::TestWithParam<Uid>
 {
 protected:
     static void SetUpTestSuite()
     {
         instance().type_registry().register_type<HierarchyTestObj>();
         instance().type_registry().register_type<ListenerObj>();
+        instance().type_registry().register_type<OpacityObj>();
     }
 
+    Hierarchy create_hierarchy() const { return ::velk::create_hierarchy(GetParam()); }
+
     IObject::Ptr make_obj() { return instance().create<IObject>(HierarchyTestObj::class_id()); }
+
+    IObject::Ptr make_opacity(float opacity)
+    {
+        auto obj = instance().create<IObject>(OpacityObj::class_id());
+        interface_cast<IOpacityTest>(obj)->opacity().set_value(opacity);
+        return obj;
+    }
+
+    static float world(const IObject::Ptr& obj)
+    {
+        return interface_cast<IOpacityTest>(obj)->world_opacity().get_value();
+    }
+
+    static void set_opacity(const IObject::Ptr& obj, float opacity)
+    {
+        interface_cast<IOpacityTest>(obj)->opacity().set_value(opacity);
+    }
+
+    static ReturnValue inherit_opacity(Hierarchy& h)
+    {
+        return h.add_inherited("opacity", "world_opacity",
+                               [](float parent, float local) { return parent * local; });
+    }
 };
 
-TEST_F(HierarchyTest, CreateHierarchy)
+std::string hierarchy_name(const ::testing::TestParamInfo<Uid>& info)
+{
+    return info.param == ClassId::FlatHierarchy ? "Flat" : "Map";
+}
+
+INSTANTIATE_TEST_SUITE_P(Impl, HierarchyTest, ::testing::Values(ClassId::Hierarchy, ClassId::FlatHierarchy),
+                         hierarchy_name);
+
+TEST_P(HierarchyTest, CreateHierarchy)
 {
     auto h = create_hierarchy();
     EXPECT_TRUE(h);
@@ -73,7 +145,7 @@ TEST_F(HierarchyTest, CreateHierarchy)
     EXPECT_TRUE(h.empty());
 }
 
-TEST_F(HierarchyTest, SetRoot)
+TEST_P(HierarchyTest, SetRoot)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -84,13 +156,13 @@ TEST_F(HierarchyTest, SetRoot)
     EXPECT_FALSE(h.empty());
 }
 
-TEST_F(HierarchyTest, SetRootNullFails)
+TEST_P(HierarchyTest, SetRootNullFails)
 {
     auto h = create_hierarchy();
     EXPECT_EQ(h.set_root({}), ReturnValue::InvalidArgument);
 }
 
-TEST_F(HierarchyTest, SetRootClearsExisting)
+TEST_P(HierarchyTest, SetRootClearsExisting)
 {
     auto h = create_hierarchy();
     auto root1 = make_obj();
@@ -108,7 +180,7 @@ TEST_F(HierarchyTest, SetRootClearsExisting)
     EXPECT_FALSE(h.contains(child));
 }
 
-TEST_F(HierarchyTest, AddChildren)
+TEST_P(HierarchyTest, AddChildren)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -125,7 +197,7 @@ TEST_F(HierarchyTest, AddChildren)
     EXPECT_TRUE(h.contains(child2));
 }
 
-TEST_F(HierarchyTest, AddToNonMemberParentFails)
+TEST_P(HierarchyTest, AddToNonMemberParentFails)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -136,7 +208,7 @@ TEST_F(HierarchyTest, AddToNonMemberParentFails)
     EXPECT_EQ(h.add(orphan, child), ReturnValue::InvalidArgument);
 }
 
-TEST_F(HierarchyTest, AddDuplicateFails)
+TEST_P(HierarchyTest, AddDuplicateFails)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -147,7 +219,7 @@ TEST_F(HierarchyTest, AddDuplicateFails)
     EXPECT_EQ(h.add(root, child), ReturnValue::InvalidArgument);
 }
 
-TEST_F(HierarchyTest, AddNullFails)
+TEST_P(HierarchyTest, AddNullFails)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -157,7 +229,7 @@ TEST_F(HierarchyTest, AddNullFails)
     EXPECT_EQ(h.add({}, root), ReturnValue::InvalidArgument);
 }
 
-TEST_F(HierarchyTest, ParentOfRoot)
+TEST_P(HierarchyTest, ParentOfRoot)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -166,7 +238,7 @@ TEST_F(HierarchyTest, ParentOfRoot)
     EXPECT_FALSE(h.parent_of(root));
 }
 
-TEST_F(HierarchyTest, ParentOfChild)
+TEST_P(HierarchyTest, ParentOfChild)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -178,7 +250,7 @@ TEST_F(HierarchyTest, ParentOfChild)
     EXPECT_EQ(h.parent_of(child), root);
 }
 
-TEST_F(HierarchyTest, ChildrenOf)
+TEST_P(HierarchyTest, ChildrenOf)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -195,7 +267,7 @@ TEST_F(HierarchyTest, ChildrenOf)
     EXPECT_EQ(children[1], child2);
 }
 
-TEST_F(HierarchyTest, InsertAtIndex)
+TEST_P(HierarchyTest, InsertAtIndex)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -216,7 +288,92 @@ TEST_F(HierarchyTest, InsertAtIndex)
     EXPECT_EQ(children[2], child3);
 }
 
-TEST_F(HierarchyTest, InsertOutOfBoundsFails)
+TEST_P(HierarchyTest, AddChildrenAppendsInOrder)
+{
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    auto first = make_obj();
+    h.set_root(root);
+    h.add(root, first);
+
+    std::vector<IObject::Ptr> batch{make_obj(), make_obj(), make_obj()};
+    EXPECT_EQ(h.add_children(root, {batch.data(), batch.size()}), ReturnValue::Success);
+    EXPECT_EQ(h.size(), 5u);
+    auto* ih = interface_cast<IHierarchy>(h.get());
+    auto children = ih->children_of(root);
+    ASSERT_EQ(children.size(), 4u);
+    EXPECT_EQ(children[0], first);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        EXPECT_EQ(children[i + 1], batch[i]);
+        EXPECT_EQ(ih->parent_of(batch[i]), root);
+    }
+    EXPECT_EQ(h.add_children(root, {}), ReturnValue::NothingToDo);
+}
+
+TEST_P(HierarchyTest, AddChildrenFailsWithoutAddingAny)
+{
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    auto existing = make_obj();
+    h.set_root(root);
+    h.add(root, existing);
+
+    auto a = make_obj();
+    std::vector<IObject::Ptr> duplicate{a, make_obj(), existing};
+    EXPECT_EQ(h.add_children(root, {duplicate.data(), duplicate.size()}), ReturnValue::InvalidArgument);
+    std::vector<IObject::Ptr> twice{a, make_obj(), a};
+    EXPECT_EQ(h.add_children(root, {twice.data(), twice.size()}), ReturnValue::InvalidArgument);
+    std::vector<IObject::Ptr> null{a, {}};
+    EXPECT_EQ(h.add_children(root, {null.data(), null.size()}), ReturnValue::InvalidArgument);
+    EXPECT_EQ(h.add_children(make_obj(), {twice.data(), 1}), ReturnValue::InvalidArgument);
+    EXPECT_EQ(h.size(), 2u);
+    EXPECT_FALSE(h.contains(a));
+    EXPECT_EQ(h.child_count(root), 1u);
+
+    auto listener = instance().create<IObject>(ListenerObj::class_id());
+    interface_cast<ITestListener>(listener)->state().allow_join = false;
+    std::vector<IObject::Ptr> refused{a, listener};
+    EXPECT_EQ(h.add_children(root, {refused.data(), refused.size()}), ReturnValue::Refused);
+    EXPECT_FALSE(h.contains(a));
+}
+
+TEST_P(HierarchyTest, AddSubtreeBuildsFromParentIndices)
+{
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    h.set_root(root);
+
+    // a{a1, a2{x}}, b
+    auto listener = instance().create<IObject>(ListenerObj::class_id());
+    std::vector<IObject::Ptr> objects{make_obj(), make_obj(), make_obj(), make_obj(), listener};
+    const auto outer = IHierarchy::OUTER_PARENT;
+    std::vector<uint32_t> parents{outer, 0, outer, 0, 3};
+    EXPECT_EQ(h.add_subtree(root, {objects.data(), objects.size()}, {parents.data(), parents.size()}),
+              ReturnValue::Success);
+    EXPECT_EQ(h.size(), 6u);
+
+    std::vector<std::pair<IObject*, size_t>> visited;
+    h.traverse<IObject>(root, TraversalOrder::PreOrder,
+                        [&](IObject& obj, size_t depth) { visited.emplace_back(&obj, depth); });
+    std::vector<std::pair<IObject*, size_t>> expected{{root.get(), 0},       {objects[0].get(), 1},
+                                                      {objects[1].get(), 2}, {objects[3].get(), 2},
+                                                      {objects[4].get(), 3}, {objects[2].get(), 1}};
+    EXPECT_EQ(visited, expected);
+
+    auto& state = interface_cast<ITestListener>(listener)->state();
+    EXPECT_EQ(state.joined_count, 1);
+    EXPECT_EQ(state.last_join_parent, objects[3]);
+
+    std::vector<IObject::Ptr> more{make_obj(), make_obj()};
+    std::vector<uint32_t> forward{1, outer};
+    EXPECT_EQ(h.add_subtree(root, {more.data(), more.size()}, {forward.data(), forward.size()}),
+              ReturnValue::InvalidArgument);
+    EXPECT_EQ(h.add_subtree(root, {more.data(), more.size()}, {parents.data(), 1}),
+              ReturnValue::InvalidArgument);
+    EXPECT_EQ(h.size(), 6u);
+}
+
+TEST_P(HierarchyTest, InsertOutOfBoundsFails)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -226,7 +383,7 @@ TEST_F(HierarchyTest, InsertOutOfBoundsFails)
     EXPECT_EQ(h.insert(root, 5, child), ReturnValue::InvalidArgument);
 }
 
-TEST_F(HierarchyTest, RemoveSubtree)
+TEST_P(HierarchyTest, RemoveSubtree)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -248,7 +405,7 @@ TEST_F(HierarchyTest, RemoveSubtree)
     EXPECT_EQ(h.child_count(root), 0u);
 }
 
-TEST_F(HierarchyTest, RemoveRoot)
+TEST_P(HierarchyTest, RemoveRoot)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -262,7 +419,7 @@ TEST_F(HierarchyTest, RemoveRoot)
     EXPECT_FALSE(h.root());
 }
 
-TEST_F(HierarchyTest, RemoveNonMember)
+TEST_P(HierarchyTest, RemoveNonMember)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -272,7 +429,7 @@ TEST_F(HierarchyTest, RemoveNonMember)
     EXPECT_EQ(h.remove(orphan), ReturnValue::NothingToDo);
 }
 
-TEST_F(HierarchyTest, ReplaceChild)
+TEST_P(HierarchyTest, ReplaceChild)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -294,7 +451,7 @@ TEST_F(HierarchyTest, ReplaceChild)
     EXPECT_EQ(children[1], child2);
 }
 
-TEST_F(HierarchyTest, ReplacePreservesChildren)
+TEST_P(HierarchyTest, ReplacePreservesChildren)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -312,7 +469,7 @@ TEST_F(HierarchyTest, ReplacePreservesChildren)
     EXPECT_EQ(h.parent_of(grandchild), replacement);
 }
 
-TEST_F(HierarchyTest, ReplaceRoot)
+TEST_P(HierarchyTest, ReplaceRoot)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -329,7 +486,7 @@ TEST_F(HierarchyTest, ReplaceRoot)
     EXPECT_EQ(h.parent_of(child), new_root);
 }
 
-TEST_F(HierarchyTest, ReplaceNonMemberFails)
+TEST_P(HierarchyTest, ReplaceNonMemberFails)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -340,7 +497,7 @@ TEST_F(HierarchyTest, ReplaceNonMemberFails)
     EXPECT_EQ(h.replace(orphan, replacement), ReturnValue::InvalidArgument);
 }
 
-TEST_F(HierarchyTest, ReplaceDuplicateFails)
+TEST_P(HierarchyTest, ReplaceDuplicateFails)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -353,7 +510,7 @@ TEST_F(HierarchyTest, ReplaceDuplicateFails)
     EXPECT_EQ(h.replace(child, root), ReturnValue::InvalidArgument);
 }
 
-TEST_F(HierarchyTest, NodeOfReturnsSnapshot)
+TEST_P(HierarchyTest, NodeOfReturnsSnapshot)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -379,7 +536,7 @@ TEST_F(HierarchyTest, NodeOfReturnsSnapshot)
     EXPECT_EQ(childNode.child_count(), 0u);
 }
 
-TEST_F(HierarchyTest, NodeOfNonMemberReturnsEmpty)
+TEST_P(HierarchyTest, NodeOfNonMemberReturnsEmpty)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -390,7 +547,7 @@ TEST_F(HierarchyTest, NodeOfNonMemberReturnsEmpty)
     EXPECT_FALSE(node);
 }
 
-TEST_F(HierarchyTest, ContainsAndSize)
+TEST_P(HierarchyTest, ContainsAndSize)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -409,7 +566,7 @@ TEST_F(HierarchyTest, ContainsAndSize)
     EXPECT_EQ(h.size(), 2u);
 }
 
-TEST_F(HierarchyTest, Clear)
+TEST_P(HierarchyTest, Clear)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -425,7 +582,7 @@ TEST_F(HierarchyTest, Clear)
     EXPECT_FALSE(h.contains(root));
 }
 
-TEST_F(HierarchyTest, ChildrenOfReturnsNodes)
+TEST_P(HierarchyTest, ChildrenOfReturnsNodes)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -443,7 +600,67 @@ TEST_F(HierarchyTest, ChildrenOfReturnsNodes)
     EXPECT_EQ(children[1].class_uid(), HierarchyTestObj::class_id());
 }
 
-TEST_F(HierarchyTest, ForEachChild)
+TEST_P(HierarchyTest, ViewChildrenIteratesInPlace)
+{
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    h.set_root(root);
+    std::vector<IObject::Ptr> children;
+    for (int i = 0; i < 3; ++i) {
+        children.push_back(make_obj());
+        h.add(root, children.back());
+    }
+    h.remove(children[1]);
+    children.erase(children.begin() + 1);
+    auto strong = children[0].block()->strong.load();
+
+    {
+        auto view = h.view_children(root);
+        ASSERT_EQ(view.size(), 2u);
+        size_t i = 0;
+        for (auto& child : view) {
+            ASSERT_LT(i, children.size());
+            EXPECT_EQ(child, children[i++]);
+        }
+        EXPECT_EQ(i, 2u);
+        EXPECT_EQ(children[0].block()->strong.load(), strong);
+
+        // Queries from the viewing thread take the read lock again.
+        EXPECT_EQ(h.child_count(root), 2u);
+    }
+
+    EXPECT_TRUE(h.view_children(children[0]).empty());
+    auto missing = h.view_children(make_obj());
+    EXPECT_TRUE(missing.empty());
+    EXPECT_EQ(missing.begin(), missing.end());
+    EXPECT_TRUE(Hierarchy().view_children(root).empty());
+}
+
+TEST_P(HierarchyTest, ViewChildrenBlocksMutationsUntilReleased)
+{
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    h.set_root(root);
+    h.add(root, make_obj());
+
+    auto view = h.view_children(root);
+    std::atomic<bool> added{false};
+    std::thread writer([&] {
+        h.add(root, make_obj());
+        added = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(added);
+    EXPECT_EQ(view.size(), 1u);
+
+    view.release();
+    EXPECT_TRUE(view.empty());
+    writer.join();
+    EXPECT_TRUE(added);
+    EXPECT_EQ(h.child_count(root), 2u);
+}
+
+TEST_P(HierarchyTest, ForEachChild)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -463,7 +680,7 @@ TEST_F(HierarchyTest, ForEachChild)
     EXPECT_EQ(sum, 30);
 }
 
-TEST_F(HierarchyTest, ForEachChildEarlyStop)
+TEST_P(HierarchyTest, ForEachChildEarlyStop)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -482,7 +699,344 @@ TEST_F(HierarchyTest, ForEachChildEarlyStop)
     EXPECT_EQ(count, 1);
 }
 
-TEST_F(HierarchyTest, NullHierarchySafe)
+TEST_P(HierarchyTest, TraverseVisitsSubtreeInOrder)
+{
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    auto a = make_obj();
+    auto a1 = make_obj();
+    auto a2 = make_obj();
+    auto b = make_obj();
+    auto b1 = make_obj();
+
+    h.set_root(root);
+    h.add(root, a);
+    h.add(root, b);
+    h.add(a, a1);
+    h.add(b, b1);
+    h.insert(a, 1, a2);
+
+    std::vector<std::pair<IObject*, size_t>> visited;
+    auto record = [&](IObject& obj, size_t depth) { visited.emplace_back(&obj, depth); };
+    h.traverse<IObject>(root, TraversalOrder::PreOrder, record);
+    std::vector<std::pair<IObject*, size_t>> expected{
+        {root.get(), 0}, {a.get(), 1}, {a1.get(), 2}, {a2.get(), 2}, {b.get(), 1}, {b1.get(), 2}};
+    EXPECT_EQ(visited, expected);
+
+    visited.clear();
+    h.traverse<IObject>(root, TraversalOrder::PostOrder, record);
+    expected = {{a1.get(), 2}, {a2.get(), 2}, {a.get(), 1}, {b1.get(), 2}, {b.get(), 1}, {root.get(), 0}};
+    EXPECT_EQ(visited, expected);
+
+    visited.clear();
+    h.traverse<IObject>(a, TraversalOrder::PreOrder, record);
+    expected = {{a.get(), 1}, {a1.get(), 2}, {a2.get(), 2}};
+    EXPECT_EQ(visited, expected);
+
+    visited.clear();
+    h.traverse<IObject>(b, TraversalOrder::PostOrder, record);
+    expected = {{b1.get(), 2}, {b.get(), 1}};
+    EXPECT_EQ(visited, expected);
+
+    size_t count = 0;
+    h.traverse<IObject>(root, TraversalOrder::PostOrder, [&](IObject&, size_t) { return ++count < 3; });
+    EXPECT_EQ(count, 3u);
+
+    count = 0;
+    h.traverse<IObject>(make_obj(), TraversalOrder::PreOrder, [&](IObject&, size_t) { ++count; });
+    EXPECT_EQ(count, 0u);
+}
+
+TEST_P(HierarchyTest, TraverseParallelKeepsParentsOrdered)
+{
+    // root with 8 children, each the top of a chain of 40.
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    h.set_root(root);
+    std::unordered_map<IObject*, IObject*> parents;
+    for (int i = 0; i < 8; ++i) {
+        auto parent = root;
+        for (int j = 0; j < 40; ++j) {
+            auto node = make_obj();
+            h.add(parent, node);
+            parents[node.get()] = parent.get();
+            parent = node;
+        }
+    }
+
+    auto exec = ext::make_object<ThreadExecutor, IExecutor>();
+    ParallelTraversalConfig config;
+    config.minTaskSize = 80;
+    for (auto order : {TraversalOrder::PreOrder, TraversalOrder::PostOrder}) {
+        std::mutex mutex;
+        std::unordered_map<IObject*, size_t> visited; // Object to visit sequence number.
+        h.traverse_parallel<IObject>(root, order, exec.get(), [&](IObject& obj, size_t depth) {
+            std::lock_guard lock(mutex);
+            EXPECT_EQ(depth == 0, &obj == root.get());
+            visited.emplace(&obj, visited.size());
+        }, config);
+        ASSERT_EQ(visited.size(), h.size());
+        for (auto& [child, parent] : parents) {
+            if (order == TraversalOrder::PreOrder) {
+                EXPECT_LT(visited[parent], visited[child]);
+            } else {
+                EXPECT_GT(visited[parent], visited[child]);
+            }
+        }
+    }
+    // Two chains per task.
+    EXPECT_EQ(static_cast<ThreadExecutor*>(exec.get())->calls, 8u);
+
+    // Without an executor, or stopped at the root, nothing runs in parallel.
+    std::vector<IObject*> serial;
+    h.traverse_parallel<IObject>(root, TraversalOrder::PreOrder, nullptr,
+                                 [&](IObject& obj, size_t) { serial.push_back(&obj); });
+    std::vector<IObject*> expected;
+    h.traverse<IObject>(root, TraversalOrder::PreOrder,
+                        [&](IObject& obj, size_t) { expected.push_back(&obj); });
+    EXPECT_EQ(serial, expected);
+
+    size_t count = 0;
+    h.traverse_parallel<IObject>(root, TraversalOrder::PreOrder, exec.get(), [&](IObject&, size_t) {
+        ++count;
+        return false;
+    });
+    EXPECT_EQ(count, 1u);
+    EXPECT_EQ(static_cast<ThreadExecutor*>(exec.get())->calls, 8u);
+}
+
+// Checks that snap lists exactly the objects of h, with the same parents and children.
+static void expect_snapshot_matches(const Hierarchy& h, const IHierarchySnapshot& snap)
+{
+    ASSERT_EQ(snap.size(), h.size());
+    EXPECT_EQ(snap.root(), h.root());
+    if (!h.root()) {
+        return;
+    }
+    h.traverse<IObject>(h.root(), TraversalOrder::PreOrder, [&](IObject& obj, size_t) {
+        auto object = obj.get_self();
+        ASSERT_TRUE(snap.contains(object));
+        EXPECT_EQ(snap.parent_of(object), h.parent_of(object));
+        auto children = h.children_of(object);
+        auto view = snap.children_of(object);
+        ASSERT_EQ(view.size(), children.size());
+        EXPECT_EQ(snap.child_count(object), children.size());
+        for (size_t i = 0; i < children.size(); ++i) {
+            EXPECT_EQ(view[i], children[i]);
+        }
+    });
+}
+
+TEST_P(HierarchyTest, SnapshotsAreVersionedAndImmutable)
+{
+    auto h = create_hierarchy();
+    EXPECT_FALSE(h.snapshot());
+    auto root = make_obj();
+    auto a = make_obj();
+    auto b = make_obj();
+    auto c = make_obj();
+    h.set_root(root);
+    h.add(root, a);
+    h.add(root, b);
+    h.add(a, c);
+
+    EXPECT_EQ(h.commit_snapshot(), 1u);
+    auto first = h.snapshot();
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first->version(), 1u);
+    expect_snapshot_matches(h, *first);
+
+    // Nothing changed: no new snapshot.
+    EXPECT_EQ(h.commit_snapshot(), 1u);
+    EXPECT_EQ(h.snapshot().get(), first.get());
+
+    auto d = make_obj();
+    h.remove(a);
+    h.replace(b, d);
+    EXPECT_EQ(h.commit_snapshot(), 2u);
+    auto second = h.snapshot();
+    EXPECT_EQ(second->version(), 2u);
+    expect_snapshot_matches(h, *second);
+    EXPECT_FALSE(second->contains(c));
+    EXPECT_EQ(second->parent_of(d), root);
+
+    // The first snapshot still shows the tree as it was, and keeps the removed objects alive.
+    EXPECT_EQ(first->size(), 4u);
+    EXPECT_EQ(first->parent_of(c), a);
+    EXPECT_EQ(first->children_of(root).size(), 2u);
+    EXPECT_EQ(first->children_of(root)[1], b);
+    EXPECT_FALSE(first->contains(d));
+    EXPECT_FALSE(first->parent_of(root));
+
+    h.clear();
+    EXPECT_EQ(h.commit_snapshot(), 3u);
+    EXPECT_EQ(h.snapshot()->size(), 0u);
+    EXPECT_FALSE(h.snapshot()->root());
+}
+
+TEST_P(HierarchyTest, SnapshotsFollowManyCommits)
+{
+    auto h = create_hierarchy();
+    std::vector<IObject::Ptr> objects{make_obj()};
+    h.set_root(objects[0]);
+    for (size_t i = 1; i < 3000; ++i) {
+        objects.push_back(make_obj());
+        h.add(objects[(i - 1) / 3], objects.back());
+    }
+    h.commit_snapshot();
+    expect_snapshot_matches(h, *h.snapshot());
+
+    // A few changes per commit update the previous snapshot rather than build a new one.
+    uint32_t seed = 1;
+    auto next = [&] { return (seed = seed * 1664525u + 1013904223u) >> 8; };
+    for (int round = 0; round < 20; ++round) {
+        for (int k = 0; k < 5; ++k) {
+            auto& object = objects[1 + next() % (objects.size() - 1)];
+            if (!h.contains(object)) {
+                continue;
+            }
+            switch (next() % 3) {
+            case 0:
+                h.remove(object);
+                break;
+            case 1:
+                h.add(object, make_obj());
+                break;
+            default:
+                h.replace(object, make_obj());
+                break;
+            }
+        }
+        h.commit_snapshot();
+        expect_snapshot_matches(h, *h.snapshot());
+    }
+}
+
+TEST_P(HierarchyTest, SnapshotsReadWhileCommitting)
+{
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    h.set_root(root);
+    h.commit_snapshot();
+
+    std::atomic<bool> done{false};
+    std::atomic<size_t> reads{0};
+    std::thread reader([&] {
+        uint64_t version = 0;
+        while (!done.load()) {
+            auto snap = h.snapshot();
+            EXPECT_GE(snap->version(), version);
+            version = snap->version();
+            for (auto& child : snap->children_of(snap->root())) {
+                EXPECT_EQ(snap->parent_of(child), snap->root());
+            }
+            reads.fetch_add(1);
+        }
+    });
+    for (int i = 0; i < 200; ++i) {
+        auto child = make_obj();
+        h.add(root, child);
+        h.commit_snapshot();
+        if (i % 3 == 0) {
+            h.remove(child);
+        }
+        if (i % 50 == 0) {
+            while (reads.load() < static_cast<size_t>(i / 50 + 1)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    done.store(true);
+    reader.join();
+    EXPECT_GT(reads.load(), 0u);
+}
+
+TEST_P(HierarchyTest, TraverseReflectsMutations)
+{
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    auto a = make_obj();
+    auto a1 = make_obj();
+    auto b = make_obj();
+    h.set_root(root);
+    h.add(root, a);
+    h.add(a, a1);
+    h.add(root, b);
+
+    std::vector<IObject*> visited;
+    auto walk = [&] {
+        visited.clear();
+        h.traverse<IObject>(root, TraversalOrder::PreOrder,
+                            [&](IObject& obj, size_t) { visited.push_back(&obj); });
+        return visited;
+    };
+    EXPECT_EQ(walk(), (std::vector<IObject*>{root.get(), a.get(), a1.get(), b.get()}));
+
+    auto c = make_obj();
+    h.replace(a, c);
+    EXPECT_EQ(walk(), (std::vector<IObject*>{root.get(), c.get(), a1.get(), b.get()}));
+
+    h.remove(a1);
+    EXPECT_EQ(walk(), (std::vector<IObject*>{root.get(), c.get(), b.get()}));
+
+    auto d = make_obj();
+    h.insert(root, 1, d);
+    EXPECT_EQ(walk(), (std::vector<IObject*>{root.get(), c.get(), d.get(), b.get()}));
+
+    // The visitor sees the tree as it was when the traversal started.
+    visited.clear();
+    h.traverse<IObject>(root, TraversalOrder::PreOrder, [&](IObject& obj, size_t) {
+        visited.push_back(&obj);
+        if (&obj == root.get()) {
+            h.remove(c);
+            h.add(root, make_obj());
+        }
+    });
+    EXPECT_EQ(visited, (std::vector<IObject*>{root.get(), c.get(), d.get(), b.get()}));
+    EXPECT_EQ(walk().size(), 4u);
+    EXPECT_FALSE(h.contains(c));
+}
+
+TEST_P(HierarchyTest, MutationsAfterRemoveKeepChildOrder)
+{
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    std::vector<IObject::Ptr> c;
+    h.set_root(root);
+    for (int i = 0; i < 4; ++i) {
+        c.push_back(make_obj());
+        h.add(root, c.back());
+    }
+    auto grandchild = make_obj();
+    h.add(c[1], grandchild);
+
+    // Nodes freed by the removal are reused by the inserts that follow.
+    EXPECT_EQ(h.remove(c[1]), ReturnValue::Success);
+    auto x = make_obj();
+    auto y = make_obj();
+    auto z = make_obj();
+    EXPECT_EQ(h.insert(root, 1, x), ReturnValue::Success);
+    EXPECT_EQ(h.add(root, y), ReturnValue::Success);
+    EXPECT_EQ(h.insert(y, 0, z), ReturnValue::Success);
+
+    auto* ih = interface_cast<IHierarchy>(h.get());
+    auto children = ih->children_of(root);
+    ASSERT_EQ(children.size(), 5u);
+    EXPECT_EQ(children[0], c[0]);
+    EXPECT_EQ(children[1], x);
+    EXPECT_EQ(children[2], c[2]);
+    EXPECT_EQ(children[3], c[3]);
+    EXPECT_EQ(children[4], y);
+    for (size_t i = 0; i < children.size(); ++i) {
+        EXPECT_EQ(ih->child_at(root, i), children[i]);
+    }
+    EXPECT_FALSE(ih->child_at(root, 5));
+    EXPECT_EQ(ih->parent_of(z), y);
+    EXPECT_FALSE(h.contains(grandchild));
+    EXPECT_EQ(h.size(), 7u);
+}
+
+TEST_P(HierarchyTest, NullHierarchySafe)
 {
     Hierarchy h;
     EXPECT_FALSE(h);
@@ -501,7 +1055,7 @@ TEST_F(HierarchyTest, NullHierarchySafe)
     EXPECT_FALSE(h.contains({}));
 }
 
-TEST_F(HierarchyTest, RootReturnsNode)
+TEST_P(HierarchyTest, RootReturnsNode)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -519,20 +1073,20 @@ TEST_F(HierarchyTest, RootReturnsNode)
     EXPECT_TRUE(node.hierarchy());
 }
 
-TEST_F(HierarchyTest, HierarchyClassId)
+TEST_P(HierarchyTest, HierarchyClassId)
 {
     auto h = create_hierarchy();
-    EXPECT_EQ(h.class_uid(), ClassId::Hierarchy);
+    EXPECT_EQ(h.class_uid(), GetParam());
 }
 
-TEST_F(HierarchyTest, GetHierarchyInterface)
+TEST_P(HierarchyTest, GetHierarchyInterface)
 {
     auto h = create_hierarchy();
     auto iface = h.get_hierarchy_interface();
     EXPECT_TRUE(iface);
 }
 
-TEST_F(HierarchyTest, NodeInheritsObject)
+TEST_P(HierarchyTest, NodeInheritsObject)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -549,7 +1103,7 @@ TEST_F(HierarchyTest, NodeInheritsObject)
     EXPECT_EQ(iht->value().get_value(), 42);
 }
 
-TEST_F(HierarchyTest, NodeGetChildren)
+TEST_P(HierarchyTest, NodeGetChildren)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -567,7 +1121,34 @@ TEST_F(HierarchyTest, NodeGetChildren)
     EXPECT_EQ(children[1], child2);
 }
 
-TEST_F(HierarchyTest, NodeChildAt)
+TEST_P(HierarchyTest, ChildrenFromArena)
+{
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    auto child1 = make_obj();
+    auto child2 = make_obj();
+
+    h.set_root(root);
+    h.add(root, child1);
+    h.add(root, child2);
+    h.add(child1, make_obj());
+
+    Arena arena;
+    auto children = h.root().get_children(&arena);
+    EXPECT_EQ(children.arena(), &arena);
+    ASSERT_EQ(children.size(), 2u);
+    EXPECT_EQ(children[0], child1);
+    EXPECT_EQ(children[1], child2);
+    EXPECT_EQ(children[0].child_count(), 1u);
+    EXPECT_EQ(children[1].get_parent(), root);
+
+    auto nested = h.children_of(child1, &arena);
+    ASSERT_EQ(nested.size(), 1u);
+    EXPECT_EQ(nested[0].get_parent(), child1);
+    EXPECT_TRUE(h.children_of(make_obj(), &arena).empty());
+}
+
+TEST_P(HierarchyTest, NodeChildAt)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -581,7 +1162,7 @@ TEST_F(HierarchyTest, NodeChildAt)
     EXPECT_FALSE(node.child_at(1)); // out of range
 }
 
-TEST_F(HierarchyTest, NodeTypedChildAt)
+TEST_P(HierarchyTest, NodeTypedChildAt)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -596,7 +1177,7 @@ TEST_F(HierarchyTest, NodeTypedChildAt)
     EXPECT_FALSE(node.child_at<IHierarchyTest>(5));
 }
 
-TEST_F(HierarchyTest, NodeImplicitConversion)
+TEST_P(HierarchyTest, NodeImplicitConversion)
 {
     auto h = create_hierarchy();
     auto root_obj = make_obj();
@@ -611,7 +1192,7 @@ TEST_F(HierarchyTest, NodeImplicitConversion)
     EXPECT_TRUE(h.contains(root_node));
 }
 
-TEST_F(HierarchyTest, NodeForEachChild)
+TEST_P(HierarchyTest, NodeForEachChild)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -631,7 +1212,7 @@ TEST_F(HierarchyTest, NodeForEachChild)
     EXPECT_EQ(sum, 30);
 }
 
-TEST_F(HierarchyTest, NodeForEachChildEarlyStop)
+TEST_P(HierarchyTest, NodeForEachChildEarlyStop)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -651,7 +1232,7 @@ TEST_F(HierarchyTest, NodeForEachChildEarlyStop)
     EXPECT_EQ(count, 1);
 }
 
-TEST_F(HierarchyTest, NodeDefaultConstructedIsEmpty)
+TEST_P(HierarchyTest, NodeDefaultConstructedIsEmpty)
 {
     ::velk::Node node;
     EXPECT_FALSE(node);
@@ -663,7 +1244,7 @@ TEST_F(HierarchyTest, NodeDefaultConstructedIsEmpty)
     EXPECT_EQ(node.get_children().size(), 0u);
 }
 
-TEST_F(HierarchyTest, NodeHierarchyNodeAccess)
+TEST_P(HierarchyTest, NodeHierarchyNodeAccess)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -674,7 +1255,7 @@ TEST_F(HierarchyTest, NodeHierarchyNodeAccess)
     EXPECT_EQ(hn.object, root);
 }
 
-TEST_F(HierarchyTest, NodeReflectsLiveState)
+TEST_P(HierarchyTest, NodeReflectsLiveState)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -698,7 +1279,7 @@ TEST_F(HierarchyTest, NodeReflectsLiveState)
 
 // Listener tests
 
-TEST_F(HierarchyTest, ListenerJoinedCalledOnAdd)
+TEST_P(HierarchyTest, ListenerJoinedCalledOnAdd)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -712,7 +1293,7 @@ TEST_F(HierarchyTest, ListenerJoinedCalledOnAdd)
     EXPECT_EQ(listener->state().last_join_parent, root);
 }
 
-TEST_F(HierarchyTest, ListenerJoinedCalledOnInsert)
+TEST_P(HierarchyTest, ListenerJoinedCalledOnInsert)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -725,7 +1306,7 @@ TEST_F(HierarchyTest, ListenerJoinedCalledOnInsert)
     EXPECT_EQ(listener->state().joined_count, 1);
 }
 
-TEST_F(HierarchyTest, ListenerJoinedCalledOnSetRoot)
+TEST_P(HierarchyTest, ListenerJoinedCalledOnSetRoot)
 {
     auto h = create_hierarchy();
     auto root = instance().create<IObject>(ListenerObj::class_id());
@@ -737,7 +1318,7 @@ TEST_F(HierarchyTest, ListenerJoinedCalledOnSetRoot)
     EXPECT_FALSE(listener->state().last_join_parent); // root has no parent
 }
 
-TEST_F(HierarchyTest, ListenerLeftCalledOnRemove)
+TEST_P(HierarchyTest, ListenerLeftCalledOnRemove)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -751,7 +1332,7 @@ TEST_F(HierarchyTest, ListenerLeftCalledOnRemove)
     EXPECT_EQ(listener->state().left_count, 1);
 }
 
-TEST_F(HierarchyTest, ListenerLeftCalledOnSubtreeRemove)
+TEST_P(HierarchyTest, ListenerLeftCalledOnSubtreeRemove)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -768,7 +1349,7 @@ TEST_F(HierarchyTest, ListenerLeftCalledOnSubtreeRemove)
     EXPECT_EQ(listener->state().left_count, 1);
 }
 
-TEST_F(HierarchyTest, ListenerLeftCalledOnClear)
+TEST_P(HierarchyTest, ListenerLeftCalledOnClear)
 {
     auto h = create_hierarchy();
     auto root = instance().create<IObject>(ListenerObj::class_id());
@@ -784,7 +1365,7 @@ TEST_F(HierarchyTest, ListenerLeftCalledOnClear)
     EXPECT_EQ(childListener->state().left_count, 1);
 }
 
-TEST_F(HierarchyTest, ListenerLeftCalledOnSetRootReplace)
+TEST_P(HierarchyTest, ListenerLeftCalledOnSetRootReplace)
 {
     auto h = create_hierarchy();
     auto root1 = instance().create<IObject>(ListenerObj::class_id());
@@ -801,7 +1382,7 @@ TEST_F(HierarchyTest, ListenerLeftCalledOnSetRootReplace)
     EXPECT_EQ(childListener->state().left_count, 1);
 }
 
-TEST_F(HierarchyTest, ListenerReplaceNotifiesBoth)
+TEST_P(HierarchyTest, ListenerReplaceNotifiesBoth)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -819,7 +1400,7 @@ TEST_F(HierarchyTest, ListenerReplaceNotifiesBoth)
     EXPECT_EQ(newListener->state().last_join_parent, root);
 }
 
-TEST_F(HierarchyTest, ListenerRefuseJoin)
+TEST_P(HierarchyTest, ListenerRefuseJoin)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -833,7 +1414,7 @@ TEST_F(HierarchyTest, ListenerRefuseJoin)
     EXPECT_EQ(listener->state().joined_count, 0);
 }
 
-TEST_F(HierarchyTest, ListenerRefuseJoinOnInsert)
+TEST_P(HierarchyTest, ListenerRefuseJoinOnInsert)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -846,7 +1427,7 @@ TEST_F(HierarchyTest, ListenerRefuseJoinOnInsert)
     EXPECT_FALSE(h.contains(child));
 }
 
-TEST_F(HierarchyTest, ListenerRefuseJoinOnSetRoot)
+TEST_P(HierarchyTest, ListenerRefuseJoinOnSetRoot)
 {
     auto h = create_hierarchy();
     auto root = instance().create<IObject>(ListenerObj::class_id());
@@ -857,7 +1438,7 @@ TEST_F(HierarchyTest, ListenerRefuseJoinOnSetRoot)
     EXPECT_TRUE(h.empty());
 }
 
-TEST_F(HierarchyTest, ListenerRefuseLeave)
+TEST_P(HierarchyTest, ListenerRefuseLeave)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -872,7 +1453,7 @@ TEST_F(HierarchyTest, ListenerRefuseLeave)
     EXPECT_TRUE(h.contains(child)); // still in hierarchy
 }
 
-TEST_F(HierarchyTest, ListenerRefuseLeaveDoesNotAffectSubtreeRemove)
+TEST_P(HierarchyTest, ListenerRefuseLeaveDoesNotAffectSubtreeRemove)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -891,7 +1472,7 @@ TEST_F(HierarchyTest, ListenerRefuseLeaveDoesNotAffectSubtreeRemove)
     EXPECT_EQ(listener->state().left_count, 1);
 }
 
-TEST_F(HierarchyTest, ListenerRefuseLeaveDoesNotAffectClear)
+TEST_P(HierarchyTest, ListenerRefuseLeaveDoesNotAffectClear)
 {
     auto h = create_hierarchy();
     auto root = instance().create<IObject>(ListenerObj::class_id());
@@ -904,7 +1485,7 @@ TEST_F(HierarchyTest, ListenerRefuseLeaveDoesNotAffectClear)
     EXPECT_EQ(listener->state().left_count, 1);
 }
 
-TEST_F(HierarchyTest, ListenerRefuseJoinOnReplace)
+TEST_P(HierarchyTest, ListenerRefuseJoinOnReplace)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -921,7 +1502,7 @@ TEST_F(HierarchyTest, ListenerRefuseJoinOnReplace)
     EXPECT_FALSE(h.contains(new_child));
 }
 
-TEST_F(HierarchyTest, NonListenerObjectsUnaffected)
+TEST_P(HierarchyTest, NonListenerObjectsUnaffected)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -932,6 +1513,92 @@ TEST_F(HierarchyTest, NonListenerObjectsUnaffected)
     EXPECT_TRUE(succeeded(h.remove(child)));
 }
 
+TEST_P(HierarchyTest, InheritedValuesFollowParentsOnUpdate)
+{
+    auto h = create_hierarchy();
+    auto root = make_opacity(0.5f);
+    auto a = make_opacity(0.5f);
+    auto b = make_opacity(1.f);
+    auto sibling = make_opacity(0.25f);
+    h.set_root(root);
+    h.add(root, a);
+    h.add(a, b);
+    h.add(root, sibling);
+
+    ASSERT_EQ(inherit_opacity(h), ReturnValue::Success);
+    EXPECT_FLOAT_EQ(world(root), 0.5f);
+    EXPECT_FLOAT_EQ(world(a), 0.25f);
+    EXPECT_FLOAT_EQ(world(b), 0.25f);
+    EXPECT_FLOAT_EQ(world(sibling), 0.125f);
+
+    // Only the changed subtree is recomputed, once per update().
+    instance().update();
+    set_opacity(a, 1.f);
+    set_opacity(a, 0.8f);
+    EXPECT_FLOAT_EQ(world(b), 0.25f);
+    instance().update();
+    EXPECT_FLOAT_EQ(world(a), 0.4f);
+    EXPECT_FLOAT_EQ(world(b), 0.4f);
+    EXPECT_FLOAT_EQ(world(sibling), 0.125f);
+    EXPECT_EQ(instance().get_update_stats().bindingsEvaluated, 2u);
+
+    set_opacity(root, 1.f);
+    instance().update();
+    EXPECT_FLOAT_EQ(world(b), 0.8f);
+    EXPECT_FLOAT_EQ(world(sibling), 0.25f);
+    EXPECT_EQ(instance().get_update_stats().bindingsEvaluated, 4u);
+
+    EXPECT_EQ(h.remove_inherited("world_opacity"), ReturnValue::Success);
+    EXPECT_EQ(h.remove_inherited("world_opacity"), ReturnValue::NothingToDo);
+    set_opacity(root, 0.5f);
+    instance().update();
+    EXPECT_FLOAT_EQ(world(root), 1.f);
+    EXPECT_FLOAT_EQ(world(b), 0.8f);
+}
+
+TEST_P(HierarchyTest, InheritedValuesFollowStructure)
+{
+    auto h = create_hierarchy();
+    auto root = make_opacity(0.5f);
+    h.set_root(root);
+    ASSERT_EQ(inherit_opacity(h), ReturnValue::Success);
+
+    auto a = make_opacity(0.5f);
+    auto plain = make_obj();
+    auto b = make_opacity(0.5f);
+    h.add(root, a);
+    h.add(a, plain);
+    h.add(plain, b);
+    EXPECT_FLOAT_EQ(world(a), 0.25f);
+    // The parent of b has no world_opacity, so b starts over from its own opacity.
+    EXPECT_FLOAT_EQ(world(b), 0.5f);
+
+    std::vector<IObject::Ptr> batch{make_opacity(0.5f), make_opacity(0.5f)};
+    std::vector<uint32_t> parents{IHierarchy::OUTER_PARENT, 0};
+    h.add_subtree(a, {batch.data(), batch.size()}, {parents.data(), parents.size()});
+    EXPECT_FLOAT_EQ(world(batch[1]), 0.0625f);
+
+    // Replacing a rebinds its children to the replacement; their descendants follow on update().
+    auto c = make_opacity(1.f);
+    h.replace(a, c);
+    EXPECT_FLOAT_EQ(world(c), 0.5f);
+    EXPECT_FLOAT_EQ(world(batch[0]), 0.25f);
+    instance().update();
+    EXPECT_FLOAT_EQ(world(batch[1]), 0.125f);
+
+    // Removed objects no longer follow their former parent.
+    h.remove(batch[0]);
+    set_opacity(root, 1.f);
+    instance().update();
+    EXPECT_FLOAT_EQ(world(c), 1.f);
+    EXPECT_FLOAT_EQ(world(batch[1]), 0.125f);
+
+    EXPECT_EQ(h.add_inherited("opacity", "opacity", [](float p, float l) { return p * l; }),
+              ReturnValue::InvalidArgument);
+    EXPECT_EQ(h.add_inherited("", "world_opacity", [](float p, float l) { return p * l; }),
+              ReturnValue::InvalidArgument);
+}
+
 // ============================================================
 // Event tests (on_changing / on_changed)
 // ============================================================
@@ -957,7 +1624,10 @@ protected:
     }
 };
 
-TEST_F(EventHierarchyTest, OnChangedFiresOnSetRoot)
+INSTANTIATE_TEST_SUITE_P(Impl, EventHierarchyTest,
+                         ::testing::Values(ClassId::Hierarchy, ClassId::FlatHierarchy), hierarchy_name);
+
+TEST_P(EventHierarchyTest, OnChangedFiresOnSetRoot)
 {
     auto h = create_hierarchy();
     subscribe(h);
@@ -974,7 +1644,7 @@ TEST_F(EventHierarchyTest, OnChangedFiresOnSetRoot)
     EXPECT_EQ(records[1].change.child, root);
 }
 
-TEST_F(EventHierarchyTest, OnChangedFiresOnAdd)
+TEST_P(EventHierarchyTest, OnChangedFiresOnAdd)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -993,7 +1663,84 @@ TEST_F(EventHierarchyTest, OnChangedFiresOnAdd)
     EXPECT_EQ(records[1].change.type, HierarchyChange::Type::Add);
 }
 
-TEST_F(EventHierarchyTest, OnChangedFiresOnInsert)
+TEST_P(EventHierarchyTest, AddChildrenFiresOneBatchEvent)
+{
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    h.set_root(root);
+    subscribe(h);
+
+    std::vector<IObject::Ptr> batch{make_obj(), make_obj(), make_obj()};
+    h.add_children(root, {batch.data(), batch.size()});
+
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_TRUE(records[0].is_pre);
+    EXPECT_FALSE(records[1].is_pre);
+    for (auto& record : records) {
+        EXPECT_EQ(record.change.type, HierarchyChange::Type::AddBatch);
+        EXPECT_EQ(record.change.parent, root);
+        EXPECT_EQ(record.change.children.begin(), batch.data());
+        EXPECT_EQ(record.change.children.size(), 3u);
+    }
+}
+
+TEST_P(EventHierarchyTest, BatchFiresOnceWithAllChanges)
+{
+    auto h = create_hierarchy();
+    auto root = make_obj();
+    auto a = make_obj();
+    h.set_root(root);
+    h.add(root, a);
+    subscribe(h);
+
+    std::vector<HierarchyChange> delivered;
+    std::vector<IObject::Ptr> added;
+    auto* ih = interface_cast<IHierarchy>(h.get());
+    ih->on_changed().add_handler(create_callback([&](const HierarchyChange& change) {
+        if (change.type == HierarchyChange::Type::Batch) {
+            // The views are only valid during the event.
+            delivered.assign(change.changes.begin(), change.changes.end());
+            for (auto& c : change.changes) {
+                added.insert(added.end(), c.children.begin(), c.children.end());
+            }
+        }
+    }));
+
+    auto b = make_obj();
+    std::vector<IObject::Ptr> batch{make_obj(), make_obj()};
+    {
+        auto outer = h.batch();
+        h.add(a, b);
+        {
+            auto inner = h.batch();
+            h.add_children(root, {batch.data(), batch.size()});
+        }
+        EXPECT_TRUE(records.empty());
+        h.remove(a);
+    }
+
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_FALSE(records[0].is_pre);
+    EXPECT_EQ(records[0].change.type, HierarchyChange::Type::Batch);
+    ASSERT_EQ(delivered.size(), 3u);
+    EXPECT_EQ(delivered[0].type, HierarchyChange::Type::Add);
+    EXPECT_EQ(delivered[0].parent, a);
+    EXPECT_EQ(delivered[0].child, b);
+    EXPECT_EQ(delivered[1].type, HierarchyChange::Type::AddBatch);
+    EXPECT_EQ(added, batch);
+    EXPECT_EQ(delivered[2].type, HierarchyChange::Type::Remove);
+    EXPECT_EQ(delivered[2].child, a);
+
+    // An empty batch fires nothing, and events fire per mutation again after it.
+    records.clear();
+    h.batch().end();
+    EXPECT_TRUE(records.empty());
+    EXPECT_EQ(ih->end_batch(), ReturnValue::NothingToDo);
+    h.add(root, make_obj());
+    EXPECT_EQ(records.size(), 2u);
+}
+
+TEST_P(EventHierarchyTest, OnChangedFiresOnInsert)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -1012,7 +1759,7 @@ TEST_F(EventHierarchyTest, OnChangedFiresOnInsert)
     EXPECT_FALSE(records[1].is_pre);
 }
 
-TEST_F(EventHierarchyTest, OnChangedFiresOnRemove)
+TEST_P(EventHierarchyTest, OnChangedFiresOnRemove)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -1032,7 +1779,7 @@ TEST_F(EventHierarchyTest, OnChangedFiresOnRemove)
     EXPECT_EQ(records[1].change.type, HierarchyChange::Type::Remove);
 }
 
-TEST_F(EventHierarchyTest, OnChangedFiresOnReplace)
+TEST_P(EventHierarchyTest, OnChangedFiresOnReplace)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -1054,7 +1801,7 @@ TEST_F(EventHierarchyTest, OnChangedFiresOnReplace)
     EXPECT_EQ(records[1].change.type, HierarchyChange::Type::Replace);
 }
 
-TEST_F(EventHierarchyTest, OnChangedFiresOnClear)
+TEST_P(EventHierarchyTest, OnChangedFiresOnClear)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -1070,7 +1817,7 @@ TEST_F(EventHierarchyTest, OnChangedFiresOnClear)
     EXPECT_EQ(records[1].change.type, HierarchyChange::Type::Clear);
 }
 
-TEST_F(EventHierarchyTest, OnChangingFiresBeforeMutation)
+TEST_P(EventHierarchyTest, OnChangingFiresBeforeMutation)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -1091,7 +1838,7 @@ TEST_F(EventHierarchyTest, OnChangingFiresBeforeMutation)
     EXPECT_EQ(h.size(), 2u);
 }
 
-TEST_F(EventHierarchyTest, NoEventOnVetoedOperation)
+TEST_P(EventHierarchyTest, NoEventOnVetoedOperation)
 {
     auto h = create_hierarchy();
     subscribe(h);
@@ -1105,7 +1852,7 @@ TEST_F(EventHierarchyTest, NoEventOnVetoedOperation)
     EXPECT_EQ(records.size(), 0u);
 }
 
-TEST_F(EventHierarchyTest, RemoveFiresOnceForSubtree)
+TEST_P(EventHierarchyTest, RemoveFiresOnceForSubtree)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -1128,7 +1875,7 @@ TEST_F(EventHierarchyTest, RemoveFiresOnceForSubtree)
     EXPECT_EQ(records[1].change.child, parent);
 }
 
-TEST_F(EventHierarchyTest, NoEventWhenNoHandlers)
+TEST_P(EventHierarchyTest, NoEventWhenNoHandlers)
 {
     auto h = create_hierarchy();
     auto root = make_obj();
@@ -1141,7 +1888,7 @@ TEST_F(EventHierarchyTest, NoEventWhenNoHandlers)
     EXPECT_EQ(h.size(), 2u);
 }
 
-TEST_F(EventHierarchyTest, OnChangingBeforeOnChanged)
+TEST_P(EventHierarchyTest, OnChangingBeforeOnChanged)
 {
     auto h = create_hierarchy();
     subscribe(h);
@@ -1,11 +1,19 @@
+#include <velk/api/callback.h>
 #include <velk/api/hive/hive.h>
+#include <velk/api/state.h>
 #include <velk/api/velk.h>
 #include <velk/ext/object.h>
 #include <velk/interface/hive/intf_hive_store.h>
 #include <velk/interface/intf_metadata.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
 #include <gtest/gtest.h>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace velk;
@@ -36,6 +44,101 @@ public:
 class HiveGadget : public ext::Object<HiveGadget, IObjectHiveGadget>
 {};
 
+// A class with both States, matched by queries over either interface.
+class HiveWidgetGadget : public ext::Object<HiveWidgetGadget, IObjectHiveWidget, IObjectHiveGadget>
+{};
+
+// Executor that runs each task on its own std::thread.
+class ThreadExecutor : public ext::ObjectCore<ThreadExecutor, IExecutor>
+{
+public:
+    size_t get_concurrency() const override { return 4; }
+    void parallel_for(size_t count, void* context, TaskFn task) override
+    {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([=] { task(context, i); });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        calls += count;
+    }
+    size_t calls{};
+};
+
+// Executor binding task i to NUMA node i, running the tasks one after another.
+class SequentialNumaExecutor : public ext::ObjectCore<SequentialNumaExecutor, INumaExecutor>
+{
+public:
+    size_t get_concurrency() const override { return 2; }
+    void parallel_for(size_t count, void* context, TaskFn task) override
+    {
+        for (size_t i = 0; i < count; ++i) {
+            current_task = i;
+            task(context, i);
+        }
+    }
+    int get_task_node(size_t index) const override { return static_cast<int>(index); }
+    size_t current_task{};
+};
+
+// NUMA page source reporting its pages alternately on nodes 1 and 0.
+class AlternatingNumaPageSource : public ext::ObjectCore<AlternatingNumaPageSource, INumaPageSource>
+{
+public:
+    void* allocate_page(size_t size, size_t alignment) override
+    {
+        void* page = inner->allocate_page(size, alignment);
+        pages.push_back({static_cast<char*>(page), size, static_cast<int>(pages.size() % 2 == 0)});
+        return page;
+    }
+    void free_page(void* page, size_t size) override { inner->free_page(page, size); }
+    ReturnValue set_policy(NumaPolicy, int) override { return ReturnValue::Fail; }
+    NumaPolicy get_policy() const override { return NumaPolicy::Node; }
+    int get_node() const override { return 0; }
+    size_t get_node_count() const override { return 2; }
+    int get_page_node(const void* page, size_t) const override { return node_of(page); }
+
+    int node_of(const void* ptr) const
+    {
+        for (auto& p : pages) {
+            if (ptr >= p.mem && ptr < p.mem + p.size) {
+                return p.node;
+            }
+        }
+        return -1;
+    }
+
+    struct Page
+    {
+        char* mem;
+        size_t size;
+        int node;
+    };
+    std::vector<Page> pages;
+    IHivePageSource::Ptr inner = instance().create<IHivePageSource>(ClassId::VirtualMemoryPageSource);
+};
+
+// Page source that counts the pages it hands out.
+class CountingPageSource : public ext::ObjectCore<CountingPageSource, IHivePageSource>
+{
+public:
+    void* allocate_page(size_t size, size_t alignment) override
+    {
+        ++allocated;
+        return inner->allocate_page(size, alignment);
+    }
+    void free_page(void* page, size_t size) override
+    {
+        ++freed;
+        inner->free_page(page, size);
+    }
+    IHivePageSource::Ptr inner = instance().create<IHivePageSource>(ClassId::VirtualMemoryPageSource);
+    std::atomic<int> allocated{0};
+    std::atomic<int> freed{0};
+};
+
 // --- Test fixture ---
 
 class HiveTest : public ::testing::Test
@@ -47,6 +150,7 @@ protected:
     {
         register_type<HiveWidget>(velk_);
         register_type<HiveGadget>(velk_);
+        register_type<HiveWidgetGadget>(velk_);
         registry_ = velk_.create<IHiveStore>(ClassId::HiveStore);
         ASSERT_TRUE(registry_);
     }
@@ -54,6 +158,7 @@ protected:
     void TearDown() override
     {
         registry_.reset();
+        unregister_type<HiveWidgetGadget>(velk_);
         unregister_type<HiveGadget>(velk_);
         unregister_type<HiveWidget>(velk_);
     }
@@ -130,6 +235,42 @@ TEST_F(HiveTest, NewHiveIsEmpty)
     EXPECT_EQ(0u, hive->size());
 }
 
+TEST_F(HiveTest, QueryJoinsStatesAcrossHives)
+{
+    ObjectHive<> widgets(*registry_, HiveWidget::class_id());
+    ObjectHive<> combos(*registry_, HiveWidgetGadget::class_id());
+    registry_->get_raw_hive(Uid{"cb6f4ea2-7a3f-4e12-9b1c-5d0e8f2a6b37"}, 16, 8);
+    for (int i = 0; i < 10; ++i) {
+        interface_cast<IObjectHiveWidget>(widgets.add())->x().set_value(1.f);
+        auto combo = combos.add();
+        interface_cast<IObjectHiveWidget>(combo)->x().set_value(static_cast<float>(i));
+        interface_cast<IObjectHiveGadget>(combo)->id().set_value(i);
+    }
+
+    HiveQuery<IObjectHiveWidget, IObjectHiveGadget> both(*registry_);
+    EXPECT_EQ(1u, both.hive_count());
+    int checked = 0;
+    EXPECT_EQ(10u, both.for_each([&](IObject& obj, IObjectHiveWidget::State& w, IObjectHiveGadget::State& g) {
+        EXPECT_EQ(HiveWidgetGadget::class_id(), obj.get_class_uid());
+        EXPECT_EQ(static_cast<float>(g.id), w.x);
+        w.x += 1.f;
+        ++checked;
+    }));
+    EXPECT_EQ(10, checked);
+    EXPECT_EQ(3u, both.for_each([&](IObject&, IObjectHiveWidget::State&, IObjectHiveGadget::State& g) {
+        return g.id < 2;
+    }));
+
+    // A hive created after the first search is picked up.
+    HiveQuery<IObjectHiveWidget> widget_states(*registry_);
+    EXPECT_EQ(2u, widget_states.hive_count());
+    HiveQuery<IObjectHiveGadget> gadget_states(*registry_);
+    EXPECT_EQ(1u, gadget_states.hive_count());
+    ObjectHive<>(fresh_hive()).add();
+    EXPECT_EQ(11u, gadget_states.for_each([](IObject&, IObjectHiveGadget::State&) {}));
+    EXPECT_EQ(2u, gadget_states.hive_count());
+}
+
 TEST_F(HiveTest, ElementClassUid)
 {
     auto hive = fresh_hive();
@@ -218,6 +359,96 @@ TEST_F(HiveTest, ObjectSurvivesRemoveWhileReferenced)
     EXPECT_EQ(HiveGadget::class_id(), held->get_class_uid());
 }
 
+TEST_F(HiveTest, MembershipChangesAreBatchedPerUpdate)
+{
+    auto hive = fresh_hive();
+    hive->clear();
+    auto a = hive->add();
+
+    std::vector<std::pair<std::vector<IObject*>, std::vector<IObject*>>> changes;
+    Event(hive->on_membership_changed()).add_handler(create_callback([&](const HiveMembershipChange& change) {
+        EXPECT_EQ(hive.get(), change.hive);
+        std::vector<IObject*> added, removed;
+        for (auto& obj : change.added) {
+            added.push_back(obj.get());
+        }
+        for (auto& obj : change.removed) {
+            removed.push_back(obj.get());
+        }
+        changes.emplace_back(added, removed);
+    }));
+
+    // Changes before the event was created are not reported.
+    instance().update();
+    EXPECT_TRUE(changes.empty());
+
+    IObject::Ptr more[2];
+    auto b = hive->add();
+    hive->add_n(2, more);
+    IObject* removed_a = a.get();
+    hive->remove(*a);
+    a.reset();
+    hive->remove(*more[0]);
+    EXPECT_TRUE(changes.empty());
+
+    instance().update();
+    ASSERT_EQ(1u, changes.size());
+    EXPECT_EQ((std::vector<IObject*>{b.get(), more[0].get(), more[1].get()}), changes[0].first);
+    // The removed object is delivered alive although nothing else holds it.
+    EXPECT_EQ((std::vector<IObject*>{removed_a, more[0].get()}), changes[0].second);
+
+    hive->clear();
+    instance().update();
+    ASSERT_EQ(2u, changes.size());
+    EXPECT_TRUE(changes[1].first.empty());
+    EXPECT_EQ(2u, changes[1].second.size());
+
+    instance().update();
+    EXPECT_EQ(2u, changes.size());
+}
+
+TEST_F(HiveTest, SingleThreadedHiveSkipsLocking)
+{
+    auto hive = fresh_hive();
+    hive->clear();
+    EXPECT_EQ(HiveThreading::MultiThread, hive->get_threading());
+    EXPECT_EQ(ReturnValue::Success, hive->set_threading(HiveThreading::SingleThread));
+    EXPECT_EQ(HiveThreading::SingleThread, hive->get_threading());
+
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 10; ++i) {
+        objs.push_back(hive->add());
+    }
+    hive->remove(*objs[3]);
+    objs.erase(objs.begin() + 3);
+    EXPECT_EQ(9u, hive->size());
+
+    size_t visited = 0;
+    hive->for_each(&visited, [](void* ctx, IObject&) -> bool {
+        ++*static_cast<size_t*>(ctx);
+        return true;
+    });
+    EXPECT_EQ(9u, visited);
+    EXPECT_TRUE(hive->contains(*objs[0]));
+
+    // The slot of a removed object that is still referenced is reclaimed without locking too.
+    IObject::Ptr zombie = objs.back();
+    objs.pop_back();
+    hive->remove(*zombie);
+    zombie.reset();
+    EXPECT_EQ(8u, hive->size());
+
+    hive->clear();
+    EXPECT_EQ(0u, hive->size());
+    EXPECT_EQ(ReturnValue::Success, hive->set_threading(HiveThreading::MultiThread));
+    EXPECT_EQ(HiveThreading::MultiThread, hive->get_threading());
+
+    auto partitioned = registry_->get_partitioned_hive<HiveWidget>(2);
+    ASSERT_TRUE(partitioned);
+    EXPECT_EQ(ReturnValue::Refused, partitioned->set_threading(HiveThreading::SingleThread));
+    EXPECT_EQ(HiveThreading::MultiThread, partitioned->get_threading());
+}
+
 TEST_F(HiveTest, SlotReuse)
 {
     auto hive = fresh_hive();
@@ -237,6 +468,131 @@ TEST_F(HiveTest, SlotReuse)
     EXPECT_TRUE(hive->contains(*obj4));
 }
 
+TEST_F(HiveTest, ContainsResolvesObjectsAcrossManyPages)
+{
+    auto hive = fresh_hive();
+    HivePageCapacity capacity;
+    capacity.page_1 = 8;
+    capacity.page_2 = 8;
+    capacity.page_3 = 8;
+    capacity.page_n = 8;
+    hive->set_page_capacity(capacity);
+
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 200; ++i) {
+        objs.push_back(hive->add());
+    }
+    EXPECT_EQ(25u, hive->get_stats().pages);
+    for (int i = 0; i < 200; i += 2) {
+        EXPECT_EQ(ReturnValue::Success, hive->remove(*objs[i]));
+    }
+    for (int i = 0; i < 200; ++i) {
+        EXPECT_EQ(i % 2 != 0, hive->contains(*objs[i]));
+    }
+}
+
+TEST_F(HiveTest, HandleResolvesToObject)
+{
+    auto hive = fresh_hive();
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 100; ++i) {
+        objs.push_back(hive->add());
+    }
+    for (auto& obj : objs) {
+        auto handle = hive->get_handle(*obj);
+        ASSERT_TRUE(handle);
+        EXPECT_EQ(obj.get(), hive->resolve(handle));
+    }
+    EXPECT_NE(hive->get_handle(*objs[0]), hive->get_handle(*objs[1]));
+
+    auto standalone = velk_.create<IObject>(HiveGadget::class_id());
+    EXPECT_FALSE(hive->get_handle(*standalone));
+    EXPECT_EQ(nullptr, hive->resolve(HiveHandle{}));
+}
+
+TEST_F(HiveTest, HandleIsStaleAfterRemove)
+{
+    auto hive = fresh_hive();
+    auto obj = hive->add();
+    auto handle = hive->get_handle(*obj);
+    hive->remove(*obj);
+    EXPECT_EQ(nullptr, hive->resolve(handle));
+
+    // The object reusing the slot has a new generation.
+    obj.reset();
+    auto reused = hive->add();
+    auto reused_handle = hive->get_handle(*reused);
+    EXPECT_EQ(handle.page(), reused_handle.page());
+    EXPECT_EQ(handle.slot(), reused_handle.slot());
+    EXPECT_NE(handle.generation(), reused_handle.generation());
+    EXPECT_EQ(nullptr, hive->resolve(handle));
+    EXPECT_EQ(reused.get(), hive->resolve(reused_handle));
+}
+
+TEST_F(HiveTest, HandleIsStaleAfterClearAndCompact)
+{
+    auto hive = fresh_hive();
+    std::vector<HiveHandle> handles;
+    for (int i = 0; i < 10; ++i) {
+        handles.push_back(hive->get_handle(*hive->add()));
+    }
+    hive->clear();
+    hive->compact();
+    EXPECT_EQ(0u, hive->get_stats().pages);
+
+    // A new page takes over the released page id, past the generations it issued.
+    auto obj = hive->add();
+    EXPECT_EQ(handles[0].page(), hive->get_handle(*obj).page());
+    for (auto handle : handles) {
+        EXPECT_EQ(nullptr, hive->resolve(handle));
+    }
+}
+
+TEST_F(HiveTest, TypedHandleResolvesState)
+{
+    ObjectHive<> hive(*registry_, HiveWidget::class_id());
+    auto widget = hive.add();
+    interface_cast<IObjectHiveWidget>(widget)->x().set_value(4.f);
+    auto handle = hive.get_handle(*widget);
+    EXPECT_EQ(widget.get(), hive.resolve(handle));
+    auto* state = hive.resolve_state<IObjectHiveWidget>(handle);
+    ASSERT_NE(nullptr, state);
+    EXPECT_EQ(4.f, state->x);
+
+    hive.remove(*widget);
+    EXPECT_EQ(nullptr, hive.resolve(handle));
+    EXPECT_EQ(nullptr, hive.resolve_state<IObjectHiveWidget>(handle));
+}
+
+TEST_F(HiveTest, PartitionedHiveHandles)
+{
+    auto hive = registry_->get_partitioned_hive<HiveGadget>(3);
+    ASSERT_TRUE(hive);
+    std::vector<IObject::Ptr> objs;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 20; ++i) {
+                auto obj = hive->add();
+                std::lock_guard<std::mutex> lock(mutex);
+                objs.push_back(obj);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (auto& obj : objs) {
+        auto handle = hive->get_handle(*obj);
+        ASSERT_TRUE(handle);
+        EXPECT_EQ(obj.get(), hive->resolve(handle));
+    }
+    auto handle = hive->get_handle(*objs[0]);
+    hive->remove(*objs[0]);
+    EXPECT_EQ(nullptr, hive->resolve(handle));
+}
+
 TEST_F(HiveTest, ForEachVisitsAllLiveObjects)
 {
     auto hive = fresh_hive();
@@ -370,6 +726,113 @@ TEST_F(HiveTest, ZombieToFreeTransition)
     EXPECT_EQ(1u, hive->size());
 }
 
+TEST_F(HiveTest, WeakRefToDeadObjectOutlivesHive)
+{
+    // A weak_ptr to a destroyed object keeps its page alive after the hive is gone.
+    auto hive = fresh_hive();
+    auto obj = hive->add();
+    IObject::WeakPtr weak = obj;
+    hive->remove(*obj);
+    obj.reset();
+    EXPECT_TRUE(weak.expired());
+
+    hive.reset();
+    registry_.reset();
+    EXPECT_TRUE(weak.expired());
+    EXPECT_FALSE(weak.lock());
+    weak = IObject::WeakPtr();
+}
+
+TEST_F(HiveTest, StatsReportPagesAndZombies)
+{
+    auto hive = fresh_hive();
+    HiveStats empty = hive->get_stats();
+    EXPECT_EQ(0u, empty.pages);
+    EXPECT_EQ(0.0, empty.fragmentation());
+
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 20; ++i) {
+        objs.push_back(hive->add());
+    }
+    hive->remove(*objs[0]); // Zombie: still referenced.
+    hive->remove(*objs[1]);
+    objs[1] = nullptr;      // Destroyed: its slot is free.
+
+    HiveStats stats = hive->get_stats();
+    EXPECT_EQ(2u, stats.pages); // 16 + 64 slots
+    EXPECT_EQ(80u, stats.capacity);
+    EXPECT_EQ(18u, stats.live);
+    EXPECT_EQ(1u, stats.zombies);
+    EXPECT_EQ(61u, stats.free_slots);
+    EXPECT_EQ(61u, stats.fragmented_slots);
+    EXPECT_GT(stats.reserved_bytes, 80u * sizeof(void*));
+    EXPECT_DOUBLE_EQ(61.0 / 80.0, stats.fragmentation());
+
+    // The store sums its hives and counts pages orphaned by destroyed hives.
+    RawHive<int64_t> raw(*registry_);
+    raw.emplace(1);
+    HiveStats total = registry_->get_stats();
+    EXPECT_EQ(3u, total.pages);
+    EXPECT_EQ(19u, total.live);
+    EXPECT_EQ(61u + 15u, total.fragmented_slots);
+    EXPECT_EQ(0u, total.orphaned_pages);
+
+    objs.erase(objs.begin() + 1, objs.end());
+    hive.reset();
+    registry_.reset();
+    auto store = velk_.create<IHiveStore>(ClassId::HiveStore);
+    EXPECT_EQ(1u, store->get_stats().orphaned_pages); // The zombie keeps its page.
+    objs.clear();
+    EXPECT_EQ(0u, store->get_stats().orphaned_pages);
+}
+
+TEST_F(HiveTest, LargeOrphanedPagesAreFreedOnThreadPool)
+{
+    auto pool = velk_.create_thread_pool(1);
+    velk_.set_thread_pool(pool);
+    IObject::Ptr held;
+    {
+        auto hive = fresh_hive();
+        hive->reserve(8192);
+        held = hive->add();
+    }
+    registry_.reset(); // The held object orphans its page.
+
+    auto before = velk_.get_memory_stats()[MemoryCategory::HivePages].bytes;
+    held.reset();
+    EXPECT_EQ(0u, velk_.create<IHiveStore>(ClassId::HiveStore)->get_stats().orphaned_pages);
+    EXPECT_EQ(before, velk_.get_memory_stats()[MemoryCategory::HivePages].bytes);
+
+    // update() posts the reclamation; releasing the pool runs it before joining its worker.
+    velk_.update();
+    velk_.set_thread_pool(nullptr);
+    pool.reset();
+    auto after = velk_.get_memory_stats()[MemoryCategory::HivePages].bytes;
+    EXPECT_GE(before - after, 64u * 1024);
+}
+
+TEST_F(HiveTest, LargeOrphanedPageReleasedDuringTeardownIsFreedInPlace)
+{
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    EXPECT_EXIT(
+        {
+            // A built-in class, whose factory outlives the instance unlike those of the test types.
+            IObject::Ptr held;
+            {
+                auto hive = registry_->get_hive(ClassId::Future);
+                hive->reserve(8192);
+                held = hive->add();
+            }
+            registry_.reset(); // The held object orphans its page.
+
+            // A deferred call that never runs keeps the object until the instance is destroyed.
+            Callback([held](FnArgs) -> ReturnValue { return ReturnValue::Success; }).invoke({}, Deferred);
+            held.reset();
+            std::exit(0);
+        },
+        ::testing::ExitedWithCode(0), "");
+}
+
 TEST_F(HiveTest, FillAndEmptyPage)
 {
     // Fill the first page (16 slots), then remove all objects.
@@ -396,6 +859,24 @@ TEST_F(HiveTest, FillAndEmptyPage)
     EXPECT_EQ(1u, hive->size());
 }
 
+TEST_F(HiveTest, AddReusesFreedSlotInEarlierPage)
+{
+    // Fill the first two pages (16 + 64 slots) exactly, so the current page is full.
+    auto hive = fresh_hive();
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 80; ++i) {
+        objs.push_back(hive->add());
+    }
+    IObject* first = objs[3].get();
+    hive->remove(*objs[3]);
+    objs[3].reset();
+
+    // The freed slot on the first page is found without allocating a new page.
+    auto obj = hive->add();
+    EXPECT_EQ(first, obj.get());
+    EXPECT_EQ(80u, hive->size());
+}
+
 TEST_F(HiveTest, GetSelfWorksForHiveObjects)
 {
     auto hive = fresh_hive();
@@ -436,7 +917,7 @@ TEST_F(HiveTest, ForEachStateVisitsAllWithCorrectValues)
         refs.push_back(std::move(obj));
     }
 
-    ptrdiff_t offset = detail::compute_state_offset(*hive, IObjectHiveWidget::UID);
+    ptrdiff_t offset = hive->get_state_offset(IObjectHiveWidget::UID);
     ASSERT_GE(offset, 0);
 
     float sum_x = 0.f;
@@ -462,7 +943,7 @@ TEST_F(HiveTest, ForEachStateEarlyTermination)
         refs.push_back(hive->add());
     }
 
-    ptrdiff_t offset = detail::compute_state_offset(*hive, IObjectHiveGadget::UID);
+    ptrdiff_t offset = hive->get_state_offset(IObjectHiveGadget::UID);
     ASSERT_GE(offset, 0);
 
     int count = 0;
@@ -486,6 +967,19 @@ TEST_F(HiveTest, ForEachStateEmptyHive)
     EXPECT_EQ(0, count);
 }
 
+TEST_F(HiveTest, StateOffsetKnownBeforeFirstAdd)
+{
+    auto hive = registry_->get_hive(HiveWidget::class_id());
+    ASSERT_TRUE(hive->empty());
+    ptrdiff_t offset = hive->get_state_offset(IObjectHiveWidget::UID);
+    ASSERT_GT(offset, 0);
+    EXPECT_EQ(-1, hive->get_state_offset(IObjectHiveGadget::UID));
+
+    auto obj = hive->add();
+    auto* state = interface_cast<IPropertyState>(obj)->get_property_state<IObjectHiveWidget>();
+    EXPECT_EQ(reinterpret_cast<char*>(obj.get()) + offset, reinterpret_cast<char*>(state));
+}
+
 TEST_F(HiveTest, ForEachHiveTypedAccess)
 {
     auto hive = registry_->get_hive(HiveWidget::class_id());
@@ -525,6 +1019,412 @@ TEST_F(HiveTest, ForEachHiveOnEmptyHive)
     EXPECT_EQ(0, count);
 }
 
+TEST_F(HiveTest, AddNCreatesObjects)
+{
+    ObjectHive<> hive(registry_->get_hive(HiveWidget::class_id()));
+    auto first = hive.add();
+    auto objs = hive.add_n(1000);
+    ASSERT_EQ(1000u, objs.size());
+    EXPECT_EQ(1001u, hive.size());
+    for (auto& obj : objs) {
+        ASSERT_TRUE(obj);
+        EXPECT_TRUE(hive.contains(*obj));
+    }
+    // The shortfall of 985 slots is covered by a single page, carved in address order.
+    auto stride = reinterpret_cast<char*>(objs[1].get()) - reinterpret_cast<char*>(objs[0].get());
+    auto* base = reinterpret_cast<char*>(objs[0].get());
+    EXPECT_EQ(stride * 984, reinterpret_cast<char*>(objs[984].get()) - base);
+
+    // Freed slots are reused before new pages are allocated.
+    for (size_t i = 0; i < 10; ++i) {
+        hive.remove(*objs[i]);
+        objs[i] = nullptr;
+    }
+    auto more = hive.add_n(10);
+    ASSERT_EQ(10u, more.size());
+    EXPECT_EQ(1001u, hive.size());
+    EXPECT_EQ(0u, hive.raw().add_n(0, nullptr));
+    EXPECT_EQ(5u, hive.raw().add_n(5, nullptr));
+    EXPECT_EQ(1006u, hive.size());
+}
+
+TEST_F(HiveTest, PageSourceBacksNewPages)
+{
+    auto source = ext::make_object<CountingPageSource, IHivePageSource>();
+    auto* counter = static_cast<CountingPageSource*>(source.get());
+    auto hive = fresh_hive();
+    auto heap_obj = hive->add(); // Allocated from the heap, before the source is set.
+    hive->set_page_source(source);
+    EXPECT_EQ(source, hive->get_page_source());
+
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 100; ++i) {
+        objs.push_back(hive->add());
+    }
+    EXPECT_EQ(2, counter->allocated.load()); // The 64 and 256 slot pages.
+    size_t count = 0;
+    hive->for_each(&count, [](void* ctx, IObject&) -> bool {
+        ++*static_cast<size_t*>(ctx);
+        return true;
+    });
+    EXPECT_EQ(101u, count);
+
+    // A weakly referenced dead object keeps its page, and the source, alive past the hive.
+    IObject::WeakPtr weak = objs.back();
+    objs.clear();
+    hive->clear();
+    hive.reset();
+    registry_.reset();
+    EXPECT_EQ(1, counter->freed.load());
+    weak = IObject::WeakPtr();
+    EXPECT_EQ(2, counter->freed.load());
+}
+
+TEST_F(HiveTest, ReserveAllocatesSinglePage)
+{
+    ObjectHive<> hive(registry_->get_hive(HiveWidget::class_id()));
+    EXPECT_EQ(ReturnValue::Success, hive.reserve(1000));
+    EXPECT_EQ(ReturnValue::NothingToDo, hive.reserve(1000));
+    EXPECT_TRUE(hive.empty());
+
+    // All reserved slots come from one page instead of the 16/64/256/1024 ramp.
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 1000; ++i) {
+        objs.push_back(hive.add());
+    }
+    auto stride = reinterpret_cast<char*>(objs[1].get()) - reinterpret_cast<char*>(objs[0].get());
+    auto* base = reinterpret_cast<char*>(objs[0].get());
+    EXPECT_EQ(stride * 999, reinterpret_cast<char*>(objs[999].get()) - base);
+    EXPECT_EQ(ReturnValue::Success, hive.reserve(1));
+}
+
+TEST_F(HiveTest, StateColumnStoresStatesContiguously)
+{
+    auto hive = registry_->get_hive(HiveWidget::class_id());
+    ObjectHive<> typed(hive);
+    EXPECT_EQ(ReturnValue::Success, typed.add_state_column<IObjectHiveWidget>());
+    EXPECT_EQ(ReturnValue::NothingToDo, typed.add_state_column<IObjectHiveWidget>());
+    EXPECT_TRUE(hive->has_state_column(IObjectHiveWidget::UID));
+    EXPECT_EQ(ReturnValue::InvalidArgument, ObjectHive<>(fresh_hive()).add_state_column<IObjectHiveWidget>());
+
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 100; ++i) {
+        auto obj = hive->add();
+        // Writes through the property system land in the column.
+        interface_cast<IObjectHiveWidget>(obj)->x().set_value(static_cast<float>(i));
+        objs.push_back(std::move(obj));
+    }
+    EXPECT_EQ(ReturnValue::Fail, hive->add_state_column(IObjectHiveGadget::UID, sizeof(int), alignof(int)));
+
+    auto* s0 = interface_cast<IPropertyState>(objs[0])->get_property_state<IObjectHiveWidget>();
+    auto* s1 = interface_cast<IPropertyState>(objs[1])->get_property_state<IObjectHiveWidget>();
+    EXPECT_EQ(s0 + 1, s1);
+    EXPECT_FLOAT_EQ(1.f, s1->x);
+    hive->remove(*objs[1]);
+
+    float sum = 0.f;
+    size_t visited = 0;
+    typed.for_each_column<IObjectHiveWidget>(
+        [&](IObjectHiveWidget::State* states, const uint64_t* active_bits, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                if (active_bits[i / 64] & (uint64_t(1) << (i % 64))) {
+                    sum += states[i].x;
+                    ++visited;
+                }
+            }
+            return true;
+        });
+    EXPECT_EQ(99u, visited);
+    EXPECT_FLOAT_EQ(4949.f, sum); // 0 + 2 + 3 + ... + 99
+
+    ThreadExecutor executor;
+    std::atomic<size_t> parallel_visited{0};
+    typed.for_each_parallel<IObjectHiveWidget>(&executor, [&](IObject& obj, IObjectHiveWidget::State& state) {
+        EXPECT_EQ(&state, interface_cast<IPropertyState>(&obj)->get_property_state<IObjectHiveWidget>());
+        ++parallel_visited;
+        return true;
+    });
+    EXPECT_EQ(99u, parallel_visited.load());
+
+    // Slot 1 was removed, so the first page splits into two runs.
+    std::vector<size_t> runs;
+    sum = 0.f;
+    typed.for_each_column_run<IObjectHiveWidget>([&](IObjectHiveWidget::State* states, size_t count) {
+        runs.push_back(count);
+        for (size_t i = 0; i < count; ++i) {
+            sum += states[i].x;
+        }
+        return true;
+    });
+    EXPECT_EQ((std::vector<size_t>{1, 14, 64, 20}), runs);
+    EXPECT_FLOAT_EQ(4949.f, sum);
+}
+
+TEST_F(HiveTest, DoubleBufferedStatePublishesOnSwap)
+{
+    auto hive = registry_->get_hive(HiveWidget::class_id());
+    ObjectHive<> typed(hive);
+    EXPECT_EQ(ReturnValue::Success, typed.add_state_column<IObjectHiveWidget>());
+    EXPECT_EQ(ReturnValue::Success, typed.add_double_buffered_state<IObjectHiveWidget>());
+    EXPECT_EQ(ReturnValue::NothingToDo, typed.add_double_buffered_state<IObjectHiveWidget>());
+    EXPECT_TRUE(hive->has_state_column(IObjectHiveWidget::UID));
+
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 10; ++i) {
+        objs.push_back(hive->add());
+    }
+    EXPECT_EQ(ReturnValue::Fail, typed.add_double_buffered_state<IObjectHiveGadget>());
+
+    auto front_sum = [&] {
+        float sum = 0.f;
+        typed.for_each_front<IObjectHiveWidget>([&](IObject&, const IObjectHiveWidget::State& state) {
+            sum += state.x;
+            return true;
+        });
+        return sum;
+    };
+    // New objects are visible to readers before the first swap.
+    EXPECT_FLOAT_EQ(0.f, front_sum());
+
+    for (size_t i = 0; i < objs.size(); ++i) {
+        interface_cast<IObjectHiveWidget>(objs[i])->x().set_value(static_cast<float>(i));
+    }
+    // Writes land in the back column, which readers do not see until the swap.
+    EXPECT_FLOAT_EQ(1.f, read_state<IObjectHiveWidget>(objs[1].get())->x);
+    EXPECT_FLOAT_EQ(0.f, front_sum());
+    typed.swap_state_buffers();
+    EXPECT_FLOAT_EQ(45.f, front_sum());
+
+    interface_cast<IObjectHiveWidget>(objs[9])->x().set_value(0.f);
+    EXPECT_FLOAT_EQ(45.f, front_sum());
+    typed.swap_state_buffers();
+    EXPECT_FLOAT_EQ(36.f, front_sum());
+
+    ThreadExecutor executor;
+    std::atomic<size_t> visited{0};
+    typed.for_each_front_parallel<IObjectHiveWidget>(&executor,
+                                                     [&](IObject&, const IObjectHiveWidget::State&) {
+                                                         ++visited;
+                                                         return true;
+                                                     });
+    EXPECT_EQ(10u, visited.load());
+}
+
+TEST_F(HiveTest, DirtyTrackingVisitsChangedObjects)
+{
+    auto hive = registry_->get_hive(HiveWidget::class_id());
+    ObjectHive<> typed(hive);
+    EXPECT_EQ(ReturnValue::Success, typed.add_dirty_tracking<IObjectHiveWidget>());
+    EXPECT_EQ(ReturnValue::NothingToDo, typed.add_dirty_tracking<IObjectHiveWidget>());
+    EXPECT_TRUE(hive->has_dirty_tracking(IObjectHiveWidget::UID));
+    EXPECT_EQ(ReturnValue::InvalidArgument,
+              ObjectHive<>(fresh_hive()).add_dirty_tracking<IObjectHiveWidget>());
+
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 100; ++i) {
+        objs.push_back(hive->add());
+    }
+    EXPECT_EQ(ReturnValue::Fail, hive->add_dirty_tracking(IObjectHiveGadget::UID));
+    auto widget = [&](size_t i) { return interface_cast<IObjectHiveWidget>(objs[i]); };
+
+    // New objects start dirty.
+    EXPECT_EQ(100u, typed.for_each_dirty<IObjectHiveWidget>([](IObject&, IObjectHiveWidget::State&) {}));
+    EXPECT_EQ(0u, typed.for_each_dirty<IObjectHiveWidget>([](IObject&, IObjectHiveWidget::State&) {}));
+
+    widget(70)->y().set_value(2.f, Deferred);
+    widget(3)->x().set_value(1.f);
+    widget(5)->x().set_value(0.f); // Unchanged, fires nothing.
+    write_state<IObjectHiveWidget>(widget(42), [](IObjectHiveWidget::State& s) { s.x = 4.f; });
+    widget(90)->x().set_value(9.f);
+    hive->remove(*objs[90]);
+    instance().update();
+
+    std::vector<IObject*> dirty;
+    EXPECT_EQ(3u, typed.for_each_dirty<IObjectHiveWidget>([&](IObject& obj, IObjectHiveWidget::State& state) {
+        EXPECT_EQ(&state, interface_cast<IPropertyState>(&obj)->get_property_state<IObjectHiveWidget>());
+        dirty.push_back(&obj);
+    }));
+    EXPECT_EQ((std::vector<IObject*>{objs[3].get(), objs[42].get(), objs[70].get()}), dirty);
+
+    // Marks of objects not visited before the visitor stops are kept.
+    widget(1)->x().set_value(1.f);
+    widget(2)->x().set_value(2.f);
+    EXPECT_EQ(1u, typed.for_each_dirty<IObjectHiveWidget>([](IObject&, IObjectHiveWidget::State&) {
+        return false;
+    }));
+    dirty.clear();
+    typed.for_each_dirty<IObjectHiveWidget>([&](IObject& obj, IObjectHiveWidget::State&) {
+        dirty.push_back(&obj);
+    });
+    EXPECT_EQ((std::vector<IObject*>{objs[2].get()}), dirty);
+}
+
+TEST_F(HiveTest, ChangeJournalRecordsLatestValues)
+{
+    auto hive = registry_->get_hive(HiveWidget::class_id());
+    ObjectHive<> typed(hive);
+    EXPECT_EQ(ReturnValue::Success, typed.add_change_journal<IObjectHiveWidget>());
+    EXPECT_EQ(ReturnValue::NothingToDo, typed.add_change_journal<IObjectHiveWidget>());
+    EXPECT_EQ(ReturnValue::Success, typed.add_dirty_tracking<IObjectHiveWidget>());
+
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 100; ++i) {
+        objs.push_back(hive->add());
+    }
+    EXPECT_EQ(ReturnValue::Fail, typed.add_change_journal<IObjectHiveGadget>());
+
+    // New objects carry only the changes made after construction.
+    auto journal = typed.write_changes<IObjectHiveWidget>();
+    EXPECT_EQ(sizeof(HiveJournalHeader), journal.size());
+    EXPECT_EQ(0u,
+              for_each_change(journal.data(), journal.size(), [](HiveHandle, uint32_t, const void*, size_t) {}));
+
+    auto* w = interface_cast<IObjectHiveWidget>(objs[7]);
+    w->x().set_value(1.f);
+    w->x().set_value(2.f);
+    write_state<IObjectHiveWidget>(interface_cast<IObjectHiveWidget>(objs[3]),
+                                   [](IObjectHiveWidget::State& s) { s.y = 5.f; });
+    // A write that is undone before the journal is written is not a change.
+    interface_cast<IObjectHiveWidget>(objs[9])->x().set_value(1.f);
+    interface_cast<IObjectHiveWidget>(objs[9])->x().set_value(0.f);
+
+    // Each float record is padded to 8 bytes.
+    constexpr size_t record_size = sizeof(HiveJournalRecord) + 8;
+    EXPECT_EQ(sizeof(HiveJournalHeader) + 2 * record_size, hive->write_changes(IObjectHiveWidget::UID, nullptr, 0));
+    journal = typed.write_changes<IObjectHiveWidget>();
+
+    // Replay the journal onto replicas of the objects.
+    std::vector<IObjectHiveWidget::State> replicas(objs.size());
+    auto apply = [&](HiveHandle handle, uint32_t member, const void* value, size_t size) {
+        auto* obj = hive->resolve(handle);
+        ASSERT_NE(nullptr, obj);
+        size_t i = 0;
+        while (objs[i].get() != obj) {
+            ++i;
+        }
+        EXPECT_TRUE(apply_change<IObjectHiveWidget>(replicas[i], member, value, size));
+    };
+    size_t applied = for_each_change(journal.data(), journal.size(), apply);
+    EXPECT_EQ(2u, applied);
+    EXPECT_FLOAT_EQ(2.f, replicas[7].x);
+    EXPECT_FLOAT_EQ(0.f, replicas[7].y);
+    EXPECT_FLOAT_EQ(5.f, replicas[3].y);
+    EXPECT_FLOAT_EQ(0.f, replicas[9].x);
+    EXPECT_FALSE(apply_change<IObjectHiveWidget>(replicas[0], 5, nullptr, 4));
+
+    // Journaling does not consume the marks of dirty tracking.
+    EXPECT_EQ(100u, typed.for_each_dirty<IObjectHiveWidget>([](IObject&, IObjectHiveWidget::State&) {}));
+    EXPECT_EQ(sizeof(HiveJournalHeader), typed.write_changes<IObjectHiveWidget>().size());
+
+    // A buffer that is too small leaves the changes for the next call.
+    w->y().set_value(3.f);
+    char small[sizeof(HiveJournalHeader)];
+    EXPECT_EQ(sizeof(HiveJournalHeader) + record_size,
+              hive->write_changes(IObjectHiveWidget::UID, small, sizeof(small)));
+    EXPECT_EQ(0u, for_each_change(small, sizeof(small), [](HiveHandle, uint32_t, const void*, size_t) {}));
+    EXPECT_EQ(sizeof(HiveJournalHeader) + record_size, typed.write_changes<IObjectHiveWidget>().size());
+}
+
+TEST_F(HiveTest, HashIndexFollowsPropertyWrites)
+{
+    ObjectHive<> hive(*registry_, HiveWidget::class_id());
+    EXPECT_EQ(ReturnValue::Success, hive.add_index<IObjectHiveWidget>(&IObjectHiveWidget::State::x));
+    EXPECT_EQ(ReturnValue::NothingToDo, hive.add_index<IObjectHiveWidget>(&IObjectHiveWidget::State::x));
+    EXPECT_FALSE(hive.raw().has_dirty_tracking(IObjectHiveWidget::UID));
+
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 100; ++i) {
+        auto obj = hive.add();
+        interface_cast<IObjectHiveWidget>(obj)->x().set_value(static_cast<float>(i % 4));
+        objs.push_back(obj);
+    }
+    EXPECT_EQ(ReturnValue::Fail, hive.add_index<IObjectHiveWidget>(&IObjectHiveWidget::State::y));
+    auto count = [&](float x) {
+        return hive.find<IObjectHiveWidget>(&IObjectHiveWidget::State::x, x,
+                                            [&](IObject&, IObjectHiveWidget::State& state) {
+                                                EXPECT_EQ(x, state.x);
+                                            });
+    };
+    EXPECT_EQ(25u, count(3.f));
+    EXPECT_EQ(25u, count(0.f));
+    EXPECT_EQ(0u, count(7.f));
+
+    interface_cast<IObjectHiveWidget>(objs[0])->x().set_value(3.f);
+    write_state<IObjectHiveWidget>(interface_cast<IObjectHiveWidget>(objs[4]), [](IObjectHiveWidget::State& s) {
+        s.x = 7.f;
+    });
+    EXPECT_EQ(26u, count(3.f));
+    EXPECT_EQ(23u, count(0.f));
+    EXPECT_EQ(1u, count(7.f));
+
+    hive.remove(*objs[3]);
+    EXPECT_EQ(25u, count(3.f));
+    hive.clear();
+    EXPECT_EQ(0u, count(3.f));
+    // Range lookups need a Sorted index.
+    EXPECT_EQ(0u, hive.find_range<IObjectHiveWidget>(&IObjectHiveWidget::State::x, 0.f, 3.f,
+                                                     [](IObject&, IObjectHiveWidget::State&) {}));
+}
+
+TEST_F(HiveTest, SortedIndexVisitsRangeInOrder)
+{
+    ObjectHive<> hive(*registry_, HiveWidget::class_id());
+    ASSERT_EQ(ReturnValue::Success,
+              hive.add_index<IObjectHiveWidget>(&IObjectHiveWidget::State::y, HiveIndexType::Sorted));
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 200; ++i) {
+        auto obj = hive.add();
+        // Negative values sort before positive ones.
+        interface_cast<IObjectHiveWidget>(obj)->y().set_value(static_cast<float>((i * 7) % 200 - 100));
+        objs.push_back(obj);
+    }
+    std::vector<float> found;
+    auto range = [&](float first, float last) {
+        found.clear();
+        return hive.find_range<IObjectHiveWidget>(&IObjectHiveWidget::State::y, first, last,
+                                                  [&](IObject&, IObjectHiveWidget::State& state) {
+                                                      found.push_back(state.y);
+                                                  });
+    };
+    EXPECT_EQ(10u, range(-5.f, 4.5f));
+    EXPECT_EQ((std::vector<float>{-5.f, -4.f, -3.f, -2.f, -1.f, 0.f, 1.f, 2.f, 3.f, 4.f}), found);
+
+    interface_cast<IObjectHiveWidget>(objs[0])->y().set_value(-0.5f);
+    EXPECT_EQ(2u, range(-1.f, -0.25f));
+    EXPECT_EQ((std::vector<float>{-1.f, -0.5f}), found);
+
+    // A lookup stops with the visitor, and -0 and 0 are the same key.
+    EXPECT_EQ(1u, hive.find<IObjectHiveWidget>(&IObjectHiveWidget::State::y, -20.f,
+                                               [](IObject&, IObjectHiveWidget::State&) { return false; }));
+    interface_cast<IObjectHiveWidget>(objs[1])->y().set_value(-0.f);
+    EXPECT_EQ(2u, range(0.f, 0.f)); // objs[1] and objs[100]
+
+    // Objects of released pages leave the index.
+    objs.clear();
+    hive.clear();
+    hive.compact();
+    auto obj = hive.add();
+    EXPECT_EQ(1u, range(0.f, 0.f));
+}
+
+TEST_F(HiveTest, ForEachActiveRunMergesWords)
+{
+    uint64_t bits[3] = {~uint64_t(0) << 60, ~uint64_t(0), 0x5};
+    HivePageView view{nullptr, 1, bits, 192};
+    std::vector<std::pair<size_t, size_t>> runs;
+    EXPECT_TRUE(for_each_active_run(view, [&](size_t first, size_t count) {
+        runs.emplace_back(first, count);
+        return true;
+    }));
+    using Run = std::pair<size_t, size_t>;
+    EXPECT_EQ((std::vector<Run>{{60, 69}, {130, 1}}), runs);
+
+    // Stopping early skips the remaining runs.
+    size_t calls = 0;
+    EXPECT_FALSE(for_each_active_run(view, [&](size_t, size_t) { return ++calls < 2; }));
+    EXPECT_EQ(2u, calls);
+}
+
 // --- IRawHive tests ---
 
 struct RawPoint
@@ -649,6 +1549,622 @@ TEST_F(HiveTest, RawHiveSlotReuse)
     hive->deallocate(slot3);
 }
 
+TEST_F(HiveTest, RawHiveDeallocateAcrossManyPages)
+{
+    auto hive = registry_->get_raw_hive<RawPoint>();
+    std::vector<void*> slots;
+    for (int i = 0; i < 3000; ++i) {
+        slots.push_back(new (hive->allocate()) RawPoint(static_cast<float>(i), 0.f, 0.f));
+    }
+    for (auto* s : slots) {
+        EXPECT_TRUE(hive->contains(s));
+        // Misaligned pointers inside a slot are not slots.
+        EXPECT_FALSE(hive->contains(static_cast<char*>(s) + 1));
+    }
+
+    // Free every other slot, in reverse page order.
+    for (size_t i = slots.size(); i-- > 0;) {
+        if (i % 2) {
+            hive->deallocate(slots[i]);
+        }
+    }
+    EXPECT_EQ(1500u, hive->size());
+    for (size_t i = 0; i < slots.size(); ++i) {
+        EXPECT_EQ(i % 2 == 0, hive->contains(slots[i]));
+    }
+
+    for (size_t i = 0; i < slots.size(); i += 2) {
+        hive->deallocate(slots[i]);
+    }
+    EXPECT_TRUE(hive->empty());
+}
+
+TEST_F(HiveTest, RawHiveAllocateReusesFreedSlotInEarlierPage)
+{
+    auto hive = registry_->get_raw_hive<RawPoint>();
+    std::vector<void*> slots;
+    for (int i = 0; i < 80; ++i) {
+        slots.push_back(hive->allocate());
+    }
+    hive->deallocate(slots[5]);
+    EXPECT_EQ(slots[5], hive->allocate());
+
+    for (auto* s : slots) {
+        hive->deallocate(s);
+    }
+    EXPECT_TRUE(hive->empty());
+}
+
+TEST_F(HiveTest, ForEachStateParallelVisitsAll)
+{
+    ObjectHive<> hive(*registry_, HiveWidget::class_id());
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 2000; ++i) {
+        objs.push_back(hive.add());
+    }
+    for (size_t i = 0; i < objs.size(); i += 3) {
+        hive.remove(*objs[i]);
+    }
+
+    auto exec = ext::make_object<ThreadExecutor, IExecutor>();
+    std::atomic<int> count{0};
+    hive.for_each_parallel<IObjectHiveWidget>(exec.get(), [&](IObject&, IObjectHiveWidget::State& s) {
+        s.x = 1.f;
+        count.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    });
+    EXPECT_EQ(static_cast<int>(hive.size()), count.load());
+    EXPECT_EQ(4u, static_cast<ThreadExecutor*>(exec.get())->calls);
+
+    int written = 0;
+    hive.for_each<IObjectHiveWidget>([&](IObject&, IObjectHiveWidget::State& s) {
+        written += s.x == 1.f;
+        return true;
+    });
+    EXPECT_EQ(count.load(), written);
+}
+
+TEST_F(HiveTest, RawHiveForEachParallel)
+{
+    RawHive<RawPoint> hive(*registry_);
+    for (int i = 0; i < 3000; ++i) {
+        hive.emplace(1.f, 0.f, 0.f);
+    }
+    auto exec = ext::make_object<ThreadExecutor, IExecutor>();
+    std::atomic<int> count{0};
+    hive.for_each_parallel(exec.get(), [&](RawPoint& p) { count.fetch_add(static_cast<int>(p.x)); });
+    EXPECT_EQ(3000, count.load());
+
+    // Without an executor the iteration runs on the calling thread.
+    int serial = 0;
+    hive.for_each_parallel(nullptr, [&](RawPoint&) { ++serial; });
+    EXPECT_EQ(3000, serial);
+}
+
+TEST_F(HiveTest, ForEachPageVisitsPageViews)
+{
+    RawHive<RawPoint> hive(*registry_);
+    std::vector<RawPoint*> pts;
+    for (int i = 0; i < 100; ++i) {
+        pts.push_back(hive.emplace(float(i), 0.f, 0.f));
+    }
+    hive.deallocate(pts[3]);
+
+    // Pages of 16, 64 and 256 slots; the last one is partly used.
+    struct Ctx
+    {
+        size_t pages = 0;
+        size_t live = 0;
+        float sum = 0.f;
+    } ctx;
+    hive.raw().for_each_page(
+        &ctx,
+        [](void* c, const HivePageView& page) -> bool {
+            auto& ctx = *static_cast<Ctx*>(c);
+            EXPECT_EQ(sizeof(RawPoint), page.stride);
+            ++ctx.pages;
+            for_each_active_slot(page, [&](size_t i) {
+                ++ctx.live;
+                ctx.sum += page_view_at<RawPoint>(page, i)->x;
+                return true;
+            });
+            return true;
+        },
+        nullptr);
+    EXPECT_EQ(3u, ctx.pages);
+    EXPECT_EQ(99u, ctx.live);
+    EXPECT_FLOAT_EQ(4950.f - 3.f, ctx.sum);
+
+    // Early stop from the typed wrapper ends the iteration.
+    int visited = 0;
+    hive.for_each([&](RawPoint&) { return ++visited < 20; });
+    EXPECT_EQ(20, visited);
+
+    // Object hive pages hold the objects, IObject first.
+    auto objects = fresh_hive();
+    auto obj = objects->add();
+    objects->for_each_page(
+        obj.get(),
+        [](void* c, const HivePageView& page) -> bool {
+            EXPECT_EQ(c, page_view_at<IObject>(page, 0));
+            EXPECT_EQ(1u, page.active_bits[0]);
+            return true;
+        },
+        nullptr);
+}
+
+TEST_F(HiveTest, RawHiveForEachRun)
+{
+    RawHive<RawPoint> hive(*registry_);
+    std::vector<RawPoint*> pts;
+    for (int i = 0; i < 80; ++i) {
+        pts.push_back(hive.emplace(1.f, 0.f, 0.f));
+    }
+    hive.deallocate(pts[20]);
+    hive.deallocate(pts[21]);
+
+    // Pages of 16 and 64 slots; the hole splits the second page.
+    std::vector<size_t> runs;
+    float sum = 0.f;
+    hive.for_each_run([&](RawPoint* first, size_t count) {
+        EXPECT_TRUE(hive.contains(first + count - 1));
+        runs.push_back(count);
+        for (size_t i = 0; i < count; ++i) {
+            sum += first[i].x;
+        }
+    });
+    EXPECT_EQ((std::vector<size_t>{16, 4, 58}), runs);
+    EXPECT_FLOAT_EQ(78.f, sum);
+
+    auto exec = ext::make_object<ThreadExecutor, IExecutor>();
+    std::atomic<size_t> total{0};
+    hive.for_each_run_parallel(exec.get(), [&](RawPoint*, size_t count) { total += count; });
+    EXPECT_EQ(78u, total.load());
+}
+
+TEST_F(HiveTest, RawHiveMagazineKeepsActiveBitsAuthoritative)
+{
+    auto hive = registry_->get_raw_hive<RawPoint>();
+    hive->set_magazine_size(8);
+    EXPECT_EQ(8u, hive->get_magazine_size());
+
+    std::vector<void*> slots;
+    for (int i = 0; i < 20; ++i) {
+        slots.push_back(hive->allocate());
+    }
+    EXPECT_EQ(20u, hive->size());
+    for (int i = 0; i < 10; ++i) {
+        hive->deallocate(slots[i]);
+        EXPECT_FALSE(hive->contains(slots[i]));
+    }
+    EXPECT_EQ(10u, hive->size());
+
+    // Cached slots are not active and are never visited.
+    int count = 0;
+    hive->for_each(&count, [](void* ctx, void*) -> bool {
+        ++(*static_cast<int*>(ctx));
+        return true;
+    });
+    EXPECT_EQ(10, count);
+
+    // Recently freed slots are served from the magazine.
+    void* reused = hive->allocate();
+    EXPECT_NE(slots.begin() + 10, std::find(slots.begin(), slots.begin() + 10, reused));
+    hive->deallocate(reused);
+
+    hive->flush_magazines();
+    EXPECT_EQ(10u, hive->size());
+    hive->set_magazine_size(0);
+    for (int i = 10; i < 20; ++i) {
+        hive->deallocate(slots[i]);
+    }
+    EXPECT_TRUE(hive->empty());
+}
+
+TEST_F(HiveTest, RawHiveMagazineConcurrentChurn)
+{
+    auto hive = registry_->get_raw_hive<RawPoint>();
+    hive->set_magazine_size(16);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            std::vector<void*> slots;
+            for (int round = 0; round < 50; ++round) {
+                for (int i = 0; i < 40; ++i) {
+                    slots.push_back(hive->allocate());
+                }
+                for (auto* s : slots) {
+                    hive->deallocate(s);
+                }
+                slots.clear();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_TRUE(hive->empty());
+}
+
+TEST_F(HiveTest, ObjectHiveCompactReleasesEmptyPages)
+{
+    auto hive = fresh_hive();
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 100; ++i) {
+        objs.push_back(hive->add());
+    }
+    EXPECT_EQ(0u, hive->compact());
+
+    // Empty the first page (16 slots); keep a weak ref to one object of the second page.
+    for (int i = 0; i < 16; ++i) {
+        hive->remove(*objs[i]);
+        objs[i].reset();
+    }
+    IObject::WeakPtr weak = objs[20];
+    for (int i = 16; i < 80; ++i) {
+        hive->remove(*objs[i]);
+        objs[i].reset();
+    }
+    EXPECT_EQ(20u, hive->size());
+
+    // The second page is empty but still weakly referenced.
+    EXPECT_EQ(1u, hive->compact());
+    weak = IObject::WeakPtr();
+    EXPECT_EQ(1u, hive->compact());
+
+    int count = 0;
+    hive->for_each(&count, [](void* ctx, IObject&) -> bool {
+        ++(*static_cast<int*>(ctx));
+        return true;
+    });
+    EXPECT_EQ(20, count);
+    for (int i = 80; i < 100; ++i) {
+        EXPECT_TRUE(hive->contains(*objs[i]));
+    }
+    EXPECT_TRUE(hive->add());
+}
+
+TEST_F(HiveTest, ObjectHiveTrimKeepsFreeSlots)
+{
+    auto hive = fresh_hive();
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 100; ++i) { // Pages of 16, 64 and 256 slots.
+        objs.push_back(hive->add());
+    }
+    EXPECT_EQ(0u, hive->trim(0));
+
+    for (int i = 0; i < 16; ++i) {
+        hive->remove(*objs[i]);
+        objs[i].reset();
+    }
+    // Releasing the empty first page would leave 236 free slots.
+    EXPECT_EQ(0u, hive->trim(237));
+    EXPECT_EQ(1u, hive->trim(236));
+
+    // Automatic trimming releases the second page once it empties.
+    HivePageCapacity capacity;
+    capacity.max_free_slots = 64;
+    hive->set_page_capacity(capacity);
+    for (int i = 16; i < 80; ++i) {
+        hive->remove(*objs[i]);
+        objs[i].reset();
+    }
+    EXPECT_EQ(0u, hive->trim(0));
+    EXPECT_EQ(20u, hive->size());
+    for (int i = 80; i < 100; ++i) {
+        EXPECT_TRUE(hive->contains(*objs[i]));
+    }
+    EXPECT_TRUE(hive->add());
+}
+
+TEST_F(HiveTest, AdaptivePageGrowthDoublesUpToMaxPageBytes)
+{
+    RawHive<RawPoint> hive(*registry_);
+    HivePageCapacity capacity;
+    capacity.growth = HivePageGrowth::Adaptive;
+    capacity.max_page_bytes = 4096 * sizeof(RawPoint);
+    hive.raw().set_page_capacity(capacity);
+
+    // Pages of 16, 16, 32, ... 2048 double the hive, then stay at 4096 elements.
+    std::vector<RawPoint*> pts;
+    for (int i = 0; i < 20000; ++i) {
+        pts.push_back(hive.emplace(static_cast<float>(i), 0.f, 0.f));
+    }
+    auto stats = hive.raw().get_stats();
+    EXPECT_EQ(13u, stats.pages);
+    EXPECT_EQ(20480u, stats.capacity);
+
+    // After shrinking, the hive grows back towards its peak with the largest page.
+    for (auto* p : pts) {
+        hive.deallocate(p);
+    }
+    hive.raw().trim(0);
+    EXPECT_EQ(0u, hive.raw().get_stats().pages);
+    hive.emplace(0.f, 0.f, 0.f);
+    EXPECT_EQ(4096u, hive.raw().get_stats().capacity);
+}
+
+TEST_F(HiveTest, RawHiveCompactMovesElements)
+{
+    RawHive<RawPoint> hive(*registry_);
+    std::vector<RawPoint*> pts;
+    for (int i = 0; i < 400; ++i) {
+        pts.push_back(hive.emplace(static_cast<float>(i), 0.f, 0.f));
+    }
+    // Keep every 10th element, spread across all pages.
+    std::vector<RawPoint*> kept;
+    for (int i = 0; i < 400; ++i) {
+        if (i % 10) {
+            hive.deallocate(pts[i]);
+        } else {
+            kept.push_back(pts[i]);
+        }
+    }
+
+    size_t moved = 0;
+    size_t freed = hive.compact([&](RawPoint* old_ptr, RawPoint* new_ptr) {
+        auto it = std::find(kept.begin(), kept.end(), old_ptr);
+        ASSERT_NE(kept.end(), it);
+        *it = new_ptr;
+        ++moved;
+    });
+    EXPECT_GT(freed, 0u);
+    EXPECT_GT(moved, 0u);
+    EXPECT_EQ(40u, hive.size());
+
+    float sum = 0.f;
+    for (auto* p : kept) {
+        EXPECT_TRUE(hive.contains(p));
+        sum += p->x;
+    }
+    EXPECT_FLOAT_EQ(7800.f, sum); // 0 + 10 + ... + 390
+    EXPECT_EQ(0u, hive.compact());
+}
+
+TEST_F(HiveTest, RawHiveSortByOrdersIteration)
+{
+    RawHive<RawPoint> hive(*registry_);
+    std::vector<RawPoint*> pts;
+    for (int i = 0; i < 400; ++i) {
+        pts.push_back(hive.emplace(static_cast<float>((i * 37) % 400), 0.f, 0.f));
+    }
+    // Leave every other element, so sorting also frees pages.
+    std::vector<RawPoint*> kept;
+    for (size_t i = 0; i < pts.size(); ++i) {
+        if (i % 2) {
+            hive.deallocate(pts[i]);
+        } else {
+            kept.push_back(pts[i]);
+        }
+    }
+    size_t pages = hive.raw().get_stats().pages;
+
+    size_t relocated = 0;
+    size_t moved = hive.sort_by([](const RawPoint& p) { return p.x; },
+                                [&](RawPoint* old_ptr, RawPoint* new_ptr) {
+                                    auto it = std::find(kept.begin(), kept.end(), old_ptr);
+                                    ASSERT_NE(kept.end(), it);
+                                    *it = new_ptr;
+                                    ++relocated;
+                                });
+    EXPECT_EQ(moved, relocated);
+    EXPECT_EQ(200u, hive.size());
+    EXPECT_LT(hive.raw().get_stats().pages, pages);
+    for (auto* p : kept) {
+        EXPECT_TRUE(hive.contains(p));
+    }
+
+    std::vector<float> order;
+    hive.for_each([&](RawPoint& p) { order.push_back(p.x); });
+    ASSERT_EQ(200u, order.size());
+    EXPECT_TRUE(std::is_sorted(order.begin(), order.end()));
+    size_t runs = 0;
+    hive.for_each_run([&](RawPoint*, size_t) { ++runs; });
+    EXPECT_EQ(1u, runs);
+
+    // Already in order: nothing moves, and new elements still fit.
+    EXPECT_EQ(0u, hive.sort_by([](const RawPoint& p) { return p.x; }));
+    EXPECT_TRUE(hive.contains(hive.emplace(0.f, 0.f, 0.f)));
+    EXPECT_EQ(201u, hive.size());
+}
+
+TEST_F(HiveTest, RawHiveAllocateN)
+{
+    RawHive<RawPoint> hive(*registry_);
+    hive.emplace(0.f, 0.f, 0.f);
+    std::vector<RawPoint*> pts(500);
+    ASSERT_EQ(500u, hive.emplace_n(pts.size(), pts.data(), 1.f, 2.f, 3.f));
+    EXPECT_EQ(501u, hive.size());
+    for (auto* p : pts) {
+        EXPECT_TRUE(hive.contains(p));
+        EXPECT_FLOAT_EQ(2.f, p->y);
+    }
+    EXPECT_EQ(pts[0] + 484, pts[484]); // The 485 slot shortfall, in one page.
+
+    float sum = 0.f;
+    hive.for_each([&](RawPoint& p) { sum += p.x; });
+    EXPECT_FLOAT_EQ(500.f, sum);
+}
+
+TEST_F(HiveTest, VirtualMemoryPageSource)
+{
+    auto source = velk_.create<IHivePageSource>(ClassId::VirtualMemoryPageSource);
+    ASSERT_TRUE(source);
+    registry_->set_default_page_source(source);
+    EXPECT_EQ(source, registry_->get_default_page_source());
+
+    RawHive<RawPoint> hive(*registry_);
+    EXPECT_EQ(source, hive.raw().get_page_source());
+    hive.reserve(100000); // Spans several huge pages.
+    std::vector<RawPoint*> pts;
+    for (int i = 0; i < 1000; ++i) {
+        pts.push_back(hive.emplace(float(i), 0.f, 0.f));
+    }
+    float sum = 0.f;
+    hive.for_each([&](RawPoint& p) { sum += p.x; });
+    EXPECT_FLOAT_EQ(499500.f, sum);
+
+    auto* mem = static_cast<char*>(source->allocate_page(100, 4096 * 4));
+    ASSERT_TRUE(mem);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(mem) % (4096 * 4));
+    mem[99] = 1;
+    source->free_page(mem, 100);
+}
+
+TEST_F(HiveTest, NumaPageSourcePolicies)
+{
+    auto source = velk_.create<INumaPageSource>(ClassId::NumaPageSource);
+    ASSERT_TRUE(source);
+    size_t nodes = source->get_node_count();
+    ASSERT_GE(nodes, 1u);
+    EXPECT_EQ(NumaPolicy::Local, source->get_policy());
+    EXPECT_EQ(ReturnValue::InvalidArgument, source->set_policy(NumaPolicy::Node, static_cast<int>(nodes)));
+    EXPECT_EQ(ReturnValue::InvalidArgument, source->set_policy(NumaPolicy::Node, -1));
+
+    RawHive<RawPoint> hive(*registry_);
+    hive.raw().set_page_source(interface_pointer_cast<IHivePageSource>(source));
+    float expected = 0.f;
+    for (auto policy : {NumaPolicy::Interleave, NumaPolicy::Node, NumaPolicy::Local}) {
+        int node = policy == NumaPolicy::Node ? static_cast<int>(nodes) - 1 : 0;
+        EXPECT_EQ(ReturnValue::Success, source->set_policy(policy, node));
+        EXPECT_EQ(ReturnValue::NothingToDo, source->set_policy(policy, node));
+        EXPECT_EQ(policy, source->get_policy());
+        EXPECT_EQ(node, source->get_node());
+
+        auto* mem = static_cast<char*>(source->allocate_page(1 << 16, 64));
+        ASSERT_TRUE(mem);
+        mem[(1 << 16) - 1] = 1;
+        int page_node = source->get_page_node(mem, 1 << 16);
+        EXPECT_LT(page_node, static_cast<int>(nodes));
+        if (policy == NumaPolicy::Node) {
+            EXPECT_EQ(node, page_node);
+        }
+        source->free_page(mem, 1 << 16);
+
+        for (int i = 0; i < 300; ++i) {
+            hive.emplace(1.f, 0.f, 0.f);
+            expected += 1.f;
+        }
+    }
+    float sum = 0.f;
+    hive.for_each([&](RawPoint& p) { sum += p.x; });
+    EXPECT_FLOAT_EQ(expected, sum);
+}
+
+TEST_F(HiveTest, ParallelIterationPrefersExecutorNode)
+{
+    auto source = ext::make_object<AlternatingNumaPageSource, IHivePageSource>();
+    auto* numa = static_cast<AlternatingNumaPageSource*>(source.get());
+    RawHive<RawPoint> hive(*registry_);
+    hive.raw().set_page_source(source);
+    HivePageCapacity capacity;
+    capacity.page_1 = 64;
+    capacity.page_2 = 64;
+    capacity.page_3 = 64;
+    capacity.page_n = 64;
+    hive.raw().set_page_capacity(capacity);
+    for (int i = 0; i < 64 * 8; ++i) {
+        hive.emplace(static_cast<float>(i), 0.f, 0.f);
+    }
+    ASSERT_EQ(8u, numa->pages.size());
+
+    // Task 0 runs first on node 0, so it drains the node 0 pages before helping with node 1.
+    auto exec = ext::make_object<SequentialNumaExecutor, IExecutor>();
+    auto* executor = static_cast<SequentialNumaExecutor*>(exec.get());
+    std::vector<int> nodes;
+    hive.for_each_parallel(exec.get(), [&](RawPoint& p) {
+        EXPECT_EQ(0u, executor->current_task);
+        nodes.push_back(numa->node_of(&p));
+    });
+    ASSERT_EQ(64u * 8, nodes.size());
+    EXPECT_TRUE(std::is_sorted(nodes.begin(), nodes.end()));
+    EXPECT_EQ(0, nodes.front());
+    EXPECT_EQ(1, nodes.back());
+}
+
+TEST_F(HiveTest, RawHiveReserve)
+{
+    RawHive<RawPoint> hive(*registry_);
+    EXPECT_EQ(ReturnValue::Success, hive.reserve(500));
+    EXPECT_EQ(ReturnValue::NothingToDo, hive.reserve(200));
+
+    std::vector<RawPoint*> pts;
+    for (int i = 0; i < 500; ++i) {
+        pts.push_back(hive.emplace(0.f, 0.f, 0.f));
+    }
+    EXPECT_EQ(pts[0] + 499, pts[499]);
+
+    // Reserved pages are released again by trim().
+    for (auto* p : pts) {
+        hive.deallocate(p);
+    }
+    EXPECT_EQ(1u, hive.trim());
+    EXPECT_EQ(ReturnValue::Success, hive.reserve(1));
+}
+
+TEST_F(HiveTest, SlotAlignmentPadsSlots)
+{
+    ObjectHive<> hive(fresh_hive());
+    EXPECT_EQ(ReturnValue::InvalidArgument, hive.set_slot_alignment(48));
+    EXPECT_EQ(ReturnValue::Success, hive.set_slot_alignment(HIVE_CACHE_LINE_SIZE));
+    EXPECT_EQ(HIVE_CACHE_LINE_SIZE, hive.raw().get_slot_alignment());
+    auto a = hive.add();
+    auto b = hive.add();
+    auto stride = reinterpret_cast<uintptr_t>(b.get()) - reinterpret_cast<uintptr_t>(a.get());
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(a.get()) % HIVE_CACHE_LINE_SIZE);
+    EXPECT_EQ(0u, stride % HIVE_CACHE_LINE_SIZE);
+    EXPECT_EQ(ReturnValue::Fail, hive.set_slot_alignment(0));
+
+    // Raw elements smaller than a cache line each get a line of their own.
+    RawHive<RawPoint> raw(*registry_);
+    EXPECT_EQ(ReturnValue::Success, raw.set_slot_alignment(HIVE_CACHE_LINE_SIZE));
+    auto* p0 = raw.emplace(1.f, 0.f, 0.f);
+    auto* p1 = raw.emplace(2.f, 0.f, 0.f);
+    EXPECT_EQ(HIVE_CACHE_LINE_SIZE, reinterpret_cast<uintptr_t>(p1) - reinterpret_cast<uintptr_t>(p0));
+    float sum = 0.f;
+    size_t runs = 0;
+    raw.for_each_run([&](RawPoint* first, size_t count) {
+        EXPECT_EQ(1u, count);
+        sum += first->x;
+        ++runs;
+    });
+    EXPECT_EQ(2u, runs);
+    EXPECT_FLOAT_EQ(3.f, sum);
+}
+
+TEST_F(HiveTest, RawHiveTrimReleasesEmptyPages)
+{
+    auto raw = registry_->get_raw_hive<RawPoint>();
+    HivePageCapacity capacity;
+    capacity.max_free_slots = 32;
+    raw->set_page_capacity(capacity);
+
+    // Pages of 16 and 64 slots, both full.
+    std::vector<void*> slots;
+    for (int i = 0; i < 80; ++i) {
+        slots.push_back(raw->allocate());
+    }
+    // Emptying the first page leaves 16 free slots: below the high-water mark.
+    for (int i = 0; i < 16; ++i) {
+        raw->deallocate(slots[i]);
+    }
+    // Emptying the second page exceeds it, which releases that page.
+    for (int i = 16; i < 80; ++i) {
+        raw->deallocate(slots[i]);
+    }
+    EXPECT_TRUE(raw->empty());
+    EXPECT_EQ(0u, raw->trim(17));
+    EXPECT_EQ(1u, raw->trim(0));
+    EXPECT_EQ(0u, raw->trim(0));
+
+    RawHive<RawPoint> hive(raw);
+    auto* pt = hive.emplace(1.f, 2.f, 3.f);
+    ASSERT_NE(nullptr, pt);
+    EXPECT_TRUE(hive.contains(pt));
+    EXPECT_EQ(1u, hive.size());
+}
+
 // --- RawHive<T> tests ---
 
 TEST_F(HiveTest, ExtRawHiveEmplace)
@@ -738,6 +2254,47 @@ TEST_F(HiveTest, ExtRawHiveClear)
     hive.deallocate(p);
 }
 
+struct CountedDestroy
+{
+    static std::atomic<int> destroyed;
+    int value;
+    explicit CountedDestroy(int v) : value(v) {}
+    ~CountedDestroy() { destroyed.fetch_add(1, std::memory_order_relaxed); }
+};
+std::atomic<int> CountedDestroy::destroyed{0};
+
+TEST_F(HiveTest, ClearParallelDestroysOnExecutor)
+{
+    RawHive<CountedDestroy> hive(*registry_);
+    for (int i = 0; i < 5000; ++i) {
+        hive.emplace(i);
+    }
+    CountedDestroy::destroyed = 0;
+    ThreadExecutor executor;
+    hive.clear_parallel(&executor, HivePageRelease::Background);
+    EXPECT_EQ(5000, CountedDestroy::destroyed.load());
+    EXPECT_GT(executor.calls, 1u);
+    EXPECT_TRUE(hive.empty());
+    EXPECT_EQ(0u, hive.raw().get_stats().pages);
+    ASSERT_TRUE(hive.emplace(1));
+    EXPECT_EQ(1u, hive.size());
+
+    // Object hives release the unused pages; the page of an externally held object stays.
+    auto objects = fresh_hive();
+    objects->clear();
+    objects->trim(0);
+    std::vector<IObject::Ptr> spawned(1000);
+    objects->add_n(spawned.size(), spawned.data());
+    IObject::Ptr held = spawned[0];
+    spawned.clear();
+    objects->clear_parallel(&executor, HivePageRelease::Immediate);
+    EXPECT_EQ(0u, objects->size());
+    EXPECT_EQ(1u, objects->get_stats().pages);
+    EXPECT_EQ(1u, objects->get_stats().zombies);
+    held.reset();
+    EXPECT_EQ(0u, objects->get_stats().zombies);
+}
+
 TEST_F(HiveTest, ExtRawHiveDestructorCleansUp)
 {
     auto raw = registry_->get_raw_hive<NonTrivial>();
@@ -776,6 +2333,283 @@ TEST_F(HiveTest, HiveStoreFindRawHive)
     ASSERT_TRUE(found);
 }
 
+TEST_F(HiveTest, HiveStoreConcurrentLookupAndCreate)
+{
+    constexpr int hive_count = 32;
+    std::vector<std::thread> threads;
+    std::vector<std::vector<IRawHive*>> seen(4, std::vector<IRawHive*>(hive_count));
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < hive_count; ++i) {
+                // Threads create the hives in different orders while others look them up.
+                int n = (i + t * 8) % hive_count;
+                Uid uid(0xfeed, static_cast<uint64_t>(n));
+                registry_->find_raw_hive(uid);
+                seen[t][n] = registry_->get_raw_hive(uid, sizeof(RawPoint), alignof(RawPoint)).get();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(static_cast<size_t>(hive_count), registry_->hive_count());
+    for (int i = 0; i < hive_count; ++i) {
+        ASSERT_NE(nullptr, seen[0][i]);
+        for (int t = 1; t < 4; ++t) {
+            EXPECT_EQ(seen[0][i], seen[t][i]);
+        }
+        EXPECT_EQ(seen[0][i], registry_->find_raw_hive(Uid(0xfeed, static_cast<uint64_t>(i))).get());
+    }
+}
+
+TEST_F(HiveTest, PartitionedHiveSpawnsFromThreads)
+{
+    auto hive = registry_->get_partitioned_hive<HiveGadget>(4);
+    ASSERT_TRUE(hive);
+    EXPECT_EQ(hive.get(), registry_->get_hive<HiveGadget>().get());
+    EXPECT_EQ(HiveType::ObjectHive, hive->get_hive_type());
+    EXPECT_EQ(HiveGadget::class_id(), hive->get_element_uid());
+
+    std::vector<std::vector<IObject::Ptr>> spawned(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 100; ++i) {
+                spawned[t].push_back(hive->add());
+            }
+            // Remove a quarter of the own objects while the other threads are still spawning.
+            for (int i = 0; i < 100; i += 4) {
+                EXPECT_EQ(ReturnValue::Success, hive->remove(*spawned[t][i]));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(300u, hive->size());
+    EXPECT_EQ(300u, hive->get_stats().live);
+
+    int visited = 0;
+    hive->for_each(&visited, [](void* ctx, IObject&) -> bool {
+        ++*static_cast<int*>(ctx);
+        return true;
+    });
+    EXPECT_EQ(300, visited);
+
+    visited = 0;
+    hive->for_each(&visited, [](void* ctx, IObject&) -> bool { return ++*static_cast<int*>(ctx) < 150; });
+    EXPECT_EQ(150, visited);
+
+    // Removal from a thread that did not add the objects is routed to their partition.
+    for (auto& objects : spawned) {
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_EQ(i % 4 != 0, hive->contains(*objects[i]));
+            EXPECT_EQ(i % 4 ? ReturnValue::Success : ReturnValue::Fail, hive->remove(*objects[i]));
+        }
+    }
+    EXPECT_TRUE(hive->empty());
+    spawned.clear();
+    EXPECT_GT(hive->compact(), 0u);
+    EXPECT_EQ(0u, hive->get_stats().pages);
+}
+
+TEST_F(HiveTest, RawHiveSnapshotRestoresDensely)
+{
+    RawHive<RawPoint> hive(*registry_);
+    std::vector<RawPoint*> pts;
+    for (int i = 0; i < 500; ++i) {
+        pts.push_back(hive.emplace(float(i), 1.f, 2.f));
+    }
+    float expected = 0.f;
+    for (int i = 0; i < 500; ++i) {
+        if (i % 3 == 0) {
+            hive.deallocate(pts[i]);
+        } else {
+            expected += float(i);
+        }
+    }
+    auto data = hive.snapshot();
+    ASSERT_GE(data.size(), sizeof(HiveSnapshotHeader));
+    auto* header = reinterpret_cast<const HiveSnapshotHeader*>(data.data());
+    EXPECT_EQ(HiveSnapshotHeader::MAGIC, header->magic);
+    EXPECT_EQ(hive.size(), header->count);
+    EXPECT_EQ(data.size(), header->size);
+    EXPECT_EQ(data.size(), hive.raw().snapshot(nullptr, 0));
+    EXPECT_EQ(data.size(), hive.raw().snapshot(data.data(), data.size() - 1));
+
+    // A second store gives an empty hive for the same type.
+    auto other_store = velk_.create<IHiveStore>(ClassId::HiveStore);
+    RawHive<RawPoint> restored(*other_store);
+    restored.emplace(-1.f, 0.f, 0.f);
+    EXPECT_EQ(ReturnValue::Success, restored.restore(data.data(), data.size()));
+    EXPECT_EQ(hive.size(), restored.size());
+
+    // The live elements are packed into a single page, in their original order.
+    size_t pages = 0;
+    size_t runs = 0;
+    restored.raw().for_each_page(
+        &pages,
+        [](void* c, const HivePageView&) -> bool {
+            ++*static_cast<size_t*>(c);
+            return true;
+        },
+        nullptr);
+    restored.for_each_run([&](RawPoint*, size_t) { ++runs; });
+    EXPECT_EQ(1u, pages);
+    EXPECT_EQ(1u, runs);
+    float sum = 0.f;
+    float last = -1.f;
+    bool ordered = true;
+    restored.for_each([&](RawPoint& p) {
+        ordered = ordered && p.x > last && p.y == 1.f && p.z == 2.f;
+        last = p.x;
+        sum += p.x;
+    });
+    EXPECT_TRUE(ordered);
+    EXPECT_FLOAT_EQ(expected, sum);
+
+    // New elements go after the restored ones.
+    ASSERT_NE(nullptr, restored.emplace(1000.f, 0.f, 0.f));
+    EXPECT_EQ(hive.size() + 1, restored.size());
+}
+
+TEST_F(HiveTest, RawHiveRestoreRejectsInvalidSnapshots)
+{
+    RawHive<RawPoint> hive(*registry_);
+    hive.emplace(1.f, 2.f, 3.f);
+    auto data = hive.snapshot();
+
+    struct Other
+    {
+        double a, b;
+    };
+    RawHive<Other> other(*registry_);
+    other.emplace(Other{4.0, 5.0});
+    EXPECT_EQ(ReturnValue::InvalidArgument, other.restore(data.data(), data.size()));
+    EXPECT_EQ(ReturnValue::InvalidArgument, hive.restore(data.data(), data.size() - 1));
+    EXPECT_EQ(ReturnValue::InvalidArgument, hive.restore(nullptr, 0));
+    auto corrupt = data;
+    reinterpret_cast<HiveSnapshotHeader*>(corrupt.data())->magic = 0;
+    EXPECT_EQ(ReturnValue::InvalidArgument, hive.restore(corrupt.data(), corrupt.size()));
+
+    // Rejected snapshots leave the hives untouched.
+    EXPECT_EQ(1u, other.size());
+    EXPECT_EQ(1u, hive.size());
+    hive.for_each([](RawPoint& p) { EXPECT_FLOAT_EQ(3.f, p.z); });
+}
+
+TEST_F(HiveTest, RawHiveAdoptsMappedSnapshot)
+{
+    RawHive<RawPoint> hive(*registry_);
+    std::vector<RawPoint*> pts;
+    for (int i = 0; i < 300; ++i) {
+        pts.push_back(hive.emplace(float(i), 1.f, 2.f));
+    }
+    hive.deallocate(pts[5]);
+    auto data = hive.snapshot();
+
+    std::string path = ::testing::TempDir() + "velk_hive_adopt.hive";
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(nullptr, file);
+    ASSERT_EQ(data.size(), std::fwrite(data.data(), 1, data.size(), file));
+    std::fclose(file);
+
+    auto mapping = velk_.create<IHiveSnapshotMapping>(ClassId::HiveSnapshotMapping);
+    ASSERT_TRUE(mapping);
+    EXPECT_EQ(ReturnValue::Fail, mapping->open((path + ".missing").c_str()));
+    ASSERT_EQ(ReturnValue::Success, mapping->open(path.c_str()));
+    EXPECT_EQ(ReturnValue::Fail, mapping->open(path.c_str()));
+    EXPECT_EQ(data.size(), mapping->get_size());
+    EXPECT_EQ(nullptr, mapping->allocate_page(4096, 64));
+
+    auto other_store = velk_.create<IHiveStore>(ClassId::HiveStore);
+    RawHive<RawPoint> adopted(*other_store);
+    EXPECT_EQ(ReturnValue::InvalidArgument, adopted.adopt(nullptr));
+    EXPECT_EQ(ReturnValue::InvalidArgument, RawHive<double>(*other_store).adopt(mapping));
+    EXPECT_EQ(ReturnValue::Success, adopted.adopt(mapping));
+    EXPECT_EQ(299u, adopted.size());
+
+    // The elements live in the mapping, at their original slots.
+    auto* begin = static_cast<char*>(mapping->get_data());
+    auto* end = begin + mapping->get_size();
+    float sum = 0.f;
+    adopted.for_each([&](RawPoint& p) {
+        EXPECT_TRUE(reinterpret_cast<char*>(&p) >= begin && reinterpret_cast<char*>(&p) < end);
+        sum += p.x;
+    });
+    EXPECT_FLOAT_EQ(44850.f - 5.f, sum);
+
+    // The adopted pages keep the mapping alive, and writes stay private to the process.
+    auto* first = static_cast<RawPoint*>(nullptr);
+    adopted.for_each([&](RawPoint& p) {
+        first = &p;
+        return false;
+    });
+    mapping.reset();
+    first->x = 100.f;
+    EXPECT_TRUE(adopted.contains(first));
+    auto* reused = adopted.emplace(-1.f, 0.f, 0.f);
+    EXPECT_TRUE(reinterpret_cast<char*>(reused) >= begin && reinterpret_cast<char*>(reused) < end);
+    adopted.deallocate(first);
+    EXPECT_EQ(299u, adopted.size());
+    adopted.clear();
+
+    std::vector<uint8_t> on_disk(data.size());
+    file = std::fopen(path.c_str(), "rb");
+    ASSERT_NE(nullptr, file);
+    EXPECT_EQ(on_disk.size(), std::fread(on_disk.data(), 1, on_disk.size(), file));
+    std::fclose(file);
+    std::remove(path.c_str());
+    EXPECT_EQ(data, on_disk);
+}
+
+TEST_F(HiveTest, ObjectHiveSnapshotStates)
+{
+    // Inline States.
+    ObjectHive<> hive(registry_->get_hive(HiveWidget::class_id()));
+    std::vector<IObject::Ptr> objs;
+    for (int i = 0; i < 100; ++i) {
+        auto obj = hive.add();
+        interface_cast<IObjectHiveWidget>(obj)->x().set_value(static_cast<float>(i));
+        objs.push_back(std::move(obj));
+    }
+    hive.remove(*objs[10]);
+    auto data = hive.snapshot_states<IObjectHiveWidget>();
+    ASSERT_FALSE(data.empty());
+    EXPECT_EQ(99u, reinterpret_cast<const HiveSnapshotHeader*>(data.data())->count);
+    EXPECT_TRUE(ObjectHive<>(fresh_hive()).snapshot_states<IObjectHiveWidget>().empty());
+
+    // Restoring into a hive with a state column writes the States to the column.
+    auto other_store = velk_.create<IHiveStore>(ClassId::HiveStore);
+    ObjectHive<> restored(other_store->get_hive(HiveWidget::class_id()));
+    EXPECT_EQ(ReturnValue::Success, restored.add_state_column<IObjectHiveWidget>());
+    EXPECT_EQ(ReturnValue::Success, restored.restore_states<IObjectHiveWidget>(data.data(), data.size()));
+    EXPECT_EQ(99u, restored.size());
+    EXPECT_EQ(ReturnValue::InvalidArgument,
+              restored.restore_states<IObjectHiveGadget>(data.data(), data.size()));
+    EXPECT_EQ(ReturnValue::InvalidArgument,
+              ObjectHive<>(fresh_hive()).restore_states<IObjectHiveWidget>(data.data(), data.size()));
+    EXPECT_EQ(99u, restored.size());
+
+    float sum = 0.f;
+    restored.for_each<IObjectHiveWidget>([&](IObject&, IObjectHiveWidget::State& s) {
+        sum += s.x;
+        return true;
+    });
+    EXPECT_FLOAT_EQ(4950.f - 10.f, sum);
+
+    // A snapshot of the column restores back into inline States.
+    auto column_data = restored.snapshot_states<IObjectHiveWidget>();
+    EXPECT_EQ(data, column_data);
+    hive.clear();
+    objs.clear();
+    EXPECT_EQ(ReturnValue::Success, hive.restore_states<IObjectHiveWidget>(column_data.data(),
+                                                                           column_data.size()));
+    sum = 0.f;
+    hive.for_each([&](IObject& obj) { sum += interface_cast<IObjectHiveWidget>(&obj)->x().get_value(); });
+    EXPECT_FLOAT_EQ(4950.f - 10.f, sum);
+}
+
 TEST_F(HiveTest, ExtRawHiveNullSafety)
 {
     RawHive<RawPoint> hive(nullptr);
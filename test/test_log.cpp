@@ -1,8 +1,10 @@
 #include <velk/api/velk.h>
 #include <velk/ext/core_object.h>
 
+#include <atomic>
 #include <gtest/gtest.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace velk;
@@ -82,6 +84,20 @@ TEST_F(LogTest, MessagesBelowThresholdDiscarded)
     EXPECT_EQ(LogLevel::Warning, ts_->entries[0].level);
 }
 
+TEST_F(LogTest, ArgumentsBelowThresholdNotEvaluated)
+{
+    velk_.log().set_level(LogLevel::Warning);
+    int evaluated = 0;
+    VELK_LOG(D, "debug %d", ++evaluated);
+    EXPECT_EQ(0, evaluated);
+    EXPECT_EQ(0u, ts_->entries.size());
+
+    VELK_LOG(E, "error %d", ++evaluated);
+    EXPECT_EQ(1, evaluated);
+    ASSERT_EQ(1u, ts_->entries.size());
+    EXPECT_EQ("error 1", ts_->entries[0].message);
+}
+
 TEST_F(LogTest, ShortAndLongLevelForms)
 {
     VELK_LOG(W, "short warning");
@@ -130,3 +146,94 @@ TEST_F(LogTest, DispatchDirectly)
     EXPECT_EQ(99, ts_->entries[0].line);
     EXPECT_EQ("direct dispatch", ts_->entries[0].message);
 }
+
+TEST_F(LogTest, AsyncSinkDeliversInOrder)
+{
+    auto async = velk_.log().create_async_sink(sink_, 1024);
+    ASSERT_TRUE(async);
+    velk_.log().set_sink(async);
+
+    constexpr int threads = 4;
+    constexpr int perThread = 100;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; ++t) {
+        writers.emplace_back([t] {
+            for (int i = 0; i < perThread; ++i) {
+                VELK_LOG(W, "%d %d", t, i);
+            }
+        });
+    }
+    for (auto& w : writers) {
+        w.join();
+    }
+    async->flush();
+
+    ASSERT_EQ(size_t(threads * perThread), ts_->entries.size());
+    EXPECT_EQ(0u, async->get_dropped_count());
+    int next[threads] = {};
+    for (auto& e : ts_->entries) {
+        EXPECT_EQ(LogLevel::Warning, e.level);
+        EXPECT_NE(std::string::npos, e.file.find("test_log.cpp"));
+        int t = 0, i = 0;
+        ASSERT_EQ(2, sscanf(e.message.c_str(), "%d %d", &t, &i));
+        ASSERT_TRUE(t >= 0 && t < threads);
+        EXPECT_EQ(next[t]++, i);
+    }
+}
+
+// Blocks in the first write until released.
+class BlockingSink : public ext::ObjectCore<BlockingSink, ILogSink>
+{
+public:
+    void write(LogLevel, const char*, int, const char* message) override
+    {
+        entered = true;
+        while (!released) {
+            std::this_thread::yield();
+        }
+        messages.push_back(message);
+    }
+
+    std::atomic<bool> entered{false};
+    std::atomic<bool> released{false};
+    std::vector<std::string> messages;
+};
+
+TEST_F(LogTest, AsyncSinkDropsWhenFull)
+{
+    auto target = ext::make_object<BlockingSink, ILogSink>();
+    auto* bs = static_cast<BlockingSink*>(target.get());
+    auto async = velk_.log().create_async_sink(target, 4);
+
+    async->write(LogLevel::Info, "a.cpp", 1, "first");
+    while (!bs->entered) {
+        std::this_thread::yield();
+    }
+    // The slot of the message being delivered stays taken, so three of these fit.
+    for (int i = 0; i < 5; ++i) {
+        async->write(LogLevel::Info, "a.cpp", 2, std::to_string(i).c_str());
+    }
+    EXPECT_EQ(2u, async->get_dropped_count());
+
+    bs->released = true;
+    async->flush();
+    ASSERT_EQ(4u, bs->messages.size());
+    EXPECT_EQ("first", bs->messages[0]);
+    EXPECT_EQ("2", bs->messages[3]);
+}
+
+TEST_F(LogTest, AsyncSinkTruncatesLongMessages)
+{
+    auto async = velk_.log().create_async_sink(sink_);
+    std::string file(300, 'f');
+    file += "end.cpp";
+    std::string message(1000, 'm');
+    async->write(LogLevel::Error, file.c_str(), 7, message.c_str());
+    async->flush();
+
+    ASSERT_EQ(1u, ts_->entries.size());
+    EXPECT_EQ(128u, ts_->entries[0].file.size());
+    EXPECT_EQ("end.cpp", ts_->entries[0].file.substr(121));
+    EXPECT_LT(ts_->entries[0].message.size(), message.size());
+    EXPECT_EQ(std::string(ts_->entries[0].message.size(), 'm'), ts_->entries[0].message);
+}
@@ -1,8 +1,10 @@
 #include <velk/api/any.h>
 #include <velk/api/callback.h>
 #include <velk/api/function_context.h>
+#include <velk/api/hierarchy.h>
 #include <velk/api/object.h>
 #include <velk/api/property.h>
+#include <velk/api/serialize.h>
 #include <velk/api/state.h>
 #include <velk/api/velk.h>
 #include <velk/ext/object.h>
@@ -13,7 +15,9 @@
 #include <velk/interface/intf_property.h>
 #include <velk/interface/types.h>
 
+#include <atomic>
 #include <gtest/gtest.h>
+#include <thread>
 
 using namespace velk;
 
@@ -40,6 +44,63 @@ public:
     )
 };
 
+class ITestCompared : public Interface<ITestCompared>
+{
+public:
+    VELK_INTERFACE(
+        (CPROP, float, opacity, 1.f),
+        (PROP, float, scale, 1.f)
+    )
+};
+
+class TestCompared : public ext::Object<TestCompared, ITestCompared>
+{};
+
+class ITestArea : public Interface<ITestArea>
+{
+public:
+    VELK_INTERFACE(
+        (PROP, float, width, 2.f),
+        (PROP, float, height, 3.f),
+        (PROP, float, depth, 1.f),
+        (COMPUTED, float, area, width, height)
+    )
+};
+
+class TestArea : public ext::Object<TestArea, ITestArea>
+{
+public:
+    mutable int computeCount = 0;
+
+    float compute_area() const override
+    {
+        computeCount++;
+        auto& s = *interface_state<ITestArea>();
+        return s.width * s.height;
+    }
+};
+
+class ITestSeqlocked : public Interface<ITestSeqlocked>
+{
+public:
+    VELK_INTERFACE(
+        (SEQLOCK),
+        (PROP, float, x, 0.f),
+        (PROP, float, y, 0.f),
+        (COMPUTED, float, sum, x, y)
+    )
+};
+
+class TestSeqlocked : public ext::Object<TestSeqlocked, ITestSeqlocked>
+{
+public:
+    float compute_sum() const override
+    {
+        auto& s = *interface_state<ITestSeqlocked>();
+        return s.x + s.y;
+    }
+};
+
 class ITestMath : public Interface<ITestMath>
 {
 public:
@@ -81,12 +142,24 @@ public:
     }
 };
 
+class TestObservedWidget : public ext::ObservedObject<TestObservedWidget, ITestWidget>
+{
+public:
+    int resetCallCount = 0;
+
+    void fn_reset() override { resetCallCount++; }
+};
+
 // --- Fixture to register once ---
 
 class ObjectTest : public ::testing::Test
 {
 protected:
-    static void SetUpTestSuite() { instance().type_registry().register_type<TestWidget>(); }
+    static void SetUpTestSuite()
+    {
+        instance().type_registry().register_type<TestWidget>();
+        instance().type_registry().register_type<TestObservedWidget>();
+    }
 };
 
 // --- Tests ---
@@ -97,6 +170,140 @@ TEST_F(ObjectTest, RegisterAndCreate)
     ASSERT_TRUE(obj);
 }
 
+// Registered and unregistered repeatedly while another thread creates objects
+class TransientWidget : public ext::Object<TransientWidget, ITestWidget>
+{
+public:
+    void fn_reset() override {}
+};
+
+TEST_F(ObjectTest, CreateWhileTypesRegister)
+{
+    auto& types = instance().type_registry();
+    std::atomic<bool> done{false};
+    std::atomic<int> failures{0};
+    std::thread reader([&] {
+        while (!done.load()) {
+            failures += !instance().create<IObject>(TestWidget::class_id());
+            types.find_factory(TransientWidget::class_id());
+        }
+    });
+    for (int i = 0; i < 200; ++i) {
+        types.register_type<TransientWidget>();
+        EXPECT_NE(nullptr, types.find_factory(TransientWidget::class_id()));
+        types.unregister_type<TransientWidget>();
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(0, failures.load());
+    EXPECT_EQ(nullptr, types.find_factory(TransientWidget::class_id()));
+}
+
+class BulkWidgetA : public ext::Object<BulkWidgetA, ITestWidget>
+{
+public:
+    void fn_reset() override {}
+};
+
+class BulkWidgetB : public ext::Object<BulkWidgetB, ITestWidget>
+{
+public:
+    void fn_reset() override {}
+};
+
+TEST_F(ObjectTest, RegisterTypesInBulk)
+{
+    auto& types = instance().type_registry();
+    const IObjectFactory* invalid[] = {&BulkWidgetA::get_factory(), nullptr};
+    EXPECT_EQ(ReturnValue::InvalidArgument, types.register_types({invalid, 2}));
+    EXPECT_EQ(nullptr, types.find_factory(BulkWidgetA::class_id()));
+
+    ASSERT_EQ(ReturnValue::Success, (types.register_types<BulkWidgetA, BulkWidgetB>()));
+    EXPECT_TRUE(instance().create<IObject>(BulkWidgetA::class_id()));
+    EXPECT_TRUE(instance().create<IObject>(BulkWidgetB::class_id()));
+
+    types.unregister_type<BulkWidgetA>();
+    types.unregister_type<BulkWidgetB>();
+    EXPECT_EQ(nullptr, types.find_factory(BulkWidgetB::class_id()));
+}
+
+TEST_F(ObjectTest, CreateInstancesInOneBlock)
+{
+    auto* factory = instance().type_registry().find_factory(TestWidget::class_id());
+    ASSERT_NE(nullptr, factory);
+
+    IObject::Ptr objects[8];
+    ASSERT_EQ(8u, factory->create_instances(8, ObjectFlags::None, objects));
+    auto first = reinterpret_cast<uintptr_t>(objects[0].get());
+    auto stride = reinterpret_cast<uintptr_t>(objects[1].get()) - first;
+    EXPECT_GE(stride, factory->get_instance_size());
+    for (size_t i = 0; i < 8; ++i) {
+        ASSERT_TRUE(objects[i]);
+        EXPECT_EQ(first + i * stride,
+                  reinterpret_cast<uintptr_t>(objects[i].get()));
+        EXPECT_EQ(objects[i], objects[i]->get_self());
+        auto* iw = interface_cast<ITestWidget>(objects[i]);
+        ASSERT_NE(nullptr, iw);
+        iw->width().set_value(static_cast<float>(i));
+    }
+    EXPECT_FLOAT_EQ(3.f, interface_cast<ITestWidget>(objects[3])->width().get_value());
+
+    // Released in any order; a weak_ptr keeps only the block alive.
+    IObject::WeakPtr weak = objects[5];
+    for (size_t i : {3, 0, 7, 5, 1, 2, 6, 4}) {
+        objects[i] = nullptr;
+    }
+    EXPECT_FALSE(weak.lock());
+    weak = IObject::WeakPtr{};
+
+    EXPECT_EQ(0u, factory->create_instances(0, ObjectFlags::None, objects));
+}
+
+TEST_F(ObjectTest, CreateInstancesThreadConfined)
+{
+    auto* factory = instance().type_registry().find_factory(TestWidget::class_id());
+    IObject::Ptr objects[2];
+    ASSERT_EQ(2u, factory->create_instances(2, ObjectFlags::ThreadConfined, objects));
+    EXPECT_TRUE(objects[0]->get_object_flags() & ObjectFlags::ThreadConfined);
+    EXPECT_TRUE(interface_cast<ITestWidget>(objects[1]));
+}
+
+class RecycledWidget : public ext::Object<RecycledWidget, ITestWidget>
+{
+public:
+    VELK_RECYCLE_INSTANCES(2);
+    void fn_reset() override {}
+};
+
+TEST_F(ObjectTest, RecycledInstancesReuseMemory)
+{
+    auto recycled = [] { return instance().get_memory_stats()[MemoryCategory::RecycledObjects].count; };
+    instance().trim_recycled_objects();
+    size_t before = recycled();
+
+    auto obj = ext::make_object<RecycledWidget>();
+    auto* address = obj.get();
+    obj = nullptr;
+    EXPECT_EQ(before + 1, recycled());
+    obj = ext::make_object<RecycledWidget>();
+    EXPECT_EQ(address, obj.get());
+    EXPECT_EQ(before, recycled());
+
+    // At most the capacity is kept.
+    IObject::Ptr objects[4];
+    for (auto& o : objects) {
+        o = ext::make_object<RecycledWidget>();
+    }
+    for (auto& o : objects) {
+        o = nullptr;
+    }
+    EXPECT_EQ(before + 2, recycled());
+
+    instance().trim_recycled_objects();
+    EXPECT_EQ(before, recycled());
+    EXPECT_TRUE(interface_cast<ITestWidget>(obj));
+}
+
 TEST_F(ObjectTest, InterfaceCastSucceeds)
 {
     auto obj = instance().create<IObject>(TestWidget::class_id());
@@ -122,6 +329,30 @@ TEST_F(ObjectTest, InterfaceCastFailsForNonImplemented)
     EXPECT_EQ(bad, nullptr);
 }
 
+template <int N>
+class ITestCastTag : public Interface<ITestCastTag<N>>
+{};
+
+class TestManyInterfaces
+    : public ext::ObjectCore<TestManyInterfaces, ITestCastTag<0>, ITestCastTag<1>, ITestCastTag<2>,
+                             ITestCastTag<3>, ITestCastTag<4>, ITestCastTag<5>, ITestCastTag<6>>
+{};
+
+TEST_F(ObjectTest, InterfaceCastResolvesEveryEntryOfHashedTable)
+{
+    auto obj = ext::make_object<TestManyInterfaces>();
+    auto* self = static_cast<TestManyInterfaces*>(obj.get());
+    EXPECT_EQ(interface_cast<ITestCastTag<0>>(obj), static_cast<ITestCastTag<0>*>(self));
+    EXPECT_EQ(interface_cast<ITestCastTag<3>>(obj), static_cast<ITestCastTag<3>*>(self));
+    EXPECT_EQ(interface_cast<ITestCastTag<6>>(obj), static_cast<ITestCastTag<6>*>(self));
+    EXPECT_NE(interface_cast<IObject>(obj), nullptr);
+    EXPECT_EQ(interface_cast<ITestCastTag<7>>(obj), nullptr);
+    EXPECT_EQ(interface_cast<IMetadata>(obj), nullptr);
+    for (auto& info : TestManyInterfaces::class_interfaces) {
+        EXPECT_NE(obj->get_interface(info.uid), nullptr) << info.name;
+    }
+}
+
 TEST_F(ObjectTest, MetadataGetPropertyByName)
 {
     auto obj = instance().create<IObject>(TestWidget::class_id());
@@ -171,6 +402,103 @@ TEST_F(ObjectTest, MetadataGetFunctionByName)
     EXPECT_TRUE(fn2);
 }
 
+TEST_F(ObjectTest, MemberTableFindsEveryMember)
+{
+    static_assert(TestWidget::member_table_data.ok);
+    auto* info = instance().type_registry().get_class_info(TestWidget::class_id());
+    ASSERT_NE(info, nullptr);
+    ASSERT_NE(info->memberTable, nullptr);
+    for (size_t i = 0; i < info->members.size(); ++i) {
+        auto& m = info->members[i];
+        EXPECT_EQ(info->memberTable->find(member_key(MemberId(m.name), m.kind)), i);
+    }
+    EXPECT_EQ(info->memberTable->find(member_key(MemberId("width"), MemberKind::Event)), MemberTable::Empty);
+    EXPECT_EQ(info->memberTable->find(member_key(MemberId("missing"), MemberKind::Property)),
+              MemberTable::Empty);
+}
+
+TEST_F(ObjectTest, MetadataGetMemberById)
+{
+    auto obj = instance().create<IObject>(TestWidget::class_id());
+    auto* meta = interface_cast<IMetadata>(obj);
+    ASSERT_NE(meta, nullptr);
+
+    static constexpr MemberId width{"width"};
+    EXPECT_FALSE(meta->get_member(width, MemberKind::Property, Resolve::Existing));
+    auto member = meta->get_member(width, MemberKind::Property);
+    ASSERT_TRUE(member);
+    EXPECT_EQ(interface_pointer_cast<IProperty>(member), meta->get_property("width"));
+    EXPECT_FALSE(meta->get_member(width, MemberKind::Function));
+    EXPECT_FALSE(meta->get_member(MemberId("missing"), MemberKind::Property));
+    EXPECT_TRUE(get_member<IFunction>(meta, MemberId("add"), MemberKind::Function));
+}
+
+TEST_F(ObjectTest, MaterializeAllCreatesMissingMembers)
+{
+    auto obj = instance().create<IObject>(TestWidget::class_id());
+    auto* meta = interface_cast<IMetadata>(obj);
+    ASSERT_NE(meta, nullptr);
+
+    auto width = meta->get_property("width");
+    ASSERT_TRUE(width);
+    EXPECT_EQ(meta->materialize_all(MemberKinds::Property), 3u); // height, id, version
+    EXPECT_EQ(meta->get_property("width"), width);
+    EXPECT_TRUE(meta->get_property("height", Resolve::Existing));
+    EXPECT_FALSE(meta->get_event("on_clicked", Resolve::Existing));
+
+    EXPECT_EQ(meta->materialize_all(), 5u); // on_clicked, reset, serialize, add, process
+    EXPECT_EQ(meta->materialize_all(), 0u);
+    EXPECT_TRUE(meta->get_event("on_clicked", Resolve::Existing));
+
+    // Pooled instances keep the flags, state and trampolines of their members.
+    auto* iw = interface_cast<ITestWidget>(obj);
+    ASSERT_NE(iw, nullptr);
+    EXPECT_FLOAT_EQ(iw->height().get_value(), 50.f);
+    iw->height().set_value(75.f);
+    EXPECT_FLOAT_EQ(iw->height().get_value(), 75.f);
+    auto id = meta->get_property("id", Resolve::Existing);
+    ASSERT_TRUE(id);
+    EXPECT_EQ(id->set_value(Any<int>(7)), ReturnValue::ReadOnly);
+    invoke_function(meta->get_function("reset", Resolve::Existing));
+    EXPECT_EQ(static_cast<TestWidget*>(iw)->resetCallCount, 1);
+
+    // A pooled instance outlives its object.
+    auto height = meta->get_property("height");
+    obj = {};
+    EXPECT_TRUE(height->get_value());
+}
+
+TEST_F(ObjectTest, ReleasedMemberSlotIsReused)
+{
+    auto obj = instance().create<IObject>(TestWidget::class_id());
+    auto* first = interface_cast<IMetadata>(obj)->get_property("width").get();
+    obj = instance().create<IObject>(TestWidget::class_id());
+    auto width = interface_cast<IMetadata>(obj)->get_property("width");
+    EXPECT_EQ(width.get(), first);
+    EXPECT_FLOAT_EQ(Property<float>(width).get_value(), 100.f);
+}
+
+TEST_F(ObjectTest, ObservedObjectEmbedsStorage)
+{
+    static_assert(sizeof(TestObservedWidget) >= OBJECT_STORAGE_SIZE + sizeof(ITestWidget::State));
+    auto obj = instance().create<IObject>(TestObservedWidget::class_id());
+    auto* iw = interface_cast<ITestWidget>(obj);
+    ASSERT_NE(iw, nullptr);
+
+    EXPECT_FLOAT_EQ(iw->width().get_value(), 100.f);
+    iw->width().set_value(20.f);
+    EXPECT_FLOAT_EQ(iw->width().get_value(), 20.f);
+    invoke_function(iw->reset());
+    EXPECT_EQ(static_cast<TestObservedWidget*>(iw)->resetCallCount, 1);
+
+    auto* storage = interface_cast<IObjectStorage>(obj);
+    ASSERT_NE(storage, nullptr);
+    auto attachment = instance().create<IInterface>(TestWidget::class_id());
+    EXPECT_TRUE(succeeded(storage->add_attachment(attachment)));
+    EXPECT_EQ(storage->attachment_count(), 1u);
+    EXPECT_EQ(storage->materialize_all(), 3u); // height, id, on_clicked
+}
+
 TEST_F(ObjectTest, PropertyDefaultsFromInterface)
 {
     auto obj = instance().create<IObject>(TestWidget::class_id());
@@ -302,6 +630,103 @@ TEST_F(ObjectTest, PropertyStateReadWrite)
     EXPECT_FLOAT_EQ(iw->height().get_value(), 75.f);
 }
 
+TEST_F(ObjectTest, PropertyAccessesStateDirectly)
+{
+    auto obj = instance().create<IObject>(TestWidget::class_id());
+    auto* iw = interface_cast<ITestWidget>(obj);
+    ASSERT_NE(iw, nullptr);
+    auto* state = get_property_state<ITestWidget>(interface_cast<IPropertyState>(obj));
+    auto width = iw->width();
+    EXPECT_EQ(width.get_property_interface()->get_state_data(type_uid<float>()), &state->width);
+    EXPECT_EQ(width.get_property_interface()->get_state_data(type_uid<int>()), nullptr);
+
+    int changes = 0;
+    Callback counter([&]() { ++changes; });
+    width.add_on_changed(counter);
+    EXPECT_EQ(width.set_value(200.f), ReturnValue::Success);
+    EXPECT_EQ(width.set_value(200.f), ReturnValue::NothingToDo);
+    EXPECT_FLOAT_EQ(state->width, 200.f);
+    EXPECT_EQ(changes, 1);
+
+    // Replacing the State-backed any (as installing an extension does) disables direct access.
+    auto* pi = interface_cast<IPropertyInternal>(width.get_property_interface());
+    ASSERT_NE(pi, nullptr);
+    pi->set_any(Any<float>(5.f).clone());
+    EXPECT_EQ(width.get_property_interface()->get_state_data(type_uid<float>()), nullptr);
+    EXPECT_FLOAT_EQ(width.get_value(), 5.f);
+    EXPECT_EQ(width.set_value(6.f), ReturnValue::Success);
+    EXPECT_FLOAT_EQ(width.get_value(), 6.f);
+    EXPECT_FLOAT_EQ(state->width, 200.f);
+}
+
+class ITestDocument : public Interface<ITestDocument>
+{
+public:
+    VELK_INTERFACE(
+        (PROP, string, title, ""),
+        (ARR, int, pages, 1, 2),
+        (PROP, double, zoom, 1.0)
+    )
+};
+
+class TestDocument : public ext::Object<TestDocument, ITestWidget, ITestDocument>
+{
+public:
+    void fn_reset() override {}
+};
+
+TEST_F(ObjectTest, SaveAndLoadStates)
+{
+    instance().type_registry().register_type<TestDocument>();
+    auto layouts = interface_cast<IPropertyState>(instance().create<IObject>(TestDocument::class_id()))
+                       ->get_state_layouts();
+    ASSERT_EQ(layouts.size(), 2u);
+    EXPECT_EQ(layouts[0].interfaceUid, ITestWidget::UID);
+    EXPECT_EQ(layouts[0].hash, ITestWidget::state_layout_hash);
+    EXPECT_TRUE(layouts[0].trivial);
+    EXPECT_EQ(layouts[1].interfaceUid, ITestDocument::UID);
+    EXPECT_FALSE(layouts[1].trivial);
+    EXPECT_NE(ITestWidget::state_layout_hash, ITestSerializable::state_layout_hash);
+
+    auto src = instance().create<IObject>(TestDocument::class_id());
+    write_state<ITestWidget>(src.get())->width = 12.f;
+    {
+        auto doc = write_state<ITestDocument>(src.get());
+        doc->title = string("Velk");
+        doc->pages.push_back(3);
+        doc->zoom = 2.5;
+    }
+    auto data = save_states(*src);
+    ASSERT_FALSE(data.empty());
+
+    auto dst = instance().create<IObject>(TestDocument::class_id());
+    int changes = 0;
+    Callback counter([&]() { ++changes; });
+    interface_cast<ITestWidget>(dst)->width().add_on_changed(counter);
+    EXPECT_EQ(load_states(*dst, data.data(), data.size()), ReturnValue::Success);
+    EXPECT_EQ(changes, 1);
+    EXPECT_FLOAT_EQ(read_state<ITestWidget>(dst.get())->width, 12.f);
+    EXPECT_EQ(read_state<ITestDocument>(dst.get())->title, string("Velk"));
+    ASSERT_EQ(read_state<ITestDocument>(dst.get())->pages.size(), 3u);
+    EXPECT_EQ(read_state<ITestDocument>(dst.get())->pages[2], 3);
+    EXPECT_DOUBLE_EQ(read_state<ITestDocument>(dst.get())->zoom, 2.5);
+
+    auto loaded = load_object(data.data(), data.size());
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(loaded->get_class_uid(), TestDocument::class_id());
+    EXPECT_FLOAT_EQ(read_state<ITestWidget>(loaded.get())->width, 12.f);
+
+    // Blocks of interfaces the target does not implement are skipped.
+    auto widget = instance().create<IObject>(TestWidget::class_id());
+    EXPECT_EQ(load_states(*widget, data.data(), data.size()), ReturnValue::Fail);
+    EXPECT_FLOAT_EQ(read_state<ITestWidget>(widget.get())->width, 12.f);
+
+    data[0] ^= 1;
+    EXPECT_EQ(load_states(*dst, data.data(), data.size()), ReturnValue::InvalidArgument);
+    EXPECT_FALSE(load_object(data.data(), data.size()));
+    instance().type_registry().unregister_type<TestDocument>();
+}
+
 TEST_F(ObjectTest, TypedFunctionInvoke)
 {
     auto obj = instance().create<IObject>(TestWidget::class_id());
@@ -335,6 +760,59 @@ TEST_F(ObjectTest, TypedFunctionReturnValue)
     EXPECT_EQ(value, 10);
 }
 
+TEST_F(ObjectTest, TypedFunctionCallSkipsBoxing)
+{
+    auto obj = instance().create<IObject>(TestWidget::class_id());
+    auto* raw = static_cast<TestWidget*>(interface_cast<ITestWidget>(obj));
+    ASSERT_NE(raw, nullptr);
+
+    auto add = interface_cast<ITestMath>(obj)->add();
+    EXPECT_EQ(add.call(3, 7), 10);
+    EXPECT_EQ(raw->lastAddResult, 10);
+
+    interface_cast<ITestWidget>(obj)->reset().call();
+    EXPECT_EQ(raw->resetCallCount, 1);
+
+    // The typed path only accepts the trampoline of the method the function was bound to.
+    int x = 1;
+    int y = 2;
+    const void* ptrs[] = {&x, &y};
+    int result = 0;
+    IFunction::ConstPtr fn = add;
+    EXPECT_FALSE(fn->invoke_typed(&detail::raw_trampoline<&ITestWidget::fn_reset>, ptrs, &result));
+    EXPECT_TRUE(fn->invoke_typed(&detail::raw_trampoline<&ITestMath::fn_add>, ptrs, &result));
+    EXPECT_EQ(result, 3);
+
+    // A null function returns a value-initialized result.
+    TypedFunction<&ITestMath::fn_add> empty(nullptr);
+    EXPECT_EQ(empty.call(1, 2), 0);
+}
+
+TEST_F(ObjectTest, FunctionInvokeIntoReusesResult)
+{
+    auto obj = instance().create<IObject>(TestWidget::class_id());
+    auto add = interface_cast<ITestMath>(obj)->add();
+
+    Any<int> result;
+    Any<int> a(3);
+    Any<int> b(7);
+    const IAny* ptrs[] = {a, b};
+    EXPECT_EQ(ReturnValue::Success, add.invoke_into({ptrs, 2}, *result.get_any_interface()));
+    EXPECT_EQ(result.get_value(), 10);
+
+    b.set_value(20);
+    EXPECT_EQ(ReturnValue::Success, add.invoke_into({ptrs, 2}, *result.get_any_interface()));
+    EXPECT_EQ(result.get_value(), 23);
+
+    // Too few args, a mismatching result type and void functions do not write a value.
+    EXPECT_EQ(ReturnValue::InvalidArgument, add.invoke_into({ptrs, 1}, *result.get_any_interface()));
+    Any<float> wrong;
+    EXPECT_NE(ReturnValue::Success, add.invoke_into({ptrs, 2}, *wrong.get_any_interface()));
+    auto reset = interface_cast<ITestWidget>(obj)->reset();
+    EXPECT_EQ(ReturnValue::NothingToDo, reset.invoke_into({}, *result.get_any_interface()));
+    EXPECT_EQ(result.get_value(), 23);
+}
+
 TEST_F(ObjectTest, VoidFunctionReturnsNull)
 {
     auto obj = instance().create<IObject>(TestWidget::class_id());
@@ -650,6 +1128,84 @@ TEST_F(ObjectTest, WriteStateFiresOnChanged)
     EXPECT_FLOAT_EQ(iw->height().get_value(), 150.f);
 }
 
+TEST_F(ObjectTest, ComputedMemberEvaluatesOnlyWhenInputsChange)
+{
+    auto obj = ext::make_object<TestArea>();
+    auto* impl = static_cast<TestArea*>(obj.get());
+    auto* ia = interface_cast<ITestArea>(obj);
+    ASSERT_NE(ia, nullptr);
+    EXPECT_EQ(TestArea::computed_count, 1u);
+
+    EXPECT_FLOAT_EQ(ia->area(), 6.f);
+    EXPECT_FLOAT_EQ(ia->area(), 6.f);
+    EXPECT_EQ(impl->computeCount, 1);
+
+    // Only the declared inputs invalidate the cache.
+    ia->depth().set_value(5.f);
+    EXPECT_FLOAT_EQ(ia->area(), 6.f);
+    EXPECT_EQ(impl->computeCount, 1);
+
+    ia->width().set_value(4.f);
+    EXPECT_FLOAT_EQ(ia->area(), 12.f);
+    EXPECT_FLOAT_EQ(ia->area(), 12.f);
+    EXPECT_EQ(impl->computeCount, 2);
+
+    // A handler of an input sees the new value.
+    float seen = 0.f;
+    Callback onHeight([&]() { seen = ia->area(); });
+    ia->height().add_on_changed(onHeight);
+    ia->height().set_value(5.f);
+    EXPECT_FLOAT_EQ(seen, 20.f);
+
+    // write_state() invalidates without any property instantiated.
+    auto other = ext::make_object<TestArea>();
+    auto* ib = interface_cast<ITestArea>(other);
+    EXPECT_FLOAT_EQ(ib->area(), 6.f);
+    write_state<ITestArea>(ib, [](ITestArea::State& s) { s.height = 10.f; });
+    EXPECT_FLOAT_EQ(ib->area(), 20.f);
+    EXPECT_EQ(static_cast<TestArea*>(other.get())->computeCount, 2);
+
+    // Reflection exposes the member as a zero-arg function.
+    auto result = invoke_function(other.get(), "area");
+    ASSERT_TRUE(result);
+    float value = 0.f;
+    result->get_data(&value, sizeof(float), type_uid<float>());
+    EXPECT_FLOAT_EQ(value, 20.f);
+    EXPECT_EQ(static_cast<TestArea*>(other.get())->computeCount, 2);
+}
+
+TEST_F(ObjectTest, WriteStateSkipsUnchangedComparedProperties)
+{
+    auto obj = ext::make_object<TestCompared>();
+    auto* ic = interface_cast<ITestCompared>(obj);
+    ASSERT_NE(ic, nullptr);
+
+    int opacityNotified = 0;
+    int scaleNotified = 0;
+    Callback onOpacity([&]() { opacityNotified++; });
+    Callback onScale([&]() { scaleNotified++; });
+    ic->opacity().add_on_changed(onOpacity);
+    ic->scale().add_on_changed(onScale);
+    opacityNotified = 0;
+    scaleNotified = 0;
+
+    {
+        auto writer = write_state<ITestCompared>(ic);
+        writer->scale = 2.f;
+    }
+    // CPROP notifies only if its value changed, PROP notifies on every write_state.
+    EXPECT_EQ(opacityNotified, 0);
+    EXPECT_EQ(scaleNotified, 1);
+
+    {
+        auto writer = write_state<ITestCompared>(ic);
+        writer->opacity = 0.5f;
+    }
+    EXPECT_EQ(opacityNotified, 1);
+    EXPECT_EQ(scaleNotified, 2);
+    EXPECT_FLOAT_EQ(ic->opacity().get_value(), 0.5f);
+}
+
 TEST_F(ObjectTest, WriteStateNoCrashWithNoInstantiatedProperties)
 {
     auto obj = instance().create<IObject>(TestWidget::class_id());
@@ -750,6 +1306,73 @@ TEST_F(ObjectTest, ValidReadWriteStateReturnTrue)
     EXPECT_TRUE(writer);
 }
 
+TEST_F(ObjectTest, SeqlockBracketsStateWrites)
+{
+    auto obj = ext::make_object<TestSeqlocked>();
+    auto* is = interface_cast<ITestSeqlocked>(obj);
+    ASSERT_NE(is, nullptr);
+    auto& lock = get_property_state<ITestSeqlocked>(is)->_velk_seqlock;
+    EXPECT_EQ(lock.sequence(), 0u);
+
+    write_state<ITestSeqlocked>(is, [](ITestSeqlocked::State& s) { s.x = 1.f; });
+    EXPECT_EQ(lock.sequence(), 2u);
+
+    {
+        auto writer = write_state<ITestSeqlocked>(is);
+        writer->y = 2.f;
+        EXPECT_EQ(lock.sequence() & 1u, 1u);
+    }
+    EXPECT_EQ(lock.sequence(), 4u);
+
+    is->x().set_value(3.f);
+    EXPECT_EQ(lock.sequence(), 6u);
+    EXPECT_FLOAT_EQ(is->sum(), 5.f);
+    EXPECT_EQ(lock.sequence(), 8u);
+
+    // A property write inside a write_state() callback is one write.
+    write_state<ITestSeqlocked>(is, [&](ITestSeqlocked::State& s) {
+        s.x = 4.f;
+        is->y().set_value(4.f);
+    });
+    EXPECT_EQ(lock.sequence(), 10u);
+
+    ITestSeqlocked::State copy;
+    ASSERT_TRUE(read_state_consistent<ITestSeqlocked>(is, copy));
+    EXPECT_FLOAT_EQ(copy.x, 4.f);
+    EXPECT_FLOAT_EQ(copy.y, 4.f);
+
+    auto widget = ext::make_object<TestWidget>();
+    EXPECT_FALSE(read_state_consistent<ITestSeqlocked>(interface_cast<ITestWidget>(widget), copy));
+}
+
+TEST_F(ObjectTest, ReadStateConsistentDoesNotTear)
+{
+    auto obj = ext::make_object<TestSeqlocked>();
+    auto* is = interface_cast<ITestSeqlocked>(obj);
+    ASSERT_NE(is, nullptr);
+
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (int i = 1; i <= 20000; ++i) {
+            write_state<ITestSeqlocked>(is, [i](ITestSeqlocked::State& s) {
+                s.x = float(i);
+                s.y = float(-i);
+            });
+        }
+        done = true;
+    });
+    size_t torn = 0;
+    ITestSeqlocked::State copy;
+    while (!done) {
+        ASSERT_TRUE(read_state_consistent<ITestSeqlocked>(is, copy));
+        torn += copy.x != -copy.y;
+    }
+    writer.join();
+    EXPECT_EQ(torn, 0u);
+    ASSERT_TRUE(read_state_consistent<ITestSeqlocked>(is, copy));
+    EXPECT_FLOAT_EQ(copy.x, 20000.f);
+}
+
 // --- Deferred write_state ---
 
 TEST_F(ObjectTest, DeferredWriteState)
@@ -797,6 +1420,26 @@ TEST_F(ObjectTest, DeferredWriteStateFiresOnChanged)
     EXPECT_FLOAT_EQ(iw->width().get_value(), 500.f);
 }
 
+TEST_F(ObjectTest, DeferredWriteOfUnobservedPropertyInvalidatesComputed)
+{
+    auto obj = ext::make_object<TestArea>();
+    auto* ia = interface_cast<ITestArea>(obj);
+    ASSERT_NE(ia, nullptr);
+    EXPECT_FLOAT_EQ(ia->area(), 6.f);
+
+    // width has no on_changed event, so the flush completes its write without notifying.
+    int heightNotified = 0;
+    Callback onHeight([&]() { heightNotified++; });
+    ia->height().add_on_changed(onHeight);
+    ia->width().set_value(4.f, Deferred);
+    ia->height().set_value(5.f, Deferred);
+    instance().update();
+
+    EXPECT_FLOAT_EQ(ia->width().get_value(), 4.f);
+    EXPECT_FLOAT_EQ(ia->area(), 20.f);
+    EXPECT_EQ(heightNotified, 1);
+}
+
 TEST_F(ObjectTest, DeferredWriteStateDestroyedBeforeUpdate)
 {
     {
@@ -1148,6 +1791,75 @@ TEST_F(ObjectWrapperTest, FindOrCreateAttachment)
     EXPECT_EQ(obj.attachment_count(), 1u);
 }
 
+TEST_F(ObjectWrapperTest, FindAttachmentByInterfaceKeepsAttachmentOrder)
+{
+    auto obj = make();
+    auto* storage = obj.as<IObjectStorage>();
+    ASSERT_NE(storage, nullptr);
+
+    // Registered classes are indexed; TestManyInterfaces is not registered and is scanned.
+    auto first = instance().create<IInterface>(ClassId::Hierarchy);
+    IInterface::Ptr unregistered = ext::make_object<TestManyInterfaces>();
+    auto second = instance().create<IInterface>(ClassId::Hierarchy);
+    auto widget = instance().create<IInterface>(TestWidget::class_id());
+    ASSERT_TRUE(first && second && widget);
+    for (auto& a : {first, unregistered, second, widget}) {
+        EXPECT_TRUE(succeeded(storage->add_attachment(a)));
+    }
+
+    EXPECT_EQ(find_attachment<IHierarchy>(storage).get(), interface_cast<IHierarchy>(first));
+    EXPECT_EQ(find_attachment<ITestWidget>(storage).get(), interface_cast<ITestWidget>(widget));
+    EXPECT_EQ(find_attachment<ITestCastTag<2>>(storage).get(), interface_cast<ITestCastTag<2>>(unregistered));
+    EXPECT_FALSE(find_attachment<IVelk>(storage));
+    EXPECT_EQ(storage->find_attachment({IObject::UID}).get(), first.get());
+    EXPECT_EQ(storage->find_attachment({IObject::UID, TestWidget::class_id()}).get(), widget.get());
+    EXPECT_EQ(storage->find_attachment({{}, TestWidget::class_id()}).get(), widget.get());
+
+    // Removing shifts the later attachments down without losing their index entries.
+    EXPECT_TRUE(succeeded(storage->remove_attachment(first)));
+    EXPECT_TRUE(succeeded(storage->remove_attachment(unregistered)));
+    EXPECT_EQ(find_attachment<IHierarchy>(storage).get(), interface_cast<IHierarchy>(second));
+    EXPECT_EQ(find_attachment<ITestWidget>(obj.get().get()).get(), interface_cast<ITestWidget>(widget));
+    EXPECT_EQ(storage->find_attachment({IObject::UID}).get(), second.get());
+    EXPECT_FALSE(find_attachment<ITestCastTag<2>>(storage));
+}
+
+TEST_F(ObjectWrapperTest, FreezeMakesObjectImmutable)
+{
+    auto obj = make();
+    auto* widget = obj.as<ITestWidget>();
+    widget->width().set_value(7.f);
+    EXPECT_FALSE(obj.borrow_property("width"));
+
+    int changes = 0;
+    Callback counter([&]() { ++changes; });
+    widget->width().add_on_changed(counter);
+
+    EXPECT_EQ(ReturnValue::Success, obj.freeze());
+    EXPECT_EQ(ReturnValue::NothingToDo, obj.freeze());
+    EXPECT_TRUE(obj.frozen());
+
+    // Every member was created, and properties are borrowed without adding a reference.
+    auto* storage = obj.as<IObjectStorage>();
+    EXPECT_TRUE(storage->get_function("reset", Resolve::Existing));
+    auto width = obj.borrow_property("width");
+    ASSERT_TRUE(width);
+    EXPECT_EQ(width.get(), storage->get_property("width").get());
+    EXPECT_EQ(width.get(), (borrow_member<IProperty>(storage, MemberId("width"), MemberKind::Property).get()));
+    EXPECT_FALSE(obj.borrow_property("nonexistent"));
+    EXPECT_FLOAT_EQ(7.f, widget->width().get_value());
+
+    // Writes are rejected and notify nobody, including handlers connected before the freeze.
+    EXPECT_EQ(ReturnValue::ReadOnly, widget->width().set_value(8.f));
+    EXPECT_FLOAT_EQ(7.f, widget->width().get_value());
+    write_state<ITestWidget>(widget, [](ITestWidget::State& s) { s.height = 1.f; });
+    EXPECT_EQ(0, changes);
+
+    auto hierarchy = instance().create<IInterface>(ClassId::Hierarchy);
+    EXPECT_EQ(ReturnValue::ReadOnly, obj.add_attachment(hierarchy));
+    EXPECT_EQ(0u, obj.attachment_count());
+}
+
 TEST_F(ObjectWrapperTest, ArrowOperator)
 {
     auto obj = make();
@@ -1189,3 +1901,61 @@ TEST_F(ObjectWrapperTest, NullObjectSafe)
     EXPECT_FALSE(obj.find_or_create_attachment<IHierarchy>(ClassId::Hierarchy));
     EXPECT_FALSE(obj.get());
 }
+
+// Memory stats
+
+TEST(MemoryStats, TracksMembersValuesAndHierarchyEntries)
+{
+    auto count = [](MemoryCategory category) { return instance().get_memory_stats()[category].count; };
+    size_t members = count(MemoryCategory::RuntimeMembers);
+    size_t values = count(MemoryCategory::AnyValues);
+    size_t entries = count(MemoryCategory::HierarchyEntries);
+    {
+        auto p = create_property<int>(1);
+        // The property and the on_changed event that setting its initial value created.
+        EXPECT_EQ(count(MemoryCategory::RuntimeMembers), members + 2);
+        EXPECT_EQ(count(MemoryCategory::AnyValues), values + 1);
+        EXPECT_GT(instance().get_memory_stats()[MemoryCategory::HivePages].bytes, 0u);
+
+        auto h = create_hierarchy();
+        auto root = instance().create<IObject>(ClassId::Property);
+        h.set_root(root);
+        h.add(root, instance().create<IObject>(ClassId::Property));
+        EXPECT_EQ(count(MemoryCategory::HierarchyEntries), entries + 2);
+    }
+    EXPECT_EQ(count(MemoryCategory::RuntimeMembers), members);
+    EXPECT_EQ(count(MemoryCategory::AnyValues), values);
+    EXPECT_EQ(count(MemoryCategory::HierarchyEntries), entries);
+}
+
+TEST(MemoryStats, SeparatesPooledControlBlocks)
+{
+    auto in_use = [] {
+        auto stats = instance().get_memory_stats();
+        size_t pooled = stats[MemoryCategory::PooledControlBlocks].count;
+        EXPECT_GE(stats[MemoryCategory::ControlBlocks].count, pooled);
+        return stats[MemoryCategory::ControlBlocks].count - pooled;
+    };
+    size_t before = in_use();
+    {
+        auto value = make_shared<int>(1);
+        EXPECT_EQ(in_use(), before + 1);
+    }
+    EXPECT_EQ(in_use(), before);
+}
+
+TEST(MemoryStats, SamplesDeferredQueues)
+{
+    int calls = 0;
+    Callback fn([&] { ++calls; });
+    instance().queue_deferred_call(fn, {});
+    auto queued = instance().get_memory_stats()[MemoryCategory::DeferredQueues];
+    EXPECT_GE(queued.count, 1u);
+    EXPECT_GT(queued.bytes, 0u);
+
+    instance().update();
+    EXPECT_EQ(calls, 1);
+    auto drained = instance().get_memory_stats()[MemoryCategory::DeferredQueues];
+    EXPECT_EQ(drained.count, 0u);
+    EXPECT_GT(drained.bytes, 0u); // The buffers keep their capacity.
+}
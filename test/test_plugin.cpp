@@ -1,8 +1,13 @@
 #include <velk/api/velk.h>
+#include <velk/ext/core_object.h>
 #include <velk/ext/object.h>
 #include <velk/ext/plugin.h>
 #include <velk/interface/types.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 
 using namespace velk;
@@ -125,9 +130,185 @@ public:
     UpdateInfo lastInfo{};
 };
 
+// An updating plugin that spends a fixed time in each update callback
+class SlowUpdatingPlugin : public ext::Plugin<SlowUpdatingPlugin>
+{
+public:
+    VELK_PLUGIN_UID("a0000000-0000-0000-0000-000000000008");
+
+    ReturnValue initialize(IVelk&, PluginConfig& config) override
+    {
+        config.enableUpdate = true;
+        return ReturnValue::Success;
+    }
+
+    ReturnValue shutdown(IVelk&) override { return ReturnValue::Success; }
+
+    void pre_update(const IPlugin::PreUpdateInfo&) override { spin(); }
+    void post_update(const IPlugin::PostUpdateInfo& info) override
+    {
+        preUpdateSeen = info.timings.preUpdate;
+        spin();
+    }
+
+    static void spin()
+    {
+        auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(2);
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    }
+
+    Duration preUpdateSeen{};
+};
+
+// A plugin that depends on FailingPlugin
+class FailingDependentPlugin : public ext::Plugin<FailingDependentPlugin>
+{
+public:
+    VELK_PLUGIN_UID("a0000000-0000-0000-0000-000000000009");
+    VELK_PLUGIN_DEPS(FailingPlugin::class_uid);
+
+    ReturnValue initialize(IVelk&, PluginConfig&) override { return ReturnValue::Success; }
+    ReturnValue shutdown(IVelk&) override { return ReturnValue::Success; }
+};
+
+// Two plugins that depend on each other
+class CyclePluginB;
+class CyclePluginA : public ext::Plugin<CyclePluginA>
+{
+public:
+    VELK_PLUGIN_UID("a0000000-0000-0000-0000-00000000000a");
+    VELK_PLUGIN_DEPS(Uid{"a0000000-0000-0000-0000-00000000000b"});
+
+    ReturnValue initialize(IVelk&, PluginConfig&) override { return ReturnValue::Success; }
+    ReturnValue shutdown(IVelk&) override { return ReturnValue::Success; }
+};
+
+class CyclePluginB : public ext::Plugin<CyclePluginB>
+{
+public:
+    VELK_PLUGIN_UID("a0000000-0000-0000-0000-00000000000b");
+    VELK_PLUGIN_DEPS(CyclePluginA::class_uid);
+
+    ReturnValue initialize(IVelk&, PluginConfig&) override { return ReturnValue::Success; }
+    ReturnValue shutdown(IVelk&) override { return ReturnValue::Success; }
+};
+
+template <uint64_t N>
+class WaveWidget : public ext::Object<WaveWidget<N>, IPluginWidget>
+{
+public:
+    static constexpr Uid class_uid{0xa000000000000000ull, 0x200 + N};
+};
+
+// Plugins that wait in initialize() until all of them have entered it, so that they only load
+// when initialized concurrently
+struct WaveState
+{
+    static constexpr int count = 3;
+    static inline std::atomic<int> entered{0};
+    static inline std::atomic<int> concurrent{0};
+};
+
+template <uint64_t N>
+class WavePlugin : public ext::Plugin<WavePlugin<N>>
+{
+public:
+    static constexpr Uid class_uid{0xa000000000000000ull, 0x100 + N};
+
+    ReturnValue initialize(IVelk& velk, PluginConfig&) override
+    {
+        WaveState::entered++;
+        auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (WaveState::entered < WaveState::count && std::chrono::steady_clock::now() < until) {
+            std::this_thread::yield();
+        }
+        WaveState::concurrent += WaveState::entered == WaveState::count;
+        return register_type<WaveWidget<N>>(velk);
+    }
+
+    ReturnValue shutdown(IVelk&) override { return ReturnValue::Success; }
+};
+
+// A plugin that depends on all WavePlugins
+class WaveDependentPlugin : public ext::Plugin<WaveDependentPlugin>
+{
+public:
+    VELK_PLUGIN_UID("a0000000-0000-0000-0000-00000000000c");
+    VELK_PLUGIN_DEPS(WavePlugin<0>::class_uid, WavePlugin<1>::class_uid, WavePlugin<2>::class_uid);
+
+    ReturnValue initialize(IVelk& velk, PluginConfig&) override
+    {
+        auto& reg = velk.plugin_registry();
+        sawDependencies = reg.find_plugin<WavePlugin<0>>() && reg.find_plugin<WavePlugin<1>>() &&
+                          reg.find_plugin<WavePlugin<2>>() && velk.create(WaveWidget<2>::class_uid);
+        return ReturnValue::Success;
+    }
+    ReturnValue shutdown(IVelk&) override { return ReturnValue::Success; }
+
+    bool sawDependencies = false;
+};
+
+// Updating plugins with configurable access sets, recording when and where their updates ran
+struct AccessState
+{
+    static inline std::atomic<int> seq{0};
+};
+
+template <uint64_t N>
+class AccessPlugin : public ext::Plugin<AccessPlugin<N>>
+{
+public:
+    static constexpr Uid class_uid{0xa000000000000000ull, 0x300 + N};
+
+    ReturnValue initialize(IVelk&, PluginConfig& config) override
+    {
+        config.enableUpdate = true;
+        config.updateReads = reads;
+        config.updateWrites = writes;
+        return ReturnValue::Success;
+    }
+    ReturnValue shutdown(IVelk&) override { return ReturnValue::Success; }
+
+    void pre_update(const IPlugin::PreUpdateInfo&) override
+    {
+        ++updates;
+        order = AccessState::seq++;
+        thread = std::this_thread::get_id();
+    }
+    bool is_update_idle() const override { return idle; }
+
+    static inline uint64_t reads = AccessAll;
+    static inline uint64_t writes = AccessAll;
+    bool idle = false;
+    int updates = 0;
+    int order = -1;
+    std::thread::id thread;
+};
+
+// Executor that runs each task on its own std::thread
+class PluginThreadExecutor : public ext::ObjectCore<PluginThreadExecutor, IExecutor>
+{
+public:
+    size_t get_concurrency() const override { return 4; }
+    void parallel_for(size_t count, void* context, TaskFn task) override
+    {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([=] { task(context, i); });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        ++calls;
+    }
+    size_t calls{};
+};
+
 // UIDs for DLL test plugins (must match test_plugin_dll.cpp)
 static constexpr Uid DllTestPluginUid{"b0000000-0000-0000-0000-000000000001"};
 static constexpr Uid DllSubPluginUid{"b0000000-0000-0000-0000-000000000002"};
+static constexpr Uid DllWidgetUid{"b0000000-0000-0000-0000-000000000003"};
 
 class PluginTest : public ::testing::Test
 {
@@ -156,6 +337,9 @@ protected:
         if (reg.find_plugin<DependentPlugin>()) {
             reg.unload_plugin<DependentPlugin>();
         }
+        if (reg.find_plugin<FailingDependentPlugin>()) {
+            reg.unload_plugin<FailingDependentPlugin>();
+        }
         if (reg.find_plugin<UpdatingPlugin>()) {
             reg.unload_plugin<UpdatingPlugin>();
         }
@@ -232,6 +416,36 @@ TEST_F(PluginTest, UnloadAutoUnregistersTypes)
     EXPECT_EQ(nullptr, velk_.type_registry().get_class_info(PluginWidget::class_id()));
 }
 
+TEST_F(PluginTest, FactoryHandleFollowsPluginLoads)
+{
+    auto& reg = velk_.plugin_registry();
+    auto& types = velk_.type_registry();
+    EXPECT_FALSE(types.get_factory_handle<PluginWidget>());
+
+    reg.load_plugin(plugin_);
+    auto handle = types.get_factory_handle<PluginWidget>();
+    ASSERT_TRUE(handle);
+    EXPECT_EQ(types.find_factory(PluginWidget::class_id()), handle.get());
+    EXPECT_TRUE(handle.create<IPluginWidget>());
+
+    IObject::Ptr objects[3];
+    ASSERT_EQ(3u, handle.create_n(objects, 3));
+    for (auto& object : objects) {
+        ASSERT_TRUE(object);
+        EXPECT_EQ(PluginWidget::class_id(), object->get_class_uid());
+    }
+
+    // Unloading the plugin sweeps the type, and with it the factory of the handle.
+    reg.unload_plugin<TestPlugin>();
+    EXPECT_FALSE(handle);
+    EXPECT_FALSE(handle.create());
+    EXPECT_EQ(0u, handle.create_n(objects, 3));
+
+    // A new registration of the class is picked up.
+    reg.load_plugin(ext::make_object<TestPlugin, IPlugin>());
+    EXPECT_TRUE(handle.create());
+}
+
 TEST_F(PluginTest, DoubleLoadReturnsNothingToDo)
 {
     auto& reg = velk_.plugin_registry();
@@ -484,6 +698,99 @@ TEST_F(PluginTest, UpdateAutoTime)
     EXPECT_GE(raw->lastInfo.dt.us, 0);
 }
 
+TEST_F(PluginTest, UpdateStatsReportPhaseAndPluginTimings)
+{
+    auto& reg = velk_.plugin_registry();
+    auto up = ext::make_object<SlowUpdatingPlugin, IPlugin>();
+    auto* raw = static_cast<SlowUpdatingPlugin*>(up.get());
+    ASSERT_EQ(ReturnValue::Success, reg.load_plugin(up));
+
+    velk_.update();
+
+    auto& stats = velk_.get_update_stats();
+    EXPECT_GE(stats.timings.preUpdate.us, 2000);
+    EXPECT_GE(stats.timings.postUpdate.us, 2000);
+    EXPECT_EQ(stats.timings.preUpdate.us, raw->preUpdateSeen.us);
+    const PluginUpdateTiming* timing = nullptr;
+    for (auto& t : stats.timings.plugins) {
+        if (t.plugin == up.get()) {
+            timing = &t;
+        }
+    }
+    ASSERT_NE(nullptr, timing);
+    EXPECT_GE(timing->preUpdate.us, 2000);
+    EXPECT_GE(timing->postUpdate.us, 2000);
+
+    ASSERT_EQ(ReturnValue::Success, reg.unload_plugin<SlowUpdatingPlugin>());
+}
+
+TEST_F(PluginTest, LoadPluginsInDependencyOrder)
+{
+    auto& reg = velk_.plugin_registry();
+    IPlugin::Ptr plugins[] = {ext::make_object<DependentPlugin, IPlugin>(), plugin_};
+
+    ASSERT_EQ(ReturnValue::Success, reg.load_plugins({plugins, 2}, nullptr));
+    EXPECT_EQ(builtin_count_ + 2, reg.plugin_count());
+    EXPECT_EQ(1, tp_->initCount);
+    EXPECT_NE(nullptr, reg.find_plugin<DependentPlugin>());
+
+    EXPECT_EQ(ReturnValue::NothingToDo, reg.load_plugins({plugins, 2}, nullptr));
+    EXPECT_EQ(1, tp_->initCount);
+}
+
+TEST_F(PluginTest, LoadPluginsSkipsDependentsOfFailedPlugins)
+{
+    auto& reg = velk_.plugin_registry();
+    IPlugin::Ptr plugins[] = {ext::make_object<FailingDependentPlugin, IPlugin>(),
+                              ext::make_object<FailingPlugin, IPlugin>(),
+                              plugin_};
+
+    EXPECT_EQ(ReturnValue::Fail, reg.load_plugins({plugins, 3}, nullptr));
+    EXPECT_EQ(builtin_count_ + 1, reg.plugin_count());
+    EXPECT_NE(nullptr, reg.find_plugin<TestPlugin>());
+    EXPECT_EQ(nullptr, reg.find_plugin<FailingPlugin>());
+    EXPECT_EQ(nullptr, reg.find_plugin<FailingDependentPlugin>());
+}
+
+TEST_F(PluginTest, LoadPluginsRejectsCyclesAndNull)
+{
+    auto& reg = velk_.plugin_registry();
+    IPlugin::Ptr cycle[] = {ext::make_object<CyclePluginA, IPlugin>(),
+                            ext::make_object<CyclePluginB, IPlugin>()};
+    EXPECT_EQ(ReturnValue::Fail, reg.load_plugins({cycle, 2}, nullptr));
+    EXPECT_EQ(builtin_count_, reg.plugin_count());
+
+    IPlugin::Ptr withNull[] = {plugin_, nullptr};
+    EXPECT_EQ(ReturnValue::InvalidArgument, reg.load_plugins({withNull, 2}, nullptr));
+    EXPECT_EQ(0, tp_->initCount);
+}
+
+TEST_F(PluginTest, LoadPluginsInitializesIndependentPluginsConcurrently)
+{
+    auto& reg = velk_.plugin_registry();
+    auto pool = velk_.create_thread_pool(WaveState::count);
+    auto dependent = ext::make_object<WaveDependentPlugin, IPlugin>();
+    IPlugin::Ptr plugins[] = {dependent,
+                              ext::make_object<WavePlugin<0>, IPlugin>(),
+                              ext::make_object<WavePlugin<1>, IPlugin>(),
+                              ext::make_object<WavePlugin<2>, IPlugin>()};
+
+    ASSERT_EQ(ReturnValue::Success, reg.load_plugins({plugins, 4}, pool.get()));
+    EXPECT_EQ(WaveState::count, WaveState::concurrent);
+    EXPECT_TRUE(static_cast<WaveDependentPlugin*>(dependent.get())->sawDependencies);
+    EXPECT_TRUE(velk_.create(WaveWidget<0>::class_uid));
+    EXPECT_TRUE(velk_.create(WaveWidget<1>::class_uid));
+
+    // Each plugin owns the types it registered on its worker thread.
+    ASSERT_EQ(ReturnValue::Success, reg.unload_plugin<WaveDependentPlugin>());
+    ASSERT_EQ(ReturnValue::Success, reg.unload_plugin<WavePlugin<0>>());
+    EXPECT_EQ(nullptr, velk_.type_registry().get_class_info(WaveWidget<0>::class_uid));
+    EXPECT_NE(nullptr, velk_.type_registry().get_class_info(WaveWidget<1>::class_uid));
+    ASSERT_EQ(ReturnValue::Success, reg.unload_plugin<WavePlugin<1>>());
+    ASSERT_EQ(ReturnValue::Success, reg.unload_plugin<WavePlugin<2>>());
+    EXPECT_EQ(builtin_count_, reg.plugin_count());
+}
+
 #ifdef TEST_PLUGIN_DLL_PATH
 TEST_F(PluginTest, LoadFromPathSuccess)
 {
@@ -529,4 +836,109 @@ TEST_F(PluginTest, LoadFromPathMultiPlugin)
     EXPECT_EQ(builtin_count_, reg.plugin_count());
     EXPECT_EQ(nullptr, reg.find_plugin(DllSubPluginUid));
 }
+
+TEST_F(PluginTest, LibraryLoadsOnFirstCreate)
+{
+    auto& reg = velk_.plugin_registry();
+    array_view<Uid> classes(&DllWidgetUid, 1);
+    ASSERT_EQ(ReturnValue::Success,
+              reg.register_plugin_library(DllTestPluginUid, TEST_PLUGIN_DLL_PATH, classes));
+    EXPECT_EQ(ReturnValue::NothingToDo,
+              reg.register_plugin_library(DllTestPluginUid, TEST_PLUGIN_DLL_PATH, classes));
+    EXPECT_EQ(builtin_count_, reg.plugin_count());
+
+    auto widget = velk_.create<IInterface>(DllWidgetUid);
+    ASSERT_TRUE(widget);
+    EXPECT_EQ(builtin_count_ + 2, reg.plugin_count()); // host + sub-plugin
+    EXPECT_NE(nullptr, reg.find_plugin(DllTestPluginUid));
+
+    // The registration is consumed; an unloaded library is not loaded again.
+    widget = nullptr;
+    ASSERT_EQ(ReturnValue::Success, reg.unload_plugin(DllTestPluginUid));
+    EXPECT_FALSE(velk_.create<IInterface>(DllWidgetUid));
+    EXPECT_EQ(builtin_count_, reg.plugin_count());
+}
+
+TEST_F(PluginTest, LibraryLoadsOnLoadPlugin)
+{
+    auto& reg = velk_.plugin_registry();
+    ASSERT_EQ(ReturnValue::Success, reg.register_plugin_library(DllTestPluginUid, TEST_PLUGIN_DLL_PATH, {}));
+    EXPECT_EQ(nullptr, reg.find_plugin(DllTestPluginUid));
+    EXPECT_NE(nullptr, reg.get_or_load_plugin(DllTestPluginUid));
+    EXPECT_EQ(builtin_count_ + 2, reg.plugin_count());
+    EXPECT_EQ(ReturnValue::NothingToDo,
+              reg.register_plugin_library(DllTestPluginUid, TEST_PLUGIN_DLL_PATH, {}));
+}
 #endif
+
+TEST_F(PluginTest, RegisterLibraryWithoutPathFails)
+{
+    auto& reg = velk_.plugin_registry();
+    EXPECT_EQ(ReturnValue::InvalidArgument, reg.register_plugin_library(DllTestPluginUid, nullptr, {}));
+    EXPECT_EQ(ReturnValue::InvalidArgument, reg.register_plugin_library(DllTestPluginUid, "", {}));
+}
+
+TEST_F(PluginTest, MissingLibraryIsNotRetried)
+{
+    auto& reg = velk_.plugin_registry();
+    static constexpr Uid pluginUid{"b0000000-0000-0000-0000-0000000000ff"};
+    static constexpr Uid classUid{"b0000000-0000-0000-0000-0000000000fe"};
+    array_view<Uid> classes(&classUid, 1);
+    ASSERT_EQ(ReturnValue::Success, reg.register_plugin_library(pluginUid, "does_not_exist.so", classes));
+    EXPECT_FALSE(velk_.create<IInterface>(classUid));
+    EXPECT_EQ(builtin_count_, reg.plugin_count());
+    EXPECT_EQ(ReturnValue::Success, reg.register_plugin_library(pluginUid, "does_not_exist.so", classes));
+    EXPECT_EQ(ReturnValue::Fail, reg.load_plugin(pluginUid));
+}
+
+TEST_F(PluginTest, UpdateRunsNonConflictingPluginsInParallelAndSkipsIdle)
+{
+    auto& reg = velk_.plugin_registry();
+    // An animator that writes properties, a layout that reads them and a plugin with its own state.
+    AccessPlugin<0>::reads = AccessNone;
+    AccessPlugin<0>::writes = AccessProperties;
+    AccessPlugin<1>::reads = AccessProperties;
+    AccessPlugin<1>::writes = AccessNone;
+    AccessPlugin<2>::reads = AccessUser;
+    AccessPlugin<2>::writes = AccessUser;
+    IPlugin::Ptr plugins[] = {ext::make_object<AccessPlugin<0>, IPlugin>(),
+                              ext::make_object<AccessPlugin<1>, IPlugin>(),
+                              ext::make_object<AccessPlugin<2>, IPlugin>()};
+    for (auto& plugin : plugins) {
+        ASSERT_EQ(ReturnValue::Success, reg.load_plugin(plugin));
+    }
+    auto* animator = static_cast<AccessPlugin<0>*>(plugins[0].get());
+    auto* layout = static_cast<AccessPlugin<1>*>(plugins[1].get());
+    auto* other = static_cast<AccessPlugin<2>*>(plugins[2].get());
+
+    // Without an executor every plugin updates on the calling thread.
+    velk_.update();
+    EXPECT_EQ(std::this_thread::get_id(), layout->thread);
+    EXPECT_EQ(std::this_thread::get_id(), other->thread);
+
+    auto executor = ext::make_object<PluginThreadExecutor, IExecutor>();
+    auto* raw = static_cast<PluginThreadExecutor*>(executor.get());
+    velk_.set_executor(executor);
+    velk_.update();
+    // The layout reads what the animator writes, so it runs after it. The third plugin
+    // conflicts with neither and runs alongside the layout.
+    EXPECT_LE(1u, raw->calls);
+    EXPECT_EQ(std::this_thread::get_id(), animator->thread);
+    EXPECT_LT(animator->order, layout->order);
+    EXPECT_NE(std::this_thread::get_id(), layout->thread);
+    EXPECT_NE(std::this_thread::get_id(), other->thread);
+    EXPECT_NE(layout->thread, other->thread);
+
+    // Idle plugins are skipped, and a wave with a single plugin runs on the calling thread.
+    other->idle = true;
+    velk_.update();
+    EXPECT_EQ(3, animator->updates);
+    EXPECT_EQ(3, layout->updates);
+    EXPECT_EQ(2, other->updates);
+    EXPECT_EQ(std::this_thread::get_id(), layout->thread);
+    velk_.set_executor({});
+
+    for (auto& plugin : plugins) {
+        reg.unload_plugin(interface_cast<IObject>(plugin)->get_class_uid());
+    }
+}
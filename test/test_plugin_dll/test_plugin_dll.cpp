@@ -13,7 +13,10 @@ public:
 };
 
 class DllWidget : public ext::Object<DllWidget, IDllWidget>
-{};
+{
+public:
+    VELK_CLASS_UID("b0000000-0000-0000-0000-000000000003");
+};
 
 // A sub-plugin that lives in the same DLL but is loaded by the host plugin
 class DllSubPlugin : public ext::Plugin<DllSubPlugin>
@@ -1,10 +1,15 @@
 #include <velk/api/any.h>
+#include <velk/api/batch.h>
+#include <velk/api/binding.h>
 #include <velk/api/callback.h>
 #include <velk/api/property.h>
 #include <velk/api/velk.h>
 #include <velk/interface/intf_property.h>
 
 #include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace velk;
 
@@ -41,6 +46,26 @@ TEST(Property, CopySemanticsShareSameIProperty)
     EXPECT_FLOAT_EQ(copy.get_value(), 20.f);
 }
 
+TEST(Property, BorrowValueDoesNotAddReference)
+{
+    auto p = create_property<int>(1);
+    auto prop = p.get_property_interface();
+    auto owned = prop->get_value();
+    ASSERT_TRUE(owned);
+    auto strong = owned.block()->strong.load();
+
+    borrowed_ptr<const IAny> value = prop->borrow_value();
+    EXPECT_EQ(value.get(), owned.get());
+    EXPECT_EQ(owned.block()->strong.load(), strong);
+
+    // Setting a value writes into the same any, so the borrowed pointer stays valid.
+    p.set_value(2);
+    EXPECT_EQ(prop->borrow_value(), value);
+    int read{};
+    EXPECT_TRUE(succeeded(value->get_data(&read, sizeof(read), type_uid<int>())));
+    EXPECT_EQ(read, 2);
+}
+
 TEST(Property, OnChangedEventFires)
 {
     int callCount = 0;
@@ -170,6 +195,215 @@ TEST(Property, DeferredCoalescing)
     EXPECT_EQ(callCount, 1);
 }
 
+TEST(Property, DeferredCoalescingAcrossThreadsKeepsLatestWrite)
+{
+    auto p = create_property<int>(0);
+    int callCount = 0;
+    Callback handler([&](FnArgs) -> ReturnValue {
+        callCount++;
+        return ReturnValue::Success;
+    });
+    p.add_on_changed(handler);
+
+    // Each write comes from a new thread, so the writes land in different deferred queues.
+    p.set_value(1, Deferred);
+    for (int i = 2; i <= 8; ++i) {
+        std::thread([&p, i] { p.set_value(i, Deferred); }).join();
+    }
+
+    instance().update();
+    EXPECT_EQ(p.get_value(), 8);
+    EXPECT_EQ(callCount, 1);
+}
+
+TEST(Property, DeferredSetsWithoutRetainedBuffers)
+{
+    auto p = create_property<int>(0);
+    instance().set_deferred_retain_limit(0);
+    for (int frame = 1; frame <= 3; ++frame) {
+        p.set_value(frame, Deferred);
+        p.set_value(frame * 10, Deferred);
+        instance().update();
+        EXPECT_EQ(p.get_value(), frame * 10);
+    }
+    instance().set_deferred_retain_limit(64 * 1024);
+}
+
+TEST(Property, DeferredTrivialAndClonedWritesCoalesce)
+{
+    auto p = create_property<float>(0.f);
+    int callCount = 0;
+    Callback handler([&](FnArgs) -> ReturnValue {
+        callCount++;
+        return ReturnValue::Success;
+    });
+    p.add_on_changed(handler);
+
+    // Typed writes of a trivially copyable type queue raw bytes; writes through an IAny queue
+    // a cloned value. The latest write wins either way.
+    p.set_value(1.f, Deferred);
+    EXPECT_EQ(p.get_property_interface()->set_value(Any<float>(2.f), Deferred), ReturnValue::Success);
+    instance().update();
+    EXPECT_FLOAT_EQ(p.get_value(), 2.f);
+    EXPECT_EQ(callCount, 1);
+
+    EXPECT_EQ(p.get_property_interface()->set_value(Any<float>(3.f), Deferred), ReturnValue::Success);
+    p.set_value(4.f, Deferred);
+    EXPECT_FLOAT_EQ(p.get_value(), 2.f);
+    instance().update();
+    EXPECT_FLOAT_EQ(p.get_value(), 4.f);
+    EXPECT_EQ(callCount, 2);
+
+    auto ro = create_property<const int>(42);
+    Property<int> writable(ro.get_property_interface());
+    EXPECT_EQ(writable.set_value(1, Deferred), ReturnValue::ReadOnly);
+}
+
+TEST(Property, DeferredPropertiesQueuedInBulk)
+{
+    auto p = create_property<int>(0);
+    auto q = create_property<int>(0);
+    auto pi = interface_pointer_cast<IPropertyInternal>(p.get_property_interface());
+    auto qi = interface_pointer_cast<IPropertyInternal>(q.get_property_interface());
+    ASSERT_TRUE(pi && qi);
+    int notified = 0;
+    Callback onChanged([&]() { notified++; });
+    p.add_on_changed(onChanged);
+    q.add_on_changed(onChanged);
+
+    IPropertyInternal::WeakPtr expired;
+    {
+        auto gone = create_property<int>(0);
+        expired = interface_pointer_cast<IPropertyInternal>(gone.get_property_interface());
+    }
+    // The notification-only set for p keeps the value queued before it, as with single sets.
+    p.set_value(7, Deferred);
+    DeferredPropertySet sets[] = {{pi, nullptr}, {expired, nullptr}, {qi, nullptr}, {qi, nullptr}};
+    instance().queue_deferred_properties({sets, 4});
+    EXPECT_EQ(notified, 0);
+    instance().update();
+    EXPECT_EQ(p.get_value(), 7);
+    EXPECT_EQ(notified, 2);
+}
+
+TEST(Property, DeferredStagingValuesAreRecycled)
+{
+    auto p = create_property<int>(0);
+    auto f = create_property<float>(0.f);
+    auto pi = interface_pointer_cast<IPropertyInternal>(p.get_property_interface());
+    ASSERT_TRUE(pi);
+
+    auto staged = instance().acquire_deferred_value(*pi->get_any());
+    ASSERT_TRUE(staged);
+    ASSERT_EQ(staged->copy_from(Any<int>(5)), ReturnValue::Success);
+    const IAny* raw = staged.get();
+    instance().queue_deferred_property({pi, std::move(staged), true});
+    f.set_value(2.5f, Deferred);
+    instance().update();
+    EXPECT_EQ(p.get_value(), 5);
+    EXPECT_FLOAT_EQ(f.get_value(), 2.5f);
+
+    // The applied value is handed out again, to one caller.
+    auto reused = instance().acquire_deferred_value(*pi->get_any());
+    EXPECT_EQ(reused.get(), raw);
+    auto other = instance().acquire_deferred_value(*pi->get_any());
+    EXPECT_NE(other.get(), raw);
+
+    // A recycled value that already holds the written value still queues the write.
+    instance().queue_deferred_property({pi, std::move(reused), true});
+    instance().update();
+    auto q = create_property<int>(0);
+    q.set_value(5, Deferred);
+    instance().update();
+    EXPECT_EQ(q.get_value(), 5);
+
+    // Writes keep applying the right values while their staging values circulate.
+    for (int frame = 1; frame <= 3; ++frame) {
+        p.set_value(frame, Deferred);
+        p.set_value(frame * 10, Deferred);
+        f.set_value(frame * 0.5f, Deferred);
+        instance().update();
+        EXPECT_EQ(p.get_value(), frame * 10);
+        EXPECT_FLOAT_EQ(f.get_value(), frame * 0.5f);
+    }
+}
+
+TEST(Property, CompareOnWriteSuppressesUnchangedNotifications)
+{
+    auto p = create_property<int>(5, ObjectFlags::CompareOnWrite);
+    auto plain = create_property<int>(5);
+    auto pi = interface_pointer_cast<IPropertyInternal>(p.get_property_interface());
+    auto plainPi = interface_pointer_cast<IPropertyInternal>(plain.get_property_interface());
+    ASSERT_TRUE(pi && plainPi);
+
+    int notified = 0;
+    Callback onChanged([&]() { notified++; });
+    p.add_on_changed(onChanged);
+    notified = 0;
+
+    // Nothing changed since the last notification.
+    EXPECT_EQ(pi->notify_changed(), ReturnValue::NothingToDo);
+    EXPECT_EQ(plainPi->notify_changed(), ReturnValue::Success);
+    instance().queue_deferred_property({pi, nullptr});
+    instance().update();
+    EXPECT_EQ(notified, 0);
+
+    p.set_value(6);
+    EXPECT_EQ(notified, 1);
+    p.set_value(6, Deferred);
+    instance().update();
+    EXPECT_EQ(notified, 1);
+
+    // A write that restores the notified value before the flush fires nothing.
+    p.set_value(7, Deferred);
+    p.set_value(6, Deferred);
+    instance().update();
+    EXPECT_EQ(notified, 1);
+    p.set_value(8, Deferred);
+    instance().update();
+    EXPECT_EQ(notified, 2);
+    EXPECT_EQ(p.get_value(), 8);
+}
+
+TEST(Property, BatchWriteNotifiesOnceAtScopeExit)
+{
+    auto a = create_property<float>(0.f);
+    auto b = create_property<int>(0);
+    auto ro = create_property<const int>(0);
+
+    std::vector<std::string> order;
+    int aSeenB = -1;
+    Callback onA([&]() {
+        order.push_back("a");
+        aSeenB = b.get_value();
+    });
+    Callback onB([&]() { order.push_back("b"); });
+    a.add_on_changed(onA);
+    b.add_on_changed(onB);
+    order.clear();
+
+    {
+        auto batch = batch_write();
+        EXPECT_EQ(batch.set(a, 1.f), ReturnValue::Success);
+        EXPECT_EQ(batch.set(b, 2), ReturnValue::Success);
+        EXPECT_EQ(batch.set(a, 3.f), ReturnValue::Success);
+        EXPECT_EQ(batch.set(b, 2), ReturnValue::NothingToDo);
+        EXPECT_EQ(batch.set(Property<int>(ro.get_property_interface()), 1), ReturnValue::ReadOnly);
+        // Values apply immediately, notifications wait for the end of the batch.
+        EXPECT_FLOAT_EQ(a.get_value(), 3.f);
+        EXPECT_EQ(b.get_value(), 2);
+        EXPECT_TRUE(order.empty());
+        EXPECT_EQ(batch.size(), 2u);
+    }
+    EXPECT_EQ(order, (std::vector<std::string>{"a", "b"}));
+    EXPECT_EQ(aSeenB, 2);
+
+    // Nothing is queued for update().
+    order.clear();
+    instance().update();
+    EXPECT_TRUE(order.empty());
+}
+
 TEST(Property, DeferredMultipleProperties)
 {
     auto p1 = create_property<int>(0);
@@ -220,3 +454,100 @@ TEST(Property, DeferredPropertyDestroyedBeforeUpdate)
     // update() should not crash when the weak_ptr is expired.
     instance().update();
 }
+
+TEST(Property, BindingFollowsSourceOnUpdate)
+{
+    auto source = create_property<int>(1);
+    auto target = create_property<int>(0);
+
+    ASSERT_EQ(bind(target, source), ReturnValue::Success);
+    EXPECT_TRUE(instance().binding_registry().is_bound(target.get_property_interface()));
+    EXPECT_EQ(target.get_value(), 1);
+
+    // Source changes reach the target on the next update(), including deferred ones.
+    source.set_value(2);
+    EXPECT_EQ(target.get_value(), 1);
+    instance().update();
+    EXPECT_EQ(target.get_value(), 2);
+
+    source.set_value(3, Deferred);
+    instance().update();
+    EXPECT_EQ(target.get_value(), 3);
+    EXPECT_EQ(instance().get_update_stats().bindingsEvaluated, 1u);
+
+    EXPECT_EQ(unbind(target), ReturnValue::Success);
+    EXPECT_EQ(unbind(target), ReturnValue::NothingToDo);
+    source.set_value(4);
+    instance().update();
+    EXPECT_EQ(target.get_value(), 3);
+}
+
+TEST(Property, BindingEvaluatesEachDependentOncePerUpdate)
+{
+    // a -> b = a * 2, a -> c = a + 1, (b, c) -> d = b + c
+    auto a = create_property<int>(1);
+    auto b = create_property<int>(0);
+    auto c = create_property<int>(0);
+    auto d = create_property<int>(0);
+
+    int dCalls = 0;
+    int dFired = 0;
+    ASSERT_EQ(bind(d, [&](int x, int y) { ++dCalls; return x + y; }, b, c), ReturnValue::Success);
+    ASSERT_EQ(bind(b, [](int x) { return x * 2; }, a), ReturnValue::Success);
+    ASSERT_EQ(bind(c, [](int x) { return x + 1; }, a), ReturnValue::Success);
+    instance().update();
+    EXPECT_EQ(d.get_value(), 4);
+
+    Callback onD([&]() { ++dFired; });
+    d.add_on_changed(onD);
+    dCalls = 0;
+    a.set_value(2);
+    a.set_value(5);
+    instance().update();
+    EXPECT_EQ(b.get_value(), 10);
+    EXPECT_EQ(c.get_value(), 6);
+    EXPECT_EQ(d.get_value(), 16);
+    EXPECT_EQ(dCalls, 1);
+    EXPECT_EQ(dFired, 1);
+    EXPECT_EQ(instance().get_update_stats().bindingsEvaluated, 3u);
+
+    // Nothing changed, nothing evaluated.
+    instance().update();
+    EXPECT_EQ(dCalls, 1);
+    EXPECT_EQ(instance().get_update_stats().bindingsEvaluated, 0u);
+}
+
+TEST(Property, BindingRejectsCyclesAndDropsExpiredBindings)
+{
+    auto a = create_property<int>(0);
+    auto b = create_property<int>(0);
+    auto c = create_property<int>(0);
+    auto& registry = instance().binding_registry();
+    size_t count = registry.get_binding_count();
+
+    ASSERT_EQ(bind(b, a), ReturnValue::Success);
+    ASSERT_EQ(bind(c, b), ReturnValue::Success);
+    EXPECT_EQ(bind(a, c), ReturnValue::InvalidArgument);
+    EXPECT_EQ(bind(a, a), ReturnValue::InvalidArgument);
+    EXPECT_EQ(registry.get_binding_count(), count + 2);
+
+    // Rebinding replaces the binding of the target.
+    auto e = create_property<int>(7);
+    ASSERT_EQ(bind(c, e), ReturnValue::Success);
+    EXPECT_EQ(c.get_value(), 7);
+    EXPECT_EQ(registry.get_binding_count(), count + 2);
+
+    {
+        auto target = create_property<int>(0);
+        ASSERT_EQ(bind(target, a), ReturnValue::Success);
+        EXPECT_EQ(registry.get_binding_count(), count + 3);
+    }
+    a.set_value(1);
+    instance().update();
+    EXPECT_EQ(b.get_value(), 1);
+    EXPECT_EQ(registry.get_binding_count(), count + 2);
+
+    unbind(b);
+    unbind(c);
+    EXPECT_EQ(registry.get_binding_count(), count);
+}
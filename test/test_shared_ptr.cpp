@@ -1,3 +1,4 @@
+#include <velk/allocator.h>
 #include <velk/api/velk.h>
 #include <velk/ext/any.h>
 #include <velk/ext/core_object.h>
@@ -5,7 +6,10 @@
 #include <velk/interface/types.h>
 #include <velk/memory.h>
 
+#include <atomic>
 #include <gtest/gtest.h>
+#include <thread>
+#include <vector>
 
 using namespace velk;
 
@@ -79,6 +83,22 @@ TEST(SharedPtr, Equality)
     EXPECT_EQ(null, nullptr);
 }
 
+TEST(BorrowedPtr, BorrowsWithoutOwning)
+{
+    auto obj = instance().create<IObject>(ClassId::Property);
+    auto strong = obj.block()->strong.load();
+    borrowed_ptr<IObject> b = obj;
+    borrowed_ptr<const IInterface> base = b;
+    EXPECT_EQ(b.get(), obj.get());
+    EXPECT_EQ(base, b);
+    EXPECT_EQ(&*b, obj.get());
+    EXPECT_EQ(obj.block()->strong.load(), strong);
+
+    borrowed_ptr<IObject> null;
+    EXPECT_FALSE(null);
+    EXPECT_NE(null, b);
+}
+
 // shared_ptr<non-IInterface> tests (external control block)
 
 struct PlainData
@@ -251,10 +271,16 @@ class TrackableObject : public ext::ObjectCore<TrackableObject>
 {
 public:
     static int alive_count;
+    static std::thread::id destroyed_on; ///< Thread that destroyed the last instance.
     TrackableObject() { ++alive_count; }
-    ~TrackableObject() override { --alive_count; }
+    ~TrackableObject() override
+    {
+        --alive_count;
+        destroyed_on = std::this_thread::get_id();
+    }
 };
 int TrackableObject::alive_count = 0;
+std::thread::id TrackableObject::destroyed_on;
 
 static bool register_trackable = [] {
     instance().type_registry().register_type<TrackableObject>();
@@ -447,6 +473,303 @@ TEST(WeakPtrIntrusive, WeakPtrSurvivesObjectDestruction)
     EXPECT_TRUE(wp3.expired());
 }
 
+// Thread-confined objects
+
+TEST(ThreadConfined, CountsWithoutAtomicsAndKeepsLifetime)
+{
+    TrackableObject::alive_count = 0;
+    weak_ptr<IObject> wp;
+    {
+        auto obj = instance().create<IObject>(TrackableObject::class_id(), ObjectFlags::ThreadConfined);
+        ASSERT_TRUE(obj);
+        EXPECT_TRUE(obj->get_object_flags() & ObjectFlags::ThreadConfined);
+        ASSERT_NE(obj.block(), nullptr);
+        EXPECT_TRUE(obj.block()->is_local());
+        EXPECT_EQ(obj->get_self().get(), obj.get());
+
+        wp = obj;
+        auto copy = obj;
+        obj.reset();
+        EXPECT_EQ(TrackableObject::alive_count, 1);
+        auto locked = wp.lock();
+        copy.reset();
+        EXPECT_EQ(TrackableObject::alive_count, 1);
+        EXPECT_FALSE(wp.expired());
+    }
+    EXPECT_EQ(TrackableObject::alive_count, 0);
+    EXPECT_TRUE(wp.expired());
+    EXPECT_FALSE(wp.lock());
+}
+
+TEST(ThreadConfined, RecycledBlockIsAtomicAgain)
+{
+    instance().create<IObject>(TrackableObject::class_id(), ObjectFlags::ThreadConfined).reset();
+    // The block of the destroyed object is the first one the pool hands out again.
+    auto obj = instance().create<IObject>(TrackableObject::class_id());
+    ASSERT_NE(obj.block(), nullptr);
+    EXPECT_FALSE(obj.block()->is_local());
+}
+
+TEST(BlockPool, ReusesBlocksReleasedOnOtherThreads)
+{
+    auto blocks_allocated = [] {
+        return instance().get_memory_stats()[MemoryCategory::ControlBlocks].count;
+    };
+    std::vector<control_block*> blocks(1024);
+    std::thread([&] {
+        for (auto& b : blocks) {
+            b = detail::alloc_control_block();
+        }
+    }).join();
+    // The releasing thread's pool overflows into the depot, and hands the rest over on exit.
+    std::thread([&] {
+        for (auto* b : blocks) {
+            detail::dealloc_control_block(b);
+        }
+    }).join();
+
+    size_t before = blocks_allocated();
+    size_t after = 0;
+    std::thread([&] {
+        for (auto& b : blocks) {
+            b = detail::alloc_control_block();
+        }
+        after = blocks_allocated();
+        for (auto* b : blocks) {
+            detail::dealloc_control_block(b);
+        }
+    }).join();
+    EXPECT_EQ(after, before);
+}
+
+namespace {
+
+// Holds more control blocks than the depot can, so that it is empty while alive.
+struct DepotDrain
+{
+    std::vector<control_block*> held = std::vector<control_block*>(8192);
+
+    DepotDrain()
+    {
+        for (auto& b : held) {
+            b = detail::alloc_control_block();
+        }
+    }
+    ~DepotDrain()
+    {
+        for (auto* b : held) {
+            detail::dealloc_control_block(b);
+        }
+    }
+};
+
+// Runs @p fn on a new thread, which starts with an empty pool.
+template <class Fn>
+void on_new_thread(Fn&& fn)
+{
+    std::thread(std::forward<Fn>(fn)).join();
+}
+
+BlockPoolStats operator-(const BlockPoolStats& a, const BlockPoolStats& b)
+{
+    return {a.hits - b.hits,       a.misses - b.misses,       a.refills - b.refills,
+            a.spills - b.spills, a.overflows - b.overflows, a.trimmed - b.trimmed};
+}
+
+} // namespace
+
+TEST(BlockPool, CapacityIsConfigurable)
+{
+    auto& velk = instance();
+    auto saved = velk.get_block_pool_config();
+    DepotDrain drain;
+    BlockPoolConfig config;
+    config.capacity = 1024;
+    velk.set_block_pool_config(config);
+    EXPECT_EQ(velk.get_block_pool_config().capacity, 1024u);
+
+    on_new_thread([&] {
+        std::vector<control_block*> blocks(1024);
+        auto before = velk.get_block_pool_stats();
+        for (auto& b : blocks) {
+            b = detail::alloc_control_block();
+        }
+        for (auto* b : blocks) {
+            detail::dealloc_control_block(b);
+        }
+        auto& reused = blocks.front();
+        reused = detail::alloc_control_block();
+        detail::dealloc_control_block(reused);
+        auto delta = velk.get_block_pool_stats() - before;
+        EXPECT_EQ(delta.misses, 1024u);
+        EXPECT_EQ(delta.hits, 1u);
+        // All released blocks fit in the pool.
+        EXPECT_EQ(delta.spills, 0u);
+        EXPECT_EQ(delta.overflows, 0u);
+    });
+    velk.set_block_pool_config(saved);
+}
+
+TEST(BlockPool, AdaptiveCapacityGrowsOnMissesAndShrinksWhenIdle)
+{
+    auto& velk = instance();
+    auto saved = velk.get_block_pool_config();
+    DepotDrain drain;
+    BlockPoolConfig config;
+    config.capacity = 256;
+    config.maxCapacity = 2048;
+    config.idleUpdates = 4;
+    velk.set_block_pool_config(config);
+
+    on_new_thread([&] {
+        std::vector<control_block*> blocks(2048);
+        auto before = velk.get_block_pool_stats();
+        for (auto& b : blocks) {
+            b = detail::alloc_control_block();
+        }
+        for (auto* b : blocks) {
+            detail::dealloc_control_block(b);
+        }
+        auto delta = velk.get_block_pool_stats() - before;
+        EXPECT_EQ(delta.misses, 2048u);
+        // The pool grew to hold the whole burst.
+        EXPECT_EQ(delta.spills, 0u);
+        EXPECT_EQ(delta.overflows, 0u);
+
+        // The first check only starts the idle window; the second releases what went unused.
+        for (int window = 0; window < 2; ++window) {
+            for (uint32_t i = 0; i < config.idleUpdates; ++i) {
+                velk.update();
+            }
+            detail::dealloc_control_block(detail::alloc_control_block());
+        }
+        // Everything above the configured capacity is released, apart from the block in use.
+        delta = velk.get_block_pool_stats() - before;
+        EXPECT_EQ(delta.trimmed, 2048u - 1 - config.capacity);
+    });
+    velk.set_block_pool_config(saved);
+}
+
+TEST(ReclaimScope, PeekedObjectOutlivesItsLastReference)
+{
+    TrackableObject::alive_count = 0;
+    auto obj = instance().create<IObject>(TrackableObject::class_id());
+    weak_ptr<IObject> weak = obj;
+    {
+        ReclaimScope scope;
+        IObject* peeked = weak.peek(scope);
+        EXPECT_EQ(peeked, obj.get());
+        {
+            ReclaimScope nested;
+            obj.reset();
+        }
+        // Expired for weak references, but destroyed only when the outermost scope ends.
+        EXPECT_EQ(TrackableObject::alive_count, 1);
+        EXPECT_TRUE(weak.expired());
+        EXPECT_EQ(weak.peek(scope), nullptr);
+        EXPECT_FALSE(weak.lock());
+        EXPECT_EQ(peeked->get_interface(IObject::UID), peeked);
+    }
+    EXPECT_EQ(TrackableObject::alive_count, 0);
+}
+
+TEST(ReclaimScope, ThreadConfinedObjectIsNeverRetired)
+{
+    TrackableObject::alive_count = 0;
+    auto obj = instance().create<IObject>(TrackableObject::class_id(), ObjectFlags::ThreadConfined);
+    ReclaimScope scope;
+    obj.reset();
+    EXPECT_EQ(TrackableObject::alive_count, 0);
+}
+
+TEST(ReclaimScope, RetiredObjectIsDestroyedByTheReleasingThread)
+{
+    TrackableObject::alive_count = 0;
+    auto obj = instance().create<IObject>(TrackableObject::class_id());
+    std::atomic<int> step{0};
+    std::thread::id releaser;
+    std::thread thread;
+    {
+        ReclaimScope scope;
+        thread = std::thread([&] {
+            releaser = std::this_thread::get_id();
+            obj.reset(); // Retired, the scope of the main thread is open.
+            step = 1;
+            while (step != 2) {
+                std::this_thread::yield();
+            }
+            // The next release of the thread destroys what the readers moved past.
+            instance().create<IObject>(TrackableObject::class_id()).reset();
+            step = 3;
+            while (step != 4) {
+                std::this_thread::yield();
+            }
+        });
+        while (step != 1) {
+            std::this_thread::yield();
+        }
+        EXPECT_EQ(TrackableObject::alive_count, 1);
+    }
+    // Ending the scope does not destroy objects other threads retired.
+    EXPECT_EQ(TrackableObject::alive_count, 1);
+    step = 2;
+    while (step != 3) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(TrackableObject::alive_count, 0);
+    EXPECT_EQ(TrackableObject::destroyed_on, releaser);
+    step = 4;
+    thread.join();
+}
+
+TEST(ReclaimScope, LaterScopesDoNotHoldBackRetiredObjects)
+{
+    TrackableObject::alive_count = 0;
+    auto obj = instance().create<IObject>(TrackableObject::class_id());
+    std::atomic<bool> entered[2]{};
+    std::atomic<bool> leave[2]{};
+    auto reader = [&](int i) {
+        return std::thread([&, i] {
+            ReclaimScope scope;
+            entered[i] = true;
+            while (!leave[i]) {
+                std::this_thread::yield();
+            }
+        });
+    };
+    auto wait_for = [](std::atomic<bool>& flag) {
+        while (!flag) {
+            std::this_thread::yield();
+        }
+    };
+    auto first = reader(0);
+    wait_for(entered[0]);
+    obj.reset(); // Retired while the first reader is in its scope.
+    EXPECT_EQ(TrackableObject::alive_count, 1);
+    auto second = reader(1); // Overlaps the first scope.
+    wait_for(entered[1]);
+    leave[0] = true;
+    first.join();
+    {
+        ReclaimScope scope;
+    }
+    // Only the first scope could have seen the object.
+    EXPECT_EQ(TrackableObject::alive_count, 0);
+    leave[1] = true;
+    second.join();
+}
+
+TEST(ReclaimScope, DestroysImmediatelyOnceScopesEnded)
+{
+    TrackableObject::alive_count = 0;
+    auto obj = instance().create<IObject>(TrackableObject::class_id());
+    {
+        ReclaimScope scope;
+    }
+    obj.reset();
+    EXPECT_EQ(TrackableObject::alive_count, 0);
+}
+
 // get_self interop with ref counting
 
 TEST(SharedPtrIntrusive, GetSelfKeepsObjectAlive)
@@ -499,3 +822,30 @@ TEST(WeakPtrPlain, MultipleWeakPtrs)
     EXPECT_TRUE(wp2.expired());
     EXPECT_EQ(PlainData::destroyed_count, 1);
 }
+
+// Allocator
+
+TEST(Allocator, CannotInstallAfterFirstAllocation)
+{
+    instance();
+    EXPECT_EQ(get_allocator(), nullptr);
+
+    struct NullAllocator : IAllocator
+    {
+        void* allocate(size_t, size_t, MemoryTag) override { return nullptr; }
+        void deallocate(void*, size_t, MemoryTag) override {}
+    } allocator;
+    EXPECT_FALSE(set_allocator(&allocator));
+    EXPECT_EQ(get_allocator(), nullptr);
+}
+
+TEST(Allocator, DefaultAllocatorHonorsAlignment)
+{
+    for (size_t alignment : {size_t(8), size_t(64), size_t(4096)}) {
+        void* p = detail::velk_alloc(100, alignment, MemoryTag::General);
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % alignment, 0u);
+        detail::velk_free(p, alignment, MemoryTag::General);
+    }
+    detail::velk_free(nullptr, 8, MemoryTag::General);
+}
@@ -0,0 +1,123 @@
+#include <velk/api/callback.h>
+#include <velk/api/future.h>
+#include <velk/api/velk.h>
+#include <velk/interface/intf_thread_pool.h>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace velk;
+
+TEST(ThreadPool, CreatesRequestedThreads)
+{
+    auto pool = instance().create_thread_pool(3);
+    ASSERT_TRUE(pool);
+    EXPECT_EQ(pool->get_thread_count(), 3u);
+    EXPECT_EQ(pool->get_concurrency(), 4u);
+
+    EXPECT_GE(instance().create_thread_pool()->get_thread_count(), 1u);
+}
+
+TEST(ThreadPool, AsyncRunsOffThread)
+{
+    auto pool = instance().create_thread_pool(2);
+    auto caller = std::this_thread::get_id();
+
+    auto future = async(pool, [caller]() -> int { return std::this_thread::get_id() != caller ? 42 : 0; });
+    EXPECT_EQ(future.get_result().get_value(), 42);
+}
+
+TEST(ThreadPool, PostedTasksRunBeforeDestruction)
+{
+    std::atomic<int> ran{0};
+    {
+        auto pool = instance().create_thread_pool(2);
+        Callback task([&](FnArgs) -> ReturnValue {
+            ++ran;
+            return ReturnValue::Success;
+        });
+        for (int i = 0; i < 100; ++i) {
+            pool->post(task);
+        }
+    }
+    EXPECT_EQ(ran.load(), 100);
+}
+
+TEST(ThreadPool, ParallelForRunsEveryIndexOnce)
+{
+    auto pool = instance().create_thread_pool(4);
+    std::vector<std::atomic<int>> hits(1000);
+    pool->parallel_for(hits.size(), &hits, [](void* context, size_t index) {
+        (*static_cast<std::vector<std::atomic<int>>*>(context))[index]++;
+    });
+    for (auto& hit : hits) {
+        EXPECT_EQ(hit.load(), 1);
+    }
+}
+
+TEST(ThreadPool, TasksPostedFromWorkersAreStolen)
+{
+    auto pool = instance().create_thread_pool(4);
+    std::atomic<int> ran{0};
+    // One task fans out into many on its own deque; the idle workers steal them.
+    auto done = async(pool, [&]() {
+        std::vector<IFuture::Ptr> children;
+        for (int i = 0; i < 64; ++i) {
+            children.push_back(async(pool, [&]() { ++ran; }));
+        }
+        when_all({children.data(), children.size()}).wait();
+    });
+    done.wait();
+    EXPECT_EQ(ran.load(), 64);
+}
+
+TEST(ThreadPool, PoolContinuationRunsOnInstancePool)
+{
+    auto previous = instance().get_thread_pool();
+    instance().set_thread_pool(instance().create_thread_pool(1));
+
+    auto promise = make_promise();
+    auto caller = std::this_thread::get_id();
+    auto chained = promise.get_future<int>().then(
+        [caller](int value) -> int { return std::this_thread::get_id() != caller ? value + 1 : 0; }, Pool);
+
+    promise.set_value(1);
+    EXPECT_EQ(chained.get_result().get_value(), 2);
+
+    instance().set_thread_pool(previous);
+}
+
+TEST(ThreadPool, PoolInvocationRunsOnInstancePool)
+{
+    std::atomic<bool> off_thread{false};
+    auto caller = std::this_thread::get_id();
+    auto promise = make_promise();
+    Callback fn([&](FnArgs) -> ReturnValue {
+        off_thread = std::this_thread::get_id() != caller;
+        promise.complete();
+        return ReturnValue::Success;
+    });
+
+    fn.invoke(Pool);
+    promise.get_future<void>().wait();
+    EXPECT_TRUE(off_thread.load());
+}
+
+TEST(ThreadPool, CancelledAsyncTaskIsDropped)
+{
+    auto pool = instance().create_thread_pool(1);
+    auto gate = make_promise();
+    std::atomic<int> ran{0};
+
+    // Occupy the only worker so that the second task stays queued.
+    auto blocker = async(pool, [&]() { gate.get_future<void>().wait(); });
+    auto dropped = async(pool, [&]() { ++ran; });
+    dropped.cancel();
+    gate.complete();
+
+    blocker.wait();
+    async(pool, []() {}).wait(); // Runs after the dropped task
+    EXPECT_EQ(ran.load(), 0);
+}
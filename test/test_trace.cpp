@@ -0,0 +1,167 @@
+#include <velk/api/velk.h>
+#include <velk/trace.h>
+
+#include <algorithm>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace velk;
+
+namespace {
+
+// Records the trace events of all threads.
+class RecordingBackend : public ITraceBackend
+{
+public:
+    void begin_zone(const TraceZone& zone, string_view text) override
+    {
+        std::lock_guard lock(mutex);
+        events.push_back(std::string("+") + zone.name + (text.empty() ? "" : ":") +
+                         std::string(text.data(), text.size()));
+    }
+    void end_zone(const TraceZone& zone) override
+    {
+        std::lock_guard lock(mutex);
+        events.push_back(std::string("-") + zone.name);
+    }
+    void counter(const char* name, int64_t value) override
+    {
+        std::lock_guard lock(mutex);
+        counters.push_back(std::string(name) + "=" + std::to_string(value));
+    }
+
+    bool has(const std::string& event) const
+    {
+        return std::find(events.begin(), events.end(), event) != events.end();
+    }
+
+    std::mutex mutex;
+    std::vector<std::string> events;
+    std::vector<std::string> counters;
+};
+
+std::string read_file(const std::string& path)
+{
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+size_t count(const std::string& text, const std::string& what)
+{
+    size_t n = 0;
+    for (size_t pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + 1)) {
+        ++n;
+    }
+    return n;
+}
+
+class TraceTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        stop_trace_recording();
+        set_trace_backend(nullptr);
+    }
+
+    RecordingBackend backend_;
+};
+
+} // namespace
+
+TEST_F(TraceTest, SetAndGetBackend)
+{
+    EXPECT_EQ(nullptr, get_trace_backend());
+    set_trace_backend(&backend_);
+    EXPECT_EQ(&backend_, get_trace_backend());
+    set_trace_backend(nullptr);
+    EXPECT_EQ(nullptr, get_trace_backend());
+}
+
+TEST_F(TraceTest, ScopeEndsOnBackendItBeganOn)
+{
+    static constexpr TraceZone zone{"zone", __FILE__, __LINE__};
+    RecordingBackend other;
+    set_trace_backend(&backend_);
+    {
+        detail::TraceScope scope(zone, "text");
+        set_trace_backend(&other);
+    }
+    ASSERT_EQ(2u, backend_.events.size());
+    EXPECT_EQ("+zone:text", backend_.events[0]);
+    EXPECT_EQ("-zone", backend_.events[1]);
+    EXPECT_TRUE(other.events.empty());
+}
+
+TEST_F(TraceTest, UpdateIsTraced)
+{
+#if VELK_ENABLE_TRACING
+    set_trace_backend(&backend_);
+    instance().update();
+    set_trace_backend(nullptr);
+    ASSERT_FALSE(backend_.events.empty());
+    EXPECT_EQ("+VelkInstance::update", backend_.events.front());
+    EXPECT_EQ("-VelkInstance::update", backend_.events.back());
+    EXPECT_TRUE(backend_.has("+BindingRegistry::evaluate"));
+    EXPECT_EQ(3u, backend_.counters.size());
+#else
+    GTEST_SKIP() << "Built without VELK_ENABLE_TRACING";
+#endif
+}
+
+TEST_F(TraceTest, RecordingWritesChromeTrace)
+{
+    static constexpr TraceZone outer{"outer", __FILE__, __LINE__};
+    static constexpr TraceZone inner{"inner", __FILE__, __LINE__};
+    start_trace_recording();
+    {
+        detail::TraceScope a(outer, "with \"quotes\"");
+        detail::TraceScope b(inner);
+        detail::trace_counter("items", 42);
+    }
+    std::thread([] { detail::TraceScope a(outer); }).join();
+    stop_trace_recording();
+    EXPECT_EQ(nullptr, get_trace_backend());
+
+    auto path = ::testing::TempDir() + "velk_trace.json";
+    ASSERT_TRUE(write_trace_recording(path.c_str()));
+    auto json = read_file(path);
+    EXPECT_EQ(0u, json.find("{\"traceEvents\":["));
+    EXPECT_EQ(3u, count(json, "\"ph\":\"B\""));
+    EXPECT_EQ(3u, count(json, "\"ph\":\"E\""));
+    EXPECT_EQ(4u, count(json, "\"name\":\"outer\""));
+    EXPECT_NE(std::string::npos, json.find("\"text\":\"with \\\"quotes\\\"\""));
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"items\",\"cat\":\"velk\",\"pid\":1,\"tid\":1"));
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"value\":42}"));
+    EXPECT_NE(std::string::npos, json.find("\"tid\":2"));
+    EXPECT_NE(std::string::npos, json.find("\"droppedEvents\":\"0\""));
+}
+
+TEST_F(TraceTest, FullBufferKeepsZonesBalanced)
+{
+    static constexpr TraceZone zone{"zone", __FILE__, __LINE__};
+    start_trace_recording(6);
+    {
+        detail::TraceScope a(zone);
+        detail::TraceScope b(zone);
+        detail::TraceScope c(zone);
+        detail::TraceScope d(zone); // No room left next to the ends of the open zones.
+    }
+    {
+        detail::TraceScope e(zone); // The buffer is full.
+    }
+
+    auto path = ::testing::TempDir() + "velk_trace_full.json";
+    ASSERT_TRUE(write_trace_recording(path.c_str()));
+    auto json = read_file(path);
+    EXPECT_EQ(3u, count(json, "\"ph\":\"B\""));
+    EXPECT_EQ(3u, count(json, "\"ph\":\"E\""));
+    EXPECT_NE(std::string::npos, json.find("\"droppedEvents\":\"2\""));
+}
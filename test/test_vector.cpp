@@ -591,3 +591,76 @@ TEST(Vector, ManyPushBacks)
         EXPECT_EQ(v[i], i);
     }
 }
+
+// small_vector
+
+TEST(SmallVector, StaysInlineUpToN)
+{
+    small_vector<int, 4> v;
+    EXPECT_TRUE(v.is_inline());
+    EXPECT_EQ(v.capacity(), 4u);
+    for (int i = 0; i < 4; ++i) {
+        v.push_back(i);
+    }
+    EXPECT_TRUE(v.is_inline());
+    v.push_back(4);
+    EXPECT_FALSE(v.is_inline());
+    EXPECT_EQ(v.capacity(), 8u);
+    ASSERT_EQ(v.size(), 5u);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(v[i], i);
+    }
+    v.clear();
+    EXPECT_FALSE(v.is_inline());
+    EXPECT_EQ(v.capacity(), 8u);
+}
+
+TEST(SmallVector, InsertAndErase)
+{
+    small_vector<std::string, 2> v{"a", "c"};
+    v.insert(v.begin() + 1, "b");
+    EXPECT_FALSE(v.is_inline());
+    ASSERT_EQ(v.size(), 3u);
+    EXPECT_EQ(v[1], "b");
+    // Appending an element of the vector itself survives the reallocation.
+    v.push_back(v[0]);
+    v.push_back(v[0]);
+    ASSERT_EQ(v.size(), 5u);
+    EXPECT_EQ(v.back(), "a");
+    v.erase(v.begin());
+    v.erase(v.begin() + 2, v.end());
+    ASSERT_EQ(v.size(), 2u);
+    EXPECT_EQ(v[0], "b");
+    EXPECT_EQ(v[1], "c");
+}
+
+TEST(SmallVector, MoveInlineAndHeap)
+{
+    Tracked::alive = 0;
+    {
+        small_vector<Tracked, 2> small;
+        small.emplace_back(1);
+        small_vector<Tracked, 2> moved(std::move(small));
+        EXPECT_TRUE(moved.is_inline());
+        EXPECT_TRUE(small.empty());
+        EXPECT_EQ(moved[0].value, 1);
+        EXPECT_EQ(Tracked::alive, 1);
+
+        small_vector<Tracked, 2> big;
+        for (int i = 0; i < 3; ++i) {
+            big.emplace_back(i);
+        }
+        const Tracked* data = big.data();
+        moved = std::move(big);
+        EXPECT_EQ(moved.data(), data);
+        EXPECT_TRUE(big.empty());
+        EXPECT_TRUE(big.is_inline());
+        EXPECT_EQ(Tracked::alive, 3);
+
+        small_vector<Tracked, 2> copy(moved);
+        EXPECT_TRUE(copy == moved);
+        copy.resize(1);
+        EXPECT_EQ(Tracked::alive, 4);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
@@ -39,6 +39,8 @@ typedef struct velk_object_s*    velk_object;
 typedef struct velk_property_s*  velk_property;
 typedef struct velk_event_s*     velk_event;
 typedef struct velk_function_s*  velk_function;
+typedef struct velk_hive_store_s* velk_hive_store;
+typedef struct velk_hive_s*      velk_hive;
 
 /* 128-bit UID, passed by value */
 typedef struct velk_uid
@@ -115,6 +117,65 @@ VELK_C_API velk_event velk_get_event(velk_object obj, const char* name);
  */
 VELK_C_API velk_function velk_get_function(velk_object obj, const char* name);
 
+/* Metadata: lookup by member id */
+
+/**
+ * @brief Identifier of a member name (matches velk::MemberId).
+ *
+ * The id is a hash of the name, so it is the same in every process and needs no registration.
+ * Bindings that look up the same names repeatedly compute the id once with velk_member_id_of()
+ * and use the *_by_id lookups, which neither hash nor compare names.
+ */
+typedef uint64_t velk_member_id;
+
+/** @brief Returns the member id of @p name, or 0 if @p name is NULL. */
+VELK_C_API velk_member_id velk_member_id_of(const char* name);
+
+/** @brief Like velk_get_property(), but looks the property up by member id. */
+VELK_C_API velk_property velk_get_property_by_id(velk_object obj, velk_member_id id);
+
+/** @brief Like velk_get_event(), but looks the event up by member id. */
+VELK_C_API velk_event velk_get_event_by_id(velk_object obj, velk_member_id id);
+
+/** @brief Like velk_get_function(), but looks the function up by member id. */
+VELK_C_API velk_function velk_get_function_by_id(velk_object obj, velk_member_id id);
+
+/* Metadata: access by member index */
+
+/** @brief Returned by velk_resolve_member() for a name the class has no member of. */
+#define VELK_NO_MEMBER ((size_t)-1)
+
+/**
+ * @brief Returns the index of the member @p name of the class @p class_id, or VELK_NO_MEMBER.
+ *
+ * The index is the same for every object of the class, so a binding resolves it once per class
+ * and then reaches the member with the *_at functions, which do no lookup at all.
+ */
+VELK_C_API size_t velk_resolve_member(velk_uid class_id, const char* name);
+
+/** @brief Like velk_get_property(), but takes the index from velk_resolve_member(). */
+VELK_C_API velk_property velk_property_at(velk_object obj, size_t index);
+
+/** @brief Like velk_get_event(), but takes the index from velk_resolve_member(). */
+VELK_C_API velk_event velk_event_at(velk_object obj, size_t index);
+
+/** @brief Like velk_get_function(), but takes the index from velk_resolve_member(). */
+VELK_C_API velk_function velk_function_at(velk_object obj, size_t index);
+
+/**
+ * @brief Like velk_property_get() on the property at @p index of @p obj, without creating a
+ *        handle. Returns VELK_INVALID_ARG if the member at @p index is not a property.
+ */
+VELK_C_API velk_result velk_property_get_at(velk_object obj, size_t index, void* out, size_t size,
+                                            velk_uid type);
+
+/**
+ * @brief Like velk_property_set() on the property at @p index of @p obj, without creating a
+ *        handle. Returns VELK_INVALID_ARG if the member at @p index is not a property.
+ */
+VELK_C_API velk_result velk_property_set_at(velk_object obj, size_t index, const void* data, size_t size,
+                                            velk_uid type);
+
 /* Property get/set (type-erased) */
 
 /**
@@ -146,6 +207,77 @@ VELK_C_API velk_result velk_property_set_double(velk_property prop, double value
 VELK_C_API velk_result velk_property_get_bool(velk_property prop, int32_t* out);
 VELK_C_API velk_result velk_property_set_bool(velk_property prop, int32_t value);
 
+/* Batched property get/set */
+
+/**
+ * @brief Reads the values of @p count properties into one buffer.
+ *
+ * Value i, of type types[i] and sizes[i] bytes, is written to @p out right after value i - 1, so
+ * that a binding marshals one contiguous buffer instead of making a call per property.
+ * @param results  If not NULL, receives the result of each property.
+ * @return VELK_SUCCESS if every value was read, otherwise the first failing result.
+ */
+VELK_C_API velk_result velk_properties_get(const velk_property* props, const velk_uid* types,
+                                           const size_t* sizes, void* out, size_t count,
+                                           velk_result* results);
+
+/**
+ * @brief Writes the values of @p count properties from one buffer laid out as for
+ *        velk_properties_get().
+ *
+ * All values are written before any on_changed fires; then each changed property notifies once,
+ * in the order given. A property listed more than once takes its last value and notifies once,
+ * at its first position.
+ * @param results  If not NULL, receives the result of each property.
+ * @return VELK_SUCCESS if no write failed, otherwise the first failing result.
+ */
+VELK_C_API velk_result velk_properties_set(const velk_property* props, const velk_uid* types,
+                                           const size_t* sizes, const void* data, size_t count,
+                                           velk_result* results);
+
+/** @brief velk_properties_get() for @p count float properties. */
+VELK_C_API velk_result velk_properties_get_float(const velk_property* props, float* out, size_t count);
+/** @brief velk_properties_set() for @p count float properties. */
+VELK_C_API velk_result velk_properties_set_float(const velk_property* props, const float* values,
+                                                 size_t count);
+
+/* Array property access */
+
+/** @brief Elements of an array property, filled by the velk_array_property_lock_* functions. */
+typedef struct velk_array_view
+{
+    void* data;          /**< First element. May be NULL if the array is empty. */
+    size_t element_size; /**< Size of an element in bytes. */
+    size_t count;        /**< Number of elements. */
+} velk_array_view;
+
+/**
+ * @brief Exposes the elements of an array property without copying them.
+ *
+ * The elements stay valid, and the property alive, until velk_array_property_unlock_read().
+ * They must not be written, and the array must not be modified in between.
+ * @param element_type  Type UID of the elements.
+ * @return VELK_INVALID_ARG if @p prop is not an array property of @p element_type.
+ */
+VELK_C_API velk_result velk_array_property_lock_read(velk_property prop, velk_uid element_type,
+                                                     velk_array_view* out);
+
+/** @brief Ends a velk_array_property_lock_read(). */
+VELK_C_API void velk_array_property_unlock_read(velk_property prop);
+
+/**
+ * @brief Like velk_array_property_lock_read(), but the elements may be written in place.
+ *
+ * The size of the array cannot change through the view. velk_array_property_unlock_write()
+ * fires on_changed once for all writes.
+ * @return VELK_READ_ONLY if the property is read-only.
+ */
+VELK_C_API velk_result velk_array_property_lock_write(velk_property prop, velk_uid element_type,
+                                                      velk_array_view* out);
+
+/** @brief Ends a velk_array_property_lock_write() and notifies on_changed. */
+VELK_C_API velk_result velk_array_property_unlock_write(velk_property prop);
+
 /**
  * @brief Returns the on_changed event for a property.
  * The returned handle has one reference; caller must velk_release() it.
@@ -191,6 +323,49 @@ VELK_C_API void velk_args_set_bool(velk_args args, size_t index, int32_t value);
  */
 VELK_C_API velk_result velk_invoke_args(velk_function fn, velk_args args);
 
+/* Packed function arguments */
+
+/** @brief Type tags of velk_arg. */
+#define VELK_ARG_FLOAT  ((int32_t)0)
+#define VELK_ARG_INT32  ((int32_t)1)
+#define VELK_ARG_DOUBLE ((int32_t)2)
+#define VELK_ARG_BOOL   ((int32_t)3)
+
+/** @brief Maximum number of arguments accepted by velk_invoke_packed(). */
+#define VELK_MAX_PACKED_ARGS 16
+
+/**
+ * @brief A tagged scalar argument for velk_invoke_packed().
+ *
+ * Plain data, so an argument list is an array the caller places on its own stack.
+ */
+typedef struct velk_arg
+{
+    int32_t type; /**< One of the VELK_ARG_* tags. */
+    union
+    {
+        float f;
+        int32_t i;
+        double d;
+        int32_t b; /**< 0 = false, nonzero = true. */
+    } value;
+} velk_arg;
+
+static inline velk_arg velk_arg_float(float v) { velk_arg a; a.type = VELK_ARG_FLOAT; a.value.f = v; return a; }
+static inline velk_arg velk_arg_int32(int32_t v) { velk_arg a; a.type = VELK_ARG_INT32; a.value.i = v; return a; }
+static inline velk_arg velk_arg_double(double v) { velk_arg a; a.type = VELK_ARG_DOUBLE; a.value.d = v; return a; }
+static inline velk_arg velk_arg_bool(int32_t v) { velk_arg a; a.type = VELK_ARG_BOOL; a.value.b = v; return a; }
+
+/**
+ * @brief Invokes a function with @p count arguments read from @p args, without allocating.
+ *
+ * Equivalent to velk_invoke_args(), but the arguments are viewed in place instead of being
+ * copied into reference counted values.
+ * @return VELK_INVALID_ARG if @p count exceeds VELK_MAX_PACKED_ARGS or an argument has an
+ *         unknown type tag.
+ */
+VELK_C_API velk_result velk_invoke_packed(velk_function fn, const velk_arg* args, size_t count);
+
 /* Events/callbacks */
 
 /**
@@ -212,6 +387,70 @@ VELK_C_API velk_result velk_event_add(velk_event evt, velk_function handler);
 /** @brief Removes a handler from an event. */
 VELK_C_API velk_result velk_event_remove(velk_event evt, velk_function handler);
 
+/* Hives */
+
+/**
+ * @brief Creates a hive store, which holds one object hive per class.
+ * Returns a handle with one reference; caller must velk_release() it.
+ */
+VELK_C_API velk_hive_store velk_hive_store_create(void);
+
+/**
+ * @brief Returns the hive of the class @p class_id in @p store, creating it if it does not exist.
+ * Returns NULL if @p store is NULL. The returned handle has one reference.
+ */
+VELK_C_API velk_hive velk_hive_get(velk_hive_store store, velk_uid class_id);
+
+/** @brief Like velk_hive_get(), but returns NULL if the class has no hive yet. */
+VELK_C_API velk_hive velk_hive_find(velk_hive_store store, velk_uid class_id);
+
+/** @brief Returns the number of live objects in @p hive. */
+VELK_C_API size_t velk_hive_size(velk_hive hive);
+
+/**
+ * @brief Creates an object in @p hive. Returns NULL on failure.
+ * The returned handle has one reference; the hive holds another until velk_hive_remove().
+ */
+VELK_C_API velk_object velk_hive_add(velk_hive hive);
+
+/** @brief Removes @p obj from @p hive. Returns VELK_FAIL if it is not in the hive. */
+VELK_C_API velk_result velk_hive_remove(velk_hive hive, velk_object obj);
+
+/** @brief Returned by velk_state_field_offset() for a name the class has no property of. */
+#define VELK_NO_FIELD ((size_t)-1)
+
+/**
+ * @brief Returns the byte offset of the property @p name in the State struct of its interface.
+ *
+ * The offset is a property of the class, so a binding resolves it once and reads the field
+ * from every state pointer handed to a velk_hive_state_fn.
+ * @param interface_id  If not NULL, receives the UID of the interface whose State holds the field.
+ * @return The offset, or VELK_NO_FIELD.
+ */
+VELK_C_API size_t velk_state_field_offset(velk_uid class_id, const char* name, velk_uid* interface_id);
+
+/**
+ * @brief Callback for velk_hive_for_each_state().
+ * @param user_data  Opaque pointer passed to velk_hive_for_each_state().
+ * @param obj        The object. Not acquired: valid only for the duration of the call.
+ * @param state      The State struct of the iterated interface in @p obj.
+ * @return Nonzero to continue, 0 to stop.
+ */
+typedef int32_t (*velk_hive_state_fn)(void* user_data, velk_object obj, void* state);
+
+/**
+ * @brief Visits every live object of @p hive with a pointer to its State of @p interface_id.
+ *
+ * The state pointer is computed with one add per object, with no interface query or virtual
+ * call, so the callback can read and write fields at the offsets from velk_state_field_offset()
+ * directly. Writes through the pointer do not fire on_changed. The hive must not be modified
+ * from the callback.
+ * @return VELK_INVALID_ARG if the objects of the hive have no State for @p interface_id, whether
+ *         or not it is empty, otherwise VELK_NOTHING_TO_DO if the hive is empty.
+ */
+VELK_C_API velk_result velk_hive_for_each_state(velk_hive hive, velk_uid interface_id,
+                                                velk_hive_state_fn fn, void* user_data);
+
 /* Update loop */
 
 /**
@@ -220,6 +459,23 @@ VELK_C_API velk_result velk_event_remove(velk_event evt, velk_function handler);
  */
 VELK_C_API void velk_update(int64_t time_us);
 
+/* Tracing */
+
+/**
+ * @brief Starts recording trace zones in memory (see velk::start_trace_recording()).
+ * @param capacity  Events recorded per thread. Pass 0 for the default.
+ */
+VELK_C_API void velk_trace_start(size_t capacity);
+
+/** @brief Stops the recording, keeping its events. */
+VELK_C_API void velk_trace_stop(void);
+
+/**
+ * @brief Writes the recorded events as a Chrome trace_event JSON file.
+ * @return VELK_FAIL if no recording was started or the file could not be written.
+ */
+VELK_C_API velk_result velk_trace_write(const char* path);
+
 /* Well-known type UIDs */
 
 VELK_C_API extern const velk_uid VELK_TYPE_FLOAT;
@@ -235,11 +491,15 @@ inline void velk_acquire(velk_object    h) { velk_acquire(reinterpret_cast<velk_
 inline void velk_acquire(velk_property  h) { velk_acquire(reinterpret_cast<velk_interface>(h)); }
 inline void velk_acquire(velk_event     h) { velk_acquire(reinterpret_cast<velk_interface>(h)); }
 inline void velk_acquire(velk_function  h) { velk_acquire(reinterpret_cast<velk_interface>(h)); }
+inline void velk_acquire(velk_hive_store h) { velk_acquire(reinterpret_cast<velk_interface>(h)); }
+inline void velk_acquire(velk_hive      h) { velk_acquire(reinterpret_cast<velk_interface>(h)); }
 
 inline void velk_release(velk_object    h) { velk_release(reinterpret_cast<velk_interface>(h)); }
 inline void velk_release(velk_property  h) { velk_release(reinterpret_cast<velk_interface>(h)); }
 inline void velk_release(velk_event     h) { velk_release(reinterpret_cast<velk_interface>(h)); }
 inline void velk_release(velk_function  h) { velk_release(reinterpret_cast<velk_interface>(h)); }
+inline void velk_release(velk_hive_store h) { velk_release(reinterpret_cast<velk_interface>(h)); }
+inline void velk_release(velk_hive      h) { velk_release(reinterpret_cast<velk_interface>(h)); }
 
 inline velk_interface velk_cast(velk_object h, velk_uid id)
 {
@@ -1,9 +1,12 @@
 #include <velk_c.h>
 
+#include <velk/api/hive/object_hive.h>
 #include <velk/api/velk.h>
 #include <velk/common.h>
 #include <velk/ext/any.h>
+#include <velk/interface/hive/intf_hive_store.h>
 #include <velk/interface/intf_any.h>
+#include <velk/interface/intf_array_any.h>
 #include <velk/interface/intf_event.h>
 #include <velk/interface/intf_function.h>
 #include <velk/interface/intf_metadata.h>
@@ -11,9 +14,13 @@
 #include <velk/interface/intf_property.h>
 #include <velk/interface/intf_velk.h>
 #include <velk/interface/types.h>
+#include <velk/trace.h>
 #include <velk/uid.h>
+#include <velk/vector.h>
 
+#include <algorithm>
 #include <cstring>
+#include <utility>
 
 using namespace velk;
 
@@ -168,6 +175,124 @@ velk_function velk_get_function(velk_object obj, const char* name)
     return to_handle<velk_function>(fn);
 }
 
+// Metadata lookup by member id
+
+velk_member_id velk_member_id_of(const char* name)
+{
+    return name ? MemberId(string_view(name, strlen(name))).hash : 0;
+}
+
+template <class T>
+static shared_ptr<T> get_member_by_id(velk_object obj, velk_member_id id, MemberKind kind)
+{
+    if (!obj) {
+        return nullptr;
+    }
+    auto* meta = interface_cast<IMetadata>(from_handle(reinterpret_cast<velk_interface>(obj)));
+    MemberId memberId;
+    memberId.hash = id;
+    return get_member<T>(meta, memberId, kind);
+}
+
+velk_property velk_get_property_by_id(velk_object obj, velk_member_id id)
+{
+    return to_handle<velk_property>(get_member_by_id<IProperty>(obj, id, MemberKind::Property));
+}
+
+velk_event velk_get_event_by_id(velk_object obj, velk_member_id id)
+{
+    return to_handle<velk_event>(get_member_by_id<IEvent>(obj, id, MemberKind::Event));
+}
+
+velk_function velk_get_function_by_id(velk_object obj, velk_member_id id)
+{
+    return to_handle<velk_function>(get_member_by_id<IFunction>(obj, id, MemberKind::Function));
+}
+
+// Metadata access by member index
+
+size_t velk_resolve_member(velk_uid class_id, const char* name)
+{
+    if (!name) {
+        return VELK_NO_MEMBER;
+    }
+    auto* info = ::velk::instance().type_registry().get_class_info(to_uid(class_id));
+    if (!info) {
+        return VELK_NO_MEMBER;
+    }
+    string_view n(name, strlen(name));
+    for (size_t i = 0; i < info->members.size(); ++i) {
+        if (info->members[i].name == n) {
+            return i;
+        }
+    }
+    return VELK_NO_MEMBER;
+}
+
+// Returns the member at index of obj if it is of one of kinds, else null.
+static IInterface::Ptr get_member_at(velk_object obj, size_t index, uint32_t kinds)
+{
+    if (!obj) {
+        return nullptr;
+    }
+    auto* meta = interface_cast<IMetadata>(from_handle(reinterpret_cast<velk_interface>(obj)));
+    if (!meta) {
+        return nullptr;
+    }
+    auto members = meta->get_static_metadata();
+    if (index >= members.size() || !(kinds & member_kind_bit(members[index].kind))) {
+        return nullptr;
+    }
+    return meta->get_member_at(index);
+}
+
+static constexpr uint32_t property_kinds = MemberKinds::Property | MemberKinds::ArrayProperty;
+
+velk_property velk_property_at(velk_object obj, size_t index)
+{
+    return to_handle<velk_property>(
+        interface_pointer_cast<IProperty>(get_member_at(obj, index, property_kinds)));
+}
+
+velk_event velk_event_at(velk_object obj, size_t index)
+{
+    return to_handle<velk_event>(
+        interface_pointer_cast<IEvent>(get_member_at(obj, index, MemberKinds::Event)));
+}
+
+velk_function velk_function_at(velk_object obj, size_t index)
+{
+    return to_handle<velk_function>(
+        interface_pointer_cast<IFunction>(get_member_at(obj, index, MemberKinds::Function)));
+}
+
+velk_result velk_property_get_at(velk_object obj, size_t index, void* out, size_t size, velk_uid type)
+{
+    if (!out) {
+        return VELK_INVALID_ARG;
+    }
+    auto member = get_member_at(obj, index, property_kinds);
+    auto* p = interface_cast<IProperty>(member);
+    if (!p) {
+        return VELK_INVALID_ARG;
+    }
+    auto value = p->borrow_value();
+    return value ? static_cast<velk_result>(value->get_data(out, size, to_uid(type))) : VELK_FAIL;
+}
+
+velk_result velk_property_set_at(velk_object obj, size_t index, const void* data, size_t size, velk_uid type)
+{
+    if (!data) {
+        return VELK_INVALID_ARG;
+    }
+    auto member = get_member_at(obj, index, property_kinds);
+    auto* pi = interface_cast<IPropertyInternal>(member);
+    if (!pi) {
+        return VELK_INVALID_ARG;
+    }
+    return static_cast<velk_result>(pi->set_data(data, size, to_uid(type)));
+}
+
 // Property get/set (type-erased)
 
 velk_result velk_property_get(velk_property prop, void* out, size_t size, velk_uid type)
@@ -195,6 +320,212 @@ velk_result velk_property_set(velk_property prop, const void* data, size_t size,
     return static_cast<velk_result>(pi->set_data(data, size, to_uid(type)));
 }
 
+// Batched property get/set
+
+namespace {
+
+/**
+ * @brief Read-only any over a value in the buffer of velk_properties_set().
+ *
+ * Like PackedArgView, it lives on the stack and is not reference counted.
+ */
+class RawValueView final : public ext::InterfaceDispatch<IAny>
+{
+public:
+    void set_target(const void* data, size_t size, Uid type)
+    {
+        data_ = data;
+        size_ = size;
+        type_ = type;
+    }
+
+public: // IObject
+    Uid get_class_uid() const override { return type_; }
+    string_view get_class_name() const override { return ::velk::get_name<RawValueView>(); }
+    IObject::Ptr get_self() const override { return nullptr; }
+    uint32_t get_object_flags() const override { return ObjectFlags::None; }
+
+public: // IAny
+    array_view<Uid> get_compatible_types() const override { return {&type_, 1}; }
+    size_t get_data_size(Uid type) const override { return type == type_ ? size_ : 0; }
+    ReturnValue get_data(void* to, size_t toSize, Uid type) const override
+    {
+        if (!to || type != type_ || toSize != size_) {
+            return ReturnValue::Fail;
+        }
+        std::memcpy(to, data_, toSize);
+        return ReturnValue::Success;
+    }
+    ReturnValue set_data(void const*, size_t, Uid) override { return ReturnValue::ReadOnly; }
+    ReturnValue copy_from(const IAny&) override { return ReturnValue::ReadOnly; }
+    IAny::Ptr clone() const override
+    {
+        auto c = ::velk::instance().create_any(type_);
+        return c && succeeded(c->copy_from(*this)) ? c : nullptr;
+    }
+
+private:
+    const void* data_{};
+    size_t size_{};
+    Uid type_;
+};
+
+/** @brief Type and size of each value of a batch, as passed to velk_properties_get(). */
+struct PerValueLayout
+{
+    const velk_uid* types;
+    const size_t* sizes;
+
+    Uid type(size_t i) const { return to_uid(types[i]); }
+    size_t size(size_t i) const { return sizes[i]; }
+};
+
+/** @brief Layout of a batch whose values all have one type, as for velk_properties_get_float(). */
+struct UniformLayout
+{
+    Uid type_uid;
+    size_t value_size;
+
+    Uid type(size_t) const { return type_uid; }
+    size_t size(size_t) const { return value_size; }
+};
+
+// Records result as the result of property i, and as the batch result if it is the first failure.
+void record_result(velk_result result, size_t i, velk_result* results, velk_result& first)
+{
+    if (results) {
+        results[i] = result;
+    }
+    if (result < 0 && first >= 0) {
+        first = result;
+    }
+}
+
+/// Properties changed by one velk_properties_set() call; typical batches need no allocation.
+using ChangedProperties = small_vector<IPropertyInternal*, 64>;
+
+/** @brief Clears the repeats of a property listed more than once, keeping its first position. */
+void drop_repeats(ChangedProperties& changed)
+{
+    small_vector<std::pair<IPropertyInternal*, size_t>, 64> order;
+    for (size_t i = 0; i < changed.size(); ++i) {
+        order.push_back({changed[i], i});
+    }
+    // Sorted by property and then position, so each run starts with the first occurrence.
+    std::sort(order.begin(), order.end());
+    for (size_t i = 1; i < order.size(); ++i) {
+        if (order[i].first == order[i - 1].first) {
+            changed[order[i].second] = nullptr;
+        }
+    }
+}
+
+template <class Layout>
+velk_result get_properties(const velk_property* props, const Layout& layout, void* out, size_t count,
+                           velk_result* results)
+{
+    velk_result first = VELK_SUCCESS;
+    auto* cursor = static_cast<char*>(out);
+    for (size_t i = 0; i < count; ++i) {
+        velk_result result = VELK_INVALID_ARG;
+        if (props[i]) {
+            auto* p = static_cast<IProperty*>(from_handle(reinterpret_cast<velk_interface>(props[i])));
+            // Borrowed, to spare the reference count of the value.
+            auto value = p->borrow_value();
+            result = value ? static_cast<velk_result>(value->get_data(cursor, layout.size(i), layout.type(i)))
+                           : VELK_FAIL;
+        }
+        record_result(result, i, results, first);
+        cursor += layout.size(i);
+    }
+    return first;
+}
+
+template <class Layout>
+velk_result set_properties(const velk_property* props, const Layout& layout, const void* data, size_t count,
+                           velk_result* results)
+{
+    velk_result first = VELK_SUCCESS;
+    RawValueView view;
+    ChangedProperties changed;
+    auto* cursor = static_cast<const char*>(data);
+    for (size_t i = 0; i < count; ++i) {
+        velk_result result = VELK_INVALID_ARG;
+        if (props[i]) {
+            auto* pi =
+                interface_cast<IPropertyInternal>(from_handle(reinterpret_cast<velk_interface>(props[i])));
+            result = VELK_FAIL;
+            if (pi) {
+                view.set_target(cursor, layout.size(i), layout.type(i));
+                result = static_cast<velk_result>(pi->set_value_silent(view));
+                if (result == VELK_SUCCESS) {
+                    changed.push_back(pi);
+                }
+            }
+        }
+        record_result(result, i, results, first);
+        cursor += layout.size(i);
+    }
+    if (changed.size() > 1) {
+        drop_repeats(changed);
+    }
+    // The caller's handles keep the properties alive through the notifications.
+    for (auto* pi : changed) {
+        if (pi) {
+            pi->notify_changed();
+        }
+    }
+    return first;
+}
+
+} // namespace
+
+velk_result velk_properties_get(const velk_property* props, const velk_uid* types, const size_t* sizes,
+                                void* out, size_t count, velk_result* results)
+{
+    if (!count) {
+        return VELK_SUCCESS;
+    }
+    if (!props || !types || !sizes || !out) {
+        return VELK_INVALID_ARG;
+    }
+    return get_properties(props, PerValueLayout{types, sizes}, out, count, results);
+}
+
+velk_result velk_properties_set(const velk_property* props, const velk_uid* types, const size_t* sizes,
+                                const void* data, size_t count, velk_result* results)
+{
+    if (!count) {
+        return VELK_SUCCESS;
+    }
+    if (!props || !types || !sizes || !data) {
+        return VELK_INVALID_ARG;
+    }
+    return set_properties(props, PerValueLayout{types, sizes}, data, count, results);
+}
+
+velk_result velk_properties_get_float(const velk_property* props, float* out, size_t count)
+{
+    if (!count) {
+        return VELK_SUCCESS;
+    }
+    if (!props || !out) {
+        return VELK_INVALID_ARG;
+    }
+    return get_properties(props, UniformLayout{type_uid<float>(), sizeof(float)}, out, count, nullptr);
+}
+
+velk_result velk_properties_set_float(const velk_property* props, const float* values, size_t count)
+{
+    if (!count) {
+        return VELK_SUCCESS;
+    }
+    if (!props || !values) {
+        return VELK_INVALID_ARG;
+    }
+    return set_properties(props, UniformLayout{type_uid<float>(), sizeof(float)}, values, count, nullptr);
+}
+
 // Property get/set (typed convenience)
 
 velk_result velk_property_get_float(velk_property prop, float* out)
@@ -254,6 +585,62 @@ velk_result velk_property_set_bool(velk_property prop, int32_t value)
     return velk_property_set(prop, &tmp, sizeof(bool), t);
 }
 
+// Array property access
+
+static velk_result lock_array(velk_property prop, velk_uid element_type, velk_array_view* out, bool write)
+{
+    if (!prop || !out) {
+        return VELK_INVALID_ARG;
+    }
+    auto* intf = from_handle(reinterpret_cast<velk_interface>(prop));
+    auto* p = static_cast<IProperty*>(intf);
+    auto value = p->borrow_value();
+    auto* aa = interface_cast<IArrayAny>(value.get());
+    auto uid = to_uid(element_type);
+    size_t size = aa ? aa->array_element_size(uid) : 0;
+    if (!size) {
+        return VELK_INVALID_ARG;
+    }
+    auto* obj = interface_cast<IObject>(intf);
+    if (write && obj && (obj->get_object_flags() & ObjectFlags::ReadOnly)) {
+        return VELK_READ_ONLY;
+    }
+    // The elements live in the object's State, which the caller may write through the view.
+    out->data = const_cast<void*>(aa->array_data(uid));
+    out->element_size = size;
+    out->count = aa->array_size();
+    intf->ref();
+    return VELK_SUCCESS;
+}
+
+velk_result velk_array_property_lock_read(velk_property prop, velk_uid element_type, velk_array_view* out)
+{
+    return lock_array(prop, element_type, out, false);
+}
+
+void velk_array_property_unlock_read(velk_property prop)
+{
+    velk_release(prop);
+}
+
+velk_result velk_array_property_lock_write(velk_property prop, velk_uid element_type, velk_array_view* out)
+{
+    return lock_array(prop, element_type, out, true);
+}
+
+velk_result velk_array_property_unlock_write(velk_property prop)
+{
+    if (!prop) {
+        return VELK_INVALID_ARG;
+    }
+    auto* intf = from_handle(reinterpret_cast<velk_interface>(prop));
+    auto* pi = interface_cast<IPropertyInternal>(intf);
+    // Notified without a recorded change, the array property reports a Reset.
+    auto result = pi ? static_cast<velk_result>(pi->notify_changed()) : VELK_FAIL;
+    intf->unref();
+    return result;
+}
+
 // Property on_changed
 
 velk_event velk_property_on_changed(velk_property prop)
@@ -357,6 +744,95 @@ velk_result velk_invoke_args(velk_function fn, velk_args args)
     return VELK_SUCCESS;
 }
 
+// Packed function arguments
+
+namespace {
+
+/**
+ * @brief Read-only any over a velk_arg, which like ext::AnyArg is not reference counted.
+ *
+ * Bools are converted on bind, so the viewed value has the layout of its C++ type.
+ */
+class PackedArgView final : public ext::InterfaceDispatch<IAny>
+{
+public:
+    bool bind(const velk_arg& arg)
+    {
+        switch (arg.type) {
+        case VELK_ARG_FLOAT:
+            return bind(&arg.value.f, sizeof(float), type_uid<float>());
+        case VELK_ARG_INT32:
+            return bind(&arg.value.i, sizeof(int32_t), type_uid<int>());
+        case VELK_ARG_DOUBLE:
+            return bind(&arg.value.d, sizeof(double), type_uid<double>());
+        case VELK_ARG_BOOL:
+            bool_ = arg.value.b != 0;
+            return bind(&bool_, sizeof(bool), type_uid<bool>());
+        default:
+            return false;
+        }
+    }
+
+public: // IObject
+    Uid get_class_uid() const override { return type_; }
+    string_view get_class_name() const override { return ::velk::get_name<PackedArgView>(); }
+    IObject::Ptr get_self() const override { return nullptr; }
+    uint32_t get_object_flags() const override { return ObjectFlags::None; }
+
+public: // IAny
+    array_view<Uid> get_compatible_types() const override { return {&type_, 1}; }
+    size_t get_data_size(Uid type) const override { return type == type_ ? size_ : 0; }
+    ReturnValue get_data(void* to, size_t toSize, Uid type) const override
+    {
+        if (!to || type != type_ || toSize != size_) {
+            return ReturnValue::Fail;
+        }
+        std::memcpy(to, data_, toSize);
+        return ReturnValue::Success;
+    }
+    ReturnValue set_data(void const*, size_t, Uid) override { return ReturnValue::ReadOnly; }
+    ReturnValue copy_from(const IAny&) override { return ReturnValue::ReadOnly; }
+    IAny::Ptr clone() const override
+    {
+        auto c = ::velk::instance().create_any(type_);
+        return c && succeeded(c->copy_from(*this)) ? c : nullptr;
+    }
+
+private:
+    bool bind(const void* data, size_t size, Uid type)
+    {
+        data_ = data;
+        size_ = size;
+        type_ = type;
+        return true;
+    }
+
+    const void* data_{};
+    size_t size_{};
+    Uid type_;
+    bool bool_{};
+};
+
+} // namespace
+
+velk_result velk_invoke_packed(velk_function fn, const velk_arg* args, size_t count)
+{
+    if (!fn || (count && !args) || count > VELK_MAX_PACKED_ARGS) {
+        return VELK_INVALID_ARG;
+    }
+    PackedArgView views[VELK_MAX_PACKED_ARGS];
+    const IAny* raw[VELK_MAX_PACKED_ARGS];
+    for (size_t i = 0; i < count; ++i) {
+        if (!views[i].bind(args[i])) {
+            return VELK_INVALID_ARG;
+        }
+        raw[i] = &views[i];
+    }
+    auto* f = static_cast<IFunction*>(from_handle(reinterpret_cast<velk_interface>(fn)));
+    f->invoke(FnArgs{raw, count});
+    return VELK_SUCCESS;
+}
+
 // Callbacks
 
 struct CallbackContext
@@ -425,6 +901,113 @@ velk_result velk_event_remove(velk_event evt, velk_function handler)
     return static_cast<velk_result>(e->remove_handler(fn_ptr));
 }
 
+// Hives
+
+static IObjectHive* hive_from_handle(velk_hive hive)
+{
+    return static_cast<IObjectHive*>(from_handle(reinterpret_cast<velk_interface>(hive)));
+}
+
+velk_hive_store velk_hive_store_create(void)
+{
+    auto store = ::velk::instance().create<IHiveStore>(ClassId::HiveStore);
+    return to_handle<velk_hive_store>(store);
+}
+
+velk_hive velk_hive_get(velk_hive_store store, velk_uid class_id)
+{
+    if (!store) {
+        return nullptr;
+    }
+    auto* s = static_cast<IHiveStore*>(from_handle(reinterpret_cast<velk_interface>(store)));
+    return to_handle<velk_hive>(s->get_hive(to_uid(class_id)));
+}
+
+velk_hive velk_hive_find(velk_hive_store store, velk_uid class_id)
+{
+    if (!store) {
+        return nullptr;
+    }
+    auto* s = static_cast<IHiveStore*>(from_handle(reinterpret_cast<velk_interface>(store)));
+    return to_handle<velk_hive>(s->find_hive(to_uid(class_id)));
+}
+
+size_t velk_hive_size(velk_hive hive)
+{
+    return hive ? hive_from_handle(hive)->size() : 0;
+}
+
+velk_object velk_hive_add(velk_hive hive)
+{
+    if (!hive) {
+        return nullptr;
+    }
+    return to_handle<velk_object>(hive_from_handle(hive)->add());
+}
+
+velk_result velk_hive_remove(velk_hive hive, velk_object obj)
+{
+    if (!hive || !obj) {
+        return VELK_INVALID_ARG;
+    }
+    auto* o = static_cast<IObject*>(from_handle(reinterpret_cast<velk_interface>(obj)));
+    return static_cast<velk_result>(hive_from_handle(hive)->remove(*o));
+}
+
+size_t velk_state_field_offset(velk_uid class_id, const char* name, velk_uid* interface_id)
+{
+    if (!name) {
+        return VELK_NO_FIELD;
+    }
+    auto* info = ::velk::instance().type_registry().get_class_info(to_uid(class_id));
+    if (!info) {
+        return VELK_NO_FIELD;
+    }
+    string_view n(name, strlen(name));
+    for (auto& member : info->members) {
+        if (member.name != n) {
+            continue;
+        }
+        auto* pk = member.propertyKind();
+        if (!pk || !pk->stateOffset || !member.interfaceInfo) {
+            return VELK_NO_FIELD;
+        }
+        if (interface_id) {
+            *interface_id = from_uid(member.interfaceInfo->uid);
+        }
+        return pk->stateOffset();
+    }
+    return VELK_NO_FIELD;
+}
+
+velk_result velk_hive_for_each_state(velk_hive hive, velk_uid interface_id, velk_hive_state_fn fn,
+                                     void* user_data)
+{
+    if (!hive || !fn) {
+        return VELK_INVALID_ARG;
+    }
+    auto* h = hive_from_handle(hive);
+    // The offsets come from the class, so interface_id is checked even if the hive is empty.
+    ptrdiff_t offset = h->get_state_offset(to_uid(interface_id));
+    if (offset < 0) {
+        return VELK_INVALID_ARG;
+    }
+    if (h->empty()) {
+        return VELK_NOTHING_TO_DO;
+    }
+    struct Ctx
+    {
+        velk_hive_state_fn fn;
+        void* user_data;
+    } ctx{fn, user_data};
+    h->for_each_state(offset, &ctx, [](void* c, IObject& obj, void* state) -> bool {
+        auto& ctx = *static_cast<Ctx*>(c);
+        auto handle = reinterpret_cast<velk_object>(static_cast<IInterface*>(&obj));
+        return ctx.fn(ctx.user_data, handle, state) != 0;
+    });
+    return VELK_SUCCESS;
+}
+
 // Update loop
 
 void velk_update(int64_t time_us)
@@ -432,6 +1015,23 @@ void velk_update(int64_t time_us)
     ::velk::instance().update(Duration{time_us});
 }
 
+// Tracing
+
+void velk_trace_start(size_t capacity)
+{
+    ::velk::start_trace_recording(capacity);
+}
+
+void velk_trace_stop(void)
+{
+    ::velk::stop_trace_recording();
+}
+
+velk_result velk_trace_write(const char* path)
+{
+    return ::velk::write_trace_recording(path) ? VELK_SUCCESS : VELK_FAIL;
+}
+
 // Type UID constants
 
 extern const velk_uid VELK_TYPE_FLOAT  = from_uid(type_uid<float>());
@@ -0,0 +1,191 @@
+#ifndef VELK_ALLOCATOR_H
+#define VELK_ALLOCATOR_H
+
+#include <velk/velk_export.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace velk {
+
+/** @brief The subsystem an allocation is made for, passed to IAllocator for accounting. */
+enum class MemoryTag : uint8_t
+{
+    General,       ///< Anything not covered by another tag.
+    Containers,    ///< Buffers of velk::vector, velk::small_vector and velk::string.
+    Objects,       ///< Objects created with make_object() or a default object factory.
+    ControlBlocks, ///< Reference count blocks of shared_ptr.
+    Hive,          ///< Hive pages not provided by an IHivePageSource.
+    Arena,         ///< Blocks of velk::Arena, including the frame arenas.
+    Count
+};
+
+/**
+ * @brief Hook for the memory velk allocates on the heap.
+ *
+ * All allocations go through the velk library, so memory allocated in one module and freed
+ * in another, e.g. a vector filled by a plugin and released by the host, reaches the same
+ * allocator. Implementations must be thread-safe and outlive every allocation they made.
+ *
+ * Memory obtained from an IHivePageSource, and the memory of the standard containers velk
+ * uses internally, does not go through the allocator.
+ */
+class IAllocator
+{
+public:
+    /**
+     * @brief Allocates @p size bytes aligned to @p alignment, a power of two.
+     * @return The memory, or null on failure.
+     */
+    virtual void* allocate(size_t size, size_t alignment, MemoryTag tag) = 0;
+    /** @brief Frees @p ptr, allocated by allocate() with the same @p alignment and @p tag. */
+    virtual void deallocate(void* ptr, size_t alignment, MemoryTag tag) = 0;
+
+protected:
+    ~IAllocator() = default;
+};
+
+/**
+ * @brief Routes velk heap allocations to @p allocator, or back to malloc/free if null.
+ *
+ * Must be called before anything is allocated, i.e. before the first call to instance() or
+ * the first velk container or object is created, since memory has to be freed by the
+ * allocator that allocated it.
+ *
+ * @return true if installed, false if memory was already allocated.
+ */
+VELK_EXPORT bool set_allocator(IAllocator* allocator);
+
+/** @brief Returns the installed allocator, or null if malloc/free is used. */
+VELK_EXPORT IAllocator* get_allocator();
+
+/**
+ * @brief A category of memory reported by IVelk::get_memory_stats().
+ *
+ * Categories are independent of MemoryTag and of the installed allocator. They may overlap:
+ * pooled members and any values live in hive pages, and pooled control blocks are a subset of
+ * the control blocks.
+ */
+enum class MemoryCategory : uint8_t
+{
+    HivePages,           ///< Pages of object and raw hives.
+    Metadata,            ///< Object storages and their member caches.
+    ControlBlocks,       ///< Heap-allocated shared_ptr control blocks, in use or pooled.
+    PooledControlBlocks, ///< Control blocks waiting for reuse in a block pool or the shared depot.
+    RuntimeMembers,      ///< Property, event and function instances, sampled from the object pool.
+    AnyValues,           ///< Owning any values (AnyValue<T>, ArrayAnyValue<T>).
+    DeferredQueues,      ///< Buffers of queued deferred work, sampled by get_memory_stats().
+    HierarchyEntries,    ///< Nodes of hierarchies.
+    RecycledObjects,     ///< Memory of destroyed objects kept for reuse, see VELK_RECYCLE_INSTANCES().
+    Count
+};
+
+/** @brief Live memory of one category. */
+struct MemoryCounter
+{
+    size_t bytes{}; ///< Live bytes.
+    size_t count{}; ///< Live allocations or instances.
+};
+
+/** @brief Live memory per category, see IVelk::get_memory_stats(). */
+struct MemoryStats
+{
+    MemoryCounter categories[static_cast<size_t>(MemoryCategory::Count)];
+
+    const MemoryCounter& operator[](MemoryCategory category) const
+    {
+        return categories[static_cast<size_t>(category)];
+    }
+};
+
+/**
+ * @brief Sizing of the per-thread shared_ptr control block pools, see IVelk::set_block_pool_config().
+ *
+ * Each thread keeps released control blocks in a pool of @c capacity blocks. A full pool moves a
+ * batch of 128 blocks to a depot shared by all threads, and an empty pool takes a batch from it
+ * before allocating.
+ */
+struct BlockPoolConfig
+{
+    /** @brief Blocks a thread's pool holds before moving a batch to the depot. */
+    uint32_t capacity = 256;
+    /**
+     * @brief Capacity an adaptive pool may grow to. Pools are adaptive if this exceeds
+     *        @c capacity: a pool grows by a batch for every 128 allocations it could not serve,
+     *        and releases blocks above @c capacity that went unused for @c idleUpdates.
+     */
+    uint32_t maxCapacity = 0;
+    /**
+     * @brief update() calls an adaptive pool's blocks must go unused to be released. The pool
+     *        checks when its thread next allocates or releases a control block.
+     */
+    uint32_t idleUpdates = 120;
+};
+
+/** @brief Process-wide counters of the control block pools, see IVelk::get_block_pool_stats(). */
+struct BlockPoolStats
+{
+    uint64_t hits{};      ///< Allocations served by a thread's pool.
+    uint64_t misses{};    ///< Allocations that fell back to the allocator.
+    uint64_t refills{};   ///< Batches an empty pool took from the depot.
+    uint64_t spills{};    ///< Batches a full pool moved to the depot.
+    uint64_t overflows{}; ///< Releases freed to the allocator because the pool and the depot were full.
+    uint64_t trimmed{};   ///< Idle blocks adaptive pools released to the allocator.
+};
+
+namespace detail {
+
+/** @brief Allocates through the installed allocator. Returns null on failure. */
+VELK_EXPORT void* velk_alloc(size_t size, size_t alignment, MemoryTag tag);
+/** @brief Frees memory allocated with velk_alloc(). Null is ignored. */
+VELK_EXPORT void velk_free(void* ptr, size_t alignment, MemoryTag tag);
+
+/**
+ * @brief Adds @p bytes in @p count allocations to the live memory of @p category.
+ *
+ * Negative values remove memory. The counters are relaxed atomics shared by all modules.
+ */
+VELK_EXPORT void track_memory(MemoryCategory category, ptrdiff_t bytes, ptrdiff_t count);
+
+/** @brief Returns the live memory tracked with track_memory(). */
+VELK_EXPORT MemoryStats get_tracked_memory();
+
+/** @brief Implements IVelk::set_block_pool_config(). */
+VELK_EXPORT void set_block_pool_config(const BlockPoolConfig& config);
+/** @brief Implements IVelk::get_block_pool_config(). */
+VELK_EXPORT BlockPoolConfig get_block_pool_config();
+/** @brief Implements IVelk::get_block_pool_stats(). */
+VELK_EXPORT BlockPoolStats get_block_pool_stats();
+/**
+ * @brief Allocates @p size bytes for an object, reusing the memory of a destroyed object of the
+ *        same 16-byte size bucket that the calling thread kept. Returns null on failure.
+ */
+VELK_EXPORT void* recycle_alloc(size_t size);
+/**
+ * @brief Frees memory from recycle_alloc(), or keeps it for reuse if the calling thread holds
+ *        fewer than @p capacity blocks of its size bucket.
+ */
+VELK_EXPORT void recycle_free(void* ptr, size_t size, uint32_t capacity);
+/** @brief Implements IVelk::trim_recycled_objects(). */
+VELK_EXPORT void trim_recycled_objects();
+
+/**
+ * @brief Base or member that counts the instances of @p Derived in @p Category for their lifetime.
+ *
+ * Counts sizeof(Derived) bytes per instance. Copies and moves count as new instances.
+ */
+template <class Derived, MemoryCategory Category>
+class TrackedMemory
+{
+public:
+    TrackedMemory() noexcept { track_memory(Category, sizeof(Derived), 1); }
+    TrackedMemory(const TrackedMemory&) noexcept : TrackedMemory() {}
+    TrackedMemory& operator=(const TrackedMemory&) noexcept { return *this; }
+    ~TrackedMemory() { track_memory(Category, -static_cast<ptrdiff_t>(sizeof(Derived)), -1); }
+};
+
+} // namespace detail
+
+} // namespace velk
+
+#endif // VELK_ALLOCATOR_H
@@ -6,6 +6,34 @@
 
 namespace velk {
 
+/**
+ * @brief Finds the first attachment that implements interface T.
+ *
+ * Attachments of registered classes are indexed by interface UID, so this is a binary search
+ * over the indexed interfaces followed by one cast.
+ *
+ * @tparam T The interface type to search for and return.
+ * @param storage The object storage to search.
+ * @return Shared pointer to the attachment cast to T, or nullptr if none implements T.
+ */
+template <class T>
+typename T::Ptr find_attachment(IObjectStorage* storage)
+{
+    return storage ? interface_pointer_cast<T>(storage->find_attachment({T::UID})) : typename T::Ptr{};
+}
+
+/**
+ * @brief Finds the first attachment that implements interface T.
+ * @tparam T The interface type to search for and return.
+ * @param obj The object to search for an IObjectStorage interface on.
+ * @return Shared pointer to the attachment cast to T, or nullptr if obj has no IObjectStorage.
+ */
+template <class T>
+typename T::Ptr find_attachment(IInterface* obj)
+{
+    return find_attachment<T>(interface_cast<IObjectStorage>(obj));
+}
+
 /**
  * @brief Finds an existing attachment of type T, or creates one by class UID and attaches it.
  * @tparam T The interface type to search for and return.
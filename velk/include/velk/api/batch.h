@@ -0,0 +1,106 @@
+#ifndef VELK_API_BATCH_H
+#define VELK_API_BATCH_H
+
+#include <velk/api/property.h>
+#include <velk/ext/any.h>
+#include <velk/interface/intf_property.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief Scoped batch of property writes that notifies each written property once when it ends.
+ *
+ * set() applies a value immediately without firing on_changed and records the property.
+ * When the batch is committed or destroyed, on_changed fires once per recorded property, in
+ * the order the properties were first written, after all values are in place. The properties
+ * may belong to any number of objects. Unlike a Deferred write, nothing goes through the
+ * deferred queue of instance().update().
+ *
+ * Values are applied the way update() applies deferred writes, so an any extension that
+ * reacts to set_data(), such as an animator transition, is bypassed.
+ *
+ * A batch is not thread-safe and should stay on the thread that created it.
+ *
+ * @code
+ * {
+ *     auto batch = batch_write();
+ *     batch.set(widget->width(), 200.f);
+ *     batch.set(widget->height(), 100.f);
+ *     batch.set(label->opacity(), 0.5f);
+ * } // on_changed fires for width, height, opacity
+ * @endcode
+ */
+class PropertyBatch
+{
+public:
+    PropertyBatch() = default;
+    ~PropertyBatch() { commit(); }
+
+    PropertyBatch(const PropertyBatch&) = delete;
+    PropertyBatch& operator=(const PropertyBatch&) = delete;
+    PropertyBatch(PropertyBatch&&) = default;
+    PropertyBatch& operator=(PropertyBatch&&) = delete;
+
+    /**
+     * @brief Writes @p value to @p property now and defers its on_changed to commit().
+     * @return Success if the value changed, NothingToDo if it was equal or the property
+     *         notified on its own (external any), ReadOnly or Fail otherwise.
+     */
+    template <class T>
+    ReturnValue set(Property<T> property, const typename ConstProperty<T>::Type& value)
+    {
+        using Type = typename ConstProperty<T>::Type;
+        auto internal = interface_pointer_cast<IPropertyInternal>(property.get_property_interface());
+        if (!internal) {
+            return ReturnValue::Fail;
+        }
+        // copy_from() only reads through the pointer.
+        ext::AnyRef<Type> ref(const_cast<Type*>(&value));
+        auto ret = internal->set_value_silent(ref);
+        if (ret == ReturnValue::Success) {
+            add(internal);
+        }
+        return ret;
+    }
+
+    /** @brief Records @p property for notification without writing it, e.g. after writing its State. */
+    void add(const IPropertyInternal::Ptr& property)
+    {
+        if (property && std::find(pending_.begin(), pending_.end(), property) == pending_.end()) {
+            pending_.push_back(property);
+        }
+    }
+
+    /** @brief Returns the number of properties waiting for notification. */
+    size_t size() const { return pending_.size(); }
+
+    /**
+     * @brief Fires on_changed for every recorded property and empties the batch.
+     *
+     * Handlers may write through the batch again; those writes are notified by the next commit().
+     */
+    void commit()
+    {
+        auto pending = std::move(pending_);
+        pending_.clear();
+        for (auto& property : pending) {
+            property->notify_changed();
+        }
+    }
+
+private:
+    std::vector<IPropertyInternal::Ptr> pending_;
+};
+
+/** @brief Starts a PropertyBatch. See PropertyBatch. */
+inline PropertyBatch batch_write()
+{
+    return {};
+}
+
+} // namespace velk
+
+#endif // VELK_API_BATCH_H
@@ -0,0 +1,55 @@
+#ifndef VELK_API_BINDING_H
+#define VELK_API_BINDING_H
+
+#include <velk/api/callback.h>
+#include <velk/api/property.h>
+#include <velk/api/velk.h>
+#include <velk/interface/intf_binding_registry.h>
+
+#include <utility>
+
+namespace velk {
+
+/**
+ * @brief Binds @p target to follow the value of @p source.
+ *
+ * The target takes the value of the source now, and after each update() in which the source
+ * changed.
+ * @see IBindingRegistry::bind
+ */
+template <class T, class S>
+ReturnValue bind(Property<T> target, const ConstProperty<S>& source)
+{
+    IProperty::ConstPtr sources[] = {source.get_property_interface()};
+    return instance().binding_registry().bind(target.get_property_interface(), {sources, 1});
+}
+
+/**
+ * @brief Binds @p target to @p transform applied to the values of @p sources.
+ *
+ * @p transform is called with the source values as typed arguments and returns the value
+ * of the target:
+ * @code
+ * bind(area, [](float w, float h) { return w * h; }, width, height);
+ * @endcode
+ * @see IBindingRegistry::bind
+ */
+template <class T, class Fn, class S, class... Rest>
+ReturnValue bind(Property<T> target, Fn&& transform, const ConstProperty<S>& source,
+                 const ConstProperty<Rest>&... rest)
+{
+    IProperty::ConstPtr props[] = {source.get_property_interface(), rest.get_property_interface()...};
+    Callback fn(std::forward<Fn>(transform));
+    return instance().binding_registry().bind(target.get_property_interface(), {props, 1 + sizeof...(Rest)},
+                                              fn);
+}
+
+/** @brief Removes the binding of @p target. @see IBindingRegistry::unbind */
+inline ReturnValue unbind(const detail::PropertyStorage& target)
+{
+    return instance().binding_registry().unbind(target.get_property_interface());
+}
+
+} // namespace velk
+
+#endif // VELK_API_BINDING_H
@@ -42,7 +42,7 @@ struct typed_trampoline
             return invoke_typed_impl<Callable, ArgsTuple>(fn, args, std::make_index_sequence<Arity>{});
         } else {
             auto result = invoke_typed_impl<Callable, ArgsTuple>(fn, args, std::make_index_sequence<Arity>{});
-            return Any<R>(result).clone();
+            return ext::AnyArg<R>(result).clone();
         }
     }
 
@@ -135,6 +135,9 @@ public:
      *  @param args Arguments for invocation.
      *  @param type Immediate executes now; Deferred queues for the next update() call. */
     IAny::Ptr invoke(FnArgs args, InvokeType type = Immediate) const { return fn_->invoke(args, type); }
+    /** @brief Invokes the function now and writes its return value into @p result.
+     *  @return As IFunction::invoke_into(). */
+    ReturnValue invoke_into(FnArgs args, IAny& result) const { return fn_->invoke_into(args, result); }
 
 private:
     IFunction::Ptr fn_;
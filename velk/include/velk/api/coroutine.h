@@ -0,0 +1,164 @@
+#ifndef VELK_API_COROUTINE_H
+#define VELK_API_COROUTINE_H
+
+/**
+ * @file
+ * @brief C++20 coroutine support for Future: @c co_await a Future<T> instead of chaining then().
+ *
+ * Opt-in: nothing is declared unless the compiler supports coroutines (@c __cpp_impl_coroutine).
+ */
+
+#if defined(__cpp_impl_coroutine)
+
+#include <velk/api/future.h>
+#include <velk/ext/interface_dispatch.h>
+
+#include <atomic>
+#include <coroutine>
+
+namespace velk {
+
+namespace detail {
+
+/**
+ * @brief Continuation that resumes a coroutine.
+ *
+ * Resumes the coroutine from invoke(), i.e. on the executor the continuation was added with.
+ * The coroutine may then destroy its frame while the future still holds a reference, so the
+ * resumer lives on the heap and deletes itself with the last reference. A continuation the
+ * future drops without running, as when it is cancelled, resumes the coroutine when the last
+ * reference is released instead.
+ */
+class FutureResumer final : public ext::InterfaceDispatch<IFunction>
+{
+public:
+    /** @brief Returns a new resumer of @p handle, owned by the returned reference. */
+    static IFunction::ConstPtr create(std::coroutine_handle<> handle)
+    {
+        return IFunction::ConstPtr(new FutureResumer(handle));
+    }
+
+    FutureResumer(const FutureResumer&) = delete;
+    FutureResumer& operator=(const FutureResumer&) = delete;
+
+public: // IInterface
+    void ref() override { refs_.fetch_add(1, std::memory_order_relaxed); }
+    void unref() override
+    {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            resume();
+            delete this;
+        }
+    }
+
+public: // IFunction
+    IAny::Ptr invoke(FnArgs, InvokeType) const override
+    {
+        resume();
+        return nullptr;
+    }
+    bool invoke_typed(TypedFn*, const void* const*, void*) const override { return false; }
+    ReturnValue invoke_into(FnArgs, IAny&) const override
+    {
+        resume();
+        return ReturnValue::Success;
+    }
+
+private:
+    explicit FutureResumer(std::coroutine_handle<> handle) : handle_(handle) {}
+    ~FutureResumer() override = default;
+
+    /** @brief Resumes the coroutine unless it was resumed already. */
+    void resume() const
+    {
+        if (!resumed_.exchange(true, std::memory_order_acq_rel)) {
+            handle_.resume();
+        }
+    }
+
+    std::coroutine_handle<> handle_;
+    std::atomic<uint32_t> refs_{1};
+    mutable std::atomic<bool> resumed_{false};
+};
+
+} // namespace detail
+
+/**
+ * @brief Awaiter returned by @c co_await on a Future<T> and by resume_on().
+ *
+ * Registers a single continuation on the future, which resumes the coroutine where the future
+ * resolves (Immediate), on the next update() (Deferred) or on a worker of the thread pool of the
+ * instance (Pool). A cancelled future resumes the coroutine as well; the result is then invalid.
+ *
+ * @c co_await yields the Any<const T> that Future<T>::get_result() returns, or nothing for
+ * Future<void>.
+ */
+template <class T>
+class FutureAwaiter
+{
+public:
+    FutureAwaiter(IFuture::Ptr future, InvokeType type) : future_(std::move(future)), type_(type) {}
+
+    /** @brief Resumes without suspending if the future is ready and may be resumed inline. */
+    bool await_ready() const
+    {
+        return !future_ || (invoke_mode(type_) == Immediate && future_->is_ready());
+    }
+
+    /**
+     * @brief Adds the continuation that resumes @p handle.
+     *
+     * The coroutine may already have resumed, and destroyed this awaiter, when add_continuation()
+     * returns, so nothing touches the awaiter afterwards.
+     */
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        auto future = future_; // Keeps the future alive if the coroutine resumes meanwhile.
+        future->add_continuation(detail::FutureResumer::create(handle), type_);
+    }
+
+    /** @brief Returns the result of the future (nothing for Future<void>). */
+    auto await_resume() const
+    {
+        if constexpr (std::is_void_v<T>) {
+            return;
+        } else {
+            return Any<const T>(future_ ? future_->get_result() : nullptr);
+        }
+    }
+
+private:
+    IFuture::Ptr future_;
+    InvokeType type_;
+};
+
+/**
+ * @brief Awaits @p future, resuming the coroutine with @p type.
+ *
+ * With Deferred or Pool the coroutine moves to that executor even if @p future is ready already.
+ * @code
+ * Task load(string path)   // any coroutine type
+ * {
+ *     auto mesh = co_await resume_on(async([=] { return decode_mesh(path); }), Deferred);
+ *     upload(mesh.get_value());   // runs in update()
+ * }
+ * @endcode
+ */
+template <class T>
+FutureAwaiter<T> resume_on(Future<T> future, InvokeType type)
+{
+    return {IFuture::Ptr(future), type};
+}
+
+/** @brief Awaits @p future, resuming the coroutine inline where it is resolved. */
+template <class T>
+FutureAwaiter<T> operator co_await(Future<T> future)
+{
+    return {IFuture::Ptr(future), Immediate};
+}
+
+} // namespace velk
+
+#endif // __cpp_impl_coroutine
+
+#endif // VELK_API_COROUTINE_H
@@ -6,7 +6,6 @@
 #include <velk/common.h>
 #include <velk/interface/intf_function.h>
 
-#include <tuple>
 #include <type_traits>
 #include <utility>
 
@@ -43,7 +42,14 @@ public:
         return fn_ ? fn_->invoke(args, type) : nullptr;
     }
 
-private:
+    /** @brief Invokes the function now and writes its return value into @p result (null-safe).
+     *  @return As IFunction::invoke_into(), or InvalidArgument if the function is null. */
+    ReturnValue invoke_into(FnArgs args, IAny& result) const
+    {
+        return fn_ ? fn_->invoke_into(args, result) : ReturnValue::InvalidArgument;
+    }
+
+protected:
     IFunction::Ptr fn_;
 };
 
@@ -61,15 +67,23 @@ IAny::Ptr invoke_function(const IFunction::ConstPtr& fn, const Args&... args)
     return fn ? fn->invoke(FnArgs{ptrs, sizeof...(Args)}) : nullptr;
 }
 
-// Variadic invoke_function: value args (auto-wrapped in Any<T>)
+// Variadic invoke_function: value args (auto-wrapped in ext::AnyArg<T>)
 
 namespace detail {
 
-template <class FnPtr, class Tuple, size_t... Is>
-IAny::Ptr invoke_with_any_tuple(const FnPtr& fn, Tuple& tup, std::index_sequence<Is...>)
+/** @brief Invokes @p fn with the stack-resident @p anys as FnArgs. */
+template <class FnPtr, class... Anys>
+IAny::Ptr invoke_with_anys(const FnPtr& fn, const Anys&... anys)
+{
+    const IAny* ptrs[] = {static_cast<const IAny*>(&anys)...};
+    return fn ? fn->invoke(FnArgs{ptrs, sizeof...(Anys)}) : nullptr;
+}
+
+/** @brief Invokes @p fn with each of @p args viewed by an ext::AnyArg, without allocating. */
+template <class FnPtr, class... Args>
+IAny::Ptr invoke_with_values(const FnPtr& fn, const Args&... args)
 {
-    const IAny* ptrs[] = {static_cast<const IAny*>(std::get<Is>(tup))...};
-    return fn ? fn->invoke(FnArgs{ptrs, sizeof...(Is)}) : nullptr;
+    return invoke_with_anys(fn, ext::AnyArg<std::decay_t<Args>>(args)...);
 }
 
 } // namespace detail
@@ -77,15 +91,109 @@ IAny::Ptr invoke_with_any_tuple(const FnPtr& fn, Tuple& tup, std::index_sequence
 /**
  * @brief Invokes a function with multiple value arguments.
  *
- * Each argument is wrapped in Any<T> and passed as FnArgs.
+ * Each argument is viewed by an ext::AnyArg<T> on the stack and passed as FnArgs, so the
+ * arguments cost no allocation.
  */
 template <class... Args, detail::require_value_args<Args...> = 0>
 IAny::Ptr invoke_function(const IFunction::ConstPtr& fn, const Args&... args)
 {
-    auto tup = std::make_tuple(Any<std::decay_t<Args>>(args)...);
-    return detail::invoke_with_any_tuple(fn, tup, std::index_sequence_for<Args...>{});
+    return detail::invoke_with_values(fn, args...);
+}
+
+namespace detail {
+
+/** @brief Implementation of raw_trampoline; unpacks raw argument pointers into typed parameters. */
+template <class Intf, class R, class... Args, size_t... Is>
+void raw_trampoline_impl(void* self, const void* const* args, void* result, R (Intf::*fn)(Args...),
+                           std::index_sequence<Is...>)
+{
+    if constexpr (std::is_void_v<R>) {
+        (static_cast<Intf*>(self)->*fn)(*static_cast<const std::decay_t<Args>*>(args[Is])...);
+    } else if (result) {
+        *static_cast<R*>(result) =
+            (static_cast<Intf*>(self)->*fn)(*static_cast<const std::decay_t<Args>*>(args[Is])...);
+    } else {
+        (static_cast<Intf*>(self)->*fn)(*static_cast<const std::decay_t<Args>*>(args[Is])...);
+    }
+}
+
+/**
+ * @brief IFunction::TypedFn that calls the virtual method @p Fn of the interface at @p self.
+ *
+ * Its address identifies the signature of @p Fn, which lets IFunction::invoke_typed() check
+ * that the raw pointers a caller passes match the parameters of the bound method.
+ */
+template <auto Fn>
+void raw_trampoline(void* self, const void* const* args, void* result)
+{
+    constexpr size_t arity = callable_traits<decltype(Fn)>::arity;
+    raw_trampoline_impl(self, args, result, Fn, std::make_index_sequence<arity>{});
 }
 
+template <auto Fn, class Sig = decltype(Fn)>
+class TypedFunctionImpl;
+
+template <auto Fn, class Intf, class R, class... Args>
+class TypedFunctionImpl<Fn, R (Intf::*)(Args...)> : public Function
+{
+public:
+    using Function::Function;
+
+    /**
+     * @brief Invokes the function immediately with typed arguments (null-safe).
+     *
+     * If the function is still bound to the virtual method it was declared for, the arguments
+     * are passed by pointer and the result is returned directly, with no IAny boxing and no heap
+     * allocation. Otherwise, e.g. if the function was rebound to a callback, the call falls back
+     * to invoke().
+     *
+     * @return The result, or a value-initialized R if the function is null or returns nothing.
+     */
+    R call(const std::decay_t<Args>&... args) const
+    {
+        const IFunction::Ptr& fn = this->fn_;
+        if (!fn) {
+            return R();
+        }
+        const void* ptrs[sizeof...(Args) + 1] = {&args...};
+        if constexpr (std::is_void_v<R>) {
+            if (!fn->invoke_typed(&raw_trampoline<Fn>, ptrs, nullptr)) {
+                invoke_with_values(fn, args...);
+            }
+        } else {
+            R result{};
+            if (!fn->invoke_typed(&raw_trampoline<Fn>, ptrs, &result)) {
+                auto boxed = invoke_with_values(fn, args...);
+                if constexpr (std::is_same_v<R, IAny::Ptr>) {
+                    result = std::move(boxed);
+                } else if (boxed) {
+                    boxed->get_data(&result, sizeof(R), type_uid<R>());
+                }
+            }
+            return result;
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Function wrapper that knows the signature of the @c FN virtual method @p Fn.
+ *
+ * Returned by the accessors that VELK_INTERFACE generates for @c FN members. In addition to
+ * the untyped Function API it provides call(), a typed invoke that skips IAny boxing:
+ * @code
+ * auto add = iw->add();        // (FN, int, add, (int, x), (int, y))
+ * int sum = add.call(1, 2);    // no allocation
+ * @endcode
+ *
+ * The fast path relies on the typed trampoline of @p Fn having the same address in the caller
+ * and in the binary that declared the interface. If it does not, e.g. across shared libraries
+ * that do not merge template instances, call() transparently uses invoke() instead.
+ */
+template <auto Fn>
+using TypedFunction = detail::TypedFunctionImpl<Fn>;
+
 } // namespace velk
 
 #endif // VELK_API_FUNCTION_H
@@ -5,6 +5,7 @@
 #include <velk/api/callback.h>
 #include <velk/api/velk.h>
 #include <velk/interface/intf_future.h>
+#include <velk/interface/intf_thread_pool.h>
 #include <velk/interface/types.h>
 
 namespace velk {
@@ -70,6 +71,11 @@ public:
     /** @brief Blocks until ready, then returns the typed result. */
     Any<const T> get_result() const { return Any<const T>(future_ ? future_->get_result() : nullptr); }
 
+    /** @brief Abandons the future and the steps chained to it. @see IFuture::cancel() */
+    ReturnValue cancel() { return future_ ? future_->cancel() : ReturnValue::Fail; }
+    /** @brief Returns true if the future was cancelled. */
+    bool is_cancelled() const { return future_ && future_->is_cancelled(); }
+
     /**
      * @brief Adds a continuation and returns a Future that resolves with its return value.
      *
@@ -113,6 +119,11 @@ public:
         }
     }
 
+    /** @copydoc Future::cancel */
+    ReturnValue cancel() { return future_ ? future_->cancel() : ReturnValue::Fail; }
+    /** @copydoc Future::is_cancelled */
+    bool is_cancelled() const { return future_ && future_->is_cancelled(); }
+
     /** @copydoc Future::then */
     template <class F>
     auto then(F&& callable, InvokeType type = Immediate);
@@ -153,6 +164,20 @@ public:
         return internal ? internal->set_result(Any<const T>(value)) : ReturnValue::Fail;
     }
 
+    /**
+     * @brief Resolves the future with a typed value, moved in instead of copied.
+     *
+     * The future adopts the Any holding @p value, so a large value such as a vector is not
+     * deep-copied on the way to the consumers.
+     * @return Success on first call, NothingToDo if already resolved.
+     */
+    template <class T, detail::require<!std::is_reference_v<T> && !std::is_const_v<T>> = 0>
+    ReturnValue set_value(T&& value)
+    {
+        auto* internal = interface_cast<IFutureInternal>(future_);
+        return internal ? internal->set_result(ext::create_any_value(std::move(value))) : ReturnValue::Fail;
+    }
+
     /**
      * @brief Resolves a void future (no value).
      * @return Success on first call, NothingToDo if already resolved.
@@ -163,6 +188,14 @@ public:
         return internal ? internal->set_result(nullptr) : ReturnValue::Fail;
     }
 
+    /**
+     * @brief Returns true if the consumer cancelled the future.
+     *
+     * Producers poll this to drop abandoned work early; setting a value afterwards returns
+     * NothingToDo.
+     */
+    bool is_cancelled() const { return future_ && future_->is_cancelled(); }
+
     /**
      * @brief Returns a typed Future for the consumer side.
      * @tparam T The expected result type. Use void for valueless futures.
@@ -186,6 +219,70 @@ inline Promise make_promise()
     return Promise(instance().create_future());
 }
 
+/**
+ * @brief Returns a Future that resolves once all of @p futures are ready.
+ *
+ * The inputs share one counter instead of a continuation callback each. The results stay in the
+ * input futures. Resolves immediately if @p futures is empty.
+ */
+inline Future<void> when_all(array_view<IFuture::Ptr> futures)
+{
+    return Future<void>(instance().when_all(futures));
+}
+
+/** @brief Returns a Future that resolves with the index of the first of @p futures to be ready. */
+inline Future<uint32_t> when_any(array_view<IFuture::Ptr> futures)
+{
+    return Future<uint32_t>(instance().when_any(futures));
+}
+
+namespace detail {
+
+/** @brief Views typed futures as the IFuture::Ptr each of them wraps. */
+template <class T>
+array_view<IFuture::Ptr> future_ptrs(array_view<Future<T>> futures)
+{
+    static_assert(std::is_standard_layout_v<Future<T>> && sizeof(Future<T>) == sizeof(IFuture::Ptr));
+    return {reinterpret_cast<const IFuture::Ptr*>(futures.begin()), futures.size()};
+}
+
+} // namespace detail
+
+/** @copydoc when_all(array_view<IFuture::Ptr>) */
+template <class T>
+Future<void> when_all(array_view<Future<T>> futures)
+{
+    return when_all(detail::future_ptrs(futures));
+}
+
+/** @copydoc when_any(array_view<IFuture::Ptr>) */
+template <class T>
+Future<uint32_t> when_any(array_view<Future<T>> futures)
+{
+    return when_any(detail::future_ptrs(futures));
+}
+
+/**
+ * @brief Runs @p callable on a worker of @p pool.
+ *
+ * Supports the same callable types as Callback, invoked without arguments.
+ * @return A Future that resolves with the callable's return value.
+ */
+template <class F>
+auto async(const IThreadPool::Ptr& pool, F&& callable)
+{
+    using FR = detail::future_return_t<std::decay_t<F>>;
+    Callback cb(std::forward<F>(callable));
+    return Future<FR>(pool ? pool->async(cb) : nullptr);
+}
+
+/** @brief Runs @p callable on a worker of the thread pool of the instance. */
+template <class F>
+auto async(F&& callable)
+{
+    return async(instance().get_thread_pool(), std::forward<F>(callable));
+}
+
 template <class T>
 template <class F>
 auto Future<T>::then(F&& callable, InvokeType type)
@@ -1,10 +1,13 @@
 #ifndef VELK_API_HIERARCHY_H
 #define VELK_API_HIERARCHY_H
 
+#include <velk/api/callback.h>
 #include <velk/api/object.h>
+#include <velk/arena.h>
 #include <velk/interface/intf_hierarchy.h>
 
 #include <type_traits>
+#include <utility>
 
 namespace velk {
 
@@ -67,15 +70,30 @@ public:
         if (!h) {
             return {};
         }
-        auto all = h->children_of(node_.object);
+        auto children = h->view_children(node_.object);
         vector<Node> result;
-        result.reserve(all.size());
-        for (auto& child : all) {
+        result.reserve(children.size());
+        for (auto& child : children) {
             result.push_back(Node({child, node_.hierarchy}));
         }
         return result;
     }
 
+    /**
+     * @brief Returns the ordered list of children as Nodes, allocated from @p arena.
+     *
+     * Avoids the heap for per-frame queries, e.g. get_children(frame_arena()).
+     * The result must not outlive the arena's next reset.
+     */
+    arena_vector<Node> get_children(Arena* arena) const
+    {
+        arena_vector<Node> result(arena);
+        if (auto h = hierarchy()) {
+            append_children(*h, node_.object, node_.hierarchy, result);
+        }
+        return result;
+    }
+
     /** @brief Returns the number of children. */
     size_t child_count() const
     {
@@ -148,9 +166,65 @@ public:
     friend bool operator!=(const IObject::Ptr& a, const Node& b) { return !(a == b); }
 
 private:
+    friend class Hierarchy;
+
+    /** @brief Appends the children of @p object in @p h to @p out as Nodes of @p weak. */
+    static void append_children(const IHierarchy& h, const IObject::Ptr& object,
+                                const weak_ptr<IHierarchy>& weak, arena_vector<Node>& out)
+    {
+        auto children = h.view_children(object);
+        out.reserve(out.size() + children.size());
+        for (auto& child : children) {
+            out.push_back(Node({child, weak}));
+        }
+    }
+
     HierarchyNode node_;
 };
 
+/**
+ * @brief Scoped batch of hierarchy changes, see IHierarchy::begin_batch().
+ *
+ * Begins a batch when constructed and ends it when destroyed, so that on_changed fires once
+ * for all the mutations made meanwhile. Move-only.
+ *
+ * @code
+ * {
+ *     auto batch = h.batch();
+ *     h.add(root, a);
+ *     h.remove(b);
+ * } // on_changed fires once, with a HierarchyChange::Type::Batch change listing both
+ * @endcode
+ */
+class HierarchyBatch
+{
+public:
+    /** @brief Begins a batch of @p hierarchy, if not null. */
+    explicit HierarchyBatch(IHierarchy::Ptr hierarchy) : hierarchy_(std::move(hierarchy))
+    {
+        if (hierarchy_) {
+            hierarchy_->begin_batch();
+        }
+    }
+    ~HierarchyBatch() { end(); }
+
+    HierarchyBatch(const HierarchyBatch&) = delete;
+    HierarchyBatch& operator=(const HierarchyBatch&) = delete;
+    HierarchyBatch(HierarchyBatch&&) = default;
+    HierarchyBatch& operator=(HierarchyBatch&&) = delete;
+
+    /** @brief Ends the batch now instead of when destroyed. */
+    void end()
+    {
+        if (auto hierarchy = std::move(hierarchy_)) {
+            hierarchy->end_batch();
+        }
+    }
+
+private:
+    IHierarchy::Ptr hierarchy_;
+};
+
 /**
  * @brief Convenience wrapper around IHierarchy.
  *
@@ -201,6 +275,24 @@ public:
         return h ? h->insert(parent, index, child) : ReturnValue::InvalidArgument;
     }
 
+    /** @brief Appends children to the given parent in one batch. See IHierarchy::add_children(). */
+    ReturnValue add_children(const IObject::Ptr& parent, array_view<IObject::Ptr> children)
+    {
+        auto* h = intf();
+        return h ? h->add_children(parent, children) : ReturnValue::InvalidArgument;
+    }
+
+    /**
+     * @brief Adds a subtree under the given parent in one batch, where @p parents gives the index
+     *        of each object's parent in @p objects. See IHierarchy::add_subtree().
+     */
+    ReturnValue add_subtree(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                            array_view<uint32_t> parents)
+    {
+        auto* h = intf();
+        return h ? h->add_subtree(parent, objects, parents) : ReturnValue::InvalidArgument;
+    }
+
     /** @brief Removes an object and all its descendants. */
     ReturnValue remove(const IObject::Ptr& object)
     {
@@ -255,19 +347,41 @@ public:
     /** @brief Returns the children as Nodes. */
     vector<Node> children_of(const IObject::Ptr& object) const
     {
-        auto* h = intf();
+        auto h = as_ptr<IHierarchy>();
         if (!h) {
             return {};
         }
-        auto all = h->children_of(object);
+        auto children = h->view_children(object);
         vector<Node> result;
-        result.reserve(all.size());
-        for (auto& child : all) {
-            result.push_back(Node(h->node_of(child)));
+        result.reserve(children.size());
+        for (auto& child : children) {
+            result.push_back(Node({child, h}));
+        }
+        return result;
+    }
+
+    /** @brief Returns the children as Nodes, allocated from @p arena. See Node::get_children(Arena*). */
+    arena_vector<Node> children_of(const IObject::Ptr& object, Arena* arena) const
+    {
+        arena_vector<Node> result(arena);
+        if (auto h = as_ptr<IHierarchy>()) {
+            Node::append_children(*h, object, h, result);
         }
         return result;
     }
 
+    /**
+     * @brief Returns a view of the children that holds the hierarchy's read lock.
+     *
+     * Iterates the children in place without copying or reference counting them. See
+     * ChildrenView for the rules while the view is alive.
+     */
+    ChildrenView view_children(const IObject::Ptr& object) const
+    {
+        auto* h = intf();
+        return h ? h->view_children(object) : ChildrenView{};
+    }
+
     /** @brief Returns the child at the given index as a Node, or empty. */
     Node child_at(const IObject::Ptr& object, size_t index) const
     {
@@ -302,6 +416,68 @@ public:
         });
     }
 
+    /**
+     * @brief Visits the given object and its descendants depth-first with a typed callback.
+     *
+     * The callback receives each object and its depth in the hierarchy. Objects that do not
+     * implement @p T are skipped, but their descendants are still visited. See IHierarchy::traverse().
+     */
+    template <class T, class Fn>
+    void traverse(const IObject::Ptr& object, TraversalOrder order, Fn&& fn) const
+    {
+        static_assert(std::is_invocable_v<std::decay_t<Fn>, T&, size_t>,
+                      "Hierarchy::traverse visitor must be callable as void(T&, size_t) or bool(T&, size_t)");
+        auto* h = intf();
+        if (!h) {
+            return;
+        }
+        h->traverse(object, order, &fn, [](void* ctx, const IObject::Ptr& obj, size_t depth) -> bool {
+            auto& callback = *static_cast<std::decay_t<Fn>*>(ctx);
+            if (auto* typed = interface_cast<T>(obj)) {
+                if constexpr (std::is_same_v<decltype(callback(*typed, depth)), bool>) {
+                    return callback(*typed, depth);
+                } else {
+                    callback(*typed, depth);
+                }
+            }
+            return true;
+        });
+    }
+
+    /**
+     * @brief Visits an object and its descendants like traverse(), splitting the subtrees into
+     *        tasks of @p executor.
+     *
+     * The callback is called concurrently for objects in different subtrees and must be
+     * thread-safe. See IHierarchy::traverse_parallel().
+     *
+     * @param executor Executor running the tasks. If null, visits on the calling thread.
+     */
+    template <class T, class Fn>
+    void traverse_parallel(const IObject::Ptr& object, TraversalOrder order, IExecutor* executor, Fn&& fn,
+                           const ParallelTraversalConfig& config = {}) const
+    {
+        static_assert(std::is_invocable_v<std::decay_t<Fn>, T&, size_t>,
+                      "Hierarchy::traverse_parallel visitor must be callable as void(T&, size_t) or "
+                      "bool(T&, size_t)");
+        auto* h = intf();
+        if (!h) {
+            return;
+        }
+        h->traverse_parallel(object, order, executor, config, &fn,
+                             [](void* ctx, const IObject::Ptr& obj, size_t depth) -> bool {
+                                 auto& callback = *static_cast<std::decay_t<Fn>*>(ctx);
+                                 if (auto* typed = interface_cast<T>(obj)) {
+                                     if constexpr (std::is_same_v<decltype(callback(*typed, depth)), bool>) {
+                                         return callback(*typed, depth);
+                                     } else {
+                                         callback(*typed, depth);
+                                     }
+                                 }
+                                 return true;
+                             });
+    }
+
     /** @brief Returns the number of children of the given object. */
     size_t child_count(const IObject::Ptr& object) const
     {
@@ -309,6 +485,50 @@ public:
         return h ? h->child_count(object) : 0;
     }
 
+    /**
+     * @brief Makes @p target of every object inherit from its parent through @p combine.
+     *
+     * @p combine is called with the parent's @p target value and the object's @p source value as
+     * typed arguments and returns the object's @p target value:
+     * @code
+     * h.add_inherited("opacity", "world_opacity", [](float parent, float local) {
+     *     return parent * local;
+     * });
+     * @endcode
+     * See IHierarchy::add_inherited().
+     */
+    template <class Fn>
+    ReturnValue add_inherited(string_view source, string_view target, Fn&& combine)
+    {
+        auto* h = intf();
+        return h ? h->add_inherited(source, target, Callback(std::forward<Fn>(combine)))
+                 : ReturnValue::InvalidArgument;
+    }
+
+    /** @brief Stops @p target from being inherited. See IHierarchy::remove_inherited(). */
+    ReturnValue remove_inherited(string_view target)
+    {
+        auto* h = intf();
+        return h ? h->remove_inherited(target) : ReturnValue::InvalidArgument;
+    }
+
+    /** @brief Begins a batch of changes that ends when the returned object is destroyed. */
+    HierarchyBatch batch() { return HierarchyBatch(interface_pointer_cast<IHierarchy>(get())); }
+
+    /** @brief Publishes the current tree as a new snapshot. See IHierarchy::commit_snapshot(). */
+    uint64_t commit_snapshot()
+    {
+        auto* h = intf();
+        return h ? h->commit_snapshot() : 0;
+    }
+
+    /** @brief Returns the last published snapshot, or null. See IHierarchy::snapshot(). */
+    IHierarchySnapshot::Ptr snapshot() const
+    {
+        auto* h = intf();
+        return h ? h->snapshot() : nullptr;
+    }
+
     /** @brief Returns true if the object is in this hierarchy. */
     bool contains(const IObject::Ptr& object) const
     {
@@ -341,10 +561,14 @@ private:
     mutable IHierarchy* hierarchy_ = nullptr;
 };
 
-/** @brief Creates a new Hierarchy instance. */
-inline Hierarchy create_hierarchy()
+/**
+ * @brief Creates a new Hierarchy instance.
+ * @param classId The implementation, e.g. ClassId::FlatHierarchy for large trees that are
+ *        traversed often.
+ */
+inline Hierarchy create_hierarchy(Uid classId = ClassId::Hierarchy)
 {
-    return Hierarchy(instance().create<IHierarchy>(ClassId::Hierarchy));
+    return Hierarchy(instance().create<IHierarchy>(classId));
 }
 
 } // namespace velk
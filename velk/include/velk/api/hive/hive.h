@@ -1,6 +1,7 @@
 #ifndef VELK_API_HIVE_H
 #define VELK_API_HIVE_H
 
+#include <velk/api/hive/hive_query.h>
 #include <velk/api/hive/object_hive.h>
 #include <velk/api/hive/raw_hive.h>
 
@@ -0,0 +1,151 @@
+#ifndef VELK_API_HIVE_QUERY_H
+#define VELK_API_HIVE_QUERY_H
+
+#include <velk/api/hive/page_view.h>
+#include <velk/interface/hive/intf_hive_store.h>
+#include <velk/interface/intf_metadata.h>
+
+#include <array>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief Visits the objects of every hive in a store whose class has a State for each of @p Interfaces.
+ *
+ * The query finds the matching hives on first use and keeps the offset of each requested
+ * State in their objects, so iteration applies the offsets to the slots of each page
+ * with no per-object interface lookup:
+ *
+ *   HiveQuery<IPosition, IVelocity> moving(*store);
+ *   moving.for_each([](IObject&, IPosition::State& p, IVelocity::State& v) { p.x += v.x; });
+ *
+ * Hives are never removed from a store, so the query searches the store again only when
+ * its hive count has changed. The store must outlive the query.
+ *
+ * @tparam Interfaces The interfaces whose States the visitor receives.
+ */
+template <class... Interfaces>
+class HiveQuery
+{
+    static_assert(sizeof...(Interfaces) > 0, "HiveQuery needs at least one interface");
+
+public:
+    /** @brief Creates a query over the hives of @p store. */
+    explicit HiveQuery(IHiveStore& store) : store_(&store) {}
+
+    /** @brief Returns the number of hives whose class matches the query. */
+    size_t hive_count()
+    {
+        refresh();
+        return matches_.size();
+    }
+
+    /**
+     * @brief Visits every live object of the matching hives.
+     *
+     * Hives are visited in store order, objects in slot order. The visitor must not add or
+     * remove objects of the hive being visited.
+     *
+     * @param fn Callable as void(IObject&, Interfaces::State&...) or bool(IObject&,
+     *           Interfaces::State&...). Return false to stop early.
+     * @return The number of objects visited.
+     */
+    template <class Fn>
+    size_t for_each(Fn&& fn)
+    {
+        static_assert(std::is_invocable_v<std::decay_t<Fn>, IObject&, typename Interfaces::State&...>,
+                      "HiveQuery::for_each visitor must be callable as void(IObject&, Interfaces::State&...) "
+                      "or bool(IObject&, Interfaces::State&...)");
+        refresh();
+        struct Ctx
+        {
+            Fn* fn;
+            const Match* match;
+            size_t visited;
+            bool stopped;
+        } ctx{&fn, nullptr, 0, false};
+        for (auto& match : matches_) {
+            ctx.match = &match;
+            match.hive->for_each_page(
+                &ctx,
+                [](void* c, const HivePageView& page) -> bool {
+                    auto& ctx = *static_cast<Ctx*>(c);
+                    return for_each_active_slot(page, [&](size_t i) -> bool {
+                        auto* obj = page_view_at<IObject>(page, i);
+                        ++ctx.visited;
+                        ctx.stopped = !visit(*ctx.fn, *ctx.match, *obj, std::index_sequence_for<Interfaces...>{});
+                        return !ctx.stopped;
+                    });
+                },
+                nullptr);
+            if (ctx.stopped) {
+                break;
+            }
+        }
+        return ctx.visited;
+    }
+
+private:
+    static constexpr Uid uids_[] = {Interfaces::UID...};
+
+    /** @brief A matching hive and the offset of each requested State in its objects. */
+    struct Match
+    {
+        IObjectHive::Ptr hive;
+        std::array<ptrdiff_t, sizeof...(Interfaces)> offsets; ///< -1 for a State in a state column.
+    };
+
+    template <class Fn, size_t... I>
+    static bool visit(Fn& fn, const Match& match, IObject& obj, std::index_sequence<I...>)
+    {
+        return detail::invoke_visitor(fn, obj, state<Interfaces>(match.offsets[I], obj)...);
+    }
+
+    /** @brief Returns the State of @p Intf at @p offset in @p obj, or from the object if it is in a column. */
+    template <class Intf>
+    static typename Intf::State& state(ptrdiff_t offset, IObject& obj)
+    {
+        if (offset >= 0) {
+            return *reinterpret_cast<typename Intf::State*>(reinterpret_cast<char*>(&obj) + offset);
+        }
+        return *interface_cast<IPropertyState>(&obj)->template get_property_state<Intf>();
+    }
+
+    /** @brief Searches the store for matching hives if it gained hives since the last search. */
+    void refresh()
+    {
+        size_t count = store_->hive_count();
+        if (count == seen_hives_) {
+            return;
+        }
+        seen_hives_ = count;
+        matches_.clear();
+        store_->for_each_hive(this, [](void* c, IHive& hive) -> bool {
+            auto& self = *static_cast<HiveQuery*>(c);
+            if (hive.get_hive_type() != HiveType::ObjectHive) {
+                return true;
+            }
+            auto object_hive = self.store_->find_hive(hive.get_element_uid());
+            Match match{object_hive, {}};
+            for (size_t i = 0; i < sizeof...(Interfaces); ++i) {
+                match.offsets[i] = object_hive->get_state_offset(uids_[i]);
+                if (match.offsets[i] < 0 && !object_hive->has_state_column(uids_[i])) {
+                    return true;
+                }
+            }
+            self.matches_.push_back(std::move(match));
+            return true;
+        });
+    }
+
+    IHiveStore* store_;
+    size_t seen_hives_{~size_t(0)};
+    std::vector<Match> matches_;
+};
+
+} // namespace velk
+
+#endif // VELK_API_HIVE_QUERY_H
@@ -1,41 +1,19 @@
 #ifndef VELK_API_OBJECT_HIVE_H
 #define VELK_API_OBJECT_HIVE_H
 
+#include <velk/api/event.h>
+#include <velk/api/hive/page_view.h>
 #include <velk/interface/hive/intf_hive_store.h>
 #include <velk/interface/intf_metadata.h>
 
+#include <cstring>
 #include <limits>
 #include <type_traits>
+#include <vector>
 
 namespace velk {
 namespace detail {
 
-inline ptrdiff_t compute_state_offset(IObjectHive& hive, Uid interfaceUid)
-{
-    if (hive.empty()) {
-        return -1;
-    }
-    struct Ctx
-    {
-        Uid uid;
-        ptrdiff_t result;
-    } ctx{interfaceUid, -1};
-
-    hive.for_each(&ctx, [](void* c, IObject& obj) -> bool {
-        auto& ctx = *static_cast<Ctx*>(c);
-        auto* ps = interface_cast<IPropertyState>(&obj);
-        if (ps) {
-            void* state = ps->get_property_state(ctx.uid);
-            if (state) {
-                ctx.result = static_cast<ptrdiff_t>(reinterpret_cast<uintptr_t>(state) -
-                                                    reinterpret_cast<uintptr_t>(&obj));
-            }
-        }
-        return false; // stop after first
-    });
-    return ctx.result;
-}
-
 /** @brief Non-template storage and operations for ObjectHive<T>. */
 class ObjectHiveCore
 {
@@ -49,48 +27,67 @@ protected:
     ObjectHiveCore(ObjectHiveCore&&) = default;
     ObjectHiveCore& operator=(ObjectHiveCore&&) = default;
 
-    /** @brief Visitor callback for for_each_as. Return false to stop early. */
-    using TypedVisitorFn = bool (*)(void* context, IObject& obj, void* typed);
-
     /**
-     * @brief Iterates all live objects, resolving an interface offset once.
+     * @brief Iterates all live objects as @p T, resolving the interface offset once.
      *
-     * On the first element, resolves the interface via get_interface(uid) and
+     * On the first element, resolves the interface via get_interface(T::UID) and
      * caches the byte offset from IObject to the interface pointer. Subsequent
      * elements apply the offset via pointer arithmetic with no virtual dispatch.
      *
-     * @param uid The interface UID to resolve.
-     * @param context Opaque pointer forwarded to the visitor.
-     * @param visitor Called with (context, obj, typed_ptr). Return false to stop early.
+     * @param fn Callable as void(T&) or bool(T&). Return false to stop early.
      */
-    void for_each_as(Uid uid, void* context, TypedVisitorFn visitor) const
+    template <class T, class Fn>
+    void visit_as(Fn& fn) const
     {
         if (!hive_) {
             return;
         }
-        struct Core
+        constexpr ptrdiff_t unset = std::numeric_limits<ptrdiff_t>::min();
+        struct Ctx
         {
-            void* context;
-            TypedVisitorFn visitor;
-            Uid uid;
+            Fn* fn;
             ptrdiff_t offset;
-        };
-        constexpr ptrdiff_t unset = std::numeric_limits<ptrdiff_t>::min();
-        Core core{context, visitor, uid, unset};
-        hive_->for_each(&core, [](void* c, IObject& obj) -> bool {
-            auto& core = *static_cast<Core*>(c);
-            void* typed;
-            if (core.offset == std::numeric_limits<ptrdiff_t>::min()) {
-                typed = obj.get_interface(core.uid);
-                if (!typed) {
-                    return false;
-                }
-                core.offset = static_cast<char*>(typed) - reinterpret_cast<char*>(&obj);
-            } else {
-                typed = reinterpret_cast<char*>(&obj) + core.offset;
-            }
-            return core.visitor(core.context, obj, typed);
-        });
+        } ctx{&fn, std::is_same_v<T, IObject> ? 0 : unset};
+        hive_->for_each_page(
+            &ctx,
+            [](void* c, const HivePageView& page) -> bool {
+                auto& ctx = *static_cast<Ctx*>(c);
+                return for_each_active_slot(page, [&](size_t i) -> bool {
+                    auto* obj = page_view_at<char>(page, i);
+                    if (ctx.offset == unset) {
+                        void* typed = reinterpret_cast<IObject*>(obj)->get_interface(T::UID);
+                        if (!typed) {
+                            return false;
+                        }
+                        ctx.offset = static_cast<char*>(typed) - obj;
+                    }
+                    return invoke_visitor(*ctx.fn, *reinterpret_cast<T*>(obj + ctx.offset));
+                });
+            },
+            nullptr);
+    }
+
+    /** @brief Returns the byte offset of @p field in StateInterface::State. */
+    template <class StateInterface, class Key>
+    static size_t field_offset(Key StateInterface::State::*field)
+    {
+        auto& s = default_state<typename StateInterface::State>();
+        return static_cast<size_t>(reinterpret_cast<const char*>(&(s.*field)) - reinterpret_cast<const char*>(&s));
+    }
+
+    /** @brief Returns how an index interprets a field of type @p Key. */
+    template <class Key>
+    static constexpr HiveKeyType index_key_type()
+    {
+        static_assert(std::is_arithmetic_v<Key> || std::is_enum_v<Key>,
+                      "ObjectHive index fields must be of an arithmetic or enum type");
+        if constexpr (std::is_floating_point_v<Key>) {
+            return HiveKeyType::Float;
+        } else if constexpr (std::is_enum_v<Key>) {
+            return std::is_signed_v<std::underlying_type_t<Key>> ? HiveKeyType::Signed : HiveKeyType::Unsigned;
+        } else {
+            return std::is_signed_v<Key> ? HiveKeyType::Signed : HiveKeyType::Unsigned;
+        }
     }
 
 public:
@@ -103,13 +100,25 @@ public:
     /** @brief Returns true if the hive is empty. */
     bool empty() const { return !hive_ || hive_->empty(); }
 
+    /**
+     * @brief Returns the State of @p StateInterface of the object behind @p handle.
+     *
+     * Returns nullptr if the handle is stale or the object does not implement the interface.
+     */
+    template <class StateInterface>
+    typename StateInterface::State* resolve_state(HiveHandle handle) const
+    {
+        auto* ps = interface_cast<IPropertyState>(hive_ ? hive_->resolve(handle) : nullptr);
+        return ps ? ps->template get_property_state<StateInterface>() : nullptr;
+    }
+
     /**
      * @brief Iterates with direct state access, bypassing interface_cast per element.
      *
      * All objects in a hive share the same class layout, so the byte offset from
-     * object start to a given State struct is constant. The offset is computed once
-     * from the first live object, then for_each_state passes a pre-computed state
-     * pointer to each visitor call with no virtual dispatch in the hot loop.
+     * object start to a given State struct is constant. The hive computes the offsets
+     * once (see IObjectHive::get_state_offset()), then each visitor call receives a
+     * state pointer with no virtual dispatch in the hot loop.
      *
      * @tparam StateInterface The interface whose State struct to access.
      * @param fn Callable as bool(IObject&, StateInterface::State&). Return false to stop early.
@@ -124,13 +133,375 @@ public:
         if (!hive_) {
             return;
         }
-        ptrdiff_t offset = compute_state_offset(*hive_, StateInterface::UID);
+        if (hive_->has_state_column(StateInterface::UID)) {
+            visit_column_states<StateInterface>(fn, nullptr);
+            return;
+        }
+        ptrdiff_t offset = hive_->get_state_offset(StateInterface::UID);
         if (offset > 0) {
-            hive_->for_each_state(offset, &fn, [](void* ctx, IObject& obj, void* state) -> bool {
-                auto& f = *static_cast<std::decay_t<Fn>*>(ctx);
-                return f(obj, *static_cast<typename StateInterface::State*>(state));
+            visit_inline_states<StateInterface>(fn, offset, nullptr);
+        }
+    }
+
+    /**
+     * @brief Parallel variant of for_each<StateInterface>() running on an executor.
+     *
+     * The visitor is called concurrently from the executor's workers and must be
+     * thread-safe. See IObjectHive::for_each_state_parallel() for scheduling details.
+     *
+     * @tparam StateInterface The interface whose State struct to access.
+     * @param executor Executor running the workers. If null, iterates on the calling thread.
+     * @param fn Callable as bool(IObject&, StateInterface::State&). Return false to stop early.
+     */
+    template <class StateInterface, class Fn>
+    void for_each_parallel(IExecutor* executor, Fn&& fn) const
+    {
+        static_assert(
+            std::is_invocable_r_v<bool, std::decay_t<Fn>, IObject&, typename StateInterface::State&>,
+            "ObjectHive::for_each_parallel<StateInterface> visitor must be callable as "
+            "bool(IObject&, StateInterface::State&)");
+        if (!hive_) {
+            return;
+        }
+        if (hive_->has_state_column(StateInterface::UID)) {
+            visit_column_states<StateInterface>(fn, executor);
+            return;
+        }
+        ptrdiff_t offset = hive_->get_state_offset(StateInterface::UID);
+        if (offset > 0) {
+            visit_inline_states<StateInterface>(fn, offset, executor);
+        }
+    }
+
+    /**
+     * @brief Stores StateInterface::State in a contiguous column per page.
+     *
+     * Must be called before the first add(). See IObjectHive::add_state_column().
+     *
+     * @tparam StateInterface The interface whose State struct to store in a column.
+     */
+    template <class StateInterface>
+    ReturnValue add_state_column()
+    {
+        using State = typename StateInterface::State;
+        static_assert(std::is_trivially_copyable_v<State>,
+                      "ObjectHive::add_state_column requires a trivially copyable State");
+        return hive_ ? hive_->add_state_column(StateInterface::UID, sizeof(State), alignof(State))
+                     : ReturnValue::Fail;
+    }
+
+    /**
+     * @brief Stores StateInterface::State in a double buffered column per page.
+     *
+     * Must be called before the first add(). See IObjectHive::add_double_buffered_state().
+     *
+     * @tparam StateInterface The interface whose State struct to double buffer.
+     */
+    template <class StateInterface>
+    ReturnValue add_double_buffered_state()
+    {
+        using State = typename StateInterface::State;
+        static_assert(std::is_trivially_copyable_v<State>,
+                      "ObjectHive::add_double_buffered_state requires a trivially copyable State");
+        return hive_ ? hive_->add_double_buffered_state(StateInterface::UID, sizeof(State), alignof(State))
+                     : ReturnValue::Fail;
+    }
+
+    /**
+     * @brief Iterates the States published by the last swap_state_buffers().
+     *
+     * Writes made since then are not visible. See IObjectHive::for_each_front().
+     *
+     * @tparam StateInterface An interface added with add_double_buffered_state<StateInterface>().
+     * @param fn Callable as bool(IObject&, const StateInterface::State&). Return false to stop early.
+     */
+    template <class StateInterface, class Fn>
+    void for_each_front(Fn&& fn) const
+    {
+        visit_front<StateInterface>(fn, nullptr);
+    }
+
+    /**
+     * @brief Parallel variant of for_each_front() running on an executor.
+     *
+     * @tparam StateInterface An interface added with add_double_buffered_state<StateInterface>().
+     * @param executor Executor running the workers. If null, iterates on the calling thread.
+     * @param fn Callable as bool(IObject&, const StateInterface::State&). Return false to stop early.
+     */
+    template <class StateInterface, class Fn>
+    void for_each_front_parallel(IExecutor* executor, Fn&& fn) const
+    {
+        visit_front<StateInterface>(fn, executor);
+    }
+
+    /** @brief Publishes the written States to the readers of for_each_front(). */
+    void swap_state_buffers()
+    {
+        if (hive_) {
+            hive_->swap_state_buffers();
+        }
+    }
+
+    /**
+     * @brief Writes the StateInterface State of every live object into a snapshot.
+     * @return The snapshot, empty if the hive is invalid or the objects have no such State.
+     *         See IObjectHive::snapshot_states().
+     */
+    template <class StateInterface>
+    std::vector<uint8_t> snapshot_states() const
+    {
+        using State = typename StateInterface::State;
+        static_assert(std::is_trivially_copyable_v<State>,
+                      "ObjectHive::snapshot_states requires a trivially copyable State");
+        std::vector<uint8_t> data;
+        if (!hive_) {
+            return data;
+        }
+        // The hive may grow between the calls, so retry until the snapshot fits.
+        size_t size = hive_->snapshot_states(StateInterface::UID, sizeof(State), nullptr, 0);
+        while (size > data.size()) {
+            data.resize(size);
+            size = hive_->snapshot_states(StateInterface::UID, sizeof(State), data.data(), data.size());
+        }
+        data.resize(size);
+        return data;
+    }
+
+    /**
+     * @brief Adds one object per State of a snapshot written by snapshot_states<StateInterface>().
+     * See IObjectHive::restore_states().
+     */
+    template <class StateInterface>
+    ReturnValue restore_states(const void* data, size_t size)
+    {
+        using State = typename StateInterface::State;
+        static_assert(std::is_trivially_copyable_v<State>,
+                      "ObjectHive::restore_states requires a trivially copyable State");
+        return hive_ ? hive_->restore_states(StateInterface::UID, sizeof(State), data, size)
+                     : ReturnValue::Fail;
+    }
+
+    /**
+     * @brief Iterates a state column page by page.
+     *
+     * The States of a run are contiguous, so fn can run a unit-stride (SIMD) kernel
+     * over them and use the active bits to skip or mask slots that are not live.
+     *
+     * @tparam StateInterface An interface added with add_state_column<StateInterface>().
+     * @param fn Callable as bool(StateInterface::State* states, const uint64_t* active_bits,
+     *           size_t count). Return false to stop early.
+     */
+    template <class StateInterface, class Fn>
+    void for_each_column(Fn&& fn) const
+    {
+        visit_columns<StateInterface>(fn, nullptr);
+    }
+
+    /**
+     * @brief Parallel variant of for_each_column() running on an executor.
+     *
+     * Pages are split into runs of bitmask words; fn is called concurrently and must be thread-safe.
+     *
+     * @tparam StateInterface An interface added with add_state_column<StateInterface>().
+     * @param executor Executor running the workers. If null, iterates on the calling thread.
+     * @param fn Callable as bool(StateInterface::State* states, const uint64_t* active_bits,
+     *           size_t count). Return false to stop early.
+     */
+    template <class StateInterface, class Fn>
+    void for_each_column_parallel(IExecutor* executor, Fn&& fn) const
+    {
+        visit_columns<StateInterface>(fn, executor);
+    }
+
+    /**
+     * @brief Iterates runs of consecutive live objects in a state column.
+     *
+     * Each run is a contiguous State array, so fn can run a SIMD kernel over it
+     * without masking.
+     *
+     * @tparam StateInterface An interface added with add_state_column<StateInterface>().
+     * @param fn Callable as bool(StateInterface::State* first, size_t count). Return false to stop early.
+     */
+    template <class StateInterface, class Fn>
+    void for_each_column_run(Fn&& fn) const
+    {
+        visit_column_runs<StateInterface>(fn, nullptr);
+    }
+
+    /**
+     * @brief Parallel variant of for_each_column_run() running on an executor.
+     *
+     * Runs end at chunk boundaries; fn is called concurrently and must be thread-safe.
+     *
+     * @tparam StateInterface An interface added with add_state_column<StateInterface>().
+     * @param executor Executor running the workers. If null, iterates on the calling thread.
+     * @param fn Callable as bool(StateInterface::State* first, size_t count). Return false to stop early.
+     */
+    template <class StateInterface, class Fn>
+    void for_each_column_run_parallel(IExecutor* executor, Fn&& fn) const
+    {
+        visit_column_runs<StateInterface>(fn, executor);
+    }
+
+    /**
+     * @brief Tracks which objects change a StateInterface property.
+     *
+     * Must be called before the first add(). See IObjectHive::add_dirty_tracking().
+     *
+     * @tparam StateInterface The interface whose changes to track.
+     */
+    template <class StateInterface>
+    ReturnValue add_dirty_tracking()
+    {
+        return hive_ ? hive_->add_dirty_tracking(StateInterface::UID) : ReturnValue::Fail;
+    }
+
+    /**
+     * @brief Visits the objects marked dirty for StateInterface and clears their marks.
+     *
+     * An object is marked when it is added and whenever one of its StateInterface
+     * properties notifies a change. See IObjectHive::for_each_dirty().
+     *
+     * @tparam StateInterface An interface added with add_dirty_tracking<StateInterface>().
+     * @param fn Callable as void(IObject&, StateInterface::State&) or bool(IObject&,
+     *           StateInterface::State&). Return false to stop early.
+     * @return The number of objects visited.
+     */
+    template <class StateInterface, class Fn>
+    size_t for_each_dirty(Fn&& fn)
+    {
+        using State = typename StateInterface::State;
+        static_assert(std::is_invocable_v<std::decay_t<Fn>, IObject&, State&>,
+                      "ObjectHive::for_each_dirty<StateInterface> visitor must be callable as "
+                      "void(IObject&, StateInterface::State&) or bool(IObject&, StateInterface::State&)");
+        if (!hive_) {
+            return 0;
+        }
+        return hive_->for_each_dirty(
+            StateInterface::UID, &fn, [](void* ctx, IObject& obj, void* state) -> bool {
+                return invoke_visitor(*static_cast<std::remove_reference_t<Fn>*>(ctx), obj,
+                                      *static_cast<State*>(state));
             });
+    }
+
+    /**
+     * @brief Journals the changes to StateInterface properties for write_changes<StateInterface>().
+     *
+     * Must be called before the first add(). See IObjectHive::add_change_journal().
+     *
+     * @tparam StateInterface The interface whose changes to journal.
+     */
+    template <class StateInterface>
+    ReturnValue add_change_journal()
+    {
+        using State = typename StateInterface::State;
+        static_assert(std::is_trivially_copyable_v<State>,
+                      "ObjectHive::add_change_journal requires a trivially copyable State");
+        return hive_ ? hive_->add_change_journal(StateInterface::UID, sizeof(State), alignof(State))
+                     : ReturnValue::Fail;
+    }
+
+    /**
+     * @brief Returns the StateInterface properties changed since the last call as a change journal.
+     *
+     * Read the journal with for_each_change(). See IObjectHive::write_changes().
+     *
+     * @tparam StateInterface An interface added with add_change_journal<StateInterface>().
+     */
+    template <class StateInterface>
+    std::vector<uint8_t> write_changes()
+    {
+        std::vector<uint8_t> data;
+        if (!hive_) {
+            return data;
+        }
+        // Changes may be made between the calls, so retry until the journal fits.
+        size_t size = hive_->write_changes(StateInterface::UID, nullptr, 0);
+        while (size > data.size()) {
+            data.resize(size);
+            size = hive_->write_changes(StateInterface::UID, data.data(), data.size());
         }
+        data.resize(size);
+        return data;
+    }
+
+    /**
+     * @brief Indexes the objects by a field of StateInterface::State.
+     *
+     * Must be called before the first add(). See IObjectHive::add_index().
+     *
+     * @tparam StateInterface The interface whose State holds the field.
+     * @param field The indexed member, an arithmetic or enum type.
+     * @param type Hash for equality lookups, Sorted for range lookups as well.
+     */
+    template <class StateInterface, class Key>
+    ReturnValue add_index(Key StateInterface::State::*field, HiveIndexType type = HiveIndexType::Hash)
+    {
+        HiveIndexDesc desc{StateInterface::UID, field_offset<StateInterface>(field), sizeof(Key),
+                           index_key_type<Key>(), type};
+        return hive_ ? hive_->add_index(desc) : ReturnValue::Fail;
+    }
+
+    /**
+     * @brief Visits the objects whose indexed @p field equals @p value.
+     *
+     * @tparam StateInterface The interface whose State holds the field.
+     * @param field A member indexed with add_index<StateInterface>().
+     * @param fn Callable as void(IObject&, StateInterface::State&) or bool(IObject&,
+     *           StateInterface::State&). Return false to stop early.
+     * @return The number of objects visited.
+     */
+    template <class StateInterface, class Key, class Fn>
+    size_t find(Key StateInterface::State::*field, const std::common_type_t<Key>& value, Fn&& fn) const
+    {
+        return find_range<StateInterface>(field, value, value, std::forward<Fn>(fn));
+    }
+
+    /**
+     * @brief Visits the objects whose indexed @p field lies in [@p first, @p last].
+     *
+     * Needs a Sorted index, which visits the objects in field order.
+     *
+     * @tparam StateInterface The interface whose State holds the field.
+     * @param field A member indexed with add_index<StateInterface>().
+     * @param fn Callable as void(IObject&, StateInterface::State&) or bool(IObject&,
+     *           StateInterface::State&). Return false to stop early.
+     * @return The number of objects visited.
+     */
+    template <class StateInterface, class Key, class Fn>
+    size_t find_range(Key StateInterface::State::*field, const std::common_type_t<Key>& first,
+                      const std::common_type_t<Key>& last, Fn&& fn) const
+    {
+        using State = typename StateInterface::State;
+        static_assert(std::is_invocable_v<std::decay_t<Fn>, IObject&, State&>,
+                      "ObjectHive::find<StateInterface> visitor must be callable as "
+                      "void(IObject&, StateInterface::State&) or bool(IObject&, StateInterface::State&)");
+        if (!hive_) {
+            return 0;
+        }
+        constexpr HiveKeyType key_type = index_key_type<Key>();
+        return hive_->find_indexed(
+            StateInterface::UID, field_offset<StateInterface>(field),
+            encode_hive_index_key(&first, key_type, sizeof(Key)), encode_hive_index_key(&last, key_type, sizeof(Key)),
+            &fn, [](void* ctx, IObject& obj, void* state) -> bool {
+                return invoke_visitor(*static_cast<std::remove_reference_t<Fn>*>(ctx), obj,
+                                      *static_cast<State*>(state));
+            });
+    }
+
+    /** @brief Frees pages that no longer hold any objects. Returns the number of pages freed. */
+    size_t compact() { return hive_ ? hive_->compact() : 0; }
+
+    /** @brief Frees unused pages while keeping at least @p keep_free_slots free slots. See IHive::trim(). */
+    size_t trim(size_t keep_free_slots = 0) { return hive_ ? hive_->trim(keep_free_slots) : 0; }
+
+    /** @brief Preallocates at least @p free_slots free slots in a single page. See IHive::reserve(). */
+    ReturnValue reserve(size_t free_slots) { return hive_ ? hive_->reserve(free_slots) : ReturnValue::Fail; }
+
+    /** @brief Pads slots to a multiple of @p alignment bytes. See IHive::set_slot_alignment(). */
+    ReturnValue set_slot_alignment(size_t alignment)
+    {
+        return hive_ ? hive_->set_slot_alignment(alignment) : ReturnValue::Fail;
     }
 
     /** @brief Removes all objects from the hive. */
@@ -141,6 +512,29 @@ public:
         }
     }
 
+    /**
+     * @brief Removes all objects, destroying them on the tasks of @p executor, and releases the
+     *        unused pages. See IObjectHive::clear_parallel().
+     */
+    void clear_parallel(IExecutor* executor, HivePageRelease release = HivePageRelease::Immediate)
+    {
+        if (hive_) {
+            hive_->clear_parallel(executor, release);
+        }
+    }
+
+    /** @brief Sets which threads may use the hive. See IObjectHive::set_threading(). */
+    ReturnValue set_threading(HiveThreading threading)
+    {
+        return hive_ ? hive_->set_threading(threading) : ReturnValue::Fail;
+    }
+
+    /**
+     * @brief Returns the event fired once per update() with the objects added and removed.
+     *        See IObjectHive::on_membership_changed().
+     */
+    Event on_membership_changed() const { return Event(hive_ ? hive_->on_membership_changed() : nullptr); }
+
     /** @brief Returns the underlying IObjectHive. */
     IObjectHive& raw() { return *hive_; }
     /** @brief Returns the underlying IObjectHive (const). */
@@ -148,6 +542,109 @@ public:
 
 protected:
     IObjectHive::Ptr hive_;
+
+private:
+    template <class StateInterface, class Fn>
+    void visit_columns(Fn& fn, IExecutor* executor) const
+    {
+        using State = typename StateInterface::State;
+        static_assert(std::is_invocable_r_v<bool, Fn&, State*, const uint64_t*, size_t>,
+                      "ObjectHive::for_each_column<StateInterface> visitor must be callable as "
+                      "bool(StateInterface::State*, const uint64_t*, size_t)");
+        if (!hive_) {
+            return;
+        }
+        hive_->for_each_column(
+            StateInterface::UID,
+            &fn,
+            [](void* ctx, const HivePageView&, const HivePageView& states) -> bool {
+                auto& f = *static_cast<Fn*>(ctx);
+                return f(static_cast<State*>(states.data), states.active_bits, states.count);
+            },
+            executor);
+    }
+
+    template <class StateInterface, class Fn>
+    void visit_column_runs(Fn& fn, IExecutor* executor) const
+    {
+        using State = typename StateInterface::State;
+        static_assert(std::is_invocable_r_v<bool, Fn&, State*, size_t>,
+                      "ObjectHive::for_each_column_run<StateInterface> visitor must be callable as "
+                      "bool(StateInterface::State*, size_t)");
+        if (!hive_) {
+            return;
+        }
+        hive_->for_each_column(
+            StateInterface::UID,
+            &fn,
+            [](void* ctx, const HivePageView&, const HivePageView& states) -> bool {
+                auto& f = *static_cast<Fn*>(ctx);
+                return for_each_active_run(states, [&](size_t first, size_t count) -> bool {
+                    return f(page_view_at<State>(states, first), count);
+                });
+            },
+            executor);
+    }
+
+    template <class StateInterface, class Fn>
+    void visit_front(Fn& fn, IExecutor* executor) const
+    {
+        using State = typename StateInterface::State;
+        static_assert(std::is_invocable_r_v<bool, Fn&, IObject&, const State&>,
+                      "ObjectHive::for_each_front<StateInterface> visitor must be callable as "
+                      "bool(IObject&, const StateInterface::State&)");
+        if (!hive_) {
+            return;
+        }
+        hive_->for_each_front(
+            StateInterface::UID,
+            &fn,
+            [](void* ctx, const HivePageView& objects, const HivePageView& states) -> bool {
+                auto& f = *static_cast<Fn*>(ctx);
+                return for_each_active_slot(states, [&](size_t i) -> bool {
+                    return f(*page_view_at<IObject>(objects, i), *page_view_at<const State>(states, i));
+                });
+            },
+            executor);
+    }
+
+    template <class StateInterface, class Fn>
+    void visit_inline_states(Fn& fn, ptrdiff_t state_offset, IExecutor* executor) const
+    {
+        using State = typename StateInterface::State;
+        struct Ctx
+        {
+            Fn* fn;
+            ptrdiff_t state_offset;
+        } ctx{&fn, state_offset};
+        hive_->for_each_page(
+            &ctx,
+            [](void* c, const HivePageView& page) -> bool {
+                auto& ctx = *static_cast<Ctx*>(c);
+                return for_each_active_slot(page, [&](size_t i) -> bool {
+                    auto* obj = page_view_at<char>(page, i);
+                    return (*ctx.fn)(*reinterpret_cast<IObject*>(obj),
+                                     *reinterpret_cast<State*>(obj + ctx.state_offset));
+                });
+            },
+            executor);
+    }
+
+    template <class StateInterface, class Fn>
+    void visit_column_states(Fn& fn, IExecutor* executor) const
+    {
+        using State = typename StateInterface::State;
+        hive_->for_each_column(
+            StateInterface::UID,
+            &fn,
+            [](void* ctx, const HivePageView& objects, const HivePageView& states) -> bool {
+                auto& f = *static_cast<Fn*>(ctx);
+                return for_each_active_slot(states, [&](size_t i) -> bool {
+                    return f(*page_view_at<IObject>(objects, i), *page_view_at<State>(states, i));
+                });
+            },
+            executor);
+    }
 };
 
 } // namespace detail
@@ -195,17 +692,45 @@ public:
         return interface_pointer_cast<T>(hive_->add());
     }
 
+    /** @brief Creates @p count objects under a single lock acquisition. See IObjectHive::add_n(). */
+    std::vector<typename T::Ptr> add_n(size_t count)
+    {
+        std::vector<typename T::Ptr> result;
+        if (!hive_) {
+            return result;
+        }
+        if constexpr (std::is_same_v<T, IObject>) {
+            result.resize(count);
+            result.resize(hive_->add_n(count, result.data()));
+        } else {
+            std::vector<IObject::Ptr> objects(count);
+            objects.resize(hive_->add_n(count, objects.data()));
+            result.reserve(objects.size());
+            for (auto& obj : objects) {
+                result.push_back(interface_pointer_cast<T>(obj));
+            }
+        }
+        return result;
+    }
+
     /** @brief Removes an object from the hive. Returns Success or Fail if not found. */
     ReturnValue remove(T& object) { return hive_ ? hive_->remove(object) : ReturnValue::Fail; }
 
     /** @brief Returns true if the given object is in this hive. */
     bool contains(const T& object) const { return hive_ && hive_->contains(object); }
 
+    /** @brief Returns a generational handle to @p object. See IObjectHive::get_handle(). */
+    HiveHandle get_handle(const T& object) const { return hive_ ? hive_->get_handle(object) : HiveHandle{}; }
+
+    /** @brief Returns the object behind @p handle as T, or nullptr if the handle is stale. */
+    T* resolve(HiveHandle handle) const { return interface_cast<T>(hive_ ? hive_->resolve(handle) : nullptr); }
+
     /**
      * @brief Iterates all live objects with a typed callback.
      *
      * The interface offset from IObject to T is computed once via get_interface
-     * on the first element, then applied via pointer arithmetic for the rest.
+     * on the first element, then applied via pointer arithmetic for the rest. Only
+     * the per-page callback is virtual, so fn can be inlined into the loop.
      *
      * @param fn Callable as void(T&) or bool(T&). Return false to stop early.
      */
@@ -214,19 +739,80 @@ public:
     {
         static_assert(std::is_invocable_v<std::decay_t<Fn>, T&>,
                       "ObjectHive::for_each visitor must be callable as void(T&) or bool(T&)");
-        for_each_as(T::UID, &fn, [](void* ctx, IObject&, void* typed) -> bool {
-            auto& f = *static_cast<std::decay_t<Fn>*>(ctx);
-            auto& obj = *static_cast<T*>(typed);
-            if constexpr (std::is_same_v<decltype(f(obj)), bool>) {
-                return f(obj);
-            } else {
-                f(obj);
-                return true;
-            }
-        });
+        visit_as<T>(fn);
     }
 };
 
+/**
+ * @brief Calls fn for each record of a change journal written by IObjectHive::write_changes().
+ *
+ * @param data The journal.
+ * @param size Size of @p data in bytes.
+ * @param fn Callable as void(HiveHandle handle, uint32_t member, const void* value, size_t size),
+ *           where @p member indexes the metadata of the journal's interface.
+ * @return The number of records visited, or 0 if @p data is not a valid journal.
+ */
+template <class Fn>
+size_t for_each_change(const void* data, size_t size, Fn&& fn)
+{
+    static_assert(std::is_invocable_v<std::decay_t<Fn>, HiveHandle, uint32_t, const void*, size_t>,
+                  "for_each_change visitor must be callable as "
+                  "void(HiveHandle, uint32_t member, const void* value, size_t size)");
+    HiveJournalHeader header;
+    if (!data || size < sizeof(header)) {
+        return 0;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != HiveJournalHeader::MAGIC || header.version != HiveJournalHeader::VERSION ||
+        header.size > size) {
+        return 0;
+    }
+    auto* bytes = static_cast<const char*>(data);
+    size_t offset = sizeof(header);
+    size_t visited = 0;
+    while (visited < header.count && offset + sizeof(HiveJournalRecord) <= header.size) {
+        HiveJournalRecord record;
+        std::memcpy(&record, bytes + offset, sizeof(record));
+        offset += sizeof(record);
+        if (offset + record.size > header.size) {
+            break;
+        }
+        fn(HiveHandle{record.handle}, record.member, static_cast<const void*>(bytes + offset),
+           static_cast<size_t>(record.size));
+        offset += (size_t(record.size) + 7) & ~size_t(7);
+        ++visited;
+    }
+    return visited;
+}
+
+/**
+ * @brief Writes the value of a change journal record into a StateInterface::State.
+ *
+ * @tparam StateInterface The interface of the journal.
+ * @param state The State to update, e.g. of the receiver's replica of the object.
+ * @param member The record's index in StateInterface::metadata.
+ * @param value The record's value.
+ * @param size Size of @p value in bytes.
+ * @return True if @p member is a property of StateInterface whose value has @p size bytes.
+ */
+template <class StateInterface>
+bool apply_change(typename StateInterface::State& state, uint32_t member, const void* value, size_t size)
+{
+    static_assert(std::is_trivially_copyable_v<typename StateInterface::State>,
+                  "apply_change requires a trivially copyable State");
+    if (member >= StateInterface::metadata.size()) {
+        return false;
+    }
+    auto& desc = StateInterface::metadata[member];
+    auto* pk = desc.kind == MemberKind::Property ? desc.propertyKind() : nullptr;
+    const IAny* def = pk && pk->stateOffset && pk->getDefault ? pk->getDefault() : nullptr;
+    if (!def || def->get_data_size(pk->typeUid) != size) {
+        return false;
+    }
+    std::memcpy(reinterpret_cast<char*>(&state) + pk->stateOffset(), value, size);
+    return true;
+}
+
 } // namespace velk
 
 #endif // VELK_API_OBJECT_HIVE_H
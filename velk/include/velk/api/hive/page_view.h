@@ -0,0 +1,123 @@
+#ifndef VELK_API_HIVE_PAGE_VIEW_H
+#define VELK_API_HIVE_PAGE_VIEW_H
+
+#include <velk/interface/hive/intf_hive.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+
+namespace velk {
+namespace detail {
+
+/** @brief Returns the index of the lowest set bit, or 64 if none. */
+inline unsigned bitscan_forward64(uint64_t mask)
+{
+#ifdef _WIN32
+    unsigned long idx;
+    if (_BitScanForward64(&idx, mask)) {
+        return static_cast<unsigned>(idx);
+    }
+    return 64;
+#else
+    if (mask == 0) {
+        return 64;
+    }
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+}
+
+/** @brief Calls fn(args...) and returns its result, or true if fn returns void. */
+template <class Fn, class... Args>
+bool invoke_visitor(Fn& fn, Args&&... args)
+{
+    if constexpr (std::is_same_v<decltype(fn(std::forward<Args>(args)...)), bool>) {
+        return fn(std::forward<Args>(args)...);
+    } else {
+        fn(std::forward<Args>(args)...);
+        return true;
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Calls fn(index) for the index of every live slot in @p view, in ascending order.
+ *
+ * The loop is header-side, so a trivial fn is inlined into it.
+ *
+ * @param view The run of slots to scan.
+ * @param fn Callable as bool(size_t index). Return false to stop early.
+ * @return false if fn stopped the scan.
+ */
+template <class Fn>
+bool for_each_active_slot(const HivePageView& view, Fn&& fn)
+{
+    size_t num_words = (view.count + 63) / 64;
+    for (size_t w = 0; w < num_words; ++w) {
+        uint64_t bits = view.active_bits[w];
+        while (bits) {
+            size_t i = w * 64 + detail::bitscan_forward64(bits);
+            bits &= bits - 1;
+            if (!fn(i)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Calls fn(first, count) for every run of consecutive live slots in @p view, in ascending order.
+ *
+ * Runs are found a word of active bits at a time and merged across word boundaries,
+ * so a fully live page is reported as a single run. Slot first + k of a run lives at
+ * page_view_at(view, first + k), which lets a caller run a SIMD kernel over long runs.
+ *
+ * @param view The run of slots to scan.
+ * @param fn Callable as bool(size_t first, size_t count). Return false to stop early.
+ * @return false if fn stopped the scan.
+ */
+template <class Fn>
+bool for_each_active_run(const HivePageView& view, Fn&& fn)
+{
+    size_t num_words = (view.count + 63) / 64;
+    size_t run_first = 0;
+    size_t run_count = 0;
+    for (size_t w = 0; w < num_words; ++w) {
+        uint64_t bits = view.active_bits[w];
+        while (bits) {
+            unsigned b = detail::bitscan_forward64(bits);
+            // Length of the block of set bits starting at b (64 - b if it reaches the top).
+            unsigned len = detail::bitscan_forward64(~(bits >> b));
+            size_t first = w * 64 + b;
+            if (run_count && run_first + run_count == first) {
+                run_count += len;
+            } else {
+                if (run_count && !fn(run_first, run_count)) {
+                    return false;
+                }
+                run_first = first;
+                run_count = len;
+            }
+            bits = b + len < 64 ? bits & (~uint64_t(0) << (b + len)) : 0;
+        }
+    }
+    return !run_count || fn(run_first, run_count);
+}
+
+/** @brief Returns a typed pointer to slot @p index of @p view. */
+template <class T>
+T* page_view_at(const HivePageView& view, size_t index)
+{
+    return reinterpret_cast<T*>(static_cast<char*>(view.data) + index * view.stride);
+}
+
+} // namespace velk
+
+#endif // VELK_API_HIVE_PAGE_VIEW_H
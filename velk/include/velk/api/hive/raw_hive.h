@@ -1,9 +1,12 @@
 #ifndef VELK_API_RAW_HIVE_H
 #define VELK_API_RAW_HIVE_H
 
+#include <velk/api/hive/page_view.h>
 #include <velk/interface/hive/intf_hive_store.h>
 
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace velk {
 
@@ -48,6 +51,26 @@ public:
         return new (slot) T(static_cast<Args&&>(args)...);
     }
 
+    /**
+     * @brief Constructs @p count elements from the same arguments under a single lock acquisition.
+     * @param count Number of elements to construct.
+     * @param out Receives the constructed elements, must hold @p count elements.
+     * @return The number of elements constructed.
+     */
+    template <class... Args>
+    size_t emplace_n(size_t count, T** out, const Args&... args)
+    {
+        if (!hive_ || !out) {
+            return 0;
+        }
+        std::vector<void*> slots(count);
+        size_t allocated = hive_->allocate_n(count, slots.data());
+        for (size_t i = 0; i < allocated; ++i) {
+            out[i] = new (slots[i]) T(args...);
+        }
+        return allocated;
+    }
+
     /** @brief Destroys the object and reclaims its slot. */
     void deallocate(T* ptr)
     {
@@ -70,6 +93,10 @@ public:
 
     /**
      * @brief Iterates all live elements with a typed callback.
+     *
+     * Only the per-page callback is virtual; fn is called from a loop in this header
+     * and can be inlined into it.
+     *
      * @param fn Callable as void(T&) or bool(T&). Return false to stop early.
      */
     template <class Fn>
@@ -77,21 +104,151 @@ public:
     {
         static_assert(std::is_invocable_v<std::decay_t<Fn>, T&>,
                       "RawHive::for_each visitor must be callable as void(T&) or bool(T&)");
+        visit_pages(fn, nullptr);
+    }
+
+    /**
+     * @brief Parallel variant of for_each() running on an executor.
+     *
+     * The visitor is called concurrently from the executor's workers and must be thread-safe.
+     *
+     * @param executor Executor running the workers. If null, iterates on the calling thread.
+     * @param fn Callable as void(T&) or bool(T&). Return false to stop early.
+     */
+    template <class Fn>
+    void for_each_parallel(IExecutor* executor, Fn&& fn) const
+    {
+        static_assert(std::is_invocable_v<std::decay_t<Fn>, T&>,
+                      "RawHive::for_each_parallel visitor must be callable as void(T&) or bool(T&)");
+        visit_pages(fn, executor);
+    }
+
+    /**
+     * @brief Iterates runs of consecutive live elements.
+     *
+     * Each run is a contiguous T array, so fn can run a SIMD kernel over it. A fully
+     * live page is a single run; sparse pages yield shorter runs. In a hive with padded
+     * slots (see set_slot_alignment()) every run holds one element.
+     *
+     * @param fn Callable as void(T* first, size_t count) or bool(T* first, size_t count).
+     *           Return false to stop early.
+     */
+    template <class Fn>
+    void for_each_run(Fn&& fn) const
+    {
+        static_assert(std::is_invocable_v<std::decay_t<Fn>, T*, size_t>,
+                      "RawHive::for_each_run visitor must be callable as void(T*, size_t) or "
+                      "bool(T*, size_t)");
+        visit_runs(fn, nullptr);
+    }
+
+    /**
+     * @brief Parallel variant of for_each_run() running on an executor.
+     *
+     * Pages are split into runs of bitmask words, so runs end at chunk boundaries.
+     * fn is called concurrently from the executor's workers and must be thread-safe.
+     *
+     * @param executor Executor running the workers. If null, iterates on the calling thread.
+     * @param fn Callable as void(T* first, size_t count) or bool(T* first, size_t count).
+     */
+    template <class Fn>
+    void for_each_run_parallel(IExecutor* executor, Fn&& fn) const
+    {
+        static_assert(std::is_invocable_v<std::decay_t<Fn>, T*, size_t>,
+                      "RawHive::for_each_run_parallel visitor must be callable as void(T*, size_t) or "
+                      "bool(T*, size_t)");
+        visit_runs(fn, executor);
+    }
+
+    /**
+     * @brief Moves live elements into as few pages as possible and frees the emptied pages.
+     *
+     * Pointers to moved elements are invalidated; @p fn is called for each move so
+     * that references can be patched.
+     *
+     * @param fn Callable as void(T* old_ptr, T* new_ptr).
+     * @return The number of pages freed.
+     */
+    template <class Fn>
+    size_t compact(Fn&& fn)
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "RawHive::compact moves elements with memcpy and requires a trivially copyable T");
+        static_assert(std::is_invocable_v<std::decay_t<Fn>, T*, T*>,
+                      "RawHive::compact callback must be callable as void(T* old_ptr, T* new_ptr)");
         if (!hive_) {
-            return;
+            return 0;
         }
-        hive_->for_each(&fn, [](void* ctx, void* elem) -> bool {
-            auto& f = *static_cast<std::decay_t<Fn>*>(ctx);
-            T& obj = *static_cast<T*>(elem);
-            if constexpr (std::is_same_v<decltype(f(obj)), bool>) {
-                return f(obj);
-            } else {
-                f(obj);
-                return true;
-            }
+        return hive_->compact(&fn, [](void* ctx, void* old_ptr, void* new_ptr) {
+            (*static_cast<std::decay_t<Fn>*>(ctx))(static_cast<T*>(old_ptr), static_cast<T*>(new_ptr));
         });
     }
 
+    /** @brief Moves live elements into as few pages as possible. Returns the number of pages freed. */
+    size_t compact()
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "RawHive::compact moves elements with memcpy and requires a trivially copyable T");
+        return hive_ ? hive_->compact(nullptr, nullptr) : 0;
+    }
+
+    /**
+     * @brief Reorders the live elements by key and packs them into the fewest pages.
+     *
+     * Afterwards for_each() and for_each_run() visit the elements in ascending key order, so
+     * elements processed together sit next to each other in memory. See IRawHive::sort().
+     *
+     * @param key Callable as Key(const T&), where Key is comparable with operator<.
+     * @param fn Callable as void(T* old_ptr, T* new_ptr), called for each moved element.
+     * @return The number of elements moved.
+     */
+    template <class KeyFn, class Fn>
+    size_t sort_by(KeyFn&& key, Fn&& fn)
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "RawHive::sort_by moves elements with memcpy and requires a trivially copyable T");
+        static_assert(std::is_invocable_v<std::decay_t<KeyFn>, const T&>,
+                      "RawHive::sort_by key must be callable as Key(const T&)");
+        static_assert(std::is_invocable_v<std::decay_t<Fn>, T*, T*>,
+                      "RawHive::sort_by callback must be callable as void(T* old_ptr, T* new_ptr)");
+        if (!hive_) {
+            return 0;
+        }
+        struct Context
+        {
+            std::decay_t<KeyFn>& key;
+            std::decay_t<Fn>& fn;
+        } ctx{key, fn};
+        return hive_->sort(
+            &ctx,
+            [](void* c, const void* lhs, const void* rhs) {
+                auto& key = static_cast<Context*>(c)->key;
+                return key(*static_cast<const T*>(lhs)) < key(*static_cast<const T*>(rhs));
+            },
+            [](void* c, void* old_ptr, void* new_ptr) {
+                static_cast<Context*>(c)->fn(static_cast<T*>(old_ptr), static_cast<T*>(new_ptr));
+            });
+    }
+
+    /** @brief Reorders the live elements by key. Returns the number of elements moved. */
+    template <class KeyFn>
+    size_t sort_by(KeyFn&& key)
+    {
+        return sort_by(std::forward<KeyFn>(key), [](T*, T*) {});
+    }
+
+    /** @brief Frees empty pages while keeping at least @p keep_free_slots free slots. See IHive::trim(). */
+    size_t trim(size_t keep_free_slots = 0) { return hive_ ? hive_->trim(keep_free_slots) : 0; }
+
+    /** @brief Preallocates at least @p free_slots free slots in a single page. See IHive::reserve(). */
+    ReturnValue reserve(size_t free_slots) { return hive_ ? hive_->reserve(free_slots) : ReturnValue::Fail; }
+
+    /** @brief Pads slots to a multiple of @p alignment bytes. See IHive::set_slot_alignment(). */
+    ReturnValue set_slot_alignment(size_t alignment)
+    {
+        return hive_ ? hive_->set_slot_alignment(alignment) : ReturnValue::Fail;
+    }
+
     /** @brief Destroys all live elements and resets the hive to empty. */
     void clear()
     {
@@ -105,12 +262,125 @@ public:
         }
     }
 
+    /**
+     * @brief Destroys all live elements on the tasks of @p executor and resets the hive to empty.
+     *        T's destructor must be safe to run concurrently. See IRawHive::clear_parallel().
+     */
+    void clear_parallel(IExecutor* executor, HivePageRelease release = HivePageRelease::Immediate)
+    {
+        if (!hive_) {
+            return;
+        }
+        if constexpr (std::is_trivially_destructible_v<T>) {
+            hive_->clear_parallel(nullptr, nullptr, executor, release);
+        } else {
+            hive_->clear_parallel(
+                nullptr, [](void*, void* elem) { static_cast<T*>(elem)->~T(); }, executor, release);
+        }
+    }
+
+    /**
+     * @brief Writes the hive into a snapshot, pages and active bitmasks verbatim.
+     * @return The snapshot, empty if the hive is invalid. See IRawHive::snapshot().
+     */
+    std::vector<uint8_t> snapshot() const
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "RawHive::snapshot copies elements with memcpy and requires a trivially copyable T");
+        std::vector<uint8_t> data;
+        if (!hive_) {
+            return data;
+        }
+        // The hive may grow between the calls, so retry until the snapshot fits.
+        size_t size = hive_->snapshot(nullptr, 0);
+        do {
+            data.resize(size);
+        } while ((size = hive_->snapshot(data.data(), data.size())) > data.size());
+        data.resize(size);
+        return data;
+    }
+
+    /**
+     * @brief Replaces the hive contents with a snapshot, discarding the current elements.
+     *
+     * T is trivially copyable, so the current elements need no destruction.
+     * See IRawHive::restore().
+     */
+    ReturnValue restore(const void* data, size_t size)
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "RawHive::restore copies elements with memcpy and requires a trivially copyable T");
+        return hive_ ? hive_->restore(data, size) : ReturnValue::Fail;
+    }
+
+    /**
+     * @brief Replaces the hive contents with the pages of a mapped snapshot file, used in place.
+     *
+     * @code
+     * auto mapping = instance().create<IHiveSnapshotMapping>(ClassId::HiveSnapshotMapping);
+     * if (succeeded(mapping->open("records.hive"))) {
+     *     hive.adopt(mapping);
+     * }
+     * @endcode
+     *
+     * See IRawHive::adopt().
+     */
+    ReturnValue adopt(const IHiveSnapshotMapping::Ptr& mapping)
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "RawHive::adopt uses snapshot bytes as elements and requires a trivially copyable T");
+        return hive_ ? hive_->adopt(mapping) : ReturnValue::Fail;
+    }
+
     /** @brief Returns the underlying IRawHive. */
     IRawHive& raw() { return *hive_; }
     /** @brief Returns the underlying IRawHive (const). */
     const IRawHive& raw() const { return *hive_; }
 
 private:
+    template <class Fn>
+    void visit_pages(Fn& fn, IExecutor* executor) const
+    {
+        if (!hive_) {
+            return;
+        }
+        hive_->for_each_page(
+            &fn,
+            [](void* ctx, const HivePageView& page) -> bool {
+                auto& f = *static_cast<Fn*>(ctx);
+                return for_each_active_slot(page, [&](size_t i) -> bool {
+                    return detail::invoke_visitor(f, *page_view_at<T>(page, i));
+                });
+            },
+            executor);
+    }
+
+    template <class Fn>
+    void visit_runs(Fn& fn, IExecutor* executor) const
+    {
+        // Slots are padded to hold a freelist link, which would break up the T array.
+        static_assert(sizeof(T) >= sizeof(size_t),
+                      "RawHive::for_each_run requires sizeof(T) >= sizeof(size_t) for contiguous slots");
+        if (!hive_) {
+            return;
+        }
+        hive_->for_each_page(
+            &fn,
+            [](void* ctx, const HivePageView& page) -> bool {
+                auto& f = *static_cast<Fn*>(ctx);
+                if (page.stride != sizeof(T)) {
+                    // Padded slots (IHive::set_slot_alignment()) only form runs of one.
+                    return for_each_active_slot(page, [&](size_t i) -> bool {
+                        return detail::invoke_visitor(f, page_view_at<T>(page, i), size_t{1});
+                    });
+                }
+                return for_each_active_run(page, [&](size_t first, size_t count) -> bool {
+                    return detail::invoke_visitor(f, page_view_at<T>(page, first), count);
+                });
+            },
+            executor);
+    }
+
     IRawHive::Ptr hive_;
 };
 
@@ -153,6 +153,28 @@ public:
         return storage ? storage->template find_attachment<T>(classUid) : typename T::Ptr{};
     }
 
+    /** @brief Makes the object immutable. See IObjectStorage::freeze(). */
+    ReturnValue freeze()
+    {
+        auto* storage = as<IObjectStorage>();
+        return storage ? storage->freeze() : ReturnValue::InvalidArgument;
+    }
+
+    /** @brief Returns true if the object was frozen. */
+    bool frozen() const { return flags() & ObjectFlags::Frozen; }
+
+    /**
+     * @brief Returns a property of a frozen object without adding a reference to it.
+     * @return The property, or nullptr if the object is not frozen or has no such property.
+     */
+    borrowed_ptr<IProperty> borrow_property(string_view name) const
+    {
+        auto* storage = as<IObjectStorage>();
+        MemberId id(name);
+        auto property = borrow_member<IProperty>(storage, id, MemberKind::Property);
+        return property ? property : borrow_member<IProperty>(storage, id, MemberKind::ArrayProperty);
+    }
+
     /** @brief Returns the underlying IObject shared pointer. */
     IObject::Ptr get() const { return obj_; }
 
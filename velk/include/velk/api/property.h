@@ -3,6 +3,7 @@
 
 #include <velk/api/any.h>
 #include <velk/api/velk.h>
+#include <velk/array_view.h>
 #include <velk/common.h>
 #include <velk/interface/intf_array_property.h>
 #include <velk/interface/intf_function.h>
@@ -11,6 +12,8 @@
 #include <velk/interface/types.h>
 #include <velk/vector.h>
 
+#include <type_traits>
+
 namespace velk {
 
 namespace detail {
@@ -80,11 +83,16 @@ public:
     /** @brief Returns the current value of the property. */
     T get_value() const
     {
+        if (!prop_) {
+            return Type{};
+        }
+        if (auto* state = prop_->get_state_data(TYPE_UID)) {
+            return *static_cast<const Type*>(state);
+        }
+        // Fall back to the backing any, e.g. when an extension is installed.
         Type value{};
-        if (auto internal = get_internal()) {
-            if (auto any = internal->get_any()) {
-                any->get_data(&value, sizeof(Type), TYPE_UID);
-            }
+        if (auto any = prop_->borrow_value()) {
+            any->get_data(&value, sizeof(Type), TYPE_UID);
         }
         return value;
     }
@@ -110,6 +118,9 @@ public:
     ReturnValue set_value(const Type& value, InvokeType type = Immediate)
     {
         if (auto internal = this->get_internal()) {
+            if constexpr (std::is_trivially_copyable_v<Type>) {
+                return internal->set_trivial_data(&value, sizeof(Type), Base::TYPE_UID, type);
+            }
             return internal->set_data(&value, sizeof(Type), Base::TYPE_UID, type);
         }
         return ReturnValue::Fail;
@@ -143,6 +154,22 @@ public:
     /** @brief Returns a full copy of the vector. */
     vector<Type> get_value() const { return arr().get_value(); }
 
+    /**
+     * @brief Returns a view of the elements without copying them.
+     *
+     * The view is valid until the array is modified. It is empty if the property has no
+     * element storage, e.g. while an animation extension is installed.
+     */
+    array_view<Type> view() const
+    {
+        if (auto* ap = interface_cast<IArrayProperty>(this->prop_)) {
+            if (auto* data = static_cast<const Type*>(ap->array_data(type_uid<Type>()))) {
+                return {data, ap->array_size()};
+            }
+        }
+        return {};
+    }
+
 protected:
     ArrayAny<const Type> arr() const { return ArrayAny<const Type>(prop_ ? prop_->get_value() : nullptr); }
 };
@@ -164,44 +191,70 @@ public:
     explicit ArrayProperty(IProperty::Ptr existing) : Base(std::move(existing)) {}
 
     /** @brief Sets the element at @p index to @p value. */
-    ReturnValue set_at(size_t index, const Type& value)
+    ReturnValue set_at(size_t index, const Type& value, InvokeType type = Immediate)
     {
         if (auto* ap = get_array_prop()) {
-            ext::AnyValue<Type> av;
-            av.set_value(value);
-            return ap->set_at(index, av);
+            return ap->set_at(index, ext::AnyArg<Type>(value), type);
         }
         return ReturnValue::Fail;
     }
 
     /** @brief Appends @p value to the end of the array. */
-    ReturnValue push_back(const Type& value)
+    ReturnValue push_back(const Type& value, InvokeType type = Immediate)
     {
         if (auto* ap = get_array_prop()) {
-            ext::AnyValue<Type> av;
-            av.set_value(value);
-            return ap->push_back(av);
+            return ap->push_back(ext::AnyArg<Type>(value), type);
         }
         return ReturnValue::Fail;
     }
 
     /** @brief Erases the element at @p index. */
-    ReturnValue erase_at(size_t index)
+    ReturnValue erase_at(size_t index, InvokeType type = Immediate)
     {
         if (auto* ap = get_array_prop()) {
-            return ap->erase_at(index);
+            return ap->erase_at(index, type);
         }
         return ReturnValue::Fail;
     }
 
     /** @brief Removes all elements. */
-    void clear()
+    void clear(InvokeType type = Immediate)
     {
         if (auto* ap = get_array_prop()) {
-            ap->clear_array();
+            ap->clear_array(type);
         }
     }
 
+    /** @brief Overwrites the elements starting at @p index with @p values, notifying once. */
+    ReturnValue set_range(size_t index, array_view<Type> values, InvokeType type = Immediate)
+    {
+        auto* ap = get_array_prop();
+        return ap ? ap->set_range(index, values.begin(), values.size(), type_uid<Type>(), type)
+                  : ReturnValue::Fail;
+    }
+
+    /** @brief Inserts @p values before the element at @p index, notifying once. */
+    ReturnValue insert_range(size_t index, array_view<Type> values, InvokeType type = Immediate)
+    {
+        auto* ap = get_array_prop();
+        return ap ? ap->insert_range(index, values.begin(), values.size(), type_uid<Type>(), type)
+                  : ReturnValue::Fail;
+    }
+
+    /** @brief Erases @p count elements starting at @p index, notifying once. */
+    ReturnValue erase_range(size_t index, size_t count, InvokeType type = Immediate)
+    {
+        auto* ap = get_array_prop();
+        return ap ? ap->erase_range(index, count, type) : ReturnValue::Fail;
+    }
+
+    /** @brief Resizes the array to @p count elements, value-initializing new ones. */
+    ReturnValue resize(size_t count, InvokeType type = Immediate)
+    {
+        auto* ap = get_array_prop();
+        return ap ? ap->resize_array(count, type) : ReturnValue::Fail;
+    }
+
     /** @brief Sets the whole vector value. */
     ReturnValue set_value(const vector<Type>& value, InvokeType type = Immediate)
     {
@@ -216,6 +269,17 @@ private:
     IArrayProperty* get_array_prop() const { return interface_cast<IArrayProperty>(this->prop_); }
 };
 
+/**
+ * @brief Returns the element changes an array property's on_changed passed in @p args.
+ *
+ * The changes are in the order they were applied, see ArrayChange. Empty if @p args carry
+ * none, e.g. in the on_changed of a plain property.
+ */
+inline vector<ArrayChange> get_array_changes(FnArgs args)
+{
+    return Any<const vector<ArrayChange>>(args[1]).get_value();
+}
+
 /**
  * @brief A helper template for creating a new read-only poperty instance
  */
@@ -229,12 +293,13 @@ ConstProperty<std::remove_const_t<T>> create_property(const T& value = {})
 
 /**
  * @brief A helper template for creating a new poperty instance
+ * @param flags ObjectFlags for the property, e.g. ObjectFlags::CompareOnWrite.
  */
 template <class T, class = std::enable_if_t<!std::is_const_v<T>>>
-Property<T> create_property(const T& value = {})
+Property<T> create_property(const T& value = {}, uint32_t flags = ObjectFlags::None)
 {
     Any<T> v(value);
-    return Property<T>(instance().create_property<T>(v.clone()));
+    return Property<T>(instance().create_property<T>(v.clone(), flags));
 }
 
 } // namespace velk
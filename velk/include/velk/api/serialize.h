@@ -0,0 +1,351 @@
+#ifndef VELK_API_SERIALIZE_H
+#define VELK_API_SERIALIZE_H
+
+#include <velk/api/velk.h>
+#include <velk/interface/intf_array_any.h>
+#include <velk/interface/intf_metadata.h>
+#include <velk/interface/intf_object.h>
+#include <velk/string.h>
+
+#include <cstring>
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief Header of a buffer written by save_states().
+ *
+ * The header is followed by @c count blocks, one per State of the object.
+ */
+struct StateStreamHeader
+{
+    static constexpr uint32_t MAGIC = 0x534c4556; ///< "VELS"
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic{MAGIC};
+    uint32_t version{VERSION};
+    Uid class_uid;   ///< Class of the saved object, see load_object().
+    uint64_t count{}; ///< Number of blocks following the header.
+    uint64_t size{};  ///< Size of the whole buffer in bytes, header included.
+};
+
+/** @brief How the payload of a StateBlockHeader is encoded. */
+enum class StateEncoding : uint32_t
+{
+    Blit = 0,    ///< The payload is the State struct, byte for byte.
+    Members = 1, ///< The payload is a sequence of StateMemberRecord entries.
+};
+
+/** @brief Header of one State block. The payload follows, padded to 8 bytes. */
+struct StateBlockHeader
+{
+    Uid interface_uid;     ///< Interface declaring the State.
+    uint64_t layout_hash{}; ///< StateLayout::hash of the saving build.
+    uint64_t size{};        ///< Payload size in bytes, without padding.
+    StateEncoding encoding{};
+    uint32_t reserved{};
+};
+
+/** @brief How the value of a StateMemberRecord is encoded. */
+enum class StateMemberEncoding : uint32_t
+{
+    Value = 0,  ///< Bytes of a trivially copyable value.
+    Array = 1,  ///< Elements of an array of trivially copyable values, back to back.
+    String = 2, ///< Characters of a velk::string, without terminator.
+};
+
+/** @brief One member of a Members encoded block. The value follows, padded to 8 bytes. */
+struct StateMemberRecord
+{
+    uint32_t member{}; ///< Index of the member among the members of its interface.
+    StateMemberEncoding encoding{};
+    uint64_t size{}; ///< Value size in bytes, without padding.
+};
+
+namespace detail {
+
+constexpr size_t state_stream_align(size_t size)
+{
+    return (size + 7) & ~size_t{7};
+}
+
+inline void state_stream_append(std::vector<uint8_t>& out, const void* data, size_t size)
+{
+    size_t at = out.size();
+    out.resize(at + state_stream_align(size));
+    if (size) {
+        std::memcpy(out.data() + at, data, size);
+    }
+}
+
+/** @brief Calls fn(index, desc, kind) for each property member of @p info declared by @p interfaceUid. */
+template <class Fn>
+void for_each_state_member(const ClassInfo& info, Uid interfaceUid, Fn&& fn)
+{
+    uint32_t index = 0;
+    for (auto& desc : info.members) {
+        if (!desc.interfaceInfo || desc.interfaceInfo->uid != interfaceUid) {
+            continue;
+        }
+        if (auto* pk = desc.propertyKind(); pk && pk->createRef) {
+            fn(index, desc, *pk);
+        }
+        ++index;
+    }
+}
+
+/** @brief Appends the serializable members of the State at @p base as StateMemberRecords. */
+inline void save_state_members(std::vector<uint8_t>& out, const ClassInfo& info, Uid interfaceUid, void* base)
+{
+    for_each_state_member(info, interfaceUid, [&](uint32_t index, const MemberDesc& desc, const PropertyKind& pk) {
+        auto ref = pk.createRef(base);
+        if (!ref) {
+            return;
+        }
+        StateMemberRecord record{index};
+        if (auto* ak = desc.arrayPropertyKind()) {
+            auto* arr = interface_cast<IArrayAny>(ref.get());
+            if (!arr || !pk.trivial) {
+                return;
+            }
+            size_t count = arr->array_size();
+            record.encoding = StateMemberEncoding::Array;
+            record.size = count * arr->array_element_size(ak->elementUid);
+            state_stream_append(out, &record, sizeof(record));
+            state_stream_append(out, count ? arr->array_data(ak->elementUid) : nullptr, record.size);
+        } else if (pk.typeUid == type_uid<string>()) {
+            string value;
+            if (failed(ref->get_data(&value, sizeof(value), pk.typeUid))) {
+                return;
+            }
+            record.encoding = StateMemberEncoding::String;
+            record.size = value.size();
+            state_stream_append(out, &record, sizeof(record));
+            state_stream_append(out, value.data(), value.size());
+        } else if (pk.trivial) {
+            size_t size = ref->get_data_size(pk.typeUid);
+            if (!size) {
+                return;
+            }
+            record.encoding = StateMemberEncoding::Value;
+            record.size = size;
+            size_t at = out.size();
+            state_stream_append(out, &record, sizeof(record));
+            out.resize(out.size() + state_stream_align(size));
+            if (failed(ref->get_data(out.data() + at + sizeof(record), size, pk.typeUid))) {
+                out.resize(at);
+            }
+        }
+    });
+}
+
+/** @brief Applies the StateMemberRecords in [data, data + size) to the State at @p base. */
+inline ReturnValue load_state_members(const uint8_t* data, size_t size, const ClassInfo& info, Uid interfaceUid,
+                                      void* base)
+{
+    ReturnValue result = ReturnValue::Success;
+    size_t at = 0;
+    while (at + sizeof(StateMemberRecord) <= size) {
+        StateMemberRecord record;
+        std::memcpy(&record, data + at, sizeof(record));
+        at += sizeof(record);
+        if (record.size > size - at) {
+            return ReturnValue::InvalidArgument;
+        }
+        const uint8_t* value = data + at;
+        at += state_stream_align(record.size);
+        bool applied = false;
+        for_each_state_member(info, interfaceUid, [&](uint32_t index, const MemberDesc& desc, const PropertyKind& pk) {
+            if (index != record.member) {
+                return;
+            }
+            auto ref = pk.createRef(base);
+            if (!ref) {
+                return;
+            }
+            switch (record.encoding) {
+            case StateMemberEncoding::Array: {
+                auto* ak = desc.arrayPropertyKind();
+                auto* arr = interface_cast<IArrayAny>(ref.get());
+                size_t elementSize = ak && arr ? arr->array_element_size(ak->elementUid) : 0;
+                if (elementSize && record.size % elementSize == 0) {
+                    applied = succeeded(arr->set_from_buffer(value, record.size / elementSize, ak->elementUid));
+                }
+                break;
+            }
+            case StateMemberEncoding::String:
+                if (pk.typeUid == type_uid<string>()) {
+                    string s(reinterpret_cast<const char*>(value), static_cast<size_t>(record.size));
+                    applied = succeeded(ref->set_data(&s, sizeof(s), pk.typeUid));
+                }
+                break;
+            case StateMemberEncoding::Value:
+                if (pk.trivial && ref->get_data_size(pk.typeUid) == record.size) {
+                    applied = succeeded(ref->set_data(value, record.size, pk.typeUid));
+                }
+                break;
+            }
+        });
+        if (!applied) {
+            result = ReturnValue::Fail;
+        }
+    }
+    return at == size ? result : ReturnValue::InvalidArgument;
+}
+
+} // namespace detail
+
+/**
+ * @brief Saves the State structs of @p object into a binary buffer.
+ *
+ * Each State is written as one block tagged with its interface UID and layout hash
+ * (StateLayout::hash). A trivially copyable State is copied as a whole. A State with
+ * members that are not, such as strings or arrays, is written member by member:
+ * velk::string values, arrays of trivially copyable elements and trivially copyable values
+ * are saved, other members are left out.
+ *
+ * Only the State structs are saved. Properties without a State (runtime properties),
+ * attachments and bindings are not.
+ *
+ * @return The buffer, or an empty buffer if @p object has no State.
+ */
+inline std::vector<uint8_t> save_states(const IObject& object)
+{
+    std::vector<uint8_t> out;
+    auto* ps = interface_cast<IPropertyState>(const_cast<IObject*>(&object));
+    auto* info = instance().type_registry().get_class_info(object.get_class_uid());
+    if (!ps || !info) {
+        return out;
+    }
+    auto layouts = ps->get_state_layouts();
+    StateStreamHeader header;
+    header.class_uid = object.get_class_uid();
+    out.resize(sizeof(header));
+    for (auto& layout : layouts) {
+        void* base = ps->get_property_state(layout.interfaceUid);
+        if (!base) {
+            continue;
+        }
+        StateBlockHeader block{layout.interfaceUid, layout.hash};
+        size_t at = out.size();
+        out.resize(at + sizeof(block));
+        if (layout.trivial) {
+            block.encoding = StateEncoding::Blit;
+            detail::state_stream_append(out, base, layout.size);
+            block.size = layout.size;
+        } else {
+            block.encoding = StateEncoding::Members;
+            detail::save_state_members(out, *info, layout.interfaceUid, base);
+            block.size = out.size() - at - sizeof(block);
+        }
+        std::memcpy(out.data() + at, &block, sizeof(block));
+        ++header.count;
+    }
+    header.size = out.size();
+    std::memcpy(out.data(), &header, sizeof(header));
+    return out;
+}
+
+/**
+ * @brief Loads State structs saved by save_states() into @p object.
+ *
+ * Each block is matched to a State of @p object by interface UID and layout hash and
+ * loaded in place, after which the object is notified of the change of each loaded
+ * interface (on_changed of its properties, hive dirty marks, COMPUTED invalidation).
+ * A block whose interface is not implemented by @p object or whose layout hash differs
+ * is skipped.
+ *
+ * The object must not be read from other threads during the load.
+ *
+ * @return Success if every block and member was loaded, Fail if some were skipped,
+ *         InvalidArgument if the buffer is malformed.
+ */
+inline ReturnValue load_states(IObject& object, const void* data, size_t size)
+{
+    StateStreamHeader header;
+    if (!data || size < sizeof(header)) {
+        return ReturnValue::InvalidArgument;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != StateStreamHeader::MAGIC || header.version != StateStreamHeader::VERSION ||
+        header.size > size) {
+        return ReturnValue::InvalidArgument;
+    }
+    auto* ps = interface_cast<IPropertyState>(&object);
+    auto* meta = interface_cast<IMetadata>(&object);
+    auto* info = instance().type_registry().get_class_info(object.get_class_uid());
+    if (!ps || !info) {
+        return ReturnValue::Fail;
+    }
+    auto layouts = ps->get_state_layouts();
+    auto* bytes = static_cast<const uint8_t*>(data);
+    ReturnValue result = ReturnValue::Success;
+    size_t at = sizeof(header);
+    for (uint64_t i = 0; i < header.count; ++i) {
+        StateBlockHeader block;
+        if (at + sizeof(block) > header.size) {
+            return ReturnValue::InvalidArgument;
+        }
+        std::memcpy(&block, bytes + at, sizeof(block));
+        at += sizeof(block);
+        if (block.size > header.size - at) {
+            return ReturnValue::InvalidArgument;
+        }
+        const uint8_t* payload = bytes + at;
+        at += detail::state_stream_align(block.size);
+
+        const StateLayout* layout = nullptr;
+        for (auto& l : layouts) {
+            if (l.interfaceUid == block.interface_uid) {
+                layout = &l;
+                break;
+            }
+        }
+        void* base = layout ? ps->get_property_state(layout->interfaceUid) : nullptr;
+        if (!base || layout->hash != block.layout_hash) {
+            result = ReturnValue::Fail;
+            continue;
+        }
+        ReturnValue loaded = ReturnValue::Fail;
+        if (block.encoding == StateEncoding::Blit) {
+            if (layout->trivial && block.size == layout->size) {
+                std::memcpy(base, payload, layout->size);
+                loaded = ReturnValue::Success;
+            }
+        } else if (block.encoding == StateEncoding::Members) {
+            loaded = detail::load_state_members(payload, block.size, *info, layout->interfaceUid, base);
+        }
+        if (loaded == ReturnValue::InvalidArgument) {
+            return loaded;
+        }
+        if (failed(loaded)) {
+            result = loaded;
+        }
+        if (meta) {
+            meta->notify(MemberKind::Property, layout->interfaceUid, Notification::Changed);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Creates an object of the class saved in @p data and loads its State structs.
+ * @return The object, or nullptr if the class is not registered or the buffer is malformed.
+ */
+inline IObject::Ptr load_object(const void* data, size_t size)
+{
+    StateStreamHeader header;
+    if (!data || size < sizeof(header)) {
+        return nullptr;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    auto object = interface_pointer_cast<IObject>(instance().create(header.class_uid));
+    if (!object || load_states(*object, data, size) == ReturnValue::InvalidArgument) {
+        return nullptr;
+    }
+    return object;
+}
+
+} // namespace velk
+
+#endif // VELK_API_SERIALIZE_H
@@ -35,12 +35,101 @@ detail::StateWriter<T> write_state(U* object)
     return meta ? meta->template write<T>() : detail::StateWriter<T>();
 }
 
+/**
+ * @brief Copies T::State into @p out without tearing, while another thread may be writing it.
+ *
+ * T must declare a SEQLOCK member. The copy is retried until no write started or finished
+ * during it, so @p out holds the State as left by one complete write. Writers must go
+ * through write_state(), property setters or COMPUTED accessors; writes through the raw
+ * get_property_state() pointer are not tracked.
+ *
+ * @tparam T The interface type whose State struct to read.
+ * @param object The object to read.
+ * @param out Receives the copy of the State.
+ * @return True if @p object has a T::State, false otherwise.
+ */
+template <class T, class U>
+bool read_state_consistent(const U* object, typename T::State& out)
+{
+    using State = typename T::State;
+    static_assert(detail::has_state_seqlock_v<State>, "read_state_consistent needs a (SEQLOCK) member in T");
+    static_assert(State::_velk_trivial_fields,
+                  "read_state_consistent needs trivially copyable State fields (no ARR or RARR members)");
+    auto* ps = interface_cast<IPropertyState>(object);
+    const State* state = ps ? ps->template get_property_state<T>() : nullptr;
+    if (!state) {
+        return false;
+    }
+    // Copies the bytes around the seqlock, which stays that of @p out.
+    auto* from = reinterpret_cast<const char*>(state);
+    auto* to = reinterpret_cast<char*>(&out);
+    size_t lockBegin = reinterpret_cast<const char*>(&state->_velk_seqlock) - from;
+    size_t lockEnd = lockBegin + sizeof(StateSeqlock);
+    uint32_t sequence;
+    do {
+        sequence = state->_velk_seqlock.read_begin();
+        StateSeqlock::load_bytes(to, from, lockBegin);
+        StateSeqlock::load_bytes(to + lockEnd, from + lockEnd, sizeof(State) - lockEnd);
+    } while (state->_velk_seqlock.read_retry(sequence));
+    return true;
+}
+
+namespace detail {
+
+/**
+ * @brief Runs @p fn on @p state within the write of its seqlock and marks its COMPUTED caches stale.
+ *
+ * For a State that read_state_consistent() can copy, @p fn edits a copy of the State and the
+ * bytes it changed are then stored with StateSeqlock::store_bytes(), so that the write does not
+ * race with the copy of a reader. Property writes nested in @p fn store into the State directly
+ * and are kept unless @p fn changed the same bytes.
+ */
+template <class State, class Fn>
+void write_state_locked(State* state, Fn& fn)
+{
+    StateWriteScope<State> scope(state);
+    if constexpr (has_state_seqlock_v<State> && State::_velk_trivial_fields) {
+        State before = *state;
+        State copy = before;
+        fn(copy);
+        invalidate_state_caches(&copy);
+        auto* old = reinterpret_cast<const char*>(&before);
+        auto* from = reinterpret_cast<const char*>(&copy);
+        auto* to = reinterpret_cast<char*>(state);
+        size_t lockBegin = reinterpret_cast<const char*>(&copy._velk_seqlock) - from;
+        size_t lockEnd = lockBegin + sizeof(StateSeqlock);
+        for (size_t i = 0; i < sizeof(State);) {
+            if (i == lockBegin) {
+                i = lockEnd;
+                continue;
+            }
+            size_t end = i;
+            while (end < sizeof(State) && end != lockBegin && from[end] != old[end]) {
+                ++end;
+            }
+            if (end != i) {
+                StateSeqlock::store_bytes(to + i, from + i, end - i);
+                i = end;
+            } else {
+                ++i;
+            }
+        }
+    } else {
+        fn(*state);
+        invalidate_state_caches(state);
+    }
+}
+
+} // namespace detail
+
 /**
  * @brief Writes to T::State via a callback, with optional deferral.
  *
  * When @p type is Immediate, the callback executes synchronously and on_changed fires when it returns.
  * When @p type is Deferred, the callback is queued and executed on the next update() call.
  * If the object is destroyed before update(), the queued callback is silently skipped.
+ * If T declares SEQLOCK, the callback edits a copy of the State that is stored back when it
+ * returns (see read_state_consistent()).
  *
  * @tparam T The interface type whose State struct to write.
  * @param object The object to modify.
@@ -55,8 +144,8 @@ void write_state(U* object, Fn&& fn, InvokeType type = Immediate)
     if (!state) {
         return;
     }
-    if (type == Immediate) {
-        fn(*state);
+    if (invoke_mode(type) == Immediate) {
+        detail::write_state_locked(state, fn);
         meta->notify(MemberKind::Property, T::UID, Notification::Changed);
         return;
     }
@@ -77,11 +166,12 @@ void write_state(U* object, Fn&& fn, InvokeType type = Immediate)
         if (!s) {
             return ReturnValue::Fail;
         }
-        f(*s);
+        detail::write_state_locked(s, f);
         m->notify(MemberKind::Property, T::UID, Notification::Changed);
         return ReturnValue::Success;
     });
     DeferredTask task{cb, {}};
+    task.priority = invoke_priority(type);
     instance().queue_deferred_tasks({&task, 1});
 }
 
@@ -20,6 +20,18 @@ T* get_or_load_plugin(Uid pluginId)
     return interface_cast<T>(reg.get_or_load_plugin(pluginId));
 }
 
+/**
+ * @brief Queues @p fn with a clone of @p args for the next update(), under ordering key @p key.
+ *
+ * Tasks with a nonzero key may run in parallel on the executor of the instance; tasks with
+ * the same key keep their queue order.
+ * @see DeferredTask::key, IVelk::set_executor
+ */
+inline void queue_deferred_task(const IFunction::ConstPtr& fn, FnArgs args, uint64_t key)
+{
+    instance().queue_deferred_call(fn, args, Deferred, key);
+}
+
 } // namespace velk
 
 #define _VELK_LOG_D ::velk::LogLevel::Debug
@@ -37,15 +49,23 @@ T* get_or_load_plugin(Uid pluginId)
  *
  * Accepts both short (D, I, W, E) and long (Debug, Info, Warning, Error)
  * level names. Messages below the current threshold are discarded without
- * formatting.
+ * evaluating the arguments or formatting, and messages below
+ * VELK_LOG_MIN_LEVEL are not compiled in at all.
  *
  * @code
  * VELK_LOG(W, "connection lost: %s", reason);
  * VELK_LOG(Debug, "tick %d", frame);
  * @endcode
  */
-#define VELK_LOG(level, fmt, ...) \
-    ::velk::detail::velk_log(     \
-        ::velk::instance().log(), _VELK_LOG_##level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+#define VELK_LOG(level, fmt, ...)                                                                    \
+    do {                                                                                             \
+        if constexpr (::velk::detail::log_compiled(_VELK_LOG_##level)) {                             \
+            auto& _velk_log = ::velk::instance().log();                                              \
+            if (_VELK_LOG_##level >= _velk_log.get_level()) {                                        \
+                ::velk::detail::velk_log(                                                            \
+                    _velk_log, _VELK_LOG_##level, __FILE__, __LINE__, fmt, ##__VA_ARGS__);           \
+            }                                                                                        \
+        }                                                                                            \
+    } while (0)
 
 #endif // VELK_API_VELK_H
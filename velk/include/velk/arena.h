@@ -0,0 +1,510 @@
+#ifndef VELK_ARENA_H
+#define VELK_ARENA_H
+
+#include <velk/allocator.h>
+#include <velk/string_view.h>
+#include <velk/vector.h>
+#include <velk/velk_export.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace velk {
+
+/**
+ * @brief Bump allocator for memory that lives until the next reset(), e.g. one update() cycle.
+ *
+ * Memory is carved from blocks of at least block_size bytes, allocated through the velk
+ * allocator with MemoryTag::Arena. reset() rewinds to the first block but keeps every block,
+ * so a steady workload stops allocating after its first cycles. Allocations are not
+ * constructed or destroyed by the arena. Not thread-safe.
+ */
+class Arena
+{
+    struct Block
+    {
+        Block* next;
+        size_t size; ///< Usable bytes after the header.
+    };
+
+public:
+    static constexpr size_t block_size = 16 * 1024;
+
+    /** @brief A position in the arena, see mark() and rewind(). */
+    struct Marker
+    {
+        Block* block{};
+        size_t offset{};
+    };
+
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /** @brief Move constructor. Takes the blocks of @p other. */
+    Arena(Arena&& other) noexcept { swap(other); }
+
+    /** @brief Move assignment. Frees the blocks of this arena and takes those of @p other. */
+    Arena& operator=(Arena&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+
+    /** @brief Destructor. Frees all blocks. */
+    ~Arena() { release(); }
+
+    /** @brief Returns @p size bytes aligned to @p alignment (at most alignof(std::max_align_t)). */
+    void* allocate(size_t size, size_t alignment)
+    {
+        assert(alignment <= alignof(std::max_align_t) && !(alignment & (alignment - 1)));
+        while (current_) {
+            size_t offset = (offset_ + alignment - 1) & ~(alignment - 1);
+            if (offset + size <= current_->size) {
+                offset_ = offset + size;
+                return data(current_) + offset;
+            }
+            if (!current_->next) {
+                break;
+            }
+            current_ = current_->next;
+            offset_ = 0;
+        }
+        return allocate_block(size);
+    }
+
+    /**
+     * @brief Grows the allocation @p ptr of @p size bytes to @p new_size bytes in place.
+     *
+     * Only the most recent allocation can grow, and only while its block has room.
+     * @return true if grown, false if @p ptr must be reallocated.
+     */
+    bool try_extend(void* ptr, size_t size, size_t new_size)
+    {
+        if (!current_ || static_cast<char*>(ptr) + size != data(current_) + offset_) {
+            return false;
+        }
+        size_t end = offset_ - size + new_size;
+        if (end > current_->size) {
+            return false;
+        }
+        offset_ = end;
+        return true;
+    }
+
+    /** @brief Makes all memory available again. Allocations must no longer be used. */
+    void reset()
+    {
+        current_ = first_;
+        offset_ = 0;
+    }
+
+    /** @brief Returns the current position, for rewind(). */
+    Marker mark() const { return {current_, offset_}; }
+
+    /**
+     * @brief Makes the memory allocated after @p marker available again.
+     *
+     * Allocations made since mark(), including a buffer that a container created earlier
+     * grew into, must no longer be used.
+     */
+    void rewind(Marker marker)
+    {
+        current_ = marker.block ? marker.block : first_;
+        offset_ = marker.block ? marker.offset : 0;
+    }
+
+    /** @brief Returns true if the arena holds no blocks. */
+    bool empty() const { return !first_; }
+
+    /** @brief Returns the total size of the blocks, used or not. */
+    size_t capacity() const
+    {
+        size_t total = 0;
+        for (auto* block = first_; block; block = block->next) {
+            total += block->size;
+        }
+        return total;
+    }
+
+    /** @brief Frees all blocks. Allocations must no longer be used. */
+    void release() noexcept
+    {
+        while (first_) {
+            auto* next = first_->next;
+            detail::velk_free(first_, alignof(std::max_align_t), MemoryTag::Arena);
+            first_ = next;
+        }
+        current_ = nullptr;
+        offset_ = 0;
+    }
+
+    void swap(Arena& other) noexcept
+    {
+        std::swap(first_, other.first_);
+        std::swap(current_, other.current_);
+        std::swap(offset_, other.offset_);
+    }
+
+private:
+    static constexpr size_t header_size =
+        (sizeof(Block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    static char* data(Block* block) { return reinterpret_cast<char*>(block) + header_size; }
+
+    /** @brief Appends a block that holds at least @p size bytes and allocates them from it. */
+    void* allocate_block(size_t size)
+    {
+        size_t usable = size > block_size ? size : block_size;
+        void* mem = detail::velk_alloc(header_size + usable, alignof(std::max_align_t), MemoryTag::Arena);
+        assert(mem && "velk::Arena allocation failed");
+        auto* block = new (mem) Block{nullptr, usable};
+        if (current_) {
+            current_->next = block;
+        } else {
+            first_ = block;
+        }
+        current_ = block;
+        offset_ = size;
+        return data(block);
+    }
+
+    Block* first_{};
+    Block* current_{}; ///< Block that allocations are carved from.
+    size_t offset_{};  ///< Offset of the first free byte in current_.
+};
+
+/**
+ * @brief Returns the frame arena of the calling thread.
+ *
+ * instance().update() resets the arena of the thread that calls it, so memory taken from it
+ * on that thread stays valid until the next update(). Other threads keep theirs until they
+ * reset it themselves or scope their allocations with ArenaScope.
+ *
+ * @return The arena, or null during static destruction.
+ */
+VELK_EXPORT Arena* frame_arena();
+
+/** @brief Rewinds an arena to where it was when the scope was entered. */
+class ArenaScope
+{
+public:
+    /** @brief Marks @p arena, or does nothing if it is null. */
+    explicit ArenaScope(Arena* arena = frame_arena()) : arena_(arena)
+    {
+        if (arena_) {
+            marker_ = arena_->mark();
+        }
+    }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    /** @brief Rewinds the arena, see Arena::rewind(). */
+    ~ArenaScope()
+    {
+        if (arena_) {
+            arena_->rewind(marker_);
+        }
+    }
+
+private:
+    Arena* arena_;
+    Arena::Marker marker_;
+};
+
+/**
+ * @brief Resizable array for temporary results, allocated from an Arena.
+ *
+ * Growth extends the buffer in place while it is the arena's latest allocation, otherwise it
+ * moves the elements to a new buffer and leaves the old one to the arena. Elements are
+ * destroyed with the vector, but its memory is only reclaimed when the arena is reset, so
+ * the vector must not outlive that. Without an arena, the buffer comes from the velk heap
+ * like a vector's.
+ *
+ * @tparam T The element type.
+ */
+template <class T>
+class arena_vector : private vector_base
+{
+    static_assert(alignof(T) <= alignof(std::max_align_t), "arena_vector does not support over-alignment");
+    static constexpr bool trivial = std::is_trivially_copyable_v<T>;
+
+public:
+    using value_type = T; ///< The element type.
+
+    /** @brief Constructs an empty vector allocating from the calling thread's frame_arena(). */
+    arena_vector() : arena_(frame_arena()) {}
+
+    /** @brief Constructs an empty vector allocating from @p arena, or the heap if null. */
+    explicit arena_vector(Arena* arena) : arena_(arena) {}
+
+    arena_vector(const arena_vector&) = delete;
+    arena_vector& operator=(const arena_vector&) = delete;
+
+    /** @brief Move constructor. Steals the buffer and arena of @p other. */
+    arena_vector(arena_vector&& other) noexcept : arena_(other.arena_) { steal_from(other); }
+
+    /** @brief Move assignment. */
+    arena_vector& operator=(arena_vector&& other) noexcept
+    {
+        if (this != &other) {
+            destroy_all();
+            release();
+            arena_ = other.arena_;
+            steal_from(other);
+        }
+        return *this;
+    }
+
+    /** @brief Destructor. Destroys all elements; heap buffers are freed. */
+    ~arena_vector()
+    {
+        destroy_all();
+        release();
+    }
+
+    /** @brief Returns the arena the vector allocates from, or null for the heap. */
+    Arena* arena() const { return arena_; }
+
+    /** @brief Returns a reference to the element at index @p i (unchecked). */
+    T& operator[](size_t i) { return typed_data()[i]; }
+    /** @brief Returns a const reference to the element at index @p i (unchecked). */
+    const T& operator[](size_t i) const { return typed_data()[i]; }
+
+    /** @brief Returns a reference to the first element. */
+    T& front() { return typed_data()[0]; }
+    /** @brief Returns a const reference to the first element. */
+    const T& front() const { return typed_data()[0]; }
+    /** @brief Returns a reference to the last element. */
+    T& back() { return typed_data()[size_ - 1]; }
+    /** @brief Returns a const reference to the last element. */
+    const T& back() const { return typed_data()[size_ - 1]; }
+
+    /** @brief Returns a pointer to the underlying data. */
+    T* data() { return typed_data(); }
+    /** @brief Returns a const pointer to the underlying data. */
+    const T* data() const { return typed_data(); }
+
+    /** @brief Returns an iterator to the first element. */
+    T* begin() { return typed_data(); }
+    /** @brief Returns a const iterator to the first element. */
+    const T* begin() const { return typed_data(); }
+    /** @brief Returns a past-the-end iterator. */
+    T* end() { return typed_data() + size_; }
+    /** @brief Returns a const past-the-end iterator. */
+    const T* end() const { return typed_data() + size_; }
+
+    /** @brief Returns true if the vector contains no elements. */
+    bool empty() const { return size_ == 0; }
+    /** @brief Returns the number of elements. */
+    size_t size() const { return size_; }
+    /** @brief Returns the number of elements that can be held without reallocation. */
+    size_t capacity() const { return capacity_; }
+
+    /** @brief Reserves storage for at least @p new_cap elements. */
+    void reserve(size_t new_cap)
+    {
+        if (new_cap > capacity_) {
+            grow_to(new_cap);
+        }
+    }
+
+    /** @brief Destroys all elements. Capacity is unchanged. */
+    void clear()
+    {
+        destroy_all();
+        size_ = 0;
+    }
+
+    /** @brief Appends a copy of @p value. Safe when @p value references this vector. */
+    void push_back(const T& value) { emplace_back(value); }
+
+    /** @brief Appends @p value by move. */
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    /** @brief Constructs an element in-place at the end. */
+    template <class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (size_ == capacity_) {
+            // The arguments may reference an element, so construct before growing.
+            T tmp(std::forward<Args>(args)...);
+            grow_to(size_ + 1);
+            return *new (typed_data() + size_++) T(std::move(tmp));
+        }
+        return *new (typed_data() + size_++) T(std::forward<Args>(args)...);
+    }
+
+    /** @brief Removes the last element. */
+    void pop_back()
+    {
+        assert(size_ > 0);
+        --size_;
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            typed_data()[size_].~T();
+        }
+    }
+
+    /** @brief Resizes the vector to @p count elements, value-initializing new ones. */
+    void resize(size_t count)
+    {
+        if (count < size_) {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                for (size_t i = count; i < size_; ++i) {
+                    typed_data()[i].~T();
+                }
+            }
+        } else if (count > size_) {
+            reserve(count);
+            for (size_t i = size_; i < count; ++i) {
+                new (typed_data() + i) T();
+            }
+        }
+        size_ = count;
+    }
+
+    /** @brief Returns a copy in a vector, e.g. to keep the elements beyond the arena's reset. */
+    vector<T> to_vector() const { return vector<T>(typed_data(), typed_data() + size_); }
+
+    /** @brief Implicit conversion to a read-only array_view. */
+    operator array_view<T>() const { return {typed_data(), size_}; }
+
+private:
+    T* typed_data() { return static_cast<T*>(data_); }
+    const T* typed_data() const { return static_cast<const T*>(data_); }
+
+    /** @brief Frees a heap buffer, leaves an arena buffer to the arena. Does not destroy elements. */
+    void release() noexcept
+    {
+        if (!arena_) {
+            free_buffer(data_);
+        }
+        data_ = nullptr;
+        capacity_ = 0;
+    }
+
+    void destroy_all()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = 0; i < size_; ++i) {
+                typed_data()[i].~T();
+            }
+        }
+    }
+
+    void grow_to(size_t required)
+    {
+        size_t new_cap = grow_capacity(capacity_, required);
+        void* dst;
+        if (arena_) {
+            if (data_ && arena_->try_extend(data_, capacity_ * sizeof(T), new_cap * sizeof(T))) {
+                capacity_ = new_cap;
+                return;
+            }
+            dst = arena_->allocate(new_cap * sizeof(T), alignof(T));
+        } else {
+            dst = alloc_raw(new_cap * sizeof(T));
+        }
+        if constexpr (trivial) {
+            if (size_) {
+                std::memcpy(dst, data_, size_ * sizeof(T));
+            }
+        } else {
+            for (size_t i = 0; i < size_; ++i) {
+                new (static_cast<T*>(dst) + i) T(std::move(typed_data()[i]));
+            }
+            destroy_all();
+        }
+        if (!arena_) {
+            free_buffer(data_);
+        }
+        data_ = dst;
+        capacity_ = new_cap;
+    }
+
+    Arena* arena_;
+};
+
+/**
+ * @brief Null-terminated string for temporary results, allocated from an Arena.
+ *
+ * The lifetime rules of arena_vector apply.
+ */
+class arena_string
+{
+public:
+    /** @brief Constructs an empty string allocating from the calling thread's frame_arena(). */
+    arena_string() = default;
+
+    /** @brief Constructs an empty string allocating from @p arena, or the heap if null. */
+    explicit arena_string(Arena* arena) : chars_(arena) {}
+
+    /** @brief Returns the arena the string allocates from, or null for the heap. */
+    Arena* arena() const { return chars_.arena(); }
+
+    /** @brief Returns a pointer to the characters. */
+    const char* data() const { return chars_.empty() ? "" : chars_.data(); }
+    /** @brief Returns a null-terminated C string. */
+    const char* c_str() const { return data(); }
+
+    /** @brief Returns true if the string is empty. */
+    bool empty() const { return size() == 0; }
+    /** @brief Returns the number of characters. */
+    size_t size() const { return chars_.empty() ? 0 : chars_.size() - 1; }
+
+    /** @brief Reserves storage for at least @p new_cap characters. */
+    void reserve(size_t new_cap) { chars_.reserve(new_cap + 1); }
+
+    /** @brief Clears the string. Capacity is unchanged. */
+    void clear() { chars_.clear(); }
+
+    /** @brief Appends a single character. */
+    void push_back(char ch) { append(string_view(&ch, 1)); }
+
+    /** @brief Appends a string_view. */
+    arena_string& append(string_view sv)
+    {
+        if (sv.empty()) {
+            return *this;
+        }
+        size_t s = size();
+        // New characters are zeroed, which also writes the terminator.
+        chars_.resize(s + sv.size() + 1);
+        std::memcpy(chars_.data() + s, sv.data(), sv.size());
+        return *this;
+    }
+
+    /** @brief Appends a string_view. */
+    arena_string& operator+=(string_view sv) { return append(sv); }
+    /** @brief Appends a single character. */
+    arena_string& operator+=(char ch)
+    {
+        push_back(ch);
+        return *this;
+    }
+
+    /** @brief Returns a read-only view of the characters. */
+    string_view view() const { return {data(), size()}; }
+    /** @brief Implicit conversion to a read-only string_view. */
+    operator string_view() const { return view(); }
+
+    /** @brief Equality comparison with a string_view. */
+    bool operator==(string_view sv) const { return view() == sv; }
+    /** @brief Inequality comparison with a string_view. */
+    bool operator!=(string_view sv) const { return view() != sv; }
+
+private:
+    arena_vector<char> chars_;
+};
+
+} // namespace velk
+
+#endif // VELK_ARENA_H
@@ -51,20 +51,18 @@ public:
 
     static ReturnValue copy_from(void* storage, const IAny& other, size_t elem_size, Uid type_uid)
     {
-        if (!is_compatible(other, type_uid)) {
-            return ReturnValue::Fail;
-        }
+        // get_data() fails if other does not hold type_uid, so there is no is_compatible() scan.
         alignas(8) char buf[sizeof(double)];
         if (elem_size <= sizeof(buf)) {
             return succeeded(other.get_data(buf, elem_size, type_uid)) ? set_value(storage, buf, elem_size)
                                                                        : ReturnValue::Fail;
         }
-        void* heap_buf = std::malloc(elem_size);
+        void* heap_buf = ::velk::detail::velk_alloc(elem_size, alignof(std::max_align_t), MemoryTag::General);
         ReturnValue ret = ReturnValue::Fail;
         if (heap_buf && succeeded(other.get_data(heap_buf, elem_size, type_uid))) {
             ret = set_value(storage, heap_buf, elem_size);
         }
-        std::free(heap_buf);
+        ::velk::detail::velk_free(heap_buf, alignof(std::max_align_t), MemoryTag::General);
         return ret;
     }
 };
@@ -257,13 +255,12 @@ public:
     {
         if constexpr (std::is_trivially_copyable_v<T>) {
             if constexpr (sizeof(T) <= sizeof(double)) {
-                // Small trivial: use the non-template base with stack buffer
+                // Small trivial: get_data() rejects other types, so one virtual call reads the
+                // value and set_value() of the known final class memcpys it into place.
                 alignas(T) char buf[sizeof(T)];
-                if (!is_compatible(other, TYPE_UID)) {
-                    return ReturnValue::Fail;
-                }
                 return succeeded(other.get_data(buf, sizeof(T), TYPE_UID))
-                           ? set_value(*reinterpret_cast<const T*>(buf))
+                           ? static_cast<FinalClass*>(this)->FinalClass::set_value(
+                                 *reinterpret_cast<const T*>(buf))
                            : ReturnValue::Fail;
             } else {
                 // Large trivial (e.g. vector<T>): delegate to base
@@ -291,11 +288,30 @@ private:
  * @brief A basic Any implementation with a single supported data type which is stored in local storage.
  */
 template <class T>
-class AnyValue final : public AnyCore<AnyValue<T>, T>
+class AnyValue final : public AnyCore<AnyValue<T>, T>,
+                       private ::velk::detail::TrackedMemory<AnyValue<T>, MemoryCategory::AnyValues>
 {
 public:
+    AnyValue() = default;
+    /** @brief Constructs an AnyValue<T> holding @p value, moved in. */
+    explicit AnyValue(T&& value) : data_(std::move(value)) {}
+
     const T& get_value() const override { return data_; }
 
+    /**
+     * @brief Creates a default-valued AnyValue<T>.
+     *
+     * Allocated on its own: the allocator's thread cache creates and releases an any faster than
+     * the object pool. Pass ObjectFlags::Pooled to IVelk::create() to take one from the pool.
+     */
+    static IAny::Ptr create() { return AnyValue::get_factory().template create_instance<IAny>(); }
+
+    IAny::Ptr clone() const override
+    {
+        auto c = create();
+        return c && succeeded(c->copy_from(*this)) ? c : nullptr;
+    }
+
 private:
     T data_{};
 };
@@ -322,7 +338,7 @@ public:
     /** @brief Clones as an owned AnyValue<T> (snapshot of the referenced data). */
     IAny::Ptr clone() const override
     {
-        auto c = AnyValue<T>::get_factory().template create_instance<IAny>();
+        auto c = AnyValue<T>::create();
         return c && succeeded(c->copy_from(*this)) ? c : nullptr;
     }
 
@@ -330,6 +346,66 @@ private:
     T* ptr_{};
 };
 
+/**
+ * @brief A read-only any over a value owned by the caller, for building FnArgs on the stack.
+ *
+ * Unlike AnyValue and AnyRef it has no control block and is not reference counted: ref() and
+ * unref() do nothing and get_self() returns null, so constructing one costs no allocation. The
+ * viewed value must outlive the any, and the any must not be wrapped in a shared_ptr. Callees
+ * that keep an argument, such as a Deferred invoke, clone() it into an owned AnyValue<T>.
+ */
+template <class T>
+class AnyArg final : public InterfaceDispatch<IAny>
+{
+public:
+    static constexpr Uid TYPE_UID = type_uid<T>();
+
+    explicit AnyArg(const T& value) noexcept : value_(value) {}
+
+    AnyArg(const AnyArg&) = delete;
+    AnyArg& operator=(const AnyArg&) = delete;
+
+    /** @brief Returns the viewed value. */
+    const T& get_value() const noexcept { return value_; }
+
+public: // IObject
+    Uid get_class_uid() const override { return TYPE_UID; }
+    string_view get_class_name() const override { return ::velk::get_name<AnyArg>(); }
+    IObject::Ptr get_self() const override { return nullptr; }
+    uint32_t get_object_flags() const override { return ObjectFlags::None; }
+
+public: // IAny
+    array_view<Uid> get_compatible_types() const override
+    {
+        static constexpr Uid uid = TYPE_UID;
+        return {&uid, 1};
+    }
+    size_t get_data_size(Uid type) const override { return type == TYPE_UID ? sizeof(T) : 0; }
+    ReturnValue get_data(void* to, size_t toSize, Uid type) const override
+    {
+        if (!to || type != TYPE_UID || toSize != sizeof(T)) {
+            return ReturnValue::Fail;
+        }
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            std::memcpy(to, &value_, sizeof(T));
+        } else {
+            *static_cast<T*>(to) = value_;
+        }
+        return ReturnValue::Success;
+    }
+    ReturnValue set_data(void const*, size_t, Uid) override { return ReturnValue::ReadOnly; }
+    ReturnValue copy_from(const IAny&) override { return ReturnValue::ReadOnly; }
+    /** @brief Clones as an owned AnyValue<T>. */
+    IAny::Ptr clone() const override
+    {
+        auto c = AnyValue<T>::create();
+        return c && succeeded(c->copy_from(*this)) ? c : nullptr;
+    }
+
+private:
+    const T& value_;
+};
+
 /**
  * @brief CRTP base for ArrayAnyRef/ArrayAnyValue, implementing all IAny and IArrayAny methods.
  *
@@ -342,6 +418,9 @@ private:
  * @tparam Derived The CRTP derived class (ArrayAnyRef<T> or ArrayAnyValue<T>).
  * @tparam T The element type of the vector.
  */
+template <class T>
+class ArrayAnyValue;
+
 template <class Derived, class T>
 class ArrayAnyCore : public AnyBase<Derived, IArrayAny>
 {
@@ -478,6 +557,91 @@ public:
         }
     }
 
+    ReturnValue set_range(size_t index, const void* data, size_t count, Uid elementType) override
+    {
+        auto& vec = this->vec();
+        if (elementType != elem_uid_ || index > vec.size() || count > vec.size() - index) {
+            return ReturnValue::InvalidArgument;
+        }
+        auto* elems = static_cast<const T*>(data);
+        T* dst = vec.data() + index;
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (count == 0 || std::memcmp(dst, elems, count * sizeof(T)) == 0) {
+                return ReturnValue::NothingToDo;
+            }
+            std::memmove(dst, elems, count * sizeof(T));
+            return ReturnValue::Success;
+        } else {
+            bool changed = false;
+            for (size_t i = 0; i < count; ++i) {
+                if (!(dst[i] == elems[i])) {
+                    dst[i] = elems[i];
+                    changed = true;
+                }
+            }
+            return changed ? ReturnValue::Success : ReturnValue::NothingToDo;
+        }
+    }
+
+    ReturnValue insert_range(size_t index, const void* data, size_t count, Uid elementType) override
+    {
+        auto& vec = this->vec();
+        if (elementType != elem_uid_ || index > vec.size()) {
+            return ReturnValue::InvalidArgument;
+        }
+        if (count == 0) {
+            return ReturnValue::NothingToDo;
+        }
+        auto* elems = static_cast<const T*>(data);
+        vec.insert(vec.begin() + index, elems, elems + count);
+        return ReturnValue::Success;
+    }
+
+    ReturnValue erase_range(size_t index, size_t count) override
+    {
+        auto& vec = this->vec();
+        if (index > vec.size() || count > vec.size() - index) {
+            return ReturnValue::InvalidArgument;
+        }
+        if (count == 0) {
+            return ReturnValue::NothingToDo;
+        }
+        vec.erase(vec.begin() + index, vec.begin() + index + count);
+        return ReturnValue::Success;
+    }
+
+    ReturnValue resize_array(size_t count) override
+    {
+        auto& vec = this->vec();
+        if (count == vec.size()) {
+            return ReturnValue::NothingToDo;
+        }
+        vec.resize(count);
+        return ReturnValue::Success;
+    }
+
+    const void* array_data(Uid elementType) const override
+    {
+        return elementType == elem_uid_ ? vec().data() : nullptr;
+    }
+
+    size_t array_element_size(Uid elementType) const override
+    {
+        return elementType == elem_uid_ ? elem_size_ : 0;
+    }
+
+    IAny::Ptr create_array(const void* data, size_t count, Uid elementType) const override
+    {
+        if (elementType != elem_uid_) {
+            return nullptr;
+        }
+        auto array = ArrayAnyValue<T>::get_factory().template create_instance<IArrayAny>();
+        if (!array || (count && failed(array->set_from_buffer(data, count, elementType)))) {
+            return nullptr;
+        }
+        return array;
+    }
+
 private:
     static bool is_valid_args(const void* from, size_t fromSize, Uid type) noexcept
     {
@@ -504,7 +668,7 @@ public:
 
     IAny::Ptr clone() const override
     {
-        auto c = AnyValue<vec_type>::get_factory().template create_instance<IAny>();
+        auto c = AnyValue<vec_type>::create();
         return c && succeeded(c->copy_from(*this)) ? c : nullptr;
     }
 
@@ -523,7 +687,8 @@ private:
  * @tparam T The element type of the vector.
  */
 template <class T>
-class ArrayAnyValue final : public ArrayAnyCore<ArrayAnyValue<T>, T>
+class ArrayAnyValue final : public ArrayAnyCore<ArrayAnyValue<T>, T>,
+                            private ::velk::detail::TrackedMemory<ArrayAnyValue<T>, MemoryCategory::AnyValues>
 {
     using vec_type = vector<T>;
     friend class ArrayAnyCore<ArrayAnyValue<T>, T>;
@@ -531,6 +696,7 @@ class ArrayAnyValue final : public ArrayAnyCore<ArrayAnyValue<T>, T>
 public:
     ArrayAnyValue() = default;
     explicit ArrayAnyValue(const vec_type& value) : data_(value) {}
+    explicit ArrayAnyValue(vec_type&& value) : data_(std::move(value)) {}
 
 private:
     vec_type& vec() { return data_; }
@@ -555,6 +721,26 @@ IAny::Ptr create_any_ref(T* ptr)
     return IAny::Ptr(static_cast<IAny*>(obj));
 }
 
+/** @brief Creates an owned AnyValue<T> holding @p value, moved in instead of copied. */
+template <class T, std::enable_if_t<!std::is_reference_v<T>, int> = 0>
+IAny::Ptr create_any_value(T&& value)
+{
+    auto* obj = new AnyValue<T>(std::move(value));
+    return IAny::Ptr(static_cast<IAny*>(obj));
+}
+
+/**
+ * @brief Creates an owned ArrayAnyValue<T> holding @p value, moved in instead of copied.
+ *
+ * Like the vector anys of instance().create_any(), the result also implements IArrayAny.
+ */
+template <class T>
+IAny::Ptr create_any_value(vector<T>&& value)
+{
+    auto* obj = new ArrayAnyValue<T>(std::move(value));
+    return IAny::Ptr(static_cast<IAny*>(obj));
+}
+
 } // namespace velk::ext
 
 #endif // ANY_H
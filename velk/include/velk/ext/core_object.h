@@ -21,6 +21,15 @@ inline IObject::Ptr make_self_ptr(control_block* block)
                : nullptr;
 }
 
+/**
+ * @brief Creates @p count instances of the class of @p factory in one allocation with embedded
+ *        control blocks. Implements IObjectFactory::create_instances().
+ *
+ * ObjectFlags::ThreadConfined instances are created one by one with create_instance().
+ */
+VELK_EXPORT size_t create_object_batch(const IObjectFactory& factory, size_t count, uint32_t flags,
+                                       IObject::Ptr* out);
+
 } // namespace velk::detail
 
 namespace velk::ext {
@@ -35,6 +44,9 @@ IObject::Ptr make_object(uint32_t flags = ObjectFlags::None)
     IObject::Ptr result(static_cast<IObject*>(static_cast<void*>(obj)), block, adopt_ref);
     if (block && !block->get_ptr()) {
         block->set_ptr(result.get());
+        if (flags & ObjectFlags::ThreadConfined) {
+            detail::BlockAccess::confine(*obj);
+        }
     }
     return result;
 }
@@ -82,6 +94,10 @@ public:
     {
         static_cast<FinalClass*>(location)->~FinalClass();
     }
+    size_t create_instances(size_t count, uint32_t flags, IObject::Ptr* out) const override
+    {
+        return detail::create_object_batch(*this, count, flags, out);
+    }
 };
 
 /**
@@ -109,6 +125,15 @@ class DefaultFactory : public ObjectFactory<FinalClass>
         str                                \
     }
 
+/**
+ * @brief Makes a class reuse the memory of its destroyed instances.
+ *
+ * Each thread keeps the memory of up to @p capacity destroyed instances per 16-byte size bucket
+ * and constructs new instances in it, instead of going to the allocator. Classes of the same
+ * size bucket share a thread's memory. IVelk::trim_recycled_objects() frees what is kept.
+ */
+#define VELK_RECYCLE_INSTANCES(capacity) static constexpr uint32_t recycle_capacity = capacity
+
 // IObject detection: walks ParentInterface chains to check if IObject is already reachable.
 
 /** @brief Selects the RefCountedDispatch base, prepending IObject only if not already reachable. */
@@ -138,10 +163,44 @@ template <class FinalClass, class... Interfaces>
 class ObjectCore
     : public ObjectCoreBase<(detail::has_iobject_in_chain<Interfaces>() || ...), Interfaces...>::type
 {
+    using Dispatch =
+        typename ObjectCoreBase<(detail::has_iobject_in_chain<Interfaces>() || ...), Interfaces...>::type;
+
 public:
     ObjectCore() = default;
     ~ObjectCore() override = default;
 
+    /** @brief Allocates an instance, in recycled memory if FinalClass has VELK_RECYCLE_INSTANCES(). */
+    static void* operator new(size_t size)
+    {
+        if constexpr (detail::has_recycle_capacity<FinalClass>::value) {
+            void* ptr = detail::recycle_alloc(size);
+            assert(ptr && "velk object allocation failed");
+            return ptr;
+        } else {
+            return Dispatch::operator new(size);
+        }
+    }
+    static void* operator new(size_t size, std::align_val_t alignment)
+    {
+        return Dispatch::operator new(size, alignment);
+    }
+    static void* operator new(size_t, void* where) noexcept { return where; }
+    /** @brief Frees an instance, keeping its memory for reuse if FinalClass has VELK_RECYCLE_INSTANCES(). */
+    static void operator delete(void* ptr, size_t size) noexcept
+    {
+        if constexpr (detail::has_recycle_capacity<FinalClass>::value) {
+            detail::recycle_free(ptr, size, FinalClass::recycle_capacity);
+        } else {
+            Dispatch::operator delete(ptr);
+        }
+    }
+    static void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept
+    {
+        Dispatch::operator delete(ptr, alignment);
+    }
+    static void operator delete(void*, void*) noexcept {}
+
 public:
     /** @brief Returns the compile-time class name of FinalClass. */
     static constexpr string_view class_name() noexcept { return ::velk::get_name<FinalClass>(); }
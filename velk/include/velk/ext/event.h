@@ -2,6 +2,7 @@
 #define VELK_EXT_EVENT_H
 
 #include <velk/api/velk.h>
+#include <velk/ext/core_object.h>
 #include <velk/interface/intf_event.h>
 #include <velk/interface/types.h>
 
@@ -26,6 +27,56 @@ public:
         }
         return event_;
     }
+
+    /**
+     * @brief Returns the event if it has been created, without creating it.
+     *
+     * An event that was never accessed has no handlers, so firing code can use
+     * this to skip creating an event only to invoke it with nobody listening.
+     */
+    const IEvent::Ptr& get_if_created() const { return event_; }
+};
+
+/**
+ * @brief Base class for IEventBatchHandler implementations.
+ *
+ * Implements IFunction::invoke() as a batch of one entry without a source, so
+ * FinalClass only has to implement handle_batch().
+ *
+ * @code
+ * class DirtyTracker : public ext::EventBatchHandler<DirtyTracker>
+ * {
+ * public:
+ *     void handle_batch(array_view<EventBatchEntry> batch) const override
+ *     {
+ *         for (auto& entry : batch) { ... }
+ *     }
+ * };
+ *
+ * auto tracker = ext::make_object<DirtyTracker, IEventBatchHandler>();
+ * prop.on_changed()->add_handler(tracker, Deferred);
+ * @endcode
+ */
+template <class FinalClass>
+class EventBatchHandler : public ObjectCore<FinalClass, IEventBatchHandler>
+{
+public:
+    IAny::Ptr invoke(FnArgs args, InvokeType type = Immediate) const override
+    {
+        if (invoke_mode(type) != Immediate) {
+            instance().queue_deferred_call(this->template get_self<IFunction>(), args, type);
+            return nullptr;
+        }
+        EventBatchEntry entry{nullptr, args};
+        this->handle_batch({&entry, 1});
+        return nullptr;
+    }
+    bool invoke_typed(IFunction::TypedFn*, const void* const*, void*) const override { return false; }
+    ReturnValue invoke_into(FnArgs args, IAny&) const override
+    {
+        invoke(args);
+        return ReturnValue::NothingToDo;
+    }
 };
 
 } // namespace velk::ext
@@ -14,8 +14,9 @@ namespace velk::ext {
  *
  * Inherits all Interfaces and dispatches get_interface queries by UID.
  * At compile time, builds a flat table of all reachable interfaces (including parents)
- * with corresponding cast function pointers. At runtime, get_interface() is a simple
- * linear scan of this table.
+ * with corresponding cast function pointers, plus a copy laid out by a perfect hash of
+ * the UIDs. At runtime, get_interface() scans tiny tables linearly and otherwise looks
+ * up a single slot of the hashed table.
  *
  * ref and unref are no-ops; override them in a derived class (e.g.
  * RefCountedDispatch) to add lifetime management.
@@ -127,23 +128,110 @@ private:
 
     /** @brief The compile-time interface dispatch table. */
     static constexpr InterfaceListData class_interface_data_ = make_interface_list();
+    static constexpr size_t interface_count_ = class_interface_data_.count;
+
+    /** @brief Upper bound of the hashed table size: 32 slots per interface. */
+    static constexpr size_t max_hash_size_ = InterfaceListData::interface_list_size_ * 32;
+
+    /** @brief Parameters of the perfect hash from UID to slot of the hashed dispatch table. */
+    struct HashLayout
+    {
+        uint32_t bits{};       ///< log2 of the slot count.
+        uint64_t multiplier{}; ///< Odd multiplier mixing the UID into a slot index, 0 if none found.
+    };
+
+    /** @brief Returns the slot of @p uid in a hashed table with @p layout. */
+    static constexpr size_t hash_slot(Uid uid, HashLayout layout)
+    {
+        auto mixed = (uid.hi ^ uid.lo) * layout.multiplier;
+        return layout.bits ? static_cast<size_t>(mixed >> (64 - layout.bits)) : 0;
+    }
+
+    /**
+     * @brief Finds the smallest table with a multiplier that sends every UID to its own slot.
+     *
+     * Starts at twice the interface count, rounded up to a power of two, and tries a
+     * sequence of odd multipliers before doubling the size. With fewer than one UID per 8
+     * slots a perfect multiplier is found within a few attempts, well below max_hash_size_.
+     */
+    static constexpr HashLayout make_hash_layout()
+    {
+        uint32_t bits = 0;
+        while ((size_t{1} << bits) < 2 * interface_count_) {
+            ++bits;
+        }
+        for (; (size_t{1} << bits) <= max_hash_size_; ++bits) {
+            uint64_t multiplier = 0x9e3779b97f4a7c15ull;
+            for (int attempt = 0; attempt < 256; ++attempt) {
+                HashLayout layout{bits, multiplier};
+                bool taken[max_hash_size_]{};
+                bool unique = true;
+                for (size_t i = 0; i < interface_count_ && unique; ++i) {
+                    auto slot = hash_slot(class_interface_data_.entries[i].uid, layout);
+                    unique = !taken[slot];
+                    taken[slot] = true;
+                }
+                if (unique) {
+                    return layout;
+                }
+                multiplier = (multiplier * 6364136223846793005ull + 1442695040888963407ull) | 1;
+            }
+        }
+        return {};
+    }
+
+    static constexpr HashLayout hash_layout_ = make_hash_layout();
+    static_assert(hash_layout_.multiplier != 0, "No perfect hash found for the interface UIDs");
+    static constexpr size_t hash_size_ = size_t{1} << hash_layout_.bits;
+
+    /** @brief The dispatch table laid out by hash_slot(); unused slots hold a null UID. */
+    struct HashedInterfaceData
+    {
+        Uid uids[hash_size_]{};
+        CastFn casts[hash_size_]{};
+    };
+
+    static constexpr HashedInterfaceData make_hashed_list()
+    {
+        HashedInterfaceData hashed{};
+        for (size_t i = 0; i < interface_count_; ++i) {
+            auto slot = hash_slot(class_interface_data_.entries[i].uid, hash_layout_);
+            hashed.uids[slot] = class_interface_data_.entries[i].uid;
+            hashed.casts[slot] = class_interface_data_.casts[i];
+        }
+        return hashed;
+    }
+
+    static constexpr HashedInterfaceData hashed_interface_data_ = make_hashed_list();
+
+    /** @brief Table size up to which a linear scan beats hashing. */
+    static constexpr size_t linear_scan_limit_ = 2;
 
 public:
     /**
      * @brief Resolves a UID to the corresponding interface pointer.
      *
      * For IInterface::UID, returns this (every object implements IInterface).
-     * For all other UIDs, scans the flat interface table and invokes the
-     * matching cast function, or returns nullptr if not found.
+     * For all other UIDs, looks up the interface table and invokes the matching
+     * cast function, or returns nullptr if not found.
      */
     IInterface* get_interface(Uid uid) override
     {
         if (uid == IInterface::UID) {
             return static_cast<IInterface*>(static_cast<void*>(this));
         }
-        for (size_t i = 0; i < class_interface_data_.count; ++i) {
-            if (class_interface_data_.entries[i].uid == uid) {
-                return class_interface_data_.casts[i](this);
+        if constexpr (interface_count_ <= linear_scan_limit_) {
+            for (size_t i = 0; i < interface_count_; ++i) {
+                if (class_interface_data_.entries[i].uid == uid) {
+                    return class_interface_data_.casts[i](this);
+                }
+            }
+        } else {
+            auto slot = hash_slot(uid, hash_layout_);
+            // A UID that is not in the table may land on any slot; the compare rejects it.
+            // Empty slots hold the null UID, which is IInterface::UID and handled above.
+            if (hashed_interface_data_.uids[slot] == uid) {
+                return hashed_interface_data_.casts[slot](this);
             }
         }
         return nullptr;
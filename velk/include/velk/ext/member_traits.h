@@ -45,6 +45,14 @@ template <class T>
 struct has_plugin_deps<T, std::void_t<decltype(T::plugin_deps)>> : std::true_type
 {};
 
+/** @brief Check if class has 'recycle_capacity' member. */
+template <class T, class = void>
+struct has_recycle_capacity : std::false_type
+{};
+template <class T>
+struct has_recycle_capacity<T, std::void_t<decltype(T::recycle_capacity)>> : std::true_type
+{};
+
 } // namespace velk::detail
 
 #endif // VELK_EXT_MEMBER_TRAITS_H
@@ -5,6 +5,7 @@
 #include <velk/interface/intf_metadata.h>
 #include <velk/interface/types.h>
 
+#include <array>
 #include <type_traits>
 
 namespace velk::ext {
@@ -58,6 +59,143 @@ struct CollectedMetadata<First, Rest...>
         concat_arrays(TypeMetadata<First>::value, CollectedMetadata<Rest...>::value);
 };
 
+/** @brief Gets T::computed_count if it exists, otherwise 0. */
+template <class T, class = void>
+struct TypeComputedCount
+{
+    static constexpr size_t value = 0;
+};
+
+/** @brief Specialization that extracts T::computed_count when it exists. */
+template <class T>
+struct TypeComputedCount<T, std::void_t<decltype(T::computed_count)>>
+{
+    static constexpr size_t value = T::computed_count;
+};
+
+// Perfect hash table of member names
+
+/** @brief Returns the number of buckets and slots of the MemberTable of @p n members. */
+constexpr size_t member_table_size(size_t n)
+{
+    size_t size = 1;
+    while (size < n) {
+        size *= 2;
+    }
+    return size;
+}
+
+/**
+ * @brief Storage of a MemberTable for @p N members, built at compile time.
+ * @tparam N The number of members.
+ */
+template <size_t N>
+struct MemberTableData
+{
+    static constexpr size_t Size = member_table_size(N); ///< Number of buckets and slots.
+
+    std::array<int32_t, Size> seeds{};
+    std::array<uint16_t, Size> slots{};
+    std::array<uint64_t, N> keys{};
+    bool ok{}; ///< False if no perfect hash was found; the members must then be searched.
+
+    /** @brief Returns the MemberTable view of this data. Only valid if @c ok is true. */
+    constexpr MemberTable table() const
+    {
+        return {seeds.data(), slots.data(), keys.data(), static_cast<uint32_t>(Size - 1)};
+    }
+};
+
+/**
+ * @brief Builds the perfect hash table of @p members (hash and displace).
+ *
+ * Keys are grouped into buckets by their seed 0 hash. Buckets are placed largest first,
+ * each with the first seed that sends its keys to free, distinct slots. Single-key buckets
+ * take the remaining free slots directly. A member whose name and kind repeat an earlier
+ * member is left out, so lookups find the first one, as a linear search would.
+ */
+template <size_t N>
+constexpr MemberTableData<N> make_member_table(const std::array<MemberDesc, N>& members)
+{
+    using Data = MemberTableData<N>;
+    constexpr size_t Size = Data::Size;
+    constexpr uint32_t Mask = static_cast<uint32_t>(Size - 1);
+    constexpr uint32_t MaxSeed = 1u << 16;
+    Data data{};
+    std::array<bool, N> used{};
+    std::array<size_t, Size> count{};
+    for (auto& slot : data.slots) {
+        slot = MemberTable::Empty;
+    }
+    if (N >= MemberTable::Empty) {
+        return data;
+    }
+    for (size_t i = 0; i < N; ++i) {
+        auto key = member_key(MemberId(members[i].name), members[i].kind);
+        data.keys[i] = key;
+        used[i] = true;
+        for (size_t j = 0; j < i; ++j) {
+            if (used[j] && data.keys[j] == key) {
+                used[i] = false;
+            }
+        }
+        if (used[i]) {
+            ++count[MemberTable::hash(key, 0) & Mask];
+        }
+    }
+    std::array<bool, Size> placed{};
+    for (;;) {
+        // The largest bucket not yet placed.
+        size_t bucket = Size;
+        for (size_t b = 0; b < Size; ++b) {
+            if (!placed[b] && count[b] > 1 && (bucket == Size || count[b] > count[bucket])) {
+                bucket = b;
+            }
+        }
+        if (bucket == Size) {
+            break;
+        }
+        placed[bucket] = true;
+        uint32_t seed = 1;
+        for (; seed < MaxSeed; ++seed) {
+            std::array<bool, Size> taken{};
+            bool fits = true;
+            for (size_t i = 0; i < N && fits; ++i) {
+                if (used[i] && (MemberTable::hash(data.keys[i], 0) & Mask) == bucket) {
+                    auto slot = MemberTable::hash(data.keys[i], seed) & Mask;
+                    fits = data.slots[slot] == MemberTable::Empty && !taken[slot];
+                    taken[slot] = true;
+                }
+            }
+            if (fits) {
+                break;
+            }
+        }
+        if (seed == MaxSeed) {
+            return data;
+        }
+        data.seeds[bucket] = static_cast<int32_t>(seed);
+        for (size_t i = 0; i < N; ++i) {
+            if (used[i] && (MemberTable::hash(data.keys[i], 0) & Mask) == bucket) {
+                data.slots[MemberTable::hash(data.keys[i], seed) & Mask] = static_cast<uint16_t>(i);
+            }
+        }
+    }
+    size_t free = 0;
+    for (size_t i = 0; i < N; ++i) {
+        auto bucket = MemberTable::hash(data.keys[i], 0) & Mask;
+        if (used[i] && count[bucket] == 1) {
+            while (data.slots[free] != MemberTable::Empty) {
+                ++free;
+            }
+            data.slots[free] = static_cast<uint16_t>(i);
+            data.seeds[bucket] = -static_cast<int32_t>(free) - 1;
+        }
+    }
+    data.ok = true;
+    return data;
+}
+
 // State struct extraction from interfaces
 
 /** @brief Extracts T::State if it exists, otherwise provides an empty struct. */
@@ -75,6 +213,39 @@ struct InterfaceState<T, std::void_t<typename T::State>>
     using type = typename T::State;
 };
 
+/** @brief True if T declares a State struct. */
+template <class T, class = void>
+struct has_interface_state : std::false_type
+{};
+
+template <class T>
+struct has_interface_state<T, std::void_t<typename T::State>> : std::true_type
+{};
+
+template <class T>
+inline constexpr bool has_interface_state_v = has_interface_state<T>::value;
+
+/** @brief Appends the StateLayout of T to @p layouts if T declares a State. */
+template <class T, size_t N>
+constexpr void append_state_layout(std::array<StateLayout, N>& layouts, size_t& i)
+{
+    if constexpr (has_interface_state_v<T>) {
+        using State = typename T::State;
+        layouts[i++] = StateLayout{
+            T::UID, sizeof(State), alignof(State), T::state_layout_hash, std::is_trivially_copyable_v<State>};
+    }
+}
+
+/** @brief Builds the StateLayout entries of every interface in Interfaces that declares a State. */
+template <class... Interfaces>
+constexpr auto make_state_layouts()
+{
+    std::array<StateLayout, (size_t{0} + ... + (has_interface_state_v<Interfaces> ? 1 : 0))> layouts{};
+    size_t i = 0;
+    (append_state_layout<Interfaces>(layouts, i), ...);
+    return layouts;
+}
+
 } // namespace velk::ext
 
 #endif // VELK_EXT_METADATA_H
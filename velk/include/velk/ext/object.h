@@ -11,6 +11,28 @@
 
 namespace velk::detail {
 
+/**
+ * @brief Returns the hive state column entry of a hive-managed object, or nullptr.
+ *
+ * Resolves the entry through the object's embedded hive control block. Only valid for
+ * objects constructed with ObjectFlags::StateColumn.
+ *
+ * @param block The object's control block.
+ * @param interfaceUid UID of the interface whose State to look up.
+ */
+VELK_EXPORT void* hive_state_column(const control_block* block, Uid interfaceUid);
+
+/**
+ * @brief Marks a hive-managed object dirty for @p interfaceUid (see IObjectHive::add_dirty_tracking()).
+ *
+ * Only valid for objects constructed with ObjectFlags::DirtyTracking. Does nothing if the
+ * hive does not track the interface.
+ *
+ * @param block The object's control block.
+ * @param interfaceUid UID of the interface whose State changed.
+ */
+VELK_EXPORT void hive_mark_dirty(const control_block* block, Uid interfaceUid);
+
 /**
  * @brief Non-template base holding IObjectStorage pointer and delegation helpers.
  *
@@ -47,6 +69,18 @@ protected:
     {
         return storage_ ? storage_->get_function(name, mode) : nullptr;
     }
+    IInterface::Ptr storage_get_member(MemberId id, MemberKind kind, Resolve mode = Resolve::Create) const
+    {
+        return storage_ ? storage_->get_member(id, kind, mode) : nullptr;
+    }
+    IInterface::Ptr storage_get_member_at(size_t index, Resolve mode = Resolve::Create) const
+    {
+        return storage_ ? storage_->get_member_at(index, mode) : nullptr;
+    }
+    size_t storage_materialize_all(uint32_t kinds) const
+    {
+        return storage_ ? storage_->materialize_all(kinds) : 0;
+    }
     void storage_notify(MemberKind kind, Uid interfaceUid, Notification notification) const
     {
         if (storage_) {
@@ -71,41 +105,75 @@ protected:
     {
         return storage_ ? storage_->find_attachment(query, mode) : nullptr;
     }
+    ReturnValue storage_freeze() const { return storage_ ? storage_->freeze() : ReturnValue::Fail; }
+    borrowed_ptr<IInterface> storage_borrow_member(MemberId id, MemberKind kind) const
+    {
+        return storage_ ? storage_->borrow_member(id, kind) : nullptr;
+    }
 
     mutable IObjectStorage* storage_{};
 };
 
+/**
+ * @brief ObjectStorageBase that constructs the ObjectStorage inside the object.
+ *
+ * Reserves OBJECT_STORAGE_SIZE bytes in the object, so creating the storage takes no lock
+ * and the storage shares the object's cache lines. The storage is still created on first
+ * runtime metadata/attachment access.
+ */
+class EmbeddedObjectStorageBase : protected ObjectStorageBase
+{
+protected:
+    ~EmbeddedObjectStorageBase()
+    {
+        if (storage_) {
+            instance().destruct_metadata_container(storage_);
+            storage_ = nullptr;
+        }
+    }
+
+    void ensure_storage(const ClassInfo& info, IInterface* owner) const
+    {
+        if (!storage_) {
+            storage_ = instance().construct_metadata_container(embedded_, info, owner);
+        }
+    }
+
+private:
+    alignas(OBJECT_STORAGE_ALIGNMENT) mutable unsigned char embedded_[OBJECT_STORAGE_SIZE];
+};
+
 } // namespace velk::detail
 
 namespace velk::ext {
 
 /**
- * @brief CRTP base for Velk objects with metadata and object storage.
- *
- * Extends ObjectCore with IObjectStorage support. Metadata is automatically collected
- * from all Interfaces that declare metadata through VELK_INTERFACE. Attachments can be
- * added/removed at runtime via the IObjectStorage interface.
- * The ObjectStorage is created lazily on first runtime metadata/attachment access.
+ * @brief Implementation of Object and ObservedObject, which differ in where the storage lives.
  *
  * @tparam FinalClass The final derived class (CRTP parameter).
+ * @tparam StorageBase detail::ObjectStorageBase or detail::EmbeddedObjectStorageBase.
  * @tparam Interfaces Additional interfaces the object implements.
  */
-template <class FinalClass, class... Interfaces>
-class Object : public ObjectCore<FinalClass, IObjectStorage, Interfaces...>,
-               protected detail::ObjectStorageBase
+template <class FinalClass, class StorageBase, class... Interfaces>
+class ObjectBase : public ObjectCore<FinalClass, IObjectStorage, Interfaces...>, protected StorageBase
 {
 public:
     /** @brief Compile-time collected metadata from all Interfaces. */
     static constexpr auto metadata = CollectedMetadata<Interfaces...>::value;
     static constexpr array_view<MemberDesc> class_metadata{metadata.data(), metadata.size()};
+    /** @brief Compile-time perfect hash of class_metadata by member name and kind. */
+    static constexpr auto member_table_data = make_member_table(metadata);
+    static constexpr MemberTable member_table = member_table_data.table();
+    /** @brief Number of COMPUTED members declared by all Interfaces. */
+    static constexpr size_t computed_count = (size_t{0} + ... + TypeComputedCount<Interfaces>::value);
 
-    Object() = default;
-    ~Object() override = default;
+    ObjectBase() = default;
+    ~ObjectBase() override = default;
 
 private:
     void ensure_stor() const
     {
-        ensure_storage(
+        this->ensure_storage(
             FinalClass::get_factory().get_class_info(),
             static_cast<IInterface*>(const_cast<IObjectStorage*>(static_cast<const IObjectStorage*>(this))));
     }
@@ -114,60 +182,131 @@ public: // IMetadata overrides
     array_view<MemberDesc> get_static_metadata() const override { return class_metadata; }
     IProperty::Ptr get_property(string_view name, Resolve mode = Resolve::Create) const override
     {
-        if (mode == Resolve::Existing && !storage_) {
+        if (mode == Resolve::Existing && !this->storage_) {
             return {};
         }
         ensure_stor();
-        return storage_get_property(name, mode);
+        return this->storage_get_property(name, mode);
     }
     IEvent::Ptr get_event(string_view name, Resolve mode = Resolve::Create) const override
     {
-        if (mode == Resolve::Existing && !storage_) {
+        if (mode == Resolve::Existing && !this->storage_) {
             return {};
         }
         ensure_stor();
-        return storage_get_event(name, mode);
+        return this->storage_get_event(name, mode);
     }
     IFunction::Ptr get_function(string_view name, Resolve mode = Resolve::Create) const override
     {
-        if (mode == Resolve::Existing && !storage_) {
+        if (mode == Resolve::Existing && !this->storage_) {
             return {};
         }
         ensure_stor();
-        return storage_get_function(name, mode);
+        return this->storage_get_function(name, mode);
+    }
+    IInterface::Ptr get_member(MemberId id, MemberKind kind, Resolve mode = Resolve::Create) const override
+    {
+        if (mode == Resolve::Existing && !this->storage_) {
+            return {};
+        }
+        ensure_stor();
+        return this->storage_get_member(id, kind, mode);
+    }
+    IInterface::Ptr get_member_at(size_t index, Resolve mode = Resolve::Create) const override
+    {
+        if (mode == Resolve::Existing && !this->storage_) {
+            return {};
+        }
+        ensure_stor();
+        return this->storage_get_member_at(index, mode);
+    }
+    size_t materialize_all(uint32_t kinds = MemberKinds::All) const override
+    {
+        ensure_stor();
+        return this->storage_materialize_all(kinds);
     }
     void notify(MemberKind kind, Uid interfaceUid, Notification notification) const override
     {
+        // A frozen object has nobody to notify.
+        if (this->get_object_data().flags & ObjectFlags::Frozen) {
+            return;
+        }
+        // A write_state() may change the State without instantiating any property, so mark
+        // the object dirty here rather than relying on the properties to do it.
+        if ((this->get_object_data().flags & ObjectFlags::DirtyTracking) &&
+            notification == Notification::Changed) {
+            detail::hive_mark_dirty(this->get_block(), interfaceUid);
+        }
+        // Likewise for the cached values of COMPUTED members derived from the State.
+        if constexpr (computed_count > 0) {
+            if (kind == MemberKind::Property && notification == Notification::Changed) {
+                auto* state = const_cast<ObjectBase*>(this)->get_property_state(interfaceUid);
+                detail::invalidate_computed(class_metadata, interfaceUid, state);
+            }
+        }
         // No need to ensure storage. If container has not been initialized there won't be anything
         // to notify either.
-        storage_notify(kind, interfaceUid, notification);
+        this->storage_notify(kind, interfaceUid, notification);
     }
 
 public: // IObjectStorage overrides
     ReturnValue add_attachment(const IInterface::Ptr& attachment) override
     {
         ensure_stor();
-        return storage_add_attachment(attachment);
+        return this->storage_add_attachment(attachment);
     }
     ReturnValue remove_attachment(const IInterface::Ptr& attachment) override
     {
         ensure_stor();
-        return storage_remove_attachment(attachment);
+        return this->storage_remove_attachment(attachment);
+    }
+    size_t attachment_count() const override { return this->storage_attachment_count(); }
+    IInterface::Ptr get_attachment(size_t index) const override
+    {
+        return this->storage_get_attachment(index);
     }
-    size_t attachment_count() const override { return storage_attachment_count(); }
-    IInterface::Ptr get_attachment(size_t index) const override { return storage_get_attachment(index); }
     IInterface::Ptr find_attachment(const AttachmentQuery& query, Resolve mode) override
     {
-        if (mode == Resolve::Existing && !storage_) {
+        if (mode == Resolve::Existing && !this->storage_) {
             return {};
         }
         ensure_stor();
-        return storage_find_attachment(query, mode);
+        return this->storage_find_attachment(query, mode);
+    }
+    ReturnValue freeze() override
+    {
+        if (this->get_object_data().flags & ObjectFlags::Frozen) {
+            return ReturnValue::NothingToDo;
+        }
+        ensure_stor();
+        auto ret = this->storage_freeze();
+        if (succeeded(ret)) {
+            detail::BlockAccess::set_flags(*this, this->get_object_data().flags | ObjectFlags::Frozen);
+        }
+        return ret;
+    }
+    borrowed_ptr<IInterface> borrow_member(MemberId id, MemberKind kind) const override
+    {
+        return this->storage_borrow_member(id, kind);
     }
 
 public: // IPropertyState override
     /** @brief Returns a pointer to the State struct for the given interface UID. */
-    void* get_property_state(Uid uid) override { return find_state<0>(uid); }
+    void* get_property_state(Uid uid) override
+    {
+        if (this->get_object_data().flags & ObjectFlags::StateColumn) {
+            if (void* column = detail::hive_state_column(this->get_block(), uid)) {
+                return column;
+            }
+        }
+        return find_state<0>(uid);
+    }
+
+    /** @brief Returns the layout of each State struct, in interface order. */
+    array_view<StateLayout> get_state_layouts() const override
+    {
+        return {state_layouts.data(), state_layouts.size()};
+    }
 
     /** @brief Type-safe state access. Returns a typed pointer to T::State for a VELK_INTERFACE. */
     template <class T>
@@ -179,7 +318,7 @@ public: // IPropertyState override
     template <class T>
     const typename T::State* interface_state() const
     {
-        return const_cast<Object*>(this)->interface_state<T>();
+        return const_cast<ObjectBase*>(this)->interface_state<T>();
     }
 
 public:
@@ -198,7 +337,9 @@ private:
             static constexpr ClassInfo info{FinalClass::class_id(),
                                             FinalClass::class_name(),
                                             FinalClass::class_interfaces,
-                                            FinalClass::class_metadata};
+                                            FinalClass::class_metadata,
+                                            FinalClass::member_table_data.ok ? &FinalClass::member_table
+                                                                             : nullptr};
             return info;
         }
     };
@@ -210,6 +351,8 @@ private:
     // and is never passed to or interpreted by the DLL.
     std::tuple<typename InterfaceState<Interfaces>::type...> states_;
 
+    static constexpr auto state_layouts = make_state_layouts<Interfaces...>();
+
     template <size_t I>
     void* find_state(Uid uid)
     {
@@ -226,6 +369,35 @@ private:
 
 };
 
+/**
+ * @brief CRTP base for Velk objects with metadata and object storage.
+ *
+ * Extends ObjectCore with IObjectStorage support. Metadata is automatically collected
+ * from all Interfaces that declare metadata through VELK_INTERFACE. Attachments can be
+ * added/removed at runtime via the IObjectStorage interface.
+ * The ObjectStorage is created lazily on first runtime metadata/attachment access.
+ *
+ * @tparam FinalClass The final derived class (CRTP parameter).
+ * @tparam Interfaces Additional interfaces the object implements.
+ */
+template <class FinalClass, class... Interfaces>
+class Object : public ObjectBase<FinalClass, detail::ObjectStorageBase, Interfaces...>
+{};
+
+/**
+ * @brief Object whose ObjectStorage is embedded in the object instead of pool-allocated.
+ *
+ * For classes whose metadata is always accessed, e.g. widgets whose properties are bound,
+ * the first metadata access then takes no lock and reaches the storage without a separate
+ * allocation, at the cost of OBJECT_STORAGE_SIZE bytes per object, used or not.
+ *
+ * @tparam FinalClass The final derived class (CRTP parameter).
+ * @tparam Interfaces Additional interfaces the object implements.
+ */
+template <class FinalClass, class... Interfaces>
+class ObservedObject : public ObjectBase<FinalClass, detail::EmbeddedObjectStorageBase, Interfaces...>
+{};
+
 } // namespace velk::ext
 
 #endif // VELK_EXT_OBJECT_H
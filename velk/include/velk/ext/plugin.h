@@ -88,6 +88,8 @@ public:
     void pre_update(const IPlugin::PreUpdateInfo&) override {}
     /** @brief Default no-op post-update handler. Override to receive post-update notifications. */
     void post_update(const IPlugin::PostUpdateInfo&) override {}
+    /** @brief Never idle by default. Override to skip update callbacks that have nothing to do. */
+    bool is_update_idle() const override { return false; }
 };
 
 } // namespace velk::ext
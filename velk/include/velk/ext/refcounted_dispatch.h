@@ -1,14 +1,25 @@
 #ifndef VELK_EXT_REFCOUNTED_DISPATCH_H
 #define VELK_EXT_REFCOUNTED_DISPATCH_H
 
+#include <velk/allocator.h>
 #include <velk/ext/interface_dispatch.h>
 #include <velk/interface/types.h>
 #include <velk/memory.h>
 
+#include <cassert>
+#include <new>
+
 namespace velk {
 
 namespace detail {
 
+/**
+ * @brief Returns a nonzero id of the calling thread, unique for the lifetime of the process.
+ *
+ * Cheaper and smaller than std::thread::id; used to check ObjectFlags::ThreadConfined.
+ */
+VELK_EXPORT uint32_t current_thread_tag();
+
 /** @brief Marks a ref-counted object as dead and releases its control block. */
 inline void release_ref_counted(control_block& block)
 {
@@ -34,19 +45,25 @@ template <class... Interfaces>
 class RefCountedDispatch : public InterfaceDispatch<Interfaces...>
 {
 public:
-    /** @brief Atomically increments the reference count. */
-    void ref() override { data_.block->add_ref(); }
+    /** @brief Increments the reference count, atomically unless ObjectFlags::ThreadConfined. */
+    void ref() override
+    {
+        assert_owner_thread();
+        data_.block->add_ref();
+    }
 
-    /** @brief Atomically decrements the reference count; deletes the object at zero. */
+    /**
+     * @brief Decrements the reference count; deletes the object at zero, or once the ReclaimScopes
+     *        that may refer to it ended.
+     *
+     * ThreadConfined objects are never retired: only their own thread refers to them.
+     */
     void unref() override
     {
-        if (data_.block->release_ref()) {
-            if (data_.block->is_external()) {
-                auto* ecb = static_cast<external_control_block*>(data_.block);
-                ecb->destroy(ecb);
-            } else {
-                delete this;
-            }
+        assert_owner_thread();
+        auto* block = data_.block;
+        if (block->release_ref() && (block->is_local() || !detail::retire_object(&destroy, this))) {
+            destroy(this);
         }
     }
 
@@ -61,12 +78,31 @@ public:
      */
     ~RefCountedDispatch() override { detail::release_ref_counted(*data_.block); }
 
+    /** @brief Allocates heap instances through the velk allocator, tagged MemoryTag::Objects. */
+    static void* operator new(size_t size) { return allocate(size, alignof(std::max_align_t)); }
+    static void* operator new(size_t size, std::align_val_t alignment)
+    {
+        return allocate(size, static_cast<size_t>(alignment));
+    }
+    static void operator delete(void* ptr) noexcept
+    {
+        detail::velk_free(ptr, alignof(std::max_align_t), MemoryTag::Objects);
+    }
+    static void operator delete(void* ptr, std::align_val_t alignment) noexcept
+    {
+        detail::velk_free(ptr, static_cast<size_t>(alignment), MemoryTag::Objects);
+    }
+    /** @brief Placement new, hidden by the class-specific forms otherwise (e.g. for hive slots). */
+    static void* operator new(size_t, void* where) noexcept { return where; }
+    static void operator delete(void*, void*) noexcept {}
+
 protected:
     /** @brief Per-object data: flags and control block pointer. */
     struct ObjectData
     {
         control_block* block{detail::alloc_control_block()}; ///< Pooled control block (strong=1).
         uint32_t flags{ObjectFlags::None};                   ///< Bitwise combination of ObjectFlags.
+        uint32_t owner{}; ///< detail::current_thread_tag() of the creator of a ThreadConfined object.
     };
     /** @brief Returns a mutable reference to the per-object data. */
     constexpr ObjectData& get_object_data() noexcept { return data_; }
@@ -78,6 +114,31 @@ protected:
 private:
     friend struct detail::BlockAccess;
 
+    static void* allocate(size_t size, size_t alignment)
+    {
+        void* ptr = detail::velk_alloc(size, alignment, MemoryTag::Objects);
+        assert(ptr && "velk object allocation failed");
+        return ptr;
+    }
+
+    static void destroy(void* object)
+    {
+        auto* self = static_cast<RefCountedDispatch*>(object);
+        if (self->data_.block->is_external()) {
+            auto* ecb = static_cast<external_control_block*>(self->data_.block);
+            ecb->destroy(ecb);
+        } else {
+            delete self;
+        }
+    }
+
+    void assert_owner_thread() const
+    {
+        assert((!(data_.flags & ObjectFlags::ThreadConfined) ||
+                data_.owner == detail::current_thread_tag()) &&
+               "ThreadConfined object used from another thread");
+    }
+
     /** @brief Replaces the control block. Used internally by placement storage. */
     void replace_block(control_block* block) noexcept { data_.block = block; }
 
@@ -108,6 +169,14 @@ struct BlockAccess
     {
         obj.get_object_data().flags = flags;
     }
+
+    /** @brief Makes the reference counts of @p obj non-atomic, owned by the calling thread. */
+    template <class T>
+    static void confine(T& obj) noexcept
+    {
+        obj.get_object_data().owner = current_thread_tag();
+        obj.get_block()->set_local_tag();
+    }
 };
 
 } // namespace detail
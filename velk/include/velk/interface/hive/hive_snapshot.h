@@ -0,0 +1,115 @@
+#ifndef VELK_INTF_HIVE_SNAPSHOT_H
+#define VELK_INTF_HIVE_SNAPSHOT_H
+
+#include <velk/interface/hive/intf_hive_page_source.h>
+#include <velk/uid.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace velk {
+
+namespace ClassId {
+/** @brief Copy-on-write memory mapping of a raw hive snapshot file (IHiveSnapshotMapping). */
+inline constexpr Uid HiveSnapshotMapping{"6d1e4f2a-93b7-4c05-a8e1-5f7c20d94b63"};
+} // namespace ClassId
+
+/**
+ * @brief Header at the start of every hive snapshot.
+ *
+ * A raw hive snapshot (IRawHive::snapshot()) is followed by @c page_count HiveSnapshotPage
+ * records, then by the active bitmask and slots of each page at the offsets the records
+ * give, written verbatim. Slots start at a multiple of @c alignment, so a snapshot that is
+ * loaded at an address aligned to @c alignment can be used in place.
+ *
+ * A State snapshot (IObjectHive::snapshot_states()) has no page records: @c count States of
+ * @c element_size bytes each follow the header back to back.
+ *
+ * All offsets are in bytes from the start of the snapshot. Snapshots are meant to be restored
+ * on the same platform and build: the data keeps the native byte order and element layout.
+ */
+struct HiveSnapshotHeader
+{
+    static constexpr uint32_t MAGIC = 0x4b564948; ///< "HIVK" in little-endian.
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic{MAGIC};
+    uint32_t version{VERSION};
+    Uid element_uid;          ///< Element UID of the raw hive, or interface UID of the States.
+    uint64_t element_size{0}; ///< Slot size of the raw hive, or size of a State.
+    uint64_t alignment{0};    ///< Alignment of the slots of each page (raw hive snapshots).
+    uint64_t count{0};        ///< Number of live elements.
+    uint64_t page_count{0};   ///< Number of HiveSnapshotPage records after the header.
+    uint64_t size{0};         ///< Total size of the snapshot in bytes.
+};
+
+/** @brief Location of one page in a raw hive snapshot. */
+struct HiveSnapshotPage
+{
+    uint64_t capacity;     ///< Number of slots in the page.
+    uint64_t bits_offset;  ///< Offset of the active bitmask, one bit per slot in 64-bit words.
+    uint64_t slots_offset; ///< Offset of the first slot. Slots are HiveSnapshotHeader::element_size apart.
+};
+
+/**
+ * @brief Header at the start of a change journal (IObjectHive::write_changes()).
+ *
+ * @c count HiveJournalRecord entries follow the header, each followed by the @c size bytes
+ * of the new value of its property, padded to a multiple of 8 bytes. Like snapshots,
+ * journals keep the native byte order and layout of the values.
+ */
+struct HiveJournalHeader
+{
+    static constexpr uint32_t MAGIC = 0x4a564948; ///< "HIVJ" in little-endian.
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic{MAGIC};
+    uint32_t version{VERSION};
+    Uid interface_uid;      ///< Interface whose properties the records hold.
+    uint64_t state_size{0}; ///< Size of the interface's State.
+    uint64_t count{0};      ///< Number of records after the header.
+    uint64_t size{0};       ///< Total size of the journal in bytes.
+};
+
+/** @brief One changed property in a change journal. */
+struct HiveJournalRecord
+{
+    uint64_t handle; ///< HiveHandle::value of the object in the hive that wrote the journal.
+    uint32_t member; ///< Index of the property in the interface's metadata.
+    uint32_t size;   ///< Size of the value that follows the record.
+};
+
+/**
+ * @brief Copy-on-write memory mapping of a snapshot file, whose pages a raw hive can adopt.
+ *
+ * The file is mapped privately: the OS shares its unmodified pages between every process
+ * that maps the same file, and a write copies only the OS page it touches. The file itself
+ * is never modified.
+ *
+ * IRawHive::adopt() uses the pages of the snapshot in place. Adopted pages hold a reference
+ * to the mapping through the IHivePageSource interface, so the file stays mapped until the
+ * last adopted page is released. The mapping cannot allocate new pages: allocate_page()
+ * always fails, and free_page() leaves the memory to be unmapped with the mapping.
+ *
+ * @see ClassId::HiveSnapshotMapping
+ */
+class IHiveSnapshotMapping : public Interface<IHiveSnapshotMapping, IHivePageSource>
+{
+public:
+    /**
+     * @brief Maps the snapshot file at @p path.
+     * @return Success, Fail if the file cannot be mapped or a file is already mapped,
+     *         or InvalidArgument if @p path is null.
+     */
+    virtual ReturnValue open(const char* path) = 0;
+
+    /** @brief Returns the start of the mapping, aligned to the OS page size, or nullptr if not open. */
+    virtual void* get_data() const = 0;
+
+    /** @brief Returns the size of the mapped file in bytes. */
+    virtual size_t get_size() const = 0;
+};
+
+} // namespace velk
+
+#endif // VELK_INTF_HIVE_SNAPSHOT_H
@@ -1,19 +1,44 @@
 #ifndef VELK_INTF_HIVE_H
 #define VELK_INTF_HIVE_H
 
+#include <velk/interface/hive/hive_snapshot.h>
+#include <velk/interface/hive/intf_hive_page_source.h>
+#include <velk/interface/intf_event.h>
+#include <velk/interface/intf_executor.h>
 #include <velk/interface/intf_object.h>
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 
 namespace velk {
 
 namespace ClassId {
 /** @brief Dense, typed container of objects sharing the same class ID. */
 inline constexpr Uid ObjectHive{"331d944c-be7d-4bb4-b5cf-91d34c1383b9"};
+/** @brief Object hive split into per-thread partitions (see IHiveStore::get_partitioned_hive()). */
+inline constexpr Uid PartitionedObjectHive{"e2c6a9b1-58d3-4f0e-b7a4-91c3d6f25e08"};
 /** @brief Dense, typed container for raw (non-ref-counted) allocations. */
 inline constexpr Uid RawHive{"a7e1c3f0-5b29-4d8a-9f1e-3c7d2a8b4e60"};
 } // namespace ClassId
 
+/** @brief Cache line size to pass to IHive::set_slot_alignment() to keep elements off shared cache lines. */
+inline constexpr size_t HIVE_CACHE_LINE_SIZE = 64;
+
+/** @brief How a hive picks the capacity of its next page (see HivePageCapacity::growth). */
+enum class HivePageGrowth : uint8_t
+{
+    /** @brief Pages hold page_1, page_2, page_3 and then page_n elements. */
+    Fixed,
+    /**
+     * @brief Each page doubles the hive, starting from page_1 elements and bounded by
+     *        max_page_bytes. A hive that shrank grows back to its peak capacity in one page,
+     *        and a hive that freed at least half its slots since its last page grows by half
+     *        as much, as the freed slots absorb the rest.
+     */
+    Adaptive,
+};
+
 /**
  * @brief The HivePageCapacity struct can be used to configure the allocation policy for each page in a hive.
  */
@@ -39,8 +64,201 @@ struct HivePageCapacity
      *  @default 1024
      */
     size_t page_n{1024u};
+    /**
+     *  @brief Free slot high-water mark. When an element is removed while more slots than this are free,
+     *         the emptied page is released. 0 disables automatic trimming.
+     *  @default 0
+     */
+    size_t max_free_slots{0u};
+    /**
+     *  @brief Page size policy. page_2, page_3 and page_n only apply to HivePageGrowth::Fixed.
+     *  @default HivePageGrowth::Fixed
+     */
+    HivePageGrowth growth{HivePageGrowth::Fixed};
+    /**
+     *  @brief Upper bound of the slot memory of a page grown by HivePageGrowth::Adaptive.
+     *         Pages always hold at least one element.
+     *  @default 1 MiB
+     */
+    size_t max_page_bytes{size_t(1) << 20};
+};
+
+/** @brief Which threads may use an object hive (see IObjectHive::set_threading()). */
+enum class HiveThreading : uint8_t
+{
+    MultiThread,  ///< Any thread, serialized by the hive lock.
+    SingleThread, ///< One thread at a time, without locking.
+};
+
+/** @brief How IObjectHive::clear_parallel() and IRawHive::clear_parallel() free the emptied pages. */
+enum class HivePageRelease : uint8_t
+{
+    Immediate,  ///< Pages are freed before the call returns.
+    Background, ///< Pages are freed by a task on the instance thread pool (IVelk::get_thread_pool()).
+};
+
+/** @brief Memory usage of a hive, or of all hives of a store (see IHive::get_stats()). */
+struct HiveStats
+{
+    size_t pages{0};            ///< Number of allocated pages.
+    size_t capacity{0};         ///< Total slots over all pages.
+    size_t live{0};             ///< Live elements, equal to IHive::size().
+    size_t zombies{0};          ///< Removed objects kept alive by external references (object hives).
+    size_t free_slots{0};       ///< Slots available for new elements.
+    size_t fragmented_slots{0}; ///< Free slots in pages that also hold elements, which trim() cannot release.
+    size_t reserved_bytes{0};   ///< Bytes allocated for pages, including bookkeeping and padding.
+    /**
+     * @brief Pages of destroyed object hives that outstanding references keep alive.
+     *
+     * Only reported by IHiveStore::get_stats(), as a process-wide count.
+     */
+    size_t orphaned_pages{0};
+
+    /**
+     * @brief Returns fragmented_slots as a share of capacity.
+     *
+     * 0 for a dense hive, approaching 1 for a hive whose elements are scattered
+     * thinly over many pages.
+     */
+    double fragmentation() const { return capacity ? double(fragmented_slots) / double(capacity) : 0.0; }
+};
+
+/**
+ * @brief View of a run of slots in one hive page, handed to per-page visitors.
+ *
+ * Slot i of the run lives at data + i * stride and is live if bit i of
+ * active_bits is set (bit i % 64 of word i / 64). Slots that are not live hold
+ * unspecified bytes.
+ */
+struct HivePageView
+{
+    void* data;                  ///< First slot of the run.
+    size_t stride;               ///< Byte distance between consecutive slots.
+    const uint64_t* active_bits; ///< Liveness bitmask, one bit per slot.
+    size_t count;                ///< Number of slots in the run.
 };
 
+/**
+ * @brief Compact reference to an object in an object hive (see IObjectHive::get_handle()).
+ *
+ * Packs the id of the object's page, its slot index and the generation of the slot into
+ * 64 bits. The generation changes when the object leaves the hive, so a handle to a removed
+ * object stops resolving, also after its slot is reused. Handles do not keep objects alive,
+ * so copying and storing them costs no reference counting. A default handle resolves to
+ * nothing. Generations wrap after 2^20 removals from the same slot.
+ */
+struct HiveHandle
+{
+    static constexpr uint32_t SLOT_BITS = 24;       ///< Bits of the slot index.
+    static constexpr uint32_t PAGE_BITS = 20;       ///< Bits of the page id.
+    static constexpr uint32_t GENERATION_BITS = 20; ///< Bits of the slot generation.
+
+    uint64_t value{0}; ///< [ generation | page id | slot index ], 0 for no object.
+
+    /** @brief Packs a handle. Each field must fit its bit count and @p generation must not be 0. */
+    static constexpr HiveHandle make(uint64_t page, uint64_t slot, uint64_t generation)
+    {
+        return {(generation << (SLOT_BITS + PAGE_BITS)) | (page << SLOT_BITS) | slot};
+    }
+
+    /** @brief Returns the slot index in the page. */
+    constexpr uint64_t slot() const { return value & ((uint64_t(1) << SLOT_BITS) - 1); }
+    /** @brief Returns the page id in the hive. */
+    constexpr uint64_t page() const { return (value >> SLOT_BITS) & ((uint64_t(1) << PAGE_BITS) - 1); }
+    /** @brief Returns the generation of the slot when the handle was issued. */
+    constexpr uint64_t generation() const { return value >> (SLOT_BITS + PAGE_BITS); }
+
+    /** @brief Returns true unless this is the default handle. */
+    constexpr explicit operator bool() const { return value != 0; }
+    constexpr bool operator==(const HiveHandle& other) const { return value == other.value; }
+    constexpr bool operator!=(const HiveHandle& other) const { return value != other.value; }
+};
+
+/** @brief How the field of a hive index is interpreted (see IObjectHive::add_index()). */
+enum class HiveKeyType : uint8_t
+{
+    Unsigned = 0, ///< Unsigned integer, bool or unsigned enum of 1, 2, 4 or 8 bytes.
+    Signed = 1,   ///< Signed integer or signed enum of 1, 2, 4 or 8 bytes.
+    Float = 2,    ///< float or double.
+};
+
+/** @brief The lookups a hive index supports. */
+enum class HiveIndexType : uint8_t
+{
+    Hash = 0,   ///< Equality lookups in constant time.
+    Sorted = 1, ///< Equality and range lookups in logarithmic time, visiting in key order.
+};
+
+/** @brief Describes an index over one field of an interface's State. */
+struct HiveIndexDesc
+{
+    Uid interfaceUid;                              ///< Interface whose State holds the field.
+    size_t field_offset{0};                        ///< Byte offset of the field in the State.
+    size_t field_size{0};                          ///< sizeof the field.
+    HiveKeyType key_type{HiveKeyType::Unsigned};   ///< Interpretation of the field.
+    HiveIndexType index_type{HiveIndexType::Hash}; ///< Supported lookups.
+};
+
+namespace detail {
+/** @brief Loads an integer field, sign-extending it if @p is_signed. */
+template <class U, class S>
+inline uint64_t load_index_key(const void* field, bool is_signed)
+{
+    U value;
+    std::memcpy(&value, field, sizeof(value));
+    return is_signed ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<S>(value))) : value;
+}
+} // namespace detail
+
+/**
+ * @brief Encodes a field value as a hive index key.
+ *
+ * Keys compare as unsigned integers in the same order as the values they encode, so a
+ * sorted index needs no knowledge of the field type. -0.0 and 0.0 encode to the same key.
+ *
+ * @param field The field value.
+ * @param type Interpretation of the field.
+ * @param size sizeof the field.
+ */
+inline uint64_t encode_hive_index_key(const void* field, HiveKeyType type, size_t size)
+{
+    constexpr uint64_t sign = uint64_t(1) << 63;
+    if (type == HiveKeyType::Float) {
+        double value = 0.0;
+        if (size == sizeof(float)) {
+            float f;
+            std::memcpy(&f, field, sizeof(f));
+            value = f;
+        } else {
+            std::memcpy(&value, field, sizeof(value));
+        }
+        if (value == 0.0) {
+            value = 0.0;
+        }
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits & sign ? ~bits : bits | sign;
+    }
+    bool is_signed = type == HiveKeyType::Signed;
+    uint64_t bits;
+    switch (size) {
+    case 1:
+        bits = detail::load_index_key<uint8_t, int8_t>(field, is_signed);
+        break;
+    case 2:
+        bits = detail::load_index_key<uint16_t, int16_t>(field, is_signed);
+        break;
+    case 4:
+        bits = detail::load_index_key<uint32_t, int32_t>(field, is_signed);
+        break;
+    default:
+        bits = detail::load_index_key<uint64_t, int64_t>(field, is_signed);
+        break;
+    }
+    // Flipping the sign bit orders negative values before positive ones.
+    return is_signed ? bits ^ sign : bits;
+}
+
 /** @brief Specifies the type of a hive. */
 enum class HiveType : uint8_t
 {
@@ -72,16 +290,71 @@ public:
     /** @brief Returns the current page allocation policy. */
     virtual HivePageCapacity get_page_capacity() const = 0;
 
+    /** @brief Returns the current page and slot usage of the hive. */
+    virtual HiveStats get_stats() const = 0;
+
     /**
      *  @brief Sets the allocation policy for new pages. Requires that each page as at least one element and
      *         that at least as many items as the previous page.
      *  @note Any changes will only affect new pages, it will have no effect on existing allocations.
      *        Typically this function should be called immediately after creating a hive, before instantiating
-     *        any objects to it.
+     *        any objects to it. HivePageCapacity::max_free_slots takes effect immediately.
      *  @param capacity The page allocation policy to set.
      */
     virtual void set_page_capacity(const HivePageCapacity& capacity) = 0;
 
+    /** @brief Returns the alignment of the slots of the hive, see set_slot_alignment(). */
+    virtual size_t get_slot_alignment() const = 0;
+
+    /**
+     * @brief Pads every slot to a multiple of @p alignment bytes and aligns the slots of each page to it.
+     *
+     * With HIVE_CACHE_LINE_SIZE no two elements share a cache line, so threads writing different
+     * elements in parallel (e.g. for_each_state() with an executor) never invalidate each other's
+     * lines. Elements smaller than the alignment take more memory and iterate slower on a single
+     * thread. Must be called before the hive allocates its first page.
+     *
+     * @param alignment A power of two, or 0 to use the natural alignment of the element.
+     * @return Success, InvalidArgument if @p alignment is not a power of two, or Fail if the hive
+     *         already has pages.
+     */
+    virtual ReturnValue set_slot_alignment(size_t alignment) = 0;
+
+    /** @brief Returns the page source used for new pages, or nullptr if pages come from the heap. */
+    virtual IHivePageSource::Ptr get_page_source() const = 0;
+
+    /**
+     * @brief Sets the source of the memory backing new pages.
+     * @note Existing pages keep the memory they were allocated with.
+     * @param source The page source to use, or nullptr to allocate pages from the heap.
+     */
+    virtual void set_page_source(const IHivePageSource::Ptr& source) = 0;
+
+    /**
+     * @brief Releases pages that hold no elements.
+     *
+     * For object hives, zombie objects and weakly referenced control blocks also
+     * keep their page alive. For raw hives, slots cached in magazines are returned
+     * to their pages first. Pages are released until releasing another one would
+     * leave fewer than @p keep_free_slots free slots.
+     *
+     * @param keep_free_slots Number of free slots to keep for future allocations.
+     * @return The number of pages released.
+     */
+    virtual size_t trim(size_t keep_free_slots = 0) = 0;
+
+    /**
+     * @brief Preallocates storage so that at least @p free_slots elements can be added without allocating.
+     *
+     * The shortfall is covered by a single page, which bypasses the HivePageCapacity
+     * growth progression. A later trim() or HivePageCapacity::max_free_slots may release
+     * the reserved pages again.
+     *
+     * @param free_slots Number of free slots the hive should hold.
+     * @return Success if a page was allocated, NothingToDo if the hive already had enough free slots.
+     */
+    virtual ReturnValue reserve(size_t free_slots) = 0;
+
     /**
      * @brief Removes all elements from the hive.
      *
@@ -94,6 +367,23 @@ public:
      * After clear(), for_each() visits no elements and size() returns 0.
      */
     virtual void clear() = 0;
+
+    /**
+     * @brief Iterates the hive page by page.
+     *
+     * The visitor receives a view of the element slots of each page and their active
+     * bits. Only the per-page callback is virtual, so a header-side loop over the view
+     * can inline a per-element callback (see for_each_active_slot()). Object hive slots
+     * hold the objects, with IObject at offset 0. With an executor, pages are split into
+     * runs of bitmask words as in IObjectHive::for_each_state_parallel() and the visitor
+     * must be thread-safe.
+     *
+     * @param context Opaque pointer forwarded to the visitor.
+     * @param visitor Called with (context, page) per run of slots. Return false to stop early.
+     * @param executor Executor running the workers. If null, iterates on the calling thread.
+     */
+    using PageVisitorFn = bool (*)(void* context, const HivePageView& page);
+    virtual void for_each_page(void* context, PageVisitorFn visitor, IExecutor* executor) const = 0;
 };
 
 /**
@@ -110,12 +400,61 @@ public:
     /** @brief Creates a new object in the hive and returns a shared pointer to it. */
     virtual IObject::Ptr add() = 0;
 
+    /**
+     * @brief Creates @p count objects in the hive under a single lock acquisition.
+     *
+     * The slots for all objects are reserved up front, allocating at most one page
+     * that covers the whole shortfall, so bulk spawning skips the per-add() locking
+     * and page checks.
+     *
+     * @param count Number of objects to create.
+     * @param out Receives the created objects, must hold @p count elements. If null,
+     *            the objects are only owned by the hive.
+     * @return The number of objects created (0 if the hive has no factory).
+     */
+    virtual size_t add_n(size_t count, IObject::Ptr* out) = 0;
+
     /** @brief Removes an object from the hive. Returns Success or Fail if not found. */
     virtual ReturnValue remove(IObject& object) = 0;
 
+    /**
+     * @brief Like clear(), releasing the objects on the tasks of @p executor, then every page left unused.
+     *
+     * The objects whose last reference the hive held are destroyed in parallel, so their
+     * destructors must be safe to run concurrently. Objects with external references enter
+     * zombie state as with clear(), and their pages are kept.
+     *
+     * @param executor Executor running the destructors, or nullptr to run them on the calling thread.
+     * @param release Whether the unused pages are freed before returning or in the background.
+     */
+    virtual void clear_parallel(IExecutor* executor, HivePageRelease release) = 0;
+
     /** @brief Returns true if the given object is in this hive. */
     virtual bool contains(const IObject& object) const = 0;
 
+    /**
+     * @brief Returns a generational handle to an object in the hive.
+     *
+     * A handle is 8 bytes and needs no reference counting, which suits storing many
+     * references between hive objects. resolve() turns it back into the object.
+     *
+     * @return The handle, or a default handle if @p object is not in the hive or its slot
+     *         lies beyond the range a handle can address.
+     */
+    virtual HiveHandle get_handle(const IObject& object) const = 0;
+
+    /**
+     * @brief Returns the object a handle refers to, in constant time.
+     *
+     * Takes the same shared lock as contains(). The returned pointer holds no reference:
+     * it stays valid while the object remains in the hive, so it must not be used after a
+     * concurrent remove() or clear().
+     *
+     * @return The object, or null if it left the hive. Handles are only checked against the
+     *         slot they name, so a handle from another hive may resolve to any object.
+     */
+    virtual IObject* resolve(HiveHandle handle) const = 0;
+
     /**
      * @brief Iterates all live objects in the hive.
      * @param context Opaque pointer forwarded to the visitor.
@@ -124,6 +463,17 @@ public:
     using VisitorFn = bool (*)(void* context, IObject& object);
     virtual void for_each(void* context, VisitorFn visitor) const = 0;
 
+    /**
+     * @brief Returns the byte offset from object start to the inline State of an interface.
+     *
+     * The offsets of all States of the element class are computed once per hive from a
+     * prototype object, so the hive may be empty and later calls cost a lookup.
+     *
+     * @return The offset to pass to for_each_state(), or -1 if the class has no State for
+     *         @p interfaceUid or the State lives in a state column.
+     */
+    virtual ptrdiff_t get_state_offset(Uid interfaceUid) const = 0;
+
     /**
      * @brief Iterates all live objects, passing a pre-computed state pointer.
      *
@@ -136,9 +486,9 @@ public:
      * the virtual dispatch overhead (bulk reads, writes, physics ticks).
      *
      * Prefer the typed ObjectHive::for_each<StateInterface> wrapper in
-     * api/hive/object_hive.h, which computes the offset automatically.
-     * Use this method directly when you need to cache the offset across
-     * repeated iterations or pass through a C-style context pointer.
+     * api/hive/object_hive.h, which looks up the offset automatically.
+     * Use this method directly with get_state_offset() when you need to
+     * pass through a C-style context pointer.
      *
      * @param state_offset Byte offset from object start to the state struct.
      * @param context Opaque pointer forwarded to the visitor.
@@ -146,6 +496,313 @@ public:
      */
     using StateVisitorFn = bool (*)(void* context, IObject& object, void* state);
     virtual void for_each_state(ptrdiff_t state_offset, void* context, StateVisitorFn visitor) const = 0;
+
+    /**
+     * @brief Parallel variant of for_each_state().
+     *
+     * Splits the pages into chunks of active-slot bitmask words which the executor's
+     * workers claim dynamically, so faster workers pick up the remaining chunks. The
+     * calling thread holds the shared lock for the whole call and the same mutation
+     * rules as for_each_state() apply.
+     *
+     * The visitor is called concurrently from several threads and must be thread-safe.
+     * Returning false stops all workers from claiming further chunks.
+     *
+     * @param state_offset Byte offset from object start to the state struct.
+     * @param context Opaque pointer forwarded to the visitor.
+     * @param visitor Called with (context, object, state_ptr). Return false to stop early.
+     * @param executor Executor running the workers. If null, iterates on the calling thread.
+     */
+    virtual void for_each_state_parallel(ptrdiff_t state_offset, void* context, StateVisitorFn visitor,
+                                         IExecutor* executor) const = 0;
+
+    /**
+     * @brief Frees pages that no longer hold any objects.
+     *
+     * Objects are never moved (external pointers refer to them directly), so only pages
+     * with no active or zombie objects and no outstanding weak references to any of their
+     * embedded control blocks are released. Equivalent to trim(0).
+     *
+     * @return The number of pages freed.
+     */
+    virtual size_t compact() = 0;
+
+    /**
+     * @brief Stores the State struct of an interface in a contiguous column per page.
+     *
+     * By default each interface State lives inside its object, so a loop touching one
+     * State field strides over whole objects. With a state column, the hive keeps the
+     * States of all objects in a page in a separate array, and objects resolve
+     * get_property_state() for that interface to their column entry. Iterate the
+     * column with for_each_column().
+     *
+     * The State must be trivially copyable: each new column entry is a byte copy of
+     * the object's inline State after construction. The inline State remains part of
+     * the object layout but is no longer used.
+     *
+     * Must be called before the first add(), while the hive has no pages.
+     * Prefer the typed ObjectHive::add_state_column<StateInterface>() wrapper.
+     *
+     * @param interfaceUid UID of the interface whose State to store in a column.
+     * @param state_size sizeof the State struct.
+     * @param state_alignment alignof the State struct.
+     * @return Success, NothingToDo if the column already exists, InvalidArgument if the
+     *         class has no State for the interface, or Fail if the hive already has pages.
+     */
+    virtual ReturnValue add_state_column(Uid interfaceUid, size_t state_size, size_t state_alignment) = 0;
+
+    /** @brief Returns true if the State of @p interfaceUid is stored in a column. */
+    virtual bool has_state_column(Uid interfaceUid) const = 0;
+
+    /**
+     * @brief Iterates a state column page by page.
+     *
+     * The visitor receives matching views of the objects and their column States. The
+     * States of a run are contiguous, so kernels can process them with unit stride and
+     * mask by the active bits. With an executor, pages are split into chunks of bitmask
+     * words as in for_each_state_parallel() and the visitor must be thread-safe.
+     *
+     * @param interfaceUid UID of an interface added with add_state_column().
+     * @param context Opaque pointer forwarded to the visitor.
+     * @param visitor Called with (context, objects, states) per run. Return false to stop early.
+     * @param executor Executor running the workers. If null, iterates on the calling thread.
+     */
+    using ColumnVisitorFn = bool (*)(void* context, const HivePageView& objects, const HivePageView& states);
+    virtual void for_each_column(Uid interfaceUid, void* context, ColumnVisitorFn visitor,
+                                 IExecutor* executor) const = 0;
+
+    /**
+     * @brief Stores the State of an interface in a double buffered state column.
+     *
+     * Like add_state_column(), but every page also keeps a front copy of the column.
+     * Property writes and for_each_column() go to the back column, while readers on
+     * another thread iterate the front copy with for_each_front(). swap_state_buffers()
+     * publishes the back column to the front, typically once at the end of a frame, so a
+     * renderer can read a stable frame N while the simulation writes frame N+1 without
+     * locking individual objects.
+     *
+     * Adds the front copy to an existing state column. Must be called before the first
+     * add(), while the hive has no pages.
+     * Prefer the typed ObjectHive::add_double_buffered_state<StateInterface>() wrapper.
+     *
+     * @param interfaceUid UID of the interface whose State to double buffer.
+     * @param state_size sizeof the State struct.
+     * @param state_alignment alignof the State struct.
+     * @return Success, NothingToDo if the column is already double buffered, InvalidArgument
+     *         if the class has no State for the interface, or Fail if the hive already has pages.
+     */
+    virtual ReturnValue add_double_buffered_state(Uid interfaceUid, size_t state_size,
+                                                  size_t state_alignment) = 0;
+
+    /**
+     * @brief Iterates the published front copy of a state column page by page.
+     *
+     * Works as for_each_column() but hands the visitor the States as of the last
+     * swap_state_buffers(). For a column that is not double buffered, visits the column
+     * itself. Holds the shared hive lock, so swap_state_buffers() waits for the iteration.
+     *
+     * @param interfaceUid UID of an interface added with add_double_buffered_state().
+     * @param context Opaque pointer forwarded to the visitor.
+     * @param visitor Called with (context, objects, states) per run. Return false to stop early.
+     * @param executor Executor running the workers. If null, iterates on the calling thread.
+     */
+    virtual void for_each_front(Uid interfaceUid, void* context, ColumnVisitorFn visitor,
+                                IExecutor* executor) const = 0;
+
+    /**
+     * @brief Publishes the back column of every double buffered State to its front copy.
+     *
+     * Copies each page's column with a single memcpy under the exclusive hive lock. Writes
+     * to the back column must not overlap the call, so call it where the writers are done
+     * with the frame, e.g. from IPlugin::post_update() or after IVelk::update().
+     */
+    virtual void swap_state_buffers() = 0;
+
+    /**
+     * @brief Writes the State of @p interfaceUid of every live object into a snapshot buffer.
+     *
+     * The States are copied back to back in iteration order (see HiveSnapshotHeader),
+     * from the objects or from the interface's state column, without per-object virtual
+     * calls. The State must be trivially copyable.
+     * Prefer the typed ObjectHive::snapshot_states<StateInterface>() wrapper.
+     *
+     * @param interfaceUid UID of the interface whose State to write.
+     * @param state_size sizeof the State struct.
+     * @param buffer Receives the snapshot. May be null to query the size.
+     * @param size Size of @p buffer in bytes.
+     * @return The size of the snapshot in bytes, or 0 if the objects have no State for the
+     *         interface. Nothing is written if it exceeds @p size.
+     */
+    virtual size_t snapshot_states(Uid interfaceUid, size_t state_size, void* buffer, size_t size) const = 0;
+
+    /**
+     * @brief Adds one object per State of a snapshot and sets its State from the snapshot.
+     *
+     * Slots for all objects are reserved up front as in add_n(), and the States are copied
+     * into the new objects, or their state column, without per-object virtual calls.
+     * The objects are only owned by the hive; existing objects are kept.
+     *
+     * @param interfaceUid UID of the interface whose State the snapshot holds.
+     * @param state_size sizeof the State struct.
+     * @param buffer A snapshot written by snapshot_states().
+     * @param size Size of @p buffer in bytes.
+     * @return Success, NothingToDo for a snapshot of no States, or InvalidArgument if @p buffer
+     *         is not a State snapshot of @p interfaceUid or the objects have no such State.
+     */
+    virtual ReturnValue restore_states(Uid interfaceUid, size_t state_size, const void* buffer,
+                                       size_t size) = 0;
+
+    /**
+     * @brief Tracks which objects changed a property of an interface.
+     *
+     * The hive keeps a dirty bitmask for the interface in every page, next to the active
+     * bits. An object is marked when one of its properties of the interface notifies a
+     * change, including the notification of write_state(), and when it is added to the
+     * hive. for_each_dirty() visits the marked objects and clears their marks, which lets
+     * a consumer poll for changes once per frame instead of subscribing to on_changed.
+     *
+     * Writes through an external any (IExternalAny) notify on their own and are not tracked.
+     * Must be called before the first add(), while the hive has no pages.
+     *
+     * @param interfaceUid UID of the interface to track.
+     * @return Success, NothingToDo if the interface is already tracked, InvalidArgument if
+     *         the class has no State for the interface, or Fail if the hive already has pages.
+     */
+    virtual ReturnValue add_dirty_tracking(Uid interfaceUid) = 0;
+
+    /** @brief Returns true if add_dirty_tracking() was called for @p interfaceUid. */
+    virtual bool has_dirty_tracking(Uid interfaceUid) const = 0;
+
+    /**
+     * @brief Visits every live object marked dirty for @p interfaceUid and clears its mark.
+     *
+     * Scans the dirty bitmask of each page a word at a time, so the cost is linear in the
+     * number of pages plus the number of dirty objects. The marks of a word are cleared
+     * before its objects are visited: a property written by the visitor marks its object
+     * again for the next call. Marks of objects not visited because the visitor stopped
+     * early are kept.
+     *
+     * @param interfaceUid UID of an interface added with add_dirty_tracking().
+     * @param context Opaque pointer forwarded to the visitor.
+     * @param visitor Called with (context, object, state_ptr). Return false to stop early.
+     * @return The number of objects visited.
+     */
+    virtual size_t for_each_dirty(Uid interfaceUid, void* context, StateVisitorFn visitor) = 0;
+
+    /**
+     * @brief Journals the changes to the State of an interface for write_changes().
+     *
+     * Every page keeps a copy of the State of each of its objects as last journaled, and a
+     * bitmask of its own marked like the one of add_dirty_tracking(), so that journaling
+     * works alongside for_each_dirty(). New objects start with their constructed State as
+     * the journaled copy. Only the properties of the interface are journaled; the State
+     * must be trivially copyable.
+     * Must be called before the first add(), while the hive has no pages.
+     *
+     * @param interfaceUid UID of the interface to journal.
+     * @param state_size sizeof the State struct.
+     * @param state_alignment alignof the State struct.
+     * @return Success, NothingToDo if the interface is already journaled, InvalidArgument if
+     *         the class has no State for the interface or @p state_size does not match it, or
+     *         Fail if the hive already has pages.
+     */
+    virtual ReturnValue add_change_journal(Uid interfaceUid, size_t state_size, size_t state_alignment) = 0;
+
+    /**
+     * @brief Writes the properties changed since the last call to a change journal buffer.
+     *
+     * Compares each marked object's State with its journaled copy, one property at a time,
+     * and writes a HiveJournalRecord for each property that differs (see HiveJournalHeader).
+     * Several writes to a property between two calls produce a single record with the
+     * latest value, so the cost is linear in the number of pages plus the number of changes.
+     * The marks and journaled copies are only updated when the journal fits in @p buffer.
+     * Writes to the States must not overlap the call.
+     *
+     * Prefer the typed ObjectHive::write_changes<StateInterface>() wrapper.
+     *
+     * @param interfaceUid UID of an interface added with add_change_journal().
+     * @param buffer Receives the journal. May be null to query the size.
+     * @param size Size of @p buffer in bytes.
+     * @return The size of the journal in bytes, or 0 if the interface is not journaled.
+     *         Nothing is written if it exceeds @p size.
+     */
+    virtual size_t write_changes(Uid interfaceUid, void* buffer, size_t size) = 0;
+
+    /**
+     * @brief Indexes the objects by a field of an interface's State.
+     *
+     * The index is kept up to date through the same marks as add_dirty_tracking(), in a
+     * bitmask of its own: a property write marks the object, and the next lookup rereads
+     * the field of every marked object before searching. Writes that do not notify, such
+     * as through a pointer from for_each_state(), are not picked up. Objects in pages
+     * beyond the range of a HiveHandle are not indexed.
+     * Must be called before the first add(), while the hive has no pages.
+     *
+     * @param desc The indexed field and the type of the index.
+     * @return Success, NothingToDo if the field is already indexed, InvalidArgument if the
+     *         class has no State for the interface or the field does not fit in it, or Fail
+     *         if the hive already has pages.
+     */
+    virtual ReturnValue add_index(const HiveIndexDesc& desc) = 0;
+
+    /**
+     * @brief Visits every live object whose indexed field encodes to a key in [@p first, @p last].
+     *
+     * Keys are encoded with encode_hive_index_key(). A Hash index only supports lookups
+     * where @p first equals @p last. A Sorted index visits the objects in key order.
+     * The objects are collected under the hive lock and visited as in for_each_state(),
+     * so the visitor must not add or remove objects.
+     *
+     * @param interfaceUid Interface of the indexed field.
+     * @param field_offset Byte offset of the indexed field in the State.
+     * @param first Smallest key to visit.
+     * @param last Largest key to visit.
+     * @param context Opaque pointer forwarded to the visitor.
+     * @param visitor Called with (context, object, state_ptr). Return false to stop early.
+     * @return The number of objects visited, or 0 if no index matches.
+     */
+    virtual size_t find_indexed(Uid interfaceUid, size_t field_offset, uint64_t first, uint64_t last,
+                                void* context, StateVisitorFn visitor) const = 0;
+
+    /**
+     * @brief Returns the event fired with the objects that entered and left the hive.
+     *
+     * Changes are accumulated and delivered once per update() as a HiveMembershipChange
+     * argument, so caches kept over the hive (spatial grids, render lists) can be maintained
+     * incrementally without a callback per object. The hive starts recording when the event
+     * is first requested; earlier changes are not reported. Removed objects are kept alive
+     * until they have been delivered.
+     */
+    virtual IEvent::Ptr on_membership_changed() const = 0;
+
+    /**
+     * @brief Sets which threads may use the hive.
+     *
+     * A HiveThreading::SingleThread hive skips its lock on every operation, including the
+     * slot reclamation when the last reference to one of its objects drops. Everything that
+     * touches the hive or releases its objects must then run on one thread; debug builds log
+     * an error when a second thread takes the elided lock. Parallel iteration remains
+     * possible, as its workers do not lock. Change the mode only while no other thread
+     * uses the hive.
+     *
+     * @return Success, or Refused if the hive does not support @p threading.
+     */
+    virtual ReturnValue set_threading(HiveThreading threading) = 0;
+    /** @brief Returns the mode set with set_threading(). */
+    virtual HiveThreading get_threading() const = 0;
+};
+
+/** @brief Argument of IObjectHive::on_membership_changed(). */
+struct HiveMembershipChange
+{
+    IObjectHive* hive{}; ///< The hive that fired the event.
+    /** @brief Objects added since the previous delivery, in order. Valid during the event. */
+    array_view<IObject::Ptr> added;
+    /**
+     * @brief Objects removed or cleared since the previous delivery, in order. An object added
+     *        and removed between two deliveries is in both lists. Valid during the event.
+     */
+    array_view<IObject::Ptr> removed;
 };
 
 /**
@@ -167,6 +824,18 @@ public:
     /** @brief Allocates a slot and returns a pointer to uninitialized memory. */
     virtual void* allocate() = 0;
 
+    /**
+     * @brief Allocates @p count slots under a single lock acquisition.
+     *
+     * The slots are reserved up front, allocating at most one page that covers the
+     * whole shortfall. Slots of a fresh page are handed out in address order.
+     *
+     * @param count Number of slots to allocate.
+     * @param out Receives pointers to the uninitialized slots, must hold @p count elements.
+     * @return The number of slots allocated (0 if @p out is null).
+     */
+    virtual size_t allocate_n(size_t count, void** out) = 0;
+
     /** @brief Deallocates a slot. The caller must have already destroyed the object. */
     virtual void deallocate(void* ptr) = 0;
 
@@ -180,6 +849,77 @@ public:
      */
     virtual void for_each(void* context, RawVisitorFn visitor) const = 0;
 
+    /**
+     * @brief Parallel variant of for_each().
+     *
+     * Work is split and scheduled the same way as IObjectHive::for_each_state_parallel().
+     * The visitor is called concurrently and must be thread-safe.
+     *
+     * @param context Opaque pointer forwarded to the visitor.
+     * @param visitor Called for each active slot. Return false to stop early.
+     * @param executor Executor running the workers. If null, iterates on the calling thread.
+     */
+    virtual void for_each_parallel(void* context, RawVisitorFn visitor, IExecutor* executor) const = 0;
+
+    /**
+     * @brief Enables slot caching ("magazines") to reduce lock contention between threads.
+     *
+     * When enabled, each thread is mapped to one of a fixed set of magazines that cache
+     * up to @p slots free slots. allocate() and deallocate() are served from the calling
+     * thread's magazine under a shared lock, and only take the exclusive lock to refill an
+     * empty magazine or drain a full one. Cached slots are not active: the active bitmask
+     * stays authoritative, so for_each() and contains() never observe them.
+     *
+     * Pass 0 to disable caching (the default). Changing the size flushes all magazines.
+     *
+     * @param slots Maximum number of free slots cached per magazine.
+     */
+    virtual void set_magazine_size(size_t slots) = 0;
+
+    /** @brief Returns the magazine size set with set_magazine_size(), or 0 if disabled. */
+    virtual size_t get_magazine_size() const = 0;
+
+    /** @brief Returns all slots cached in magazines back to the shared page freelists. */
+    virtual void flush_magazines() = 0;
+
+    /** @brief Callback invoked by compact() after an element has been moved. */
+    using RelocateFn = void (*)(void* context, void* old_ptr, void* new_ptr);
+
+    /**
+     * @brief Moves live elements into as few pages as possible and frees the emptied pages.
+     *
+     * The fullest pages are kept and elements from the remaining pages are moved into their
+     * free slots. Elements are moved with memcpy, so they must be trivially relocatable.
+     * @p relocate is called after each move so that owners can patch references to the
+     * element; pointers to moved elements are invalid after the call. Slots cached in
+     * magazines are flushed first.
+     *
+     * @param context Opaque pointer forwarded to the relocate callback.
+     * @param relocate Called with (context, old_ptr, new_ptr) for each moved element. May be null.
+     * @return The number of pages freed.
+     */
+    virtual size_t compact(void* context, RelocateFn relocate) = 0;
+
+    /** @brief Ordering used by sort(): returns true if element @p lhs goes before element @p rhs. */
+    using LessFn = bool (*)(void* context, const void* lhs, const void* rhs);
+
+    /**
+     * @brief Reorders the live elements so that iteration visits them in @p less order.
+     *
+     * The elements are sorted (stably) and packed into the fewest, largest pages, which then
+     * come first in iteration order; the emptied pages are freed, so sorting also compacts
+     * the hive. Elements are moved with memcpy through a temporary copy of all live
+     * elements, so they must be trivially relocatable. @p relocate is called for each
+     * element whose address changed; pointers to moved elements are invalid after the call.
+     * Slots cached in magazines are flushed first.
+     *
+     * @param context Opaque pointer forwarded to both callbacks.
+     * @param less Strict weak ordering of the elements.
+     * @param relocate Called with (context, old_ptr, new_ptr) for each moved element. May be null.
+     * @return The number of elements moved.
+     */
+    virtual size_t sort(void* context, LessFn less, RelocateFn relocate) = 0;
+
     /** @brief Callback for per-element cleanup during clear(). */
     using DestroyFn = void (*)(void* context, void* element);
 
@@ -194,6 +934,66 @@ public:
      * @param destroy Called for each live element before its slot is reclaimed.
      */
     virtual void clear(void* context, DestroyFn destroy) = 0;
+
+    /**
+     * @brief Like clear(context, destroy), calling @p destroy on the tasks of @p executor.
+     *
+     * The pages are split into chunks destroyed in parallel under the exclusive lock, so
+     * @p destroy must be safe to call concurrently and must not access the hive.
+     *
+     * @param context Opaque pointer forwarded to the destroy callback.
+     * @param destroy Called for each live element before its slot is reclaimed. May be null.
+     * @param executor Executor running the destroy calls, or nullptr to run them on the calling thread.
+     * @param release Whether the pages are freed before returning or in the background.
+     */
+    virtual void clear_parallel(void* context, DestroyFn destroy, IExecutor* executor,
+                                HivePageRelease release) = 0;
+
+    /**
+     * @brief Writes the hive contents into a snapshot buffer.
+     *
+     * Every page is written verbatim with its active bitmask (see HiveSnapshotHeader),
+     * so the elements must be trivially copyable. Slots cached in magazines are written
+     * as free.
+     *
+     * @param buffer Receives the snapshot. May be null to query the size.
+     * @param size Size of @p buffer in bytes.
+     * @return The size of the snapshot in bytes. Nothing is written if it exceeds @p size.
+     */
+    virtual size_t snapshot(void* buffer, size_t size) const = 0;
+
+    /**
+     * @brief Replaces the hive contents with the elements of a snapshot.
+     *
+     * The current elements are discarded without destruction. The snapshot's live elements
+     * are copied in runs into a single new page sized to hold them all, so the restored hive
+     * is dense regardless of how fragmented the snapshotted one was.
+     *
+     * @param buffer A snapshot written by snapshot().
+     * @param size Size of @p buffer in bytes.
+     * @return Success, or InvalidArgument (leaving the hive unchanged) if @p buffer is not a
+     *         valid snapshot of a hive with the same element UID and size.
+     */
+    virtual ReturnValue restore(const void* buffer, size_t size) = 0;
+
+    /**
+     * @brief Replaces the hive contents with the pages of a mapped snapshot, in place.
+     *
+     * Unlike restore(), nothing is copied: every snapshot page becomes a hive page whose
+     * active bitmask and slots live in the copy-on-write mapping, so a snapshot of any size
+     * is adopted in time proportional to its page count. Elements keep their slot in the
+     * snapshot, and new elements first fill the free slots of the adopted pages, which are
+     * linked into the freelists when the pages are adopted. That writes to, and thereby
+     * copies, the OS pages holding free slots; a snapshot of a dense hive (e.g. one filled by
+     * restore()) is adopted without writing to the mapping at all.
+     *
+     * The current elements are discarded without destruction.
+     *
+     * @param mapping An open mapping of a file written from snapshot().
+     * @return Success, or InvalidArgument (leaving the hive unchanged) if the mapping does not
+     *         hold a valid snapshot of a hive with the same element UID and size.
+     */
+    virtual ReturnValue adopt(const IHiveSnapshotMapping::Ptr& mapping) = 0;
 };
 
 } // namespace velk
@@ -0,0 +1,103 @@
+#ifndef VELK_INTF_HIVE_PAGE_SOURCE_H
+#define VELK_INTF_HIVE_PAGE_SOURCE_H
+
+#include <velk/interface/intf_interface.h>
+#include <velk/interface/types.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace velk {
+
+namespace ClassId {
+/** @brief Page source mapping hive pages directly from the OS, using huge/large pages where available. */
+inline constexpr Uid VirtualMemoryPageSource{"3cd8311c-f29a-4ee2-873c-9bbb546138fc"};
+/** @brief Page source mapping hive pages from the OS with a NUMA placement policy (INumaPageSource). */
+inline constexpr Uid NumaPageSource{"b4f0b1d6-7c55-4d8e-9a43-2e61f07c9d1a"};
+} // namespace ClassId
+
+/**
+ * @brief Interface for a provider of the memory blocks that back hive pages.
+ *
+ * By default hives allocate their pages from the heap. A page source lets an
+ * application back them with other memory, e.g. huge pages to reduce TLB misses
+ * when iterating very large hives. If allocate_page() fails, the hive falls back
+ * to a heap allocation for that page.
+ *
+ * Pages hold a reference to the source that allocated them, so a source outlives
+ * every page it backs. free_page() may be called from any thread.
+ *
+ * @see ClassId::VirtualMemoryPageSource
+ */
+class IHivePageSource : public Interface<IHivePageSource>
+{
+public:
+    /**
+     * @brief Allocates a memory block for one hive page.
+     * @param size Size of the block in bytes.
+     * @param alignment Required alignment of the block, a power of two.
+     * @return The block, or nullptr on failure.
+     */
+    virtual void* allocate_page(size_t size, size_t alignment) = 0;
+
+    /**
+     * @brief Releases a block returned by allocate_page().
+     * @param page The block to release.
+     * @param size The size that was passed to allocate_page().
+     */
+    virtual void free_page(void* page, size_t size) = 0;
+};
+
+/** @brief Specifies where a NUMA page source places hive pages. */
+enum class NumaPolicy : uint8_t
+{
+    Local = 0,      ///< On the node of the thread that allocates the page, which also first touches it.
+    Interleave = 1, ///< Interleaved page by page over all nodes the process may use.
+    Node = 2,       ///< On an explicit node, falling back to other nodes when it runs out of memory.
+};
+
+/**
+ * @brief Page source that places hive pages on NUMA nodes.
+ *
+ * Pages remember the node reported by get_page_node(), and parallel hive iteration
+ * hands the chunks of each page to executor tasks running on that node first when
+ * the executor implements INumaExecutor. Assign a source per hive to give hives
+ * different policies.
+ *
+ * On systems without NUMA support the source behaves like ClassId::VirtualMemoryPageSource
+ * and reports every page on node 0.
+ *
+ * @see ClassId::NumaPageSource
+ */
+class INumaPageSource : public Interface<INumaPageSource, IHivePageSource>
+{
+public:
+    /**
+     * @brief Sets the placement policy for pages allocated from now on.
+     * @param policy The placement policy.
+     * @param node The target node for NumaPolicy::Node, ignored otherwise.
+     * @return InvalidArgument if @p policy is NumaPolicy::Node and @p node is not below get_node_count().
+     */
+    virtual ReturnValue set_policy(NumaPolicy policy, int node = 0) = 0;
+
+    /** @brief Returns the placement policy. */
+    virtual NumaPolicy get_policy() const = 0;
+
+    /** @brief Returns the target node of NumaPolicy::Node. */
+    virtual int get_node() const = 0;
+
+    /** @brief Returns the number of NUMA nodes in the system, at least 1. */
+    virtual size_t get_node_count() const = 0;
+
+    /**
+     * @brief Returns the node that a block returned by allocate_page() was placed on.
+     * @param page The block.
+     * @param size The size that was passed to allocate_page().
+     * @return The node, or -1 if the block spans several nodes.
+     */
+    virtual int get_page_node(const void* page, size_t size) const = 0;
+};
+
+} // namespace velk
+
+#endif // VELK_INTF_HIVE_PAGE_SOURCE_H
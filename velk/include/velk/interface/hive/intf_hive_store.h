@@ -29,6 +29,21 @@ public:
     /** @brief Returns the object hive for the given class UID, or nullptr if it does not exist. */
     virtual IObjectHive::Ptr find_hive(Uid classUid) const = 0;
 
+    /**
+     * @brief Returns the object hive for a class UID, creating a partitioned hive if it does not exist.
+     *
+     * A partitioned hive keeps one set of pages per partition, each with its own lock.
+     * Every thread adds objects to one partition, so threads spawning objects concurrently
+     * do not contend unless there are more threads than partitions. Removal, iteration and
+     * queries span all partitions, so the hive otherwise behaves like one from get_hive().
+     *
+     * @param classUid The class of the objects.
+     * @param partitions Number of partitions, typically the number of spawning threads.
+     *                   0 or 1 creates a regular hive.
+     * @return The hive, which is the existing one (partitioned or not) if the class already has a hive.
+     */
+    virtual IObjectHive::Ptr get_partitioned_hive(Uid classUid, size_t partitions) = 0;
+
     /** @brief Returns the raw hive for the given UID, creating it if it does not exist. */
     virtual IRawHive::Ptr get_raw_hive(Uid uid, size_t element_size, size_t element_align) = 0;
 
@@ -45,6 +60,19 @@ public:
      */
     virtual void for_each_hive(void* context, HiveVisitorFn visitor) const = 0;
 
+    /** @brief Returns the stats of all hives summed, plus the process-wide HiveStats::orphaned_pages. */
+    virtual HiveStats get_stats() const = 0;
+
+    /** @brief Returns the page source assigned to hives of this store, or nullptr for heap pages. */
+    virtual IHivePageSource::Ptr get_default_page_source() const = 0;
+
+    /**
+     * @brief Sets the page source of every hive in the store, including hives created later.
+     * @note Individual hives can still override it with IHive::set_page_source().
+     * @param source The page source to use, or nullptr to allocate pages from the heap.
+     */
+    virtual void set_default_page_source(const IHivePageSource::Ptr& source) = 0;
+
     /** @brief Returns the object hive for type T, creating it if it does not exist. */
     template <class T>
     IObjectHive::Ptr get_hive()
@@ -55,6 +83,15 @@ public:
         return get_hive(T::class_id());
     }
 
+    /** @brief Returns the object hive for type T, creating a partitioned hive if it does not exist. */
+    template <class T>
+    IObjectHive::Ptr get_partitioned_hive(size_t partitions)
+    {
+        static_assert(detail::has_class_id<T>::value,
+                      "T must be a registered Velk object type with class_id().");
+        return get_partitioned_hive(T::class_id(), partitions);
+    }
+
     /** @brief Returns the object hive for type T, or nullptr if it does not exist. */
     template <class T>
     IObjectHive::Ptr find_hive() const
@@ -34,7 +34,8 @@ public:
      * @param to The buffer to store the data to.
      * @param toSize Size of the buffer.
      * @param type Type which should be stored. Must be one of the values returned by get_compatible_types.
-     * @return Success if data was successfully stored, Fail otherwise.
+     * @return Success if data was successfully stored, Fail otherwise, including when @p type or
+     *         @p toSize does not match the data. copy_from() implementations rely on this check.
      */
     virtual ReturnValue get_data(void* to, size_t toSize, Uid type) const = 0;
     /**
@@ -28,6 +28,42 @@ public:
     virtual void clear_array() = 0;
     /** @brief Bulk-sets contents from a raw element buffer. */
     virtual ReturnValue set_from_buffer(const void* data, size_t count, Uid elementType) = 0;
+    /**
+     * @brief Overwrites @p count elements starting at @p index with the elements at @p data.
+     * @return Success, NothingToDo if the elements were equal, or InvalidArgument if the range is
+     *         out of bounds or @p elementType is not the element type.
+     */
+    virtual ReturnValue set_range(size_t index, const void* data, size_t count, Uid elementType) = 0;
+    /**
+     * @brief Inserts @p count elements from @p data before the element at @p index.
+     * @return Success, NothingToDo if @p count is 0, or InvalidArgument if @p index is past the end
+     *         or @p elementType is not the element type.
+     */
+    virtual ReturnValue insert_range(size_t index, const void* data, size_t count, Uid elementType) = 0;
+    /**
+     * @brief Erases @p count elements starting at @p index.
+     * @return Success, NothingToDo if @p count is 0, or InvalidArgument if the range is out of bounds.
+     */
+    virtual ReturnValue erase_range(size_t index, size_t count) = 0;
+    /**
+     * @brief Resizes to @p count elements, value-initializing new ones.
+     * @return Success, or NothingToDo if the size was already @p count.
+     */
+    virtual ReturnValue resize_array(size_t count) = 0;
+    /**
+     * @brief Returns the contiguous elements, or null if @p elementType is not the element type.
+     *
+     * The pointer is valid until the array is modified.
+     */
+    virtual const void* array_data(Uid elementType) const = 0;
+    /** @brief Returns the size of an element in bytes, or 0 if @p elementType is not the element type. */
+    virtual size_t array_element_size(Uid elementType) const = 0;
+    /**
+     * @brief Creates an owned array any of the same element type holding a copy of @p count
+     *        elements at @p data.
+     * @return The new any, or null if @p elementType is not the element type.
+     */
+    virtual IAny::Ptr create_array(const void* data, size_t count, Uid elementType) const = 0;
 };
 
 } // namespace velk
@@ -1,12 +1,52 @@
 #ifndef VELK_INTF_ARRAY_PROPERTY_H
 #define VELK_INTF_ARRAY_PROPERTY_H
 
+#include <velk/interface/intf_function.h>
 #include <velk/interface/intf_property.h>
 
+#include <cstdint>
+
 namespace velk {
 
-/** @brief Interface for array properties with element-level access. Inherits IProperty for whole-vector
- * get/set. */
+/** @brief What an ArrayChange did to its range of elements. */
+enum class ArrayChangeKind : uint8_t
+{
+    Inserted, ///< @c count elements were inserted before @c index.
+    Removed,  ///< @c count elements starting at @c index were erased.
+    Updated,  ///< @c count elements starting at @c index were overwritten.
+    Reset     ///< The whole array may have changed; @c count is its new size.
+};
+
+/**
+ * @brief A range of elements changed by an array property mutation.
+ *
+ * Indices refer to the array as it was when the change was applied, so a list of changes is
+ * replayed in order.
+ */
+struct ArrayChange
+{
+    ArrayChangeKind kind{ArrayChangeKind::Reset};
+    size_t index{};
+    size_t count{};
+};
+
+/**
+ * @brief Interface for array properties with element-level access. Inherits IProperty for whole-vector
+ * get/set.
+ *
+ * Each successful mutation fires on_changed once, so a range operation notifies once for any
+ * number of elements. Range operations take raw element buffers of the element type.
+ *
+ * on_changed carries the value as its first argument and a @c vector<ArrayChange> describing
+ * what changed since the previous notification as its second, see get_array_changes(). Changes
+ * are coalesced where possible; writes of the whole value report a single Reset.
+ *
+ * With a deferred @p type, an element operation is logged and applied in the next update(),
+ * where on_changed fires once for all the changes of the frame. Only the written elements are
+ * copied, and the operation returns Success; one that turns out to be invalid when applied,
+ * e.g. an index out of bounds, is skipped. A write of the whole value drops the operations
+ * logged before it.
+ */
 class IArrayProperty : public Interface<IArrayProperty, IProperty>
 {
 public:
@@ -15,13 +55,29 @@ public:
     /** @brief Reads the element at @p index into @p out. */
     virtual ReturnValue get_at(size_t index, IAny& out) const = 0;
     /** @brief Writes @p value to the element at @p index. */
-    virtual ReturnValue set_at(size_t index, const IAny& value) = 0;
+    virtual ReturnValue set_at(size_t index, const IAny& value, InvokeType type = Immediate) = 0;
     /** @brief Appends @p value to the end of the array. */
-    virtual ReturnValue push_back(const IAny& value) = 0;
+    virtual ReturnValue push_back(const IAny& value, InvokeType type = Immediate) = 0;
     /** @brief Erases the element at @p index. */
-    virtual ReturnValue erase_at(size_t index) = 0;
+    virtual ReturnValue erase_at(size_t index, InvokeType type = Immediate) = 0;
     /** @brief Removes all elements from the array. */
-    virtual void clear_array() = 0;
+    virtual void clear_array(InvokeType type = Immediate) = 0;
+    /** @brief Overwrites @p count elements starting at @p index. See IArrayAny::set_range(). */
+    virtual ReturnValue set_range(size_t index, const void* data, size_t count, Uid elementType,
+                                  InvokeType type = Immediate) = 0;
+    /** @brief Inserts @p count elements before @p index. See IArrayAny::insert_range(). */
+    virtual ReturnValue insert_range(size_t index, const void* data, size_t count, Uid elementType,
+                                     InvokeType type = Immediate) = 0;
+    /** @brief Erases @p count elements starting at @p index. See IArrayAny::erase_range(). */
+    virtual ReturnValue erase_range(size_t index, size_t count, InvokeType type = Immediate) = 0;
+    /** @brief Resizes the array to @p count elements. See IArrayAny::resize_array(). */
+    virtual ReturnValue resize_array(size_t count, InvokeType type = Immediate) = 0;
+    /**
+     * @brief Returns the contiguous elements, or null if @p elementType is not the element type.
+     *
+     * The pointer is valid until the array is modified.
+     */
+    virtual const void* array_data(Uid elementType) const = 0;
 };
 
 } // namespace velk
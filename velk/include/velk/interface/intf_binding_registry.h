@@ -0,0 +1,62 @@
+#ifndef VELK_INTF_BINDING_REGISTRY_H
+#define VELK_INTF_BINDING_REGISTRY_H
+
+#include <velk/array_view.h>
+#include <velk/interface/intf_function.h>
+#include <velk/interface/intf_property.h>
+#include <velk/interface/types.h>
+
+namespace velk {
+
+/**
+ * @brief Interface for one-way property bindings kept up to date by instance().update().
+ *
+ * A binding makes a target property follow one or more source properties, optionally through
+ * a transform. A change of a source marks the binding dirty; update() re-evaluates the dirty
+ * bindings after deferred property writes are applied. Bindings are evaluated in topological
+ * order, so a binding whose sources are targets of other bindings runs after them, and each
+ * binding is evaluated at most once per update() however often its sources change.
+ *
+ * A binding lives until it is replaced, unbound, or its target or a source is destroyed.
+ */
+class IBindingRegistry : public Interface<IBindingRegistry>
+{
+public:
+    /**
+     * @brief Binds @p target to @p sources and sets it to the bound value right away.
+     *
+     * Replaces an existing binding of @p target. Writing @p target directly does not remove
+     * the binding; the next change of a source overwrites the value.
+     *
+     * @param target The property to update.
+     * @param sources The properties the value is computed from.
+     * @param transform Called with the values of @p sources, returns the value to set. If null,
+     *                  @p sources must hold a single property whose value is copied.
+     * @return Success, or InvalidArgument if the arguments are invalid or the binding would
+     *         make @p target depend on itself.
+     */
+    virtual ReturnValue bind(const IProperty::Ptr& target, array_view<IProperty::ConstPtr> sources,
+                             const IFunction::ConstPtr& transform = {}) = 0;
+    /**
+     * @brief Removes the binding of @p target. The target keeps its current value.
+     * @return Success, or NothingToDo if @p target is not bound.
+     */
+    virtual ReturnValue unbind(const IProperty::ConstPtr& target) = 0;
+    /** @brief Returns true if @p target is bound. */
+    virtual bool is_bound(const IProperty::ConstPtr& target) const = 0;
+    /** @brief Returns the number of bindings whose target and sources are alive. */
+    virtual size_t get_binding_count() const = 0;
+    /**
+     * @brief Re-evaluates the dirty bindings now. Called by update().
+     *
+     * A binding marked dirty again by a change made during the pass, e.g. by an on_changed
+     * handler writing one of its sources, is evaluated by the next call.
+     *
+     * @return The number of bindings evaluated.
+     */
+    virtual size_t evaluate() = 0;
+};
+
+} // namespace velk
+
+#endif // VELK_INTF_BINDING_REGISTRY_H
@@ -1,6 +1,7 @@
 #ifndef VELK_INTF_EVENT_H
 #define VELK_INTF_EVENT_H
 
+#include <velk/array_view.h>
 #include <velk/common.h>
 #include <velk/interface/intf_function.h>
 #include <velk/interface/intf_interface.h>
@@ -19,8 +20,11 @@ class IEvent : public Interface<IEvent, IFunction>
 public:
     /**
      * @brief Adds a handler function for the event.
-     * @param fn Handler to register. A handler can only be added once.
+     * @param fn Handler to register. A handler can only be added once. A deferred handler that
+     *           implements IEventBatchHandler receives its invocations through handle_batch().
      * @param type Immediate handlers fire synchronously; Deferred handlers are queued for update().
+     *             DeferredCoalesced handlers run once per update() with the args of the latest
+     *             invocation of the event.
      */
     virtual ReturnValue add_handler(const IFunction::ConstPtr& fn, InvokeType type = Immediate) const = 0;
     /**
@@ -34,6 +38,34 @@ public:
     virtual bool has_handlers() const = 0;
 };
 
+/** @brief One invocation of an event, as delivered to IEventBatchHandler::handle_batch(). */
+struct EventBatchEntry
+{
+    const IEvent* source; ///< The event that was invoked.
+    FnArgs args;          ///< Cloned arguments of the invocation.
+};
+
+/**
+ * @brief Deferred event handler that receives all of its invocations of a frame in one call.
+ *
+ * Registered with IEvent::add_handler() as a Deferred or DeferredCoalesced handler, it is not
+ * invoked once per event firing. Instead update() calls handle_batch() once, after running
+ * the other deferred work, with every firing queued for it since the previous update() in
+ * queue order, across all the events it is registered to. A handler that reacts to many
+ * objects can then process their changes in one loop.
+ *
+ * @see ext::EventBatchHandler
+ */
+class IEventBatchHandler : public Interface<IEventBatchHandler, IFunction>
+{
+public:
+    /**
+     * @brief Handles a batch of event invocations.
+     * @param batch The invocations. The entries and their args are valid only during the call.
+     */
+    virtual void handle_batch(array_view<EventBatchEntry> batch) const = 0;
+};
+
 /**
  * @brief Invokes an event with null safety.
  * @param event Event to invoke.
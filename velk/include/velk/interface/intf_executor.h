@@ -0,0 +1,70 @@
+#ifndef VELK_INTF_EXECUTOR_H
+#define VELK_INTF_EXECUTOR_H
+
+#include <velk/interface/intf_interface.h>
+
+#include <cstddef>
+
+namespace velk {
+
+/**
+ * @brief Interface for a user-supplied job system used by Velk's parallel operations.
+ *
+ * Operations that can run in parallel (e.g. IObjectHive::for_each_state_parallel)
+ * split their work into tasks and hand them to an executor, so applications can
+ * reuse their existing job system, or the IThreadPool of IVelk::create_thread_pool().
+ *
+ * @code
+ * class MyExecutor : public ext::ObjectCore<MyExecutor, IExecutor>
+ * {
+ * public:
+ *     size_t get_concurrency() const override { return pool_.size(); }
+ *     void parallel_for(size_t count, void* context, TaskFn task) override
+ *     {
+ *         pool_.run_and_wait(count, [&](size_t i) { task(context, i); });
+ *     }
+ * };
+ * @endcode
+ */
+class IExecutor : public Interface<IExecutor>
+{
+public:
+    /** @brief Task callback. @p index is in [0, count) of the parallel_for() call. */
+    using TaskFn = void (*)(void* context, size_t index);
+
+    /** @brief Returns the number of tasks the executor can run concurrently. */
+    virtual size_t get_concurrency() const = 0;
+
+    /**
+     * @brief Runs @p task once for every index in [0, count) and waits for all of them to finish.
+     *
+     * Tasks may run concurrently on any thread, including the calling thread.
+     * Must not return before every task has completed.
+     *
+     * @param count Number of tasks to run.
+     * @param context Opaque pointer forwarded to each task.
+     * @param task Called with (context, index) for each index.
+     */
+    virtual void parallel_for(size_t count, void* context, TaskFn task) = 0;
+};
+
+/**
+ * @brief Executor whose tasks run on workers bound to NUMA nodes.
+ *
+ * Parallel hive iteration queries this interface on the executor it is given. When it
+ * is available, task @p index first processes pages on node get_task_node(index), placed
+ * by an INumaPageSource, and only then helps with pages on other nodes.
+ */
+class INumaExecutor : public Interface<INumaExecutor, IExecutor>
+{
+public:
+    /**
+     * @brief Returns the node that task @p index of parallel_for() runs on.
+     * @return The node, or -1 if the task may run on any node.
+     */
+    virtual int get_task_node(size_t index) const = 0;
+};
+
+} // namespace velk
+
+#endif // VELK_INTF_EXECUTOR_H
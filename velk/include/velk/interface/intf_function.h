@@ -7,13 +7,55 @@
 
 namespace velk {
 
-/** @brief Specifies whether an invocation should execute immediately or be deferred to update(). */
+/**
+ * @brief Specifies whether an invocation should execute immediately, be deferred to update() or run
+ *        on the thread pool.
+ *
+ * Pool applies to function invocations and future continuations, DeferredOnce to function
+ * invocations. Property sets and event handlers added with either are treated as Deferred.
+ */
 enum InvokeType : uint8_t
 {
-    Immediate = 0,
-    Deferred = 1
+    Immediate = 0,        ///< Executes now.
+    Deferred = 1,          ///< Queues for the next update() call; every invocation runs.
+    DeferredCoalesced = 2, ///< Like Deferred, but only the latest invocation per frame runs.
+    Pool = 3,              ///< Runs on a worker of IVelk::get_thread_pool(); every invocation runs.
+    DeferredOnce = 4       ///< Like Deferred, but invocations while one is queued are dropped.
+};
+
+/**
+ * @brief Priority lane of deferred work, combined with a deferred InvokeType as
+ *        @c Deferred @c | @c HighPriority.
+ *
+ * update() runs the high lane first and the background lane last, so under a time budget
+ * background work is the first to yield to the next frame.
+ */
+enum DeferredPriority : uint8_t
+{
+    NormalPriority = 0,    ///< Default lane.
+    HighPriority = 1,      ///< Runs before normal work, e.g. UI-critical callbacks.
+    BackgroundPriority = 2 ///< Runs after normal work, e.g. bulk bookkeeping.
 };
 
+/** @brief Number of DeferredPriority lanes. */
+constexpr size_t DEFERRED_PRIORITY_COUNT = 3;
+
+/** @brief Returns @p type queued in the @p priority lane. */
+constexpr InvokeType operator|(InvokeType type, DeferredPriority priority)
+{
+    return static_cast<InvokeType>(static_cast<uint8_t>(type) | static_cast<uint8_t>(priority << 4));
+}
+/** @brief Returns the invocation mode of @p type (Immediate, Deferred, DeferredCoalesced, Pool or DeferredOnce). */
+constexpr InvokeType invoke_mode(InvokeType type)
+{
+    return static_cast<InvokeType>(type & 0x0f);
+}
+/** @brief Returns the priority lane of @p type. */
+constexpr DeferredPriority invoke_priority(InvokeType type)
+{
+    return static_cast<DeferredPriority>(type >> 4);
+}
+
 /**
  * @brief Non-owning view of function arguments.
  *
@@ -46,6 +88,15 @@ public:
     using BoundFn = IAny::Ptr(void* context, FnArgs);
     /** @brief Function pointer type for deleting an owned context. */
     using ContextDeleter = void(void*);
+    /**
+     * @brief Function pointer type for typed trampolines.
+     *
+     * Calls a typed target with @p args pointing to values of its parameter types and writes
+     * its return value into @p result, which points to storage of the return type or is null.
+     */
+    using TypedFn = void(void* context, const void* const* args, void* result);
+    /** @brief Function pointer type for trampolines that write the return value into @p result. */
+    using ResultFn = ReturnValue(void* context, FnArgs args, IAny& result);
     /**
      * @brief Called to invoke the function.
      * @param args Call args as a non-owning view.
@@ -53,6 +104,32 @@ public:
      * @return Typed result (nullptr = void/no result).
      */
     virtual IAny::Ptr invoke(FnArgs args, InvokeType type = Immediate) const = 0;
+    /**
+     * @brief Invokes the function immediately through typed trampoline @p typed, without boxing.
+     *
+     * Succeeds only if the function is bound to @p typed, so the caller knows the parameter and
+     * return types that @p args and @p result must point to. Used by TypedFunction, which falls
+     * back to invoke() otherwise.
+     *
+     * @param typed The typed trampoline the caller expects the function to be bound to.
+     * @param args Pointers to the argument values.
+     * @param result Storage for the return value, or null to discard it.
+     * @return true if the function was bound to @p typed and has been called.
+     */
+    virtual bool invoke_typed(TypedFn* typed, const void* const* args, void* result) const = 0;
+    /**
+     * @brief Invokes the function immediately and writes its return value into @p result.
+     *
+     * Lets a caller reuse one result object across calls instead of receiving a new IAny::Ptr
+     * from each invoke(). Functions declared with @c FN write the value straight into @p result;
+     * others copy it from the result of invoke().
+     *
+     * @param args Call args as a non-owning view.
+     * @param result Receives the return value.
+     * @return Success if a value was written, NothingToDo if the function returned nothing, or
+     *         the error of writing the value into @p result (e.g. a type mismatch).
+     */
+    virtual ReturnValue invoke_into(FnArgs args, IAny& result) const = 0;
 };
 
 /**
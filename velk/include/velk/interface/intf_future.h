@@ -19,13 +19,14 @@ public:
     virtual bool is_ready() const = 0;
     /** @brief Blocks the calling thread until the result is available. */
     virtual void wait() const = 0;
-    /** @brief Returns the result if ready, nullptr otherwise. */
+    /** @brief Returns the result if ready, nullptr otherwise or if cancelled. */
     virtual const IAny* get_result() const = 0;
     /**
      * @brief Adds a continuation to be invoked when the result is set.
      *
      * If the future is already ready the continuation fires immediately (for Immediate type)
-     * or is queued (for Deferred type). The continuation receives the result as a single FnArgs element.
+     * or is queued (for Deferred type). The continuation receives the result as a single FnArgs element,
+     * which refers to the stored result rather than a copy of it.
      *
      * @param fn The continuation function.
      * @param type Immediate fires synchronously; Deferred queues via instance().queue_deferred_tasks().
@@ -35,14 +36,29 @@ public:
     /**
      * @brief Adds a continuation and returns a chained future that resolves with its result.
      *
-     * The continuation's IAny::Ptr return value becomes the chained future's result.
-     * nullptr results resolve as void.
+     * The continuation's IAny::Ptr return value becomes the chained future's result, adopted
+     * without a copy, so a continuation returning an any it keeps changing should return a
+     * clone of it. nullptr results resolve as void.
      *
      * @param fn The continuation function.
      * @param type Immediate fires synchronously; Deferred queues via instance().queue_deferred_tasks().
      * @return A new IFuture that resolves when the continuation completes.
      */
     virtual IFuture::Ptr then(const IFunction::ConstPtr& fn, InvokeType type = Immediate) = 0;
+
+    /**
+     * @brief Abandons the future: it resolves without a result and its continuations are dropped.
+     *
+     * The futures chained by then() are cancelled in turn, so cancelling the head of a chain
+     * drops every step that has not run yet. A then() step whose own chained future was
+     * cancelled is skipped as well. Producers and long-running continuations can poll
+     * is_cancelled() to stop early. @c when_all and @c when_any count a cancelled input as ready.
+     *
+     * @return Success if cancelled, NothingToDo if the future was already resolved or cancelled.
+     */
+    virtual ReturnValue cancel() = 0;
+    /** @brief Returns true if cancel() resolved the future. is_ready() is then true as well. */
+    virtual bool is_cancelled() const = 0;
 };
 
 /**
@@ -61,6 +77,17 @@ public:
      * @return Success on first call, NothingToDo if already resolved.
      */
     virtual ReturnValue set_result(const IAny* result) = 0;
+
+    /**
+     * @brief Resolves the future with @p result, adopting it instead of cloning.
+     *
+     * The caller must not modify the value afterwards, as continuations and get_result() read
+     * it in place. Can only be called once; subsequent calls return NothingToDo.
+     *
+     * @param result The value to resolve with, or nullptr for void.
+     * @return Success on first call, NothingToDo if already resolved.
+     */
+    virtual ReturnValue set_result(IAny::Ptr&& result) = 0;
 };
 
 } // namespace velk
@@ -1,10 +1,16 @@
 #ifndef VELK_INTF_HIERARCHY_H
 #define VELK_INTF_HIERARCHY_H
 
+#include <velk/array_view.h>
+#include <velk/interface/intf_executor.h>
 #include <velk/interface/intf_metadata.h>
 #include <velk/interface/intf_object.h>
 #include <velk/vector.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
 namespace velk {
 
 class IHierarchy;
@@ -26,7 +32,9 @@ struct HierarchyChange
         Insert,  ///< Child inserted at index. parent, child, index set.
         Remove,  ///< Subtree removed. parent, child set. child is subtree root.
         Replace, ///< In-place replacement. parent, child (new), old_child set.
-        Clear    ///< All objects removed.
+        Clear,   ///< All objects removed.
+        AddBatch, ///< Objects added in one batch under parent. parent, children set.
+        Batch     ///< Changes made between IHierarchy::begin_batch() and end_batch(). changes set.
     };
 
     Type type{};
@@ -35,15 +43,203 @@ struct HierarchyChange
     IObject::Ptr child;
     IObject::Ptr old_child;
     size_t index{};
+    /** @brief AddBatch: the added objects, parents before their children. Valid during the event. */
+    array_view<IObject::Ptr> children;
+    /**
+     * @brief Batch: the changes made during the batch, in order, with no hierarchy set. Valid
+     *        during the event.
+     */
+    array_view<HierarchyChange> changes;
 
     friend bool operator==(const HierarchyChange& a, const HierarchyChange& b)
     {
         return a.type == b.type && a.hierarchy.lock() == b.hierarchy.lock() && a.parent == b.parent &&
-               a.child == b.child && a.old_child == b.old_child && a.index == b.index;
+               a.child == b.child && a.old_child == b.old_child && a.index == b.index &&
+               a.children.begin() == b.children.begin() && a.children.size() == b.children.size() &&
+               a.changes.begin() == b.changes.begin() && a.changes.size() == b.changes.size();
     }
     friend bool operator!=(const HierarchyChange& a, const HierarchyChange& b) { return !(a == b); }
 };
 
+/**
+ * @brief Read-only view of an object's children that holds the hierarchy's read lock.
+ *
+ * Iterates the children where the hierarchy stores them, without copying them or touching their
+ * reference counts. Mutations of the hierarchy wait until the view is destroyed, so the view
+ * must not be kept across frames, and the thread holding it must not mutate the hierarchy or
+ * query it while another thread may be waiting to mutate it. The view must not outlive the
+ * hierarchy. Move-only.
+ *
+ *   for (auto& child : hierarchy->view_children(parent)) { ... }
+ */
+class ChildrenView
+{
+public:
+    /** @brief Where the children are stored, filled in by IHierarchy implementations. */
+    struct Layout
+    {
+        const char* base = nullptr;           ///< Address of the child at index 0.
+        size_t stride = sizeof(IObject::Ptr); ///< Bytes from one element to the next.
+        /**
+         * @brief Offset from each child to the uint32_t index of the next child, UINT32_MAX after
+         *        the last, or -1 if the children are the first @c count elements.
+         */
+        ptrdiff_t next_offset = -1;
+        uint32_t first = 0; ///< Index of the first child if linked.
+        size_t count = 0;   ///< Number of children.
+    };
+    /** @brief Releases the read lock @p lock. */
+    using UnlockFn = void (*)(const void* lock);
+
+    /** @brief Forward iterator over the children. */
+    class iterator
+    {
+    public:
+        using value_type = IObject::Ptr;
+        using reference = const IObject::Ptr&;
+        using pointer = const IObject::Ptr*;
+        using difference_type = ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        reference operator*() const { return *get(); }
+        pointer operator->() const { return get(); }
+        iterator& operator++()
+        {
+            index_ = layout_->next_offset < 0
+                         ? index_ + 1
+                         : *reinterpret_cast<const uint32_t*>(reinterpret_cast<const char*>(get()) +
+                                                              layout_->next_offset);
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+        friend bool operator==(const iterator& a, const iterator& b) { return a.index_ == b.index_; }
+        friend bool operator!=(const iterator& a, const iterator& b) { return a.index_ != b.index_; }
+
+    private:
+        friend class ChildrenView;
+        iterator(const Layout* layout, size_t index) : layout_(layout), index_(index) {}
+        pointer get() const { return reinterpret_cast<pointer>(layout_->base + index_ * layout_->stride); }
+
+        const Layout* layout_;
+        size_t index_;
+    };
+
+    /** @brief Constructs an empty view that holds no lock. */
+    ChildrenView() = default;
+    /** @brief Constructs a view of the children at @p layout, releasing @p lock with @p unlock. */
+    ChildrenView(const Layout& layout, const void* lock, UnlockFn unlock)
+        : layout_(layout), lock_(lock), unlock_(unlock)
+    {}
+    ChildrenView(ChildrenView&& other) noexcept
+        : layout_(other.layout_), lock_(other.lock_), unlock_(other.unlock_)
+    {
+        other.layout_ = {};
+        other.unlock_ = nullptr;
+    }
+    ChildrenView& operator=(ChildrenView&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            layout_ = other.layout_;
+            lock_ = other.lock_;
+            unlock_ = other.unlock_;
+            other.layout_ = {};
+            other.unlock_ = nullptr;
+        }
+        return *this;
+    }
+    ChildrenView(const ChildrenView&) = delete;
+    ChildrenView& operator=(const ChildrenView&) = delete;
+    ~ChildrenView() { release(); }
+
+    iterator begin() const { return {&layout_, layout_.count ? first() : end_index()}; }
+    iterator end() const { return {&layout_, end_index()}; }
+    /** @brief Returns the number of children. */
+    size_t size() const { return layout_.count; }
+    /** @brief Returns true if there are no children. */
+    bool empty() const { return layout_.count == 0; }
+
+    /** @brief Releases the read lock early. The view is empty afterwards. */
+    void release()
+    {
+        if (unlock_) {
+            unlock_(lock_);
+            unlock_ = nullptr;
+        }
+        layout_ = {};
+    }
+
+private:
+    size_t first() const { return layout_.next_offset < 0 ? 0 : layout_.first; }
+    size_t end_index() const { return layout_.next_offset < 0 ? layout_.count : UINT32_MAX; }
+
+    Layout layout_;
+    const void* lock_ = nullptr;
+    UnlockFn unlock_ = nullptr;
+};
+
+/** @brief Order in which IHierarchy::traverse() visits a subtree. */
+enum class TraversalOrder : uint8_t
+{
+    PreOrder, ///< Parents before their children.
+    PostOrder ///< Children before their parents.
+};
+
+/** @brief How IHierarchy::traverse_parallel() splits a subtree into tasks. */
+struct ParallelTraversalConfig
+{
+    /**
+     * @brief Depth below the traversed object at which subtrees become units of work. The objects
+     *        above it are visited on the calling thread. Values below 1 count as 1.
+     */
+    uint32_t splitDepth = 1;
+    /**
+     * @brief Objects a task visits at least: consecutive subtrees are grouped into one task until
+     *        they reach this size, and into no more than about four tasks per executor thread.
+     */
+    uint32_t minTaskSize = 256;
+};
+
+/**
+ * @brief Immutable, versioned view of a hierarchy, published by IHierarchy::commit_snapshot().
+ *
+ * Queries take no lock and never change, so any thread may read a snapshot while the hierarchy
+ * is mutated. They return references into the snapshot, valid while it is alive, so reading
+ * does not touch the objects' reference counts either. A snapshot keeps the objects it lists
+ * alive, including those removed from the hierarchy since.
+ *
+ * Chain: IInterface -> IHierarchySnapshot
+ */
+class IHierarchySnapshot : public Interface<IHierarchySnapshot>
+{
+public:
+    /** @brief Returns the version, one more than that of the previous snapshot of the hierarchy. */
+    virtual uint64_t version() const = 0;
+
+    /** @brief Returns the root object, or null if the hierarchy was empty. */
+    virtual const IObject::Ptr& root() const = 0;
+
+    /** @brief Returns the parent of the given object, or null if root or not in the snapshot. */
+    virtual const IObject::Ptr& parent_of(const IObject::Ptr& object) const = 0;
+
+    /** @brief Returns the children of the given object, empty if not in the snapshot. */
+    virtual array_view<IObject::Ptr> children_of(const IObject::Ptr& object) const = 0;
+
+    /** @brief Returns the number of children of the given object. */
+    virtual size_t child_count(const IObject::Ptr& object) const = 0;
+
+    /** @brief Returns true if the object is in the snapshot. */
+    virtual bool contains(const IObject::Ptr& object) const = 0;
+
+    /** @brief Returns the number of objects in the snapshot (including root). */
+    virtual size_t size() const = 0;
+};
+
 /**
  * @brief Manages a single-root tree of IObject references.
  *
@@ -70,6 +266,29 @@ public:
     /** @brief Inserts a child at the given index under the parent. */
     virtual ReturnValue insert(const IObject::Ptr& parent, size_t index, const IObject::Ptr& child) = 0;
 
+    /** @brief parents value of add_subtree() for the objects added directly under the parent. */
+    static constexpr uint32_t OUTER_PARENT = UINT32_MAX;
+
+    /**
+     * @brief Appends children to the given parent in one batch.
+     *
+     * Equivalent to add() for each child, but takes the lock once and fires a single
+     * HierarchyChange::Type::AddBatch event. The batch is added entirely or not at all:
+     * IHierarchyAware::on_hierarchy_joining is asked for every child first, and a refusal fails
+     * the batch with ReturnValue::Refused.
+     */
+    virtual ReturnValue add_children(const IObject::Ptr& parent, array_view<IObject::Ptr> children) = 0;
+
+    /**
+     * @brief Adds a subtree under the given parent in one batch, like add_children().
+     * @param parent The object the subtree is added under.
+     * @param objects The objects to add.
+     * @param parents For each object, the index in @p objects of its parent, which must be lower
+     *                than the object's own index, or OUTER_PARENT to append it to @p parent.
+     */
+    virtual ReturnValue add_subtree(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                                    array_view<uint32_t> parents) = 0;
+
     /** @brief Removes an object and all its descendants from the hierarchy. */
     virtual ReturnValue remove(const IObject::Ptr& object) = 0;
 
@@ -91,6 +310,14 @@ public:
     /** @brief Returns the children of the given object. */
     virtual vector<IObject::Ptr> children_of(const IObject::Ptr& object) const = 0;
 
+    /**
+     * @brief Returns a view of the children of the given object, holding the read lock.
+     *
+     * Unlike children_of(), nothing is copied; see ChildrenView for the locking rules. The view
+     * is empty and holds no lock if the object is not in the hierarchy.
+     */
+    virtual ChildrenView view_children(const IObject::Ptr& object) const = 0;
+
     /** @brief Returns the child at the given index, or null if out of range. */
     virtual IObject::Ptr child_at(const IObject::Ptr& object, size_t index) const = 0;
 
@@ -106,11 +333,114 @@ public:
     using ChildVisitorFn = bool (*)(void* context, const IObject::Ptr& child);
     virtual void for_each_child(const IObject::Ptr& object, void* context, ChildVisitorFn visitor) const = 0;
 
+    /**
+     * @brief Visits the given object and its descendants depth-first.
+     *
+     * The subtree is captured under a single lock acquisition and visited outside the lock, so
+     * the visitor may mutate the hierarchy; it sees the subtree as it was when traverse() began.
+     *
+     * @param object The subtree root.
+     * @param order Whether parents are visited before or after their children.
+     * @param context Opaque pointer forwarded to the visitor.
+     * @param visitor Called for each object with its depth, 0 for the hierarchy root.
+     *                Return false to stop early.
+     */
+    using SubtreeVisitorFn = bool (*)(void* context, const IObject::Ptr& object, size_t depth);
+    virtual void traverse(const IObject::Ptr& object, TraversalOrder order, void* context,
+                          SubtreeVisitorFn visitor) const = 0;
+
+    /**
+     * @brief Visits the given object and its descendants like traverse(), on an executor.
+     *
+     * The subtrees at ParallelTraversalConfig::splitDepth below @p object are visited by the
+     * executor's tasks, each depth-first in @p order; the objects above them are visited on the
+     * calling thread, before the tasks start for PreOrder and after they finish for PostOrder.
+     * So an object is still visited before (PreOrder) or after (PostOrder) all its descendants,
+     * but the visitor is called concurrently for objects in different subtrees and must be
+     * thread-safe. Like traverse(), the subtree is visited from a snapshot taken under a single
+     * lock acquisition, so concurrent mutations do not affect it.
+     *
+     * A visitor returning false stops the traversal; tasks already running stop at their next
+     * object.
+     *
+     * @param executor Executor running the tasks. If null, visits on the calling thread.
+     */
+    virtual void traverse_parallel(const IObject::Ptr& object, TraversalOrder order, IExecutor* executor,
+                                   const ParallelTraversalConfig& config, void* context,
+                                   SubtreeVisitorFn visitor) const = 0;
+
     /** @brief Returns true if the object is in this hierarchy. */
     virtual bool contains(const IObject::Ptr& object) const = 0;
 
     /** @brief Returns the total number of objects in this hierarchy (including root). */
     virtual size_t size() const = 0;
+
+    /**
+     * @brief Makes the @p target property of every object inherit from its parent.
+     *
+     * Each object's @p target is set to @p combine called with the parent's @p target and the
+     * object's own @p source, e.g. a world transform from the parent's world transform and the
+     * local one. The root, and objects whose parent has no @p target, take their @p source as is.
+     * Objects lacking either property are skipped.
+     *
+     * The values are kept up to date with property bindings (see IBindingRegistry): when a
+     * @p source changes, update() recomputes only the affected descendants, once each, parents
+     * before children, and stops below objects whose value did not change. Adding, removing
+     * and replacing objects updates the bindings, so a hierarchy with inherited properties is
+     * meant to be mutated on the thread calling update(). Replaces an existing declaration of
+     * @p target.
+     *
+     * @return Success, or InvalidArgument if a name is empty, the names are equal or
+     *         @p combine is null.
+     */
+    virtual ReturnValue add_inherited(string_view source, string_view target,
+                                      const IFunction::ConstPtr& combine) = 0;
+
+    /**
+     * @brief Stops @p target from being inherited. The objects keep their current values.
+     * @return Success, or NothingToDo if @p target is not inherited.
+     */
+    virtual ReturnValue remove_inherited(string_view target) = 0;
+
+    /**
+     * @brief Publishes the current tree as a new snapshot, returned by snapshot() from then on.
+     *
+     * Meant to be called by the thread mutating the hierarchy, e.g. once per frame. A snapshot
+     * shares the unchanged part of its storage with the previous one, so publishing costs about
+     * the objects whose position changed since, not the size of the tree. Returns the current
+     * version without publishing if nothing changed.
+     *
+     * @return The version of the published snapshot.
+     */
+    virtual uint64_t commit_snapshot() = 0;
+
+    /**
+     * @brief Returns the last snapshot published by commit_snapshot(), or null if none.
+     *
+     * Takes no lock and never waits for a mutation or a commit in progress.
+     */
+    virtual IHierarchySnapshot::Ptr snapshot() const = 0;
+
+    /**
+     * @brief Starts a batch of changes. Batches nest; the outermost one ends the batch.
+     *
+     * Until the batch ends, mutations fire neither on_changing nor on_changed. Their changes are
+     * recorded instead and delivered together by end_batch(), so that handlers can process any
+     * number of mutations in one pass. The batch covers mutations from every thread. The
+     * IHierarchyAware callbacks are not deferred.
+     */
+    virtual void begin_batch() = 0;
+
+    /**
+     * @brief Ends a batch started by begin_batch().
+     *
+     * Ending the outermost batch fires on_changed once with a HierarchyChange::Type::Batch change
+     * listing the changes made during the batch, if there were any. Changes made while on_changed
+     * had no handler are not recorded.
+     *
+     * @return Success, or NothingToDo if no batch was started.
+     */
+    virtual ReturnValue end_batch() = 0;
 };
 
 /**
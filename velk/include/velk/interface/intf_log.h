@@ -4,6 +4,17 @@
 #include <velk/interface/intf_interface.h>
 #include <velk/velk_export.h>
 
+/**
+ * @def VELK_LOG_MIN_LEVEL
+ * @brief Lowest LogLevel, as an integer, whose VELK_LOG calls are compiled in.
+ *
+ * VELK_LOG calls below it compile to nothing, arguments included. Set by the VELK_LOG_MIN_LEVEL
+ * CMake option; defaults to 0, which keeps all levels.
+ */
+#ifndef VELK_LOG_MIN_LEVEL
+#define VELK_LOG_MIN_LEVEL 0
+#endif
+
 namespace velk {
 
 /** @brief Severity levels for log messages (ordered lowest to highest). */
@@ -28,6 +39,29 @@ public:
     virtual void write(LogLevel level, const char* file, int line, const char* message) = 0;
 };
 
+/**
+ * @brief Log sink that queues messages and delivers them to another sink on a background thread.
+ *
+ * write() copies the message into a lock-free ring buffer and returns without blocking, so that
+ * threads logging in bursts do not stall on I/O. A message that finds the buffer full is dropped
+ * and counted. Messages are delivered in the order their writes claimed a slot; file name and
+ * message are truncated to fit a slot of 512 bytes.
+ *
+ * Created with ILog::create_async_sink() and installed with ILog::set_sink(). Releasing the last
+ * reference delivers the queued messages, then joins the thread.
+ */
+class IAsyncLogSink : public Interface<IAsyncLogSink, ILogSink>
+{
+public:
+    /**
+     * @brief Blocks until the messages written before the call have been delivered.
+     * @note Must not be called from the target sink, which runs on the background thread.
+     */
+    virtual void flush() = 0;
+    /** @brief Returns the number of messages dropped because the buffer was full. */
+    virtual size_t get_dropped_count() const = 0;
+};
+
 /**
  * @brief Logging interface exposed by the velk instance.
  *
@@ -52,12 +86,26 @@ public:
      * Callers should generally use the VELK_LOG macro instead of calling this directly.
      */
     virtual void dispatch(LogLevel level, const char* file, int line, const char* message) = 0;
+    /**
+     * @brief Creates an asynchronous sink delivering to @p target.
+     * @param target Sink the messages are delivered to; empty for the default stderr output.
+     * @param capacity Messages the buffer holds, rounded up to a power of two; 0 for 256.
+     */
+    virtual IAsyncLogSink::Ptr create_async_sink(const ILogSink::Ptr& target = {},
+                                                 size_t capacity = 0) const = 0;
 };
 
 namespace detail {
 
+/** @brief Returns true if VELK_LOG calls of @p level are compiled in, see VELK_LOG_MIN_LEVEL. */
+constexpr bool log_compiled(LogLevel level)
+{
+    return static_cast<int32_t>(level) >= VELK_LOG_MIN_LEVEL;
+}
+
 /**
- * @brief Formats and dispatches a log message through @p log.
+ * @brief Formats and dispatches a log message through @p log, unless @p level is below the
+ *        level of @p log.
  * @note Usually not called directly; use VELK_LOG from api/velk.h instead.
  */
 VELK_EXPORT void velk_log(ILog& log, LogLevel level, const char* file, int line, const char* fmt, ...);
@@ -17,12 +17,33 @@
 #include <velk/interface/member_desc.h>
 #include <velk/vector.h>
 
+#include <atomic>
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
 #include <utility>
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
 namespace velk {
 
+/**
+ * @brief Layout of the State struct of one interface (see IPropertyState::get_state_layouts()).
+ *
+ * The hash changes whenever a member of the State is added, removed, renamed, reordered or
+ * changes its type, so a State saved as a block can be checked against the running build.
+ */
+struct StateLayout
+{
+    Uid interfaceUid;   ///< Interface declaring the State.
+    size_t size{};      ///< sizeof the State.
+    size_t alignment{}; ///< alignof the State.
+    uint64_t hash{};    ///< Hash of the State's members, see the VELK_INTERFACE state_layout_hash.
+    bool trivial{};     ///< The State is trivially copyable and can be copied as one block.
+};
+
 /**
  * @brief Interface for accessing per-interface property state structs.
  *
@@ -35,6 +56,9 @@ public:
     /** @brief Returns a pointer to the State struct for the given interface UID, or nullptr. */
     virtual void* get_property_state(Uid interfaceUid) = 0;
 
+    /** @brief Returns the layout of each State struct of the object, in interface order. */
+    virtual array_view<StateLayout> get_state_layouts() const = 0;
+
     /**
      * @brief Type-safe state access. Returns a typed pointer to T::State.
      * @tparam T The interface type whose State struct to retrieve.
@@ -53,8 +77,220 @@ public:
     }
 };
 
+/**
+ * @brief Sequence counter that an interface declaring SEQLOCK adds to its State struct.
+ *
+ * The counter is odd while a write is in progress. Writers bump it through write_state(),
+ * property writes and COMPUTED cache refreshes; readers on other threads take a consistent
+ * copy of the State with read_state_consistent(), retrying when the counter moved during
+ * the copy. Writes must come from one thread at a time. Nested writes on that thread bump
+ * the counter only at the outermost level. Copying a State does not copy its counter.
+ */
+class StateSeqlock
+{
+public:
+    StateSeqlock() = default;
+    StateSeqlock(const StateSeqlock&) noexcept {}
+    StateSeqlock& operator=(const StateSeqlock&) noexcept { return *this; }
+
+    /** @brief Marks the start of a write; the counter becomes odd. */
+    void begin_write() noexcept
+    {
+        if (depth_++ == 0) {
+            sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+    }
+
+    /** @brief Marks the end of a write; the counter becomes even again. */
+    void end_write() noexcept
+    {
+        if (--depth_ == 0) {
+            sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+    }
+
+    /** @brief Waits until no write is in progress and returns the counter to pass to read_retry(). */
+    uint32_t read_begin() const noexcept
+    {
+        uint32_t sequence;
+        while ((sequence = sequence_.load(std::memory_order_acquire)) & 1u) {
+        }
+        return sequence;
+    }
+
+    /** @brief Returns true if a write started since read_begin() returned @p sequence. */
+    bool read_retry(uint32_t sequence) const noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence_.load(std::memory_order_relaxed) != sequence;
+    }
+
+    /** @brief Returns the current counter, which counts twice the completed writes. */
+    uint32_t sequence() const noexcept { return sequence_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Copies @p size bytes from @p src to @p dst with relaxed atomic loads.
+     *
+     * For the copy between read_begin() and read_retry(), which a write may overlap: unlike a
+     * plain copy, the loads do not race with the stores of the writer. @p src must be 4-byte
+     * aligned and @p size a multiple of 4.
+     */
+    static void load_bytes(void* dst, const void* src, size_t size) noexcept
+    {
+        auto* from = static_cast<const uint32_t*>(src);
+        auto* to = static_cast<char*>(dst);
+        for (size_t i = 0; i < size / sizeof(uint32_t); ++i) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            auto word = static_cast<uint32_t>(__iso_volatile_load32(reinterpret_cast<const volatile int*>(from + i)));
+#else
+            uint32_t word = __atomic_load_n(from + i, __ATOMIC_RELAXED);
+#endif
+            std::memcpy(to + i * sizeof(uint32_t), &word, sizeof(word));
+        }
+    }
+
+    /**
+     * @brief Copies @p size bytes from @p src to @p dst with relaxed atomic stores.
+     *
+     * The counterpart of load_bytes() for the writer, called between begin_write() and
+     * end_write(). Each 4-byte word covering @p dst is read, merged and stored only if it
+     * changed, so the words must lie within the State and be written by this thread alone.
+     */
+    static void store_bytes(void* dst, const void* src, size_t size) noexcept
+    {
+        auto address = reinterpret_cast<uintptr_t>(dst);
+        auto* word = reinterpret_cast<uint32_t*>(address & ~uintptr_t(3));
+        auto* from = static_cast<const char*>(src);
+        size_t offset = address & 3;
+        while (size) {
+            size_t n = sizeof(uint32_t) - offset < size ? sizeof(uint32_t) - offset : size;
+#if defined(_MSC_VER) && !defined(__clang__)
+            auto old = static_cast<uint32_t>(__iso_volatile_load32(reinterpret_cast<const volatile int*>(word)));
+#else
+            uint32_t old = __atomic_load_n(word, __ATOMIC_RELAXED);
+#endif
+            uint32_t next = old;
+            std::memcpy(reinterpret_cast<char*>(&next) + offset, from, n);
+            if (next != old) {
+#if defined(_MSC_VER) && !defined(__clang__)
+                __iso_volatile_store32(reinterpret_cast<volatile int*>(word), static_cast<int>(next));
+#else
+                __atomic_store_n(word, next, __ATOMIC_RELAXED);
+#endif
+            }
+            ++word;
+            from += n;
+            size -= n;
+            offset = 0;
+        }
+    }
+
+    /** @brief Stores @p value into @p dst with store_bytes(). */
+    template <class V>
+    static void store(V* dst, const V& value) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<V>, "StateSeqlock::store needs a trivially copyable type");
+        store_bytes(dst, &value, sizeof(V));
+    }
+
+private:
+    std::atomic<uint32_t> sequence_{0};
+    uint32_t depth_{0}; ///< Write nesting depth, touched only by the writing thread.
+};
+
 namespace detail {
 
+/** @brief Compile-time FNV-1a 64-bit accumulator used for the State layout hash. */
+struct LayoutHash
+{
+    uint64_t value{14695981039346656037ull};
+
+    constexpr LayoutHash mix(uint64_t v) const
+    {
+        LayoutHash h{value};
+        for (int i = 0; i < 8; ++i) {
+            h.value = (h.value ^ ((v >> (i * 8)) & 0xff)) * 1099511628211ull;
+        }
+        return h;
+    }
+    constexpr LayoutHash add(size_t size, size_t alignment) const
+    {
+        return mix(size).mix(alignment);
+    }
+    constexpr LayoutHash add(string_view name, Uid type) const
+    {
+        LayoutHash h{value};
+        for (char c : name) {
+            h.value = (h.value ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+        }
+        return h.mix(type.hi).mix(type.lo);
+    }
+};
+
+/** @brief True if @p State was declared with a SEQLOCK member. */
+template <class State, class = void>
+struct has_state_seqlock : std::false_type
+{};
+
+template <class State>
+struct has_state_seqlock<State, std::void_t<decltype(&State::_velk_seqlock)>> : std::true_type
+{};
+
+template <class State>
+inline constexpr bool has_state_seqlock_v = has_state_seqlock<State>::value;
+
+/** @brief Returns the seqlock of @p state, or nullptr if @p state is null or its interface has none. */
+template <class State>
+StateSeqlock* state_seqlock(State* state) noexcept
+{
+    if constexpr (has_state_seqlock_v<State>) {
+        return state ? &state->_velk_seqlock : nullptr;
+    } else {
+        return nullptr;
+    }
+}
+
+/**
+ * @brief Marks the COMPUTED caches of a @p state with a seqlock stale.
+ *
+ * Called within the write that changed the State, so that a consistent copy never sees new
+ * inputs next to a cache that is still marked fresh. The notification that follows the write
+ * then finds the caches stale already and leaves them alone. States without a seqlock are
+ * invalidated by the notification.
+ */
+template <class State>
+void invalidate_state_caches(State* state) noexcept
+{
+    if constexpr (has_state_seqlock_v<State>) {
+        state->_velk_invalidate_computed();
+    }
+}
+
+/** @brief Brackets a write to a State with the seqlock of its interface, if it has one. */
+template <class State>
+class StateWriteScope
+{
+public:
+    explicit StateWriteScope(State* state) noexcept : lock_(state_seqlock(state))
+    {
+        if (lock_) {
+            lock_->begin_write();
+        }
+    }
+    ~StateWriteScope()
+    {
+        if (lock_) {
+            lock_->end_write();
+        }
+    }
+    StateWriteScope(const StateWriteScope&) = delete;
+    StateWriteScope& operator=(const StateWriteScope&) = delete;
+
+private:
+    StateSeqlock* lock_;
+};
+
 /** @brief RAII read-only accessor to an interface's State struct. Null-safe. */
 template <class T>
 class StateReader
@@ -72,13 +308,23 @@ private:
     const typename T::State* state_{};
 };
 
-/** @brief RAII write accessor; fires notify on destruction. Null-safe. */
+/**
+ * @brief RAII write accessor; fires notify on destruction. Null-safe.
+ *
+ * For an interface with a SEQLOCK member the write is held open for the lifetime of the
+ * accessor, so consistent readers on other threads wait until it is destroyed.
+ */
 template <class T>
 class StateWriter
 {
 public:
     StateWriter() = default;
-    StateWriter(typename T::State* state, const IInterface* meta) : state_(state), meta_(meta) {}
+    StateWriter(typename T::State* state, const IInterface* meta) : state_(state), meta_(meta)
+    {
+        if (auto* lock = state_seqlock(state_)) {
+            lock->begin_write();
+        }
+    }
     ~StateWriter(); // defined after IMetadata
     StateWriter(const StateWriter&) = delete;
     StateWriter& operator=(const StateWriter&) = delete;
@@ -113,6 +359,34 @@ public:
     virtual IEvent::Ptr get_event(string_view name, Resolve mode = Resolve::Create) const = 0;
     /** @brief Returns the runtime function instance for the named member, or nullptr. */
     virtual IFunction::Ptr get_function(string_view name, Resolve mode = Resolve::Create) const = 0;
+    /**
+     * @brief Returns the runtime instance of member @p id of @p kind, or nullptr.
+     *
+     * Resolves @p id through the class's compile-time member table, so no name is hashed or
+     * compared. The by-name getters hash the name and compare it once.
+     */
+    virtual IInterface::Ptr get_member(MemberId id, MemberKind kind,
+                                       Resolve mode = Resolve::Create) const = 0;
+    /**
+     * @brief Returns the runtime instance of the member at @p index in get_static_metadata(), or
+     *        nullptr if @p index is out of range.
+     *
+     * The index of a member is the same for every object of a class, so callers that resolve it
+     * once per class skip the lookup altogether.
+     */
+    virtual IInterface::Ptr get_member_at(size_t index, Resolve mode = Resolve::Create) const = 0;
+    /**
+     * @brief Creates the runtime instances of all members of @p kinds in one pass.
+     *
+     * For objects whose members are all used, e.g. bound UI widgets, this replaces the
+     * one-by-one creation on first access. The instances are drawn in bulk from pooled pages,
+     * so the members of an object sit next to each other in memory. Members that already
+     * have an instance are kept.
+     *
+     * @param kinds A MemberKinds mask.
+     * @return The number of instances created.
+     */
+    virtual size_t materialize_all(uint32_t kinds = MemberKinds::All) const = 0;
 
     /** @brief Broadcasts a notification to all instantiated members of the given kind and interface. */
     virtual void notify(MemberKind kind, Uid interfaceUid, Notification notification) const = 0;
@@ -143,6 +417,10 @@ detail::StateWriter<T> IMetadata::write()
 template <class T>
 detail::StateWriter<T>::~StateWriter()
 {
+    if (auto* lock = state_seqlock(state_)) {
+        invalidate_state_caches(state_);
+        lock->end_write();
+    }
     if (state_ && meta_) {
         if (auto* m = interface_cast<IMetadata>(meta_)) {
             m->notify(MemberKind::Property, T::UID, Notification::Changed);
@@ -185,6 +463,22 @@ inline IFunction::Ptr get_function(const IMetadata* meta, string_view name, Reso
     return meta ? meta->get_function(name, mode) : nullptr;
 }
 
+/**
+ * @brief Null-safe member lookup by precomputed id on an IMetadata pointer.
+ * @tparam T The member interface, e.g. IProperty, IEvent or IFunction.
+ * @param meta Metadata interface pointer (may be nullptr).
+ * @param id Id of the member name, preferably a constant: <tt>static constexpr MemberId id{"width"}</tt>.
+ * @param kind Kind of the member.
+ * @param mode Resolve::Create (default) to lazily create, Resolve::Existing to only return cached.
+ * @return The runtime member instance, or nullptr if @p meta is null or the member is not found.
+ */
+template <class T>
+typename T::Ptr get_member(const IMetadata* meta, MemberId id, MemberKind kind,
+                           Resolve mode = Resolve::Create)
+{
+    return meta ? interface_pointer_cast<T>(meta->get_member(id, kind, mode)) : nullptr;
+}
+
 /**
  * @brief Invoke a function from target object metadata.
  * @param o The object to query for the function.
@@ -251,26 +545,12 @@ IAny::Ptr invoke_function(const IInterface* o, string_view name, const Args&...
 
 // Variadic invoke_function: value args (name-based)
 
-namespace detail {
-
-template <class Tuple, size_t... Is>
-FnArgs make_fn_args(Tuple& tup, const IAny** ptrs, std::index_sequence<Is...>)
-{
-    ((ptrs[Is] = static_cast<const IAny*>(std::get<Is>(tup))), ...);
-    return {ptrs, sizeof...(Is)};
-}
-
-} // namespace detail
-
-/** @brief Invokes a named function with multiple value arguments. */
+/** @brief Invokes a named function with multiple value arguments, viewed by ext::AnyArg. */
 template <class... Args, detail::require_value_args<Args...> = 0>
 IAny::Ptr invoke_function(const IInterface* o, string_view name, const Args&... args)
 {
-    auto tup = std::make_tuple(Any<std::decay_t<Args>>(args)...);
-    const IAny* ptrs[sizeof...(Args)];
-    auto fnArgs = detail::make_fn_args(tup, ptrs, std::index_sequence_for<Args...>{});
     auto* meta = interface_cast<IMetadata>(o);
-    return meta ? invoke_function(meta->get_function(name), fnArgs) : nullptr;
+    return meta ? detail::invoke_with_values(meta->get_function(name), args...) : nullptr;
 }
 
 /** @brief Internal helpers for VELK_INTERFACE macro expansion. */
@@ -315,6 +595,50 @@ IAny::Ptr interface_trampoline_impl(void* self, FnArgs args, R (Intf::*fn)(Args.
     }
 }
 
+/**
+ * @brief Writes @p value, returned by a trampoline target, into @p result.
+ * @return NothingToDo for a null IAny::Ptr, otherwise the result of writing the value.
+ */
+template <class R>
+ReturnValue store_result(R&& value, IAny& result)
+{
+    using T = std::decay_t<R>;
+    if constexpr (std::is_same_v<T, IAny::Ptr>) {
+        return value ? result.copy_from(*value) : ReturnValue::NothingToDo;
+    } else {
+        return result.set_data(&value, sizeof(T), type_uid<T>());
+    }
+}
+
+/** @brief Implementation of interface_result_trampoline; writes the result instead of boxing it. */
+template <class Intf, class R, class... Args, size_t... Is>
+ReturnValue interface_result_trampoline_impl(void* self, FnArgs args, IAny& result, R (Intf::*fn)(Args...),
+                                             std::index_sequence<Is...>)
+{
+    if constexpr (std::is_void_v<R>) {
+        (static_cast<Intf*>(self)->*fn)(extract_arg<std::decay_t<Args>>(args[Is])...);
+        return ReturnValue::NothingToDo;
+    } else {
+        return store_result((static_cast<Intf*>(self)->*fn)(extract_arg<std::decay_t<Args>>(args[Is])...),
+                            result);
+    }
+}
+
+/**
+ * @brief Routes an IFunction::invoke_into() call to a typed virtual method.
+ * @return As IFunction::invoke_into(), or InvalidArgument if too few args were given.
+ */
+template <class Intf, class R, class... Args>
+ReturnValue interface_result_trampoline(void* self, FnArgs args, IAny& result, R (Intf::*fn)(Args...))
+{
+    if constexpr (sizeof...(Args) > 0) {
+        if (args.count < sizeof...(Args)) {
+            return ReturnValue::InvalidArgument;
+        }
+    }
+    return interface_result_trampoline_impl(self, args, result, fn, std::index_sequence_for<Args...>{});
+}
+
 /**
  * @brief Routes an IFunction::invoke() call to a typed virtual method.
  *
@@ -360,6 +684,81 @@ State& default_state()
     return s;
 }
 
+/**
+ * @brief An AnyRef into a State struct whose interface declares SEQLOCK.
+ *
+ * Every write through the any is bracketed by the seqlock of the State, so property
+ * writes are seen whole by read_state_consistent(). A write that changes the value also
+ * marks the COMPUTED caches of the State stale within the bracket.
+ */
+template <class T>
+class SeqlockAnyRef final : public ext::AnyCore<SeqlockAnyRef<T>, T>
+{
+    using Base = ext::AnyCore<SeqlockAnyRef<T>, T>;
+
+public:
+    /// Marks the COMPUTED caches of the State stale (see invalidate_state_caches()).
+    using InvalidateFn = void (*)(void* state);
+
+    explicit SeqlockAnyRef(T* ptr = nullptr, StateSeqlock* lock = nullptr, void* state = nullptr,
+                           InvalidateFn invalidate = nullptr)
+        : ptr_(ptr), lock_(lock), state_(state), invalidate_(invalidate)
+    {}
+
+    const T& get_value() const override { return *ptr_; }
+
+    ReturnValue set_value(const T& value) override
+    {
+        lock_->begin_write();
+        ReturnValue ret;
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            // Stored with StateSeqlock::store(), so the write does not race with the copy of a reader.
+            ret = std::memcmp(ptr_, &value, sizeof(T)) ? ReturnValue::Success : ReturnValue::NothingToDo;
+            if (ret == ReturnValue::Success) {
+                StateSeqlock::store(ptr_, value);
+            }
+        } else {
+            ret = Base::set_value(value);
+        }
+        invalidate(ret);
+        lock_->end_write();
+        return ret;
+    }
+
+    ReturnValue copy_from(const IAny& other) override
+    {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            // Reads the value first and writes it through set_value(), whatever the size of T.
+            alignas(T) char buf[sizeof(T)];
+            return succeeded(other.get_data(buf, sizeof(T), Base::TYPE_UID))
+                       ? set_value(*reinterpret_cast<const T*>(buf))
+                       : ReturnValue::Fail;
+        } else {
+            // Base::copy_from() writes through set_value() for non-trivial types.
+            return Base::copy_from(other);
+        }
+    }
+
+    IAny::Ptr clone() const override
+    {
+        auto c = ext::AnyValue<T>::create();
+        return c && succeeded(c->copy_from(*this)) ? c : nullptr;
+    }
+
+private:
+    void invalidate(ReturnValue ret)
+    {
+        if (ret == ReturnValue::Success && invalidate_) {
+            invalidate_(state_);
+        }
+    }
+
+    T* ptr_{};
+    StateSeqlock* lock_{};
+    void* state_{};
+    InvalidateFn invalidate_{};
+};
+
 /**
  * @brief Binds a pointer-to-member to PropertyKind function pointers.
  *
@@ -400,11 +799,47 @@ struct PropBind
      */
     static IAny::Ptr createRef(void* base)
     {
-        return ext::create_any_ref<value_type>(&(static_cast<State*>(base)->*Mem));
+        auto* state = static_cast<State*>(base);
+        if constexpr (has_state_seqlock_v<State>) {
+            auto* obj = new SeqlockAnyRef<value_type>(&(state->*Mem), &state->_velk_seqlock, state, [](void* s) {
+                invalidate_state_caches(static_cast<State*>(s));
+            });
+            return IAny::Ptr(static_cast<IAny*>(obj));
+        } else {
+            return ext::create_any_ref<value_type>(&(state->*Mem));
+        }
     }
 
-    static constexpr PropertyKind kind{
-        type_uid<value_type>(), &getDefault, &createRef, Flags}; ///< Pre-built PropertyKind.
+    /** @brief Returns the byte offset of the member in State, measured on default_state<State>(). */
+    static size_t stateOffset()
+    {
+        auto& s = default_state<State>();
+        return static_cast<size_t>(reinterpret_cast<const char*>(&(s.*Mem)) -
+                                   reinterpret_cast<const char*>(&s));
+    }
+
+    /**
+     * @brief Returns the member's address in a live State struct for direct access.
+     *
+     * Returns nullptr for seqlock-protected states, whose members must be accessed through the
+     * SeqlockAnyRef returned by createRef().
+     */
+    static void* stateData(void* base)
+    {
+        if constexpr (has_state_seqlock_v<State>) {
+            return nullptr;
+        } else {
+            return &(static_cast<State*>(base)->*Mem);
+        }
+    }
+
+    static constexpr PropertyKind kind{type_uid<value_type>(),
+                                       &getDefault,
+                                       &createRef,
+                                       Flags,
+                                       &stateOffset,
+                                       &stateData,
+                                       std::is_trivially_copyable_v<value_type>}; ///< Pre-built PropertyKind.
 };
 
 /**
@@ -435,7 +870,15 @@ struct ArrBind
         return ext::create_array_any_ref<value_type>(&(static_cast<State*>(base)->*Mem));
     }
 
-    static constexpr PropertyKind baseKind{type_uid<vec_type>(), &getDefault, &createRef, Flags};
+    static size_t stateOffset()
+    {
+        auto& s = default_state<State>();
+        return static_cast<size_t>(reinterpret_cast<const char*>(&(s.*Mem)) -
+                                   reinterpret_cast<const char*>(&s));
+    }
+
+    static constexpr PropertyKind baseKind{type_uid<vec_type>(), &getDefault, &createRef, Flags, &stateOffset,
+                                           nullptr, std::is_trivially_copyable_v<value_type>};
 
     static constexpr ArrayPropertyKind kind{baseKind, type_uid<value_type>()};
 };
@@ -465,7 +908,11 @@ template <auto Fn>
 struct FnBind
 {
     static IAny::Ptr trampoline(void* self, FnArgs args) { return interface_trampoline(self, args, Fn); }
-    static constexpr FunctionKind kind{&trampoline, {}};
+    static ReturnValue into(void* self, FnArgs args, IAny& result)
+    {
+        return interface_result_trampoline(self, args, result, Fn);
+    }
+    static constexpr FunctionKind kind{&trampoline, {}, &raw_trampoline<Fn>, &into};
 };
 
 /**
@@ -501,10 +948,95 @@ struct FnRawBind
             return Any<R>((static_cast<Intf*>(self)->*fn)(args)).clone();
         }
     }
+    template <class Intf, class R>
+    static ReturnValue call_into(void* self, FnArgs args, IAny& result, R (Intf::*fn)(FnArgs))
+    {
+        if constexpr (std::is_void_v<R>) {
+            (static_cast<Intf*>(self)->*fn)(args);
+            return ReturnValue::NothingToDo;
+        } else {
+            return store_result((static_cast<Intf*>(self)->*fn)(args), result);
+        }
+    }
     static IAny::Ptr trampoline(void* self, FnArgs args) { return call(self, args, Fn); }
-    static constexpr FunctionKind kind{&trampoline, {}};
+    static ReturnValue into(void* self, FnArgs args, IAny& result)
+    {
+        return call_into(self, args, result, Fn);
+    }
+    static constexpr FunctionKind kind{&trampoline, {}, nullptr, &into};
+};
+
+/**
+ * @brief Binds a COMPUTED member to its cache in the State struct and its compute method.
+ *
+ * The cached value and its stale flag are members of the State struct. get() returns the
+ * cached value, calling the compute method first if the flag is set. The flag starts set
+ * and is set again whenever a declared input of the member changes.
+ *
+ * @tparam Intf The interface declaring the member.
+ * @tparam State The state struct type of @p Intf.
+ * @tparam Value Pointer-to-member of the cached value.
+ * @tparam Stale Pointer-to-member of the stale flag.
+ * @tparam Compute Pointer-to-member of the compute method, e.g. @c &IMyWidget::compute_area.
+ */
+template <class Intf, class State, auto Value, auto Stale, auto Compute>
+struct ComputedBind
+{
+    using value_type = decltype(member_type_helper(Value)); ///< The member's value type.
+
+    /** @brief Returns the value of the member of @p self, computing it if the cache is stale. */
+    static value_type get(const Intf* self)
+    {
+        auto* ps = const_cast<IPropertyState*>(interface_cast<IPropertyState>(self));
+        auto* state = ps ? static_cast<State*>(ps->get_property_state(Intf::UID)) : nullptr;
+        if (!state) {
+            return (self->*Compute)();
+        }
+        if (state->*Stale) {
+            auto value = (self->*Compute)();
+            StateWriteScope<State> scope(state);
+            if constexpr (has_state_seqlock_v<State> && std::is_trivially_copyable_v<value_type>) {
+                StateSeqlock::store(&(state->*Value), value);
+                StateSeqlock::store(&(state->*Stale), false);
+            } else {
+                state->*Value = std::move(value);
+                state->*Stale = false;
+            }
+        }
+        return state->*Value;
+    }
+
+    static bool* stale(void* base) { return &(static_cast<State*>(base)->*Stale); }
+    static IAny::Ptr trampoline(void* self, FnArgs)
+    {
+        return Any<value_type>(get(static_cast<const Intf*>(self))).clone();
+    }
+    static ReturnValue into(void* self, FnArgs, IAny& result)
+    {
+        return store_result(get(static_cast<const Intf*>(self)), result);
+    }
 };
 
+/**
+ * @brief Marks the COMPUTED members of interface @p interfaceUid among @p members stale.
+ * @param state The State struct of the interface, may be null.
+ */
+inline void invalidate_computed(array_view<MemberDesc> members, Uid interfaceUid, void* state)
+{
+    if (!state) {
+        return;
+    }
+    for (auto& m : members) {
+        auto* ck = m.computedKind();
+        if (ck && m.interfaceInfo && m.interfaceInfo->uid == interfaceUid) {
+            // A State with a seqlock was invalidated within its write; do not write it again.
+            if (bool* stale = ck->stale(state); !*stale) {
+                *stale = true;
+            }
+        }
+    }
+}
+
 } // namespace detail
 
 } // namespace velk
@@ -653,17 +1185,48 @@ struct FnRawBind
 #define _VELK_ARGDESCS_8(a, ...) _VELK_ARGDESCS_1(a), _VELK_EXPAND(_VELK_ARGDESCS_7(__VA_ARGS__))
 #define _VELK_ARGDESCS(...) _VELK_EXPAND(_VELK_CAT(_VELK_ARGDESCS_, _VELK_NARG(__VA_ARGS__))(__VA_ARGS__))
 
+// --- Name expansion: bare member names -> string_view initializers (COMPUTED inputs) ---
+
+#define _VELK_NAMES_1(a) #a
+#define _VELK_NAMES_2(a, ...) #a, _VELK_EXPAND(_VELK_NAMES_1(__VA_ARGS__))
+#define _VELK_NAMES_3(a, ...) #a, _VELK_EXPAND(_VELK_NAMES_2(__VA_ARGS__))
+#define _VELK_NAMES_4(a, ...) #a, _VELK_EXPAND(_VELK_NAMES_3(__VA_ARGS__))
+#define _VELK_NAMES_5(a, ...) #a, _VELK_EXPAND(_VELK_NAMES_4(__VA_ARGS__))
+#define _VELK_NAMES_6(a, ...) #a, _VELK_EXPAND(_VELK_NAMES_5(__VA_ARGS__))
+#define _VELK_NAMES_7(a, ...) #a, _VELK_EXPAND(_VELK_NAMES_6(__VA_ARGS__))
+#define _VELK_NAMES_8(a, ...) #a, _VELK_EXPAND(_VELK_NAMES_7(__VA_ARGS__))
+#define _VELK_NAMES(...) _VELK_EXPAND(_VELK_CAT(_VELK_NAMES_, _VELK_NARG(__VA_ARGS__))(__VA_ARGS__))
+
 // --- State pass: generates State struct fields for PROP members ---
 
 #define _VELK_STATE_PROP(Type, Name, Default) Type Name = Default;
 #define _VELK_STATE_RPROP(Type, Name, Default) Type Name = Default;
+#define _VELK_STATE_CPROP(Type, Name, Default) Type Name = Default;
 #define _VELK_STATE_ARR(Type, Name, ...) ::velk::vector<Type> Name = {__VA_ARGS__};
 #define _VELK_STATE_RARR(Type, Name, ...) ::velk::vector<Type> Name = {__VA_ARGS__};
 #define _VELK_STATE_EVT(Name)
 #define _VELK_STATE_FN(...)
 #define _VELK_STATE_FN_RAW(...)
+#define _VELK_STATE_COMPUTED(Type, Name, ...) \
+    Type Name{};                              \
+    bool _velk_stale_##Name = true;
+#define _VELK_STATE_SEQLOCK() ::velk::StateSeqlock _velk_seqlock;
 #define _VELK_STATE(Tag, ...) _VELK_EXPAND(_VELK_CAT(_VELK_STATE_, Tag)(__VA_ARGS__))
 
+// --- Stale pass: marks the cache of each COMPUTED member stale (_velk_invalidate_computed) ---
+
+#define _VELK_STALE_PROP(...)
+#define _VELK_STALE_RPROP(...)
+#define _VELK_STALE_CPROP(...)
+#define _VELK_STALE_ARR(...)
+#define _VELK_STALE_RARR(...)
+#define _VELK_STALE_EVT(...)
+#define _VELK_STALE_FN(...)
+#define _VELK_STALE_FN_RAW(...)
+#define _VELK_STALE_COMPUTED(Type, Name, ...) ::velk::StateSeqlock::store(&_velk_stale_##Name, true);
+#define _VELK_STALE_SEQLOCK()
+#define _VELK_STALE(Tag, ...) _VELK_EXPAND(_VELK_CAT(_VELK_STALE_, Tag)(__VA_ARGS__))
+
 // --- Defaults pass: generates kind-specific static data for each member ---
 
 #define _VELK_DEFAULTS_PROP(Type, Name, Default)                  \
@@ -672,6 +1235,9 @@ struct FnRawBind
 #define _VELK_DEFAULTS_RPROP(Type, Name, Default)                 \
     static constexpr ::velk::PropertyKind _velk_propkind_##Name = \
         ::velk::detail::PropBind<State, &State::Name, ::velk::ObjectFlags::ReadOnly>::kind;
+#define _VELK_DEFAULTS_CPROP(Type, Name, Default)                 \
+    static constexpr ::velk::PropertyKind _velk_propkind_##Name = \
+        ::velk::detail::PropBind<State, &State::Name, ::velk::ObjectFlags::CompareOnWrite>::kind;
 #define _VELK_DEFAULTS_ARR(Type, Name, ...)                           \
     static constexpr ::velk::ArrayPropertyKind _velk_arrkind_##Name = \
         ::velk::detail::ArrBind<State, &State::Name>::kind;
@@ -687,7 +1253,9 @@ struct FnRawBind
     static constexpr ::velk::FnArgDesc _velk_fnargs_##Name[] = {_VELK_ARGDESCS(__VA_ARGS__)}; \
     static constexpr ::velk::FunctionKind _velk_fnkind_##Name{                                \
         &::velk::detail::FnBind<&_velk_intf_type::fn_##Name>::trampoline,                     \
-        {_velk_fnargs_##Name, _VELK_NARG(__VA_ARGS__)}};
+        {_velk_fnargs_##Name, _VELK_NARG(__VA_ARGS__)},                                       \
+        &::velk::detail::raw_trampoline<&_velk_intf_type::fn_##Name>,                         \
+        &::velk::detail::FnBind<&_velk_intf_type::fn_##Name>::into};
 
 #define _VELK_DFN_2(RetType, Name) _VELK_DEFAULTS_FN_0(Name)
 #define _VELK_DFN_3(RetType, Name, ...) _VELK_DEFAULTS_FN_N(Name, __VA_ARGS__)
@@ -704,23 +1272,85 @@ struct FnRawBind
     static constexpr ::velk::FunctionKind _velk_fnkind_##Name = \
         ::velk::detail::FnRawBind<&_velk_intf_type::fn_##Name>::kind;
 
+#define _VELK_DEFAULTS_COMPUTED(Type, Name, ...)                                                        \
+    using _velk_compbind_##Name = ::velk::detail::ComputedBind<_velk_intf_type,                      \
+                                                               State,                                \
+                                                               &State::Name,                         \
+                                                               &State::_velk_stale_##Name,           \
+                                                               &_velk_intf_type::compute_##Name>;    \
+    static constexpr ::velk::string_view _velk_inputs_##Name[] = {_VELK_NAMES(__VA_ARGS__)};         \
+    static constexpr ::velk::ComputedKind _velk_compkind_##Name{                                     \
+        {_velk_inputs_##Name, _VELK_NARG(__VA_ARGS__)}, &_velk_compbind_##Name::stale};              \
+    static constexpr ::velk::FunctionKind _velk_fnkind_##Name{&_velk_compbind_##Name::trampoline,    \
+                                                              {},                                    \
+                                                              nullptr,                               \
+                                                              &_velk_compbind_##Name::into,          \
+                                                              &_velk_compkind_##Name};
+
+#define _VELK_DEFAULTS_SEQLOCK()
 #define _VELK_DEFAULTS(Tag, ...) _VELK_EXPAND(_VELK_CAT(_VELK_DEFAULTS_, Tag)(__VA_ARGS__))
 
+// --- Computed count pass: number of COMPUTED members, so objects without any skip invalidation ---
+
+#define _VELK_NCOMP_PROP(...)
+#define _VELK_NCOMP_RPROP(...)
+#define _VELK_NCOMP_CPROP(...)
+#define _VELK_NCOMP_ARR(...)
+#define _VELK_NCOMP_RARR(...)
+#define _VELK_NCOMP_EVT(...)
+#define _VELK_NCOMP_FN(...)
+#define _VELK_NCOMP_FN_RAW(...)
+#define _VELK_NCOMP_COMPUTED(...) +1
+#define _VELK_NCOMP_SEQLOCK()
+#define _VELK_NCOMP(Tag, ...) _VELK_EXPAND(_VELK_CAT(_VELK_NCOMP_, Tag)(__VA_ARGS__))
+
+// --- Trivial pass: true if every State field can be copied while a write is in progress ---
+
+#define _VELK_TRIVIAL_PROP(Type, ...) &&std::is_trivially_copyable_v<Type>
+#define _VELK_TRIVIAL_RPROP(Type, ...) &&std::is_trivially_copyable_v<Type>
+#define _VELK_TRIVIAL_CPROP(Type, ...) &&std::is_trivially_copyable_v<Type>
+#define _VELK_TRIVIAL_ARR(...) &&false
+#define _VELK_TRIVIAL_RARR(...) &&false
+#define _VELK_TRIVIAL_EVT(...)
+#define _VELK_TRIVIAL_FN(...)
+#define _VELK_TRIVIAL_FN_RAW(...)
+#define _VELK_TRIVIAL_COMPUTED(Type, ...) &&std::is_trivially_copyable_v<Type>
+#define _VELK_TRIVIAL_SEQLOCK()
+#define _VELK_TRIVIAL(Tag, ...) _VELK_EXPAND(_VELK_CAT(_VELK_TRIVIAL_, Tag)(__VA_ARGS__))
+
+// --- Layout pass: hashes the name and type of each State field (state_layout_hash) ---
+
+#define _VELK_LAYOUT_PROP(Type, Name, ...) .add(#Name, ::velk::type_uid<Type>())
+#define _VELK_LAYOUT_RPROP(Type, Name, ...) .add(#Name, ::velk::type_uid<Type>())
+#define _VELK_LAYOUT_CPROP(Type, Name, ...) .add(#Name, ::velk::type_uid<Type>())
+#define _VELK_LAYOUT_ARR(Type, Name, ...) .add(#Name, ::velk::type_uid<::velk::vector<Type>>())
+#define _VELK_LAYOUT_RARR(Type, Name, ...) .add(#Name, ::velk::type_uid<::velk::vector<Type>>())
+#define _VELK_LAYOUT_EVT(...)
+#define _VELK_LAYOUT_FN(...)
+#define _VELK_LAYOUT_FN_RAW(...)
+#define _VELK_LAYOUT_COMPUTED(Type, Name, ...) .add(#Name, ::velk::type_uid<Type>())
+#define _VELK_LAYOUT_SEQLOCK() .add("(SEQLOCK)", {})
+#define _VELK_LAYOUT(Tag, ...) _VELK_EXPAND(_VELK_CAT(_VELK_LAYOUT_, Tag)(__VA_ARGS__))
+
 // --- Metadata dispatch: tag -> MemberDesc initializer ---
 
 #define _VELK_META_PROP(Type, Name, ...) ::velk::PropertyDesc(#Name, &INFO, &_velk_propkind_##Name),
 #define _VELK_META_RPROP(Type, Name, ...) ::velk::PropertyDesc(#Name, &INFO, &_velk_propkind_##Name),
+#define _VELK_META_CPROP(Type, Name, ...) ::velk::PropertyDesc(#Name, &INFO, &_velk_propkind_##Name),
 #define _VELK_META_ARR(Type, Name, ...) ::velk::ArrayPropertyDesc(#Name, &INFO, &_velk_arrkind_##Name),
 #define _VELK_META_RARR(Type, Name, ...) ::velk::ArrayPropertyDesc(#Name, &INFO, &_velk_arrkind_##Name),
 #define _VELK_META_EVT(Name) ::velk::EventDesc(#Name, &INFO),
 #define _VELK_META_FN(RetType, Name, ...) ::velk::FunctionDesc(#Name, &INFO, &_velk_fnkind_##Name),
 #define _VELK_META_FN_RAW(Name) ::velk::FunctionDesc(#Name, &INFO, &_velk_fnkind_##Name),
+#define _VELK_META_COMPUTED(Type, Name, ...) ::velk::FunctionDesc(#Name, &INFO, &_velk_fnkind_##Name),
+#define _VELK_META_SEQLOCK()
 #define _VELK_META(Tag, ...) _VELK_EXPAND(_VELK_CAT(_VELK_META_, Tag)(__VA_ARGS__))
 
 // --- Trampoline dispatch: tag -> virtual method + static trampoline for FN, no-op for PROP/EVT ---
 
 #define _VELK_TRAMPOLINE_PROP(...)
 #define _VELK_TRAMPOLINE_RPROP(...)
+#define _VELK_TRAMPOLINE_CPROP(...)
 #define _VELK_TRAMPOLINE_ARR(...)
 #define _VELK_TRAMPOLINE_RARR(...)
 #define _VELK_TRAMPOLINE_EVT(Name)
@@ -741,6 +1371,9 @@ struct FnRawBind
 
 #define _VELK_TRAMPOLINE_FN_RAW(Name) virtual ::velk::IAny::Ptr fn_##Name(::velk::FnArgs) = 0;
 
+#define _VELK_TRAMPOLINE_COMPUTED(Type, Name, ...) virtual Type compute_##Name() const = 0;
+
+#define _VELK_TRAMPOLINE_SEQLOCK()
 #define _VELK_TRAMPOLINE(Tag, ...) _VELK_EXPAND(_VELK_CAT(_VELK_TRAMPOLINE_, Tag)(__VA_ARGS__))
 
 /**
@@ -753,57 +1386,76 @@ struct FnRawBind
  *
  * @see VELK_INTERFACE For the full macro that also generates accessors and virtuals.
  */
-#define VELK_METADATA(...)                       \
-    struct State                                 \
-    {                                            \
-        _VELK_FOR_EACH(_VELK_STATE, __VA_ARGS__) \
-    };                                           \
-    _VELK_FOR_EACH(_VELK_DEFAULTS, __VA_ARGS__)  \
-    static constexpr std::array metadata = {_VELK_FOR_EACH(_VELK_META, __VA_ARGS__)};
+#define VELK_METADATA(...)                                                                     \
+    struct State                                                                               \
+    {                                                                                          \
+        _VELK_FOR_EACH(_VELK_STATE, __VA_ARGS__)                                               \
+        static constexpr bool _velk_trivial_fields = true _VELK_FOR_EACH(_VELK_TRIVIAL, __VA_ARGS__); \
+        void _velk_invalidate_computed() noexcept { _VELK_FOR_EACH(_VELK_STALE, __VA_ARGS__) }   \
+    };                                                                                         \
+    _VELK_FOR_EACH(_VELK_DEFAULTS, __VA_ARGS__)                                                \
+    static constexpr std::array metadata = {_VELK_FOR_EACH(_VELK_META, __VA_ARGS__)}; \
+    static constexpr size_t computed_count = 0 _VELK_FOR_EACH(_VELK_NCOMP, __VA_ARGS__);      \
+    static constexpr uint64_t state_layout_hash =                                             \
+        ::velk::detail::LayoutHash{}.add(sizeof(State), alignof(State))                       \
+            _VELK_FOR_EACH(_VELK_LAYOUT, __VA_ARGS__).value;
 
 // --- Accessor dispatch: tag -> typed non-virtual accessor method ---
 
-#define _VELK_ACC_PROP(Type, Name, ...)                                                      \
-    ::velk::Property<Type> Name() const                                                      \
-    {                                                                                        \
-        return ::velk::Property<Type>(                                                       \
-            ::velk::get_property(this->template get_interface<::velk::IMetadata>(), #Name)); \
-    }
-#define _VELK_ACC_RPROP(Type, Name, ...)                                                     \
-    ::velk::ConstProperty<Type> Name() const                                                 \
-    {                                                                                        \
-        return ::velk::ConstProperty<Type>(                                                  \
-            ::velk::get_property(this->template get_interface<::velk::IMetadata>(), #Name)); \
-    }
-#define _VELK_ACC_ARR(Type, Name, ...)                                                       \
-    ::velk::ArrayProperty<Type> Name() const                                                 \
-    {                                                                                        \
-        return ::velk::ArrayProperty<Type>(                                                  \
-            ::velk::get_property(this->template get_interface<::velk::IMetadata>(), #Name)); \
-    }
-#define _VELK_ACC_RARR(Type, Name, ...)                                                      \
-    ::velk::ConstArrayProperty<Type> Name() const                                            \
-    {                                                                                        \
-        return ::velk::ConstArrayProperty<Type>(                                             \
-            ::velk::get_property(this->template get_interface<::velk::IMetadata>(), #Name)); \
-    }
-#define _VELK_ACC_EVT(Name)                                                                                \
-    ::velk::Event Name() const                                                                             \
-    {                                                                                                      \
-        return ::velk::Event(::velk::get_event(this->template get_interface<::velk::IMetadata>(), #Name)); \
-    }
-#define _VELK_ACC_FN(RetType, Name, ...)                                                     \
-    ::velk::Function Name() const                                                            \
-    {                                                                                        \
-        return ::velk::Function(                                                             \
-            ::velk::get_function(this->template get_interface<::velk::IMetadata>(), #Name)); \
-    }
-#define _VELK_ACC_FN_RAW(Name)                                                               \
-    ::velk::Function Name() const                                                            \
-    {                                                                                        \
-        return ::velk::Function(                                                             \
-            ::velk::get_function(this->template get_interface<::velk::IMetadata>(), #Name)); \
+#define _VELK_ACC_MEMBER(Intf, Kind, Name)                                                     \
+    ::velk::get_member<::velk::Intf>(this->template get_interface<::velk::IMetadata>(),        \
+                                     _velk_id_##Name,                                          \
+                                     ::velk::MemberKind::Kind)
+#define _VELK_ACC_PROP(Type, Name, ...)                                                        \
+    ::velk::Property<Type> Name() const                                                        \
+    {                                                                                          \
+        static constexpr ::velk::MemberId _velk_id_##Name{#Name};                              \
+        return ::velk::Property<Type>(_VELK_ACC_MEMBER(IProperty, Property, Name));            \
+    }
+#define _VELK_ACC_RPROP(Type, Name, ...)                                                       \
+    ::velk::ConstProperty<Type> Name() const                                                   \
+    {                                                                                          \
+        static constexpr ::velk::MemberId _velk_id_##Name{#Name};                              \
+        return ::velk::ConstProperty<Type>(_VELK_ACC_MEMBER(IProperty, Property, Name));       \
+    }
+#define _VELK_ACC_CPROP(Type, Name, ...) _VELK_ACC_PROP(Type, Name)
+#define _VELK_ACC_ARR(Type, Name, ...)                                                         \
+    ::velk::ArrayProperty<Type> Name() const                                                   \
+    {                                                                                          \
+        static constexpr ::velk::MemberId _velk_id_##Name{#Name};                              \
+        return ::velk::ArrayProperty<Type>(_VELK_ACC_MEMBER(IProperty, ArrayProperty, Name));  \
+    }
+#define _VELK_ACC_RARR(Type, Name, ...)                                                        \
+    ::velk::ConstArrayProperty<Type> Name() const                                              \
+    {                                                                                          \
+        static constexpr ::velk::MemberId _velk_id_##Name{#Name};                              \
+        return ::velk::ConstArrayProperty<Type>(_VELK_ACC_MEMBER(IProperty, ArrayProperty, Name)); \
+    }
+#define _VELK_ACC_EVT(Name)                                                                    \
+    ::velk::Event Name() const                                                                 \
+    {                                                                                          \
+        static constexpr ::velk::MemberId _velk_id_##Name{#Name};                              \
+        return ::velk::Event(_VELK_ACC_MEMBER(IEvent, Event, Name));                           \
+    }
+#define _VELK_ACC_FN(RetType, Name, ...)                                                       \
+    ::velk::TypedFunction<&_velk_intf_type::fn_##Name> Name() const                            \
+    {                                                                                          \
+        static constexpr ::velk::MemberId _velk_id_##Name{#Name};                              \
+        return ::velk::TypedFunction<&_velk_intf_type::fn_##Name>(                             \
+            _VELK_ACC_MEMBER(IFunction, Function, Name));                                      \
+    }
+#define _VELK_ACC_FN_RAW(Name)                                                                 \
+    ::velk::Function Name() const                                                              \
+    {                                                                                          \
+        static constexpr ::velk::MemberId _velk_id_##Name{#Name};                              \
+        return ::velk::Function(_VELK_ACC_MEMBER(IFunction, Function, Name));                  \
+    }
+#define _VELK_ACC_COMPUTED(Type, Name, ...)      \
+    Type Name() const                            \
+    {                                            \
+        return _velk_compbind_##Name::get(this); \
     }
+#define _VELK_ACC_SEQLOCK()
 #define _VELK_ACC(Tag, ...) _VELK_EXPAND(_VELK_CAT(_VELK_ACC_, Tag)(__VA_ARGS__))
 
 /**
@@ -818,12 +1470,15 @@ struct FnRawBind
  * |----------|------------------------------------------|--------------------------------------|
  * | Property | @c (PROP, Type, Name, Default)           | A typed property with default value  |
  * | Read-only| @c (RPROP, Type, Name, Default)          | A read-only property with default    |
+ * | Compared | @c (CPROP, Type, Name, Default)          | A property that skips no-op notifies |
  * | Array    | @c (ARR, ElemType, Name, ...)             | Array property (vector\<ElemType\>)  |
  * | RO Array | @c (RARR, ElemType, Name, ...)            | Read-only array property             |
  * | Event    | @c (EVT, Name)                           | An observable event                  |
  * | Function | @c (FN, RetType, Name)                            | Zero-arg function with return type   |
  * | Function | @c (FN, RetType, Name, (T1, a1), (T2, a2), ...)   | Typed-arg function with metadata     |
  * | Function | @c (FN_RAW, Name)                        | Raw untyped function (receives FnArgs) |
+ * | Computed | @c (COMPUTED, Type, Name, Input1, ...)   | Cached value derived from properties |
+ * | Seqlock  | @c (SEQLOCK)                             | State sequence counter, see StateSeqlock |
  *
  * @par What the macro generates
  * For each member entry the macro produces:
@@ -833,16 +1488,30 @@ struct FnRawBind
  *    is generated via @c detail::FnBind (for @c FN) or @c detail::FnRawBind
  *    (for @c FN_RAW). Implementing classes @c override the virtual to provide
  *    function logic.
+ * -# For @c COMPUTED members: a pure @c virtual <tt>Type compute_Name() const</tt>, plus the
+ *    cached value and its stale flag in the @c State struct. The listed inputs are names of
+ *    properties of the same interface; a change of any of them, or a write_state() of the
+ *    interface, marks the cache stale.
+ * -# For @c SEQLOCK: a StateSeqlock in the @c State struct. write_state(), property writes and
+ *    COMPUTED refreshes bracket their writes with it, and read_state_consistent() copies the
+ *    @c State without tearing. The writes also mark every COMPUTED cache of the interface stale
+ *    within the bracket, not only those listing the written property as an input. It adds no
+ *    member descriptor or accessor.
  * -# A @c MemberDesc initializer in a @c static @c constexpr @c std::array
  *    named @c metadata, used for compile-time and runtime introspection.
  *    For @c FN members the descriptor includes a pointer to the trampoline.
  * -# A non-virtual @c const accessor method on the interface:
  *    - @c PROP &rarr; <tt>Property\<Type\> Name() const</tt>
  *    - @c RPROP &rarr; <tt>ConstProperty\<Type\> Name() const</tt>
+ *    - @c CPROP &rarr; <tt>Property\<Type\> Name() const</tt>, with ObjectFlags::CompareOnWrite
  *    - @c ARR  &rarr; <tt>ArrayProperty\<ElemType\> Name() const</tt>
  *    - @c RARR &rarr; <tt>ConstArrayProperty\<ElemType\> Name() const</tt>
  *    - @c EVT  &rarr; <tt>Event Name() const</tt>
- *    - @c FN   &rarr; <tt>Function Name() const</tt>
+ *    - @c FN   &rarr; <tt>TypedFunction\<&fn_Name\> Name() const</tt>, a Function with a
+ *      typed call()
+ *    - @c COMPUTED &rarr; <tt>Type Name() const</tt>, which returns the cached value and calls
+ *      @c compute_Name() only if the cache is stale. Reflection sees the member as a zero-arg
+ *      function returning @c Type.
  *
  *    Each accessor obtains the runtime instance by querying the object's
  *    @c IMetadata interface, so it works on any @c Object that implements
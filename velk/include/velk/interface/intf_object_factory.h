@@ -30,6 +30,16 @@ public:
                                         uint32_t flags = ObjectFlags::None) const = 0;
     /** @brief Calls the destructor of an instance at the given location (does not free memory). */
     virtual void destroy_in_place(void* location) const = 0;
+    /**
+     * @brief Creates @p count instances in one allocation, with their control blocks embedded.
+     *
+     * The instances are laid out contiguously, so that objects loaded in bulk are iterated
+     * cache-friendly. Each instance is released independently; the allocation is freed once
+     * all of them are destroyed and no weak_ptr refers to any of them.
+     * @param out Receives the instances, must hold @p count elements.
+     * @return The number of instances created: @p count, or 0 if allocation failed.
+     */
+    virtual size_t create_instances(size_t count, uint32_t flags, IObject::Ptr* out) const = 0;
 
     /** @brief Type helper create_instance(). */
     template <class T>
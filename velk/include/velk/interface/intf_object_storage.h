@@ -3,8 +3,15 @@
 
 #include <velk/interface/intf_metadata.h>
 
+#include <cstddef>
+
 namespace velk {
 
+/** @brief Bytes an object reserves for an ObjectStorage embedded in it (see ext::ObservedObject). */
+inline constexpr size_t OBJECT_STORAGE_SIZE = 160;
+/** @brief Alignment of the memory reserved for an embedded ObjectStorage. */
+inline constexpr size_t OBJECT_STORAGE_ALIGNMENT = alignof(std::max_align_t);
+
 /** @brief Query parameters for finding attachments. Zero means "don't filter by this field". */
 struct AttachmentQuery
 {
@@ -65,8 +72,47 @@ public:
     {
         return interface_pointer_cast<T>(find_attachment({T::UID, classUid}, Resolve::Create));
     }
+
+    /**
+     * @brief Makes the object immutable, for data that is built once and only read afterwards.
+     *
+     * Creates the runtime instances of all members, then makes every property read-only and
+     * drops its on_changed event, including the handlers connected to it, and its hive dirty
+     * and COMPUTED bookkeeping. Attachments can no longer be added or removed, and notify()
+     * does nothing. The object gets ObjectFlags::Frozen.
+     *
+     * Since the member instances never change afterwards, borrow_member() can hand them out
+     * without adding a reference. The State itself is not protected: writes through
+     * get_property_state() are the caller's responsibility, and property writes deferred
+     * before the call are rejected when update() applies them.
+     *
+     * @return Success, or NothingToDo if the object is already frozen.
+     */
+    virtual ReturnValue freeze() = 0;
+
+    /**
+     * @brief Returns the runtime instance of member @p id of @p kind of a frozen object.
+     *
+     * Unlike IMetadata::get_member(), adds no reference: the instance lives as long as the
+     * object. Returns nullptr if the object is not frozen or has no such member.
+     */
+    virtual borrowed_ptr<IInterface> borrow_member(MemberId id, MemberKind kind) const = 0;
 };
 
+/**
+ * @brief Null-safe member borrow on a frozen object. See IObjectStorage::borrow_member().
+ * @tparam T The member interface, e.g. IProperty, IEvent or IFunction.
+ * @param storage Object storage interface pointer (may be nullptr).
+ * @param id Id of the member name, preferably a constant: <tt>static constexpr MemberId id{"width"}</tt>.
+ * @param kind Kind of the member.
+ * @return The member instance, or nullptr if @p storage is null or not frozen, or the member is not found.
+ */
+template <class T>
+borrowed_ptr<T> borrow_member(const IObjectStorage* storage, MemberId id, MemberKind kind)
+{
+    return storage ? interface_cast<T>(storage->borrow_member(id, kind).get()) : nullptr;
+}
+
 } // namespace velk
 
 #endif // VELK_INTF_OBJECT_STORAGE_H
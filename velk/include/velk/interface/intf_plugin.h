@@ -8,8 +8,40 @@
 namespace velk {
 
 class IVelk;       // Forward declaration
+class IPlugin;     // Forward declaration
 struct UpdateInfo; // Forward declaration
 
+/** @brief Time one plugin spent in its update callbacks during an update() call. */
+struct PluginUpdateTiming
+{
+    const IPlugin* plugin; ///< The plugin.
+    Duration preUpdate;    ///< Time spent in IPlugin::pre_update().
+    Duration postUpdate;   ///< Time spent in IPlugin::post_update().
+};
+
+/** @brief Wall-clock time spent in each phase of an update() call. */
+struct UpdateTimings
+{
+    Duration preUpdate;     ///< Pre-update plugin callbacks.
+    Duration deferredTasks; ///< Deferred tasks and deferred event handlers.
+    Duration properties;    ///< Applying deferred property sets.
+    Duration notifications; ///< on_changed notifications of the deferred property sets.
+    Duration bindings;      ///< Re-evaluating dirty property bindings.
+    Duration postUpdate;    ///< Post-update plugin callbacks.
+    /// Callback timings of each plugin that opted into updates.
+    array_view<PluginUpdateTiming> plugins;
+};
+
+/** @brief Counters and timings of an update() call. */
+struct UpdateStats
+{
+    size_t tasksRun{};          ///< Number of deferred tasks run.
+    size_t propertiesChanged{}; ///< Number of deferred property changes.
+    size_t tasksPending{};      ///< Number of deferred tasks carried over by a time budget.
+    size_t bindingsEvaluated{}; ///< Number of property bindings re-evaluated.
+    UpdateTimings timings;      ///< Time spent in each phase.
+};
+
 /** @brief Packs major.minor.patch into a single uint32_t.
  *  Layout: [major:8][minor:8][patch:16] */
 constexpr uint32_t make_version(uint8_t major, uint8_t minor, uint16_t patch = 0)
@@ -59,10 +91,35 @@ struct PluginInfo
 };
 
 /** @brief Plugin configuration set during initialize to control system behavior. */
+/**
+ * @brief Bits of PluginConfig::updateReads and PluginConfig::updateWrites, naming the state that
+ *        the update callbacks of a plugin access.
+ *
+ * Bits from AccessUser up are free for plugins to name state of their own.
+ */
+enum PluginAccess : uint64_t
+{
+    AccessNone = 0,               ///< Accesses no shared state.
+    AccessProperties = 1ull << 0, ///< Property values, e.g. written by an animator, read by layout.
+    AccessHierarchy = 1ull << 1,  ///< Object hierarchies.
+    AccessHives = 1ull << 2,      ///< Object and raw hives.
+    AccessUser = 1ull << 32,      ///< First bit for plugin-defined state.
+    AccessAll = ~0ull             ///< Everything; conflicts with every other plugin.
+};
+
 struct PluginConfig
 {
     bool retainTypesOnUnload = false; ///< If true, plugin-owned types are kept after unload.
     bool enableUpdate = false;        ///< If true, update() is called during instance().update().
+    /**
+     * @brief State the update callbacks read and write, as PluginAccess bits.
+     *
+     * With an executor set through IVelk::set_executor(), the callbacks of adjacent plugins
+     * whose sets do not conflict (neither writes what the other reads or writes) run in
+     * parallel. The defaults conflict with everything, so such plugins update one at a time.
+     */
+    uint64_t updateReads = AccessAll;
+    uint64_t updateWrites = AccessAll; ///< See updateReads.
 };
 
 /**
@@ -93,12 +150,23 @@ public:
         const UpdateInfo& info;     ///< UpdateInfo from instance().update().
         size_t tasksRun{};          ///< Number of tasks that were run after pre_update().
         size_t propertiesChanged{}; ///< Number of deferred property changes after pre_update().
+        size_t tasksPending{};      ///< Number of deferred tasks carried over by a time-budgeted update().
+        /**
+         * @brief Timings of the phases so far. The post-update phase is still running, so its
+         *        timings, including the PluginUpdateTiming::postUpdate entries, are zero.
+         */
+        const UpdateTimings& timings;
     };
     /** @brief Called at the start of instance().update(), before deferred tasks and properties are flushed.
      */
     virtual void pre_update(const PreUpdateInfo& info) = 0;
     /** @brief Called at the end of instance().update(), after deferred tasks and properties are flushed. */
     virtual void post_update(const PostUpdateInfo& info) = 0;
+    /**
+     * @brief Returns true if the plugin has no update work, so that its next pre_update() or
+     *        post_update() call can be skipped. Queried before each of those calls.
+     */
+    virtual bool is_update_idle() const = 0;
     /** @brief Returns the static plugin descriptor. */
     virtual const PluginInfo& get_plugin_info() const = 0;
 
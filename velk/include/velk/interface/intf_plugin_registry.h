@@ -1,6 +1,7 @@
 #ifndef VELK_INTF_PLUGIN_REGISTRY_H
 #define VELK_INTF_PLUGIN_REGISTRY_H
 
+#include <velk/interface/intf_executor.h>
 #include <velk/interface/intf_plugin.h>
 
 namespace velk {
@@ -11,6 +12,9 @@ namespace velk {
  * Plugins are loaded via load_plugin() which calls their initialize() method,
  * and unloaded via unload_plugin() which calls shutdown() and sweeps any
  * types the plugin registered but did not explicitly unregister.
+ *
+ * A plugin library registered with register_plugin_library() is only loaded when one of the
+ * classes it provides is first created, or the plugin itself is asked for.
  */
 class IPluginRegistry : public Interface<IPluginRegistry>
 {
@@ -21,6 +25,41 @@ public:
     virtual ReturnValue load_plugin(Uid pluginUid) = 0;
     /** @brief Loads a plugin from a shared library (.dll/.so) at the given path. */
     virtual ReturnValue load_plugin_from_path(const char* path) = 0;
+    /**
+     * @brief Loads @p plugins in the order of their dependencies, running the initialize() of
+     *        plugins that do not depend on each other concurrently on @p executor.
+     *
+     * The plugins load in waves. Each wave holds the plugins whose dependencies are all loaded,
+     * and initializes them as the tasks of one IExecutor::parallel_for(). While a wave runs the
+     * instance serializes registry access, so initialize() may register types and
+     * interpolators, create objects and load further plugins from any of the tasks. A plugin
+     * that fails, and every plugin that depends on it, is not loaded; the others are.
+     *
+     * @param plugins Plugins to load, in any order. Plugins that are loaded already are skipped.
+     * @param executor Executor to initialize on, or null to initialize one plugin at a time.
+     * @return Success if all plugins are loaded, NothingToDo if all were loaded already, Fail
+     *         if any could not be loaded or the dependencies form a cycle, InvalidArgument if
+     *         one of @p plugins is null.
+     */
+    virtual ReturnValue load_plugins(array_view<IPlugin::Ptr> plugins, IExecutor* executor) = 0;
+    /**
+     * @brief Registers the shared library at @p path as the provider of plugin @p pluginId and
+     *        of the classes @p classUids, without loading it.
+     *
+     * The library is loaded with load_plugin_from_path() by the first IVelk::create() of one of
+     * @p classUids that is not registered yet, or by load_plugin(@p pluginId), on the thread
+     * that makes the call. The registration is then consumed, whether the load succeeds or not.
+     * Typically @p classUids is the list of classes the public header of the plugin publishes:
+     * @code
+     * reg.register_plugin_library(PluginId::AnimatorPlugin, "libvelk_animator.so",
+     *                             {PluginClasses::AnimatorPlugin, std::size(PluginClasses::AnimatorPlugin)});
+     * @endcode
+     *
+     * @return NothingToDo if the plugin is loaded or registered already, InvalidArgument
+     *         without a path.
+     */
+    virtual ReturnValue register_plugin_library(Uid pluginId, const char* path,
+                                                array_view<Uid> classUids) = 0;
     /** @brief Unloads a plugin by ID, calling shutdown() and sweeping owned types. */
     virtual ReturnValue unload_plugin(Uid pluginId) = 0;
     /**
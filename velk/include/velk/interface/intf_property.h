@@ -24,6 +24,21 @@ public:
      * @brief Returns the property's current value.
      */
     virtual const IAny::ConstPtr get_value() const = 0;
+    /**
+     * @brief Returns the property's current value without adding a reference to it.
+     *
+     * The value stays valid while the property is alive and its backing any is not replaced
+     * with IPropertyInternal::set_any(). Setting a new value does not replace the any.
+     */
+    virtual borrowed_ptr<const IAny> borrow_value() const = 0;
+    /**
+     * @brief Returns the address of the property's value in its object's State, or nullptr.
+     *
+     * Non-null only while the value lives in a State field of type @p type and is read and
+     * written directly, i.e. no extension is installed and the State is not seqlock-protected.
+     * Typed accessors read through it instead of calling into the backing any.
+     */
+    virtual const void* get_state_data(Uid type) const = 0;
     /**
      * @brief Invoked when value of the property changes as a response to
      *        set_value being called.
@@ -56,12 +71,39 @@ public:
      */
     virtual ReturnValue set_data(const void* data, size_t size, Uid type,
                                  InvokeType invokeType = Immediate) = 0;
+    /**
+     * @brief Like set_data(), for data of a trivially copyable type.
+     *
+     * A deferred write of at most DeferredPropertySet::INLINE_SIZE bytes is queued as the raw
+     * bytes, without cloning the backing value.
+     */
+    virtual ReturnValue set_trivial_data(const void* data, size_t size, Uid type,
+                                         InvokeType invokeType = Immediate) = 0;
     /**
      * @brief Copies @p from into the backing value without firing on_changed.
      * @return ReturnValue::Success if the value changed and the caller should fire on_changed.
      *         ReturnValue::NothingToDo if unchanged or if the property is externally notified.
      */
     virtual ReturnValue set_value_silent(const IAny& from) = 0;
+    /**
+     * @brief Applies a deferred write of trivially copyable data, queued by set_trivial_data().
+     *
+     * Like set_value_silent() for raw bytes stored straight into the State field, which is only
+     * possible while no extension is installed. A change that nothing observes (no on_changed
+     * event was created) is completed here, so it needs no notify_changed().
+     * @return ReturnValue::Success if the value changed and the caller should call notify_changed().
+     *         ReturnValue::NothingToDo if unchanged or already completed.
+     *         ReturnValue::Refused if the field is not directly accessible; use set_value_silent().
+     */
+    virtual ReturnValue apply_trivial_data(const void* data, size_t size, Uid type) = 0;
+    /**
+     * @brief Fires on_changed with the current value.
+     *
+     * With ObjectFlags::CompareOnWrite the event is suppressed if the value equals the one
+     * last notified, compared with memcmp for trivially copyable types.
+     * @return ReturnValue::Success if on_changed fired, ReturnValue::NothingToDo if suppressed.
+     */
+    virtual ReturnValue notify_changed() = 0;
     /**
      * @brief Installs an IAnyExtension at the head of the property's any chain.
      * @param extension Must implement IAnyExtension. Its inner will be set to the current data.
@@ -0,0 +1,45 @@
+#ifndef VELK_INTF_THREAD_POOL_H
+#define VELK_INTF_THREAD_POOL_H
+
+#include <velk/interface/intf_executor.h>
+#include <velk/interface/intf_function.h>
+#include <velk/interface/intf_future.h>
+
+namespace velk {
+
+/**
+ * @brief Executor that owns a pool of worker threads.
+ *
+ * Each worker keeps a deque of tasks. Tasks posted from a worker go to the front of its own
+ * deque, others are spread over the workers, and a worker whose deque is empty steals from the
+ * back of the others' deques. Functions invoked with InvokeType::Pool and continuations added
+ * with it run on the pool of the instance, see IVelk::get_thread_pool().
+ *
+ * Releasing the last reference runs the tasks still queued, then joins the workers. It must
+ * therefore not happen from within one of those tasks.
+ */
+class IThreadPool : public Interface<IThreadPool, IExecutor>
+{
+public:
+    /** @brief Returns the number of worker threads. */
+    virtual size_t get_thread_count() const = 0;
+
+    /**
+     * @brief Invokes @p fn with @p args on a worker thread.
+     *
+     * The args are cloned, as for a Deferred invocation.
+     */
+    virtual void post(const IFunction::ConstPtr& fn, FnArgs args = {}) = 0;
+
+    /**
+     * @brief Invokes @p fn on a worker thread.
+     *
+     * @p fn is skipped if the returned future is cancelled before a worker picks it up.
+     * @return A future that resolves with the IAny::Ptr @p fn returns, or nullptr if @p fn is null.
+     */
+    virtual IFuture::Ptr async(const IFunction::ConstPtr& fn) = 0;
+};
+
+} // namespace velk
+
+#endif // VELK_INTF_THREAD_POOL_H
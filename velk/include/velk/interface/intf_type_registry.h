@@ -1,48 +1,136 @@
 #ifndef VELK_INTF_TYPE_REGISTRY_H
 #define VELK_INTF_TYPE_REGISTRY_H
 
+#include <velk/array_view.h>
 #include <velk/interface/intf_any.h>
 #include <velk/interface/intf_object_factory.h>
 #include <velk/interface/types.h>
 
+#include <atomic>
+#include <cstddef>
+
 namespace velk {
 
 /** @brief Interpolation callback: interpolates between two type-erased values. */
 using InterpolatorFn = ReturnValue (*)(const IAny& from, const IAny& to, float t, IAny& result);
 
+/**
+ * @brief Unboxed interpolation callback: interpolates between two values of the registered type.
+ *
+ * @p from, @p to and @p result point to suitably aligned objects of the type, which lets callers
+ * that keep values unboxed interpolate without going through IAny.
+ */
+using RawInterpolatorFn = void (*)(const void* from, const void* to, float t, void* result);
+
+/**
+ * @brief The registration of a class, resolved once by ITypeRegistry::get_factory_handle().
+ *
+ * Creates instances of the class without looking it up again, for code that creates many
+ * instances of the same class. The handle follows the registration: it stays empty while the
+ * class is unregistered, e.g. after the plugin that registered it is unloaded, and picks up the
+ * factory of a later registration of the class. It stays usable for the lifetime of the
+ * instance; creating through it must not race with unloading the plugin of the class.
+ *
+ * Instances are created with IObjectFactory::create_instance(), so unlike IVelk::create()
+ * they never come from the object pool of the instance.
+ */
+class FactoryHandle
+{
+public:
+    using FactorySlot = std::atomic<const IObjectFactory*>;
+
+    FactoryHandle() = default;
+    /** @brief Constructs a handle reading the factory from @p slot. Used by the type registry. */
+    explicit FactoryHandle(const FactorySlot* slot) : slot_(slot) {}
+
+    /** @brief Returns the current factory of the class, or null while it is unregistered. */
+    const IObjectFactory* get() const { return slot_ ? slot_->load(std::memory_order_acquire) : nullptr; }
+    /** @brief Returns true if the class is registered. */
+    explicit operator bool() const { return get() != nullptr; }
+
+    /** @brief Creates an instance, or returns null while the class is unregistered. */
+    IObject::Ptr create(uint32_t flags = ObjectFlags::None) const
+    {
+        auto* factory = get();
+        return factory ? factory->create_instance(flags) : nullptr;
+    }
+    /** @brief Typed create(). */
+    template <class T>
+    typename T::Ptr create(uint32_t flags = ObjectFlags::None) const
+    {
+        return interface_pointer_cast<T>(create(flags));
+    }
+    /**
+     * @brief Creates @p count instances into @p out in one allocation, see
+     *        IObjectFactory::create_instances().
+     * @return The number of instances created: @p count, or 0 while the class is unregistered.
+     */
+    size_t create_n(IObject::Ptr* out, size_t count, uint32_t flags = ObjectFlags::None) const
+    {
+        auto* factory = get();
+        return factory ? factory->create_instances(count, flags, out) : 0;
+    }
+
+private:
+    const FactorySlot* slot_{};
+};
+
 /**
  * @brief Interface for registering, unregistering, and querying object type factories.
  *
  * Extracted from IVelk so that subsystems needing only type registration
  * can depend on ITypeRegistry without pulling in factory/deferred-task APIs.
+ *
+ * All functions may be called from any thread. Looking up a type, as IVelk::create() does, takes
+ * no lock, even while another thread registers types.
  */
 class ITypeRegistry : public Interface<ITypeRegistry>
 {
 public:
     /** @brief Registers an object factory for the type it describes. */
     virtual ReturnValue register_type(const IObjectFactory& factory) = 0;
+    /**
+     * @brief Registers the object factories @p factories under one lock, growing the lookup
+     *        table at most once.
+     * @return InvalidArgument if any of the factories is null, in which case none is registered.
+     */
+    virtual ReturnValue register_types(array_view<const IObjectFactory*> factories) = 0;
     /** @brief Unregisters a previously registered object factory. */
     virtual ReturnValue unregister_type(const IObjectFactory& factory) = 0;
     /** @brief Returns the ClassInfo for a registered type, or nullptr if not found. */
     virtual const ClassInfo* get_class_info(Uid classUid) const = 0;
     /** @brief Returns the factory for a registered type, or nullptr if not found. */
     virtual const IObjectFactory* find_factory(Uid classUid) const = 0;
+    /**
+     * @brief Returns a handle that creates instances of a registered type without looking it up.
+     * @return The handle, or an empty one if @p classUid is not registered.
+     */
+    virtual FactoryHandle get_factory_handle(Uid classUid) const = 0;
 
-    /** @brief Registers an interpolator function for a given type UID. */
-    virtual ReturnValue register_interpolator(Uid typeUid, InterpolatorFn fn) = 0;
+    /**
+     * @brief Registers an interpolator function for a given type UID.
+     * @param raw Optional unboxed equivalent of @p fn, see find_raw_interpolator().
+     */
+    virtual ReturnValue register_interpolator(Uid typeUid, InterpolatorFn fn,
+                                              RawInterpolatorFn raw = nullptr) = 0;
     /** @brief Unregisters a previously registered interpolator for a given type UID. */
     virtual ReturnValue unregister_interpolator(Uid typeUid) = 0;
     /** @brief Finds the interpolator function for a given type UID, or nullptr if not registered. */
     virtual InterpolatorFn find_interpolator(Uid typeUid) const = 0;
+    /**
+     * @brief Finds the unboxed interpolator registered with the interpolator of a given type UID.
+     * @return The function, or nullptr if none was registered with the current interpolator.
+     */
+    virtual RawInterpolatorFn find_raw_interpolator(Uid typeUid) const = 0;
 
     /**
      * @brief Registers an interpolator function for type T.
      * @tparam T The value type to associate the interpolator with.
      */
     template <class T>
-    ReturnValue register_interpolator(InterpolatorFn fn)
+    ReturnValue register_interpolator(InterpolatorFn fn, RawInterpolatorFn raw = nullptr)
     {
-        return register_interpolator(type_uid<T>(), fn);
+        return register_interpolator(type_uid<T>(), fn, raw);
     }
     /**
      * @brief Unregisters a previously registered interpolator for type T.
@@ -63,6 +151,16 @@ public:
     {
         return register_type(T::get_factory());
     }
+    /**
+     * @brief Registers several types using their static get_factory() methods, see
+     *        register_types(array_view<const IObjectFactory*>).
+     */
+    template <class... T>
+    ReturnValue register_types()
+    {
+        const IObjectFactory* factories[] = {&T::get_factory()...};
+        return register_types({factories, sizeof...(T)});
+    }
     /**
      * @brief Unregisters a previously registered type using its static get_factory() method.
      * @tparam T An Object-derived class with a static get_factory() method.
@@ -81,6 +179,15 @@ public:
     {
         return get_class_info(T::class_id());
     }
+    /**
+     * @brief Returns the factory handle of a type using its static class_id() method.
+     * @tparam T An Object-derived class with a static class_id() method.
+     */
+    template <class T>
+    FactoryHandle get_factory_handle() const
+    {
+        return get_factory_handle(T::class_id());
+    }
 };
 
 } // namespace velk
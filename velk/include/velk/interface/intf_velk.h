@@ -1,7 +1,11 @@
 #ifndef INTF_VELK_H
 #define INTF_VELK_H
 
+#include <velk/allocator.h>
+#include <velk/interface/intf_binding_registry.h>
+#include <velk/interface/intf_executor.h>
 #include <velk/interface/intf_future.h>
+#include <velk/interface/intf_thread_pool.h>
 #include <velk/interface/intf_log.h>
 #include <velk/interface/intf_object.h>
 #include <velk/interface/intf_object_factory.h>
@@ -52,13 +56,46 @@ struct DeferredTask
     IFunction::ConstPtr fn;
     /** @brief Cloned function args. Shared across tasks that originated from the same invocation. */
     shared_ptr<DeferredArgs> args;
+    /**
+     * @brief If true, the task replaces the args of a coalesced task for the same function still
+     *        queued, so the function runs once per update() with the latest args.
+     */
+    bool coalesce{};
+    /**
+     * @brief Ordering key. With an executor set through IVelk::set_executor(), tasks with a
+     *        nonzero key run on the executor after the unkeyed tasks of the same update(), and
+     *        tasks with the same key run one after another in queue order. Tasks with key 0
+     *        run on the thread calling update().
+     */
+    uint64_t key{};
+    /** @brief Lane the task runs in. */
+    DeferredPriority priority{NormalPriority};
 };
 
-/** @brief Deferred property write queued for the next update() call. */
+/**
+ * @brief Deferred property write queued for the next update() call.
+ *
+ * The value is either a cloned any in @c value, or the bytes of a trivially copyable value in
+ * @c inlineData. A set with neither only fires on_changed of the property.
+ */
 struct DeferredPropertySet
 {
+    /** @brief Capacity of @c inlineData in bytes. */
+    static constexpr size_t INLINE_SIZE = 16;
+
     IPropertyInternal::WeakPtr property; ///< Weak ref to the property. Skipped if expired before flush.
     IAny::Ptr value;                     ///< Cloned value to apply.
+    /**
+     * @brief True if @c value came from IVelk::acquire_deferred_value() and is not referenced
+     *        elsewhere, so update() may reuse it for later deferred writes once applied.
+     */
+    bool recycle{};
+    uint8_t inlineSize{}; ///< Size of the value in @c inlineData, 0 if none.
+    Uid inlineType;       ///< Type of the value in @c inlineData.
+    alignas(INLINE_SIZE) unsigned char inlineData[INLINE_SIZE]; ///< Trivially copyable value to apply.
+
+    /** @brief Returns true if the set carries a value, false if it only notifies. */
+    bool has_value() const { return value || inlineSize; }
 };
 
 /** @brief Information passed to each update cycle. */
@@ -94,6 +131,11 @@ public:
     /** @brief Returns the plugin registry (const). */
     virtual const IPluginRegistry& plugin_registry() const = 0;
 
+    /** @brief Returns the binding registry for binding properties to each other. */
+    virtual IBindingRegistry& binding_registry() = 0;
+    /** @brief Returns the binding registry (const). */
+    virtual const IBindingRegistry& binding_registry() const = 0;
+
     /** @brief Returns the log interface for configuring and emitting log messages. */
     virtual ILog& log() = 0;
     /** @brief Returns the log interface (const). */
@@ -110,15 +152,148 @@ public:
      */
     virtual void queue_deferred_property(DeferredPropertySet task) const = 0;
     /**
-     * @brief Executes all queued deferred tasks and notifies opted-in plugins.
+     * @brief Enqueues several deferred property writes for the next update() call.
+     *
+     * Equivalent to queue_deferred_property() for each of @p tasks in order, but takes the queue
+     * lock once, for callers that write many properties in one pass.
+     * @param tasks The deferred property sets to queue.
+     */
+    virtual void queue_deferred_properties(array_view<DeferredPropertySet> tasks) const = 0;
+    /**
+     * @brief Returns an any to stage a deferred write to a property holding @p prototype in.
+     *
+     * Reuses a value applied by an earlier update() when one of the same type is available,
+     * and clones @p prototype otherwise, so a steady stream of deferred writes stops allocating.
+     * Queue the filled value with DeferredPropertySet::recycle set.
+     *
+     * @param prototype The current value of the property.
+     * @return The staging value, with unspecified contents.
+     */
+    virtual IAny::Ptr acquire_deferred_value(const IAny& prototype) const = 0;
+    /**
+     * @brief Enqueues @p fn with a clone of @p args for the next update() call.
+     *
+     * Equivalent to queue_deferred_tasks() with a single task, except that the cloned args
+     * live in an arena that is recycled every update() rather than in a DeferredArgs of their own.
+     *
+     * @param fn The function to invoke.
+     * @param args Arguments to clone for the call.
+     * @param type Deferred or DeferredCoalesced, optionally combined with the DeferredPriority lane
+     *             of the task.
+     * @param key Ordering key, see DeferredTask::key.
+     */
+    virtual void queue_deferred_call(const IFunction::ConstPtr& fn, FnArgs args, InvokeType type = Deferred,
+                                     uint64_t key = 0) const = 0;
+    /**
+     * @brief Enqueues the deferred handlers of an event for the next update() call.
+     *
+     * Queues a single record holding @p event and a clone of @p args, however many deferred
+     * handlers the event has. update() invokes the deferred handlers registered at that time,
+     * so a handler removed before then is not called. The cloned args live in an arena that
+     * is recycled every update().
+     *
+     * With @p type DeferredCoalesced the record targets the coalesced handlers of the event
+     * instead. If a coalesced record for @p event is still queued, its args are replaced so the
+     * handlers run once with the latest args.
+     *
+     * @param event The event whose deferred handlers to invoke.
+     * @param args Arguments to clone for the handlers.
+     * @param type Deferred or DeferredCoalesced, selecting which handlers to invoke, optionally
+     *             combined with the DeferredPriority lane of the record.
+     */
+    virtual void queue_deferred_handlers(const IEvent::ConstPtr& event, FnArgs args,
+                                         InvokeType type = Deferred) const = 0;
+    /**
+     * @brief Executes queued deferred tasks, applies deferred property sets, re-evaluates dirty
+     *        property bindings and notifies opted-in plugins.
+     *
+     * With a @p budget, update() stops running deferred tasks once the budget is spent and
+     * carries the rest over to the next update(), where it runs before newly queued work.
+     * Deferred property sets and bindings are always applied in full. IPlugin::PostUpdateInfo::tasksPending
+     * reports the carried-over backlog.
+     *
      * @param time Current time in microseconds. If zero, the system clock is used.
+     * @param budget Time to spend on deferred tasks. Zero runs them all.
+     */
+    virtual void update(Duration time = {}, Duration budget = {}) const = 0;
+    /**
+     * @brief Sets how many entries a deferred queue keeps allocated between update() calls.
+     *
+     * The deferred queues are double-buffered and keep their capacity, so a steady workload
+     * queues and runs deferred work without allocating. A buffer that grew beyond @p entries
+     * during a frame is freed after its update() instead. Defaults to 65536.
+     *
+     * @param entries Capacity to retain. 0 frees the buffers after every update().
      */
-    virtual void update(Duration time = {}) const = 0;
+    virtual void set_deferred_retain_limit(size_t entries) = 0;
+    /**
+     * @brief Returns the counters and phase timings of the last completed update() call.
+     *
+     * Lets an application attribute frame spikes to a phase or plugin without a profiler.
+     * The returned reference, and the plugin timings it points to, are overwritten by the
+     * next update(), so read them from the thread that calls update().
+     */
+    virtual const UpdateStats& get_update_stats() const = 0;
+    /**
+     * @brief Returns the live bytes and allocation counts of each MemoryCategory.
+     *
+     * Subsystems keep relaxed atomic counters that are read without locking, apart from the
+     * DeferredQueues category, which sums the capacity of the deferred buffers and counts the
+     * queued entries. Sampling is cheap enough to call every frame. The counters cover the
+     * whole process, not only this instance.
+     */
+    virtual MemoryStats get_memory_stats() const = 0;
+    /**
+     * @brief Sets the sizing of the control block pools of all threads.
+     *
+     * Pools pick up the new capacity the next time one of them fills up. Like the pools, the
+     * configuration is shared by the whole process. Has no effect if velk was built without
+     * VELK_ENABLE_BLOCK_POOL.
+     */
+    virtual void set_block_pool_config(const BlockPoolConfig& config) = 0;
+    /** @brief Returns the configuration set with set_block_pool_config(). */
+    virtual BlockPoolConfig get_block_pool_config() const = 0;
+    /**
+     * @brief Returns the hit and miss counters of the control block pools of all threads.
+     *
+     * The counters are cumulative and cover the whole process; sample them twice and compare
+     * to tune the BlockPoolConfig of a workload.
+     */
+    virtual BlockPoolStats get_block_pool_stats() const = 0;
+    /**
+     * @brief Frees the memory of destroyed instances that classes with VELK_RECYCLE_INSTANCES()
+     *        keep for reuse.
+     *
+     * Frees the memory of the calling thread at once, and that of other threads the next time
+     * they create or destroy a recycling instance. Has no effect if velk was built without
+     * VELK_ENABLE_BLOCK_POOL, which also disables recycling.
+     */
+    virtual void trim_recycled_objects() = 0;
+    /**
+     * @brief Sets the executor that update() runs keyed deferred tasks on.
+     *
+     * Without an executor, keyed tasks run on the thread calling update() like any other.
+     * Must not be called while update() runs.
+     *
+     * @param executor The executor, or null to run every task on the calling thread.
+     * @see DeferredTask::key
+     */
+    virtual void set_executor(const IExecutor::Ptr& executor) = 0;
+    /** @brief Returns the executor set with set_executor(), or null. */
+    virtual IExecutor::Ptr get_executor() const = 0;
 
     /** @brief Creates an ObjectStorage for the given class info and owner. */
     virtual IObjectStorage* create_metadata_container(const ClassInfo& info, IInterface* owner) const = 0;
     /** @brief Destroys an ObjectStorage previously created by create_metadata_container. */
     virtual void destroy_metadata_container(IObjectStorage* storage) const = 0;
+    /**
+     * @brief Constructs an ObjectStorage in memory owned by the caller, e.g. inside its owner.
+     * @param location Holds OBJECT_STORAGE_SIZE bytes aligned to OBJECT_STORAGE_ALIGNMENT.
+     */
+    virtual IObjectStorage* construct_metadata_container(void* location, const ClassInfo& info,
+                                                         IInterface* owner) const = 0;
+    /** @brief Destroys an ObjectStorage built by construct_metadata_container, keeping its memory. */
+    virtual void destruct_metadata_container(IObjectStorage* storage) const = 0;
 
     /** @brief Creates an instance of a registered type by its UID. */
     virtual IInterface::Ptr create(Uid uid, uint32_t flags = ObjectFlags::None) const = 0;
@@ -129,6 +304,32 @@ public:
                                            uint32_t flags = ObjectFlags::None) const = 0;
     /** @brief Creates a new future/promise pair. */
     virtual IFuture::Ptr create_future() const = 0;
+    /**
+     * @brief Creates a future that resolves, without a value, once all of @p futures are ready.
+     *
+     * The inputs share one counter, so joining thousands of futures allocates no callback per
+     * input. Resolves immediately when @p futures is empty. Returns nullptr if an entry is null.
+     */
+    virtual IFuture::Ptr when_all(array_view<IFuture::Ptr> futures) const = 0;
+    /**
+     * @brief Creates a future that resolves once the first of @p futures is ready.
+     *
+     * The result is the uint32_t index of that future in @p futures. Returns nullptr if
+     * @p futures is empty or an entry is null.
+     */
+    virtual IFuture::Ptr when_any(array_view<IFuture::Ptr> futures) const = 0;
+    /**
+     * @brief Creates a pool of @p thread_count worker threads.
+     * @param thread_count Number of workers; 0 starts one per hardware thread but the calling one.
+     */
+    virtual IThreadPool::Ptr create_thread_pool(size_t thread_count = 0) const = 0;
+    /**
+     * @brief Sets the pool that InvokeType::Pool invocations and continuations run on.
+     * @param pool The pool, or null to have get_thread_pool() create a default one again.
+     */
+    virtual void set_thread_pool(const IThreadPool::Ptr& pool) = 0;
+    /** @brief Returns the pool set with set_thread_pool(), creating a default one on first use. */
+    virtual IThreadPool::Ptr get_thread_pool() const = 0;
     /** @brief Creates a callback-backed IFunction from a raw function pointer. */
     virtual IFunction::Ptr create_callback(IFunction::CallableFn* fn) const = 0;
     /** @brief Creates an owned-callback IFunction from a context, trampoline, and deleter. */
@@ -164,6 +365,17 @@ ReturnValue register_type(IVelk& instance)
     return instance.type_registry().register_type(T::get_factory());
 }
 
+/**
+ * @brief Registers several types for a given velk instance in one call, see
+ *        ITypeRegistry::register_types().
+ * @tparam T Object-derived classes with a static get_factory() method.
+ */
+template <class... T>
+ReturnValue register_types(IVelk& instance)
+{
+    return instance.type_registry().template register_types<T...>();
+}
+
 /**
  * @brief Unregisters a previously registered type from a given velk instance using
  *        its static get_factory() method.
@@ -5,6 +5,7 @@
 #include <velk/api/traits.h>
 #include <velk/array_view.h>
 #include <velk/common.h>
+#include <velk/interface/intf_function.h>
 #include <velk/interface/intf_interface.h>
 
 #include <cstdint>
@@ -20,6 +21,21 @@ enum class MemberKind : uint8_t
     ArrayProperty
 };
 
+/** @brief Returns the bit of @p kind in a MemberKinds mask. */
+constexpr uint32_t member_kind_bit(MemberKind kind)
+{
+    return uint32_t(1) << static_cast<uint32_t>(kind);
+}
+
+/** @brief Masks selecting member kinds, e.g. for IMetadata::materialize_all(). */
+namespace MemberKinds {
+inline constexpr uint32_t Property = member_kind_bit(MemberKind::Property);
+inline constexpr uint32_t Event = member_kind_bit(MemberKind::Event);
+inline constexpr uint32_t Function = member_kind_bit(MemberKind::Function);
+inline constexpr uint32_t ArrayProperty = member_kind_bit(MemberKind::ArrayProperty);
+inline constexpr uint32_t All = Property | Event | Function | ArrayProperty;
+} // namespace MemberKinds
+
 /** @brief Discriminator for the kind of notification to broadcast. */
 enum class Notification : uint8_t
 {
@@ -30,6 +46,10 @@ enum class Notification : uint8_t
 
 /** @brief Function pointer type for trampoline callbacks that route to virtual methods. */
 using FnTrampoline = IAny::Ptr (*)(void* self, FnArgs args);
+/** @brief Function pointer type for typed trampolines that call virtual methods with raw values. */
+using FnTypedTrampoline = IFunction::TypedFn*;
+/** @brief Function pointer type for trampolines that write the virtual method's result into an IAny. */
+using FnResultTrampoline = IFunction::ResultFn*;
 
 /** @brief Kind-specific data for Property members. */
 struct PropertyKind
@@ -40,6 +60,11 @@ struct PropertyKind
     /** @brief Creates an AnyRef pointing into the State struct at @p stateBase. */
     IAny::Ptr (*createRef)(void* stateBase) = nullptr;
     uint32_t flags{ObjectFlags::None}; ///< ObjectFlags to apply to the created PropertyImpl.
+    /** @brief Returns the byte offset of the property's value in its State struct. */
+    size_t (*stateOffset)() = nullptr;
+    /** @brief Returns the property's value in @p stateBase, or nullptr if it must be accessed via createRef. */
+    void* (*stateData)(void* stateBase) = nullptr;
+    bool trivial{}; ///< The value type (the element type of an array) is trivially copyable.
 };
 
 /** @brief Kind-specific data for ArrayProperty members.
@@ -60,11 +85,22 @@ struct FnArgDesc
     Uid typeUid;      ///< type_uid<T>() for the parameter type.
 };
 
+/** @brief Kind-specific data of a COMPUTED member, which is described as a zero-arg Function. */
+struct ComputedKind
+{
+    array_view<string_view> inputs; ///< Names of the properties of the same interface it depends on.
+    /** @brief Returns the stale flag of the cached value in the State struct at @p stateBase. */
+    bool* (*stale)(void* stateBase) = nullptr;
+};
+
 /** @brief Kind-specific data for Function/Event members. */
 struct FunctionKind
 {
     FnTrampoline trampoline = nullptr; ///< Static trampoline that routes invoke() to the virtual method.
     array_view<FnArgDesc> args;        ///< Typed argument descriptors; empty for zero-arg and FN_RAW.
+    FnTypedTrampoline typed = nullptr; ///< Typed trampoline for invoke_typed(); null for FN_RAW.
+    FnResultTrampoline into = nullptr; ///< Trampoline for invoke_into(); null to copy from invoke().
+    const ComputedKind* computed = nullptr; ///< Set if the function reads a COMPUTED member.
 };
 
 /** @brief Describes a single member (property, event, or function) declared by an object class. */
@@ -99,6 +135,12 @@ struct MemberDesc
                    ? static_cast<const FunctionKind*>(ext)
                    : nullptr;
     }
+    /// Typed ext member getter for a Function member declared with COMPUTED
+    constexpr const ComputedKind* computedKind() const
+    {
+        auto* fk = functionKind();
+        return fk ? fk->computed : nullptr;
+    }
 };
 
 /**
@@ -166,6 +208,71 @@ constexpr MemberDesc FunctionDesc(string_view name, const InterfaceInfo* info =
     return {name, MemberKind::Function, info, fk};
 }
 
+/**
+ * @brief Precomputed identifier of a member name: the FNV-1a 64-bit hash of the name.
+ *
+ * Constructing a MemberId in a constant expression moves the string work to compile time,
+ * so lookups through IMetadata::get_member() do not hash or compare names at runtime.
+ */
+struct MemberId
+{
+    uint64_t hash{}; ///< FNV-1a 64-bit hash of the member name.
+
+    constexpr MemberId() = default;
+    constexpr explicit MemberId(string_view name) : hash(0xcbf29ce484222325ull)
+    {
+        for (char c : name) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3ull;
+        }
+    }
+
+    constexpr bool operator==(MemberId other) const { return hash == other.hash; }
+    constexpr bool operator!=(MemberId other) const { return hash != other.hash; }
+};
+
+/** @brief Returns the key of member @p id of @p kind in a MemberTable. */
+constexpr uint64_t member_key(MemberId id, MemberKind kind)
+{
+    return id.hash ^ ((static_cast<uint64_t>(kind) + 1) * 0x9e3779b97f4a7c15ull);
+}
+
+/**
+ * @brief Compile-time perfect hash table from member keys to member indices of a class.
+ *
+ * Built by ext::Object from the collected metadata (see ext::make_member_table()). A key
+ * selects a bucket by hashing with seed 0; the bucket's entry in @c seeds either names its
+ * slot directly (negative: -(slot + 1)) or gives the seed that hashes its keys to distinct
+ * slots. Every member key maps to its own slot, so a lookup is two hashes and one compare.
+ */
+struct MemberTable
+{
+    static constexpr uint16_t Empty = 0xffff; ///< Slot value of an unused slot.
+
+    const int32_t* seeds;  ///< Per-bucket seed, or -(slot + 1) for single-key buckets.
+    const uint16_t* slots; ///< Member index of each slot, or Empty.
+    const uint64_t* keys;  ///< member_key() of each member, indexed by member position.
+    uint32_t mask;         ///< Number of buckets and slots minus one.
+
+    /** @brief Hashes @p key with @p seed. */
+    static constexpr uint64_t hash(uint64_t key, uint32_t seed)
+    {
+        key ^= seed * 0x9e3779b97f4a7c15ull;
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return key;
+    }
+
+    /** @brief Returns the index of the member with @p key, or Empty. */
+    constexpr uint16_t find(uint64_t key) const
+    {
+        int32_t seed = seeds[hash(key, 0) & mask];
+        uint16_t index = slots[seed < 0 ? -seed - 1 : hash(key, seed) & mask];
+        return index != Empty && keys[index] == key ? index : Empty;
+    }
+};
+
 } // namespace velk
 
 #endif // VELK_MEMBER_DESC_H
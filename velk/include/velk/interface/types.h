@@ -7,7 +7,8 @@
 
 namespace velk {
 
-struct MemberDesc; // Forward declaration
+struct MemberDesc;  // Forward declaration
+struct MemberTable; // Forward declaration
 
 /** @brief Describes a registered class with its UID, name, and static metadata. */
 struct ClassInfo
@@ -16,6 +17,7 @@ struct ClassInfo
     const string_view name;                     ///< Human-readable class name.
     const array_view<InterfaceInfo> interfaces; ///< Interfaces implemented by this class.
     const array_view<MemberDesc> members;       ///< Static metadata members (empty when no metadata).
+    const MemberTable* memberTable = nullptr;   ///< Perfect hash of @c members, or null to search them.
 };
 
 /** @brief Compile-time class identifiers for built-in object types. */
@@ -32,6 +34,8 @@ inline constexpr Uid Future{"371dfa91-1cf7-441e-b688-20d7e0114745"};
 inline constexpr Uid ArrayProperty{"f8e2a3b1-7c4d-49e6-8f1a-2b3c4d5e6f70"};
 /** @brief Default hierarchy object implementation. */
 inline constexpr Uid Hierarchy{"b7d3e1a2-5f48-4c96-9e0a-1d2b3c4e5f67"};
+/** @brief Hierarchy implementation storing the tree in a dense node array. */
+inline constexpr Uid FlatHierarchy{"cc14dd6b-bee4-4989-b8cb-973615e41f68"};
 } // namespace ClassId
 
 /** @brief A duration in microseconds. */
@@ -66,6 +70,18 @@ namespace ObjectFlags {
 inline constexpr uint32_t None = 0;
 inline constexpr uint32_t ReadOnly = 1 << 0;    ///< Property rejects writes via set_value/set_data.
 inline constexpr uint32_t HiveManaged = 1 << 1; ///< Object is managed by a Hive.
+inline constexpr uint32_t StateColumn = 1 << 2; ///< Some State structs live in a hive state column.
+/// Property fires on_changed only if its value differs from the one it last notified.
+inline constexpr uint32_t CompareOnWrite = 1 << 3;
+inline constexpr uint32_t DirtyTracking = 1 << 4; ///< Property changes mark the object dirty in its hive.
+/// Object is only used by the thread that created it, so its reference counts are not atomic.
+/// Applies to objects created by a factory; debug builds assert the thread in ref()/unref().
+inline constexpr uint32_t ThreadConfined = 1 << 5;
+/// Object was frozen with IObjectStorage::freeze(): its members are read-only and fire no events.
+inline constexpr uint32_t Frozen = 1 << 6;
+/// Passed to IVelk::create(): takes the instance from the object pool of the instance when its
+/// class is pooled. Not kept by the object.
+inline constexpr uint32_t Pooled = 1 << 7;
 } // namespace ObjectFlags
 
 /** @brief Controls whether metadata lookups create instances on miss. */
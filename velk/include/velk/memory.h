@@ -34,15 +34,25 @@ struct control_block
     ///  bit 0 (external): block is an external_control_block with a destroy function pointer.
     ///  bit 1 (embedded): block lives inside a larger allocation (e.g. a hive page) and must
     ///                     not be individually deleted or returned to the pool.
+    ///  bit 2 (local):    the counts are only touched by one thread (ObjectFlags::ThreadConfined)
+    ///                     and are updated with plain loads and stores instead of atomic RMWs.
     static constexpr uintptr_t tag_external = 1;
     static constexpr uintptr_t tag_embedded = 2;
-    static constexpr uintptr_t tag_mask = tag_external | tag_embedded;
+    static constexpr uintptr_t tag_local = 4;
+    static constexpr uintptr_t tag_mask = tag_external | tag_embedded | tag_local;
 
     std::atomic<int32_t> strong{0};
     std::atomic<int32_t> weak{1}; ///< 1 = "strong group exists"
 
     /** @brief Increments the strong count (relaxed). */
-    void add_ref() { strong.fetch_add(1, std::memory_order_relaxed); }
+    void add_ref()
+    {
+        if (is_local()) {
+            strong.store(strong.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        } else {
+            strong.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
 
     /**
      * @brief Decrements the strong count (acq_rel).
@@ -50,6 +60,11 @@ struct control_block
      */
     bool release_ref()
     {
+        if (is_local()) {
+            int32_t count = strong.load(std::memory_order_relaxed) - 1;
+            strong.store(count, std::memory_order_relaxed);
+            return count == 0;
+        }
         if (strong.fetch_sub(1, std::memory_order_acq_rel) == 1) {
             return true;
         }
@@ -67,6 +82,12 @@ struct control_block
     bool try_add_ref()
     {
         int32_t old = strong.load(std::memory_order_relaxed);
+        if (is_local()) {
+            if (old > 0) {
+                strong.store(old + 1, std::memory_order_relaxed);
+            }
+            return old > 0;
+        }
         while (old > 0) {
             if (strong.compare_exchange_weak(
                     old, old + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
@@ -105,17 +126,38 @@ struct control_block
     /** @brief Returns true if the embedded tag is set. */
     bool is_embedded() const { return reinterpret_cast<uintptr_t>(ptr_) & tag_embedded; }
 
+    /** @brief Sets the local tag. Preserves other tags. */
+    void set_local_tag() { ptr_ = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(ptr_) | tag_local); }
+
+    /** @brief Returns true if the local tag is set. */
+    bool is_local() const { return reinterpret_cast<uintptr_t>(ptr_) & tag_local; }
+
     /** @brief Increments the weak count (relaxed). */
-    void add_weak() { weak.fetch_add(1, std::memory_order_relaxed); }
+    void add_weak()
+    {
+        if (is_local()) {
+            weak.store(weak.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        } else {
+            weak.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
 
     /**
      * @brief Decrements the weak count (acq_rel).
      * @return true if this was the last weak ref (caller must deallocate the block).
      */
-    bool release_weak() { return weak.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+    bool release_weak()
+    {
+        if (is_local()) {
+            int32_t count = weak.load(std::memory_order_relaxed) - 1;
+            weak.store(count, std::memory_order_relaxed);
+            return count == 0;
+        }
+        return weak.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
 
 private:
-    void* ptr_{nullptr}; ///< Tagged pointer: bit 0 = external, bit 1 = embedded, bits 2+ = object address.
+    void* ptr_{nullptr}; ///< Tagged pointer: bits 0-2 = external, embedded, local; bits 3+ = address.
 };
 
 /**
@@ -155,6 +197,19 @@ VELK_EXPORT control_block* alloc_control_block(bool external = false);
  */
 VELK_EXPORT void dealloc_control_block(control_block* block, bool external = false);
 
+/** @brief Starts a ReclaimScope. */
+VELK_EXPORT void enter_reclaim_scope();
+/** @brief Ends a ReclaimScope, destroying the objects the calling thread retired that no open scope may refer to. */
+VELK_EXPORT void leave_reclaim_scope();
+/**
+ * @brief Defers destroying @p object until the ReclaimScopes open on any thread have ended.
+ *
+ * Called by ext::RefCountedDispatch::unref() once the strong count reached zero. The object is
+ * destroyed later by the calling thread.
+ * @return true if the object was retired, false if no scope is open and the caller destroys it.
+ */
+VELK_EXPORT bool retire_object(void (*destroy)(void*), void* object);
+
 /**
  * @brief Releases the "strong group" weak ref, freeing the block if no weak_ptrs remain.
  *
@@ -230,6 +285,34 @@ inline constexpr adopt_ref_t adopt_ref{};
 
 class IInterface;
 
+/**
+ * @brief Defers the destruction of velk objects while alive, so weak references can be read
+ *        without locking them.
+ *
+ * An object derived from ext::RefCountedDispatch whose last strong reference is released while
+ * any thread has a scope open is retired rather than destroyed at once. Its strong count still
+ * drops to zero, so weak_ptr::lock() and weak_ptr::peek() see it as expired. This makes the raw
+ * pointer returned by weak_ptr::peek() valid until the scope ends, without the atomic increment
+ * and decrement of lock().
+ *
+ * Each thread tracks its scopes in its own epoch record. A retired object is destroyed by the
+ * thread that released it, once the scopes open at the time of the release have ended: when that
+ * thread leaves its own scope, or at its next release. Scopes opened later do not delay it. An
+ * object the thread still holds when it exits is destroyed by the next thread leaving a scope.
+ * ThreadConfined objects are never retired, since no other thread refers to them.
+ *
+ * Scopes are meant for short loops over many weak references, such as the per-frame passes of
+ * update(). Objects may outlive their last reference by the length of the longest open scope.
+ */
+class ReclaimScope
+{
+public:
+    ReclaimScope() { detail::enter_reclaim_scope(); }
+    ~ReclaimScope() { detail::leave_reclaim_scope(); }
+    ReclaimScope(const ReclaimScope&) = delete;
+    ReclaimScope& operator=(const ReclaimScope&) = delete;
+};
+
 template <class T>
 class shared_ptr;
 template <class T>
@@ -588,6 +671,68 @@ public:
      * Checks whether the strong count has dropped to zero.
      */
     bool expired() const { return !block_ || block_->strong.load(std::memory_order_acquire) == 0; }
+
+    /**
+     * @brief Returns the object if it is alive, without adding a reference.
+     *
+     * The pointer stays valid until @p scope ends, since objects released meanwhile are only
+     * destroyed then. Only for objects derived from ext::RefCountedDispatch, which all velk
+     * objects are.
+     */
+    T* peek(const ReclaimScope& scope) const
+    {
+        static_assert(is_interface, "weak_ptr::peek() requires an IInterface-derived type");
+        (void)scope;
+        return expired() ? nullptr : ptr_;
+    }
+};
+
+/**
+ * @brief Non-owning pointer to an object kept alive by someone else (8 bytes).
+ *
+ * Returned by getters whose result is owned by the callee, so that reading it does not touch
+ * any reference count. A borrowed_ptr never extends the lifetime of the object; the getter
+ * documents how long the object stays valid. Copy it into a shared_ptr to keep it longer.
+ *
+ * @tparam T The pointed-to type.
+ */
+template <class T>
+class borrowed_ptr
+{
+public:
+    constexpr borrowed_ptr() = default;
+    constexpr borrowed_ptr(std::nullptr_t) noexcept {}
+    constexpr borrowed_ptr(T* p) noexcept : ptr_(p) {}
+
+    /** @brief Borrows the object owned by @p sp. */
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    borrowed_ptr(const shared_ptr<U>& sp) noexcept : ptr_(sp.get())
+    {}
+
+    /** @brief Converts from a borrowed_ptr to a derived type. */
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    constexpr borrowed_ptr(const borrowed_ptr<U>& o) noexcept : ptr_(o.get())
+    {}
+
+    /** @brief Returns the raw pointer. */
+    constexpr T* get() const noexcept { return ptr_; }
+    constexpr T* operator->() const noexcept { return ptr_; }
+    constexpr T& operator*() const noexcept { return *ptr_; }
+    constexpr explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    template <class U>
+    constexpr bool operator==(const borrowed_ptr<U>& o) const noexcept
+    {
+        return ptr_ == o.get();
+    }
+    template <class U>
+    constexpr bool operator!=(const borrowed_ptr<U>& o) const noexcept
+    {
+        return ptr_ != o.get();
+    }
+
+private:
+    T* ptr_{};
 };
 
 /**
@@ -1,6 +1,7 @@
 #ifndef VELK_STRING_H
 #define VELK_STRING_H
 
+#include <velk/allocator.h>
 #include <velk/string_view.h>
 #include <velk/uid.h>
 
@@ -14,8 +15,8 @@ namespace velk {
  * @brief ABI-stable owning string with small-string optimization.
  *
  * Replacement for std::string in public interface headers.
- * Uses malloc/free for heap buffer management, making it safe across
- * DLL boundaries. Always null-terminated.
+ * Allocates heap buffers through the velk allocator (see set_allocator()), which lives in
+ * the velk library, making it safe across DLL boundaries. Always null-terminated.
  *
  * Strings of up to 22 characters are stored inline (no heap allocation).
  * The last byte of the 24-byte layout discriminates between modes:
@@ -101,7 +102,7 @@ public:
     {
         if (this != &other) {
             if (is_heap()) {
-                std::free(heap_.ptr_);
+                free_buffer(heap_.ptr_);
             }
             std::memcpy(raw_bytes(), other.raw_bytes(), sizeof(*this));
             std::memset(other.raw_bytes(), 0, sizeof(other));
@@ -129,7 +130,7 @@ public:
     ~string()
     {
         if (is_heap()) {
-            std::free(heap_.ptr_);
+            free_buffer(heap_.ptr_);
         }
     }
 
@@ -202,7 +203,7 @@ public:
             }
             local_.buf_[s] = '\0';
             local_.size_ = static_cast<unsigned char>(s);
-            std::free(old_ptr);
+            free_buffer(old_ptr);
         } else {
             size_t real_cap = heap_.capacity_ & ~heap_flag;
             if (real_cap == s) {
@@ -210,7 +211,7 @@ public:
             }
             char* new_buf = alloc_buffer(s + 1);
             std::memcpy(new_buf, heap_.ptr_, s + 1);
-            std::free(heap_.ptr_);
+            free_buffer(heap_.ptr_);
             set_heap(new_buf, s, s);
         }
     }
@@ -252,7 +253,16 @@ public:
         size_t s = size();
         ensure_capacity(s + sv.size());
         char* d = writable_data();
+#if defined(__GNUC__) && !defined(__clang__)
+        // GCC cannot tell that ensure_capacity() left a long string on the heap, since the
+        // buffer comes from velk_alloc(), and warns about copying into the inline buffer.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wstringop-overflow"
+#endif
         std::memcpy(d + s, sv.data(), sv.size());
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
         set_size_and_null(s + sv.size()); // NOLINT(clang-analyzer-unix.Malloc)
         return *this;
     }
@@ -471,14 +481,20 @@ private:
         }
     }
 
-    /** @brief Allocates a raw buffer of @p bytes. Aborts on failure. */
+    /** @brief Allocates a raw buffer of @p bytes through the velk allocator. Aborts on failure. */
     static char* alloc_buffer(size_t bytes)
     {
-        void* p = std::malloc(bytes);
+        void* p = detail::velk_alloc(bytes, alignof(std::max_align_t), MemoryTag::Containers);
         assert(p && "velk::string allocation failed");
         return static_cast<char*>(p);
     }
 
+    /** @brief Frees a buffer allocated with alloc_buffer(). */
+    static void free_buffer(char* p) noexcept
+    {
+        detail::velk_free(p, alignof(std::max_align_t), MemoryTag::Containers);
+    }
+
     /**
      * @brief Grows the buffer to hold at least @p required characters (plus null).
      *
@@ -498,7 +514,7 @@ private:
         }
         new_buf[s] = '\0';
         if (is_heap()) {
-            std::free(heap_.ptr_);
+            free_buffer(heap_.ptr_);
         }
         set_heap(new_buf, s, new_cap);
     }
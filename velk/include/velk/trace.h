@@ -0,0 +1,157 @@
+#ifndef VELK_TRACE_H
+#define VELK_TRACE_H
+
+#include <velk/string_view.h>
+#include <velk/velk_export.h>
+
+#include <cstdint>
+
+/**
+ * @def VELK_ENABLE_TRACING
+ * @brief Compiles in the VELK_TRACE_ZONE and VELK_TRACE_COUNTER instrumentation if nonzero.
+ *
+ * Set by the VELK_ENABLE_TRACING CMake option; off by default, in which case the macros compile
+ * to nothing and set_trace_backend() has no effect on the library.
+ */
+#ifndef VELK_ENABLE_TRACING
+#define VELK_ENABLE_TRACING 0
+#endif
+
+namespace velk {
+
+/** @brief Static description of a traced zone, declared once per call site by VELK_TRACE_ZONE. */
+struct TraceZone
+{
+    const char* name; ///< Name of the zone, a string literal.
+    const char* file; ///< Source file of the zone.
+    int line;         ///< Source line of the zone.
+};
+
+/**
+ * @brief Receiver of the trace events of the library, for feeding a profiler such as Tracy or
+ *        Perfetto.
+ *
+ * Called on whichever thread runs the traced code, so implementations must be thread-safe. Zones
+ * nest per thread: each begin_zone() is followed by the end_zone() of the same zone, on the same
+ * thread, after those of the zones begun in between.
+ */
+class ITraceBackend
+{
+public:
+    /**
+     * @brief Called when a thread enters @p zone.
+     * @param text Dynamic detail of this entry, such as the plugin being updated; may be empty.
+     */
+    virtual void begin_zone(const TraceZone& zone, string_view text) = 0;
+    /** @brief Called when a thread leaves @p zone. */
+    virtual void end_zone(const TraceZone& zone) = 0;
+    /** @brief Reports the current value of the counter @p name, a string literal. */
+    virtual void counter(const char* name, int64_t value) = 0;
+
+protected:
+    ~ITraceBackend() = default;
+};
+
+/**
+ * @brief Routes trace events to @p backend, or stops tracing if null.
+ *
+ * Zones end on the backend they began on, so a replaced backend must stay alive until the zones
+ * open on it have ended; replacing it between update() calls is enough for the library's zones.
+ */
+VELK_EXPORT void set_trace_backend(ITraceBackend* backend);
+
+/** @brief Returns the installed trace backend, or null. */
+VELK_EXPORT ITraceBackend* get_trace_backend();
+
+/**
+ * @brief Starts recording trace events in memory, replacing the installed backend.
+ *
+ * Each thread records into its own buffer of @p capacity events (0 for 65536), without locking.
+ * A thread whose buffer is full records nothing more, except the ends of the zones it began,
+ * and counts the events it drops. Starting again discards the previous recording.
+ *
+ * Zone names are kept by address, so the recording must be written before a module whose zones
+ * it contains is unloaded. Without VELK_ENABLE_TRACING, only zones of code built with it record.
+ */
+VELK_EXPORT void start_trace_recording(size_t capacity = 0);
+
+/** @brief Stops the recording started with start_trace_recording(), keeping its events. */
+VELK_EXPORT void stop_trace_recording();
+
+/**
+ * @brief Writes the events recorded so far as a Chrome trace_event JSON file to @p path, for
+ *        chrome://tracing or Perfetto.
+ *
+ * May be called while recording; events of zones still open are written without their end.
+ * @return false if no recording was started or @p path could not be written.
+ */
+VELK_EXPORT bool write_trace_recording(const char* path);
+
+namespace detail {
+
+/** @brief Reports a zone for its scope to the backend installed when it is constructed. */
+class TraceScope
+{
+public:
+    explicit TraceScope(const TraceZone& zone, string_view text = {})
+        : zone_(zone), backend_(get_trace_backend())
+    {
+        if (backend_) {
+            backend_->begin_zone(zone, text);
+        }
+    }
+    ~TraceScope()
+    {
+        if (backend_) {
+            backend_->end_zone(zone_);
+        }
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const TraceZone& zone_;
+    ITraceBackend* backend_;
+};
+
+/** @brief Reports @p value of the counter @p name to the installed backend, if any. */
+inline void trace_counter(const char* name, int64_t value)
+{
+    if (auto* backend = get_trace_backend()) {
+        backend->counter(name, value);
+    }
+}
+
+} // namespace detail
+
+} // namespace velk
+
+#define _VELK_TRACE_CAT2(a, b) a##b
+#define _VELK_TRACE_CAT(a, b) _VELK_TRACE_CAT2(a, b)
+
+/**
+ * @def VELK_TRACE_ZONE(name)
+ * @brief Traces the rest of the enclosing scope as the zone @p name, a string literal.
+ *
+ * @def VELK_TRACE_ZONE_TEXT(name, text)
+ * @brief VELK_TRACE_ZONE() with the dynamic detail @p text, a string_view.
+ *
+ * @def VELK_TRACE_COUNTER(name, value)
+ * @brief Reports @p value of the counter @p name, a string literal.
+ *
+ * All three compile to nothing, arguments included, unless VELK_ENABLE_TRACING is set.
+ */
+#if VELK_ENABLE_TRACING
+#define VELK_TRACE_ZONE_TEXT(name, text)                                                                   \
+    static constexpr ::velk::TraceZone _VELK_TRACE_CAT(_velk_zone_, __LINE__){name, __FILE__, __LINE__};   \
+    ::velk::detail::TraceScope _VELK_TRACE_CAT(_velk_scope_, __LINE__)(                                    \
+        _VELK_TRACE_CAT(_velk_zone_, __LINE__), text)
+#define VELK_TRACE_ZONE(name) VELK_TRACE_ZONE_TEXT(name, ::velk::string_view{})
+#define VELK_TRACE_COUNTER(name, value) ::velk::detail::trace_counter(name, static_cast<int64_t>(value))
+#else
+#define VELK_TRACE_ZONE_TEXT(name, text) static_cast<void>(0)
+#define VELK_TRACE_ZONE(name) static_cast<void>(0)
+#define VELK_TRACE_COUNTER(name, value) static_cast<void>(0)
+#endif
+
+#endif // VELK_TRACE_H
@@ -1,6 +1,7 @@
 #ifndef VELK_VECTOR_H
 #define VELK_VECTOR_H
 
+#include <velk/allocator.h>
 #include <velk/array_view.h>
 
 #include <cassert>
@@ -27,23 +28,33 @@ class vector_base
 protected:
     vector_base() = default;
 
-    /** @brief Allocates a raw buffer of @p bytes. Aborts on failure. */
+    /** @brief Allocates a raw buffer of @p bytes through the velk allocator. Aborts on failure. */
     static void* alloc_raw(size_t bytes)
     {
-        void* p = std::malloc(bytes);
+        void* p = detail::velk_alloc(bytes, alignof(std::max_align_t), MemoryTag::Containers);
         assert(p && "velk::vector allocation failed");
         return p;
     }
 
+    /** @brief Frees a buffer allocated with alloc_raw(). */
+    static void free_buffer(void* p) noexcept
+    {
+        detail::velk_free(p, alignof(std::max_align_t), MemoryTag::Containers);
+    }
+
     /** @brief Frees the raw buffer. Does not destroy elements. */
     void free_raw() noexcept
     {
-        std::free(data_);
+        free_buffer(data_);
         data_ = nullptr;
         capacity_ = 0;
     }
 
-    /** @brief Computes the next capacity that can hold @p required elements. */
+    /**
+     * @brief Computes the next capacity that can hold @p required elements.
+     *
+     * Starts at min_capacity and doubles. small_vector starts from its inline capacity.
+     */
     static size_t grow_capacity(size_t current, size_t required) noexcept
     {
         size_t cap = current ? current : min_capacity;
@@ -86,7 +97,7 @@ protected:
         if (size_ > 0) {
             std::memcpy(new_buf, data_, size_ * elem_size);
         }
-        std::free(data_);
+        free_buffer(data_);
         data_ = new_buf;
         capacity_ = new_cap;
     }
@@ -102,8 +113,8 @@ protected:
  * @brief ABI-stable owning resizable array.
  *
  * Replacement for std::vector in public interface headers.
- * Uses malloc/free for raw buffer management, making it safe across
- * DLL boundaries.
+ * Allocates its buffer through the velk allocator (see set_allocator()), which lives in
+ * the velk library, making it safe across DLL boundaries.
  *
  * For trivially copyable types, all operations use memcpy/memmove/memset/memcmp.
  * For non-trivial types, uses placement new, explicit destructors, and move semantics.
@@ -300,7 +311,7 @@ public:
             }
             destroy_all();
         }
-        std::free(data_);
+        free_buffer(data_);
         data_ = new_buf;
         capacity_ = size_;
     }
@@ -405,7 +416,7 @@ public:
             std::memcpy(tmp, first, count * sizeof(T));
             ensure_capacity(size_ + count);
             insert_trivial(idx, tmp, count);
-            std::free(tmp);
+            free_buffer(tmp);
         } else {
             vector tmp(first, last);
             ensure_capacity(size_ + count);
@@ -612,7 +623,7 @@ private:
             }
             destroy_all();
         }
-        std::free(data_);
+        free_buffer(data_);
         data_ = new_buf;
         capacity_ = new_cap;
     }
@@ -649,6 +660,352 @@ private:
     }
 };
 
+/**
+ * @brief Resizable array that stores up to @p N elements inline before allocating.
+ *
+ * Suited to lists that usually hold a handful of elements, such as child lists. Once the
+ * elements no longer fit, they move to a heap buffer allocated with the same allocator
+ * and growth policy as vector, and stay there; clear() keeps the buffer.
+ *
+ * Moving a small_vector whose elements are inline moves them one by one, so iterators are not
+ * preserved. Meant for internal data structures; use vector in public interface headers.
+ *
+ * @tparam T The element type.
+ * @tparam N The number of elements stored inline.
+ */
+template <class T, size_t N>
+class small_vector : private vector_base
+{
+    static_assert(N > 0, "small_vector needs inline capacity");
+    static constexpr bool trivial = std::is_trivially_copyable_v<T>;
+
+public:
+    using value_type = T; ///< The element type.
+
+    /** @brief Default-constructs an empty vector using the inline storage. */
+    small_vector() noexcept { reset_inline(); }
+
+    /** @brief Constructs a vector from an initializer list. */
+    small_vector(std::initializer_list<T> init) : small_vector()
+    {
+        reserve(init.size());
+        for (auto& value : init) {
+            new (typed_data() + size_++) T(value);
+        }
+    }
+
+    /** @brief Copy constructor. */
+    small_vector(const small_vector& other) : small_vector()
+    {
+        reserve(other.size_);
+        copy_construct(other.typed_data(), other.size_);
+    }
+
+    /** @brief Move constructor. Steals a heap buffer, moves inline elements. */
+    small_vector(small_vector&& other) noexcept : small_vector() { take(other); }
+
+    /** @brief Copy assignment. */
+    small_vector& operator=(const small_vector& other)
+    {
+        if (this != &other) {
+            clear();
+            reserve(other.size_);
+            copy_construct(other.typed_data(), other.size_);
+        }
+        return *this;
+    }
+
+    /** @brief Move assignment. */
+    small_vector& operator=(small_vector&& other) noexcept
+    {
+        if (this != &other) {
+            destroy_all();
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    /** @brief Destructor. Destroys all elements and frees a heap buffer. */
+    ~small_vector()
+    {
+        destroy_all();
+        release();
+    }
+
+    /** @brief Returns a reference to the element at index @p i (unchecked). */
+    T& operator[](size_t i) { return typed_data()[i]; }
+    /** @brief Returns a const reference to the element at index @p i (unchecked). */
+    const T& operator[](size_t i) const { return typed_data()[i]; }
+
+    /** @brief Returns a reference to the first element. */
+    T& front() { return typed_data()[0]; }
+    /** @brief Returns a const reference to the first element. */
+    const T& front() const { return typed_data()[0]; }
+    /** @brief Returns a reference to the last element. */
+    T& back() { return typed_data()[size_ - 1]; }
+    /** @brief Returns a const reference to the last element. */
+    const T& back() const { return typed_data()[size_ - 1]; }
+
+    /** @brief Returns a pointer to the underlying data. */
+    T* data() { return typed_data(); }
+    /** @brief Returns a const pointer to the underlying data. */
+    const T* data() const { return typed_data(); }
+
+    /** @brief Returns an iterator to the first element. */
+    T* begin() { return typed_data(); }
+    /** @brief Returns a const iterator to the first element. */
+    const T* begin() const { return typed_data(); }
+    /** @brief Returns a past-the-end iterator. */
+    T* end() { return typed_data() + size_; }
+    /** @brief Returns a const past-the-end iterator. */
+    const T* end() const { return typed_data() + size_; }
+
+    /** @brief Returns true if the vector contains no elements. */
+    bool empty() const { return size_ == 0; }
+    /** @brief Returns the number of elements. */
+    size_t size() const { return size_; }
+    /** @brief Returns the number of elements that can be held without reallocation. */
+    size_t capacity() const { return capacity_; }
+    /** @brief Returns true if the elements are in the inline storage. */
+    bool is_inline() const { return data_ == inline_; }
+
+    /** @brief Reserves storage for at least @p new_cap elements. */
+    void reserve(size_t new_cap)
+    {
+        if (new_cap > capacity_) {
+            grow_to(new_cap);
+        }
+    }
+
+    /** @brief Destroys all elements. Capacity is unchanged. */
+    void clear()
+    {
+        destroy_all();
+        size_ = 0;
+    }
+
+    /** @brief Appends a copy of @p value. Safe when @p value references this vector. */
+    void push_back(const T& value) { emplace_back(value); }
+
+    /** @brief Appends @p value by move. */
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    /** @brief Constructs an element in-place at the end. */
+    template <class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (size_ == capacity_) {
+            // The arguments may reference an element, so construct before growing.
+            T tmp(std::forward<Args>(args)...);
+            grow_to(size_ + 1);
+            return *new (typed_data() + size_++) T(std::move(tmp));
+        }
+        return *new (typed_data() + size_++) T(std::forward<Args>(args)...);
+    }
+
+    /** @brief Removes the last element. */
+    void pop_back()
+    {
+        assert(size_ > 0);
+        --size_;
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            typed_data()[size_].~T();
+        }
+    }
+
+    /**
+     * @brief Inserts a copy of @p value before the element at @p pos.
+     * @return Pointer to the inserted element.
+     */
+    T* insert(const T* pos, const T& value)
+    {
+        size_t idx = static_cast<size_t>(pos - typed_data());
+        assert(idx <= size_);
+        T tmp(value);
+        if (size_ == capacity_) {
+            grow_to(size_ + 1);
+        }
+        T* d = typed_data();
+        if constexpr (trivial) {
+            std::memmove(d + idx + 1, d + idx, (size_ - idx) * sizeof(T));
+            d[idx] = tmp;
+        } else if (idx == size_) {
+            new (d + idx) T(std::move(tmp));
+        } else {
+            new (d + size_) T(std::move(d[size_ - 1]));
+            for (size_t i = size_ - 1; i > idx; --i) {
+                d[i] = std::move(d[i - 1]);
+            }
+            d[idx] = std::move(tmp);
+        }
+        ++size_;
+        return d + idx;
+    }
+
+    /**
+     * @brief Erases the element at @p pos.
+     * @return Pointer to the element following the removed one.
+     */
+    T* erase(const T* pos) { return erase(pos, pos + 1); }
+
+    /**
+     * @brief Erases elements in the range [@p first, @p last).
+     * @return Pointer to the element following the last removed one.
+     */
+    T* erase(const T* first, const T* last)
+    {
+        T* d = typed_data();
+        size_t idx = static_cast<size_t>(first - d);
+        size_t count = static_cast<size_t>(last - first);
+        assert(idx + count <= size_);
+        if constexpr (trivial) {
+            std::memmove(d + idx, d + idx + count, (size_ - idx - count) * sizeof(T));
+        } else {
+            for (size_t i = idx; i + count < size_; ++i) {
+                d[i] = std::move(d[i + count]);
+            }
+            for (size_t i = size_ - count; i < size_; ++i) {
+                d[i].~T();
+            }
+        }
+        size_ -= count;
+        return d + idx;
+    }
+
+    /** @brief Resizes the vector to @p count elements, value-initializing new ones. */
+    void resize(size_t count)
+    {
+        if (count < size_) {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                for (size_t i = count; i < size_; ++i) {
+                    typed_data()[i].~T();
+                }
+            }
+        } else if (count > size_) {
+            reserve(count);
+            for (size_t i = size_; i < count; ++i) {
+                new (typed_data() + i) T();
+            }
+        }
+        size_ = count;
+    }
+
+    /** @brief Implicit conversion to a read-only array_view. */
+    operator array_view<T>() const { return {typed_data(), size_}; }
+
+    /** @brief Equality comparison (element-wise). */
+    bool operator==(const small_vector& other) const
+    {
+        if (size_ != other.size_) {
+            return false;
+        }
+        for (size_t i = 0; i < size_; ++i) {
+            if (!(typed_data()[i] == other.typed_data()[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** @brief Inequality comparison. */
+    bool operator!=(const small_vector& other) const { return !(*this == other); }
+
+private:
+    T* typed_data() { return static_cast<T*>(data_); }
+    const T* typed_data() const { return static_cast<const T*>(data_); }
+
+    void reset_inline() noexcept
+    {
+        data_ = inline_;
+        size_ = 0;
+        capacity_ = N;
+    }
+
+    /** @brief Frees a heap buffer. Does not destroy elements. */
+    void release() noexcept
+    {
+        if (!is_inline()) {
+            free_buffer(data_);
+        }
+        reset_inline();
+    }
+
+    void destroy_all()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = 0; i < size_; ++i) {
+                typed_data()[i].~T();
+            }
+        }
+    }
+
+    /** @brief Appends copies of @p count elements at @p src. Requires the capacity. */
+    void copy_construct(const T* src, size_t count)
+    {
+        if constexpr (trivial) {
+            if (count) {
+                std::memcpy(typed_data() + size_, src, count * sizeof(T));
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                new (typed_data() + size_ + i) T(src[i]);
+            }
+        }
+        size_ += count;
+    }
+
+    /** @brief Moves the elements of @p other into this empty inline vector, leaving @p other empty. */
+    void take(small_vector& other) noexcept
+    {
+        if (!other.is_inline()) {
+            steal_from(other);
+            other.reset_inline();
+            return;
+        }
+        T* src = other.typed_data();
+        if constexpr (trivial) {
+            std::memcpy(data_, src, other.size_ * sizeof(T));
+        } else {
+            for (size_t i = 0; i < other.size_; ++i) {
+                new (typed_data() + i) T(std::move(src[i]));
+            }
+            other.destroy_all();
+        }
+        size_ = other.size_;
+        other.size_ = 0;
+    }
+
+    /** @brief Moves the elements to a heap buffer that holds at least @p required elements. */
+    void grow_to(size_t required)
+    {
+        if constexpr (trivial) {
+            if (!is_inline()) {
+                // Reuse the vector growth path, which frees the old buffer.
+                grow_raw(required, sizeof(T));
+                return;
+            }
+        }
+        size_t new_cap = grow_capacity(capacity_, required);
+        T* dst = static_cast<T*>(alloc_raw(new_cap * sizeof(T)));
+        if constexpr (trivial) {
+            std::memcpy(dst, data_, size_ * sizeof(T));
+        } else {
+            for (size_t i = 0; i < size_; ++i) {
+                new (dst + i) T(std::move(typed_data()[i]));
+            }
+            destroy_all();
+        }
+        if (!is_inline()) {
+            free_buffer(data_);
+        }
+        data_ = dst;
+        capacity_ = new_cap;
+    }
+
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+};
+
 } // namespace velk
 
 #endif // VELK_VECTOR_H
@@ -105,6 +105,14 @@ public:
         }
     }
 
+    /** @brief Bakes the keyframes into @p samplesPerSecond samples per second, or 0 to stop baking. */
+    void set_sample_rate(uint32_t samplesPerSecond)
+    {
+        if (auto* a = intf()) {
+            a->set_sample_rate(samplesPerSecond);
+        }
+    }
+
     /** @brief Returns the total duration, or zero if invalid. */
     Duration get_duration() const
     {
@@ -69,6 +69,18 @@ public:
     virtual void seek(float progress) = 0;
     /** @brief Replaces all keyframes. Shares ownership of each entry's value. */
     virtual void set_keyframes(array_view<KeyframeEntry> keyframes) = 0;
+    /**
+     * @brief Bakes the keyframes into a table of @p samplesPerSecond samples per second, or
+     *        evaluates them exactly with 0 (the default).
+     *
+     * A baked track samples its keyframes and their easing at evenly spaced times once, after
+     * keyframes or targets change, and then interpolates linearly between the two samples around
+     * the elapsed time each tick. This replaces the easing call, which may be costly as for
+     * easing::in_out_sine, with a table read, at the cost of a value of memory per sample and
+     * of detail between the samples. Tables hold at most 65536 intervals. Only types with a raw
+     * interpolator (see ITypeRegistry::find_raw_interpolator()) are baked; others ignore the rate.
+     */
+    virtual void set_sample_rate(uint32_t samplesPerSecond) = 0;
 };
 
 } // namespace velk
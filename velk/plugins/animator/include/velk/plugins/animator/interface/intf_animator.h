@@ -1,23 +1,44 @@
 #ifndef VELK_ANIMATOR_INTF_ANIMATOR_H
 #define VELK_ANIMATOR_INTF_ANIMATOR_H
 
+#include <velk/interface/intf_executor.h>
 #include <velk/interface/intf_metadata.h>
 #include <velk/plugins/animator/interface/intf_animation.h>
 
 namespace velk {
 
+/** @brief Counters and timing of an IAnimator::tick() call. */
+struct AnimatorStats
+{
+    size_t ticked{};       ///< Animations advanced, one by one or in a batch.
+    size_t batched{};      ///< Of ticked, the tracks advanced by a batch of tracks.
+    size_t skipped{};      ///< Animations not advanced as their level of detail was not due.
+    size_t idle{};         ///< Tracks that are not playing, which the tick did not visit.
+    size_t finished{};     ///< Tracks that reached their end.
+    size_t targetWrites{}; ///< Values the tracks wrote to their target properties.
+    Duration time;         ///< Wall-clock time the tick took.
+};
+
 /**
  * @brief Interface for an animator that manages and ticks a set of animations.
  *
  * Animations are added via add() and advanced each frame via tick().
  * The animator holds weak references; animations persist via property installation.
+ *
+ * Each animation has a level of detail (LOD), 0 unless set_lod() says otherwise. All
+ * animations at one level are ticked at the interval set_lod_interval() sets for it, so an
+ * application can throttle, say, every animation of off-screen objects by giving them their own
+ * level and changing its interval.
  */
 class IAnimator : public Interface<IAnimator>
 {
 public:
+    /** @brief Number of levels of detail; set_lod() clamps higher levels to the last one. */
+    static constexpr uint32_t LOD_COUNT = 8;
+
     /** @brief Advances all animations. */
     virtual void tick(const UpdateInfo& info) = 0;
-    /** @brief Adds an animation to be managed. */
+    /** @brief Adds an animation to be managed; does nothing if it was added already. */
     virtual void add(const IAnimation::Ptr& animation) = 0;
     /** @brief Removes an animation from the animator. */
     virtual void remove(const IAnimation::Ptr& animation) = 0;
@@ -27,6 +48,48 @@ public:
     virtual size_t active_count() const = 0;
     /** @brief Returns the total number of managed animations (excluding expired). */
     virtual size_t count() const = 0;
+    /**
+     * @brief Returns the counters and timing of the last tick().
+     *
+     * The default animator of the plugin is ticked once per update(), so its stats describe the
+     * animations of the last frame.
+     */
+    virtual const AnimatorStats& get_stats() const = 0;
+
+    /**
+     * @brief Sets the executor tick() evaluates playing keyframe tracks on.
+     *
+     * With an executor, tick() computes and writes the values of large sets of batched tracks in
+     * chunks on the executor, then fires the change notifications on the calling thread. Tracks
+     * whose targets carry other extensions, such as a transition or a second track, and all
+     * other animations are still ticked on the calling thread. Must not be called during tick().
+     *
+     * @param executor The executor, e.g. instance().get_thread_pool(), or null to tick serially.
+     */
+    virtual void set_executor(const IExecutor::Ptr& executor) = 0;
+    /** @brief Returns the executor set with set_executor(), or null. */
+    virtual IExecutor::Ptr get_executor() const = 0;
+
+    /**
+     * @brief Moves @p animation, which must have been added, to level of detail @p level.
+     *
+     * The animation is ticked at the interval of its new level from the next tick() on. The dt
+     * its old level accumulated since it last updated stays with that level.
+     */
+    virtual void set_lod(const IAnimation::Ptr& animation, uint32_t level) = 0;
+    /** @brief Returns the level of detail of @p animation, or 0 if it was not added. */
+    virtual uint32_t get_lod(const IAnimation::Ptr& animation) const = 0;
+    /**
+     * @brief Sets how often the animations at level of detail @p level are ticked.
+     *
+     * With an interval of n, they are ticked on every nth call to tick(), with the sum of the dt
+     * of those n calls, so they keep time while updating less often. With 0 they are not ticked
+     * at all and their time stands still, until the interval changes again. All levels start at
+     * an interval of 1, every tick().
+     */
+    virtual void set_lod_interval(uint32_t level, uint32_t interval) = 0;
+    /** @brief Returns the interval of level of detail @p level. */
+    virtual uint32_t get_lod_interval(uint32_t level) const = 0;
 };
 
 } // namespace velk
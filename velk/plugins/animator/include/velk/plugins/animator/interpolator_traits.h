@@ -34,6 +34,14 @@ ReturnValue typed_interpolator(const IAny& from, const IAny& to, float t, IAny&
     return ReturnValue::Fail;
 }
 
+/** @brief Unboxed counterpart of typed_interpolator<T>, registered alongside it. */
+template <class T>
+void raw_typed_interpolator(const void* from, const void* to, float t, void* result)
+{
+    *static_cast<T*>(result) =
+        interpolator_trait<T>::interpolate(*static_cast<const T*>(from), *static_cast<const T*>(to), t);
+}
+
 } // namespace detail
 } // namespace velk
 
@@ -19,6 +19,11 @@ namespace PluginId {
 inline constexpr Uid AnimatorPlugin{"738617b8-dba8-4a08-a0bc-51e8dc4d5faf"};
 } // namespace PluginId
 
+namespace PluginClasses {
+/** @brief Classes of velk_animator, for IPluginRegistry::register_plugin_library(). */
+inline constexpr Uid AnimatorPlugin[] = {ClassId::AnimationTrack, ClassId::Animator, ClassId::Transition};
+} // namespace PluginClasses
+
 } // namespace velk
 
 #endif // VELK_PLUGINS_ANIMATOR_PLUGIN_H
@@ -1,5 +1,8 @@
 #include "animation_track.h"
 
+#include "animator.h"
+#include "notification_batch.h"
+
 #include <velk/api/state.h>
 #include <velk/api/velk.h>
 #include <velk/interface/intf_event.h>
@@ -11,6 +14,7 @@ namespace velk {
 
 AnimationTrackImpl::~AnimationTrackImpl()
 {
+    leave_group();
     if (transient_) {
         AnimationTrackImpl::uninstall();
     }
@@ -18,6 +22,7 @@ AnimationTrackImpl::~AnimationTrackImpl()
 
 void AnimationTrackImpl::uninstall()
 {
+    leave_group();
     for (auto& entry : targets_) {
         auto owner = entry.owner.lock();
         if (!owner) {
@@ -58,6 +63,7 @@ IAnimationTrack::State* AnimationTrackImpl::state()
 
 void AnimationTrackImpl::set_keyframes(array_view<KeyframeEntry> keyframes)
 {
+    leave_group();
     auto* s = state();
     if (!s) {
         return;
@@ -67,8 +73,19 @@ void AnimationTrackImpl::set_keyframes(array_view<KeyframeEntry> keyframes)
     sorted_ = false;
 }
 
+void AnimationTrackImpl::set_sample_rate(uint32_t samplesPerSecond)
+{
+    leave_group();
+    if (sampleRate_ != samplesPerSecond) {
+        sampleRate_ = samplesPerSecond;
+        // Baked again, or the table dropped, by the next ensure_init().
+        sorted_ = false;
+    }
+}
+
 void AnimationTrackImpl::play()
 {
+    leave_group();
     auto* s = state();
     if (!s) {
         return;
@@ -83,6 +100,7 @@ void AnimationTrackImpl::play()
 
 void AnimationTrackImpl::pause()
 {
+    leave_group();
     auto* s = state();
     if (!s || s->state != PlayState::Playing) {
         return;
@@ -93,6 +111,7 @@ void AnimationTrackImpl::pause()
 
 void AnimationTrackImpl::stop()
 {
+    leave_group();
     auto* s = state();
     if (!s || s->state == PlayState::Idle) {
         return;
@@ -105,6 +124,7 @@ void AnimationTrackImpl::stop()
 
 void AnimationTrackImpl::finish()
 {
+    leave_group();
     auto* s = state();
     if (!s || s->state == PlayState::Finished) {
         return;
@@ -115,6 +135,7 @@ void AnimationTrackImpl::finish()
 
 void AnimationTrackImpl::restart()
 {
+    leave_group();
     auto* s = state();
     if (!s) {
         return;
@@ -127,6 +148,7 @@ void AnimationTrackImpl::restart()
 
 void AnimationTrackImpl::seek(float p)
 {
+    leave_group();
     auto* s = state();
     if (!s) {
         return;
@@ -166,6 +188,7 @@ void AnimationTrackImpl::ensure_init(IAnimationTrack::State& s)
         }
         result_ = inner->clone();
     }
+    unbox_keyframes(s);
     sorted_ = true;
 }
 
@@ -193,27 +216,107 @@ void AnimationTrackImpl::apply_at(IAnimationTrack::State& s)
         return;
     }
 
-    // Find the segment: first keyframe with time > elapsed
-    size_t i = 1;
-    while (i < s.keyframes.size() && s.keyframes[i].time.us <= s.elapsed.us) {
-        ++i;
+    if (!samples_.empty()) {
+        // Baked: linear between the samples around elapsed.
+        size_t intervals = samples_.size() / rawStride_ - 1;
+        double pos = static_cast<double>(s.elapsed.us) * static_cast<double>(intervals) /
+                     static_cast<double>(s.duration.us);
+        size_t k = std::min(static_cast<size_t>(pos), intervals - 1);
+        auto* result = raw_value(s.keyframes.size());
+        rawInterpolator_(sample(k), sample(k + 1), static_cast<float>(pos - static_cast<double>(k)), result);
+        write_raw(result, valueSize_, typeUid_);
+        return;
     }
+    size_t i = find_segment(s, s.elapsed.us);
     if (i >= s.keyframes.size() || !interpolator_ || !result_) {
         return;
     }
 
     auto& kf0 = s.keyframes[i - 1];
     auto& kf1 = s.keyframes[i];
-    if (kf0.value && kf1.value) {
-        int64_t seg_len = kf1.time.us - kf0.time.us;
-        float seg_t = (seg_len > 0)
-                          ? static_cast<float>(s.elapsed.us - kf0.time.us) / static_cast<float>(seg_len)
-                          : 1.f;
+    int64_t seg_len = kf1.time.us - kf0.time.us;
+    float seg_t = (seg_len > 0) ? static_cast<float>(s.elapsed.us - kf0.time.us) / static_cast<float>(seg_len)
+                                : 1.f;
+    if (rawInterpolator_) {
+        auto* result = raw_value(s.keyframes.size());
+        rawInterpolator_(raw_value(i - 1), raw_value(i), kf1.easing(seg_t), result);
+        write_raw(result, valueSize_, typeUid_);
+    } else if (kf0.value && kf1.value) {
         interpolator_(*kf0.value, *kf1.value, kf1.easing(seg_t), *result_);
         write_value(*result_);
     }
 }
 
+void AnimationTrackImpl::unbox_keyframes(const IAnimationTrack::State& s)
+{
+    // The keyframe values are copied out of their anys once, so that apply_at() interpolates
+    // without a virtual call and writes the result with a single set_data() per target.
+    rawInterpolator_ = nullptr;
+    rawValues_.clear();
+    auto raw = interpolator_ ? instance().type_registry().find_raw_interpolator(typeUid_) : nullptr;
+    size_t size = (raw && result_) ? result_->get_data_size(typeUid_) : 0;
+    if (!size) {
+        return;
+    }
+    rawStride_ = (size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+    rawValues_.resize(rawStride_ * (s.keyframes.size() + 1));
+    for (size_t i = 0; i < s.keyframes.size(); ++i) {
+        auto& value = s.keyframes[i].value;
+        if (!value || failed(value->get_data(raw_value(i), size, typeUid_))) {
+            // Keyframes of another type go through the boxed interpolator, which rejects them.
+            rawValues_.clear();
+            return;
+        }
+    }
+    rawInterpolator_ = raw;
+    valueSize_ = size;
+    bake_samples(s);
+}
+
+void AnimationTrackImpl::bake_samples(const IAnimationTrack::State& s)
+{
+    constexpr int64_t max_intervals = 65536;
+    samples_.clear();
+    if (!sampleRate_ || !rawInterpolator_ || s.keyframes.size() < 2 || s.duration.us <= 0) {
+        return;
+    }
+    // Intervals of equal length, at least as many as the rate asks for.
+    int64_t intervals = (s.duration.us * sampleRate_ + 999999) / 1000000;
+    intervals = std::min(std::max<int64_t>(intervals, 1), max_intervals);
+    samples_.resize(rawStride_ * static_cast<size_t>(intervals + 1));
+    for (int64_t k = 0; k <= intervals; ++k) {
+        // As apply_at() computes the value at that time, but always from the keyframe values.
+        int64_t time = s.duration.us * k / intervals;
+        size_t i = std::min(find_segment(s, time), s.keyframes.size() - 1);
+        auto& kf0 = s.keyframes[i - 1];
+        auto& kf1 = s.keyframes[i];
+        int64_t seg_len = kf1.time.us - kf0.time.us;
+        float seg_t =
+            (seg_len > 0) ? static_cast<float>(time - kf0.time.us) / static_cast<float>(seg_len) : 1.f;
+        rawInterpolator_(raw_value(i - 1), raw_value(i), kf1.easing(seg_t), sample(static_cast<size_t>(k)));
+    }
+}
+
+size_t AnimationTrackImpl::find_segment(const IAnimationTrack::State& s, int64_t elapsed)
+{
+    // The segment ends at the first keyframe after index 0 with time > elapsed, or is past the end.
+    auto& kfs = s.keyframes;
+    auto ends_segment = [&](size_t i) {
+        return i >= 1 && i <= kfs.size() && (i == 1 || kfs[i - 1].time.us <= elapsed) &&
+               (i == kfs.size() || kfs[i].time.us > elapsed);
+    };
+    // While playing, elapsed only grows: the segment is the cached one or, after a tick crossed a
+    // keyframe, the next. Anything else (seek, restart, new keyframes) searches.
+    size_t i = segment_;
+    if (!ends_segment(i) && !ends_segment(++i)) {
+        auto after = std::upper_bound(kfs.begin() + 1, kfs.end(), elapsed,
+                                      [](int64_t t, const KeyframeEntry& kf) { return t < kf.time.us; });
+        i = static_cast<size_t>(after - kfs.begin());
+    }
+    segment_ = i;
+    return i;
+}
+
 void AnimationTrackImpl::mark_finished(IAnimationTrack::State& s)
 {
     s.elapsed = s.duration;
@@ -232,16 +335,35 @@ void AnimationTrackImpl::write_value(const IAny& value)
         if (entry.inner) {
             entry.inner->copy_from(value);
         }
-        auto prop = entry.owner.lock();
-        if (prop) {
-            auto pi = interface_pointer_cast<IPropertyInternal>(prop);
-            if (pi) {
-                instance().queue_deferred_property({pi, nullptr});
-            }
+    }
+    queue_targets();
+}
+
+void AnimationTrackImpl::write_raw(const void* value, size_t size, Uid type)
+{
+    store_raw(value, size, type);
+    queue_targets();
+}
+
+void AnimationTrackImpl::store_raw(const void* value, size_t size, Uid type)
+{
+    if (display_) {
+        display_->set_data(value, size, type);
+    }
+    for (auto& entry : targets_) {
+        if (entry.inner) {
+            entry.inner->set_data(value, size, type);
         }
     }
 }
 
+void AnimationTrackImpl::queue_targets()
+{
+    for (auto& entry : targets_) {
+        NotificationBatch::queue(entry.property);
+    }
+}
+
 void AnimationTrackImpl::notify_state(IAnimationTrack::State& state)
 {
     notify(MemberKind::Property, IAnimationTrack::UID, Notification::Changed);
@@ -249,6 +371,7 @@ void AnimationTrackImpl::notify_state(IAnimationTrack::State& state)
 
 ReturnValue AnimationTrackImpl::tick(const UpdateInfo& info)
 {
+    leave_group();
     // Skip if not actively playing
     auto* st = state();
     if (!st || st->state != PlayState::Playing) {
@@ -280,6 +403,83 @@ ReturnValue AnimationTrackImpl::tick(const UpdateInfo& info)
     return ReturnValue::Success;
 }
 
+// TrackBatch support
+
+void AnimationTrackImpl::leave_group()
+{
+    if (batch_) {
+        batch_->release(batchSlot_);
+        batch_ = nullptr;
+    }
+    leave_idle();
+}
+
+void AnimationTrackImpl::leave_idle()
+{
+    if (idleIn_) {
+        auto* animator = idleIn_;
+        idleIn_ = nullptr;
+        animator->wake(idleSlot_);
+    }
+}
+
+bool AnimationTrackImpl::get_batch_segment(BatchSegment& seg)
+{
+    auto* st = state();
+    if (!st || st->state != PlayState::Playing || st->keyframes.size() < 2 || !has_targets()) {
+        return false;
+    }
+    auto& s = *st;
+    ensure_init(s);
+    if (!samples_.empty()) {
+        // Baked tracks are ticked on their own; the batches interpolate the keyframes exactly.
+        return false;
+    }
+    // The segment apply_at() interpolates in
+    size_t i = find_segment(s, s.elapsed.us);
+    if (i >= s.keyframes.size() || !interpolator_ || !result_) {
+        return false;
+    }
+    auto& kf0 = s.keyframes[i - 1];
+    auto& kf1 = s.keyframes[i];
+    if (!kf0.value || !kf1.value) {
+        return false;
+    }
+    seg = {s.elapsed.us, s.duration.us, kf0.time.us, kf1.time.us,
+           kf1.easing, kf0.value.get(), kf1.value.get()};
+    return true;
+}
+
+void AnimationTrackImpl::store_batched(int64_t elapsed, float progress, const void* value, size_t size,
+                                       Uid type)
+{
+    auto* s = state();
+    if (!s) {
+        return;
+    }
+    s->elapsed.us = elapsed;
+    s->progress = progress;
+    store_raw(value, size, type);
+}
+
+void AnimationTrackImpl::notify_batched()
+{
+    if (auto* s = state()) {
+        queue_targets();
+        notify_state(*s);
+    }
+}
+
+bool AnimationTrackImpl::have_plain_targets() const
+{
+    for (auto& entry : targets_) {
+        if (entry.inner && interface_cast<IAnyExtension>(entry.inner)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // IAnyExtension
 
 IAny::ConstPtr AnimationTrackImpl::get_inner() const
@@ -289,6 +489,7 @@ IAny::ConstPtr AnimationTrackImpl::get_inner() const
 
 void AnimationTrackImpl::set_inner(IAny::Ptr inner, const IInterface::WeakPtr& owner)
 {
+    leave_group();
     // First target entry: initialize display/result/interpolator
     if (targets_.empty() && inner) {
         display_ = inner->clone();
@@ -299,12 +500,16 @@ void AnimationTrackImpl::set_inner(IAny::Ptr inner, const IInterface::WeakPtr& o
             typeUid_ = types[0];
             interpolator_ = instance().type_registry().find_interpolator(typeUid_);
         }
+        // Unbox the keyframes again for the type of the new target.
+        sorted_ = false;
     }
-    targets_.push_back({owner, std::move(inner)});
+    auto property = interface_pointer_cast<IPropertyInternal>(owner.lock());
+    targets_.push_back({owner, std::move(inner), property});
 }
 
 IAny::Ptr AnimationTrackImpl::take_inner(IInterface& owner)
 {
+    leave_group();
     for (auto it = targets_.begin(); it != targets_.end(); ++it) {
         auto locked = it->owner.lock();
         if (locked && locked.get() == &owner) {
@@ -314,6 +519,8 @@ IAny::Ptr AnimationTrackImpl::take_inner(IInterface& owner)
                 display_ = nullptr;
                 result_ = nullptr;
                 interpolator_ = nullptr;
+                rawInterpolator_ = nullptr;
+                samples_.clear();
             }
             return inner;
         }
@@ -1,19 +1,29 @@
 #ifndef VELK_ANIMATOR_ANIMATION_TRACK_IMPL_H
 #define VELK_ANIMATOR_ANIMATION_TRACK_IMPL_H
 
+#include "track_batch.h"
+
 #include <velk/ext/object.h>
 #include <velk/plugins/animator/interface/intf_animation_track.h>
 #include <velk/plugins/animator/plugin.h>
 #include <velk/vector.h>
 
+#include <cstddef>
+
 namespace velk {
 
+class AnimatorImpl;
+
 /**
  * @brief Keyframe-based animation implementation that is itself an IAnyExtension.
  *
  * Installed on one or more properties via install_extension. Drives values from
  * keyframes during tick(), writing directly to all inners and firing on_changed
  * via each owner.
+ *
+ * While playing, an animator may advance the track in a TrackBatch instead of calling tick().
+ * While not playing, the animator keeps it in its idle list instead of ticking it. Every other
+ * call makes the track leave the batch or the idle list first.
  */
 class AnimationTrackImpl : public ext::Object<AnimationTrackImpl, IAnimationTrack, IAnyExtension>
 {
@@ -38,6 +48,7 @@ public:
     void restart() override;
     void seek(float progress) override;
     void set_keyframes(array_view<KeyframeEntry> keyframes) override;
+    void set_sample_rate(uint32_t samplesPerSecond) override;
 
     // IAnyExtension
     IAny::ConstPtr get_inner() const override;
@@ -52,19 +63,81 @@ public:
     ReturnValue copy_from(const IAny& other) override;
     IAny::Ptr clone() const override;
 
+    // TrackBatch support
+    /** @brief Returns the value type, resolved on the first tick. */
+    Uid get_value_type() const { return typeUid_; }
+    /** @brief Returns true if the track has played to its end. */
+    bool is_finished() const
+    {
+        auto* s = state();
+        return s && s->state == PlayState::Finished;
+    }
+    /** @brief Returns the interpolator, resolved on the first tick. */
+    InterpolatorFn get_interpolator() const { return interpolator_; }
+    /** @brief Fills @p seg with the segment the track plays in; false if it is not playing one. */
+    bool get_batch_segment(BatchSegment& seg);
+    /** @brief Sets the batch advancing the track, or null. */
+    void set_batch(TrackBatch* batch, uint32_t slot)
+    {
+        batch_ = batch;
+        batchSlot_ = slot;
+    }
+    /** @brief Returns the batch advancing the track, or null. */
+    TrackBatch* get_batch() const { return batch_; }
+    /** @brief Returns the slot of the track in get_batch(). */
+    uint32_t get_batch_slot() const { return batchSlot_; }
+    /** @brief Sets the animator whose idle list the track is in at @p slot, or null. */
+    void set_idle(AnimatorImpl* animator, uint32_t slot)
+    {
+        idleIn_ = animator;
+        idleSlot_ = slot;
+    }
+    /** @brief Makes the track leave the idle list it is in, if any, so that it is ticked again. */
+    void leave_idle();
+    /** @brief Stores the state and the value @p value computed by the batch, as tick() would. */
+    void write_batched(int64_t elapsed, float progress, const void* value, size_t size, Uid type)
+    {
+        store_batched(elapsed, progress, value, size, type);
+        notify_batched();
+    }
+    /**
+     * @brief The first half of write_batched(): stores the state and @p value without notifying.
+     *
+     * Calls nothing but set_data() on values the track owns or that have_plain_targets() checked,
+     * so the batch may call it for different tracks on different threads.
+     */
+    void store_batched(int64_t elapsed, float progress, const void* value, size_t size, Uid type);
+    /** @brief The second half of write_batched(): queues on_changed of the targets and the state. */
+    void notify_batched();
+    /**
+     * @brief Returns true if the targets are plain values rather than other extensions, whose
+     *        set_data() might run code that is not safe to call concurrently.
+     */
+    bool have_plain_targets() const;
+
 private:
     struct TargetEntry
     {
         IInterface::WeakPtr owner;
         IAny::Ptr inner;
+        IPropertyInternal::WeakPtr property; // owner, as queued for deferred notification.
     };
 
     IAnimationTrack::State* state();
     const IAnimationTrack::State* state() const;
     void ensure_init(IAnimationTrack::State& state);
     void apply_at(IAnimationTrack::State& s);
+    size_t find_segment(const IAnimationTrack::State& s, int64_t time);
+    void unbox_keyframes(const IAnimationTrack::State& s);
+    void bake_samples(const IAnimationTrack::State& s);
+    void* raw_value(size_t index) { return &rawValues_[index * rawStride_]; }
+    void* sample(size_t index) { return &samples_[index * rawStride_]; }
     void mark_finished(IAnimationTrack::State& s);
     void write_value(const IAny& value);
+    void write_raw(const void* value, size_t size, Uid type);
+    void store_raw(const void* value, size_t size, Uid type);
+    void queue_targets();
+    void leave_group();
     void notify_state(IAnimationTrack::State& state);
     bool has_targets() const { return !targets_.empty(); }
 
@@ -72,7 +145,18 @@ private:
     IAny::Ptr display_;
     InterpolatorFn interpolator_ = nullptr;
     IAny::Ptr result_;
+    RawInterpolatorFn rawInterpolator_ = nullptr; // Set while the keyframe values are unboxed.
+    vector<std::max_align_t> rawValues_;          // Unboxed keyframe values, then the result.
+    size_t rawStride_ = 0;                        // Elements of rawValues_ per value.
+    size_t valueSize_ = 0;                        // Bytes per unboxed value.
+    vector<std::max_align_t> samples_;            // Baked values, rawStride_ elements each, or empty.
+    uint32_t sampleRate_ = 0;                     // Samples per second to bake, 0 if not baked.
     Uid typeUid_{};
+    TrackBatch* batch_ = nullptr;
+    uint32_t batchSlot_ = 0;
+    AnimatorImpl* idleIn_ = nullptr; // Animator whose idle list the track is in.
+    uint32_t idleSlot_ = 0;
+    size_t segment_ = 0; // Keyframe the last find_segment() returned.
     bool sorted_ = false;
     bool transient_ = false;
 };
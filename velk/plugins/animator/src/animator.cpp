@@ -1,21 +1,295 @@
 #include "animator.h"
 
+#include "animation_track.h"
+
 #include <velk/plugins/animator/interface/intf_animation.h>
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
 namespace velk {
 
+namespace {
+
+AnimationTrackImpl* as_track(IAnimation* animation)
+{
+    auto* object = interface_cast<IObject>(animation);
+    if (!object || object->get_class_uid() != ClassId::AnimationTrack) {
+        return nullptr;
+    }
+    return static_cast<AnimationTrackImpl*>(animation);
+}
+
+// Smallest number of slots worth a task of their own in a parallel tick.
+constexpr size_t min_chunk_size = 1024;
+
+} // namespace
+
+AnimatorImpl::~AnimatorImpl()
+{
+    clear_idle(false);
+}
+
 void AnimatorImpl::tick(const UpdateInfo& info)
 {
-    size_t write = 0;
-    for (size_t i = 0; i < animations_.size(); ++i) {
-        auto anim = animations_[i].lock();
+    auto start = std::chrono::steady_clock::now();
+    stats_ = {};
+    // Animations released by a tick are destroyed after the loop, so they need not be locked.
+    ReclaimScope scope;
+    // The on_changed of all written properties is queued in one go at the end.
+    NotificationBatch notifications(notifications_);
+    ticking_ = true;
+    // The levels of detail that update in this tick, with the dt they accumulated.
+    for (auto& lod : lods_) {
+        lod.due = false;
+        if (!lod.interval) {
+            continue;
+        }
+        lod.pending.us += info.dt.us;
+        if (++lod.skipped >= lod.interval) {
+            lod.info = info;
+            lod.info.dt = lod.pending;
+            lod.pending = {};
+            lod.skipped = 0;
+            lod.due = true;
+        }
+    }
+    // Tracks that may play again or left their batch since the last tick are ticked one by one.
+    wake_idle(scope);
+    for (auto& batch : batches_) {
+        reclaimed_.clear();
+        batch->reclaim(reclaimed_);
+        for (auto& entry : reclaimed_) {
+            if (entry.handle.peek(scope)) {
+                push_ticked(std::move(entry), scope);
+            } else {
+                forget(entry.key);
+            }
+        }
+    }
+    bool parallel = evaluate_parallel(scope);
+    for (auto& batch : batches_) {
+        auto& lod = lods_[batch->get_lod()];
+        if (!lod.due) {
+            stats_.skipped += batch->size();
+            continue;
+        }
+        if (parallel) {
+            batch->finish(lod.info, scope, stats_);
+        } else {
+            batch->tick(lod.info, scope, stats_);
+        }
+    }
+    // Entries are re-read after each tick, as handlers may add, remove or cancel animations.
+    for (size_t i = 0; i < animations_.size();) {
+        auto* anim = animations_[i].handle.peek(scope);
         if (!anim) {
+            forget(animations_[i].key);
+            drop_ticked(i, scope);
+            continue;
+        }
+        auto& lod = lods_[animations_[i].lod];
+        if (!lod.due) {
+            ++stats_.skipped;
+            ++i;
             continue;
         }
-        anim->tick(info);
-        animations_[write++] = animations_[i];
+        auto* track = animations_[i].track;
+        if (anim->tick(lod.info) == ReturnValue::Success) {
+            ++stats_.ticked;
+            stats_.finished += track && track->is_finished();
+        }
+        if (i >= animations_.size() || animations_[i].handle.peek(scope) != anim) {
+            continue;
+        }
+        if (track) {
+            // From the next tick on, a track still playing is advanced by the batch of its type,
+            // and one that stopped is not visited until it wakes.
+            if (join_batch(animations_[i], scope)) {
+                drop_ticked(i, scope);
+                continue;
+            }
+            if (!track->is_active()) {
+                park(i, scope);
+                continue;
+            }
+        }
+        ++i;
     }
-    animations_.resize(write); // Removes any IAnimation::WeakPtrs whose .lock() failed above.
+    ticking_ = false;
+    stats_.idle = idle_.size();
+    // Every target write queues one notification, which the batch has not flushed yet.
+    stats_.targetWrites = notifications_.size();
+    stats_.time.us = std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start).count();
+}
+
+bool AnimatorImpl::evaluate_parallel(const ReclaimScope& scope)
+{
+    size_t concurrency = executor_ ? executor_->get_concurrency() : 0;
+    if (concurrency < 2) {
+        return false;
+    }
+    size_t total = 0;
+    for (auto& batch : batches_) {
+        total += lods_[batch->get_lod()].due ? batch->size() : 0;
+    }
+    if (total < 2 * min_chunk_size) {
+        return false;
+    }
+    // A few chunks per thread balance batches that take longer, e.g. with a scalar easing.
+    size_t grain = std::max(min_chunk_size, total / (4 * concurrency));
+    chunks_.clear();
+    for (auto& batch : batches_) {
+        auto& lod = lods_[batch->get_lod()];
+        for (size_t begin = 0; lod.due && begin < batch->size(); begin += grain) {
+            chunks_.push_back({batch.get(), &lod.info, begin, std::min(begin + grain, batch->size())});
+        }
+    }
+    struct Context
+    {
+        const ReclaimScope& scope;
+        const BatchChunk* chunks;
+    } context{scope, chunks_.data()};
+    executor_->parallel_for(chunks_.size(), &context, [](void* ctx, size_t index) {
+        auto& c = *static_cast<Context*>(ctx);
+        auto& chunk = c.chunks[index];
+        chunk.batch->evaluate(*chunk.info, chunk.begin, chunk.end);
+        chunk.batch->store(chunk.begin, chunk.end, c.scope);
+    });
+    return true;
+}
+
+bool AnimatorImpl::join_batch(const AnimationEntry& entry, const ReclaimScope& scope)
+{
+    auto type = entry.track->get_value_type();
+    auto interpolator = entry.track->get_interpolator();
+    BatchSegment seg;
+    if (!interpolator || !entry.track->get_batch_segment(seg)) {
+        return false;
+    }
+    TrackBatch* target = nullptr;
+    for (auto& batch : batches_) {
+        if (batch->get_type() == type && batch->get_interpolator() == interpolator &&
+            batch->get_easing() == seg.easing && batch->get_lod() == entry.lod) {
+            target = batch.get();
+            break;
+        }
+    }
+    if (target) {
+        if (!target->add(entry, seg)) {
+            return false;
+        }
+    } else {
+        auto batch = TrackBatch::create(type, interpolator, seg.easing, entry.lod);
+        if (!batch || !batch->add(entry, seg)) {
+            return false;
+        }
+        batches_.push_back(std::move(batch));
+    }
+    locate(entry, Batched, 0, scope);
+    return true;
+}
+
+AnimatorImpl::Location* AnimatorImpl::find(const IAnimation::Ptr& animation, const ReclaimScope& scope)
+{
+    auto it = index_.find(animation.get());
+    return it != index_.end() && it->second.handle.peek(scope) == animation.get() ? &it->second : nullptr;
+}
+
+const AnimatorImpl::Location* AnimatorImpl::find(const IAnimation::Ptr& animation,
+                                                 const ReclaimScope& scope) const
+{
+    return const_cast<AnimatorImpl*>(this)->find(animation, scope);
+}
+
+void AnimatorImpl::locate(const AnimationEntry& entry, List list, size_t slot, const ReclaimScope& scope)
+{
+    auto* anim = entry.handle.peek(scope);
+    if (!anim) {
+        return;
+    }
+    auto it = index_.find(entry.key);
+    if (it != index_.end() && it->second.handle.peek(scope) == anim) {
+        it->second.list = list;
+        it->second.slot = static_cast<uint32_t>(slot);
+    }
+}
+
+void AnimatorImpl::forget(const IAnimation* key)
+{
+    // A live animation under key was added after the destroyed one, and stays.
+    auto it = index_.find(key);
+    if (it != index_.end() && it->second.handle.expired()) {
+        index_.erase(it);
+    }
+}
+
+void AnimatorImpl::push_ticked(AnimationEntry&& entry, const ReclaimScope& scope)
+{
+    animations_.push_back(std::move(entry));
+    locate(animations_.back(), Ticked, animations_.size() - 1, scope);
+}
+
+void AnimatorImpl::drop_ticked(size_t slot, const ReclaimScope& scope)
+{
+    size_t last = animations_.size() - 1;
+    if (slot != last) {
+        animations_[slot] = std::move(animations_[last]);
+        locate(animations_[slot], Ticked, slot, scope);
+    }
+    animations_.pop_back();
+}
+
+void AnimatorImpl::park(size_t slot, const ReclaimScope& scope)
+{
+    auto idleSlot = static_cast<uint32_t>(idle_.size());
+    idle_.push_back(std::move(animations_[slot]));
+    idle_.back().track->set_idle(this, idleSlot);
+    locate(idle_.back(), Idle, idleSlot, scope);
+    drop_ticked(slot, scope);
+}
+
+void AnimatorImpl::wake_idle(const ReclaimScope& scope)
+{
+    // From the highest slot down: all slots above the current one have been handled, so the
+    // track moved into a freed slot is one that did not wake, and still knows its slot.
+    std::sort(woken_.begin(), woken_.end(), std::greater<uint32_t>());
+    for (auto slot : woken_) {
+        if (idle_[slot].handle.peek(scope)) {
+            push_ticked(std::move(idle_[slot]), scope);
+        } else {
+            forget(idle_[slot].key);
+        }
+        size_t last = idle_.size() - 1;
+        if (slot != last) {
+            idle_[slot] = std::move(idle_[last]);
+            idle_[slot].track->set_idle(this, slot);
+            locate(idle_[slot], Idle, slot, scope);
+        }
+        idle_.pop_back();
+    }
+    woken_.clear();
+}
+
+void AnimatorImpl::clear_idle(bool uninstall)
+{
+    // Tracks that woke have left the list themselves, and may have been destroyed since; all
+    // others are still alive, or at least not yet destroyed, and must not report back.
+    ReclaimScope scope;
+    std::sort(woken_.begin(), woken_.end());
+    for (size_t i = 0; i < idle_.size(); ++i) {
+        auto& entry = idle_[i];
+        if (!std::binary_search(woken_.begin(), woken_.end(), static_cast<uint32_t>(i))) {
+            entry.track->set_idle(nullptr, 0);
+        }
+        if (uninstall && entry.handle.peek(scope)) {
+            entry.track->uninstall();
+        }
+    }
+    idle_.clear();
+    woken_.clear();
 }
 
 void AnimatorImpl::add(const IAnimation::Ptr& animation)
@@ -23,13 +297,14 @@ void AnimatorImpl::add(const IAnimation::Ptr& animation)
     if (!animation) {
         return;
     }
-    for (auto& weak : animations_) {
-        auto locked = weak.lock();
-        if (locked && locked.get() == animation.get()) {
-            return;
-        }
+    ReclaimScope scope;
+    auto& location = index_[animation.get()];
+    if (location.handle.peek(scope) == animation.get()) {
+        return;
     }
-    animations_.push_back(IAnimation::WeakPtr(animation));
+    // New, or replacing a destroyed animation at the same address, which tick() drops.
+    location = {IAnimation::WeakPtr(animation), Ticked, static_cast<uint32_t>(animations_.size())};
+    animations_.push_back({location.handle, as_track(animation.get()), 0, animation.get()});
 }
 
 void AnimatorImpl::remove(const IAnimation::Ptr& animation)
@@ -37,47 +312,144 @@ void AnimatorImpl::remove(const IAnimation::Ptr& animation)
     if (!animation) {
         return;
     }
-    for (size_t i = 0; i < animations_.size(); ++i) {
-        auto locked = animations_[i].lock();
-        if (locked && locked.get() == animation.get()) {
-            animations_.erase(animations_.begin() + static_cast<ptrdiff_t>(i));
-            return;
+    ReclaimScope scope;
+    auto* location = find(animation, scope);
+    if (!location) {
+        return;
+    }
+    auto list = location->list;
+    auto slot = location->slot;
+    index_.erase(animation.get());
+    if (list == Ticked) {
+        if (ticking_) {
+            // Dropped by the loop of tick(), which may be visiting the slot.
+            animations_[slot].handle = IAnimation::WeakPtr{};
+        } else {
+            drop_ticked(slot, scope);
+        }
+    } else if (list == Idle) {
+        // Dropped when it wakes, as other woken slots may be pending.
+        idle_[slot].handle = IAnimation::WeakPtr{};
+        idle_[slot].track->leave_idle();
+    } else if (auto* track = as_track(animation.get())) {
+        for (auto& batch : batches_) {
+            if (batch->erase(*track, scope)) {
+                return;
+            }
         }
     }
 }
 
 void AnimatorImpl::cancel_all()
 {
-    for (auto& weak : animations_) {
-        auto anim = weak.lock();
-        if (anim) {
+    // The batches are only emptied, as this may run from a handler called by one of them.
+    for (auto& batch : batches_) {
+        ReclaimScope scope;
+        batch->for_each(scope, [](AnimationTrackImpl& track) { track.uninstall(); });
+        batch->clear();
+    }
+    clear_idle(true);
+    ReclaimScope scope;
+    for (auto& entry : animations_) {
+        if (auto* anim = entry.handle.peek(scope)) {
             anim->uninstall();
         }
     }
     animations_.clear();
+    index_.clear();
 }
 
 size_t AnimatorImpl::active_count() const
 {
+    ReclaimScope scope;
     size_t n = 0;
-    for (auto& weak : animations_) {
-        auto anim = weak.lock();
-        if (anim && anim->is_active()) {
-            ++n;
-        }
+    for (auto& item : index_) {
+        auto* anim = item.second.handle.peek(scope);
+        n += anim && anim->is_active();
     }
     return n;
 }
 
 size_t AnimatorImpl::count() const
 {
+    ReclaimScope scope;
     size_t n = 0;
-    for (auto& weak : animations_) {
-        if (weak.lock()) {
-            ++n;
-        }
+    for (auto& item : index_) {
+        n += item.second.handle.peek(scope) != nullptr;
     }
     return n;
 }
 
+void AnimatorImpl::set_lod(const IAnimation::Ptr& animation, uint32_t level)
+{
+    if (!animation) {
+        return;
+    }
+    level = std::min(level, LOD_COUNT - 1);
+    ReclaimScope scope;
+    auto* location = find(animation, scope);
+    if (!location) {
+        return;
+    }
+    if (location->list == Ticked) {
+        animations_[location->slot].lod = level;
+        return;
+    }
+    if (location->list == Idle) {
+        idle_[location->slot].lod = level;
+        return;
+    }
+    auto* track = as_track(animation.get());
+    for (auto& batch : batches_) {
+        if (!batch->contains(*track, scope)) {
+            continue;
+        }
+        if (batch->get_lod() != level) {
+            // Joins a batch of the new level after its next tick.
+            batch->erase(*track, scope);
+            push_ticked({location->handle, track, level, animation.get()}, scope);
+        }
+        return;
+    }
+}
+
+uint32_t AnimatorImpl::get_lod(const IAnimation::Ptr& animation) const
+{
+    if (!animation) {
+        return 0;
+    }
+    ReclaimScope scope;
+    auto* location = find(animation, scope);
+    if (!location) {
+        return 0;
+    }
+    if (location->list == Ticked) {
+        return animations_[location->slot].lod;
+    }
+    if (location->list == Idle) {
+        return idle_[location->slot].lod;
+    }
+    auto* track = as_track(animation.get());
+    for (auto& batch : batches_) {
+        if (batch->contains(*track, scope)) {
+            return batch->get_lod();
+        }
+    }
+    return 0;
+}
+
+void AnimatorImpl::set_lod_interval(uint32_t level, uint32_t interval)
+{
+    // The dt accumulated so far is kept, and handed out at the next update; a level with an
+    // interval of 0 accumulates none, so it resumes without the time it stood still for.
+    if (level < LOD_COUNT) {
+        lods_[level].interval = interval;
+    }
+}
+
+uint32_t AnimatorImpl::get_lod_interval(uint32_t level) const
+{
+    return level < LOD_COUNT ? lods_[level].interval : 0;
+}
+
 } // namespace velk
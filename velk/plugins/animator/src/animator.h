@@ -1,17 +1,35 @@
 #ifndef VELK_ANIMATOR_IMPL_H
 #define VELK_ANIMATOR_IMPL_H
 
+#include "notification_batch.h"
+#include "track_batch.h"
+
 #include <velk/ext/object.h>
 #include <velk/plugins/animator/interface/intf_animator.h>
 #include <velk/plugins/animator/plugin.h>
 #include <velk/vector.h>
 
+#include <unordered_map>
+
 namespace velk {
 
+/**
+ * @brief IAnimator implementation.
+ *
+ * Playing keyframe tracks of the built-in scalar types are moved into one TrackBatch per type,
+ * easing and level of detail, which advances them without a call to tick() each. Tracks that are
+ * not playing are moved into the idle list, which tick() does not visit until they wake. All
+ * other animations are ticked one by one.
+ *
+ * Each animation is indexed by its address, so that add(), remove() and the LOD calls find it
+ * without a scan. The index tells an animation from a later one at the same address by its
+ * handle, and drops the entries of destroyed animations as tick() comes across them.
+ */
 class AnimatorImpl : public ext::Object<AnimatorImpl, IAnimator>
 {
 public:
     VELK_CLASS_UID(ClassId::Animator);
+    ~AnimatorImpl();
 
     void tick(const UpdateInfo& info) override;
     void add(const IAnimation::Ptr& animation) override;
@@ -19,9 +37,89 @@ public:
     void cancel_all() override;
     size_t active_count() const override;
     size_t count() const override;
+    const AnimatorStats& get_stats() const override { return stats_; }
+    void set_executor(const IExecutor::Ptr& executor) override { executor_ = executor; }
+    IExecutor::Ptr get_executor() const override { return executor_; }
+    void set_lod(const IAnimation::Ptr& animation, uint32_t level) override;
+    uint32_t get_lod(const IAnimation::Ptr& animation) const override;
+    void set_lod_interval(uint32_t level, uint32_t interval) override;
+    uint32_t get_lod_interval(uint32_t level) const override;
+
+    /** @brief Called by the track in slot @p slot of the idle list when it may play again. */
+    void wake(uint32_t slot) { woken_.push_back(slot); }
 
 private:
-    vector<IAnimation::WeakPtr> animations_;
+    // The list an animation is on.
+    enum List : uint8_t
+    {
+        Ticked,  // animations_.
+        Idle,    // idle_.
+        Batched  // One of batches_.
+    };
+
+    // Where an animation is, under its address in index_.
+    struct Location
+    {
+        IAnimation::WeakPtr handle; // Tells the animation from a later one at the same address.
+        List list = Ticked;
+        uint32_t slot = 0;          // Slot in animations_ or idle_.
+    };
+
+    // Returns the location of animation, or null if it was not added.
+    Location* find(const IAnimation::Ptr& animation, const ReclaimScope& scope);
+    const Location* find(const IAnimation::Ptr& animation, const ReclaimScope& scope) const;
+    // Records that the animation of entry is in slot of list, if it is alive.
+    void locate(const AnimationEntry& entry, List list, size_t slot, const ReclaimScope& scope);
+    // Drops the index entry of key if the animation there has been destroyed.
+    void forget(const IAnimation* key);
+    // Appends entry to animations_.
+    void push_ticked(AnimationEntry&& entry, const ReclaimScope& scope);
+    // Removes slot from animations_, moving the last entry into it.
+    void drop_ticked(size_t slot, const ReclaimScope& scope);
+    // Moves the track in slot of animations_ into idle_.
+    void park(size_t slot, const ReclaimScope& scope);
+    // Moves the tracks that woke since the last tick from idle_ back into animations_.
+    void wake_idle(const ReclaimScope& scope);
+    // Empties idle_, uninstalling the live tracks if uninstall is set.
+    void clear_idle(bool uninstall);
+
+    // Moves the track of entry into the batch of its type; false if it cannot be batched.
+    bool join_batch(const AnimationEntry& entry, const ReclaimScope& scope);
+    // Evaluates and stores the batches due in this tick on executor_ if they are large enough;
+    // false if not.
+    bool evaluate_parallel(const ReclaimScope& scope);
+
+    // Slots [begin, end) of a batch, evaluated by one task of evaluate_parallel().
+    struct BatchChunk
+    {
+        TrackBatch* batch;
+        const UpdateInfo* info; // UpdateInfo of the level of the batch.
+        size_t begin;
+        size_t end;
+    };
+
+    // A level of detail and its schedule.
+    struct LodLevel
+    {
+        uint32_t interval = 1; // Ticks per update of the animations, 0 if never.
+        uint32_t skipped = 0;  // Ticks since the last update.
+        Duration pending;      // Sum of the dt of the skipped ticks.
+        bool due = false;      // Set if the animations update in the current tick.
+        UpdateInfo info;       // UpdateInfo of the update, with the accumulated dt.
+    };
+
+    vector<AnimationEntry> animations_;           // Animations ticked one by one.
+    vector<AnimationEntry> idle_;                 // Tracks that are not playing.
+    vector<uint32_t> woken_;                      // Slots of idle_ whose track may play again.
+    vector<std::unique_ptr<TrackBatch>> batches_; // Batched tracks, one batch per type, easing and LOD.
+    std::unordered_map<const IAnimation*, Location> index_; // Every animation, by address.
+    vector<AnimationEntry> reclaimed_;            // Buffer of the reclaim() of the batches.
+    bool ticking_ = false;                        // Set during tick().
+    AnimatorStats stats_;                         // Stats of the last tick().
+    vector<DeferredPropertySet> notifications_;   // Buffer of the NotificationBatch of tick().
+    IExecutor::Ptr executor_;                     // Executor of evaluate_parallel(), or null.
+    vector<BatchChunk> chunks_;                   // Buffer of evaluate_parallel().
+    LodLevel lods_[LOD_COUNT];
 };
 
 } // namespace velk
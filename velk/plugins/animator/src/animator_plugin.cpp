@@ -4,33 +4,35 @@
 
 namespace velk {
 
+namespace {
+
+template <class T>
+void register_interpolator(ITypeRegistry& types)
+{
+    types.register_interpolator<T>(&detail::typed_interpolator<T>, &detail::raw_typed_interpolator<T>);
+}
+
+} // namespace
+
 ReturnValue AnimatorPlugin::initialize(IVelk& velk, PluginConfig& config)
 {
     config.enableUpdate = true;
-    auto rv = register_type<AnimationTrackImpl>(velk);
-    if (failed(rv)) {
-        return rv;
-    }
-    rv = register_type<AnimatorImpl>(velk);
-    if (failed(rv)) {
-        return rv;
-    }
-    rv = register_type<TransitionImpl>(velk);
+    auto rv =
+        register_types<AnimationTrackImpl, AnimatorImpl, TransitionImpl, ext::AnyValue<KeyframeEntry>>(velk);
     if (failed(rv)) {
         return rv;
     }
     auto& types = velk.type_registry();
-    types.register_type<ext::AnyValue<KeyframeEntry>>();
-    types.register_interpolator<float>(&detail::typed_interpolator<float>);
-    types.register_interpolator<double>(&detail::typed_interpolator<double>);
-    types.register_interpolator<uint8_t>(&detail::typed_interpolator<uint8_t>);
-    types.register_interpolator<uint16_t>(&detail::typed_interpolator<uint16_t>);
-    types.register_interpolator<uint32_t>(&detail::typed_interpolator<uint32_t>);
-    types.register_interpolator<uint64_t>(&detail::typed_interpolator<uint64_t>);
-    types.register_interpolator<int8_t>(&detail::typed_interpolator<int8_t>);
-    types.register_interpolator<int16_t>(&detail::typed_interpolator<int16_t>);
-    types.register_interpolator<int32_t>(&detail::typed_interpolator<int32_t>);
-    types.register_interpolator<int64_t>(&detail::typed_interpolator<int64_t>);
+    register_interpolator<float>(types);
+    register_interpolator<double>(types);
+    register_interpolator<uint8_t>(types);
+    register_interpolator<uint16_t>(types);
+    register_interpolator<uint32_t>(types);
+    register_interpolator<uint64_t>(types);
+    register_interpolator<int8_t>(types);
+    register_interpolator<int16_t>(types);
+    register_interpolator<int32_t>(types);
+    register_interpolator<int64_t>(types);
 
     animator_ = velk.create<IAnimator>(ClassId::Animator);
     velk_ = &velk;
@@ -0,0 +1,129 @@
+#include "easing_batch.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VELK_EASING_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VELK_EASING_NEON
+#endif
+
+namespace velk {
+
+namespace {
+
+template <easing::EasingFn Fn>
+void ease_each(const float* t, float* out, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = Fn(t[i]);
+    }
+}
+
+// The compiler does not vectorize the branch of the piecewise curves, as computing both halves
+// could raise floating-point exceptions the scalar code does not. These kernels compute both
+// halves four values at a time and select, with the operations in the order of the scalar
+// functions. A scalar loop handles the remainder, and all values without SSE2 or NEON.
+#if defined(VELK_EASING_SSE2)
+using Lanes = __m128;
+inline Lanes load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, Lanes v) { _mm_storeu_ps(p, v); }
+inline Lanes splat(float v) { return _mm_set1_ps(v); }
+inline Lanes add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+// Lanes of a where x < limit, of b elsewhere.
+inline Lanes select_less(Lanes x, float limit, Lanes a, Lanes b)
+{
+    Lanes mask = _mm_cmplt_ps(x, splat(limit));
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+#elif defined(VELK_EASING_NEON)
+using Lanes = float32x4_t;
+inline Lanes load(const float* p) { return vld1q_f32(p); }
+inline void store(float* p, Lanes v) { vst1q_f32(p, v); }
+inline Lanes splat(float v) { return vdupq_n_f32(v); }
+inline Lanes add(Lanes a, Lanes b) { return vaddq_f32(a, b); }
+inline Lanes sub(Lanes a, Lanes b) { return vsubq_f32(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return vmulq_f32(a, b); }
+inline Lanes select_less(Lanes x, float limit, Lanes a, Lanes b)
+{
+    return vbslq_f32(vcltq_f32(x, splat(limit)), a, b);
+}
+#endif
+
+void ease_in_out_quad(const float* t, float* out, size_t count)
+{
+    size_t i = 0;
+#if defined(VELK_EASING_SSE2) || defined(VELK_EASING_NEON)
+    for (; i + 4 <= count; i += 4) {
+        Lanes x = load(t + i);
+        Lanes in = mul(mul(splat(2.f), x), x);
+        Lanes out_half = add(splat(-1.f), mul(sub(splat(4.f), mul(splat(2.f), x)), x));
+        store(out + i, select_less(x, 0.5f, in, out_half));
+    }
+#endif
+    ease_each<easing::in_out_quad>(t + i, out + i, count - i);
+}
+
+void ease_in_out_cubic(const float* t, float* out, size_t count)
+{
+    size_t i = 0;
+#if defined(VELK_EASING_SSE2) || defined(VELK_EASING_NEON)
+    for (; i + 4 <= count; i += 4) {
+        Lanes x = load(t + i);
+        Lanes in = mul(mul(mul(splat(4.f), x), x), x);
+        Lanes u = sub(mul(splat(2.f), x), splat(2.f));
+        Lanes out_half = add(mul(mul(sub(x, splat(1.f)), u), u), splat(1.f));
+        store(out + i, select_less(x, 0.5f, in, out_half));
+    }
+#endif
+    ease_each<easing::in_out_cubic>(t + i, out + i, count - i);
+}
+
+struct EasingKernel
+{
+    easing::EasingFn fn;
+    EasingBatchFn batch;
+};
+
+template <easing::EasingFn Fn>
+constexpr EasingKernel each()
+{
+    return {Fn, &ease_each<Fn>};
+}
+
+// Ordered by how common the curves are, as find_easing_batch() scans linearly.
+constexpr EasingKernel builtin_kernels[] = {
+    each<easing::linear>(),
+    {easing::in_out_quad, &ease_in_out_quad},
+    each<easing::out_quad>(),
+    each<easing::in_quad>(),
+    {easing::in_out_cubic, &ease_in_out_cubic},
+    each<easing::out_cubic>(),
+    each<easing::in_cubic>(),
+    each<easing::in_out_sine>(),
+    each<easing::out_sine>(),
+    each<easing::in_sine>(),
+    each<easing::in_out_expo>(),
+    each<easing::out_expo>(),
+    each<easing::in_expo>(),
+    each<easing::out_elastic>(),
+    each<easing::in_elastic>(),
+    each<easing::out_bounce>(),
+    each<easing::in_bounce>(),
+};
+
+} // namespace
+
+EasingBatchFn find_easing_batch(easing::EasingFn fn)
+{
+    for (auto& kernel : builtin_kernels) {
+        if (kernel.fn == fn) {
+            return kernel.batch;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace velk
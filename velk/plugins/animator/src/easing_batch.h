@@ -0,0 +1,41 @@
+#ifndef VELK_ANIMATOR_EASING_BATCH_H
+#define VELK_ANIMATOR_EASING_BATCH_H
+
+#include <velk/plugins/animator/easing.h>
+
+#include <cstddef>
+
+namespace velk {
+
+/** @brief Writes the eased value of each of the @p count factors in @p t to @p out. */
+using EasingBatchFn = void (*)(const float* t, float* out, size_t count);
+
+/**
+ * @brief Returns the batch kernel of a built-in easing function, or null for any other.
+ *
+ * The kernels are plain loops over the arrays with the easing inlined, which the compiler
+ * vectorizes for the instruction set the plugin is built for (SSE2 by default on x86-64, AVX2
+ * with -mavx2, NEON on AArch64). The piecewise in_out curves, which the compiler keeps scalar,
+ * use SSE2 or NEON directly. The curves built on std::sin and std::pow stay scalar per value, but
+ * still save the indirect call.
+ *
+ * Easing functions are matched by address, so a built-in easing whose address differs across
+ * module boundaries (inline functions on Windows) is not found and runs through the scalar path.
+ */
+EasingBatchFn find_easing_batch(easing::EasingFn fn);
+
+/** @brief Evaluates @p fn over @p count factors, with @p batch if it is not null. */
+inline void ease_batch(easing::EasingFn fn, EasingBatchFn batch, const float* t, float* out, size_t count)
+{
+    if (batch) {
+        batch(t, out, count);
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = fn(t[i]);
+    }
+}
+
+} // namespace velk
+
+#endif // VELK_ANIMATOR_EASING_BATCH_H
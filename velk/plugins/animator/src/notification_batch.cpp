@@ -0,0 +1,38 @@
+#include "notification_batch.h"
+
+#include <velk/api/velk.h>
+
+namespace velk {
+
+namespace {
+
+thread_local NotificationBatch* current_batch = nullptr;
+
+} // namespace
+
+NotificationBatch::NotificationBatch(vector<DeferredPropertySet>& buffer)
+    : buffer_(buffer), previous_(current_batch)
+{
+    current_batch = this;
+}
+
+NotificationBatch::~NotificationBatch()
+{
+    current_batch = previous_;
+    if (!buffer_.empty()) {
+        instance().queue_deferred_properties({buffer_.data(), buffer_.size()});
+    }
+    // Keeps the capacity, so that steady ticks stop allocating.
+    buffer_.clear();
+}
+
+void NotificationBatch::queue(const IPropertyInternal::WeakPtr& property)
+{
+    if (current_batch) {
+        current_batch->buffer_.push_back({property, nullptr});
+    } else {
+        instance().queue_deferred_property({property, nullptr});
+    }
+}
+
+} // namespace velk
@@ -0,0 +1,41 @@
+#ifndef VELK_ANIMATOR_NOTIFICATION_BATCH_H
+#define VELK_ANIMATOR_NOTIFICATION_BATCH_H
+
+#include <velk/interface/intf_velk.h>
+#include <velk/vector.h>
+
+namespace velk {
+
+/**
+ * @brief Collects the deferred change notifications of animated properties on this thread.
+ *
+ * While a batch is open, queue() appends to its buffer instead of locking the deferred queue for
+ * each property; the batch queues them all with one IVelk::queue_deferred_properties() call when
+ * it closes. The animator opens one around each tick. Batches nest, the innermost collects.
+ */
+class NotificationBatch
+{
+public:
+    /** @brief Opens a batch collecting into @p buffer, which must be empty. */
+    explicit NotificationBatch(vector<DeferredPropertySet>& buffer);
+    /** @brief Queues the collected notifications and closes the batch. */
+    ~NotificationBatch();
+
+    NotificationBatch(const NotificationBatch&) = delete;
+    NotificationBatch& operator=(const NotificationBatch&) = delete;
+
+    /**
+     * @brief Queues the deferred on_changed of @p property, in the open batch if there is one.
+     *
+     * Expired properties are skipped when the notifications are queued.
+     */
+    static void queue(const IPropertyInternal::WeakPtr& property);
+
+private:
+    vector<DeferredPropertySet>& buffer_;
+    NotificationBatch* previous_;
+};
+
+} // namespace velk
+
+#endif // VELK_ANIMATOR_NOTIFICATION_BATCH_H
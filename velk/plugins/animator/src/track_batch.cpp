@@ -0,0 +1,215 @@
+#include "track_batch.h"
+
+#include "animation_track.h"
+
+namespace velk {
+
+namespace {
+
+template <class T>
+bool is_builtin(Uid type, InterpolatorFn interpolator)
+{
+    return type == type_uid<T>() && interpolator == &detail::typed_interpolator<T>;
+}
+
+template <class... T>
+std::unique_ptr<TrackBatch> create_typed(Uid type, InterpolatorFn interpolator)
+{
+    std::unique_ptr<TrackBatch> batch;
+    // A custom interpolator registered for one of the types is not batched, as it may differ.
+    ((is_builtin<T>(type, interpolator) ? (void)(batch = std::make_unique<TypedTrackBatch<T>>()) : (void)0),
+     ...);
+    return batch;
+}
+
+} // namespace
+
+std::unique_ptr<TrackBatch> TrackBatch::create(Uid type, InterpolatorFn interpolator, easing::EasingFn easing,
+                                               uint32_t lod)
+{
+    auto batch = create_typed<float, double, uint8_t, uint16_t, uint32_t, uint64_t, int8_t, int16_t, int32_t,
+                              int64_t>(type, interpolator);
+    if (batch) {
+        batch->set_key(easing, lod);
+    }
+    return batch;
+}
+
+TrackBatch::~TrackBatch()
+{
+    // Tracks outliving the animator must not report back to the batch.
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        if (flags_[i] == Active) {
+            tracks_[i]->set_batch(nullptr, 0);
+        }
+    }
+}
+
+bool TrackBatch::add(const AnimationEntry& entry, const BatchSegment& seg)
+{
+    if (!push_values(*seg.from, *seg.to)) {
+        return false;
+    }
+    auto slot = static_cast<uint32_t>(tracks_.size());
+    tracks_.push_back(entry.track);
+    handles_.push_back(entry.handle);
+    keys_.push_back(entry.key);
+    flags_.push_back(Active);
+    elapsed_.push_back(seg.elapsed);
+    duration_.push_back(seg.duration);
+    begin_.push_back(seg.begin);
+    end_.push_back(seg.end);
+    t_.push_back(0.f);
+    eased_.push_back(0.f);
+    progress_.push_back(0.f);
+    edge_.push_back(0);
+    plain_.push_back(entry.track->have_plain_targets());
+    stored_.push_back(0);
+    entry.track->set_batch(this, slot);
+    return true;
+}
+
+size_t TrackBatch::find(const AnimationTrackImpl& track, const ReclaimScope& scope) const
+{
+    // A track in the batch knows its slot; only one that left it is searched for.
+    if (track.get_batch() == this) {
+        return track.get_batch_slot();
+    }
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        if (tracks_[i] == &track && flags_[i] != Erased && handles_[i].peek(scope)) {
+            return i;
+        }
+    }
+    return tracks_.size();
+}
+
+bool TrackBatch::erase(const AnimationTrackImpl& track, const ReclaimScope& scope)
+{
+    auto slot = find(track, scope);
+    if (slot == tracks_.size()) {
+        return false;
+    }
+    if (flags_[slot] == Active) {
+        tracks_[slot]->set_batch(nullptr, 0);
+    }
+    flags_[slot] = Erased;
+    return true;
+}
+
+void TrackBatch::clear()
+{
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        if (flags_[i] == Active) {
+            tracks_[i]->set_batch(nullptr, 0);
+        }
+        flags_[i] = Erased;
+    }
+}
+
+void TrackBatch::evaluate(const UpdateInfo& info, size_t begin, size_t end)
+{
+    int64_t dt = info.dt.us;
+    // The arithmetic of AnimationTrackImpl::tick() and apply_at() for a tick within the segment.
+    for (size_t i = begin; i < end; ++i) {
+        int64_t elapsed = elapsed_[i] + dt;
+        bool inside = elapsed > 0 && elapsed >= begin_[i] && elapsed < end_[i];
+        edge_[i] = !inside;
+        stored_[i] = 0;
+        if (inside) {
+            elapsed_[i] = elapsed;
+            t_[i] = static_cast<float>(elapsed - begin_[i]) / static_cast<float>(end_[i] - begin_[i]);
+            progress_[i] = static_cast<float>(elapsed) / static_cast<float>(duration_[i]);
+        }
+    }
+    // Slots at an edge are eased from a stale factor too, which keeps the loop free of branches.
+    ease_batch(easing_, easingBatch_, t_.data() + begin, eased_.data() + begin, end - begin);
+    interpolate(begin, end);
+}
+
+void TrackBatch::store(size_t begin, size_t end, const ReclaimScope& scope)
+{
+    for (size_t i = begin; i < end; ++i) {
+        if (flags_[i] == Active && !edge_[i] && plain_[i] && handles_[i].peek(scope)) {
+            tracks_[i]->store_batched(elapsed_[i], progress_[i], get_value(i), size_, type_);
+            stored_[i] = 1;
+        }
+    }
+}
+
+void TrackBatch::finish(const UpdateInfo& info, const ReclaimScope& scope, AnimatorStats& stats)
+{
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        auto* anim = handles_[i].peek(scope);
+        if (!anim) {
+            continue;
+        }
+        if (stored_[i]) {
+            // Advanced already, even if a notification handler has made it leave since.
+            tracks_[i]->notify_batched();
+            ++stats.ticked;
+            ++stats.batched;
+            continue;
+        }
+        if (flags_[i] == Erased) {
+            continue;
+        }
+        if (flags_[i] == Released || edge_[i]) {
+            // Left during this loop, or leaving the segment: ticked like an unbatched animation.
+            if (anim->tick(info) == ReturnValue::Success) {
+                ++stats.ticked;
+                stats.finished += tracks_[i]->is_finished();
+            }
+            continue;
+        }
+        tracks_[i]->write_batched(elapsed_[i], progress_[i], get_value(i), size_, type_);
+        ++stats.ticked;
+        ++stats.batched;
+    }
+}
+
+void TrackBatch::reclaim(vector<AnimationEntry>& out)
+{
+    for (size_t i = 0; i < tracks_.size();) {
+        if (flags_[i] == Active) {
+            ++i;
+            continue;
+        }
+        if (flags_[i] == Released) {
+            // Released ones too, so that the animator can drop them from its index.
+            out.push_back({handles_[i], tracks_[i], lod_, keys_[i]});
+        }
+        size_t last = tracks_.size() - 1;
+        if (i != last) {
+            tracks_[i] = tracks_[last];
+            handles_[i] = std::move(handles_[last]);
+            keys_[i] = keys_[last];
+            flags_[i] = flags_[last];
+            elapsed_[i] = elapsed_[last];
+            duration_[i] = duration_[last];
+            begin_[i] = begin_[last];
+            end_[i] = end_[last];
+            t_[i] = t_[last];
+            plain_[i] = plain_[last];
+            if (flags_[i] == Active) {
+                tracks_[i]->set_batch(this, static_cast<uint32_t>(i));
+            }
+        }
+        remove_values(last, i);
+        tracks_.pop_back();
+        handles_.pop_back();
+        keys_.pop_back();
+        flags_.pop_back();
+        elapsed_.pop_back();
+        duration_.pop_back();
+        begin_.pop_back();
+        end_.pop_back();
+        t_.pop_back();
+        eased_.pop_back();
+        progress_.pop_back();
+        edge_.pop_back();
+        plain_.pop_back();
+        stored_.pop_back();
+    }
+}
+
+} // namespace velk
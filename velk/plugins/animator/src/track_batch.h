@@ -0,0 +1,239 @@
+#ifndef VELK_ANIMATOR_TRACK_BATCH_H
+#define VELK_ANIMATOR_TRACK_BATCH_H
+
+#include "easing_batch.h"
+
+#include <velk/interface/intf_type_registry.h>
+#include <velk/plugins/animator/easing.h>
+#include <velk/plugins/animator/interface/intf_animation.h>
+#include <velk/plugins/animator/interface/intf_animator.h>
+#include <velk/plugins/animator/interpolator_traits.h>
+#include <velk/vector.h>
+
+#include <memory>
+
+namespace velk {
+
+class AnimationTrackImpl;
+
+/** @brief An animation of an animator, with its AnimationTrackImpl if it is one. */
+struct AnimationEntry
+{
+    IAnimation::WeakPtr handle;
+    AnimationTrackImpl* track = nullptr;
+    uint32_t lod = 0;                // Level of detail, see IAnimator::set_lod().
+    const IAnimation* key = nullptr; // Address of the animation, by which the animator indexes it.
+};
+
+/** @brief The keyframe segment a playing track is in, as handed to a TrackBatch. */
+struct BatchSegment
+{
+    int64_t elapsed;         // Elapsed time of the track.
+    int64_t duration;        // Total duration of the track.
+    int64_t begin;           // Time of the keyframe the segment starts at.
+    int64_t end;             // Time of the keyframe the segment ends at.
+    easing::EasingFn easing; // Easing of the end keyframe.
+    const IAny* from;        // Value of the start keyframe.
+    const IAny* to;          // Value of the end keyframe.
+};
+
+/**
+ * @brief Playing animation tracks of one value type and easing, advanced together.
+ *
+ * Keeps the timing and the keyframe values of the current segment of each track in parallel
+ * arrays, so that a tick advances all of them in tight loops and only calls back into a track to
+ * write its value. The easing of all tracks is evaluated in one call to its batch kernel, see
+ * find_easing_batch(). A track leaves its batch whenever anything but the batch changes it; the
+ * animator then ticks it on its own again. Ticks that would cross into another segment or reach
+ * the end also run through AnimationTrackImpl::tick(), which makes the track leave.
+ *
+ * Single-threaded, like the animator that owns it, except that an animator with an executor may
+ * call evaluate() and store() for disjoint slot ranges concurrently, see tick().
+ */
+class TrackBatch
+{
+public:
+    /**
+     * @brief Creates a batch for tracks of type @p type interpolated by @p interpolator, in
+     *        segments eased by @p easing, at level of detail @p lod.
+     * @return The batch, or null if @p interpolator is not the built-in one of a scalar type.
+     */
+    static std::unique_ptr<TrackBatch> create(Uid type, InterpolatorFn interpolator,
+                                              easing::EasingFn easing, uint32_t lod);
+
+    virtual ~TrackBatch();
+
+    /** @brief Returns the value type of the tracks. */
+    Uid get_type() const { return type_; }
+    /** @brief Returns the interpolator of the tracks. */
+    InterpolatorFn get_interpolator() const { return interpolator_; }
+    /** @brief Returns the easing of the segments the tracks play in. */
+    easing::EasingFn get_easing() const { return easing_; }
+    /** @brief Returns the level of detail of the tracks. */
+    uint32_t get_lod() const { return lod_; }
+    /** @brief Returns the number of tracks, including those that left since the last reclaim(). */
+    size_t size() const { return tracks_.size(); }
+
+    /**
+     * @brief Adds the track of @p entry, playing in @p seg.
+     * @return false if the keyframe values of @p seg are not of the batch type.
+     */
+    bool add(const AnimationEntry& entry, const BatchSegment& seg);
+    /** @brief Called by a track that leaves the batch. */
+    void release(uint32_t slot) { flags_[slot] = Released; }
+    /**
+     * @brief Removes @p track without handing it back to the animator.
+     * @return false if @p track is neither in the batch nor left it since the last reclaim().
+     */
+    bool erase(const AnimationTrackImpl& track, const ReclaimScope& scope);
+    /** @brief Removes all tracks without handing them back to the animator. */
+    void clear();
+    /** @brief Returns true if @p track is in the batch or left it since the last reclaim(). */
+    bool contains(const AnimationTrackImpl& track, const ReclaimScope& scope) const
+    {
+        return find(track, scope) != tracks_.size();
+    }
+
+    /**
+     * @brief Advances all tracks by @p info.dt and writes their values.
+     *
+     * Equivalent to evaluate() over all slots followed by finish(). An animator ticking in
+     * parallel instead calls evaluate() and store() for chunks of the slots on an executor, then
+     * finish() on its own thread.
+     */
+    void tick(const UpdateInfo& info, const ReclaimScope& scope, AnimatorStats& stats)
+    {
+        evaluate(info, 0, tracks_.size());
+        finish(info, scope, stats);
+    }
+    /** @brief Computes the values of slots [@p begin, @p end) for tick @p info. */
+    void evaluate(const UpdateInfo& info, size_t begin, size_t end);
+    /**
+     * @brief Stores the values of slots [@p begin, @p end) that evaluate() computed into their
+     *        tracks and targets, where that is safe on any thread, without notifying.
+     */
+    void store(size_t begin, size_t end, const ReclaimScope& scope);
+    /**
+     * @brief Completes the tick on the thread of the animator: notifies for the slots store()
+     *        handled and writes or ticks all others, counting them in @p stats.
+     */
+    void finish(const UpdateInfo& info, const ReclaimScope& scope, AnimatorStats& stats);
+    /**
+     * @brief Appends the tracks that left the batch to @p out, including those released since,
+     *        and compacts the arrays.
+     */
+    void reclaim(vector<AnimationEntry>& out);
+    /** @brief Calls @p fn with each live track in the batch or that left it since the last reclaim(). */
+    template <class Fn>
+    void for_each(const ReclaimScope& scope, Fn&& fn) const
+    {
+        for (size_t i = 0; i < tracks_.size(); ++i) {
+            if (flags_[i] != Erased && handles_[i].peek(scope)) {
+                fn(*tracks_[i]);
+            }
+        }
+    }
+
+protected:
+    TrackBatch(Uid type, size_t size, InterpolatorFn interpolator)
+        : type_(type), size_(size), interpolator_(interpolator)
+    {}
+
+    // Sets the easing and the level of detail of the batch.
+    void set_key(easing::EasingFn easing, uint32_t lod)
+    {
+        easing_ = easing;
+        easingBatch_ = find_easing_batch(easing);
+        lod_ = lod;
+    }
+
+    // Returns the slot for which for_each() would visit track, or size().
+    size_t find(const AnimationTrackImpl& track, const ReclaimScope& scope) const;
+
+    // Appends the typed values of from and to; false if they are not of the batch type.
+    virtual bool push_values(const IAny& from, const IAny& to) = 0;
+    // Moves the values of slot from into slot to, then removes the last slot.
+    virtual void remove_values(size_t from, size_t to) = 0;
+    // Interpolates the values of slots [begin, end) that are not at an edge with their eased_ factor.
+    virtual void interpolate(size_t begin, size_t end) = 0;
+    // Returns the interpolated value of slot.
+    virtual const void* get_value(size_t slot) const = 0;
+
+    enum Flag : uint8_t
+    {
+        Active,   // Advanced by the batch.
+        Released, // Left the batch; handed back to the animator by reclaim().
+        Erased    // Removed from the animator.
+    };
+
+    vector<AnimationTrackImpl*> tracks_; // Valid while the handle can be peeked.
+    vector<IAnimation::WeakPtr> handles_;
+    vector<const IAnimation*> keys_;     // AnimationEntry::key of each slot.
+    vector<uint8_t> flags_;              // Flag of each slot.
+    vector<int64_t> elapsed_;            // Synced with the state of the track by each write.
+    vector<int64_t> duration_;
+    vector<int64_t> begin_;              // Start time of the segment.
+    vector<int64_t> end_;                // End time of the segment.
+    vector<float> t_;                    // Interpolation factor of the current tick.
+    vector<float> eased_;                // t_ eased.
+    vector<float> progress_;             // Progress of the current tick.
+    vector<uint8_t> edge_;               // Set if the current tick leaves the segment.
+    vector<uint8_t> plain_;              // Set if store() may write the track on any thread.
+    vector<uint8_t> stored_;             // Set if store() wrote the track in the current tick.
+
+private:
+    Uid type_;
+    size_t size_;
+    InterpolatorFn interpolator_;
+    easing::EasingFn easing_ = nullptr;
+    EasingBatchFn easingBatch_ = nullptr;
+    uint32_t lod_ = 0;
+};
+
+/** @brief TrackBatch for a scalar type T with the interpolator_trait<T> interpolator. */
+template <class T>
+class TypedTrackBatch final : public TrackBatch
+{
+public:
+    TypedTrackBatch() : TrackBatch(type_uid<T>(), sizeof(T), &detail::typed_interpolator<T>) {}
+
+protected:
+    bool push_values(const IAny& from, const IAny& to) override
+    {
+        constexpr auto uid = type_uid<T>();
+        T a{}, b{};
+        if (failed(from.get_data(&a, sizeof(T), uid)) || failed(to.get_data(&b, sizeof(T), uid))) {
+            return false;
+        }
+        from_.push_back(a);
+        to_.push_back(b);
+        values_.push_back(a);
+        return true;
+    }
+    void remove_values(size_t from, size_t to) override
+    {
+        from_[to] = from_[from];
+        to_[to] = to_[from];
+        from_.pop_back();
+        to_.pop_back();
+        values_.pop_back();
+    }
+    void interpolate(size_t begin, size_t end) override
+    {
+        for (size_t i = begin; i < end; ++i) {
+            if (!edge_[i]) {
+                values_[i] = interpolator_trait<T>::interpolate(from_[i], to_[i], eased_[i]);
+            }
+        }
+    }
+    const void* get_value(size_t slot) const override { return &values_[slot]; }
+
+private:
+    vector<T> from_;
+    vector<T> to_;
+    vector<T> values_;
+};
+
+} // namespace velk
+
+#endif // VELK_ANIMATOR_TRACK_BATCH_H
@@ -5,6 +5,7 @@
 #include <velk/plugins/animator/interface/intf_animator_plugin.h>
 
 #include <algorithm>
+#include <cstring>
 
 namespace velk {
 
@@ -12,9 +13,19 @@ namespace velk {
 // TransitionDriver
 // ============================================================================
 
-void TransitionDriver::init(const IAny& inner)
+void TransitionDriver::init(const IAny& inner, RawInterpolatorFn rawInterpolator)
 {
     display = inner.clone();
+    auto types = inner.get_compatible_types();
+    if (rawInterpolator && !types.empty()) {
+        size_t typeSize = inner.get_data_size(types[0]);
+        if (typeSize > 0 && typeSize <= INLINE_SIZE) {
+            raw = rawInterpolator;
+            rawType = types[0];
+            rawSize = typeSize;
+            return;
+        }
+    }
     from = inner.clone();
     target = inner.clone();
     result = inner.clone();
@@ -26,6 +37,16 @@ bool TransitionDriver::start(const void* data, size_t size, Uid type)
         return false;
     }
 
+    if (raw) {
+        if (type != rawType || size != rawSize || failed(display->get_data(fromData, size, type))) {
+            return false;
+        }
+        std::memcpy(targetData, data, size);
+        elapsed = {};
+        animating = true;
+        return true;
+    }
+
     // Capture from = current display value
     if (from) {
         from->copy_from(*display);
@@ -48,6 +69,12 @@ bool TransitionDriver::start_from(const IAny& value)
         return false;
     }
 
+    if (raw) {
+        if (failed(display->get_data(fromData, rawSize, rawType)) ||
+            failed(value.get_data(targetData, rawSize, rawType))) {
+            return false;
+        }
+    }
     if (from) {
         from->copy_from(*display);
     }
@@ -61,7 +88,7 @@ bool TransitionDriver::start_from(const IAny& value)
 }
 
 bool TransitionDriver::tick(Duration dt, Duration duration, easing::EasingFn easing,
-                            InterpolatorFn interpolator, IAny& inner, const IInterface::WeakPtr& owner)
+                            InterpolatorFn interpolator, IAny& inner, IPropertyInternal* property)
 {
     if (!animating) {
         return false;
@@ -77,20 +104,19 @@ bool TransitionDriver::tick(Duration dt, Duration duration, easing::EasingFn eas
 
     float eased = easing ? easing(t) : t;
 
-    if (interpolator && from && target && result) {
+    if (raw) {
+        raw(fromData, targetData, eased, resultData);
+        display->set_data(resultData, rawSize, rawType);
+        inner.set_data(resultData, rawSize, rawType);
+    } else if (interpolator && from && target && result) {
         if (succeeded(interpolator(*from, *target, eased, *result))) {
             display->copy_from(*result);
             inner.copy_from(*result);
         }
     }
 
-    // Fire on_changed on the property
-    auto prop = owner.lock();
-    if (prop) {
-        auto* propIntf = interface_cast<IProperty>(prop);
-        if (propIntf && propIntf->on_changed()) {
-            invoke_event(propIntf->on_changed(), display.get());
-        }
+    if (property) {
+        property->notify_changed();
     }
 
     if (t >= 1.f) {
@@ -106,6 +132,8 @@ void TransitionDriver::clear()
     from = nullptr;
     target = nullptr;
     result = nullptr;
+    raw = nullptr;
+    rawSize = 0;
     elapsed = {};
     animating = false;
 }
@@ -122,20 +150,26 @@ void TransitionProxy::set_inner(IAny::Ptr inner, const IInterface::WeakPtr& owne
     if (!inner_) {
         return;
     }
+    // Cast once, so that tick() only needs to check that the owner is alive.
+    property_ = interface_cast<IPropertyInternal>(owner_.lock());
 
     // Resolve interpolator from the inner's compatible type
     auto types = inner_->get_compatible_types();
+    RawInterpolatorFn raw = nullptr;
     if (!types.empty()) {
-        interpolator_ = instance().type_registry().find_interpolator(types[0]);
+        auto& registry = instance().type_registry();
+        interpolator_ = registry.find_interpolator(types[0]);
+        raw = registry.find_raw_interpolator(types[0]);
     }
 
-    driver.init(*inner_);
+    driver.init(*inner_, raw);
     pending_ = inner_->clone();
 }
 
 IAny::Ptr TransitionProxy::take_inner(IInterface&)
 {
     owner_ = IInterface::WeakPtr{};
+    property_ = nullptr;
     parent_ = nullptr;
     active_flag_ = nullptr;
     driver.clear();
@@ -196,7 +230,8 @@ IAny::Ptr TransitionProxy::clone() const
     return driver.display ? driver.display->clone() : nullptr;
 }
 
-bool TransitionProxy::tick(Duration dt, Duration duration, easing::EasingFn easing)
+bool TransitionProxy::tick(Duration dt, Duration duration, easing::EasingFn easing,
+                           const ReclaimScope& scope)
 {
     if (!inner_) {
         return false;
@@ -209,7 +244,8 @@ bool TransitionProxy::tick(Duration dt, Duration duration, easing::EasingFn easi
         driver.start_from(*pending_);
     }
 
-    return driver.tick(dt, duration, easing, interpolator_, *inner_, owner_);
+    auto* property = owner_.peek(scope) ? property_ : nullptr;
+    return driver.tick(dt, duration, easing, interpolator_, *inner_, property);
 }
 
 // ============================================================================
@@ -417,10 +453,11 @@ ReturnValue TransitionImpl::tick(const UpdateInfo& info)
     Duration duration = s ? s->duration : Duration{};
 
     // Advance each per-property driver (interpolates from -> target)
+    ReclaimScope scope;
     bool anyAnimating = false;
     for (auto& child : children_) {
         if (child.proxy) {
-            anyAnimating = child.proxy->tick(info.dt, duration, easing_) || anyAnimating;
+            anyAnimating = child.proxy->tick(info.dt, duration, easing_, scope) || anyAnimating;
         }
     }
     active_.store(anyAnimating, std::memory_order_relaxed);
@@ -3,11 +3,13 @@
 
 #include <velk/ext/any_extension.h>
 #include <velk/ext/object.h>
+#include <velk/interface/intf_property.h>
 #include <velk/plugins/animator/interface/intf_transition.h>
 #include <velk/plugins/animator/plugin.h>
 #include <velk/vector.h>
 
 #include <atomic>
+#include <cstddef>
 
 namespace velk {
 
@@ -17,15 +19,30 @@ namespace velk {
  * Plain C++ struct that holds the animation buffers (display, from, target, result)
  * and manages interpolation. Used by both TransitionImpl (direct install) and
  * TransitionProxy (multi-target children).
+ *
+ * Values of at most INLINE_SIZE bytes whose type has a raw interpolator are kept inline in
+ * the driver instead, so that only display is allocated and ticking allocates nothing.
  */
 struct TransitionDriver
 {
-    IAny::Ptr display, from, target, result;
+    static constexpr size_t INLINE_SIZE = 16;
+
+    IAny::Ptr display;
+    IAny::Ptr from, target, result; ///< Boxed values; null if the values are inline.
+    RawInterpolatorFn raw = nullptr; ///< Interpolator of the inline values.
+    Uid rawType;                     ///< Type of the inline values.
+    size_t rawSize = 0;              ///< Size of the inline values.
+    alignas(std::max_align_t) unsigned char fromData[INLINE_SIZE];
+    alignas(std::max_align_t) unsigned char targetData[INLINE_SIZE];
+    alignas(std::max_align_t) unsigned char resultData[INLINE_SIZE];
     Duration elapsed{};
     bool animating = false;
 
-    /** @brief Clones all scratch buffers from an inner IAny. */
-    void init(const IAny& inner);
+    /**
+     * @brief Clones the display buffer from an inner IAny, and the scratch buffers unless the
+     *        values fit inline and @p rawInterpolator is set.
+     */
+    void init(const IAny& inner, RawInterpolatorFn rawInterpolator);
 
     /** @brief Captures from=display, target=new data, resets elapsed. Returns false if no display. */
     bool start(const void* data, size_t size, Uid type);
@@ -34,11 +51,11 @@ struct TransitionDriver
     bool start_from(const IAny& value);
 
     /**
-     * @brief Interpolates one tick.
+     * @brief Interpolates one tick and notifies @p property unless it is null.
      * @return true if still animating.
      */
     bool tick(Duration dt, Duration duration, easing::EasingFn easing, InterpolatorFn interpolator,
-              IAny& inner, const IInterface::WeakPtr& owner);
+              IAny& inner, IPropertyInternal* property);
 
     /** @brief Resets all state. */
     void clear();
@@ -71,12 +88,13 @@ public:
     IAny::Ptr clone() const override;
 
     /** @brief Ticks this proxy's driver with its own interpolator/inner/owner. */
-    bool tick(Duration dt, Duration duration, easing::EasingFn easing);
+    bool tick(Duration dt, Duration duration, easing::EasingFn easing, const ReclaimScope& scope);
 
     IAny* inner_ptr() { return inner_.get(); }
 
     TransitionDriver driver;
     IInterface::WeakPtr owner_;
+    IPropertyInternal* property_ = nullptr; ///< owner_, cast once; valid while owner_ can be peeked.
     InterpolatorFn interpolator_ = nullptr;
     IInterface::Ptr parent_; ///< Strong ref to TransitionImpl when persistent (creates intentional cycle).
     std::atomic<bool>* active_flag_ = nullptr; ///< Points into TransitionImpl::active_; set on driver start.
@@ -1,8 +1,11 @@
 #include "array_property.h"
 
 #include <velk/api/velk.h>
+#include <velk/ext/any.h>
 #include <velk/interface/types.h>
 
+#include <algorithm>
+
 namespace velk {
 
 // IProperty
@@ -15,17 +18,19 @@ ReturnValue ArrayPropertyImpl::set_value(const IAny& from, InvokeType type)
     if (!data_) {
         return ReturnValue::Fail;
     }
-    if (type == Deferred) {
-        auto clone = data_->clone();
-        if (clone && clone->copy_from(from) == ReturnValue::Success) {
-            instance().queue_deferred_property({get_self<IPropertyInternal>(), std::move(clone)});
+    discard_pending();
+    if (invoke_mode(type) != Immediate) {
+        auto clone = instance().acquire_deferred_value(*data_);
+        if (clone && succeeded(clone->copy_from(from))) {
+            instance().queue_deferred_property({get_self<IPropertyInternal>(), std::move(clone), true});
             return ReturnValue::Success;
         }
         return ReturnValue::Fail;
     }
     auto ret = data_->copy_from(from);
     if (ret == ReturnValue::Success) {
-        invoke_event(on_changed(), data_.get());
+        record_reset();
+        notify_changed();
     }
     return ret;
 }
@@ -35,6 +40,11 @@ const IAny::ConstPtr ArrayPropertyImpl::get_value() const
     return data_;
 }
 
+borrowed_ptr<const IAny> ArrayPropertyImpl::borrow_value() const
+{
+    return data_;
+}
+
 // IPropertyInternal
 
 bool ArrayPropertyImpl::set_any(const IAny::Ptr& value, IAny::Ptr* previous)
@@ -48,7 +58,9 @@ bool ArrayPropertyImpl::set_any(const IAny::Ptr& value, IAny::Ptr* previous)
         }
     }
     data_ = value;
-    return succeeded(invoke_event(on_changed(), data_.get()));
+    record_reset();
+    fire_changed();
+    return true;
 }
 
 IAny::ConstPtr ArrayPropertyImpl::get_any() const
@@ -64,21 +76,29 @@ ReturnValue ArrayPropertyImpl::set_data(const void* data, size_t size, Uid type,
     if (!data_) {
         return ReturnValue::Fail;
     }
-    if (invokeType == Deferred) {
-        auto clone = data_->clone();
-        if (clone && clone->set_data(data, size, type) == ReturnValue::Success) {
-            instance().queue_deferred_property({get_self<IPropertyInternal>(), std::move(clone)});
+    discard_pending();
+    if (invoke_mode(invokeType) != Immediate) {
+        auto clone = instance().acquire_deferred_value(*data_);
+        if (clone && succeeded(clone->set_data(data, size, type))) {
+            instance().queue_deferred_property({get_self<IPropertyInternal>(), std::move(clone), true});
             return ReturnValue::Success;
         }
         return ReturnValue::Fail;
     }
     auto ret = data_->set_data(data, size, type);
     if (ret == ReturnValue::Success) {
-        invoke_event(on_changed(), data_.get());
+        record_reset();
+        notify_changed();
     }
     return ret;
 }
 
+ReturnValue ArrayPropertyImpl::set_trivial_data(const void* data, size_t size, Uid type,
+                                                InvokeType invokeType)
+{
+    return set_data(data, size, type, invokeType);
+}
+
 ReturnValue ArrayPropertyImpl::set_value_silent(const IAny& from)
 {
     if (get_object_data().flags & ObjectFlags::ReadOnly) {
@@ -87,7 +107,120 @@ ReturnValue ArrayPropertyImpl::set_value_silent(const IAny& from)
     if (!data_) {
         return ReturnValue::Fail;
     }
-    return data_->copy_from(from);
+    auto ret = data_->copy_from(from);
+    if (ret == ReturnValue::Success) {
+        record_reset();
+    }
+    return ret;
+}
+
+ReturnValue ArrayPropertyImpl::apply_trivial_data(const void*, size_t, Uid)
+{
+    // set_trivial_data() never queues inline data for an array.
+    return ReturnValue::Refused;
+}
+
+void ArrayPropertyImpl::freeze()
+{
+    // Like deferred writes of a PropertyImpl, logged operations are rejected once frozen.
+    discard_pending();
+    detail::BlockAccess::set_flags(*this, get_object_data().flags | ObjectFlags::ReadOnly);
+    onChanged_ = {};
+    dirty_ = {};
+    stale_ = {};
+    changes_.clear();
+}
+
+ReturnValue ArrayPropertyImpl::notify_changed()
+{
+    apply_pending();
+    dirty_.mark();
+    for (auto* stale : stale_) {
+        *stale = true;
+    }
+    fire_changed();
+    return ReturnValue::Success;
+}
+
+void ArrayPropertyImpl::record(const ArrayChange& change)
+{
+    if (!changes_.empty()) {
+        auto& last = changes_.back();
+        if (last.kind == ArrayChangeKind::Reset) {
+            // Listeners re-read the whole array anyway.
+            last.count = array_size();
+            return;
+        }
+        if (change.kind == last.kind) {
+            switch (change.kind) {
+            case ArrayChangeKind::Inserted:
+                if (change.index >= last.index && change.index <= last.index + last.count) {
+                    last.count += change.count;
+                    return;
+                }
+                break;
+            case ArrayChangeKind::Removed:
+                if (change.index == last.index) {
+                    last.count += change.count;
+                    return;
+                }
+                if (change.index + change.count == last.index) {
+                    last.index = change.index;
+                    last.count += change.count;
+                    return;
+                }
+                break;
+            case ArrayChangeKind::Updated:
+                if (change.index <= last.index + last.count && last.index <= change.index + change.count) {
+                    size_t end = std::max(last.index + last.count, change.index + change.count);
+                    last.index = std::min(last.index, change.index);
+                    last.count = end - last.index;
+                    return;
+                }
+                break;
+            default:
+                break;
+            }
+        } else if (change.kind == ArrayChangeKind::Updated && last.kind == ArrayChangeKind::Inserted &&
+                   change.index >= last.index && change.index + change.count <= last.index + last.count) {
+            // Writes to elements inserted since the last notification are part of the insertion.
+            return;
+        }
+    }
+    if (changes_.size() >= MAX_CHANGES) {
+        record_reset();
+        return;
+    }
+    changes_.push_back(change);
+}
+
+void ArrayPropertyImpl::record_reset()
+{
+    changes_.clear();
+    changes_.push_back({ArrayChangeKind::Reset, 0, array_size()});
+}
+
+void ArrayPropertyImpl::fire_changed()
+{
+    if (changes_.empty()) {
+        // Notified without a recorded change, e.g. after a write to the State struct.
+        record_reset();
+    }
+    auto& event = onChanged_.get_if_created();
+    if (!event) {
+        changes_.clear();
+        return;
+    }
+    // Handlers may modify the array again, which records into the emptied member.
+    vector<ArrayChange> changes;
+    changes.swap(changes_);
+    ext::AnyArg<vector<ArrayChange>> arg(changes);
+    const IAny* args[] = {data_.get(), &arg};
+    invoke_event(event, FnArgs{args, 2});
+    if (changes_.empty()) {
+        changes.clear();
+        changes_.swap(changes);
+    }
 }
 
 bool ArrayPropertyImpl::install_extension(const IAnyExtension::Ptr& extension)
@@ -138,19 +271,7 @@ IArrayAny* ArrayPropertyImpl::get_array_any() const
     return data_ ? interface_cast<IArrayAny>(data_) : nullptr;
 }
 
-size_t ArrayPropertyImpl::array_size() const
-{
-    auto* aa = get_array_any();
-    return aa ? aa->array_size() : 0;
-}
-
-ReturnValue ArrayPropertyImpl::get_at(size_t index, IAny& out) const
-{
-    auto* aa = get_array_any();
-    return aa ? aa->get_at(index, out) : ReturnValue::Fail;
-}
-
-ReturnValue ArrayPropertyImpl::set_at(size_t index, const IAny& value)
+ReturnValue ArrayPropertyImpl::modify(InvokeType type, PendingOp op)
 {
     if (get_object_data().flags & ObjectFlags::ReadOnly) {
         return ReturnValue::ReadOnly;
@@ -159,56 +280,165 @@ ReturnValue ArrayPropertyImpl::set_at(size_t index, const IAny& value)
     if (!aa) {
         return ReturnValue::Fail;
     }
-    auto ret = aa->set_at(index, value);
-    if (succeeded(ret)) {
-        invoke_event(on_changed(), data_.get());
+    if (invoke_mode(type) != Immediate) {
+        // Copy only what the operation writes; the array itself is not touched until update().
+        if (op.value) {
+            op.owned = op.value->clone();
+            op.value = op.owned.get();
+        } else if (op.data) {
+            op.owned = aa->create_array(op.data, op.count, op.elementType);
+            op.data = op.owned ? interface_cast<IArrayAny>(op.owned)->array_data(op.elementType) : nullptr;
+        }
+        if ((op.value || op.data) && !op.owned) {
+            return ReturnValue::InvalidArgument;
+        }
+        {
+            std::lock_guard lock(pendingMutex_);
+            pending_.push_back(std::move(op));
+            hasPending_.store(true, std::memory_order_release);
+        }
+        // A notification-only set: update() replays the log and fires on_changed once.
+        instance().queue_deferred_property({get_self<IPropertyInternal>()});
+        return ReturnValue::Success;
+    }
+    apply_pending();
+    ArrayChange change;
+    auto ret = apply(*aa, op, change);
+    if (ret == ReturnValue::Success) {
+        record(change);
+        notify_changed();
     }
     return ret;
 }
 
-ReturnValue ArrayPropertyImpl::push_back(const IAny& value)
+ReturnValue ArrayPropertyImpl::apply(IArrayAny& aa, const PendingOp& op, ArrayChange& change)
 {
-    if (get_object_data().flags & ObjectFlags::ReadOnly) {
-        return ReturnValue::ReadOnly;
-    }
-    auto* aa = get_array_any();
-    if (!aa) {
-        return ReturnValue::Fail;
-    }
-    auto ret = aa->push_back(value);
-    if (succeeded(ret)) {
-        invoke_event(on_changed(), data_.get());
+    size_t size = aa.array_size();
+    switch (op.kind) {
+    case OpKind::SetAt:
+        change = {ArrayChangeKind::Updated, op.index, 1};
+        return aa.set_at(op.index, *op.value);
+    case OpKind::PushBack:
+        change = {ArrayChangeKind::Inserted, size, 1};
+        return aa.push_back(*op.value);
+    case OpKind::EraseAt:
+        change = {ArrayChangeKind::Removed, op.index, 1};
+        return aa.erase_at(op.index);
+    case OpKind::Clear:
+        change = {ArrayChangeKind::Removed, 0, size};
+        if (size == 0) {
+            return ReturnValue::NothingToDo;
+        }
+        aa.clear_array();
+        return ReturnValue::Success;
+    case OpKind::SetRange:
+        change = {ArrayChangeKind::Updated, op.index, op.count};
+        return aa.set_range(op.index, op.data, op.count, op.elementType);
+    case OpKind::InsertRange:
+        change = {ArrayChangeKind::Inserted, op.index, op.count};
+        return aa.insert_range(op.index, op.data, op.count, op.elementType);
+    case OpKind::EraseRange:
+        change = {ArrayChangeKind::Removed, op.index, op.count};
+        return aa.erase_range(op.index, op.count);
+    case OpKind::Resize:
+        change = op.count > size ? ArrayChange{ArrayChangeKind::Inserted, size, op.count - size}
+                                 : ArrayChange{ArrayChangeKind::Removed, op.count, size - op.count};
+        return aa.resize_array(op.count);
     }
-    return ret;
+    return ReturnValue::Fail;
 }
 
-ReturnValue ArrayPropertyImpl::erase_at(size_t index)
+void ArrayPropertyImpl::apply_pending()
 {
-    if (get_object_data().flags & ObjectFlags::ReadOnly) {
-        return ReturnValue::ReadOnly;
+    if (!hasPending_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::vector<PendingOp> ops;
+    {
+        std::lock_guard lock(pendingMutex_);
+        ops.swap(pending_);
+        hasPending_.store(false, std::memory_order_relaxed);
     }
     auto* aa = get_array_any();
     if (!aa) {
-        return ReturnValue::Fail;
+        return;
     }
-    auto ret = aa->erase_at(index);
-    if (succeeded(ret)) {
-        invoke_event(on_changed(), data_.get());
+    for (auto& op : ops) {
+        ArrayChange change;
+        if (apply(*aa, op, change) == ReturnValue::Success) {
+            record(change);
+        }
     }
-    return ret;
 }
 
-void ArrayPropertyImpl::clear_array()
+void ArrayPropertyImpl::discard_pending()
 {
-    if (get_object_data().flags & ObjectFlags::ReadOnly) {
+    if (!hasPending_.load(std::memory_order_acquire)) {
         return;
     }
+    std::lock_guard lock(pendingMutex_);
+    pending_.clear();
+    hasPending_.store(false, std::memory_order_relaxed);
+}
+
+size_t ArrayPropertyImpl::array_size() const
+{
     auto* aa = get_array_any();
-    if (!aa) {
-        return;
-    }
-    aa->clear_array();
-    invoke_event(on_changed(), data_.get());
+    return aa ? aa->array_size() : 0;
+}
+
+ReturnValue ArrayPropertyImpl::get_at(size_t index, IAny& out) const
+{
+    auto* aa = get_array_any();
+    return aa ? aa->get_at(index, out) : ReturnValue::Fail;
+}
+
+ReturnValue ArrayPropertyImpl::set_at(size_t index, const IAny& value, InvokeType type)
+{
+    return modify(type, {OpKind::SetAt, index, 1, &value});
+}
+
+ReturnValue ArrayPropertyImpl::push_back(const IAny& value, InvokeType type)
+{
+    return modify(type, {OpKind::PushBack, 0, 1, &value});
+}
+
+ReturnValue ArrayPropertyImpl::erase_at(size_t index, InvokeType type)
+{
+    return modify(type, {OpKind::EraseAt, index, 1});
+}
+
+void ArrayPropertyImpl::clear_array(InvokeType type)
+{
+    modify(type, {OpKind::Clear});
+}
+
+ReturnValue ArrayPropertyImpl::set_range(size_t index, const void* data, size_t count, Uid elementType,
+                                         InvokeType type)
+{
+    return modify(type, {OpKind::SetRange, index, count, nullptr, data, elementType});
+}
+
+ReturnValue ArrayPropertyImpl::insert_range(size_t index, const void* data, size_t count, Uid elementType,
+                                            InvokeType type)
+{
+    return modify(type, {OpKind::InsertRange, index, count, nullptr, data, elementType});
+}
+
+ReturnValue ArrayPropertyImpl::erase_range(size_t index, size_t count, InvokeType type)
+{
+    return modify(type, {OpKind::EraseRange, index, count});
+}
+
+ReturnValue ArrayPropertyImpl::resize_array(size_t count, InvokeType type)
+{
+    return modify(type, {OpKind::Resize, 0, count});
+}
+
+const void* ArrayPropertyImpl::array_data(Uid elementType) const
+{
+    auto* aa = get_array_any();
+    return aa ? aa->array_data(elementType) : nullptr;
 }
 
 } // namespace velk
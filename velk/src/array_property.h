@@ -1,6 +1,8 @@
 #ifndef ARRAY_PROPERTY_H
 #define ARRAY_PROPERTY_H
 
+#include "hive/dirty_bit.h"
+
 #include <velk/common.h>
 #include <velk/ext/core_object.h>
 #include <velk/ext/event.h>
@@ -9,6 +11,11 @@
 #include <velk/interface/intf_array_property.h>
 #include <velk/interface/intf_property.h>
 #include <velk/interface/types.h>
+#include <velk/vector.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 namespace velk {
 
@@ -18,6 +25,10 @@ namespace velk {
  * Nearly identical to PropertyImpl but also implements IArrayProperty by
  * delegating element-level operations to IArrayAny on its backing data_.
  * The data_ is expected to be an ArrayAnyRef<T> (which implements IArrayAny).
+ *
+ * Deferred element operations are recorded in an operation log that notify_changed() replays
+ * in update(), so deferring a write to one element does not copy the whole array. Only the
+ * written element or range is copied.
  */
 class ArrayPropertyImpl final : public ext::ObjectCore<ArrayPropertyImpl, IPropertyInternal, IArrayProperty>
 {
@@ -26,32 +37,103 @@ public:
 
     ArrayPropertyImpl() = default;
 
+    /** @brief Sets the hive dirty bit that notify_changed() marks. */
+    void set_dirty_bit(const DirtyBit& bit) { dirty_ = bit; }
+    /** @brief Sets the stale flags of the COMPUTED members that notify_changed() invalidates. */
+    void set_stale_flags(std::vector<bool*> flags) { stale_ = std::move(flags); }
+    /** @brief Makes the property read-only and drops its change notification (see IObjectStorage::freeze()). */
+    void freeze();
+
 protected: // IProperty
     ReturnValue set_value(const IAny& from, InvokeType type = Immediate) override;
     const IAny::ConstPtr get_value() const override;
+    borrowed_ptr<const IAny> borrow_value() const override;
+    const void* get_state_data(Uid) const override { return nullptr; }
     IEvent::Ptr on_changed() const override { return onChanged_; }
 
 protected: // IPropertyInternal
     bool set_any(const IAny::Ptr& value, IAny::Ptr* previous = nullptr) override;
     IAny::ConstPtr get_any() const override;
     ReturnValue set_data(const void* data, size_t size, Uid type, InvokeType invokeType = Immediate) override;
+    ReturnValue set_trivial_data(const void* data, size_t size, Uid type,
+                                 InvokeType invokeType = Immediate) override;
     ReturnValue set_value_silent(const IAny& from) override;
+    ReturnValue apply_trivial_data(const void* data, size_t size, Uid type) override;
+    ReturnValue notify_changed() override;
     bool install_extension(const IAnyExtension::Ptr& extension) override;
     bool remove_extension(const IAnyExtension::Ptr& extension) override;
 
 protected: // IArrayProperty
     size_t array_size() const override;
     ReturnValue get_at(size_t index, IAny& out) const override;
-    ReturnValue set_at(size_t index, const IAny& value) override;
-    ReturnValue push_back(const IAny& value) override;
-    ReturnValue erase_at(size_t index) override;
-    void clear_array() override;
+    ReturnValue set_at(size_t index, const IAny& value, InvokeType type = Immediate) override;
+    ReturnValue push_back(const IAny& value, InvokeType type = Immediate) override;
+    ReturnValue erase_at(size_t index, InvokeType type = Immediate) override;
+    void clear_array(InvokeType type = Immediate) override;
+    ReturnValue set_range(size_t index, const void* data, size_t count, Uid elementType,
+                          InvokeType type = Immediate) override;
+    ReturnValue insert_range(size_t index, const void* data, size_t count, Uid elementType,
+                             InvokeType type = Immediate) override;
+    ReturnValue erase_range(size_t index, size_t count, InvokeType type = Immediate) override;
+    ReturnValue resize_array(size_t count, InvokeType type = Immediate) override;
+    const void* array_data(Uid elementType) const override;
 
 private:
+    /** @brief A list of changes longer than this collapses into a Reset. */
+    static constexpr size_t MAX_CHANGES = 64;
+
+    enum class OpKind : uint8_t
+    {
+        SetAt,
+        PushBack,
+        EraseAt,
+        Clear,
+        SetRange,
+        InsertRange,
+        EraseRange,
+        Resize
+    };
+
+    /** @brief An element operation, applied now or logged for the next update(). */
+    struct PendingOp
+    {
+        OpKind kind;
+        size_t index{};
+        size_t count{};
+        const IAny* value{};  ///< Element of SetAt and PushBack.
+        const void* data{};   ///< Elements of SetRange and InsertRange.
+        Uid elementType{};
+        IAny::Ptr owned;      ///< Copy of value or data owned by a logged operation.
+    };
+
     IArrayAny* get_array_any() const;
+    /**
+     * @brief Applies @p op now, or copies its argument into the operation log if @p type is deferred.
+     *
+     * An immediate operation first replays the logged ones, so operations apply in call order.
+     */
+    ReturnValue modify(InvokeType type, PendingOp op);
+    /** @brief Applies @p op to @p aa and describes the change in @p change. */
+    static ReturnValue apply(IArrayAny& aa, const PendingOp& op, ArrayChange& change);
+    /** @brief Applies the logged operations and records their changes. Failing ones are skipped. */
+    void apply_pending();
+    /** @brief Drops the logged operations, which a write of the whole value supersedes. */
+    void discard_pending();
+    /** @brief Appends @p change to the changes since the last notification, merging where possible. */
+    void record(const ArrayChange& change);
+    /** @brief Records a Reset: the whole value was replaced. */
+    void record_reset();
+    /** @brief Invokes on_changed with the value and the recorded changes, then clears them. */
+    void fire_changed();
 
     IAny::Ptr data_;
     ext::LazyEvent onChanged_;
+    DirtyBit dirty_;
+    std::vector<bool*> stale_;   ///< Stale flags of the COMPUTED members derived from this property.
+    vector<ArrayChange> changes_; ///< Changes since the last on_changed.
+    std::mutex pendingMutex_;
+    std::vector<PendingOp> pending_; ///< Deferred operations, in call order.
+    std::atomic<bool> hasPending_{}; ///< Lets immediate operations skip pendingMutex_ when the log is empty.
 };
 
 } // namespace velk
@@ -0,0 +1,360 @@
+#include "binding_registry.h"
+
+#include <velk/interface/intf_velk.h>
+#include <velk/trace.h>
+
+#include <algorithm>
+#include <functional>
+
+namespace velk {
+
+BindingRegistry::BindingRegistry(IVelk& velk) : velk_(velk) {}
+
+BindingRegistry::~BindingRegistry()
+{
+    clear();
+}
+
+void BindingRegistry::clear()
+{
+    std::vector<Removed> removed;
+    {
+        std::lock_guard lock(mutex_);
+        removed.reserve(bindings_.size());
+        for (auto& [id, binding] : bindings_) {
+            removed.push_back({std::move(binding.handler), std::move(binding.sources)});
+        }
+        bindings_.clear();
+        targets_.clear();
+        readers_.clear();
+        dirty_.clear();
+    }
+    for (auto& r : removed) {
+        unsubscribe(r);
+    }
+}
+
+IAny::Ptr BindingRegistry::on_source_changed(void* context, FnArgs)
+{
+    auto* ctx = static_cast<HandlerContext*>(context);
+    ctx->registry->mark_dirty(ctx->id);
+    return nullptr;
+}
+
+void BindingRegistry::mark_dirty(uint64_t id)
+{
+    std::lock_guard lock(mutex_);
+    auto it = bindings_.find(id);
+    if (it != bindings_.end() && !it->second.dirty) {
+        it->second.dirty = true;
+        push_dirty({it->second.rank, id});
+    }
+}
+
+void BindingRegistry::push_dirty(DirtyEntry entry)
+{
+    dirty_.push_back(entry);
+    std::push_heap(dirty_.begin(), dirty_.end(), std::greater<>{});
+}
+
+bool BindingRegistry::expired(const Binding& binding)
+{
+    if (binding.target.expired()) {
+        return true;
+    }
+    for (auto& source : binding.sources) {
+        if (source.expired()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+BindingRegistry::Binding* BindingRegistry::find_target(const IProperty* key)
+{
+    auto it = targets_.find(key);
+    if (it == targets_.end()) {
+        return nullptr;
+    }
+    auto& binding = bindings_.at(it->second);
+    if (expired(binding)) {
+        auto removed = remove(it->second);
+        unsubscribe(removed);
+        return nullptr;
+    }
+    return &binding;
+}
+
+void BindingRegistry::remove_expired()
+{
+    std::vector<uint64_t> ids;
+    for (auto& [id, binding] : bindings_) {
+        if (expired(binding)) {
+            ids.push_back(id);
+        }
+    }
+    for (auto id : ids) {
+        auto removed = remove(id);
+        unsubscribe(removed);
+    }
+}
+
+bool BindingRegistry::reaches(const IProperty* target, array_view<IProperty::ConstPtr> sources)
+{
+    std::vector<const IProperty*> stack;
+    for (auto& source : sources) {
+        stack.push_back(source.get());
+    }
+    std::vector<const IProperty*> visited;
+    while (!stack.empty()) {
+        auto* key = stack.back();
+        stack.pop_back();
+        if (key == target) {
+            return true;
+        }
+        if (std::find(visited.begin(), visited.end(), key) != visited.end()) {
+            continue;
+        }
+        visited.push_back(key);
+        if (auto* binding = find_target(key)) {
+            stack.insert(stack.end(), binding->sourceKeys.begin(), binding->sourceKeys.end());
+        }
+    }
+    return false;
+}
+
+void BindingRegistry::raise_ranks(const IProperty* key, uint32_t rank)
+{
+    auto it = readers_.find(key);
+    if (it == readers_.end()) {
+        return;
+    }
+    for (auto id : it->second) {
+        auto& binding = bindings_.at(id);
+        if (binding.rank <= rank) {
+            binding.rank = rank + 1;
+            if (binding.dirty) {
+                // The entry queued with the old rank is skipped when popped.
+                push_dirty({binding.rank, id});
+            }
+            raise_ranks(binding.targetKey, binding.rank);
+        }
+    }
+}
+
+BindingRegistry::Removed BindingRegistry::remove(uint64_t id)
+{
+    auto it = bindings_.find(id);
+    auto& binding = it->second;
+    targets_.erase(binding.targetKey);
+    for (auto* key : binding.sourceKeys) {
+        auto reader = readers_.find(key);
+        auto& ids = reader->second;
+        ids.erase(std::find(ids.begin(), ids.end(), id));
+        if (ids.empty()) {
+            readers_.erase(reader);
+        }
+    }
+    Removed removed{std::move(binding.handler), std::move(binding.sources)};
+    bindings_.erase(it);
+    return removed;
+}
+
+void BindingRegistry::unsubscribe(Removed& removed)
+{
+    for (auto& weak : removed.sources) {
+        if (auto source = weak.lock()) {
+            source->on_changed()->remove_handler(removed.handler);
+        }
+    }
+}
+
+bool BindingRegistry::take_job(const Binding& binding, Job& job)
+{
+    job.target = binding.target.lock();
+    if (!job.target) {
+        return false;
+    }
+    job.sources.clear();
+    for (auto& weak : binding.sources) {
+        auto source = weak.lock();
+        if (!source) {
+            return false;
+        }
+        job.sources.push_back(std::move(source));
+    }
+    job.transform = binding.transform;
+    return true;
+}
+
+void BindingRegistry::apply(const Job& job)
+{
+    if (!job.transform) {
+        if (auto value = job.sources.front()->borrow_value()) {
+            job.target->set_value(*value);
+        }
+        return;
+    }
+    // The job holds the sources, which keep their values alive.
+    std::vector<const IAny*> args;
+    args.reserve(job.sources.size());
+    for (auto& source : job.sources) {
+        args.push_back(source->borrow_value().get());
+    }
+    if (auto result = job.transform->invoke({args.data(), args.size()})) {
+        job.target->set_value(*result);
+    }
+}
+
+ReturnValue BindingRegistry::bind(const IProperty::Ptr& target, array_view<IProperty::ConstPtr> sources,
+                                  const IFunction::ConstPtr& transform)
+{
+    if (!target || sources.empty() || (!transform && sources.size() != 1)) {
+        return ReturnValue::InvalidArgument;
+    }
+    for (auto& source : sources) {
+        if (!source) {
+            return ReturnValue::InvalidArgument;
+        }
+    }
+
+    Binding binding;
+    binding.target = target;
+    binding.targetKey = target.get();
+    binding.transform = transform;
+    for (auto& source : sources) {
+        binding.sources.push_back(source);
+        if (std::find(binding.sourceKeys.begin(), binding.sourceKeys.end(), source.get()) ==
+            binding.sourceKeys.end()) {
+            binding.sourceKeys.push_back(source.get());
+        }
+    }
+
+    Removed replaced;
+    uint64_t id;
+    {
+        std::lock_guard lock(mutex_);
+        if (reaches(target.get(), sources)) {
+            return ReturnValue::InvalidArgument;
+        }
+        // A binding is only removed on expiry when its sources change or a lookup finds it, so
+        // sweep now and then to bound the bindings of properties that were destroyed unchanged.
+        if (bindings_.size() >= sweepAt_) {
+            remove_expired();
+            sweepAt_ = std::max<size_t>(64, bindings_.size() * 2);
+        }
+        if (find_target(target.get())) {
+            replaced = remove(targets_.at(target.get()));
+        }
+        id = ++nextId_;
+        for (auto* key : binding.sourceKeys) {
+            if (auto* upstream = find_target(key)) {
+                binding.rank = std::max(binding.rank, upstream->rank + 1);
+            }
+            readers_[key].push_back(id);
+        }
+        binding.handler =
+            velk_.create_owned_callback(new HandlerContext{this, id}, &BindingRegistry::on_source_changed,
+                                        [](void* context) { delete static_cast<HandlerContext*>(context); });
+        targets_[target.get()] = id;
+        raise_ranks(target.get(), binding.rank);
+        bindings_.emplace(id, binding);
+    }
+    unsubscribe(replaced);
+
+    for (auto* key : binding.sourceKeys) {
+        for (auto& source : sources) {
+            if (source.get() == key) {
+                source->on_changed()->add_handler(binding.handler);
+                break;
+            }
+        }
+    }
+    Job job;
+    take_job(binding, job);
+    apply(job);
+    return ReturnValue::Success;
+}
+
+ReturnValue BindingRegistry::unbind(const IProperty::ConstPtr& target)
+{
+    Removed removed;
+    {
+        std::lock_guard lock(mutex_);
+        if (!find_target(target.get())) {
+            return ReturnValue::NothingToDo;
+        }
+        removed = remove(targets_.at(target.get()));
+    }
+    unsubscribe(removed);
+    return ReturnValue::Success;
+}
+
+bool BindingRegistry::is_bound(const IProperty::ConstPtr& target) const
+{
+    std::lock_guard lock(mutex_);
+    auto it = targets_.find(target.get());
+    return it != targets_.end() && !expired(bindings_.at(it->second));
+}
+
+size_t BindingRegistry::get_binding_count() const
+{
+    std::lock_guard lock(mutex_);
+    size_t count = 0;
+    for (auto& [id, binding] : bindings_) {
+        count += !expired(binding);
+    }
+    return count;
+}
+
+size_t BindingRegistry::evaluate()
+{
+    VELK_TRACE_ZONE("BindingRegistry::evaluate");
+    std::vector<DirtyEntry> later;
+    std::vector<Removed> expired;
+    Job job;
+    size_t count = 0;
+    std::unique_lock lock(mutex_);
+    if (dirty_.empty()) {
+        return 0;
+    }
+    uint64_t pass = ++pass_;
+    while (!dirty_.empty()) {
+        std::pop_heap(dirty_.begin(), dirty_.end(), std::greater<>{});
+        auto [rank, id] = dirty_.back();
+        dirty_.pop_back();
+        auto it = bindings_.find(id);
+        if (it == bindings_.end() || !it->second.dirty || it->second.rank != rank) {
+            continue;
+        }
+        auto& binding = it->second;
+        if (binding.pass == pass) {
+            // Changed again by this pass; evaluating it twice could loop through handlers.
+            later.push_back({rank, id});
+            continue;
+        }
+        binding.dirty = false;
+        binding.pass = pass;
+        if (!take_job(binding, job)) {
+            expired.push_back(remove(id));
+            continue;
+        }
+        // The target's on_changed marks downstream bindings, which have a higher rank.
+        lock.unlock();
+        apply(job);
+        job.target = {};
+        job.sources.clear();
+        ++count;
+        lock.lock();
+    }
+    for (auto& entry : later) {
+        push_dirty(entry);
+    }
+    lock.unlock();
+    for (auto& r : expired) {
+        unsubscribe(r);
+    }
+    return count;
+}
+
+} // namespace velk
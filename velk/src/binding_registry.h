@@ -0,0 +1,130 @@
+#ifndef VELK_BINDING_REGISTRY_H
+#define VELK_BINDING_REGISTRY_H
+
+#include <velk/ext/interface_dispatch.h>
+#include <velk/interface/intf_binding_registry.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace velk {
+
+class IVelk;
+
+/**
+ * @brief Concrete implementation of IBindingRegistry.
+ *
+ * Each binding subscribes an immediate handler to the on_changed event of its sources that
+ * queues the binding in a heap ordered by rank. A binding's rank is one more than the highest
+ * rank of the bindings targeting its sources, so popping the heap yields a topological order.
+ * Ranks only grow; one left high after an unbind still orders the graph correctly.
+ *
+ * Sources may change on any thread. bind(), unbind() and evaluate() are meant for the thread
+ * calling update(). Owned as a stack member by VelkInstance.
+ */
+class BindingRegistry final : public ext::InterfaceDispatch<IBindingRegistry>
+{
+public:
+    explicit BindingRegistry(IVelk& velk);
+    ~BindingRegistry();
+
+    // IBindingRegistry overrides
+    ReturnValue bind(const IProperty::Ptr& target, array_view<IProperty::ConstPtr> sources,
+                     const IFunction::ConstPtr& transform) override;
+    ReturnValue unbind(const IProperty::ConstPtr& target) override;
+    bool is_bound(const IProperty::ConstPtr& target) const override;
+    size_t get_binding_count() const override;
+    size_t evaluate() override;
+
+    /** @brief Removes all bindings. */
+    void clear();
+
+private:
+    struct Binding
+    {
+        IProperty::WeakPtr target;
+        const IProperty* targetKey{};
+        std::vector<IProperty::ConstWeakPtr> sources;
+        std::vector<const IProperty*> sourceKeys; ///< Unique keys of @c sources.
+        IFunction::ConstPtr transform;
+        IFunction::Ptr handler; ///< Subscribed to on_changed of each source.
+        uint32_t rank{};
+        bool dirty{};
+        uint64_t pass{}; ///< Last evaluate() pass that evaluated the binding.
+    };
+
+    /** @brief Strong references to what evaluating a binding needs, taken under the lock. */
+    struct Job
+    {
+        IProperty::Ptr target;
+        std::vector<IProperty::ConstPtr> sources;
+        IFunction::ConstPtr transform;
+    };
+
+    /** @brief A removed binding whose handler still has to be unsubscribed from its sources. */
+    struct Removed
+    {
+        IFunction::Ptr handler;
+        std::vector<IProperty::ConstWeakPtr> sources;
+    };
+
+    /** @brief Context of a binding's on_changed handler. */
+    struct HandlerContext
+    {
+        BindingRegistry* registry;
+        uint64_t id;
+    };
+
+    /** @brief Heap entry: a dirty binding and its rank when queued. */
+    using DirtyEntry = std::pair<uint32_t, uint64_t>;
+
+    static IAny::Ptr on_source_changed(void* context, FnArgs);
+    /** @brief Queues binding @p id for the next evaluate(). */
+    void mark_dirty(uint64_t id);
+    /** @brief Pushes @p entry to the dirty heap. Requires mutex_. */
+    void push_dirty(DirtyEntry entry);
+    /**
+     * @brief Returns the binding targeting @p key, or null. Requires mutex_.
+     *
+     * Removes the binding instead if its target or a source expired, since @p key may then
+     * be the address of a new property.
+     */
+    Binding* find_target(const IProperty* key);
+    /** @brief Removes the bindings whose target or a source expired. Requires mutex_. */
+    void remove_expired();
+    /** @brief Returns true if the target or a source of @p binding expired. */
+    static bool expired(const Binding& binding);
+    /** @brief Returns true if @p target is reachable upstream from @p sources. Requires mutex_. */
+    bool reaches(const IProperty* target, array_view<IProperty::ConstPtr> sources);
+    /** @brief Raises the ranks downstream of @p key above @p rank. Requires mutex_. */
+    void raise_ranks(const IProperty* key, uint32_t rank);
+    /** @brief Erases binding @p id and returns what to unsubscribe. Requires mutex_. */
+    Removed remove(uint64_t id);
+    /**
+     * @brief Unsubscribes the handler of @p removed.
+     *
+     * Events invoke handlers without holding the lock remove_handler() takes, so this may be
+     * called with mutex_ held.
+     */
+    static void unsubscribe(Removed& removed);
+    /** @brief Takes strong references for evaluating @p binding. Returns false if one expired. */
+    static bool take_job(const Binding& binding, Job& job);
+    /** @brief Sets the target of @p job to its bound value. */
+    static void apply(const Job& job);
+
+    IVelk& velk_;
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, Binding> bindings_;
+    std::unordered_map<const IProperty*, uint64_t> targets_;               ///< Binding of each target.
+    std::unordered_map<const IProperty*, std::vector<uint64_t>> readers_; ///< Bindings of each source.
+    std::vector<DirtyEntry> dirty_; ///< Min-heap of dirty bindings by rank, then creation order.
+    size_t sweepAt_{64}; ///< Binding count at which bind() next removes expired bindings.
+    uint64_t nextId_{};
+    uint64_t pass_{};
+};
+
+} // namespace velk
+
+#endif // VELK_BINDING_REGISTRY_H
@@ -1,12 +1,168 @@
 #include "event.h"
 
+#include "event_batch.h"
+
+#include <velk/allocator.h>
 #include <velk/api/velk.h>
+#include <velk/trace.h>
+
+#include <memory>
+#include <new>
+#include <thread>
 
 namespace velk {
 
+// Event readers
+//
+// Epoch-based: each thread that invokes an event claims a reader record. An invocation
+// publishes the global reader epoch in the record of its thread when it starts the outermost
+// read, with an exchange that orders the publication before its load of the handler list.
+// A writer replaces the list and then advances the epoch, stamping the old list with the new
+// value. Readers that start from then on load the new list, so the old one is freed once no
+// record holds an earlier epoch. Dispatch thus writes only the record of its own thread, and
+// the shared cache lines of the event are read but never written.
+//
+// The records are a constant-initialized array, so that a scan reads adjacent cache lines.
+// The record pointer uses initial-exec TLS where available: reaching it through
+// __tls_get_addr() from the shared library costs as much as the rest of a dispatch.
+
+namespace {
+
+/** @brief Reader state of one thread. */
+struct alignas(64) event_reader
+{
+    std::atomic<uint64_t> epoch{0};  ///< Epoch of the outermost read, 0 outside reads.
+    std::atomic<bool> in_use{false}; ///< Claimed by a thread.
+    uint32_t depth{0};               ///< Nesting depth of the reads, e.g. of a handler firing an event.
+};
+
+/** @brief Number of threads that may hold a record at the same time. */
+constexpr uint32_t max_event_readers = 1024;
+
+std::atomic<uint64_t> g_reader_epoch{1};
+event_reader g_event_readers[max_event_readers];
+/// One past the highest record ever claimed; the scans stop there.
+std::atomic<uint32_t> g_event_reader_end{0};
+
+#if defined(__GNUC__) && !defined(_WIN32)
+#define VELK_READER_TLS __attribute__((tls_model("initial-exec"))) thread_local
+#else
+#define VELK_READER_TLS thread_local
+#endif
+
+// Trivially destructible, so they remain usable after the exit guard of the thread ran.
+VELK_READER_TLS event_reader* t_reader = nullptr;
+VELK_READER_TLS bool t_reader_exited = false;
+
+/** @brief Returns the oldest epoch of the reads running on any thread, or UINT64_MAX if none is. */
+uint64_t oldest_reader_epoch()
+{
+    uint64_t oldest = UINT64_MAX;
+    uint32_t end = g_event_reader_end.load();
+    for (uint32_t i = 0; i < end; ++i) {
+        uint64_t epoch = g_event_readers[i].epoch.load();
+        if (epoch && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    return oldest;
+}
+
+struct event_reader_exit
+{
+    ~event_reader_exit()
+    {
+        if (auto* self = t_reader) {
+            t_reader = nullptr;
+            self->in_use.store(false, std::memory_order_release);
+        }
+        t_reader_exited = true;
+    }
+};
+
+/** @brief Claims a free record for the calling thread. */
+event_reader* claim_event_reader()
+{
+    for (;;) {
+        for (uint32_t i = 0; i < max_event_readers; ++i) {
+            auto& record = g_event_readers[i];
+            bool free = false;
+            if (!record.in_use.load(std::memory_order_relaxed) &&
+                record.in_use.compare_exchange_strong(free, true, std::memory_order_acquire)) {
+                // Published before the thread can read a list, so the scans include the record.
+                uint32_t end = g_event_reader_end.load(std::memory_order_relaxed);
+                while (end <= i && !g_event_reader_end.compare_exchange_weak(end, i + 1)) {
+                }
+                t_reader = &record;
+                // Reads after the exit guard of the thread ran, e.g. from other thread_local
+                // destructors, claim a record that is handed back when the read ends.
+                if (!t_reader_exited) {
+                    thread_local event_reader_exit guard;
+                    (void)guard;
+                }
+                return &record;
+            }
+        }
+        // Every record is held; one frees up when its thread exits.
+        std::this_thread::yield();
+    }
+}
+
+} // anonymous namespace
+
 EventImpl::~EventImpl()
 {
     release_owned_context();
+    // No invocation can be running once the event is destroyed.
+    destroy_list(handlers_.load(std::memory_order_relaxed));
+    while (retired_) {
+        HandlerList* next = retired_->next_retired;
+        destroy_list(retired_);
+        retired_ = next;
+    }
+}
+
+EventImpl::HandlerList* EventImpl::HandlerList::construct(void* mem, uint32_t count)
+{
+    static_assert(sizeof(HandlerList) % alignof(IFunction::ConstPtr) == 0,
+                  "Handlers must be aligned after the HandlerList header");
+    auto* list = new (mem) HandlerList;
+    list->count = count;
+    for (uint32_t i = 0; i < count; ++i) {
+        new (list->handlers() + i) IFunction::ConstPtr;
+    }
+    return list;
+}
+
+void EventImpl::HandlerList::destruct(HandlerList* list)
+{
+    for (uint32_t i = 0; i < list->count; ++i) {
+        std::destroy_at(list->handlers() + i);
+    }
+    list->~HandlerList();
+}
+
+EventImpl::HandlerList* EventImpl::create_list(uint32_t count) const
+{
+    if (count <= INLINE_HANDLERS && !inline_used_) {
+        inline_used_ = true;
+        return HandlerList::construct(inline_storage_, count);
+    }
+    size_t size = sizeof(HandlerList) + count * sizeof(IFunction::ConstPtr);
+    return HandlerList::construct(detail::velk_alloc(size, alignof(HandlerList), MemoryTag::General), count);
+}
+
+void EventImpl::destroy_list(HandlerList* list) const
+{
+    if (!list) {
+        return;
+    }
+    HandlerList::destruct(list);
+    if (list == inline_list()) {
+        inline_used_ = false;
+    } else {
+        detail::velk_free(list, alignof(HandlerList), MemoryTag::General);
+    }
 }
 
 void EventImpl::release_owned_context()
@@ -25,11 +181,8 @@ IAny::Ptr EventImpl::callback_trampoline(void* ctx, FnArgs args)
 
 IAny::Ptr EventImpl::invoke(FnArgs args, InvokeType type) const
 {
-    if (type == Deferred) {
-        DeferredTask task;
-        task.fn = get_self<IFunction>();
-        task.args = ::velk::make_shared<DeferredArgs>(args);
-        instance().queue_deferred_tasks(array_view(&task, 1));
+    if (invoke_mode(type) != Immediate) {
+        instance().queue_deferred_call(get_self<IFunction>(), args, type);
         return nullptr;
     }
 
@@ -41,37 +194,121 @@ IAny::Ptr EventImpl::invoke(FnArgs args, InvokeType type) const
     return result;
 }
 
-array_view<IFunction::ConstPtr> EventImpl::immediate_handlers() const
+ReturnValue EventImpl::invoke_into(FnArgs args, IAny& result) const
+{
+    ReturnValue ret = ReturnValue::NothingToDo;
+    if (target_fn_) {
+        if (auto value = target_fn_(target_context_, args)) {
+            ret = result.copy_from(*value);
+        }
+    }
+    invoke_handlers(args);
+    return ret;
+}
+
+inline EventImpl::HandlerList* EventImpl::begin_read() const
 {
-    return {handlers_.data(), deferred_begin_};
+    auto* self = t_reader;
+    if (!self) {
+        self = claim_event_reader();
+    }
+    if (self->depth++ == 0) {
+        // The exchange orders the epoch before the load of the list, where a store would not.
+        self->epoch.exchange(g_reader_epoch.load());
+    }
+    return handlers_.load();
 }
 
-array_view<IFunction::ConstPtr> EventImpl::deferred_handlers() const
+inline void EventImpl::end_read() const
 {
-    return {handlers_.data() + deferred_begin_, handlers_.size() - deferred_begin_};
+    auto* self = t_reader;
+    if (--self->depth == 0) {
+        self->epoch.store(0, std::memory_order_release);
+        if (t_reader_exited) {
+            t_reader = nullptr;
+            self->in_use.store(false, std::memory_order_release);
+        }
+    }
+    // Frees the lists retired while this read held them back, unless a writer is busy and will.
+    if (has_retired_.load(std::memory_order_relaxed) && write_mutex_.try_lock()) {
+        reclaim_retired();
+        write_mutex_.unlock();
+    }
 }
 
 void EventImpl::invoke_handlers(FnArgs args) const
 {
-    // Ignoring all return values as different handlers might return different results
-    for (const auto& h : immediate_handlers()) {
-        h->invoke(args);
-    }
-    auto deferred = deferred_handlers();
-    if (deferred.empty()) {
+    // Most events have no handlers; skip the reader registration for them.
+    if (!handlers_.load(std::memory_order_relaxed)) {
         return;
     }
-    // Clone args once, share ownership across all deferred tasks
-    auto clonedArgs = ::velk::make_shared<DeferredArgs>(args);
+    VELK_TRACE_ZONE("EventImpl::invoke");
+    HandlerList* list = begin_read();
+    if (list) {
+        // Ignoring all return values as different handlers might return different results
+        for (const auto& h : list->partition(ImmediateHandlers)) {
+            h->invoke(args);
+        }
+        // One queued record fans out to every deferred handler at update() time.
+        if (!list->partition(DeferredHandlers, DeferredBatchHandlers).empty()) {
+            instance().queue_deferred_handlers(get_self<IEvent>(), args, Deferred);
+        }
+        if (!list->partition(CoalescedHandlers, CoalescedBatchHandlers).empty()) {
+            instance().queue_deferred_handlers(get_self<IEvent>(), args, DeferredCoalesced);
+        }
+    }
+    end_read();
+}
+
+size_t EventImpl::invoke_deferred_handlers(FnArgs args, InvokeType type, EventBatches& batches) const
+{
+    VELK_TRACE_ZONE("EventImpl::invoke_deferred_handlers");
+    HandlerList* list = begin_read();
+    size_t count = 0;
+    if (list) {
+        bool coalesced = type == DeferredCoalesced;
+        auto handlers = list->partition(coalesced ? CoalescedHandlers : DeferredHandlers);
+        for (const auto& h : handlers) {
+            h->invoke(args);
+        }
+        count = handlers.size();
+        for (const auto& h : list->partition(coalesced ? CoalescedBatchHandlers : DeferredBatchHandlers)) {
+            batches.add(h, this, args);
+        }
+    }
+    end_read();
+    return count;
+}
 
-    std::vector<DeferredTask> tasks;
-    tasks.reserve(deferred.size());
-    for (const auto& h : deferred) {
-        tasks.push_back({h, clonedArgs});
+void EventImpl::publish(HandlerList* list) const
+{
+    HandlerList* old = handlers_.exchange(list);
+    if (old) {
+        // Reads that start from now on announce this epoch or a later one and load the new list.
+        old->retired_epoch = g_reader_epoch.fetch_add(1) + 1;
+        old->next_retired = retired_;
+        retired_ = old;
+        has_retired_.store(true, std::memory_order_relaxed);
     }
+    reclaim_retired();
+}
 
-    // Queue N tasks to instance for exececution at next instance().update().
-    instance().queue_deferred_tasks(array_view(tasks.data(), tasks.size()));
+void EventImpl::reclaim_retired() const
+{
+    if (!retired_) {
+        return;
+    }
+    uint64_t oldest = oldest_reader_epoch();
+    HandlerList** link = &retired_;
+    while (HandlerList* list = *link) {
+        if (list->retired_epoch <= oldest) {
+            *link = list->next_retired;
+            destroy_list(list);
+        } else {
+            link = &list->next_retired;
+        }
+    }
+    has_retired_.store(retired_ != nullptr, std::memory_order_relaxed);
 }
 
 void EventImpl::set_invoke_callback(IFunction::CallableFn* fn)
@@ -81,7 +318,8 @@ void EventImpl::set_invoke_callback(IFunction::CallableFn* fn)
     target_fn_ = fn ? &callback_trampoline : nullptr;
 }
 
-void EventImpl::bind(void* context, IFunction::BoundFn* fn)
+void EventImpl::bind(void* context, IFunction::BoundFn* fn, IFunction::TypedFn* /*typed*/,
+                     IFunction::ResultFn* /*into*/)
 {
     release_owned_context();
     target_context_ = context;
@@ -102,28 +340,56 @@ ReturnValue EventImpl::add_handler(const IFunction::ConstPtr& fn, InvokeType typ
     if (!fn) {
         return ReturnValue::InvalidArgument;
     }
-    for (const auto& h : handlers_) {
-        if (h == fn) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    HandlerList* current = handlers_.load(std::memory_order_relaxed);
+    uint32_t count = current ? current->count : 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (current->handlers()[i] == fn) {
             return ReturnValue::NothingToDo;
         }
     }
-    if (type == Immediate) {
-        handlers_.insert(handlers_.begin() + deferred_begin_, fn);
-        ++deferred_begin_;
-    } else {
-        handlers_.push_back(fn);
+    Partition part = ImmediateHandlers;
+    if (invoke_mode(type) != Immediate) {
+        bool batch = interface_cast<IEventBatchHandler>(fn) != nullptr;
+        if (invoke_mode(type) == DeferredCoalesced) {
+            part = batch ? CoalescedBatchHandlers : CoalescedHandlers;
+        } else {
+            part = batch ? DeferredBatchHandlers : DeferredHandlers;
+        }
+    }
+    // The handler goes at the end of its partition.
+    uint32_t pos = part + 1 < PartitionCount ? (current ? current->begin[part + 1] : 0) : count;
+    HandlerList* list = create_list(count + 1);
+    for (uint32_t i = 0; i < count; ++i) {
+        list->handlers()[i < pos ? i : i + 1] = current->handlers()[i];
+    }
+    list->handlers()[pos] = fn;
+    for (uint32_t p = 0; p < PartitionCount; ++p) {
+        uint32_t begin = current ? current->begin[p] : 0;
+        list->begin[p] = begin + (p > part ? 1 : 0);
     }
+    publish(list);
     return ReturnValue::Success;
 }
 
 ReturnValue EventImpl::remove_handler(const IFunction::ConstPtr& fn) const
 {
-    for (size_t i = 0; i < handlers_.size(); ++i) {
-        if (handlers_[i] == fn) {
-            if (i < deferred_begin_) {
-                --deferred_begin_;
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    HandlerList* current = handlers_.load(std::memory_order_relaxed);
+    uint32_t count = current ? current->count : 0;
+    for (uint32_t pos = 0; pos < count; ++pos) {
+        if (current->handlers()[pos] == fn) {
+            HandlerList* list = nullptr;
+            if (count > 1) {
+                list = create_list(count - 1);
+                for (uint32_t i = 0; i < count - 1; ++i) {
+                    list->handlers()[i] = current->handlers()[i < pos ? i : i + 1];
+                }
+                for (uint32_t p = 0; p < PartitionCount; ++p) {
+                    list->begin[p] = current->begin[p] - (pos < current->begin[p] ? 1 : 0);
+                }
             }
-            handlers_.erase(handlers_.begin() + i);
+            publish(list);
             return ReturnValue::Success;
         }
     }
@@ -132,7 +398,7 @@ ReturnValue EventImpl::remove_handler(const IFunction::ConstPtr& fn) const
 
 bool EventImpl::has_handlers() const
 {
-    return !handlers_.empty();
+    return handlers_.load(std::memory_order_acquire) != nullptr;
 }
 
 } // namespace velk
@@ -5,6 +5,8 @@
 
 #include <velk/interface/types.h>
 
+#include <atomic>
+#include <mutex>
 #include <vector>
 
 namespace velk {
@@ -12,9 +14,22 @@ namespace velk {
 /**
  * @brief Default IEvent implementation with handler management.
  *
- * Extends the invoke machinery of FunctionImpl with a partitioned handler
- * list: [0, deferred_begin_) for immediate handlers, [deferred_begin_, size())
- * for deferred handlers.
+ * Extends the invoke machinery of FunctionImpl with a handler list that is
+ * partitioned by dispatch kind: immediate handlers, then deferred and coalesced
+ * deferred handlers, each followed by those of its kind that implement
+ * IEventBatchHandler.
+ *
+ * The list is copy-on-write. add_handler() and remove_handler() build a new
+ * HandlerList under write_mutex_ and publish it atomically, so invocation never
+ * locks and always iterates an immutable list, even when a handler subscribes or
+ * unsubscribes during dispatch. Replaced lists are retired and freed once no
+ * invocation that may be reading them is left: an invocation announces itself in a
+ * reader record of its own thread, so dispatch touches no cache line shared with
+ * other threads (see event.cpp).
+ *
+ * Lists of up to INLINE_HANDLERS handlers are built in storage inside the event
+ * whenever that storage is not in use, so most events never allocate a list and
+ * dispatch reads the handlers from the event's own cache lines.
  */
 class EventImpl final : public ext::ObjectCore<EventImpl, IFunctionInternal>
 {
@@ -26,12 +41,21 @@ public:
 
 public: // IFunction
     IAny::Ptr invoke(FnArgs args, InvokeType type = Immediate) const override;
+    /** @brief Always fails: invoking an event must also dispatch its handlers. */
+    bool invoke_typed(IFunction::TypedFn*, const void* const*, void*) const override { return false; }
+    ReturnValue invoke_into(FnArgs args, IAny& result) const override;
 
 public: // IFunctionInternal
     void set_invoke_callback(IFunction::CallableFn* fn) override;
-    void bind(void* context, IFunction::BoundFn* fn) override;
+    void bind(void* context, IFunction::BoundFn* fn, IFunction::TypedFn* typed = nullptr,
+              IFunction::ResultFn* into = nullptr) override;
     void set_owned_callback(void* context, IFunction::BoundFn* fn,
                             IFunction::ContextDeleter* deleter) override;
+    size_t invoke_deferred_handlers(FnArgs args, InvokeType type, EventBatches& batches) const override;
+    bool set_queued_once(bool queued) const override
+    {
+        return queued_once_.exchange(queued, std::memory_order_acq_rel);
+    }
 
 public: // IEvent
     ReturnValue add_handler(const IFunction::ConstPtr& fn, InvokeType type = Immediate) const override;
@@ -39,10 +63,60 @@ public: // IEvent
     bool has_handlers() const override;
 
 private:
+    /** @brief Handler partitions, in list order. */
+    enum Partition : uint32_t
+    {
+        ImmediateHandlers,
+        DeferredHandlers,
+        DeferredBatchHandlers,
+        CoalescedHandlers,
+        CoalescedBatchHandlers,
+        PartitionCount
+    };
+
+    /** @brief Immutable handler list; the handlers follow the struct in the same allocation. */
+    struct HandlerList
+    {
+        uint32_t count{};
+        uint32_t begin[PartitionCount]{}; ///< Index of the first handler of each partition.
+        HandlerList* next_retired{};      ///< Next list in EventImpl::retired_.
+        uint64_t retired_epoch{};         ///< Reader epoch from which no invocation can see the list.
+
+        IFunction::ConstPtr* handlers() { return reinterpret_cast<IFunction::ConstPtr*>(this + 1); }
+        /** @brief Returns the handlers of partitions [first, last]. */
+        array_view<IFunction::ConstPtr> partition(Partition first, Partition last)
+        {
+            uint32_t end = last + 1 < PartitionCount ? begin[last + 1] : count;
+            return {handlers() + begin[first], end - begin[first]};
+        }
+        array_view<IFunction::ConstPtr> partition(Partition p) { return partition(p, p); }
+
+        /** @brief Constructs a list of @p count empty handlers in @p mem. */
+        static HandlerList* construct(void* mem, uint32_t count);
+        /** @brief Destroys the list and its handlers without freeing its memory. */
+        static void destruct(HandlerList* list);
+    };
+
+    /** @brief Number of handlers that fit the inline list. */
+    static constexpr uint32_t INLINE_HANDLERS = 2;
+
+    /** @brief Creates a list of @p count empty handlers, inline if possible. Requires write_mutex_. */
+    HandlerList* create_list(uint32_t count) const;
+    /** @brief Destroys @p list and releases its memory. Requires write_mutex_. */
+    void destroy_list(HandlerList* list) const;
+    HandlerList* inline_list() const { return reinterpret_cast<HandlerList*>(inline_storage_); }
+
     static IAny::Ptr callback_trampoline(void* ctx, FnArgs args);
     void invoke_handlers(FnArgs args) const;
-    array_view<IFunction::ConstPtr> immediate_handlers() const;
-    array_view<IFunction::ConstPtr> deferred_handlers() const;
+
+    /** @brief Publishes @p list and retires the current one. Requires write_mutex_. */
+    void publish(HandlerList* list) const;
+    /** @brief Frees the retired lists no invocation can still be reading. Requires write_mutex_. */
+    void reclaim_retired() const;
+    /** @brief Starts a read of the handler list, which stays valid until end_read(). */
+    HandlerList* begin_read() const;
+    /** @brief Ends a read started by begin_read(), reclaiming the retired lists it no longer holds back. */
+    void end_read() const;
 
     void release_owned_context();
 
@@ -50,9 +124,15 @@ private:
     IFunction::BoundFn* target_fn_{};
     void* owned_context_{};
     IFunction::ContextDeleter* context_deleter_{};
-    /// Partitioned handler list: [0, deferred_begin_) = immediate, [deferred_begin_, size()) = deferred.
-    mutable std::vector<IFunction::ConstPtr> handlers_;
-    mutable uint32_t deferred_begin_{};
+    mutable std::atomic<HandlerList*> handlers_{}; ///< Current list, null when there are no handlers.
+    mutable std::atomic<bool> has_retired_{};      ///< True if retired_ is not empty.
+    mutable HandlerList* retired_{};               ///< Replaced lists that readers may still use.
+    mutable std::mutex write_mutex_;               ///< Serializes handler list changes.
+    mutable bool inline_used_{};                   ///< True if the inline list is current or retired.
+    mutable std::atomic<bool> queued_once_{};      ///< True while a DeferredOnce invocation is queued.
+    /// Storage for a list of up to INLINE_HANDLERS handlers, so small lists need no allocation.
+    alignas(HandlerList) mutable unsigned char
+        inline_storage_[sizeof(HandlerList) + INLINE_HANDLERS * sizeof(IFunction::ConstPtr)];
 };
 
 } // namespace velk
@@ -0,0 +1,71 @@
+#ifndef VELK_SRC_EVENT_BATCH_H
+#define VELK_SRC_EVENT_BATCH_H
+
+#include <velk/interface/intf_event.h>
+
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief Collects the invocations of IEventBatchHandler handlers during one update().
+ *
+ * Events add an entry per invocation and batch handler while update() runs the deferred
+ * queue; dispatch() then calls each handler once with its entries, in the order the
+ * handlers were first seen. The entries reference args that must outlive dispatch().
+ * Not thread-safe.
+ */
+class EventBatches
+{
+public:
+    /** @brief Adds an invocation of @p source with @p args for batch handler @p fn. */
+    void add(const IFunction::ConstPtr& fn, const IEvent* source, FnArgs args)
+    {
+        // Consecutive entries mostly go to the same handler.
+        if (last_ >= batches_.size() || batches_[last_].fn != fn) {
+            last_ = find(fn);
+        }
+        batches_[last_].entries.push_back({source, args});
+    }
+
+    /** @brief Calls every handler with its batch and clears the batches. Returns the calls made. */
+    size_t dispatch()
+    {
+        size_t calls = 0;
+        for (auto& batch : batches_) {
+            if (batch.handler) {
+                batch.handler->handle_batch({batch.entries.data(), batch.entries.size()});
+                ++calls;
+            }
+        }
+        batches_.clear();
+        last_ = 0;
+        return calls;
+    }
+
+private:
+    struct Batch
+    {
+        IFunction::ConstPtr fn;
+        const IEventBatchHandler* handler;
+        std::vector<EventBatchEntry> entries;
+    };
+
+    size_t find(const IFunction::ConstPtr& fn)
+    {
+        for (size_t i = 0; i < batches_.size(); ++i) {
+            if (batches_[i].fn == fn) {
+                return i;
+            }
+        }
+        batches_.push_back({fn, interface_cast<IEventBatchHandler>(fn), {}});
+        return batches_.size() - 1;
+    }
+
+    std::vector<Batch> batches_;
+    size_t last_{};
+};
+
+} // namespace velk
+
+#endif // VELK_SRC_EVENT_BATCH_H
@@ -0,0 +1,169 @@
+#ifndef VELK_SRC_FACTORY_TABLE_H
+#define VELK_SRC_FACTORY_TABLE_H
+
+#include <velk/interface/intf_object_factory.h>
+#include <velk/uid.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief Hash map from class UID to factory, readable without locking while it changes.
+ *
+ * Open-addressed with linear probing over a power-of-two array of entry pointers, at most half
+ * full. Entries are only ever added: removing a factory clears it in its entry, which a later
+ * set() of the UID reuses. Growing publishes a new array and keeps the replaced ones until the
+ * table is destroyed, so that a reader can finish probing one; as each array doubles the
+ * previous one, they take at most as much memory again as the current array.
+ *
+ * find() is safe on any thread at any time and costs one acquire load per probed slot. The
+ * other functions must be serialized by the caller.
+ */
+class FactoryTable
+{
+public:
+    /** @brief Returns the factory of @p uid, or null. */
+    const IObjectFactory* find(Uid uid) const
+    {
+        auto* entry = find_entry(uid);
+        return entry ? entry->factory.load(std::memory_order_acquire) : nullptr;
+    }
+
+    /**
+     * @brief Returns the factory slot of @p uid, which lives as long as the table, or null if
+     *        @p uid has no factory.
+     */
+    const std::atomic<const IObjectFactory*>* find_slot(Uid uid) const
+    {
+        auto* entry = find_entry(uid);
+        return entry && entry->factory.load(std::memory_order_acquire) ? &entry->factory : nullptr;
+    }
+
+    /**
+     * @brief Sets the factory of @p uid, registered by @p owner, or removes it if null.
+     * @return false if @p factory is null and @p uid has no factory.
+     */
+    bool set(Uid uid, const IObjectFactory* factory, Uid owner)
+    {
+        if (auto* entry = find_entry(uid)) {
+            bool had = entry->factory.load(std::memory_order_relaxed);
+            entry->owner = owner;
+            entry->factory.store(factory, std::memory_order_release);
+            return factory || had;
+        }
+        if (!factory) {
+            return false;
+        }
+        auto* array = reserve(1);
+        entries_.push_back(std::make_unique<Entry>(uid, factory, owner));
+        array->slots[probe(*array, uid)].store(entries_.back().get(), std::memory_order_release);
+        return true;
+    }
+
+    /** @brief Makes room for @p count more entries, growing the array at most once. */
+    void reserve_entries(size_t count)
+    {
+        reserve(count);
+        entries_.reserve(entries_.size() + count);
+    }
+
+    /** @brief Removes all factories registered by @p owner. */
+    void remove_owner(Uid owner)
+    {
+        for (auto& entry : entries_) {
+            if (entry->owner == owner) {
+                entry->factory.store(nullptr, std::memory_order_release);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t MIN_CAPACITY = 64;
+
+    struct Entry
+    {
+        Entry(Uid u, const IObjectFactory* f, Uid o) : uid(u), factory(f), owner(o) {}
+        const Uid uid;
+        std::atomic<const IObjectFactory*> factory; ///< Null once removed.
+        Uid owner;                                  ///< Read and written by writers only.
+    };
+
+    struct Array
+    {
+        size_t mask;
+        unsigned shift; ///< 64 - log2(mask + 1).
+        std::unique_ptr<std::atomic<Entry*>[]> slots;
+    };
+
+    static size_t slot(Uid uid, unsigned shift)
+    {
+        // Fibonacci hashing: the top bits of the product mix all bits of both halves.
+        uint64_t hash = (uid.hi * 0x9E3779B97F4A7C15ull ^ uid.lo) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(hash >> shift);
+    }
+
+    // Returns the slot of array holding uid, or the empty slot where it belongs.
+    static size_t probe(const Array& array, Uid uid)
+    {
+        size_t i = slot(uid, array.shift);
+        for (Entry* entry; (entry = array.slots[i].load(std::memory_order_relaxed)) && entry->uid != uid;) {
+            i = (i + 1) & array.mask;
+        }
+        return i;
+    }
+
+    Entry* find_entry(Uid uid) const
+    {
+        auto* array = array_.load(std::memory_order_acquire);
+        if (!array) {
+            return nullptr;
+        }
+        for (size_t i = slot(uid, array->shift);; i = (i + 1) & array->mask) {
+            auto* entry = array->slots[i].load(std::memory_order_acquire);
+            if (!entry || entry->uid == uid) {
+                return entry;
+            }
+        }
+    }
+
+    // Returns the current array, grown first if count more entries would fill it over half.
+    Array* reserve(size_t count)
+    {
+        auto* array = array_.load(std::memory_order_relaxed);
+        size_t capacity = array ? array->mask + 1 : MIN_CAPACITY;
+        while ((entries_.size() + count) * 2 > capacity) {
+            capacity *= 2;
+        }
+        return array && capacity == array->mask + 1 ? array : grow(capacity);
+    }
+
+    Array* grow(size_t capacity)
+    {
+        auto array = std::make_unique<Array>();
+        array->mask = capacity - 1;
+        array->shift = 64;
+        for (size_t c = capacity; c > 1; c >>= 1) {
+            --array->shift;
+        }
+        array->slots = std::make_unique<std::atomic<Entry*>[]>(capacity);
+        for (auto& entry : entries_) {
+            array->slots[probe(*array, entry->uid)].store(entry.get(), std::memory_order_relaxed);
+        }
+        array_.store(array.get(), std::memory_order_release);
+        arrays_.push_back(std::move(array));
+        return arrays_.back().get();
+    }
+
+    std::atomic<Array*> array_{};               ///< Current array, read by find().
+    std::vector<std::unique_ptr<Array>> arrays_; ///< Current and replaced arrays.
+    std::vector<std::unique_ptr<Entry>> entries_;
+};
+
+} // namespace velk
+
+#endif // VELK_SRC_FACTORY_TABLE_H
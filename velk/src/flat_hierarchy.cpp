@@ -0,0 +1,815 @@
+#include "flat_hierarchy.h"
+
+#include <velk/ext/any.h>
+
+#include <atomic>
+
+namespace velk {
+
+// Looks up a named event (on_changing / on_changed) and invokes it with the change
+// descriptor wrapped as a single IAny argument. Skips work if no handlers are registered.
+// Inside a batch, the change is recorded instead.
+void FlatHierarchyImpl::fire_event(string_view name, HierarchyChange change)
+{
+    auto evt = get_event(name, Resolve::Existing);
+    if (evt && evt->has_handlers()) {
+        if (change.type != HierarchyChange::Type::Batch && deferred_.defer(name, change)) {
+            return;
+        }
+        change.hierarchy = get_self<IHierarchy>();
+        auto any = ext::create_any_ref(&change);
+        const IAny* arg = any.get();
+        FnArgs args{&arg, 1};
+        evt->invoke(args);
+    }
+}
+
+FlatHierarchyImpl::~FlatHierarchyImpl()
+{
+    if (!inherited_.empty()) {
+        for (auto& node : nodes_) {
+            inherited_.left(node.object);
+        }
+    }
+    size_t before = index_.size();
+    index_.clear();
+    track_entries(before);
+}
+
+void FlatHierarchyImpl::track_entries(size_t before) const
+{
+    // Counts each node with its side table entry and the link the map keeps with it.
+    constexpr auto node_size =
+        static_cast<ptrdiff_t>(sizeof(Node) + sizeof(decltype(index_)::value_type) + sizeof(void*));
+    auto delta = static_cast<ptrdiff_t>(index_.size()) - static_cast<ptrdiff_t>(before);
+    if (delta) {
+        detail::track_memory(MemoryCategory::HierarchyEntries, delta * node_size, delta);
+    }
+}
+
+uint32_t FlatHierarchyImpl::find(const IObject* obj) const
+{
+    auto it = index_.find(obj);
+    return it != index_.end() ? it->second : NONE;
+}
+
+// Walks forward from the first child or backward from the last, whichever is nearer.
+uint32_t FlatHierarchyImpl::nth_child(uint32_t parent, size_t index) const
+{
+    auto& p = nodes_[parent];
+    if (index >= p.child_count) {
+        return NONE;
+    }
+    uint32_t i;
+    if (index < p.child_count / 2) {
+        for (i = p.first_child; index; --index) {
+            i = nodes_[i].next_sibling;
+        }
+    } else {
+        for (i = p.last_child, index = p.child_count - 1 - index; index; --index) {
+            i = nodes_[i].prev_sibling;
+        }
+    }
+    return i;
+}
+
+// Descends to the first child, else moves to the next sibling of the nearest ancestor below top.
+uint32_t FlatHierarchyImpl::next_in_subtree(uint32_t node, uint32_t top) const
+{
+    if (nodes_[node].first_child != NONE) {
+        return nodes_[node].first_child;
+    }
+    while (node != top) {
+        if (nodes_[node].next_sibling != NONE) {
+            return nodes_[node].next_sibling;
+        }
+        node = nodes_[node].parent;
+    }
+    return NONE;
+}
+
+uint32_t FlatHierarchyImpl::create_node(const IObject::Ptr& object, uint32_t parent, uint32_t before)
+{
+    uint32_t i = free_;
+    if (i != NONE) {
+        free_ = nodes_[i].next_free;
+        nodes_[i] = {};
+    } else {
+        i = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+    auto& node = nodes_[i];
+    node.object = object;
+    node.parent = parent;
+    snapshots_.touch(object.get());
+    if (parent == NONE) {
+        return i;
+    }
+    auto& p = nodes_[parent];
+    snapshots_.touch(p.object.get());
+    node.depth = p.depth + 1;
+    node.next_sibling = before;
+    node.prev_sibling = before != NONE ? nodes_[before].prev_sibling : p.last_child;
+    (node.prev_sibling != NONE ? nodes_[node.prev_sibling].next_sibling : p.first_child) = i;
+    (before != NONE ? nodes_[before].prev_sibling : p.last_child) = i;
+    ++p.child_count;
+    return i;
+}
+
+void FlatHierarchyImpl::unlink(uint32_t node)
+{
+    auto& n = nodes_[node];
+    auto& p = nodes_[n.parent];
+    snapshots_.touch(p.object.get());
+    (n.prev_sibling != NONE ? nodes_[n.prev_sibling].next_sibling : p.first_child) = n.next_sibling;
+    (n.next_sibling != NONE ? nodes_[n.next_sibling].prev_sibling : p.last_child) = n.prev_sibling;
+    --p.child_count;
+}
+
+// Pre-order walk that frees each node as it is visited. Freeing only touches the object and
+// next_free, so the links the walk follows stay intact.
+void FlatHierarchyImpl::release_subtree(uint32_t node, std::vector<IObject::Ptr>& removed)
+{
+    for (uint32_t i = node; i != NONE; i = next_in_subtree(i, node)) {
+        auto& n = nodes_[i];
+        index_.erase(n.object.get());
+        snapshots_.touch(n.object.get());
+        removed.push_back(std::move(n.object));
+        n.next_free = free_;
+        free_ = i;
+    }
+}
+
+// Moves every live object to removed in array order and empties the node array.
+void FlatHierarchyImpl::release_all(std::vector<IObject::Ptr>& removed)
+{
+    removed.reserve(index_.size());
+    for (auto& n : nodes_) {
+        if (n.object) {
+            removed.push_back(std::move(n.object));
+        }
+    }
+    nodes_.clear();
+    free_ = NONE;
+    index_.clear();
+    order_.reset();
+    snapshots_.touch_all();
+}
+
+// Walks the tree once, closing the subtree of each pending node when the walk reaches a node
+// that is not deeper than it.
+std::shared_ptr<FlatHierarchyImpl::DepthFirstOrder> FlatHierarchyImpl::build_order() const
+{
+    auto order = std::make_shared<DepthFirstOrder>();
+    auto& listed = order->nodes;
+    listed.reserve(index_.size());
+    order->sizes.resize(index_.size());
+    order->positions.assign(nodes_.size(), NONE);
+    small_vector<uint32_t, 32> pending;
+    for (uint32_t i = index_.empty() ? NONE : 0; i != NONE; i = next_in_subtree(i, 0)) {
+        auto k = static_cast<uint32_t>(listed.size());
+        auto depth = nodes_[i].depth;
+        for (; !pending.empty() && listed[pending.back()].depth >= depth; pending.pop_back()) {
+            order->sizes[pending.back()] = k - pending.back();
+        }
+        order->positions[i] = k;
+        listed.push_back({nodes_[i].object, depth});
+        pending.push_back(k);
+    }
+    for (; !pending.empty(); pending.pop_back()) {
+        order->sizes[pending.back()] = static_cast<uint32_t>(listed.size()) - pending.back();
+    }
+    order->live = listed.size();
+    return order;
+}
+
+FlatHierarchyImpl::DepthFirstOrder* FlatHierarchyImpl::unique_order()
+{
+    if (order_ && order_.use_count() == 1) {
+        // Pairs with the release of the last traversal's reference.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return order_.get();
+    }
+    order_.reset();
+    return nullptr;
+}
+
+IObject::Ptr FlatHierarchyImpl::parent_object(uint32_t node) const
+{
+    auto parent = nodes_[node].parent;
+    return parent != NONE ? nodes_[parent].object : IObject::Ptr{};
+}
+
+// Clears any existing tree, sets the new root. Veto via IHierarchyAware::on_hierarchy_joining.
+// Removed nodes get on_hierarchy_left; new root gets on_hierarchy_joined.
+ReturnValue FlatHierarchyImpl::set_root(const IObject::Ptr& root)
+{
+    if (!root) {
+        return ReturnValue::InvalidArgument;
+    }
+
+    auto self = get_self<IHierarchy>();
+
+    if (auto* listener = interface_cast<IHierarchyAware>(root)) {
+        if (!listener->on_hierarchy_joining(self, {})) {
+            return ReturnValue::Refused;
+        }
+    }
+
+    fire_event("on_changing", {HierarchyChange::Type::SetRoot, {}, {}, root});
+
+    std::vector<IObject::Ptr> removed;
+    {
+        std::lock_guard lock(mutex_);
+        size_t before = index_.size();
+        release_all(removed);
+        index_.emplace(root.get(), create_node(root, NONE, NONE));
+        track_entries(before);
+    }
+
+    notify_left(removed);
+    inherited_.left(removed);
+
+    if (auto* listener = interface_cast<IHierarchyAware>(root)) {
+        listener->on_hierarchy_joined(self, {});
+    }
+
+    inherited_.joined({}, root);
+
+    fire_event("on_changed", {HierarchyChange::Type::SetRoot, {}, {}, root});
+    return ReturnValue::Success;
+}
+
+// Links child as the last child of parent. Rejects if parent is not in the tree
+// or child is already present. Veto via IHierarchyAware::on_hierarchy_joining.
+ReturnValue FlatHierarchyImpl::add(const IObject::Ptr& parent, const IObject::Ptr& child)
+{
+    if (!parent || !child) {
+        return ReturnValue::InvalidArgument;
+    }
+
+    auto self = get_self<IHierarchy>();
+
+    if (auto* listener = interface_cast<IHierarchyAware>(child)) {
+        if (!listener->on_hierarchy_joining(self, parent)) {
+            return ReturnValue::Refused;
+        }
+    }
+
+    fire_event("on_changing", {HierarchyChange::Type::Add, {}, parent, child});
+
+    {
+        std::lock_guard lock(mutex_);
+        auto p = find(parent.get());
+        if (p == NONE || find(child.get()) != NONE) {
+            return ReturnValue::InvalidArgument;
+        }
+        index_.emplace(child.get(), create_node(child, p, NONE));
+        order_.reset();
+        track_entries(index_.size() - 1);
+    }
+
+    if (auto* listener = interface_cast<IHierarchyAware>(child)) {
+        listener->on_hierarchy_joined(self, parent);
+    }
+
+    inherited_.joined(parent, child);
+
+    fire_event("on_changed", {HierarchyChange::Type::Add, {}, parent, child});
+    return ReturnValue::Success;
+}
+
+// Links child before parent's index-th child. Same validation and veto logic as add(),
+// but also rejects out-of-range indices.
+ReturnValue FlatHierarchyImpl::insert(const IObject::Ptr& parent, size_t index, const IObject::Ptr& child)
+{
+    if (!parent || !child) {
+        return ReturnValue::InvalidArgument;
+    }
+
+    auto self = get_self<IHierarchy>();
+
+    if (auto* listener = interface_cast<IHierarchyAware>(child)) {
+        if (!listener->on_hierarchy_joining(self, parent)) {
+            return ReturnValue::Refused;
+        }
+    }
+
+    fire_event("on_changing", {HierarchyChange::Type::Insert, {}, parent, child, {}, index});
+
+    {
+        std::lock_guard lock(mutex_);
+        auto p = find(parent.get());
+        if (p == NONE || find(child.get()) != NONE || index > nodes_[p].child_count) {
+            return ReturnValue::InvalidArgument;
+        }
+        index_.emplace(child.get(), create_node(child, p, nth_child(p, index)));
+        order_.reset();
+        track_entries(index_.size() - 1);
+    }
+
+    if (auto* listener = interface_cast<IHierarchyAware>(child)) {
+        listener->on_hierarchy_joined(self, parent);
+    }
+
+    inherited_.joined(parent, child);
+
+    fire_event("on_changed", {HierarchyChange::Type::Insert, {}, parent, child, {}, index});
+    return ReturnValue::Success;
+}
+
+ReturnValue FlatHierarchyImpl::add_children(const IObject::Ptr& parent, array_view<IObject::Ptr> children)
+{
+    return add_batch(parent, children, {});
+}
+
+ReturnValue FlatHierarchyImpl::add_subtree(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                                           array_view<uint32_t> parents)
+{
+    return parents.size() == objects.size() ? add_batch(parent, objects, parents)
+                                            : ReturnValue::InvalidArgument;
+}
+
+// Vetoes, one lock acquisition and one AddBatch event pair for the whole batch.
+ReturnValue FlatHierarchyImpl::add_batch(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                                         array_view<uint32_t> parents)
+{
+    if (!parent || !is_valid_batch(objects, parents)) {
+        return ReturnValue::InvalidArgument;
+    }
+    if (objects.empty()) {
+        return ReturnValue::NothingToDo;
+    }
+
+    auto self = get_self<IHierarchy>();
+
+    if (!batch_joining(self, parent, objects, parents)) {
+        return ReturnValue::Refused;
+    }
+
+    fire_event("on_changing", {HierarchyChange::Type::AddBatch, {}, parent, {}, {}, {}, objects});
+
+    {
+        std::lock_guard lock(mutex_);
+        if (!insert_batch(parent, objects, parents)) {
+            return ReturnValue::InvalidArgument;
+        }
+    }
+
+    batch_joined(self, parent, objects, parents);
+    inherited_.joined(parent, objects, parents);
+
+    fire_event("on_changed", {HierarchyChange::Type::AddBatch, {}, parent, {}, {}, {}, objects});
+    return ReturnValue::Success;
+}
+
+// Enters every object in index_ before creating any node, so an object already present (or
+// listed twice) only needs the new entries erased again. The nodes are then created and the
+// reserved entries filled in.
+bool FlatHierarchyImpl::insert_batch(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                                     array_view<uint32_t> parents)
+{
+    auto outer = find(parent.get());
+    if (outer == NONE) {
+        return false;
+    }
+    size_t before = index_.size();
+    reserve_batch(index_, objects.size());
+    std::vector<uint32_t*> slots(objects.size());
+    for (size_t k = 0; k < objects.size(); ++k) {
+        auto [it, inserted] = index_.try_emplace(objects[k].get(), NONE);
+        if (!inserted) {
+            for (size_t j = 0; j < k; ++j) {
+                index_.erase(objects[j].get());
+            }
+            return false;
+        }
+        slots[k] = &it->second;
+    }
+    reserve_batch(nodes_, objects.size());
+    for (size_t k = 0; k < objects.size(); ++k) {
+        bool isOuter = parents.empty() || parents[k] == OUTER_PARENT;
+        *slots[k] = create_node(objects[k], isOuter ? outer : *slots[parents[k]], NONE);
+    }
+    order_.reset();
+    track_entries(before);
+    return true;
+}
+
+// Removes the object and its entire subtree. If the object is the root, the
+// whole tree is cleared. Veto only on the directly removed object, not descendants.
+ReturnValue FlatHierarchyImpl::remove(const IObject::Ptr& object)
+{
+    if (!object) {
+        return ReturnValue::InvalidArgument;
+    }
+
+    auto self = get_self<IHierarchy>();
+
+    if (auto* listener = interface_cast<IHierarchyAware>(object)) {
+        if (!listener->on_hierarchy_leaving(self)) {
+            return ReturnValue::Refused;
+        }
+    }
+
+    IObject::Ptr parent_obj;
+    {
+        std::shared_lock lock(mutex_);
+        auto i = find(object.get());
+        if (i == NONE) {
+            return ReturnValue::NothingToDo;
+        }
+        parent_obj = parent_object(i);
+    }
+
+    fire_event("on_changing", {HierarchyChange::Type::Remove, {}, parent_obj, object});
+
+    std::vector<IObject::Ptr> removed;
+    {
+        std::lock_guard lock(mutex_);
+        auto i = find(object.get());
+        if (i == NONE) {
+            return ReturnValue::NothingToDo;
+        }
+        size_t before = index_.size();
+        if (nodes_[i].parent == NONE) {
+            release_all(removed);
+        } else {
+            if (auto* order = unique_order()) {
+                // The subtree's objects are kept alive by removed until after the lock.
+                auto begin = order->positions[i];
+                for (auto k = begin; k != begin + order->sizes[begin]; ++k) {
+                    if (order->nodes[k].object) {
+                        order->nodes[k].object = {};
+                        --order->live;
+                    }
+                }
+                if (order->live * 2 < order->nodes.size()) {
+                    order_.reset();
+                }
+            }
+            unlink(i);
+            release_subtree(i, removed);
+        }
+        track_entries(before);
+    }
+
+    notify_left(removed);
+    inherited_.left(removed);
+
+    fire_event("on_changed", {HierarchyChange::Type::Remove, {}, parent_obj, object});
+    return ReturnValue::Success;
+}
+
+// Swaps the object of old_child's node for new_child. The node keeps its links, so the
+// children need no reparenting. Veto via on_hierarchy_joining on new_child.
+ReturnValue FlatHierarchyImpl::replace(const IObject::Ptr& old_child, const IObject::Ptr& new_child)
+{
+    if (!old_child || !new_child) {
+        return ReturnValue::InvalidArgument;
+    }
+
+    auto self = get_self<IHierarchy>();
+
+    IObject::Ptr parent_obj;
+    {
+        std::shared_lock lock(mutex_);
+        auto i = find(old_child.get());
+        if (i == NONE || find(new_child.get()) != NONE) {
+            return ReturnValue::InvalidArgument;
+        }
+        parent_obj = parent_object(i);
+    }
+
+    if (auto* listener = interface_cast<IHierarchyAware>(new_child)) {
+        if (!listener->on_hierarchy_joining(self, parent_obj)) {
+            return ReturnValue::Refused;
+        }
+    }
+
+    fire_event("on_changing", {HierarchyChange::Type::Replace, {}, parent_obj, new_child, old_child});
+
+    {
+        std::lock_guard lock(mutex_);
+        auto it = index_.find(old_child.get());
+        if (it == index_.end() || find(new_child.get()) != NONE) {
+            return ReturnValue::InvalidArgument;
+        }
+        auto i = it->second;
+        index_.erase(it);
+        index_.emplace(new_child.get(), i);
+        nodes_[i].object = new_child;
+        if (auto* order = unique_order()) {
+            order->nodes[order->positions[i]].object = new_child;
+        }
+        snapshots_.touch(old_child.get());
+        snapshots_.touch(new_child.get());
+        if (nodes_[i].parent != NONE) {
+            snapshots_.touch(nodes_[nodes_[i].parent].object.get());
+        }
+        for (auto k = nodes_[i].first_child; k != NONE; k = nodes_[k].next_sibling) {
+            snapshots_.touch(nodes_[k].object.get());
+        }
+    }
+
+    if (auto* listener = interface_cast<IHierarchyAware>(old_child)) {
+        listener->on_hierarchy_left(self);
+    }
+
+    if (auto* listener = interface_cast<IHierarchyAware>(new_child)) {
+        listener->on_hierarchy_joined(self, parent_obj);
+    }
+
+    inherited_.left(old_child);
+    inherited_.joined(parent_obj, new_child);
+    inherited_.rebind_children(*this, new_child);
+
+    fire_event("on_changed", {HierarchyChange::Type::Replace, {}, parent_obj, new_child, old_child});
+    return ReturnValue::Success;
+}
+
+// Removes all nodes. No per-object veto; on_hierarchy_left fires for each.
+void FlatHierarchyImpl::clear()
+{
+    fire_event("on_changing", {HierarchyChange::Type::Clear});
+
+    std::vector<IObject::Ptr> removed;
+    {
+        std::lock_guard lock(mutex_);
+        size_t before = index_.size();
+        release_all(removed);
+        track_entries(before);
+    }
+
+    notify_left(removed);
+    inherited_.left(removed);
+
+    fire_event("on_changed", {HierarchyChange::Type::Clear});
+}
+
+IObject::Ptr FlatHierarchyImpl::root() const
+{
+    std::shared_lock lock(mutex_);
+    return index_.empty() ? IObject::Ptr{} : nodes_[0].object;
+}
+
+HierarchyNode FlatHierarchyImpl::node_of(const IObject::Ptr& object) const
+{
+    if (!object) {
+        return {};
+    }
+    std::shared_lock lock(mutex_);
+    auto i = find(object.get());
+    if (i == NONE) {
+        return {};
+    }
+    return {nodes_[i].object, get_self<IHierarchy>()};
+}
+
+IObject::Ptr FlatHierarchyImpl::parent_of(const IObject::Ptr& object) const
+{
+    if (!object) {
+        return {};
+    }
+    std::shared_lock lock(mutex_);
+    auto i = find(object.get());
+    return i != NONE ? parent_object(i) : IObject::Ptr{};
+}
+
+vector<IObject::Ptr> FlatHierarchyImpl::children_of(const IObject::Ptr& object) const
+{
+    if (!object) {
+        return {};
+    }
+    std::shared_lock lock(mutex_);
+    auto i = find(object.get());
+    if (i == NONE) {
+        return {};
+    }
+    vector<IObject::Ptr> result;
+    result.reserve(nodes_[i].child_count);
+    for (auto c = nodes_[i].first_child; c != NONE; c = nodes_[c].next_sibling) {
+        result.push_back(nodes_[c].object);
+    }
+    return result;
+}
+
+// Exposes the sibling list in place: the view follows next_sibling from node to node.
+ChildrenView FlatHierarchyImpl::view_children(const IObject::Ptr& object) const
+{
+    if (!object) {
+        return {};
+    }
+    mutex_.lock_shared();
+    auto i = find(object.get());
+    if (i == NONE) {
+        mutex_.unlock_shared();
+        return {};
+    }
+    auto& node = nodes_[i];
+    ChildrenView::Layout layout;
+    layout.base = reinterpret_cast<const char*>(&nodes_[0].object);
+    layout.stride = sizeof(Node);
+    layout.next_offset =
+        reinterpret_cast<const char*>(&node.next_sibling) - reinterpret_cast<const char*>(&node.object);
+    layout.first = node.first_child;
+    layout.count = node.child_count;
+    return {layout, &mutex_, &unlock_children_view};
+}
+
+IObject::Ptr FlatHierarchyImpl::child_at(const IObject::Ptr& object, size_t index) const
+{
+    if (!object) {
+        return {};
+    }
+    std::shared_lock lock(mutex_);
+    auto i = find(object.get());
+    auto c = i != NONE ? nth_child(i, index) : NONE;
+    return c != NONE ? nodes_[c].object : IObject::Ptr{};
+}
+
+size_t FlatHierarchyImpl::child_count(const IObject::Ptr& object) const
+{
+    if (!object) {
+        return 0;
+    }
+    std::shared_lock lock(mutex_);
+    auto i = find(object.get());
+    return i != NONE ? nodes_[i].child_count : 0;
+}
+
+// Snapshots children under shared lock, then iterates outside the lock so the
+// visitor can safely mutate the hierarchy. Visitor returns false to stop early.
+void FlatHierarchyImpl::for_each_child(const IObject::Ptr& object, void* context,
+                                       ChildVisitorFn visitor) const
+{
+    if (!object || !visitor) {
+        return;
+    }
+    small_vector<IObject::Ptr, 16> snapshot;
+    {
+        std::shared_lock lock(mutex_);
+        auto i = find(object.get());
+        if (i == NONE) {
+            return;
+        }
+        snapshot.reserve(nodes_[i].child_count);
+        for (auto c = nodes_[i].first_child; c != NONE; c = nodes_[c].next_sibling) {
+            snapshot.push_back(nodes_[c].object);
+        }
+    }
+    for (auto& child : snapshot) {
+        if (!visitor(context, child)) {
+            return;
+        }
+    }
+}
+
+// Shares the cached order under shared lock, rebuilding it if needed, then visits the subtree's
+// range outside the lock. The shared order keeps the listed objects alive.
+std::shared_ptr<const FlatHierarchyImpl::DepthFirstOrder>
+FlatHierarchyImpl::share_order(const IObject::Ptr& object, uint32_t& begin) const
+{
+    std::shared_lock lock(mutex_);
+    auto i = find(object.get());
+    if (i == NONE) {
+        return {};
+    }
+    std::lock_guard order_lock(order_mutex_);
+    if (!order_) {
+        order_ = build_order();
+    }
+    begin = order_->positions[i];
+    return order_;
+}
+
+void FlatHierarchyImpl::traverse(const IObject::Ptr& object, TraversalOrder order, void* context,
+                                 SubtreeVisitorFn visitor) const
+{
+    if (!object || !visitor) {
+        return;
+    }
+    uint32_t begin;
+    if (auto listing = share_order(object, begin)) {
+        visit_in_order(listing->nodes.data() + begin, listing->sizes[begin], order, context, visitor);
+    }
+}
+
+void FlatHierarchyImpl::traverse_parallel(const IObject::Ptr& object, TraversalOrder order,
+                                          IExecutor* executor, const ParallelTraversalConfig& config,
+                                          void* context, SubtreeVisitorFn visitor) const
+{
+    if (!object || !visitor) {
+        return;
+    }
+    uint32_t begin;
+    if (auto listing = share_order(object, begin)) {
+        visit_parallel(listing->nodes.data() + begin, listing->sizes[begin], order, executor, config, context,
+                       visitor);
+    }
+}
+
+bool FlatHierarchyImpl::contains(const IObject::Ptr& object) const
+{
+    if (!object) {
+        return false;
+    }
+    std::shared_lock lock(mutex_);
+    return find(object.get()) != NONE;
+}
+
+size_t FlatHierarchyImpl::size() const
+{
+    std::shared_lock lock(mutex_);
+    return index_.size();
+}
+
+ReturnValue FlatHierarchyImpl::add_inherited(string_view source, string_view target,
+                                             const IFunction::ConstPtr& combine)
+{
+    return inherited_.add(*this, source, target, combine);
+}
+
+ReturnValue FlatHierarchyImpl::remove_inherited(string_view target)
+{
+    return inherited_.remove(*this, target);
+}
+
+void FlatHierarchyImpl::read_snapshot_node(uint32_t node, SnapshotNode& out) const
+{
+    auto& n = nodes_[node];
+    out.object = n.object;
+    out.parent = parent_object(node);
+    if (n.child_count) {
+        auto children = std::make_shared<std::vector<IObject::Ptr>>();
+        children->reserve(n.child_count);
+        for (auto c = n.first_child; c != NONE; c = nodes_[c].next_sibling) {
+            children->push_back(nodes_[c].object);
+        }
+        out.children = std::move(children);
+    }
+}
+
+uint64_t FlatHierarchyImpl::commit_snapshot()
+{
+    // Declared before the lock, so that the replaced snapshot is released after unlocking.
+    IHierarchySnapshot::Ptr replaced;
+    std::lock_guard lock(mutex_);
+    return snapshots_.commit(
+        index_.empty() ? IObject::Ptr{} : nodes_[0].object, index_.size(), this,
+        [](const void* self, const IObject* object, SnapshotNode& node) {
+            auto& h = *static_cast<const FlatHierarchyImpl*>(self);
+            auto i = h.find(object);
+            if (i == NONE) {
+                return false;
+            }
+            h.read_snapshot_node(i, node);
+            return true;
+        },
+        [](const void* self, std::vector<SnapshotNode>& nodes) {
+            auto& h = *static_cast<const FlatHierarchyImpl*>(self);
+            for (uint32_t i = 0; i < h.nodes_.size(); ++i) {
+                if (h.nodes_[i].object) {
+                    h.read_snapshot_node(i, nodes.emplace_back());
+                }
+            }
+        },
+        replaced);
+}
+
+IHierarchySnapshot::Ptr FlatHierarchyImpl::snapshot() const
+{
+    return snapshots_.acquire();
+}
+
+void FlatHierarchyImpl::begin_batch()
+{
+    deferred_.begin();
+}
+
+ReturnValue FlatHierarchyImpl::end_batch()
+{
+    std::vector<HierarchyChange> changes;
+    std::vector<IObject::Ptr> children;
+    auto ret = deferred_.end(changes, children);
+    if (!changes.empty()) {
+        HierarchyChange batch{HierarchyChange::Type::Batch};
+        batch.changes = {changes.data(), changes.size()};
+        fire_event("on_changed", batch);
+    }
+    return ret;
+}
+
+// Notifies each removed object via IHierarchyAware::on_hierarchy_left.
+// Called outside the lock so callbacks can safely interact with the hierarchy.
+void FlatHierarchyImpl::notify_left(const std::vector<IObject::Ptr>& removed)
+{
+    auto self = get_self<IHierarchy>();
+    for (auto& obj : removed) {
+        if (auto* listener = interface_cast<IHierarchyAware>(obj)) {
+            listener->on_hierarchy_left(self);
+        }
+    }
+}
+
+} // namespace velk
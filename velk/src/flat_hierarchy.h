@@ -0,0 +1,157 @@
+#ifndef FLAT_HIERARCHY_H
+#define FLAT_HIERARCHY_H
+
+#include "hierarchy.h"
+
+#include <velk/ext/object.h>
+#include <velk/interface/intf_hierarchy.h>
+#include <velk/vector.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief IHierarchy implementation storing the tree in a dense node array.
+ *
+ * Nodes link to their parent, first and last child and siblings by index, and record their
+ * depth, so traversals walk the array instead of looking up every node. A side table maps each
+ * object to its node. Removed nodes are reused by later inserts. child_at() and insert() walk
+ * the sibling list from the nearer end.
+ *
+ * traverse() scans a cached pre-order listing of the tree, where every subtree is a contiguous
+ * range. Adding nodes drops the listing and the next traversal rebuilds it; removing a subtree
+ * and replace() update it in place unless a traversal is still using it.
+ *
+ * Thread-safe: reads use shared locks, mutations use exclusive locks.
+ * Listener callbacks and events are invoked outside the lock.
+ */
+class FlatHierarchyImpl final : public ext::Object<FlatHierarchyImpl, IHierarchy>
+{
+public:
+    VELK_CLASS_UID(ClassId::FlatHierarchy);
+
+    ~FlatHierarchyImpl() override;
+
+    ReturnValue set_root(const IObject::Ptr& root) override;
+    ReturnValue add(const IObject::Ptr& parent, const IObject::Ptr& child) override;
+    ReturnValue insert(const IObject::Ptr& parent, size_t index, const IObject::Ptr& child) override;
+    ReturnValue add_children(const IObject::Ptr& parent, array_view<IObject::Ptr> children) override;
+    ReturnValue add_subtree(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                            array_view<uint32_t> parents) override;
+    ReturnValue remove(const IObject::Ptr& object) override;
+    ReturnValue replace(const IObject::Ptr& old_child, const IObject::Ptr& new_child) override;
+    void clear() override;
+
+    IObject::Ptr root() const override;
+    HierarchyNode node_of(const IObject::Ptr& object) const override;
+    IObject::Ptr parent_of(const IObject::Ptr& object) const override;
+    vector<IObject::Ptr> children_of(const IObject::Ptr& object) const override;
+    ChildrenView view_children(const IObject::Ptr& object) const override;
+    IObject::Ptr child_at(const IObject::Ptr& object, size_t index) const override;
+    size_t child_count(const IObject::Ptr& object) const override;
+    void for_each_child(const IObject::Ptr& object, void* context, ChildVisitorFn visitor) const override;
+    void traverse(const IObject::Ptr& object, TraversalOrder order, void* context,
+                  SubtreeVisitorFn visitor) const override;
+    void traverse_parallel(const IObject::Ptr& object, TraversalOrder order, IExecutor* executor,
+                           const ParallelTraversalConfig& config, void* context,
+                           SubtreeVisitorFn visitor) const override;
+    bool contains(const IObject::Ptr& object) const override;
+    size_t size() const override;
+    ReturnValue add_inherited(string_view source, string_view target,
+                              const IFunction::ConstPtr& combine) override;
+    ReturnValue remove_inherited(string_view target) override;
+    uint64_t commit_snapshot() override;
+    IHierarchySnapshot::Ptr snapshot() const override;
+    void begin_batch() override;
+    ReturnValue end_batch() override;
+
+private:
+    // Index of no node.
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // One node of the tree, linked to its neighbours by index into nodes_.
+    struct Node
+    {
+        IObject::Ptr object;          // Owning reference; null for a free node.
+        uint32_t parent = NONE;       // NONE for the root.
+        uint32_t first_child = NONE;  // First in the ordered child list.
+        uint32_t last_child = NONE;   // Last in the ordered child list.
+        uint32_t prev_sibling = NONE; // Previous child of the parent.
+        uint32_t next_sibling = NONE; // Next child of the parent.
+        uint32_t child_count = 0;     // Number of direct children.
+        uint32_t depth = 0;           // Distance from the root.
+        uint32_t next_free = NONE;    // Next free node while this one is free.
+    };
+
+    // Pre-order listing of the whole tree, shared with the traversals using it.
+    struct DepthFirstOrder
+    {
+        std::vector<OrderedNode> nodes;  // Removed subtrees are left in place with null objects.
+        std::vector<uint32_t> sizes;     // Length of the subtree listed at each position.
+        std::vector<uint32_t> positions; // Position of each node of nodes_ when listed, or NONE.
+        size_t live = 0;                 // Listed objects not removed since.
+    };
+
+    // Returns the node of obj, or NONE. Caller must hold a lock.
+    uint32_t find(const IObject* obj) const;
+    // Returns the index-th child of parent, or NONE if out of range. Caller must hold a lock.
+    uint32_t nth_child(uint32_t parent, size_t index) const;
+    // Returns the node after node in pre-order within the subtree of top, or NONE.
+    uint32_t next_in_subtree(uint32_t node, uint32_t top) const;
+    // Creates a node for object and links it under parent before the child before, appending if
+    // before is NONE. Returns the node for the caller to enter in index_. Caller must hold the
+    // exclusive lock.
+    uint32_t create_node(const IObject::Ptr& object, uint32_t parent, uint32_t before);
+    // Unlinks node from its parent and siblings. Caller must hold the exclusive lock.
+    void unlink(uint32_t node);
+    // Frees node and its descendants, collecting their objects in pre-order in removed.
+    void release_subtree(uint32_t node, std::vector<IObject::Ptr>& removed);
+    // Frees all nodes, collecting their objects in removed. Caller must hold the exclusive lock.
+    void release_all(std::vector<IObject::Ptr>& removed);
+    // Returns the owning Ptr of node's parent, or null. Caller must hold a lock.
+    IObject::Ptr parent_object(uint32_t node) const;
+    // Reads node into out, for the SnapshotPublisher. Caller must hold a lock.
+    void read_snapshot_node(uint32_t node, SnapshotNode& out) const;
+    // Lists the tree in pre-order. Caller must hold a lock.
+    std::shared_ptr<DepthFirstOrder> build_order() const;
+    // Shares the cached order, building it if needed, and sets begin to the position of object.
+    // Returns null if object is not in the hierarchy.
+    std::shared_ptr<const DepthFirstOrder> share_order(const IObject::Ptr& object, uint32_t& begin) const;
+    // Returns the cached order if no traversal shares it, else drops it and returns null.
+    // Caller must hold the exclusive lock.
+    DepthFirstOrder* unique_order();
+    // Implements add_children() and add_subtree(); empty parents adds every object under parent.
+    ReturnValue add_batch(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                          array_view<uint32_t> parents);
+    // Adds the entries of a batch, or nothing if one is already present. Caller must hold the
+    // exclusive lock.
+    bool insert_batch(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                      array_view<uint32_t> parents);
+    // Fires on_hierarchy_left on each removed object that implements IHierarchyAware.
+    void notify_left(const std::vector<IObject::Ptr>& removed);
+    // Reports the nodes added or removed since the hierarchy held `before` as
+    // MemoryCategory::HierarchyEntries. Caller must hold the lock.
+    void track_entries(size_t before) const;
+    // Fires on_changing or on_changed if handlers exist. Invoked outside the lock.
+    void fire_event(string_view name, HierarchyChange change);
+
+    mutable std::shared_mutex mutex_;                    // Shared for reads, exclusive for mutations.
+    std::vector<Node> nodes_;                            // Live and free nodes; the root is node 0.
+    uint32_t free_ = NONE;                               // First free node.
+    std::unordered_map<const IObject*, uint32_t> index_; // Node of each object in the hierarchy.
+    mutable std::mutex order_mutex_;                     // Guards order_ under the shared lock.
+    mutable std::shared_ptr<DepthFirstOrder> order_;     // Cached listing, or null until traversed.
+    InheritedProperties inherited_;                      // Properties bound to the parent's.
+    SnapshotPublisher snapshots_;                        // Snapshots published by commit_snapshot().
+    DeferredChanges deferred_;                           // Changes of the open batch.
+};
+
+} // namespace velk
+
+#endif // FLAT_HIERARCHY_H
@@ -25,11 +25,8 @@ IAny::Ptr FunctionImpl::callback_trampoline(void* ctx, FnArgs args)
 
 IAny::Ptr FunctionImpl::invoke(FnArgs args, InvokeType type) const
 {
-    if (type == Deferred) {
-        DeferredTask task;
-        task.fn = get_self<IFunction>();
-        task.args = ::velk::make_shared<DeferredArgs>(args);
-        instance().queue_deferred_tasks(array_view(&task, 1));
+    if (invoke_mode(type) != Immediate) {
+        instance().queue_deferred_call(get_self<IFunction>(), args, type);
         return nullptr;
     }
 
@@ -39,18 +36,41 @@ IAny::Ptr FunctionImpl::invoke(FnArgs args, InvokeType type) const
     return nullptr;
 }
 
+bool FunctionImpl::invoke_typed(IFunction::TypedFn* typed, const void* const* args, void* result) const
+{
+    if (!typed || typed != typed_fn_) {
+        return false;
+    }
+    typed_fn_(target_context_, args, result);
+    return true;
+}
+
+ReturnValue FunctionImpl::invoke_into(FnArgs args, IAny& result) const
+{
+    if (result_fn_) {
+        return result_fn_(target_context_, args, result);
+    }
+    auto value = invoke(args);
+    return value ? result.copy_from(*value) : ReturnValue::NothingToDo;
+}
+
 void FunctionImpl::set_invoke_callback(IFunction::CallableFn* fn)
 {
     release_owned_context();
     target_context_ = reinterpret_cast<void*>(fn);
     target_fn_ = fn ? &callback_trampoline : nullptr;
+    typed_fn_ = nullptr;
+    result_fn_ = nullptr;
 }
 
-void FunctionImpl::bind(void* context, IFunction::BoundFn* fn)
+void FunctionImpl::bind(void* context, IFunction::BoundFn* fn, IFunction::TypedFn* typed,
+                        IFunction::ResultFn* into)
 {
     release_owned_context();
     target_context_ = context;
     target_fn_ = fn;
+    typed_fn_ = typed;
+    result_fn_ = into;
 }
 
 void FunctionImpl::set_owned_callback(void* context, IFunction::BoundFn* fn,
@@ -61,6 +81,8 @@ void FunctionImpl::set_owned_callback(void* context, IFunction::BoundFn* fn,
     context_deleter_ = deleter;
     target_context_ = context;
     target_fn_ = fn;
+    typed_fn_ = nullptr;
+    result_fn_ = nullptr;
 }
 
 ReturnValue FunctionImpl::add_handler(const IFunction::ConstPtr& /*fn*/, InvokeType /*type*/) const
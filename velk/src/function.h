@@ -7,8 +7,12 @@
 #include <velk/interface/intf_function.h>
 #include <velk/interface/types.h>
 
+#include <atomic>
+
 namespace velk {
 
+class EventBatches;
+
 /**
  * @brief Internal interface for configuring an IFunction's invoke callback.
  *
@@ -27,8 +31,11 @@ public:
      * @brief Binds a context pointer and trampoline function for virtual dispatch.
      * @param context Pointer to the interface subobject (passed as first arg to fn).
      * @param fn Static trampoline that casts context and calls the virtual method.
+     * @param typed Typed trampoline for the same method, used by invoke_typed(). May be null.
+     * @param into Trampoline for the same method, used by invoke_into(). May be null.
      */
-    virtual void bind(void* context, IFunction::BoundFn* fn) = 0;
+    virtual void bind(void* context, IFunction::BoundFn* fn, IFunction::TypedFn* typed = nullptr,
+                      IFunction::ResultFn* into = nullptr) = 0;
 
     /**
      * @brief Sets an owned callback with a heap-allocated context.
@@ -42,6 +49,20 @@ public:
      */
     virtual void set_owned_callback(void* context, IFunction::BoundFn* fn,
                                     IFunction::ContextDeleter* deleter) = 0;
+
+    /**
+     * @brief Invokes the deferred handlers of an event queued with IVelk::queue_deferred_handlers().
+     * @param type Deferred for the deferred handlers, DeferredCoalesced for the coalesced ones.
+     * @param batches Receives the invocation for the handlers that implement IEventBatchHandler.
+     * @return The number of handlers invoked.
+     */
+    virtual size_t invoke_deferred_handlers(FnArgs args, InvokeType type, EventBatches& batches) const = 0;
+
+    /**
+     * @brief Sets whether a DeferredOnce invocation of the function is queued.
+     * @return The previous value.
+     */
+    virtual bool set_queued_once(bool queued) const = 0;
 };
 
 /**
@@ -67,12 +88,24 @@ public:
 
 public: // IFunction
     IAny::Ptr invoke(FnArgs args, InvokeType type = Immediate) const override;
+    bool invoke_typed(IFunction::TypedFn* typed, const void* const* args, void* result) const override;
+    ReturnValue invoke_into(FnArgs args, IAny& result) const override;
 
 public: // IFunctionInternal
     void set_invoke_callback(IFunction::CallableFn* fn) override;
-    void bind(void* context, IFunction::BoundFn* fn) override;
+    void bind(void* context, IFunction::BoundFn* fn, IFunction::TypedFn* typed = nullptr,
+              IFunction::ResultFn* into = nullptr) override;
     void set_owned_callback(void* context, IFunction::BoundFn* fn,
                             IFunction::ContextDeleter* deleter) override;
+    size_t invoke_deferred_handlers(FnArgs /*args*/, InvokeType /*type*/,
+                                    EventBatches& /*batches*/) const override
+    {
+        return 0;
+    }
+    bool set_queued_once(bool queued) const override
+    {
+        return queued_once_.exchange(queued, std::memory_order_acq_rel);
+    }
 
 public: // IEvent (stubs; use EventImpl for handler support)
     ReturnValue add_handler(const IFunction::ConstPtr& fn, InvokeType type = Immediate) const override;
@@ -90,6 +123,9 @@ private:
         target_fn_{}; ///< Primary invoke target. Uses callback_trampoline when set via set_invoke_callback.
     void* owned_context_{};                        ///< Heap-allocated callable context (owned).
     IFunction::ContextDeleter* context_deleter_{}; ///< Deleter for owned_context_.
+    IFunction::TypedFn* typed_fn_{};               ///< Typed trampoline of the bound method (bind only).
+    IFunction::ResultFn* result_fn_{};             ///< invoke_into() trampoline of the bound method.
+    mutable std::atomic<bool> queued_once_{};      ///< True while a DeferredOnce invocation is queued.
 };
 
 } // namespace velk
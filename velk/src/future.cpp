@@ -2,21 +2,72 @@
 
 #include <velk/api/callback.h>
 #include <velk/api/velk.h>
+#include <velk/ext/any.h>
+
+#include <utility>
 
 namespace velk {
 
+struct FutureImpl::FanIn
+{
+    IFuture::Ptr combined;          // Resolved by the input that completes the fan-in.
+    std::atomic<size_t> pending{1}; // Inputs not ready yet, plus one until all are added.
+    std::atomic<bool> done{false};  // Set by the first input of a when_any() to be ready.
+    bool any = false;               // when_any() rather than when_all().
+
+    // Counts down the input at index, which just became ready.
+    void arrive(uint32_t index)
+    {
+        auto* internal = interface_cast<IFutureInternal>(combined);
+        if (any) {
+            if (!done.exchange(true, std::memory_order_acq_rel)) {
+                internal->set_result(ext::create_any_value(uint32_t{index}));
+            }
+        } else if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            internal->set_result(nullptr);
+        }
+    }
+};
+
+FutureImpl::Continuation* FutureImpl::ready_marker()
+{
+    static Continuation marker;
+    return &marker;
+}
+
+FutureImpl::~FutureImpl()
+{
+    auto* cont = continuations_.load(std::memory_order_acquire);
+    while (cont && cont != ready_marker()) {
+        delete std::exchange(cont, cont->next);
+    }
+    delete waiter_.load(std::memory_order_acquire);
+}
+
 bool FutureImpl::is_ready() const
 {
-    return ready_.load(std::memory_order_acquire);
+    return continuations_.load(std::memory_order_acquire) == ready_marker();
 }
 
+// The waiter is published before checking for the result and set_result() marks the result
+// before looking for a waiter, both sequentially consistent, so at least one of them sees the
+// other: either this wait() returns, or set_result() notifies it under the mutex.
 void FutureImpl::wait() const
 {
-    if (ready_.load(std::memory_order_acquire)) {
+    if (is_ready()) {
         return;
     }
-    std::unique_lock lock(mutex_);
-    cv_.wait(lock, [this] { return ready_.load(std::memory_order_relaxed); });
+    auto* waiter = waiter_.load();
+    if (!waiter) {
+        auto* created = new Waiter;
+        if (waiter_.compare_exchange_strong(waiter, created)) {
+            waiter = created;
+        } else {
+            delete created;
+        }
+    }
+    std::unique_lock lock(waiter->mutex);
+    waiter->cv.wait(lock, [this] { return continuations_.load() == ready_marker(); });
 }
 
 const IAny* FutureImpl::get_result() const
@@ -27,71 +78,232 @@ const IAny* FutureImpl::get_result() const
 
 ReturnValue FutureImpl::set_result(const IAny* result)
 {
-    std::vector<Continuation> continuations;
-    {
-        std::lock_guard lock(mutex_);
-        if (ready_.load(std::memory_order_relaxed)) {
-            return ReturnValue::NothingToDo;
-        }
-        result_ = result ? result->clone() : nullptr;
-        ready_.store(true, std::memory_order_release);
-        continuations.swap(pending_continuations_);
+    // Checked before cloning so that a second set_result() does not copy the value.
+    if (claimed_.load(std::memory_order_acquire)) {
+        return ReturnValue::NothingToDo;
     }
-    cv_.notify_all();
+    return resolve(result ? result->clone() : nullptr);
+}
 
-    for (auto& cont : continuations) {
-        fire_continuation(cont, result_.get());
+ReturnValue FutureImpl::set_result(IAny::Ptr&& result)
+{
+    return resolve(std::move(result));
+}
+
+ReturnValue FutureImpl::resolve(IAny::Ptr&& result)
+{
+    if (claimed_.exchange(true, std::memory_order_acq_rel)) {
+        return ReturnValue::NothingToDo;
     }
+    result_ = std::move(result);
+    finish();
     return ReturnValue::Success;
 }
 
+ReturnValue FutureImpl::cancel()
+{
+    if (claimed_.exchange(true, std::memory_order_acq_rel)) {
+        return ReturnValue::NothingToDo;
+    }
+    cancelled_.store(true, std::memory_order_release);
+    finish();
+    return ReturnValue::Success;
+}
+
+bool FutureImpl::is_cancelled() const
+{
+    return cancelled_.load(std::memory_order_acquire);
+}
+
+void FutureImpl::finish()
+{
+    auto* pending = continuations_.exchange(ready_marker());
+
+    if (auto* waiter = waiter_.load()) {
+        // Taking the mutex orders the notification after a waiter's check of the predicate.
+        { std::lock_guard lock(waiter->mutex); }
+        waiter->cv.notify_all();
+    }
+
+    // The stack lists the newest first; fire in the order the continuations were added.
+    Continuation* ordered = nullptr;
+    while (pending) {
+        auto* next = pending->next;
+        pending->next = ordered;
+        ordered = pending;
+        pending = next;
+    }
+    while (ordered) {
+        fire_continuation(*ordered, result_.get());
+        delete std::exchange(ordered, ordered->next);
+    }
+}
+
+bool FutureImpl::push_continuation(Continuation* cont)
+{
+    auto* head = continuations_.load(std::memory_order_acquire);
+    while (head != ready_marker()) {
+        cont->next = head;
+        if (continuations_.compare_exchange_weak(head, cont, std::memory_order_release,
+                                                 std::memory_order_acquire)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void FutureImpl::add_continuation(const IFunction::ConstPtr& fn, InvokeType type)
 {
     if (!fn) {
         return;
     }
 
-    {
-        std::lock_guard lock(mutex_);
-        if (!ready_.load(std::memory_order_relaxed)) {
-            pending_continuations_.push_back({fn, type});
+    if (continuations_.load(std::memory_order_acquire) != ready_marker()) {
+        auto* cont = new Continuation{fn, type};
+        if (push_continuation(cont)) {
             return;
         }
+        delete cont;
     }
     // Already ready — fire now
     fire_continuation({fn, type}, result_.get());
 }
 
-void FutureImpl::fire_continuation(const Continuation& cont, const IAny* result) const
+void FutureImpl::run_step(const IFunction& fn, const IAny* result, IFuture* chained)
 {
+    // A chained future cancelled meanwhile has no consumer left for the step's result.
+    if (chained && chained->is_cancelled()) {
+        return;
+    }
     FnArgs args;
     if (result) {
         args = {&result, 1};
     }
+    auto value = fn.invoke(args);
+    if (auto* internal = interface_cast<IFutureInternal>(chained)) {
+        internal->set_result(std::move(value));
+    }
+}
+
+void FutureImpl::fire_continuation(const Continuation& cont, const IAny* result) const
+{
+    if (cont.fan_in) {
+        cont.fan_in->arrive(cont.index);
+        return;
+    }
+    if (is_cancelled()) {
+        // Dropped, and the futures chained by then() are cancelled with this one.
+        if (cont.chained) {
+            cont.chained->cancel();
+        }
+        return;
+    }
 
-    if (cont.type == Immediate) {
-        cont.fn->invoke(args);
-    } else {
-        DeferredTask task;
-        task.fn = cont.fn;
-        task.args = ::velk::make_shared<DeferredArgs>(args);
-        instance().queue_deferred_tasks(array_view(&task, 1));
+    if (invoke_mode(cont.type) == Immediate) {
+        run_step(*cont.fn, result, cont.chained.get());
+        return;
+    }
+    // Pool continuations run on the thread pool, all others on the next update().
+    auto queued = invoke_mode(cont.type) == Pool ? Pool : Deferred | invoke_priority(cont.type);
+    auto self = get_self();
+    if (!cont.chained && (!result || !self)) {
+        FnArgs args;
+        if (result) {
+            args = {&result, 1};
+        }
+        instance().queue_deferred_call(cont.fn, args, queued);
+        return;
     }
+    // Hand the continuation the stored result instead of letting the queue clone it; the
+    // wrapper's reference keeps the future, and so the result, alive until it runs.
+    IAny::Ptr owned;
+    if (!self && result) {
+        owned = result->clone();
+        result = owned.get();
+    }
+    Callback deferred([self = std::move(self), owned = std::move(owned), fn = cont.fn, chained = cont.chained,
+                       result](FnArgs) -> IAny::Ptr {
+        run_step(*fn, result, chained.get());
+        return nullptr;
+    });
+    instance().queue_deferred_call(deferred, {}, queued);
 }
 
 IFuture::Ptr FutureImpl::then(const IFunction::ConstPtr& fn, InvokeType type)
 {
+    if (!fn) {
+        return nullptr;
+    }
     auto chained = instance().create_future();
-    auto* internal = interface_cast<IFutureInternal>(chained);
-    Callback wrapper([internal, chained, fn](FnArgs args) -> IAny::Ptr {
-        auto result = fn->invoke(args);
-        if (internal) {
-            internal->set_result(result.get());
+    if (continuations_.load(std::memory_order_acquire) != ready_marker()) {
+        auto* cont = new Continuation{fn, type};
+        cont->chained = chained;
+        if (push_continuation(cont)) {
+            return chained;
         }
-        return nullptr;
-    });
-    add_continuation(wrapper, type);
+        delete cont;
+    }
+    Continuation cont{fn, type};
+    cont.chained = chained;
+    fire_continuation(cont, result_.get());
     return chained;
 }
 
+IFuture::Ptr FutureImpl::when_all(array_view<IFuture::Ptr> futures)
+{
+    return fan_in(futures, false);
+}
+
+IFuture::Ptr FutureImpl::when_any(array_view<IFuture::Ptr> futures)
+{
+    return futures.empty() ? nullptr : fan_in(futures, true);
+}
+
+IFuture::Ptr FutureImpl::fan_in(array_view<IFuture::Ptr> futures, bool any)
+{
+    for (auto& future : futures) {
+        if (!future) {
+            return nullptr;
+        }
+    }
+    auto state = std::make_shared<FanIn>();
+    state->combined = instance().create_future();
+    state->pending.store(futures.size() + 1, std::memory_order_relaxed);
+    state->any = any;
+    auto combined = state->combined;
+
+    for (uint32_t i = 0; i < futures.size(); ++i) {
+        // Once a when_any() resolved, the remaining inputs no longer matter.
+        if (any && state->done.load(std::memory_order_acquire)) {
+            break;
+        }
+        auto& future = futures[i];
+        auto* object = interface_cast<IObject>(future);
+        if (!object || object->get_class_uid() != ClassId::Future) {
+            // Another IFuture implementation: count it down from a callback.
+            future->add_continuation(Callback([state, i](FnArgs) -> ReturnValue {
+                state->arrive(i);
+                return ReturnValue::Success;
+            }));
+            continue;
+        }
+        auto& impl = static_cast<FutureImpl&>(*future);
+        if (impl.is_ready()) {
+            state->arrive(i);
+            continue;
+        }
+        auto* cont = new Continuation{nullptr, Immediate};
+        cont->fan_in = state;
+        cont->index = i;
+        if (!impl.push_continuation(cont)) {
+            delete cont;
+            state->arrive(i);
+        }
+    }
+    if (!any) {
+        state->arrive(0); // Drops the count held while adding.
+    }
+    return combined;
+}
+
 } // namespace velk
@@ -8,19 +8,30 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
-#include <vector>
 
 namespace velk {
 
 /**
  * @brief Default IFuture/IFutureInternal implementation.
  *
- * Thread-safe future that stores a cloned IAny result. Supports blocking
+ * Thread-safe future that stores a cloned or adopted IAny result. Supports blocking
  * wait(), lock-free is_ready(), and continuation chaining via then().
  * Continuations attached before set_result() are stored and fired when
  * the result arrives. Continuations attached after are fired immediately
  * (Immediate type) or queued via instance().queue_deferred_tasks() (Deferred type).
+ *
+ * Continuations are pushed on a lock-free stack that set_result() swaps for a sentinel marking
+ * the future ready, so neither takes a lock. The mutex and condition variable that wait()
+ * blocks on are only allocated by the first wait() that finds the future not ready.
+ *
+ * Continuations receive the stored result by pointer, including Deferred ones, which keep the
+ * future alive until they run. then() adopts the result its continuation returns.
+ *
+ * when_all() and when_any() share one counter among their inputs and resolve a single combined
+ * future. The inputs that are FutureImpls count down through a continuation node of their own
+ * rather than a callback each.
  */
 class FutureImpl final : public ext::ObjectCore<FutureImpl, IFutureInternal>
 {
@@ -28,6 +39,7 @@ public:
     VELK_CLASS_UID(ClassId::Future);
 
     FutureImpl() = default;
+    ~FutureImpl() override;
 
 public: // IFuture
     bool is_ready() const override;
@@ -35,24 +47,62 @@ public: // IFuture
     const IAny* get_result() const override;
     void add_continuation(const IFunction::ConstPtr& fn, InvokeType type) override;
     IFuture::Ptr then(const IFunction::ConstPtr& fn, InvokeType type) override;
+    ReturnValue cancel() override;
+    bool is_cancelled() const override;
 
 public: // IFutureInternal
     ReturnValue set_result(const IAny* result) override;
+    ReturnValue set_result(IAny::Ptr&& result) override;
+
+    /** @brief Implements IVelk::when_all(). */
+    static IFuture::Ptr when_all(array_view<IFuture::Ptr> futures);
+    /** @brief Implements IVelk::when_any(). */
+    static IFuture::Ptr when_any(array_view<IFuture::Ptr> futures);
 
 private:
+    // Shared state of a when_all() or when_any().
+    struct FanIn;
+
     struct Continuation
     {
         IFunction::ConstPtr fn;
         InvokeType type;
+        Continuation* next = nullptr;  // Continuation added before this one.
+        IFuture::Ptr chained;          // Future of then() that fn resolves, or null.
+        std::shared_ptr<FanIn> fan_in; // Counted down instead of invoking fn, if set.
+        uint32_t index = 0;            // Position of this future among the inputs of fan_in.
     };
 
+    // What wait() blocks on until set_result().
+    struct Waiter
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    // Value of continuations_ once the result is set.
+    static Continuation* ready_marker();
+
+    // Stores result and fires the pending continuations. Returns NothingToDo if already claimed.
+    ReturnValue resolve(IAny::Ptr&& result);
+    // Marks the claimed future ready, wakes the waiters and fires the pending continuations.
+    void finish();
+    // Invokes fn with result and resolves chained with what it returns, unless chained was
+    // cancelled.
+    static void run_step(const IFunction& fn, const IAny* result, IFuture* chained);
+    // Pushes cont on the stack of pending continuations. Returns false, leaving cont to the
+    // caller, if the future is already ready.
+    bool push_continuation(Continuation* cont);
+    // Implements when_all() and when_any().
+    static IFuture::Ptr fan_in(array_view<IFuture::Ptr> futures, bool any);
+
     void fire_continuation(const Continuation& cont, const IAny* result) const;
 
-    mutable std::mutex mutex_;
-    mutable std::condition_variable cv_;
-    std::atomic<bool> ready_{false};
-    IAny::Ptr result_;
-    std::vector<Continuation> pending_continuations_;
+    std::atomic<Continuation*> continuations_{nullptr}; // Stack of pending ones, or ready_marker().
+    mutable std::atomic<Waiter*> waiter_{nullptr};      // Allocated by the first blocking wait().
+    std::atomic<bool> claimed_{false};                  // Set by the set_result() or cancel() that wins.
+    std::atomic<bool> cancelled_{false};                // Set by cancel() before marking ready.
+    IAny::Ptr result_;                                  // Written before continuations_ is marked.
 };
 
 } // namespace velk
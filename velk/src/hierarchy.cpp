@@ -1,15 +1,22 @@
 #include "hierarchy.h"
 
 #include <velk/ext/any.h>
+#include <velk/trace.h>
+
+#include <atomic>
 
 namespace velk {
 
 // Looks up a named event (on_changing / on_changed) and invokes it with the change
 // descriptor wrapped as a single IAny argument. Skips work if no handlers are registered.
+// Inside a batch, the change is recorded instead.
 void HierarchyImpl::fire_event(string_view name, HierarchyChange change)
 {
     auto evt = get_event(name, Resolve::Existing);
     if (evt && evt->has_handlers()) {
+        if (change.type != HierarchyChange::Type::Batch && deferred_.defer(name, change)) {
+            return;
+        }
         change.hierarchy = get_self<IHierarchy>();
         auto any = ext::create_any_ref(&change);
         const IAny* arg = any.get();
@@ -44,8 +51,31 @@ IObject::Ptr HierarchyImpl::lookup_parent(IObject* obj) const
 
 // Clears any existing tree, sets the new root. Veto via IHierarchyAware::on_hierarchy_joining.
 // Removed nodes get on_hierarchy_left; new root gets on_hierarchy_joined.
+HierarchyImpl::~HierarchyImpl()
+{
+    if (!inherited_.empty()) {
+        for (auto& [_, entry] : entries_) {
+            inherited_.left(entry.object);
+        }
+    }
+    size_t before = entries_.size();
+    entries_.clear();
+    track_entries(before);
+}
+
+void HierarchyImpl::track_entries(size_t before) const
+{
+    // Counts the value of each map node and the link the map keeps with it.
+    constexpr auto node_size = static_cast<ptrdiff_t>(sizeof(decltype(entries_)::value_type) + sizeof(void*));
+    auto delta = static_cast<ptrdiff_t>(entries_.size()) - static_cast<ptrdiff_t>(before);
+    if (delta) {
+        detail::track_memory(MemoryCategory::HierarchyEntries, delta * node_size, delta);
+    }
+}
+
 ReturnValue HierarchyImpl::set_root(const IObject::Ptr& root)
 {
+    VELK_TRACE_ZONE("Hierarchy::set_root");
     if (!root) {
         return ReturnValue::InvalidArgument;
     }
@@ -64,17 +94,23 @@ ReturnValue HierarchyImpl::set_root(const IObject::Ptr& root)
     {
         std::lock_guard lock(mutex_);
         collect_all(removed);
+        size_t before = entries_.size();
         root_ = root;
         entries_.clear();
         entries_[root.get()] = {root, nullptr, {}};
+        track_entries(before);
+        snapshots_.touch_all();
     }
 
     notify_left(removed);
+    inherited_.left(removed);
 
     if (auto* listener = interface_cast<IHierarchyAware>(root)) {
         listener->on_hierarchy_joined(self, {});
     }
 
+    inherited_.joined({}, root);
+
     fire_event("on_changed", {HierarchyChange::Type::SetRoot, {}, {}, root});
     return ReturnValue::Success;
 }
@@ -83,6 +119,7 @@ ReturnValue HierarchyImpl::set_root(const IObject::Ptr& root)
 // or child is already present. Veto via IHierarchyAware::on_hierarchy_joining.
 ReturnValue HierarchyImpl::add(const IObject::Ptr& parent, const IObject::Ptr& child)
 {
+    VELK_TRACE_ZONE("Hierarchy::add");
     if (!parent || !child) {
         return ReturnValue::InvalidArgument;
     }
@@ -108,12 +145,17 @@ ReturnValue HierarchyImpl::add(const IObject::Ptr& parent, const IObject::Ptr& c
         }
         pit->second.children.push_back(child);
         entries_[child.get()] = {child, parent.get(), {}};
+        track_entries(entries_.size() - 1);
+        snapshots_.touch(parent.get());
+        snapshots_.touch(child.get());
     }
 
     if (auto* listener = interface_cast<IHierarchyAware>(child)) {
         listener->on_hierarchy_joined(self, parent);
     }
 
+    inherited_.joined(parent, child);
+
     fire_event("on_changed", {HierarchyChange::Type::Add, {}, parent, child});
     return ReturnValue::Success;
 }
@@ -122,6 +164,7 @@ ReturnValue HierarchyImpl::add(const IObject::Ptr& parent, const IObject::Ptr& c
 // and veto logic as add(), but also rejects out-of-range indices.
 ReturnValue HierarchyImpl::insert(const IObject::Ptr& parent, size_t index, const IObject::Ptr& child)
 {
+    VELK_TRACE_ZONE("Hierarchy::insert");
     if (!parent || !child) {
         return ReturnValue::InvalidArgument;
     }
@@ -151,21 +194,109 @@ ReturnValue HierarchyImpl::insert(const IObject::Ptr& parent, size_t index, cons
         }
         children.insert(children.begin() + static_cast<ptrdiff_t>(index), child);
         entries_[child.get()] = {child, parent.get(), {}};
+        track_entries(entries_.size() - 1);
+        snapshots_.touch(parent.get());
+        snapshots_.touch(child.get());
     }
 
     if (auto* listener = interface_cast<IHierarchyAware>(child)) {
         listener->on_hierarchy_joined(self, parent);
     }
 
+    inherited_.joined(parent, child);
+
     fire_event("on_changed", {HierarchyChange::Type::Insert, {}, parent, child, {}, index});
     return ReturnValue::Success;
 }
 
+ReturnValue HierarchyImpl::add_children(const IObject::Ptr& parent, array_view<IObject::Ptr> children)
+{
+    return add_batch(parent, children, {});
+}
+
+ReturnValue HierarchyImpl::add_subtree(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                                       array_view<uint32_t> parents)
+{
+    return parents.size() == objects.size() ? add_batch(parent, objects, parents)
+                                            : ReturnValue::InvalidArgument;
+}
+
+// Vetoes, one lock acquisition and one AddBatch event pair for the whole batch.
+ReturnValue HierarchyImpl::add_batch(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                                     array_view<uint32_t> parents)
+{
+    VELK_TRACE_ZONE("Hierarchy::add_batch");
+    if (!parent || !is_valid_batch(objects, parents)) {
+        return ReturnValue::InvalidArgument;
+    }
+    if (objects.empty()) {
+        return ReturnValue::NothingToDo;
+    }
+
+    auto self = get_self<IHierarchy>();
+
+    if (!batch_joining(self, parent, objects, parents)) {
+        return ReturnValue::Refused;
+    }
+
+    fire_event("on_changing", {HierarchyChange::Type::AddBatch, {}, parent, {}, {}, {}, objects});
+
+    {
+        std::lock_guard lock(mutex_);
+        if (!insert_batch(parent, objects, parents)) {
+            return ReturnValue::InvalidArgument;
+        }
+    }
+
+    batch_joined(self, parent, objects, parents);
+    inherited_.joined(parent, objects, parents);
+
+    fire_event("on_changed", {HierarchyChange::Type::AddBatch, {}, parent, {}, {}, {}, objects});
+    return ReturnValue::Success;
+}
+
+// Inserts every entry before linking any, so an object already present (or listed twice) only
+// needs the new entries erased again.
+bool HierarchyImpl::insert_batch(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                                 array_view<uint32_t> parents)
+{
+    if (entries_.find(parent.get()) == entries_.end()) {
+        return false;
+    }
+    size_t before = entries_.size();
+    reserve_batch(entries_, objects.size());
+    std::vector<Entry*> added(objects.size());
+    for (size_t k = 0; k < objects.size(); ++k) {
+        auto* parentPtr = batch_parent(parent, objects, parents, k).get();
+        auto [it, inserted] = entries_.try_emplace(objects[k].get(), Entry{objects[k], parentPtr, {}});
+        if (!inserted) {
+            for (size_t j = 0; j < k; ++j) {
+                entries_.erase(objects[j].get());
+            }
+            return false;
+        }
+        added[k] = &it->second;
+    }
+    auto& outer = entries_.find(parent.get())->second;
+    if (parents.empty()) {
+        reserve_batch(outer.children, objects.size());
+    }
+    for (size_t k = 0; k < objects.size(); ++k) {
+        bool isOuter = parents.empty() || parents[k] == OUTER_PARENT;
+        (isOuter ? &outer : added[parents[k]])->children.push_back(objects[k]);
+        snapshots_.touch(objects[k].get());
+    }
+    snapshots_.touch(parent.get());
+    track_entries(before);
+    return true;
+}
+
 // Removes the object and its entire subtree. If the object is the root, the
 // whole tree is cleared. Detaches from parent's children list, then recursively
 // erases descendants. Veto only on the directly removed object, not descendants.
 ReturnValue HierarchyImpl::remove(const IObject::Ptr& object)
 {
+    VELK_TRACE_ZONE("Hierarchy::remove");
     if (!object) {
         return ReturnValue::InvalidArgument;
     }
@@ -197,10 +328,12 @@ ReturnValue HierarchyImpl::remove(const IObject::Ptr& object)
         if (it == entries_.end()) {
             return ReturnValue::NothingToDo;
         }
+        size_t before = entries_.size();
         if (object.get() == root_.get()) {
             collect_all(removed);
             root_ = {};
             entries_.clear();
+            snapshots_.touch_all();
         } else {
             auto* parentPtr = it->second.parent;
             if (parentPtr) {
@@ -216,10 +349,16 @@ ReturnValue HierarchyImpl::remove(const IObject::Ptr& object)
                 }
             }
             remove_recursive(object.get(), removed);
+            snapshots_.touch(parentPtr);
+            for (auto& obj : removed) {
+                snapshots_.touch(obj.get());
+            }
         }
+        track_entries(before);
     }
 
     notify_left(removed);
+    inherited_.left(removed);
 
     fire_event("on_changed", {HierarchyChange::Type::Remove, {}, parent_obj, object});
     return ReturnValue::Success;
@@ -230,6 +369,7 @@ ReturnValue HierarchyImpl::remove(const IObject::Ptr& object)
 // If old_child is root, root_ is updated. Veto via on_hierarchy_joining on new_child.
 ReturnValue HierarchyImpl::replace(const IObject::Ptr& old_child, const IObject::Ptr& new_child)
 {
+    VELK_TRACE_ZONE("Hierarchy::replace");
     if (!old_child || !new_child) {
         return ReturnValue::InvalidArgument;
     }
@@ -293,7 +433,11 @@ ReturnValue HierarchyImpl::replace(const IObject::Ptr& old_child, const IObject:
             if (cit != entries_.end()) {
                 cit->second.parent = new_child.get();
             }
+            snapshots_.touch(c.get());
         }
+        snapshots_.touch(parentPtr);
+        snapshots_.touch(old_child.get());
+        snapshots_.touch(new_child.get());
     }
 
     if (auto* listener = interface_cast<IHierarchyAware>(old_child)) {
@@ -304,6 +448,10 @@ ReturnValue HierarchyImpl::replace(const IObject::Ptr& old_child, const IObject:
         listener->on_hierarchy_joined(self, parent_obj);
     }
 
+    inherited_.left(old_child);
+    inherited_.joined(parent_obj, new_child);
+    inherited_.rebind_children(*this, new_child);
+
     fire_event("on_changed", {HierarchyChange::Type::Replace, {}, parent_obj, new_child, old_child});
     return ReturnValue::Success;
 }
@@ -311,17 +459,22 @@ ReturnValue HierarchyImpl::replace(const IObject::Ptr& old_child, const IObject:
 // Removes all nodes. No per-object veto; on_hierarchy_left fires for each.
 void HierarchyImpl::clear()
 {
+    VELK_TRACE_ZONE("Hierarchy::clear");
     fire_event("on_changing", {HierarchyChange::Type::Clear});
 
     std::vector<IObject::Ptr> removed;
     {
         std::lock_guard lock(mutex_);
         collect_all(removed);
+        size_t before = entries_.size();
         root_ = {};
         entries_.clear();
+        track_entries(before);
+        snapshots_.touch_all();
     }
 
     notify_left(removed);
+    inherited_.left(removed);
 
     fire_event("on_changed", {HierarchyChange::Type::Clear});
 }
@@ -376,6 +529,24 @@ vector<IObject::Ptr> HierarchyImpl::children_of(const IObject::Ptr& object) cons
     return result;
 }
 
+// Exposes the entry's child array, keeping the shared lock until the view is destroyed.
+ChildrenView HierarchyImpl::view_children(const IObject::Ptr& object) const
+{
+    if (!object) {
+        return {};
+    }
+    mutex_.lock_shared();
+    auto it = entries_.find(object.get());
+    if (it == entries_.end()) {
+        mutex_.unlock_shared();
+        return {};
+    }
+    ChildrenView::Layout layout;
+    layout.base = reinterpret_cast<const char*>(it->second.children.data());
+    layout.count = it->second.children.size();
+    return {layout, &mutex_, &unlock_children_view};
+}
+
 // Returns the child at the given index, or null if out of range.
 IObject::Ptr HierarchyImpl::child_at(const IObject::Ptr& object, size_t index) const
 {
@@ -409,15 +580,19 @@ void HierarchyImpl::for_each_child(const IObject::Ptr& object, void* context, Ch
         return;
     }
     // Snapshot children under shared lock, then iterate outside the lock
-    // so the visitor can safely mutate the hierarchy.
-    std::vector<IObject::Ptr> snapshot;
+    // so the visitor can safely mutate the hierarchy. Typical child counts fit on the stack.
+    small_vector<IObject::Ptr, 16> snapshot;
     {
         std::shared_lock lock(mutex_);
         auto it = entries_.find(object.get());
         if (it == entries_.end()) {
             return;
         }
-        snapshot.assign(it->second.children.begin(), it->second.children.end());
+        auto& children = it->second.children;
+        snapshot.reserve(children.size());
+        for (auto& c : children) {
+            snapshot.push_back(c);
+        }
     }
     for (auto& child : snapshot) {
         if (!visitor(context, child)) {
@@ -426,6 +601,258 @@ void HierarchyImpl::for_each_child(const IObject::Ptr& object, void* context, Ch
     }
 }
 
+void DeferredChanges::begin()
+{
+    std::lock_guard lock(mutex_);
+    ++depth_;
+}
+
+// on_changing is dropped: a batch only reports changes once they are all made.
+bool DeferredChanges::defer(string_view name, HierarchyChange& change)
+{
+    std::lock_guard lock(mutex_);
+    if (!depth_) {
+        return false;
+    }
+    if (name == "on_changed") {
+        children_.insert(children_.end(), change.children.begin(), change.children.end());
+        change.children = {nullptr, change.children.size()};
+        changes_.push_back(std::move(change));
+    }
+    return true;
+}
+
+ReturnValue DeferredChanges::end(std::vector<HierarchyChange>& changes, std::vector<IObject::Ptr>& children)
+{
+    {
+        std::lock_guard lock(mutex_);
+        if (!depth_) {
+            return ReturnValue::NothingToDo;
+        }
+        if (--depth_) {
+            return ReturnValue::Success;
+        }
+        changes.swap(changes_);
+        children.swap(children_);
+    }
+    size_t offset = 0;
+    for (auto& change : changes) {
+        change.children = {children.data() + offset, change.children.size()};
+        offset += change.children.size();
+    }
+    return ReturnValue::Success;
+}
+
+bool is_valid_batch(array_view<IObject::Ptr> objects, array_view<uint32_t> parents)
+{
+    for (size_t k = 0; k < objects.size(); ++k) {
+        if (!objects[k] || (!parents.empty() && parents[k] >= k && parents[k] != IHierarchy::OUTER_PARENT)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool batch_joining(const IHierarchy::Ptr& hierarchy, const IObject::Ptr& parent,
+                   array_view<IObject::Ptr> objects, array_view<uint32_t> parents)
+{
+    for (size_t k = 0; k < objects.size(); ++k) {
+        if (auto* listener = interface_cast<IHierarchyAware>(objects[k])) {
+            if (!listener->on_hierarchy_joining(hierarchy, batch_parent(parent, objects, parents, k))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void batch_joined(const IHierarchy::Ptr& hierarchy, const IObject::Ptr& parent,
+                  array_view<IObject::Ptr> objects, array_view<uint32_t> parents)
+{
+    for (size_t k = 0; k < objects.size(); ++k) {
+        if (auto* listener = interface_cast<IHierarchyAware>(objects[k])) {
+            listener->on_hierarchy_joined(hierarchy, batch_parent(parent, objects, parents, k));
+        }
+    }
+}
+
+void unlock_children_view(const void* mutex)
+{
+    static_cast<std::shared_mutex*>(const_cast<void*>(mutex))->unlock_shared();
+}
+
+void visit_in_order(const OrderedNode* nodes, size_t count, TraversalOrder order, void* context,
+                    IHierarchy::SubtreeVisitorFn visitor)
+{
+    if (order == TraversalOrder::PreOrder) {
+        for (size_t k = 0; k < count; ++k) {
+            if (nodes[k].object && !visitor(context, nodes[k].object, nodes[k].depth)) {
+                return;
+            }
+        }
+        return;
+    }
+    small_vector<size_t, 32> pending; // Ancestors of the current node, innermost last.
+    for (size_t k = 0; k <= count; ++k) {
+        while (!pending.empty() && (k == count || nodes[pending.back()].depth >= nodes[k].depth)) {
+            auto& node = nodes[pending.back()];
+            pending.pop_back();
+            if (node.object && !visitor(context, node.object, node.depth)) {
+                return;
+            }
+        }
+        if (k < count) {
+            pending.push_back(k);
+        }
+    }
+}
+
+namespace {
+
+// State shared by the tasks of visit_parallel().
+struct ParallelVisit
+{
+    const OrderedNode* nodes;
+    const std::pair<size_t, size_t>* subtrees; // Listing range of each subtree at the split depth.
+    const size_t* tasks;                       // First subtree of each task, then the subtree count.
+    TraversalOrder order;
+    void* context;
+    IHierarchy::SubtreeVisitorFn visitor;
+    std::atomic<bool> stopped{false};
+};
+
+// Forwards to the caller's visitor until one call returns false for any task.
+bool visit_unless_stopped(void* context, const IObject::Ptr& object, size_t depth)
+{
+    auto& visit = *static_cast<ParallelVisit*>(context);
+    if (visit.stopped.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (!visit.visitor(visit.context, object, depth)) {
+        visit.stopped.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void visit_task(void* context, size_t index)
+{
+    auto& visit = *static_cast<ParallelVisit*>(context);
+    for (size_t s = visit.tasks[index]; s < visit.tasks[index + 1]; ++s) {
+        auto [begin, end] = visit.subtrees[s];
+        visit_in_order(visit.nodes + begin, end - begin, visit.order, &visit, visit_unless_stopped);
+    }
+}
+
+} // namespace
+
+// Splits the listing into the objects above the split depth, listed again on their own so that
+// visit_in_order() can derive their post-order, and the contiguous subtrees below them.
+void visit_parallel(const OrderedNode* nodes, size_t count, TraversalOrder order, IExecutor* executor,
+                    const ParallelTraversalConfig& config, void* context,
+                    IHierarchy::SubtreeVisitorFn visitor)
+{
+    size_t concurrency = executor ? executor->get_concurrency() : 0;
+    if (concurrency < 2 || count < 2) {
+        visit_in_order(nodes, count, order, context, visitor);
+        return;
+    }
+    uint32_t split = nodes[0].depth + std::max<uint32_t>(config.splitDepth, 1);
+    std::vector<OrderedNode> top;
+    std::vector<std::pair<size_t, size_t>> subtrees;
+    for (size_t k = 0; k < count;) {
+        if (nodes[k].depth < split) {
+            top.push_back(nodes[k++]);
+            continue;
+        }
+        size_t end = k + 1;
+        while (end < count && nodes[end].depth > nodes[k].depth) {
+            ++end;
+        }
+        subtrees.emplace_back(k, end);
+        k = end;
+    }
+    size_t grain = std::max<size_t>(config.minTaskSize, (count - top.size()) / (4 * concurrency));
+    std::vector<size_t> tasks{0};
+    size_t size = 0;
+    for (size_t s = 0; s < subtrees.size(); ++s) {
+        size += subtrees[s].second - subtrees[s].first;
+        if (size >= grain || s + 1 == subtrees.size()) {
+            tasks.push_back(s + 1);
+            size = 0;
+        }
+    }
+
+    ParallelVisit visit{nodes, subtrees.data(), tasks.data(), order, context, visitor};
+    auto run_tasks = [&] {
+        size_t taskCount = tasks.size() - 1;
+        if (taskCount > 1) {
+            executor->parallel_for(taskCount, &visit, visit_task);
+        } else if (taskCount) {
+            visit_task(&visit, 0);
+        }
+    };
+    if (order == TraversalOrder::PreOrder) {
+        visit_in_order(top.data(), top.size(), order, &visit, visit_unless_stopped);
+        if (!visit.stopped.load(std::memory_order_relaxed)) {
+            run_tasks();
+        }
+    } else {
+        run_tasks();
+        if (!visit.stopped.load(std::memory_order_relaxed)) {
+            visit_in_order(top.data(), top.size(), order, &visit, visit_unless_stopped);
+        }
+    }
+}
+
+// Snapshots the subtree in pre-order under shared lock, then visits outside the lock like
+// for_each_child(). Each node costs a hash lookup; FlatHierarchyImpl caches the order instead.
+std::vector<OrderedNode> HierarchyImpl::list_subtree(const IObject::Ptr& object) const
+{
+    std::vector<OrderedNode> listing;
+    std::shared_lock lock(mutex_);
+    auto it = entries_.find(object.get());
+    if (it == entries_.end()) {
+        return listing;
+    }
+    uint32_t depth = 0;
+    for (auto* p = it->second.parent; p; p = entries_.at(p).parent) {
+        ++depth;
+    }
+    std::vector<std::pair<const Entry*, uint32_t>> stack{{&it->second, depth}};
+    while (!stack.empty()) {
+        auto [entry, d] = stack.back();
+        stack.pop_back();
+        listing.push_back({entry->object, d});
+        for (auto c = entry->children.end(); c != entry->children.begin();) {
+            --c;
+            stack.emplace_back(&entries_.at(c->get()), d + 1);
+        }
+    }
+    return listing;
+}
+
+void HierarchyImpl::traverse(const IObject::Ptr& object, TraversalOrder order, void* context,
+                             SubtreeVisitorFn visitor) const
+{
+    if (!object || !visitor) {
+        return;
+    }
+    auto snapshot = list_subtree(object);
+    visit_in_order(snapshot.data(), snapshot.size(), order, context, visitor);
+}
+
+void HierarchyImpl::traverse_parallel(const IObject::Ptr& object, TraversalOrder order, IExecutor* executor,
+                                      const ParallelTraversalConfig& config, void* context,
+                                      SubtreeVisitorFn visitor) const
+{
+    if (!object || !visitor) {
+        return;
+    }
+    auto snapshot = list_subtree(object);
+    visit_parallel(snapshot.data(), snapshot.size(), order, executor, config, context, visitor);
+}
+
 // O(1) hash lookup to check membership.
 bool HierarchyImpl::contains(const IObject::Ptr& object) const
 {
@@ -459,6 +886,81 @@ void HierarchyImpl::remove_recursive(IObject* obj, std::vector<IObject::Ptr>& re
     }
 }
 
+ReturnValue HierarchyImpl::add_inherited(string_view source, string_view target,
+                                         const IFunction::ConstPtr& combine)
+{
+    return inherited_.add(*this, source, target, combine);
+}
+
+ReturnValue HierarchyImpl::remove_inherited(string_view target)
+{
+    return inherited_.remove(*this, target);
+}
+
+void HierarchyImpl::read_snapshot_node(const Entry& entry, SnapshotNode& node) const
+{
+    node.object = entry.object;
+    if (entry.parent) {
+        auto pit = entries_.find(entry.parent);
+        if (pit != entries_.end()) {
+            node.parent = pit->second.object;
+        }
+    }
+    if (!entry.children.empty()) {
+        node.children =
+            std::make_shared<const std::vector<IObject::Ptr>>(entry.children.begin(), entry.children.end());
+    }
+}
+
+uint64_t HierarchyImpl::commit_snapshot()
+{
+    // Declared before the lock, so that the replaced snapshot is released after unlocking.
+    IHierarchySnapshot::Ptr replaced;
+    std::lock_guard lock(mutex_);
+    return snapshots_.commit(
+        root_, entries_.size(), this,
+        [](const void* self, const IObject* object, SnapshotNode& node) {
+            auto& h = *static_cast<const HierarchyImpl*>(self);
+            auto it = h.entries_.find(const_cast<IObject*>(object));
+            if (it == h.entries_.end()) {
+                return false;
+            }
+            h.read_snapshot_node(it->second, node);
+            return true;
+        },
+        [](const void* self, std::vector<SnapshotNode>& nodes) {
+            auto& h = *static_cast<const HierarchyImpl*>(self);
+            for (auto& [_, entry] : h.entries_) {
+                h.read_snapshot_node(entry, nodes.emplace_back());
+            }
+        },
+        replaced);
+}
+
+IHierarchySnapshot::Ptr HierarchyImpl::snapshot() const
+{
+    return snapshots_.acquire();
+}
+
+void HierarchyImpl::begin_batch()
+{
+    deferred_.begin();
+}
+
+ReturnValue HierarchyImpl::end_batch()
+{
+    VELK_TRACE_ZONE("Hierarchy::end_batch");
+    std::vector<HierarchyChange> changes;
+    std::vector<IObject::Ptr> children;
+    auto ret = deferred_.end(changes, children);
+    if (!changes.empty()) {
+        HierarchyChange batch{HierarchyChange::Type::Batch};
+        batch.changes = {changes.data(), changes.size()};
+        fire_event("on_changed", batch);
+    }
+    return ret;
+}
+
 // Notifies each removed object via IHierarchyAware::on_hierarchy_left.
 // Called outside the lock so callbacks can safely interact with the hierarchy.
 void HierarchyImpl::notify_left(const std::vector<IObject::Ptr>& removed)
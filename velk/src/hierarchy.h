@@ -1,15 +1,120 @@
 #ifndef HIERARCHY_H
 #define HIERARCHY_H
 
+#include "hierarchy_snapshot.h"
+#include "inherited_properties.h"
+
 #include <velk/ext/object.h>
 #include <velk/interface/intf_hierarchy.h>
+#include <velk/vector.h>
 
+#include <algorithm>
+#include <mutex>
 #include <shared_mutex>
 #include <unordered_map>
 #include <vector>
 
 namespace velk {
 
+/** @brief An object and its depth in a pre-order listing of a subtree. Null objects are skipped. */
+struct OrderedNode
+{
+    IObject::Ptr object;
+    uint32_t depth;
+};
+
+/** @brief Releases a std::shared_mutex read-locked for a ChildrenView. */
+void unlock_children_view(const void* mutex);
+
+/**
+ * @brief Returns true if @p objects are non-null and each of @p parents, if not empty, is
+ *        IHierarchy::OUTER_PARENT or lower than its own index.
+ */
+bool is_valid_batch(array_view<IObject::Ptr> objects, array_view<uint32_t> parents);
+
+/**
+ * @brief Reserves room for @p extra more elements in @p c. Grows at least geometrically, so
+ *        repeated small batches do not reallocate every time.
+ */
+template <class Container>
+void reserve_batch(Container& c, size_t extra)
+{
+    if (c.size() + extra > c.capacity()) {
+        c.reserve(std::max(c.size() + extra, c.capacity() * 2));
+    }
+}
+
+/** @brief reserve_batch() for an unordered_map. */
+template <class K, class V, class... Rest>
+void reserve_batch(std::unordered_map<K, V, Rest...>& map, size_t extra)
+{
+    auto needed = map.size() + extra;
+    if (static_cast<float>(needed) > static_cast<float>(map.bucket_count()) * map.max_load_factor()) {
+        map.reserve(std::max(needed, map.size() * 2));
+    }
+}
+
+/** @brief Returns the parent of the k-th object of a batch added under @p parent. */
+inline const IObject::Ptr& batch_parent(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                                        array_view<uint32_t> parents, size_t k)
+{
+    return parents.empty() || parents[k] == IHierarchy::OUTER_PARENT ? parent : objects[parents[k]];
+}
+
+/** @brief Asks each object of a batch that implements IHierarchyAware whether it may join. */
+bool batch_joining(const IHierarchy::Ptr& hierarchy, const IObject::Ptr& parent,
+                   array_view<IObject::Ptr> objects, array_view<uint32_t> parents);
+
+/** @brief Notifies each object of a batch that implements IHierarchyAware that it joined. */
+void batch_joined(const IHierarchy::Ptr& hierarchy, const IObject::Ptr& parent,
+                  array_view<IObject::Ptr> objects, array_view<uint32_t> parents);
+
+/**
+ * @brief Calls @p visitor for the @p count nodes listed in pre-order at @p nodes, in @p order.
+ *
+ * Post-order is derived from the depths: a node is visited once the walk reaches the next node
+ * that is not deeper than it.
+ */
+void visit_in_order(const OrderedNode* nodes, size_t count, TraversalOrder order, void* context,
+                    IHierarchy::SubtreeVisitorFn visitor);
+
+/**
+ * @brief Like visit_in_order(), but visits the subtrees at config.splitDepth below nodes[0] in
+ *        tasks of @p executor, see IHierarchy::traverse_parallel().
+ */
+void visit_parallel(const OrderedNode* nodes, size_t count, TraversalOrder order, IExecutor* executor,
+                    const ParallelTraversalConfig& config, void* context,
+                    IHierarchy::SubtreeVisitorFn visitor);
+
+/**
+ * @brief The changes of a hierarchy recorded between IHierarchy::begin_batch() and end_batch().
+ *
+ * Thread-safe. The recorded changes keep their objects alive until the batch is delivered.
+ */
+class DeferredChanges
+{
+public:
+    /** @brief Implements IHierarchy::begin_batch(). */
+    void begin();
+    /**
+     * @brief Moves @p change, fired as event @p name, into the open batch, if any.
+     * @return false if no batch is open and the caller should fire the event itself.
+     */
+    bool defer(string_view name, HierarchyChange& change);
+    /**
+     * @brief Ends a batch. Ending the outermost one moves the changes recorded to @p changes,
+     *        and the objects their children views point to to @p children.
+     * @return Success, or NothingToDo if no batch was open.
+     */
+    ReturnValue end(std::vector<HierarchyChange>& changes, std::vector<IObject::Ptr>& children);
+
+private:
+    std::mutex mutex_;                     // Guards the members below.
+    uint32_t depth_ = 0;                   // Number of open batches.
+    std::vector<HierarchyChange> changes_; // Recorded changes, with children views left null.
+    std::vector<IObject::Ptr> children_;   // The children of the recorded changes, in order.
+};
+
 /**
  * @brief Default implementation of IHierarchy backed by an unordered_map.
  *
@@ -21,9 +126,14 @@ class HierarchyImpl final : public ext::Object<HierarchyImpl, IHierarchy>
 public:
     VELK_CLASS_UID(ClassId::Hierarchy);
 
+    ~HierarchyImpl() override;
+
     ReturnValue set_root(const IObject::Ptr& root) override;
     ReturnValue add(const IObject::Ptr& parent, const IObject::Ptr& child) override;
     ReturnValue insert(const IObject::Ptr& parent, size_t index, const IObject::Ptr& child) override;
+    ReturnValue add_children(const IObject::Ptr& parent, array_view<IObject::Ptr> children) override;
+    ReturnValue add_subtree(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                            array_view<uint32_t> parents) override;
     ReturnValue remove(const IObject::Ptr& object) override;
     ReturnValue replace(const IObject::Ptr& old_child, const IObject::Ptr& new_child) override;
     void clear() override;
@@ -32,19 +142,35 @@ public:
     HierarchyNode node_of(const IObject::Ptr& object) const override;
     IObject::Ptr parent_of(const IObject::Ptr& object) const override;
     vector<IObject::Ptr> children_of(const IObject::Ptr& object) const override;
+    ChildrenView view_children(const IObject::Ptr& object) const override;
     IObject::Ptr child_at(const IObject::Ptr& object, size_t index) const override;
     size_t child_count(const IObject::Ptr& object) const override;
     void for_each_child(const IObject::Ptr& object, void* context, ChildVisitorFn visitor) const override;
+    void traverse(const IObject::Ptr& object, TraversalOrder order, void* context,
+                  SubtreeVisitorFn visitor) const override;
+    void traverse_parallel(const IObject::Ptr& object, TraversalOrder order, IExecutor* executor,
+                           const ParallelTraversalConfig& config, void* context,
+                           SubtreeVisitorFn visitor) const override;
     bool contains(const IObject::Ptr& object) const override;
     size_t size() const override;
+    ReturnValue add_inherited(string_view source, string_view target,
+                              const IFunction::ConstPtr& combine) override;
+    ReturnValue remove_inherited(string_view target) override;
+    uint64_t commit_snapshot() override;
+    IHierarchySnapshot::Ptr snapshot() const override;
+    void begin_batch() override;
+    ReturnValue end_batch() override;
 
 private:
+    // Number of children stored inside the entry; most nodes have only a few.
+    static constexpr size_t INLINE_CHILDREN = 4;
+
     // Per-node storage: owning pointer, raw parent backlink, ordered children.
     struct Entry
     {
-        IObject::Ptr object;                // Owning reference to the node's object.
-        IObject* parent = nullptr;          // Raw backlink (non-owning); null for root.
-        std::vector<IObject::Ptr> children; // Ordered child list.
+        IObject::Ptr object;                                  // Owning reference to the node's object.
+        IObject* parent = nullptr;                            // Raw backlink (non-owning); null for root.
+        small_vector<IObject::Ptr, INLINE_CHILDREN> children; // Ordered child list.
     };
 
     // Recursively erases obj and all descendants from entries_, collecting them in removed.
@@ -53,14 +179,31 @@ private:
     void collect_all(std::vector<IObject::Ptr>& out) const;
     // Returns the owning Ptr of obj's parent, or null. Caller must hold a lock.
     IObject::Ptr lookup_parent(IObject* obj) const;
+    // Reads entry into node, for the SnapshotPublisher. Caller must hold a lock.
+    void read_snapshot_node(const Entry& entry, SnapshotNode& node) const;
+    // Lists the subtree of object in pre-order under the shared lock; empty if not present.
+    std::vector<OrderedNode> list_subtree(const IObject::Ptr& object) const;
+    // Implements add_children() and add_subtree(); empty parents adds every object under parent.
+    ReturnValue add_batch(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                          array_view<uint32_t> parents);
+    // Adds the entries of a batch, or nothing if one is already present. Caller must hold the
+    // exclusive lock.
+    bool insert_batch(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                      array_view<uint32_t> parents);
     // Fires on_hierarchy_left on each removed object that implements IHierarchyAware.
     void notify_left(const std::vector<IObject::Ptr>& removed);
+    // Reports the entries added or removed since entries_ held `before` nodes as
+    // MemoryCategory::HierarchyEntries. Caller must hold the lock.
+    void track_entries(size_t before) const;
     // Fires on_changing or on_changed if handlers exist. Invoked outside the lock.
     void fire_event(string_view name, HierarchyChange change);
 
     mutable std::shared_mutex mutex_;             // Shared for reads, exclusive for mutations.
     IObject::Ptr root_;                           // Root object, or null if empty.
     std::unordered_map<IObject*, Entry> entries_; // All nodes keyed by raw pointer.
+    InheritedProperties inherited_;               // Properties bound to the parent's.
+    SnapshotPublisher snapshots_;                 // Snapshots published by commit_snapshot().
+    DeferredChanges deferred_;                    // Changes of the open batch.
 };
 
 } // namespace velk
@@ -0,0 +1,193 @@
+#include "hierarchy_snapshot.h"
+
+#include <algorithm>
+
+namespace velk {
+
+namespace {
+
+// Chunks of a snapshot built from scratch, and the bounds on the objects per chunk beyond which
+// the next commit builds from scratch rather than keep the chunk count.
+constexpr size_t MIN_CHUNKS = 16;
+constexpr size_t TARGET_PER_CHUNK = 64;
+constexpr size_t MAX_PER_CHUNK = 128;
+constexpr size_t MIN_PER_CHUNK = 16;
+
+const IObject::Ptr null_object;
+
+bool by_address(const SnapshotNode& node, const IObject* object)
+{
+    return node.object.get() < object;
+}
+
+void sort_by_address(std::vector<SnapshotNode>& nodes)
+{
+    std::sort(nodes.begin(), nodes.end(), [](const SnapshotNode& a, const SnapshotNode& b) {
+        return a.object.get() < b.object.get();
+    });
+}
+
+} // namespace
+
+size_t HierarchySnapshotImpl::chunk_of(const IObject* object) const
+{
+    // Fibonacci hashing, as in PointerIndex.
+    uint64_t hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(object)) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(hash >> shift_);
+}
+
+const SnapshotNode* HierarchySnapshotImpl::find(const IObject* object) const
+{
+    if (!object || chunks_.empty()) {
+        return nullptr;
+    }
+    auto& nodes = chunks_[chunk_of(object)]->nodes;
+    auto it = std::lower_bound(nodes.begin(), nodes.end(), object, by_address);
+    return it != nodes.end() && it->object.get() == object ? &*it : nullptr;
+}
+
+const IObject::Ptr& HierarchySnapshotImpl::parent_of(const IObject::Ptr& object) const
+{
+    auto* node = find(object.get());
+    return node ? node->parent : null_object;
+}
+
+array_view<IObject::Ptr> HierarchySnapshotImpl::children_of(const IObject::Ptr& object) const
+{
+    auto* node = find(object.get());
+    if (!node || !node->children) {
+        return {};
+    }
+    return {node->children->data(), node->children->size()};
+}
+
+size_t HierarchySnapshotImpl::child_count(const IObject::Ptr& object) const
+{
+    auto* node = find(object.get());
+    return node && node->children ? node->children->size() : 0;
+}
+
+bool HierarchySnapshotImpl::contains(const IObject::Ptr& object) const
+{
+    return find(object.get()) != nullptr;
+}
+
+SnapshotPublisher::~SnapshotPublisher()
+{
+    published_.store(nullptr);
+}
+
+void SnapshotPublisher::build(HierarchySnapshotImpl& snap, std::vector<SnapshotNode>& nodes)
+{
+    size_t count = MIN_CHUNKS;
+    unsigned shift = 60;
+    while (count * TARGET_PER_CHUNK < nodes.size()) {
+        count *= 2;
+        --shift;
+    }
+    snap.shift_ = shift;
+    std::vector<std::shared_ptr<SnapshotChunk>> chunks(count);
+    for (auto& chunk : chunks) {
+        chunk = std::make_shared<SnapshotChunk>();
+    }
+    for (auto& node : nodes) {
+        chunks[snap.chunk_of(node.object.get())]->nodes.push_back(std::move(node));
+    }
+    snap.chunks_.reserve(count);
+    for (auto& chunk : chunks) {
+        sort_by_address(chunk->nodes);
+        snap.chunks_.push_back(std::move(chunk));
+    }
+}
+
+bool SnapshotPublisher::update(HierarchySnapshotImpl& snap, const void* source, ReadNodeFn read)
+{
+    auto& previous = static_cast<const HierarchySnapshotImpl&>(*current_);
+    size_t count = previous.chunks_.size();
+    if (touched_.size() > previous.size_ / 4 || snap.size_ > count * MAX_PER_CHUNK ||
+        (count > MIN_CHUNKS && snap.size_ < count * MIN_PER_CHUNK)) {
+        return false;
+    }
+    snap.shift_ = previous.shift_;
+    snap.chunks_ = previous.chunks_;
+
+    // Group the touched objects by chunk, then rebuild each chunk that holds any of them.
+    std::sort(touched_.begin(), touched_.end(), [&](const IObject* a, const IObject* b) {
+        auto ca = snap.chunk_of(a);
+        auto cb = snap.chunk_of(b);
+        return ca != cb ? ca < cb : a < b;
+    });
+    touched_.erase(std::unique(touched_.begin(), touched_.end()), touched_.end());
+    for (auto first = touched_.begin(); first != touched_.end();) {
+        size_t index = snap.chunk_of(*first);
+        auto last = std::find_if(first, touched_.end(), [&](auto* o) { return snap.chunk_of(o) != index; });
+        auto chunk = std::make_shared<SnapshotChunk>();
+        auto& old_nodes = snap.chunks_[index]->nodes;
+        chunk->nodes.reserve(old_nodes.size() + (last - first));
+        for (auto& node : old_nodes) {
+            if (!std::binary_search(first, last, node.object.get())) {
+                chunk->nodes.push_back(node);
+            }
+        }
+        for (auto it = first; it != last; ++it) {
+            SnapshotNode node;
+            if (read(source, *it, node)) {
+                chunk->nodes.push_back(std::move(node));
+            }
+        }
+        sort_by_address(chunk->nodes);
+        snap.chunks_[index] = std::move(chunk);
+        first = last;
+    }
+    return true;
+}
+
+uint64_t SnapshotPublisher::commit(const IObject::Ptr& root, size_t size, const void* source,
+                                   ReadNodeFn read, ReadAllFn read_all, IHierarchySnapshot::Ptr& replaced)
+{
+    auto* previous = static_cast<const HierarchySnapshotImpl*>(current_.get());
+    if (previous && !all_ && touched_.empty()) {
+        return previous->version_;
+    }
+    auto ptr = ext::make_object<HierarchySnapshotImpl, IHierarchySnapshot>();
+    auto& snap = static_cast<HierarchySnapshotImpl&>(*ptr);
+    snap.version_ = previous ? previous->version_ + 1 : 1;
+    snap.root_ = root;
+    snap.size_ = size;
+    if (!previous || all_ || !update(snap, source, read)) {
+        std::vector<SnapshotNode> nodes;
+        nodes.reserve(size);
+        read_all(source, nodes);
+        snap.chunks_.clear();
+        build(snap, nodes);
+    }
+    tracking_ = true;
+    all_ = false;
+    touched_.clear();
+    touch_limit_ = size / 4 + MIN_CHUNKS;
+
+    // A reader that loaded the previous snapshot before this store holds a ReclaimScope, so the
+    // release of the caller's reference only retires it until the reader has added its own.
+    published_.store(&snap);
+    replaced = std::move(current_);
+    current_ = std::move(ptr);
+    return snap.version_;
+}
+
+IHierarchySnapshot::Ptr SnapshotPublisher::acquire() const
+{
+    ReclaimScope scope;
+    for (;;) {
+        auto* snap = published_.load();
+        if (!snap) {
+            return {};
+        }
+        // Fails only if the snapshot was replaced and released since the load; retry the next.
+        auto* block = detail::BlockAccess::get(*snap);
+        if (block->try_add_ref()) {
+            return IHierarchySnapshot::Ptr(snap, block, adopt_ref);
+        }
+    }
+}
+
+} // namespace velk
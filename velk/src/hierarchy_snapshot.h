@@ -0,0 +1,127 @@
+#ifndef HIERARCHY_SNAPSHOT_H
+#define HIERARCHY_SNAPSHOT_H
+
+#include <velk/ext/core_object.h>
+#include <velk/interface/intf_hierarchy.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace velk {
+
+/** @brief One object of a hierarchy snapshot. */
+struct SnapshotNode
+{
+    IObject::Ptr object;                                       // The object itself.
+    IObject::Ptr parent;                                       // Null for the root.
+    std::shared_ptr<const std::vector<IObject::Ptr>> children; // Ordered children; null for leaves.
+};
+
+/** @brief A part of a snapshot, shared by the snapshots in which none of its objects changed. */
+struct SnapshotChunk
+{
+    std::vector<SnapshotNode> nodes; // Sorted by object address.
+};
+
+/**
+ * @brief IHierarchySnapshot implementation: the objects hashed by address into chunks.
+ *
+ * Lookups hash the object to its chunk and binary search it. A snapshot published after a few
+ * changes copies only the chunks holding the changed objects and shares the others with the
+ * previous snapshot.
+ */
+class HierarchySnapshotImpl final : public ext::ObjectCore<HierarchySnapshotImpl, IHierarchySnapshot>
+{
+public:
+    uint64_t version() const override { return version_; }
+    const IObject::Ptr& root() const override { return root_; }
+    const IObject::Ptr& parent_of(const IObject::Ptr& object) const override;
+    array_view<IObject::Ptr> children_of(const IObject::Ptr& object) const override;
+    size_t child_count(const IObject::Ptr& object) const override;
+    bool contains(const IObject::Ptr& object) const override;
+    size_t size() const override { return size_; }
+
+private:
+    friend class SnapshotPublisher;
+
+    // Returns the chunk that holds object if present.
+    size_t chunk_of(const IObject* object) const;
+    // Returns the node of object, or null.
+    const SnapshotNode* find(const IObject* object) const;
+
+    uint64_t version_ = 0;
+    IObject::Ptr root_;
+    size_t size_ = 0;
+    unsigned shift_ = 64;                                      // 64 - log2(chunks_.size()).
+    std::vector<std::shared_ptr<const SnapshotChunk>> chunks_; // Power-of-two count.
+};
+
+/**
+ * @brief Publishes the snapshots of a hierarchy and hands them to readers without locking.
+ *
+ * The hierarchy calls touch() for each object whose parent or children change, under its
+ * exclusive lock. commit() then rereads only the touched objects. Nothing is tracked before the
+ * first commit, so a hierarchy that never publishes a snapshot pays a branch per mutation.
+ *
+ * Readers load the published snapshot inside a ReclaimScope, which keeps a snapshot replaced
+ * meanwhile alive until they have added their reference.
+ */
+class SnapshotPublisher
+{
+public:
+    // Reads object from the hierarchy at source into node. Returns false if not present.
+    using ReadNodeFn = bool (*)(const void* source, const IObject* object, SnapshotNode& node);
+    // Reads every object of the hierarchy at source into nodes, in any order.
+    using ReadAllFn = void (*)(const void* source, std::vector<SnapshotNode>& nodes);
+
+    ~SnapshotPublisher();
+
+    /** @brief Records that the parent or children of @p object changed. */
+    void touch(const IObject* object)
+    {
+        if (tracking_ && !all_ && object) {
+            touched_.push_back(object);
+            if (touched_.size() > touch_limit_) {
+                touch_all();
+            }
+        }
+    }
+    /** @brief Records that the whole hierarchy changed, e.g. on clear(). */
+    void touch_all()
+    {
+        all_ = tracking_;
+        touched_.clear();
+    }
+
+    /**
+     * @brief Implements IHierarchy::commit_snapshot() for a hierarchy of @p size objects.
+     *
+     * Must be called under the hierarchy's exclusive lock. The replaced snapshot is moved to
+     * @p replaced for the caller to release outside the lock.
+     */
+    uint64_t commit(const IObject::Ptr& root, size_t size, const void* source, ReadNodeFn read,
+                    ReadAllFn read_all, IHierarchySnapshot::Ptr& replaced);
+
+    /** @brief Implements IHierarchy::snapshot(). Lock-free. */
+    IHierarchySnapshot::Ptr acquire() const;
+
+private:
+    // Builds all chunks of snap from nodes.
+    static void build(HierarchySnapshotImpl& snap, std::vector<SnapshotNode>& nodes);
+    // Copies the chunks of the current snapshot into snap, rereading the touched objects.
+    // Returns false if too much changed, so that build() is cheaper.
+    bool update(HierarchySnapshotImpl& snap, const void* source, ReadNodeFn read);
+
+    bool tracking_ = false;                                  // Set by the first commit().
+    bool all_ = false;                                       // Everything changed.
+    std::vector<const IObject*> touched_;                    // Changed since the last commit().
+    size_t touch_limit_ = 0;                                 // Touches before touch_all().
+    IHierarchySnapshot::Ptr current_;                        // Owning reference to published_.
+    std::atomic<HierarchySnapshotImpl*> published_{nullptr}; // Loaded by readers.
+};
+
+} // namespace velk
+
+#endif // HIERARCHY_SNAPSHOT_H
@@ -0,0 +1,51 @@
+#ifndef VELK_SRC_HIVE_DIRTY_BIT_H
+#define VELK_SRC_HIVE_DIRTY_BIT_H
+
+#include <velk/memory.h>
+#include <velk/uid.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace velk {
+
+/**
+ * @brief One bit of a hive dirty bitmask (see IObjectHive::add_dirty_tracking()).
+ *
+ * A property of a hive object constructed with ObjectFlags::DirtyTracking holds the bit
+ * of its object and interface, and sets it whenever it notifies a change. The bit is
+ * empty for all other properties.
+ */
+struct DirtyBit
+{
+    std::atomic<uint64_t>* word{};         ///< Bitmask word in the object's page, null if not tracked.
+    std::atomic<uint64_t>* index_word{};   ///< Word of the bitmask read by indexes, null if not indexed.
+    std::atomic<uint64_t>* journal_word{}; ///< Word of the change journal bitmask, null if not journaled.
+    uint64_t mask{};                       ///< The object's bit in all words.
+
+    /** @brief Marks the object dirty. */
+    void mark() const
+    {
+        if (word) {
+            word->fetch_or(mask, std::memory_order_release);
+        }
+        if (index_word) {
+            index_word->fetch_or(mask, std::memory_order_release);
+        }
+        if (journal_word) {
+            journal_word->fetch_or(mask, std::memory_order_release);
+        }
+    }
+};
+
+/**
+ * @brief Returns the dirty bit of a hive-managed object for @p interfaceUid.
+ * @param block The object's control block.
+ * @param interfaceUid UID of the interface.
+ * @return The bit, or an empty bit if the hive does not track the interface.
+ */
+DirtyBit hive_dirty_bit(const control_block* block, Uid interfaceUid);
+
+} // namespace velk
+
+#endif // VELK_SRC_HIVE_DIRTY_BIT_H
@@ -0,0 +1,73 @@
+#include "hive_index.h"
+
+namespace velk {
+
+void HiveIndex::update(uint64_t position, const void* state)
+{
+    uint64_t key = encode_hive_index_key(static_cast<const char*>(state) + desc_.field_offset,
+                                         desc_.key_type, desc_.field_size);
+    auto it = entries_.find(position);
+    if (it != entries_.end()) {
+        if (it->second.key == key) {
+            return;
+        }
+        remove(position, it->second);
+    }
+    insert(position, key);
+}
+
+void HiveIndex::erase(uint64_t position)
+{
+    auto it = entries_.find(position);
+    if (it != entries_.end()) {
+        remove(position, it->second);
+        entries_.erase(position);
+    }
+}
+
+void HiveIndex::find(uint64_t first, uint64_t last, std::vector<uint64_t>& out) const
+{
+    if (desc_.index_type == HiveIndexType::Hash) {
+        auto it = first == last ? buckets_.find(first) : buckets_.end();
+        if (it != buckets_.end()) {
+            out.insert(out.end(), it->second.begin(), it->second.end());
+        }
+        return;
+    }
+    for (auto it = sorted_.lower_bound({first, 0}); it != sorted_.end() && it->first <= last; ++it) {
+        out.push_back(it->second);
+    }
+}
+
+void HiveIndex::insert(uint64_t position, uint64_t key)
+{
+    Entry entry{key, 0};
+    if (desc_.index_type == HiveIndexType::Hash) {
+        auto& bucket = buckets_[key];
+        entry.bucket_index = bucket.size();
+        bucket.push_back(position);
+    } else {
+        sorted_.emplace(key, position);
+    }
+    entries_[position] = entry;
+}
+
+void HiveIndex::remove(uint64_t position, const Entry& entry)
+{
+    if (desc_.index_type == HiveIndexType::Sorted) {
+        sorted_.erase({entry.key, position});
+        return;
+    }
+    // Swap-remove keeps the bucket dense: the last position takes over the freed index.
+    auto it = buckets_.find(entry.key);
+    auto& bucket = it->second;
+    uint64_t moved = bucket.back();
+    bucket[entry.bucket_index] = moved;
+    entries_[moved].bucket_index = entry.bucket_index;
+    bucket.pop_back();
+    if (bucket.empty()) {
+        buckets_.erase(it);
+    }
+}
+
+} // namespace velk
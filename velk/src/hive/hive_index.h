@@ -0,0 +1,57 @@
+#ifndef VELK_SRC_HIVE_INDEX_H
+#define VELK_SRC_HIVE_INDEX_H
+
+#include <velk/interface/hive/intf_hive.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief Index of the objects of an ObjectHive by one State field (see IObjectHive::add_index()).
+ *
+ * Objects are identified by their position in the hive: the page id and slot index of a
+ * HiveHandle without the generation. The owning hive feeds the index the States of changed
+ * objects and the positions of removed ones.
+ */
+class HiveIndex
+{
+public:
+    explicit HiveIndex(const HiveIndexDesc& desc) : desc_(desc) {}
+
+    /** @brief Returns the indexed field and the type of the index. */
+    const HiveIndexDesc& desc() const { return desc_; }
+
+    /** @brief Indexes the object at @p position under the field value in @p state. */
+    void update(uint64_t position, const void* state);
+
+    /** @brief Drops the object at @p position from the index, if indexed. */
+    void erase(uint64_t position);
+
+    /** @brief Appends the positions of the objects with keys in [@p first, @p last] to @p out. */
+    void find(uint64_t first, uint64_t last, std::vector<uint64_t>& out) const;
+
+private:
+    struct Entry
+    {
+        uint64_t key;        ///< Encoded field value.
+        size_t bucket_index; ///< Index of the position in its Hash bucket.
+    };
+
+    void insert(uint64_t position, uint64_t key);
+    void remove(uint64_t position, const Entry& entry);
+
+    HiveIndexDesc desc_;
+    std::unordered_map<uint64_t, Entry> entries_;                 ///< Key of each indexed position.
+    std::unordered_map<uint64_t, std::vector<uint64_t>> buckets_; ///< Hash: positions by key.
+    std::set<std::pair<uint64_t, uint64_t>> sorted_;              ///< Sorted: (key, position) pairs.
+};
+
+} // namespace velk
+
+#endif // VELK_SRC_HIVE_INDEX_H
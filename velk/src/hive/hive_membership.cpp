@@ -0,0 +1,108 @@
+#include "hive_membership.h"
+
+#include <velk/api/callback.h>
+#include <velk/api/velk.h>
+#include <velk/ext/any.h>
+
+namespace velk {
+
+IEvent::Ptr HiveMembership::event(const IObjectHive::WeakPtr& hive)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!event_) {
+        hive_ = hive;
+        event_ = instance().create<IEvent>(ClassId::Event);
+        // The hive owns this object, so it is alive for as long as the hive is.
+        deliver_fn_ = Callback([this, weak = hive](FnArgs) -> ReturnValue {
+            if (auto alive = weak.lock()) {
+                deliver();
+            }
+            return ReturnValue::Success;
+        });
+        observed_.store(true, std::memory_order_relaxed);
+    }
+    return event_;
+}
+
+void HiveMembership::added(const IObject::Ptr* objects, size_t count)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!event_) {
+        return;
+    }
+    added_.insert(added_.end(), objects, objects + count);
+    queue_locked();
+}
+
+void HiveMembership::removed(IObject::Ptr object)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!event_) {
+        return;
+    }
+    removed_.push_back(std::move(object));
+    queue_locked();
+}
+
+void HiveMembership::removed(std::vector<IObject::Ptr>&& objects)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!event_ || objects.empty()) {
+        return;
+    }
+    if (removed_.empty()) {
+        removed_.swap(objects);
+    } else {
+        removed_.insert(removed_.end(),
+                        std::make_move_iterator(objects.begin()),
+                        std::make_move_iterator(objects.end()));
+    }
+    queue_locked();
+}
+
+void HiveMembership::queue_locked()
+{
+    if (!queued_) {
+        queued_ = true;
+        instance().queue_deferred_call(deliver_fn_, {});
+    }
+}
+
+void HiveMembership::deliver()
+{
+    std::vector<IObject::Ptr> added;
+    std::vector<IObject::Ptr> removed;
+    IEvent::Ptr event;
+    IObjectHive::Ptr hive;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        added.swap(added_);
+        removed.swap(removed_);
+        queued_ = false;
+        event = event_;
+        hive = hive_.lock();
+    }
+    if (!event || !hive || (added.empty() && removed.empty()) || !event->has_handlers()) {
+        return;
+    }
+    HiveMembershipChange change{hive.get(), {added.data(), added.size()}, {removed.data(), removed.size()}};
+    auto any = ext::create_any_ref(&change);
+    const IAny* arg = any.get();
+    event->invoke(FnArgs{&arg, 1});
+    // The removed objects are released on return, outside the lock.
+}
+
+void HiveMembership::reset()
+{
+    std::vector<IObject::Ptr> added;
+    std::vector<IObject::Ptr> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        observed_.store(false, std::memory_order_relaxed);
+        event_ = {};
+        added.swap(added_);
+        removed.swap(removed_);
+    }
+}
+
+} // namespace velk
@@ -0,0 +1,62 @@
+#ifndef VELK_SRC_HIVE_HIVE_MEMBERSHIP_H
+#define VELK_SRC_HIVE_HIVE_MEMBERSHIP_H
+
+#include <velk/interface/hive/intf_hive.h>
+#include <velk/interface/intf_event.h>
+#include <velk/interface/intf_function.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief Accumulates the objects entering and leaving a hive for IObjectHive::on_membership_changed().
+ *
+ * Nothing is recorded until the event is created. The first change after a delivery queues
+ * a deferred call, which fires the event once with everything recorded up to that update().
+ */
+class HiveMembership
+{
+public:
+    ~HiveMembership() { reset(); }
+
+    /** @brief Returns the event, creating it and starting to record on first access. */
+    IEvent::Ptr event(const IObjectHive::WeakPtr& hive);
+
+    /** @brief True if changes are recorded. */
+    bool observed() const { return observed_.load(std::memory_order_relaxed); }
+
+    /** @brief Records @p count added objects. */
+    void added(const IObject::Ptr* objects, size_t count);
+
+    /** @brief Records a removed object, keeping it alive until the delivery. */
+    void removed(IObject::Ptr object);
+
+    /** @brief Records removed objects, keeping them alive until the delivery. */
+    void removed(std::vector<IObject::Ptr>&& objects);
+
+    /** @brief Fires the event with the changes recorded since the previous delivery. */
+    void deliver();
+
+    /** @brief Stops recording and releases the recorded objects. */
+    void reset();
+
+private:
+    /** @brief Queues the delivery if none is queued. Called with mutex_ held. */
+    void queue_locked();
+
+    std::mutex mutex_;
+    std::atomic<bool> observed_{false};
+    bool queued_{false};
+    IObjectHive::WeakPtr hive_;
+    IEvent::Ptr event_;
+    IFunction::Ptr deliver_fn_;
+    std::vector<IObject::Ptr> added_;
+    std::vector<IObject::Ptr> removed_;
+};
+
+} // namespace velk
+
+#endif // VELK_SRC_HIVE_HIVE_MEMBERSHIP_H
@@ -0,0 +1,103 @@
+#include "hive_snapshot_mapping.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace velk {
+
+HiveSnapshotMapping::~HiveSnapshotMapping()
+{
+    if (!data_) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    munmap(data_, size_);
+#endif
+}
+
+void* HiveSnapshotMapping::allocate_page(size_t, size_t)
+{
+    // The mapping only backs the pages of the snapshot.
+    return nullptr;
+}
+
+void HiveSnapshotMapping::free_page(void*, size_t)
+{
+    // Adopted pages are unmapped together with the mapping.
+}
+
+ReturnValue HiveSnapshotMapping::open(const char* path)
+{
+    if (!path) {
+        return ReturnValue::InvalidArgument;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (data_) {
+        return ReturnValue::Fail;
+    }
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return ReturnValue::Fail;
+    }
+    LARGE_INTEGER file_size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    }
+    CloseHandle(file);
+    if (!mapping) {
+        return ReturnValue::Fail;
+    }
+    // The view keeps the mapping object alive after its handle is closed.
+    void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) {
+        return ReturnValue::Fail;
+    }
+    size_t size = static_cast<size_t>(file_size.QuadPart);
+#else
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return ReturnValue::Fail;
+    }
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    // The mapping keeps the file referenced after the descriptor is closed.
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return ReturnValue::Fail;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+#endif
+    data_ = data;
+    size_ = size;
+    return ReturnValue::Success;
+}
+
+void* HiveSnapshotMapping::get_data() const
+{
+    return data_;
+}
+
+size_t HiveSnapshotMapping::get_size() const
+{
+    return size_;
+}
+
+} // namespace velk
@@ -0,0 +1,43 @@
+#ifndef VELK_SRC_HIVE_SNAPSHOT_MAPPING_H
+#define VELK_SRC_HIVE_SNAPSHOT_MAPPING_H
+
+#include <velk/ext/core_object.h>
+#include <velk/interface/hive/hive_snapshot.h>
+
+#include <mutex>
+
+namespace velk {
+
+/**
+ * @brief IHiveSnapshotMapping that maps a file privately, copy-on-write.
+ *
+ * Uses mmap(MAP_PRIVATE) on POSIX systems and a FILE_MAP_COPY view on Windows.
+ * The file is unmapped when the object is destroyed, i.e. after every adopted page
+ * has released its reference.
+ */
+class HiveSnapshotMapping final : public ext::ObjectCore<HiveSnapshotMapping, IHiveSnapshotMapping>
+{
+public:
+    VELK_CLASS_UID(ClassId::HiveSnapshotMapping);
+
+    HiveSnapshotMapping() = default;
+    ~HiveSnapshotMapping() override;
+
+    // IHivePageSource overrides
+    void* allocate_page(size_t size, size_t alignment) override;
+    void free_page(void* page, size_t size) override;
+
+    // IHiveSnapshotMapping overrides
+    ReturnValue open(const char* path) override;
+    void* get_data() const override;
+    size_t get_size() const override;
+
+private:
+    std::mutex mutex_; ///< Serializes open().
+    void* data_{nullptr};
+    size_t size_{0};
+};
+
+} // namespace velk
+
+#endif // VELK_SRC_HIVE_SNAPSHOT_MAPPING_H
@@ -1,6 +1,7 @@
 #include "hive_store.h"
 
 #include "object_hive.h"
+#include "partitioned_object_hive.h"
 #include "raw_hive.h"
 
 #include <velk/api/velk.h>
@@ -9,12 +10,46 @@
 
 namespace velk {
 
+HiveStore::HiveStore()
+{
+    tables_.push_back(std::make_unique<HiveTable>());
+    table_.store(tables_.back().get(), std::memory_order_release);
+}
+
+IHive::Ptr HiveStore::find_entry(Uid uid) const
+{
+    auto& hives = table();
+    HiveEntry key{uid, {}};
+    auto it = std::lower_bound(hives.begin(), hives.end(), key);
+    if (it != hives.end() && it->uid == uid) {
+        return it->hive;
+    }
+    return {};
+}
+
+void HiveStore::publish(Uid uid, const IHive::Ptr& hive)
+{
+    auto& current = table();
+    auto next = std::make_unique<HiveTable>();
+    next->reserve(current.size() + 1);
+    HiveEntry entry{uid, hive};
+    auto it = std::lower_bound(current.begin(), current.end(), entry);
+    next->insert(next->end(), current.begin(), it);
+    next->push_back(entry);
+    next->insert(next->end(), it, current.end());
+    table_.store(next.get(), std::memory_order_release);
+    tables_.push_back(std::move(next));
+}
+
 IObjectHive::Ptr HiveStore::get_hive(Uid classUid)
 {
-    HiveEntry key{classUid, {}};
-    auto it = std::lower_bound(hives_.begin(), hives_.end(), key);
-    if (it != hives_.end() && it->uid == classUid) {
-        return interface_pointer_cast<IObjectHive>(it->hive);
+    return get_partitioned_hive(classUid, 1);
+}
+
+IObjectHive::Ptr HiveStore::get_partitioned_hive(Uid classUid, size_t partitions)
+{
+    if (auto existing = find_entry(classUid)) {
+        return interface_pointer_cast<IObjectHive>(existing);
     }
 
     auto& velk = instance();
@@ -24,62 +59,69 @@ IObjectHive::Ptr HiveStore::get_hive(Uid classUid)
         return {};
     }
 
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    // Another thread may have created the hive since the lock-free lookup.
+    if (auto existing = find_entry(classUid)) {
+        return interface_pointer_cast<IObjectHive>(existing);
+    }
+
     // Create and initialize a new hive for this class UID.
-    auto hive_obj = ext::make_object<ObjectHive>();
-    auto* hive = static_cast<ObjectHive*>(hive_obj.get());
-    hive->init(classUid);
+    IObject::Ptr hive_obj;
+    if (partitions > 1) {
+        hive_obj = ext::make_object<PartitionedObjectHive>();
+        static_cast<PartitionedObjectHive*>(hive_obj.get())->init(classUid, partitions, page_source_);
+    } else {
+        hive_obj = ext::make_object<ObjectHive>();
+        auto* hive = static_cast<ObjectHive*>(hive_obj.get());
+        hive->init(classUid);
+        hive->set_page_source(page_source_);
+    }
     auto hive_ptr = interface_pointer_cast<IHive>(hive_obj);
 
-    hives_.insert(it, HiveEntry{classUid, hive_ptr});
+    publish(classUid, hive_ptr);
     return interface_pointer_cast<IObjectHive>(hive_ptr);
 }
 
 IObjectHive::Ptr HiveStore::find_hive(Uid classUid) const
 {
-    HiveEntry key{classUid, {}};
-    auto it = std::lower_bound(hives_.begin(), hives_.end(), key);
-    if (it != hives_.end() && it->uid == classUid) {
-        return interface_pointer_cast<IObjectHive>(it->hive);
-    }
-    return {};
+    return interface_pointer_cast<IObjectHive>(find_entry(classUid));
 }
 
 IRawHive::Ptr HiveStore::get_raw_hive(Uid uid, size_t element_size, size_t element_align)
 {
-    HiveEntry key{uid, {}};
-    auto it = std::lower_bound(hives_.begin(), hives_.end(), key);
-    if (it != hives_.end() && it->uid == uid) {
-        return interface_pointer_cast<IRawHive>(it->hive);
+    if (auto existing = find_entry(uid)) {
+        return interface_pointer_cast<IRawHive>(existing);
+    }
+
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (auto existing = find_entry(uid)) {
+        return interface_pointer_cast<IRawHive>(existing);
     }
 
     // Create and initialize a new raw hive.
     auto hive_obj = ext::make_object<RawHiveImpl>();
     auto* hive = static_cast<RawHiveImpl*>(hive_obj.get());
     hive->init(uid, element_size, element_align);
+    hive->set_page_source(page_source_);
     auto hive_ptr = interface_pointer_cast<IHive>(hive_obj);
 
-    hives_.insert(it, HiveEntry{uid, hive_ptr});
+    publish(uid, hive_ptr);
     return interface_pointer_cast<IRawHive>(hive_ptr);
 }
 
 IRawHive::Ptr HiveStore::find_raw_hive(Uid uid) const
 {
-    HiveEntry key{uid, {}};
-    auto it = std::lower_bound(hives_.begin(), hives_.end(), key);
-    if (it != hives_.end() && it->uid == uid) {
-        return interface_pointer_cast<IRawHive>(it->hive);
-    }
-    return {};
+    return interface_pointer_cast<IRawHive>(find_entry(uid));
 }
 
 size_t HiveStore::hive_count() const
 {
-    return hives_.size();
+    return table().size();
 }
 
 void HiveStore::for_each_hive(void* context, HiveVisitorFn visitor) const
 {
-    for (auto& entry : hives_) {
+    for (auto& entry : table()) {
         auto* hive = interface_cast<IHive>(entry.hive);
         if (hive && !visitor(context, *hive)) {
             return;
@@ -87,4 +129,42 @@ void HiveStore::for_each_hive(void* context, HiveVisitorFn visitor) const
     }
 }
 
+HiveStats HiveStore::get_stats() const
+{
+    HiveStats total;
+    for (auto& entry : table()) {
+        auto* hive = interface_cast<IHive>(entry.hive);
+        if (!hive) {
+            continue;
+        }
+        HiveStats stats = hive->get_stats();
+        total.pages += stats.pages;
+        total.capacity += stats.capacity;
+        total.live += stats.live;
+        total.zombies += stats.zombies;
+        total.free_slots += stats.free_slots;
+        total.fragmented_slots += stats.fragmented_slots;
+        total.reserved_bytes += stats.reserved_bytes;
+    }
+    total.orphaned_pages = ObjectHive::orphaned_page_count();
+    return total;
+}
+
+IHivePageSource::Ptr HiveStore::get_default_page_source() const
+{
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return page_source_;
+}
+
+void HiveStore::set_default_page_source(const IHivePageSource::Ptr& source)
+{
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    page_source_ = source;
+    for (auto& entry : table()) {
+        if (auto* hive = interface_cast<IHive>(entry.hive)) {
+            hive->set_page_source(source);
+        }
+    }
+}
+
 } // namespace velk
@@ -4,6 +4,9 @@
 #include <velk/ext/core_object.h>
 #include <velk/interface/hive/intf_hive_store.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace velk {
@@ -13,19 +16,31 @@ namespace velk {
  *
  * Maintains a sorted vector of hives keyed by UID. Hives are lazily
  * created on first access via get_hive() or get_raw_hive().
+ *
+ * The vector is an immutable snapshot published through an atomic pointer. Lookups
+ * read the current snapshot without locking, so they never contend with hive creation.
+ * Creating a hive copies the snapshot with the new entry inserted and swaps it in.
+ * Earlier snapshots stay alive until the store is destroyed, since a reader may still
+ * be searching them; the store only holds one hive per type, so they stay small.
  */
 class HiveStore final : public ext::ObjectCore<HiveStore, IHiveStore>
 {
 public:
     VELK_CLASS_UID(ClassId::HiveStore);
 
+    HiveStore();
+
     // IHiveStore overrides
     IObjectHive::Ptr get_hive(Uid classUid) override;
     IObjectHive::Ptr find_hive(Uid classUid) const override;
+    IObjectHive::Ptr get_partitioned_hive(Uid classUid, size_t partitions) override;
     IRawHive::Ptr get_raw_hive(Uid uid, size_t element_size, size_t element_align) override;
     IRawHive::Ptr find_raw_hive(Uid uid) const override;
     size_t hive_count() const override;
     void for_each_hive(void* context, HiveVisitorFn visitor) const override;
+    HiveStats get_stats() const override;
+    IHivePageSource::Ptr get_default_page_source() const override;
+    void set_default_page_source(const IHivePageSource::Ptr& source) override;
 
 private:
     struct HiveEntry
@@ -35,7 +50,22 @@ private:
         bool operator<(const HiveEntry& o) const { return uid < o.uid; }
     };
 
-    std::vector<HiveEntry> hives_;
+    /** @brief Sorted hive table. Never modified once published. */
+    using HiveTable = std::vector<HiveEntry>;
+
+    /** @brief Returns the current snapshot. Lock-free. */
+    const HiveTable& table() const { return *table_.load(std::memory_order_acquire); }
+
+    /** @brief Returns the hive registered for @p uid in the current snapshot, or nullptr. Lock-free. */
+    IHive::Ptr find_entry(Uid uid) const;
+
+    /** @brief Publishes a snapshot with @p hive added. Call with write_mutex_ held. */
+    void publish(Uid uid, const IHive::Ptr& hive);
+
+    mutable std::mutex write_mutex_;                 ///< Serializes hive creation and page source updates.
+    std::atomic<const HiveTable*> table_{nullptr};   ///< Current snapshot.
+    std::vector<std::unique_ptr<HiveTable>> tables_; ///< Every published snapshot, newest last.
+    IHivePageSource::Ptr page_source_;
 };
 
 } // namespace velk
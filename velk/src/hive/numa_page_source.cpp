@@ -0,0 +1,181 @@
+#include "numa_page_source.h"
+
+#include "virtual_memory_page_source.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace velk {
+
+namespace {
+
+#ifdef _WIN32
+size_t query_node_count()
+{
+    ULONG highest = 0;
+    return GetNumaHighestNodeNumber(&highest) ? static_cast<size_t>(highest) + 1 : 1;
+}
+
+int current_node()
+{
+    PROCESSOR_NUMBER processor;
+    GetCurrentProcessorNumberEx(&processor);
+    USHORT node = 0;
+    return GetNumaProcessorNodeEx(&processor, &node) ? static_cast<int>(node) : 0;
+}
+#else
+// Memory policy constants from <linux/mempolicy.h>, which is not installed everywhere.
+constexpr int NUMA_MPOL_PREFERRED = 1;
+constexpr int NUMA_MPOL_INTERLEAVE = 3;
+constexpr int NUMA_MPOL_LOCAL = 4;
+constexpr unsigned long NUMA_MPOL_F_MEMS_ALLOWED = 1ul << 2;
+
+/** @brief Node bitmask as passed to the mempolicy system calls. */
+struct NodeMask
+{
+    static constexpr size_t BITS = 1024;
+    static constexpr size_t WORD_BITS = sizeof(unsigned long) * 8;
+    unsigned long words[BITS / WORD_BITS]{};
+
+    void set(size_t node) { words[node / WORD_BITS] |= 1ul << (node % WORD_BITS); }
+    bool test(size_t node) const { return words[node / WORD_BITS] & (1ul << (node % WORD_BITS)); }
+};
+
+/** @brief Returns the nodes the calling process may allocate from, or false without NUMA support. */
+bool allowed_nodes(NodeMask& mask)
+{
+    unsigned long flags = NUMA_MPOL_F_MEMS_ALLOWED;
+    return syscall(SYS_get_mempolicy, nullptr, mask.words, NodeMask::BITS, nullptr, flags) == 0;
+}
+
+size_t query_node_count()
+{
+    NodeMask mask;
+    if (!allowed_nodes(mask)) {
+        return 1;
+    }
+    size_t count = 1;
+    for (size_t node = 0; node < NodeMask::BITS; ++node) {
+        if (mask.test(node)) {
+            count = node + 1;
+        }
+    }
+    return count;
+}
+
+int current_node()
+{
+    unsigned cpu = 0;
+    unsigned node = 0;
+    return syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 ? static_cast<int>(node) : 0;
+}
+
+/** @brief Applies @p policy to the pages of a block that nothing has touched yet. Best effort. */
+void bind_pages(void* page, size_t size, NumaPolicy policy, int node)
+{
+    NodeMask mask;
+    int mode = NUMA_MPOL_LOCAL;
+    if (policy == NumaPolicy::Interleave) {
+        if (!allowed_nodes(mask)) {
+            return;
+        }
+        mode = NUMA_MPOL_INTERLEAVE;
+    } else if (policy == NumaPolicy::Node) {
+        mask.set(static_cast<size_t>(node));
+        mode = NUMA_MPOL_PREFERRED;
+    }
+    // The kernel reads maxnode - 1 bits of the mask.
+    const unsigned long* nodes = mode == NUMA_MPOL_LOCAL ? nullptr : mask.words;
+    syscall(SYS_mbind, page, size, mode, nodes, NodeMask::BITS + 1, 0);
+}
+#endif
+
+} // namespace
+
+NumaPageSource::NumaPageSource() : node_count_(query_node_count()) {}
+
+void* NumaPageSource::allocate_page(size_t size, size_t alignment)
+{
+    NumaPolicy policy = policy_.load(std::memory_order_relaxed);
+    int node = node_.load(std::memory_order_relaxed);
+#ifdef _WIN32
+    if (policy == NumaPolicy::Node) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        if (alignment > info.dwAllocationGranularity) {
+            return nullptr;
+        }
+        DWORD type = MEM_RESERVE | MEM_COMMIT;
+        return VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, type, PAGE_READWRITE, node);
+    }
+    return map_page_memory(size, alignment);
+#else
+    void* mem = map_page_memory(size, alignment);
+    if (mem && node_count_ > 1) {
+        bind_pages(mem, size, policy, node);
+    }
+    return mem;
+#endif
+}
+
+void NumaPageSource::free_page(void* page, size_t size)
+{
+    unmap_page_memory(page, size);
+}
+
+ReturnValue NumaPageSource::set_policy(NumaPolicy policy, int node)
+{
+    if (policy == NumaPolicy::Node && (node < 0 || static_cast<size_t>(node) >= node_count_)) {
+        return ReturnValue::InvalidArgument;
+    }
+    if (policy != NumaPolicy::Node) {
+        node = 0;
+    }
+    if (policy == policy_.load(std::memory_order_relaxed) && node == node_.load(std::memory_order_relaxed)) {
+        return ReturnValue::NothingToDo;
+    }
+    node_.store(node, std::memory_order_relaxed);
+    policy_.store(policy, std::memory_order_relaxed);
+    return ReturnValue::Success;
+}
+
+NumaPolicy NumaPageSource::get_policy() const
+{
+    return policy_.load(std::memory_order_relaxed);
+}
+
+int NumaPageSource::get_node() const
+{
+    return node_.load(std::memory_order_relaxed);
+}
+
+size_t NumaPageSource::get_node_count() const
+{
+    return node_count_;
+}
+
+int NumaPageSource::get_page_node(const void* page, size_t size) const
+{
+    (void)page;
+    (void)size;
+    if (node_count_ == 1) {
+        return 0;
+    }
+    switch (policy_.load(std::memory_order_relaxed)) {
+    case NumaPolicy::Node:
+        return node_.load(std::memory_order_relaxed);
+    case NumaPolicy::Interleave:
+        return -1;
+    default:
+        return current_node();
+    }
+}
+
+} // namespace velk
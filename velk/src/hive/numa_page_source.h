@@ -0,0 +1,45 @@
+#ifndef VELK_SRC_NUMA_PAGE_SOURCE_H
+#define VELK_SRC_NUMA_PAGE_SOURCE_H
+
+#include <velk/ext/core_object.h>
+#include <velk/interface/hive/intf_hive_page_source.h>
+
+#include <atomic>
+
+namespace velk {
+
+/**
+ * @brief INumaPageSource that maps hive pages from the OS and places them with a NUMA policy.
+ *
+ * Pages are mapped like VirtualMemoryPageSource maps them. On Linux the policy is
+ * applied with mbind() before the hive first touches the page; on Windows explicit
+ * nodes use VirtualAllocExNuma() and interleaving is not available, so an interleaved
+ * page lands on the node of the thread that first touches it.
+ */
+class NumaPageSource final : public ext::ObjectCore<NumaPageSource, INumaPageSource>
+{
+public:
+    VELK_CLASS_UID(ClassId::NumaPageSource);
+
+    NumaPageSource();
+
+    // IHivePageSource overrides
+    void* allocate_page(size_t size, size_t alignment) override;
+    void free_page(void* page, size_t size) override;
+
+    // INumaPageSource overrides
+    ReturnValue set_policy(NumaPolicy policy, int node) override;
+    NumaPolicy get_policy() const override;
+    int get_node() const override;
+    size_t get_node_count() const override;
+    int get_page_node(const void* page, size_t size) const override;
+
+private:
+    std::atomic<NumaPolicy> policy_{NumaPolicy::Local};
+    std::atomic<int> node_{0};
+    size_t node_count_{1};
+};
+
+} // namespace velk
+
+#endif // VELK_SRC_NUMA_PAGE_SOURCE_H
@@ -1,9 +1,16 @@
 #include "object_hive.h"
 
+#include "dirty_bit.h"
 #include "page_allocator.h"
 
 #include <velk/api/velk.h>
+#include <velk/ext/object.h>
 #include <velk/interface/intf_metadata.h>
+#include <velk/trace.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
 
 namespace velk {
 
@@ -21,6 +28,108 @@ struct HiveControlBlock
     HivePage* page;
 };
 
+/** @brief Number of orphaned pages alive in the process (see HiveStats::orphaned_pages). */
+static std::atomic<size_t> orphaned_pages{0};
+
+/** @brief Orphaned pages of at least this many bytes are freed on the instance thread pool. */
+static constexpr size_t ORPHAN_RECLAIM_MIN_BYTES = 64 * 1024;
+
+/** @brief Past this many queued pages the releasing thread frees the queue itself. */
+static constexpr size_t ORPHAN_RECLAIM_MAX_PAGES = 64;
+
+/**
+ * @brief Memory of large orphaned pages awaiting release on the instance thread pool.
+ *
+ * The last reference to an object of an orphaned page may drop on any thread, which should
+ * not stall on freeing a page of several megabytes. VelkInstance::update() posts the drain to
+ * the pool; the queue itself never calls into the instance, since pages are also released
+ * while the instance is destroyed. Never destroyed, so releases during static destruction
+ * remain safe.
+ */
+struct OrphanReclaimQueue
+{
+    std::mutex mutex;
+    std::vector<PageMemory> pages;
+    std::atomic<bool> pending{false}; ///< Pages are queued.
+    std::atomic<bool> inline_free{false}; ///< Set while the instance shuts down.
+};
+
+static OrphanReclaimQueue& orphan_reclaim_queue()
+{
+    static auto* queue = new OrphanReclaimQueue;
+    return *queue;
+}
+
+/** @brief Queues the memory of an orphaned page, or frees it when the queue is not drained any more. */
+static void queue_orphaned_page_memory(HivePage& page)
+{
+    auto& queue = orphan_reclaim_queue();
+    if (!queue.inline_free.load(std::memory_order_acquire)) {
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        take_page_memory(page, queue.pages);
+        queue.pending.store(true, std::memory_order_release);
+        if (queue.pages.size() < ORPHAN_RECLAIM_MAX_PAGES) {
+            return;
+        }
+        lock.unlock();
+        ObjectHive::reclaim_orphaned_page_memory();
+        return;
+    }
+    free_page_memory(page);
+}
+
+/** @brief Frees an orphaned page once nothing refers to it any more. */
+static void delete_orphaned_page(HivePage* page)
+{
+    if (page->allocation_size >= ORPHAN_RECLAIM_MIN_BYTES) {
+        queue_orphaned_page_memory(*page);
+    } else {
+        free_page_memory(*page);
+    }
+    delete page;
+    orphaned_pages.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Weak dealloc notification for a dead object's block in a page owned by a hive.
+ *
+ * Called when the last weak_ptr to a destroyed object drops. Lets the hive
+ * release the page if it became unused.
+ */
+static void hive_weak_release(external_control_block* ecb)
+{
+    auto* hcb = reinterpret_cast<HiveControlBlock*>(ecb);
+    HivePage* page = hcb->page;
+    page->hive->release_weak_block(*page, static_cast<size_t>(hcb - page->hcbs));
+}
+
+/**
+ * @brief Weak dealloc notification for a dead object's block in a hive with magazines.
+ *
+ * The slot stayed a zombie of its page while the weak_ptrs were alive, and is now cached.
+ */
+static void hive_weak_release_cached(external_control_block* ecb)
+{
+    auto* hcb = reinterpret_cast<HiveControlBlock*>(ecb);
+    HivePage* page = hcb->page;
+    page->hive->release_cached_block(*page, static_cast<size_t>(hcb - page->hcbs));
+}
+
+/**
+ * @brief Weak dealloc notification for a dead object's block in an orphaned page.
+ *
+ * Frees the page when the last weak_ptr to any of its blocks drops and no
+ * objects remain on it.
+ */
+static void hive_weak_release_orphan(external_control_block* ecb)
+{
+    auto* hcb = reinterpret_cast<HiveControlBlock*>(ecb);
+    HivePage* page = hcb->page;
+    if (page->weak_hcb_count.fetch_sub(1, std::memory_order_acq_rel) == 1 && page->live_count == 0) {
+        delete_orphaned_page(page);
+    }
+}
+
 /**
  * @brief Shared destroy logic for hive-managed objects.
  *
@@ -56,53 +165,25 @@ static void hive_destroy_impl(HiveControlBlock* hcb, bool orphan)
     bool last_weak = hcb->ecb.release_weak();
 
     if (!orphan) {
-        // Lock the owning hive's mutex to protect page state (freelist, bitmask, counts).
-        std::lock_guard<std::shared_mutex> lock(*page->hive_mutex);
-
-        // Normal mode: block stays embedded in the page. If outstanding
-        // weak_ptrs exist, set the destroy callback to hive_weak_release
-        // so the page can track when they all drop.
-        if (!last_weak) {
-            // Outstanding weak_ptrs. Set destroy to the weak release callback
-            // so dealloc_control_block (called when last weak_ptr drops) will
-            // notify the page. The external+embedded tags are already set.
-            // No weak_hcb_count tracking needed in normal mode because the
-            // page is still owned by the Hive.
-            hcb->ecb.destroy = nullptr;
-        }
-        // else: no outstanding weak_ptrs, block is fully dead. It sits inert
-        // in the page allocation, ready for reuse.
-
-        // Clear active bit and transition slot to Free.
-        size_t word = slot_index / 64;
-        size_t bit = slot_index % 64;
-        clear_slot_active(page->active_bits, word, bit);
-
-        page->state[slot_index] = SlotState::Free;
-        push_free_slot(page->slots, slot_index, slot_sz, page->free_head);
-    } else {
-        // Orphan mode: page was detached from the Hive.
-        if (!last_weak) {
-            // Outstanding weak_ptrs. We need to track this so the page can
-            // be freed when all weak_ptrs drop.
-            hcb->ecb.destroy = [](external_control_block* ecb) {
-                auto* h = reinterpret_cast<HiveControlBlock*>(ecb);
-                HivePage* p = h->page;
-                if (p->weak_hcb_count.fetch_sub(1, std::memory_order_acq_rel) == 1 && p->live_count == 0) {
-                    aligned_free_impl(p->allocation);
-                    delete p;
-                }
-            };
-            page->weak_hcb_count.fetch_add(1, std::memory_order_relaxed);
-        }
+        // Normal mode: the owning hive reclaims the slot under its lock. This may
+        // release the page, so it must not be touched afterwards.
+        page->hive->reclaim_slot(*page, slot_index, last_weak);
+        return;
+    }
 
-        page->state[slot_index] = SlotState::Free;
+    // Orphan mode: page was detached from the Hive. Its zombie bits are no longer
+    // maintained, as destroys may now run concurrently without a lock.
+    if (!last_weak) {
+        // Outstanding weak_ptrs. We need to track this so the page can
+        // be freed when all weak_ptrs drop.
+        hcb->ecb.destroy = hive_weak_release_orphan;
+        page->weak_hcb_count.fetch_add(1, std::memory_order_relaxed);
     }
+
     --page->live_count;
 
-    if (orphan && page->live_count == 0 && page->weak_hcb_count.load(std::memory_order_acquire) == 0) {
-        aligned_free_impl(page->allocation);
-        delete page;
+    if (page->live_count == 0 && page->weak_hcb_count.load(std::memory_order_acquire) == 0) {
+        delete_orphaned_page(page);
     }
 }
 
@@ -120,36 +201,72 @@ static void hive_destroy_orphan(external_control_block* ecb)
 
 ObjectHive::~ObjectHive()
 {
+    // Nobody can observe the objects released by the destructor.
+    membership_.reset();
+    membership_target_ = nullptr;
+
     // Release the hive's strong ref on all active objects.
     clear();
+    drain_magazines();
 
     // Handle orphan pages: pages with zombies or outstanding weak HCBs
     // must outlive the hive.
     for (auto& page_ptr : pages_) {
         auto& page = *page_ptr;
+        size_t num_words = bitmask_words(page.capacity);
 
-        bool has_zombies = false;
-        for (size_t i = 0; i < page.capacity; ++i) {
-            if (page.state[i] == SlotState::Zombie) {
-                has_zombies = true;
-                break;
+        // Dead objects whose slot awaits its last weak_ptr to be cached become weakly
+        // referenced free slots.
+        for (size_t w = 0; w < num_words && magazines_; ++w) {
+            uint64_t bits = page.zombie_bits[w];
+            while (bits) {
+                size_t i = w * 64 + bitscan_forward64(bits);
+                bits &= bits - 1;
+                auto& ecb = page.hcbs[i].ecb;
+                if (ecb.destroy == hive_weak_release_cached) {
+                    ecb.destroy = hive_weak_release;
+                    clear_slot_active(page.zombie_bits, w, i % 64);
+                    --page.live_count;
+                    ++page.weak_free_count;
+                }
+            }
+        }
+
+        // Only pages with weakly referenced dead objects need a per-slot scan.
+        if (page.weak_free_count) {
+            for (size_t i = 0; i < page.capacity; ++i) {
+                auto& ecb = page.hcbs[i].ecb;
+                bool zombie = is_slot_active(page.zombie_bits, i / 64, i % 64);
+                if (!zombie && ecb.weak.load(std::memory_order_acquire)) {
+                    // Dead object with outstanding weak_ptrs: track them as an orphan.
+                    ecb.destroy = hive_weak_release_orphan;
+                    page.weak_hcb_count.fetch_add(1, std::memory_order_relaxed);
+                }
             }
         }
 
+        bool has_zombies = false;
+        for (size_t w = 0; w < num_words && !has_zombies; ++w) {
+            has_zombies = page.zombie_bits[w] != 0;
+        }
         bool has_weak_hcbs = page.weak_hcb_count.load(std::memory_order_acquire) > 0;
 
         if (has_zombies || has_weak_hcbs) {
-            // Transfer page ownership to an orphan. Null out the mutex pointer
+            // Transfer page ownership to an orphan. Null out the hive pointer
             // since the ObjectHive (and its mutex) are being destroyed.
             page.orphaned = true;
-            page.hive_mutex = nullptr;
-            for (size_t i = 0; i < page.capacity; ++i) {
-                if (page.state[i] == SlotState::Zombie) {
+            page.hive = nullptr;
+            for (size_t w = 0; w < num_words; ++w) {
+                uint64_t bits = page.zombie_bits[w];
+                while (bits) {
+                    size_t i = w * 64 + bitscan_forward64(bits);
+                    bits &= bits - 1;
                     page.hcbs[i].ecb.destroy = hive_destroy_orphan;
                 }
             }
             // Release unique_ptr ownership.
             page_ptr.release();
+            orphaned_pages.fetch_add(1, std::memory_order_relaxed);
         } else {
             free_page(page);
         }
@@ -181,6 +298,60 @@ bool ObjectHive::empty() const
     return live_count_ == 0;
 }
 
+size_t ObjectHive::orphaned_page_count()
+{
+    return orphaned_pages.load(std::memory_order_relaxed);
+}
+
+bool ObjectHive::has_orphaned_page_memory()
+{
+    return orphan_reclaim_queue().pending.load(std::memory_order_acquire);
+}
+
+void ObjectHive::reclaim_orphaned_page_memory()
+{
+    std::vector<PageMemory> pages;
+    {
+        auto& queue = orphan_reclaim_queue();
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        pages.swap(queue.pages);
+        queue.pending.store(false, std::memory_order_relaxed);
+    }
+    for (auto& page : pages) {
+        free_page_memory(page);
+    }
+}
+
+void ObjectHive::set_inline_page_reclaim(bool enabled)
+{
+    orphan_reclaim_queue().inline_free.store(enabled, std::memory_order_release);
+    if (enabled) {
+        reclaim_orphaned_page_memory();
+    }
+}
+
+HiveStats ObjectHive::get_stats() const
+{
+    std::shared_lock lock(mutex_);
+    HiveStats stats;
+    stats.pages = pages_.size();
+    stats.live = live_count_;
+    stats.free_slots = free_slots_;
+    size_t occupied = 0;
+    for (auto& page_ptr : pages_) {
+        auto& page = *page_ptr;
+        stats.capacity += page.capacity;
+        stats.reserved_bytes += page.allocation_size;
+        occupied += page.live_count;
+        if (page.live_count) {
+            stats.fragmented_slots += page.capacity - page.live_count;
+        }
+    }
+    // Page live counts include the zombies.
+    stats.zombies = occupied - live_count_;
+    return stats;
+}
+
 HivePageCapacity ObjectHive::get_page_capacity() const
 {
     return capacity_;
@@ -191,6 +362,45 @@ void ObjectHive::set_page_capacity(const HivePageCapacity& capacity)
     capacity_ = check_capacity(capacity);
 }
 
+size_t ObjectHive::get_slot_alignment() const
+{
+    std::shared_lock lock(mutex_);
+    return slot_alignment_;
+}
+
+ReturnValue ObjectHive::set_slot_alignment(size_t alignment)
+{
+    if (alignment & (alignment - 1)) {
+        return ReturnValue::InvalidArgument;
+    }
+    check_iteration_guard(mutex_, "set_slot_alignment");
+
+    std::lock_guard<HiveMutex> lock(mutex_);
+    if (!pages_.empty()) {
+        return ReturnValue::Fail;
+    }
+    if (factory_) {
+        size_t natural = factory_->get_instance_alignment();
+        slot_alignment_ = alignment > natural ? alignment : natural;
+        slot_size_ = align_up(factory_->get_instance_size(), slot_alignment_);
+    }
+    return ReturnValue::Success;
+}
+
+IHivePageSource::Ptr ObjectHive::get_page_source() const
+{
+    std::shared_lock lock(mutex_);
+    return page_source_;
+}
+
+void ObjectHive::set_page_source(const IHivePageSource::Ptr& source)
+{
+    check_iteration_guard(mutex_, "set_page_source");
+
+    std::lock_guard<HiveMutex> lock(mutex_);
+    page_source_ = source;
+}
+
 void* ObjectHive::slot_ptr(HivePage& page, size_t index) const
 {
     return static_cast<char*>(page.slots) + index * slot_size_;
@@ -211,301 +421,1593 @@ void ObjectHive::alloc_page(size_t capacity)
     size_t num_words = bitmask_words(capacity);
 
     // Compute layout:
-    // [ SlotState[capacity] | pad | uint64_t[bitmask] | pad | HiveControlBlock[capacity] | pad | slots ]
-    size_t state_bytes = capacity * sizeof(SlotState);
-    size_t bits_offset = align_up(state_bytes, alignof(uint64_t));
+    // [ uint64_t[active bits] | uint64_t[zombie bits] | uint32_t[generations] | pad |
+    //   HiveControlBlock[capacity] | pad | slots ]
     size_t bits_bytes = num_words * sizeof(uint64_t);
-    size_t hcbs_offset = align_up(bits_offset + bits_bytes, alignof(HiveControlBlock));
+    size_t generations_offset = 2 * bits_bytes;
+    size_t hcbs_offset = align_up(generations_offset + capacity * sizeof(uint32_t), alignof(HiveControlBlock));
     size_t hcbs_bytes = capacity * sizeof(HiveControlBlock);
     size_t slots_offset = align_up(hcbs_offset + hcbs_bytes, slot_alignment_);
     size_t slots_bytes = capacity * slot_size_;
     size_t total = slots_offset + slots_bytes;
 
-    auto* mem = static_cast<char*>(aligned_alloc_impl(slot_alignment_, total));
-    page->allocation = mem;
-    page->state = reinterpret_cast<SlotState*>(mem);
-    page->active_bits = reinterpret_cast<uint64_t*>(mem + bits_offset);
+    // State columns follow the slots: [ ... | slots | pad | column 0 | (front 0) | pad | column 1 ... ]
+    // A double buffered column is followed by its front copy.
+    size_t alloc_align = slot_alignment_;
+    std::vector<size_t> column_offsets;
+    column_offsets.reserve(state_columns_.size());
+    for (auto& column : state_columns_) {
+        total = align_up(total, column.alignment);
+        column_offsets.push_back(total);
+        total += (column.double_buffered ? 2 : 1) * capacity * column.stride;
+        alloc_align = alloc_align > column.alignment ? alloc_align : column.alignment;
+    }
+    // Dirty bitmasks come next: [ ... | column n | pad | dirty bits 0 | index bits 0 | dirty bits 1 ... ]
+    // Each tracked interface has a bitmask for for_each_dirty(), one for its indexes and one for
+    // its change journal, if needed.
+    size_t dirty_offset = align_up(total, alignof(std::atomic<uint64_t>));
+    size_t dirty_masks = 0;
+    for (auto& tracking : dirty_tracking_) {
+        dirty_masks += size_t(tracking.tracked) + size_t(tracking.indexed) + size_t(tracking.journaled);
+    }
+    total = dirty_offset + dirty_masks * num_words * sizeof(std::atomic<uint64_t>);
+    // The journaled States of the change journals come last: [ ... | pad | journaled 0 | pad | ... ]
+    std::vector<size_t> journal_offsets;
+    for (auto& tracking : dirty_tracking_) {
+        if (tracking.journaled) {
+            total = align_up(total, tracking.state_alignment);
+            journal_offsets.push_back(total);
+            total += capacity * align_up(tracking.state_size, tracking.state_alignment);
+            alloc_align = alloc_align > tracking.state_alignment ? alloc_align : tracking.state_alignment;
+        }
+    }
+
+    auto* mem = static_cast<char*>(allocate_page_memory(*page, page_source_, alloc_align, total));
+    page->active_bits = reinterpret_cast<uint64_t*>(mem);
+    page->zombie_bits = reinterpret_cast<uint64_t*>(mem + bits_bytes);
+    page->generations = reinterpret_cast<uint32_t*>(mem + generations_offset);
     page->hcbs = reinterpret_cast<HiveControlBlock*>(mem + hcbs_offset);
     page->slots = mem + slots_offset;
+    page->columns.reserve(state_columns_.size());
+    for (size_t c = 0; c < state_columns_.size(); ++c) {
+        auto& column = state_columns_[c];
+        char* base = mem + column_offsets[c];
+        char* front = column.double_buffered ? base + capacity * column.stride : base;
+        page->columns.push_back({column.uid, base, front, column.stride});
+    }
+    page->dirty.reserve(dirty_tracking_.size());
+    auto* next_mask = reinterpret_cast<std::atomic<uint64_t>*>(mem + dirty_offset);
+    for (size_t w = 0; w < dirty_masks * num_words; ++w) {
+        new (&next_mask[w]) std::atomic<uint64_t>(0);
+    }
+    size_t next_journal = 0;
+    for (auto& tracking : dirty_tracking_) {
+        PageDirtyBits dirty{tracking.uid, nullptr, nullptr, nullptr, nullptr};
+        if (tracking.tracked) {
+            dirty.bits = next_mask;
+            next_mask += num_words;
+        }
+        if (tracking.indexed) {
+            dirty.index_bits = next_mask;
+            next_mask += num_words;
+        }
+        if (tracking.journaled) {
+            dirty.journal_bits = next_mask;
+            next_mask += num_words;
+            dirty.journaled = mem + journal_offsets[next_journal++];
+        }
+        page->dirty.push_back(dirty);
+    }
 
     for (size_t i = 0; i < capacity; ++i) {
-        page->state[i] = SlotState::Free;
+        // Zero counts mark the block as unreferenced.
+        new (&page->hcbs[i]) HiveControlBlock{};
+        page->hcbs[i].ecb.weak.store(0, std::memory_order_relaxed);
     }
-    std::memset(page->active_bits, 0, bits_bytes);
+    std::memset(page->active_bits, 0, 2 * bits_bytes);
+    assign_page_id(*page);
 
     // Build intrusive freelist through slot memory.
     build_freelist(page->slots, capacity, slot_size_, page->free_head);
     page->live_count = 0;
 
-    page->hive_mutex = &mutex_;
+    page->hive = this;
+    free_slots_ += capacity;
+    free_pages_.push(page.get());
     current_page_ = page.get();
+    insert_sorted_page(sorted_pages_, page.get());
     pages_.push_back(std::move(page));
+    note_page_alloc(capacity_, pages_, growth_);
 }
 
 void ObjectHive::free_page(HivePage& page)
 {
-    aligned_free_impl(page.allocation);
-    page.allocation = nullptr;
-    page.state = nullptr;
+    if (page.allocation) {
+        free_page_memory(page);
+    }
     page.active_bits = nullptr;
+    page.zombie_bits = nullptr;
+    page.generations = nullptr;
     page.hcbs = nullptr;
     page.slots = nullptr;
 }
 
-void ObjectHive::push_free(HivePage& page, size_t index, size_t slot_sz)
+bool ObjectHive::is_page_unused(const HivePage& page)
 {
-    push_free_slot(page.slots, index, slot_sz, page.free_head);
+    // Free slots whose previous object was weakly referenced keep their embedded
+    // block, and the pending hive_weak_release notification, until the last weak_ptr
+    // drops. weak_free_count counts them.
+    return page.live_count == 0 && page.weak_free_count == 0;
 }
 
-size_t ObjectHive::next_page_capacity() const
+void ObjectHive::release_page(HivePage& page, std::vector<PageMemory>* deferred)
 {
-    return ::velk::next_page_capacity(capacity_, pages_.size());
+    free_pages_.unlink(&page);
+    if (current_page_ == &page) {
+        current_page_ = free_pages_.head;
+    }
+    free_slots_ -= page.capacity;
+    release_page_id(page);
+    if (deferred) {
+        take_page_memory(page, *deferred);
+    }
+    free_page(page);
 }
 
-bool ObjectHive::find_slot(const void* obj, size_t& page_idx, size_t& slot_idx) const
+void ObjectHive::assign_page_id(HivePage& page)
 {
-    auto obj_addr = reinterpret_cast<uintptr_t>(obj);
-    for (size_t pi = 0; pi < pages_.size(); ++pi) {
-        auto& page = *pages_[pi];
-        auto base = reinterpret_cast<uintptr_t>(page.slots);
-        auto end = base + page.capacity * slot_size_;
-        if (obj_addr >= base && obj_addr < end) {
-            size_t offset = static_cast<size_t>(obj_addr - base);
-            if (offset % slot_size_ == 0) {
-                size_t si = offset / slot_size_;
-                if (page.state[si] == SlotState::Active) {
-                    page_idx = pi;
-                    slot_idx = si;
-                    return true;
-                }
-            }
-        }
+    uint32_t first_generation = 1;
+    if (!free_page_ids_.empty()) {
+        page.id = free_page_ids_.back();
+        free_page_ids_.pop_back();
+        page_ids_[page.id] = &page;
+        first_generation = id_generations_[page.id];
+    } else if (page_ids_.size() < (size_t(1) << HiveHandle::PAGE_BITS)) {
+        page.id = static_cast<uint32_t>(page_ids_.size());
+        page_ids_.push_back(&page);
+        id_generations_.push_back(first_generation);
     }
-    return false;
+    std::fill_n(page.generations, page.capacity, first_generation);
 }
 
-IObject::Ptr ObjectHive::add()
+void ObjectHive::release_page_id(HivePage& page)
 {
-    if (!factory_) {
-        return {};
+    if (page.id == NO_PAGE_ID) {
+        return;
     }
-
-    check_iteration_guard(mutex_, "add");
-
-    std::lock_guard<std::shared_mutex> lock(mutex_);
-
-    // Check cached page hint first, then scan.
-    HivePage* target = nullptr;
-    if (current_page_ && current_page_->free_head != PAGE_SENTINEL) {
-        target = current_page_;
-    } else {
-        for (auto& page_ptr : pages_) {
-            if (page_ptr->free_head != PAGE_SENTINEL) {
-                target = page_ptr.get();
-                break;
-            }
-        }
+    // The next page with this id starts past every generation this one handed out, so
+    // handles into the released page do not resolve in its successor.
+    uint32_t last = 0;
+    for (size_t i = 0; i < page.capacity; ++i) {
+        last = std::max(last, page.generations[i]);
     }
-
-    if (!target) {
-        alloc_page(next_page_capacity());
-        target = pages_.back().get();
+    id_generations_[page.id] = next_generation(last);
+    // The removals marked in the page are never read: drop its objects from the indexes now.
+    for (auto& index : indexes_) {
+        for (size_t i = 0; i < page.capacity; ++i) {
+            index.erase((uint64_t(page.id) << HiveHandle::SLOT_BITS) | i);
+        }
     }
+    page_ids_[page.id] = nullptr;
+    free_page_ids_.push_back(page.id);
+    page.id = NO_PAGE_ID;
+}
 
-    current_page_ = target;
-
-    // Pop slot from freelist.
-    size_t slot_idx = pop_free_slot(target->slots, slot_size_, target->free_head);
-    target->state[slot_idx] = SlotState::Active;
-    ++target->live_count;
-
-    // Set active bit.
-    size_t word = slot_idx / 64;
-    size_t bit = slot_idx % 64;
-    set_slot_active(target->active_bits, word, bit);
-
-    // Initialize the embedded HiveControlBlock (no heap allocation).
-    auto* hcb = &target->hcbs[slot_idx];
-    hcb->ecb.strong.store(1, std::memory_order_relaxed);
-    hcb->ecb.weak.store(1, std::memory_order_relaxed);
-    hcb->ecb.destroy = hive_destroy;
-    hcb->ecb.set_ptr(nullptr);
-    hcb->page = target;
+uint32_t ObjectHive::next_generation(uint32_t generation)
+{
+    constexpr uint32_t mask = (uint32_t(1) << HiveHandle::GENERATION_BITS) - 1;
+    uint32_t next = (generation + 1) & mask;
+    // Generation 0 is never issued, so no handle to a live object equals the default handle.
+    return next ? next : 1;
+}
 
-    // Placement-construct the object, installing the hive's control block.
-    // The factory swaps in our block and returns the auto-allocated one to the pool.
-    void* slot = slot_ptr(*target, slot_idx);
-    auto* obj = factory_->construct_in_place(slot, &hcb->ecb, ObjectFlags::HiveManaged);
+void ObjectHive::erase_released_pages()
+{
+    sorted_pages_.erase(std::remove_if(sorted_pages_.begin(),
+                                       sorted_pages_.end(),
+                                       [](const HivePage* page) { return !page->allocation; }),
+                        sorted_pages_.end());
+    pages_.erase(std::remove_if(pages_.begin(),
+                                pages_.end(),
+                                [](const std::unique_ptr<HivePage>& page) { return !page->allocation; }),
+                 pages_.end());
+}
 
-    // Set the self-pointer and external + embedded tags on the block.
-    hcb->ecb.set_ptr(static_cast<void*>(obj));
-    hcb->ecb.set_external_tag();
-    hcb->ecb.set_embedded_tag();
+void ObjectHive::reclaim_slot(HivePage& page, size_t slot_index, bool last_weak)
+{
+    if (magazines_) {
+        // The slot stays a zombie of its page until it is cached, so neither step locks the
+        // hive. A weakly referenced slot is cached when the last weak_ptr drops, which for an
+        // intrusive shared_ptr is the release that destroyed the object.
+        page.hcbs[slot_index].ecb.destroy = last_weak ? nullptr : hive_weak_release_cached;
+        if (last_weak) {
+            magazine_deallocate(page, slot_index);
+        }
+        return;
+    }
+    return_slot(page, slot_index, last_weak);
+}
 
-    // The hive owns one strong ref (keeps the object alive while in the hive).
-    // The returned shared_ptr will acquire a second strong ref via adopt_ref + ref().
-    ++live_count_;
+void ObjectHive::release_cached_block(HivePage& page, size_t slot_index)
+{
+    page.hcbs[slot_index].ecb.destroy = nullptr;
+    magazine_deallocate(page, slot_index);
+}
 
-    IObject::Ptr result(obj, &hcb->ecb, adopt_ref);
-    obj->ref(); // Hive's strong ref
-    return result;
+void ObjectHive::return_slot(HivePage& page, size_t slot_index, bool last_weak)
+{
+    // Lock the hive's mutex to protect page state (freelist, bitmask, counts).
+    std::lock_guard<HiveMutex> lock(mutex_);
+
+    // The block stays embedded in the page. If outstanding weak_ptrs exist, set the
+    // destroy callback to hive_weak_release so dealloc_control_block (called when the
+    // last weak_ptr drops) notifies the hive. The external+embedded tags are already
+    // set. Otherwise the block is fully dead and sits inert in the page, ready for reuse.
+    page.hcbs[slot_index].ecb.destroy = last_weak ? nullptr : hive_weak_release;
+
+    if (!last_weak) {
+        // A weak_ptr would lock a new object constructed in the slot, so the slot is only
+        // reused once release_weak_block() runs.
+        clear_slot_active(page.zombie_bits, slot_index / 64, slot_index % 64);
+        --page.live_count;
+        ++page.weak_free_count;
+        return;
+    }
+    free_zombie_slot(page, slot_index);
 }
 
-ReturnValue ObjectHive::remove(IObject& object)
+void ObjectHive::free_zombie_slot(HivePage& page, size_t slot_index)
 {
-    check_iteration_guard(mutex_, "remove");
+    // Transition the slot from Zombie to Free.
+    clear_slot_active(page.zombie_bits, slot_index / 64, slot_index % 64);
+    --page.live_count;
+    push_free_slot(page.slots, slot_index, slot_size_, page.free_head);
+    free_pages_.push(&page);
+    ++free_slots_;
+    ++growth_.returned;
+
+    auto_trim(page);
+}
 
+void ObjectHive::magazine_deallocate(HivePage& page, size_t slot_index)
+{
+    auto& magazine = magazines_[thread_magazine_index()];
     {
-        std::lock_guard<std::shared_mutex> lock(mutex_);
-
-        size_t page_idx, slot_idx;
-        if (!find_slot(&object, page_idx, slot_idx)) {
-            return ReturnValue::Fail;
+        std::lock_guard<std::mutex> mlock(magazine.mutex);
+        if (magazine.slots.size() < magazine_size_) {
+            magazine.slots.push_back({&page, slot_index});
+            return;
         }
+    }
+    // The magazine is full: return half of it to the pages under one hive lock.
+    std::lock_guard<HiveMutex> lock(mutex_);
+    std::lock_guard<std::mutex> mlock(magazine.mutex);
+    while (magazine.slots.size() >= magazine_size_ / 2) {
+        auto slot = magazine.slots.back();
+        magazine.slots.pop_back();
+        free_zombie_slot(*slot.page, slot.index);
+    }
+    magazine.slots.push_back({&page, slot_index});
+}
 
-        // Clear active bit before transitioning to Zombie.
-        size_t word = slot_idx / 64;
-        size_t bit = slot_idx % 64;
-        clear_slot_active(pages_[page_idx]->active_bits, word, bit);
+void ObjectHive::drain_magazines()
+{
+    if (!magazines_) {
+        return;
+    }
+    for (size_t i = 0; i < MAGAZINE_COUNT; ++i) {
+        auto& magazine = magazines_[i];
+        std::lock_guard<std::mutex> lock(magazine.mutex);
+        for (auto& slot : magazine.slots) {
+            free_zombie_slot(*slot.page, slot.index);
+        }
+        magazine.slots.clear();
+    }
+}
 
-        // Transition Active -> Zombie. The object stays alive until external refs drop.
-        // When the last strong ref drops, unref() calls hive_destroy which transitions
-        // Zombie -> Free.
-        pages_[page_idx]->state[slot_idx] = SlotState::Zombie;
-        --live_count_;
+MemoryCounter ObjectHive::get_instance_memory() const
+{
+    std::shared_lock lock(mutex_);
+    size_t occupied = 0;
+    for (auto& page_ptr : pages_) {
+        occupied += page_ptr->live_count;
+    }
+    if (magazines_) {
+        for (size_t i = 0; i < MAGAZINE_COUNT; ++i) {
+            std::lock_guard<std::mutex> mlock(magazines_[i].mutex);
+            occupied -= magazines_[i].slots.size();
+        }
     }
+    return {occupied * slot_size_, occupied};
+}
 
-    // Release the hive's strong ref outside the lock. If this is the last ref,
-    // unref() triggers hive_destroy which re-acquires the lock to reclaim the slot.
-    object.unref();
+void ObjectHive::set_magazine_size(size_t slots)
+{
+    magazine_size_ = slots;
+    magazines_ = slots ? std::make_unique<Magazine[]>(MAGAZINE_COUNT) : nullptr;
+}
 
-    return ReturnValue::Success;
+void ObjectHive::release_weak_block(HivePage& page, size_t slot_index)
+{
+    std::lock_guard<HiveMutex> lock(mutex_);
+    // Until cleared here the pending notification keeps the page alive (see is_page_unused()).
+    page.hcbs[slot_index].ecb.destroy = nullptr;
+    --page.weak_free_count;
+    push_free_slot(page.slots, slot_index, slot_size_, page.free_head);
+    free_pages_.push(&page);
+    ++free_slots_;
+    ++growth_.returned;
+    auto_trim(page);
 }
 
-void ObjectHive::clear()
+void ObjectHive::auto_trim(HivePage& page)
 {
-    check_iteration_guard(mutex_, "clear");
+    // High-water-mark shrink: release the page once it is unused if the hive holds
+    // more free slots than the policy allows.
+    size_t max_free = capacity_.max_free_slots;
+    if (max_free && free_slots_ > max_free && is_page_unused(page)) {
+        release_page(page);
+        erase_released_pages();
+    }
+}
 
-    // Collect all active objects under the lock, then unref outside it.
-    // unref() may trigger hive_destroy which re-acquires the lock to reclaim slots.
-    std::vector<IObject*> to_unref;
+size_t ObjectHive::trim(size_t keep_free_slots)
+{
+    check_iteration_guard(mutex_, "trim");
+
+    std::lock_guard<HiveMutex> lock(mutex_);
+    drain_magazines();
+    size_t freed = 0;
+    // Release from the back: later pages are the largest ones.
+    for (auto it = pages_.rbegin(); it != pages_.rend(); ++it) {
+        auto& page = **it;
+        if (free_slots_ >= keep_free_slots + page.capacity && is_page_unused(page)) {
+            release_page(page);
+            ++freed;
+        }
+    }
+    if (freed) {
+        erase_released_pages();
+    }
+    return freed;
+}
 
-    {
-        std::lock_guard<std::shared_mutex> lock(mutex_);
+ReturnValue ObjectHive::reserve(size_t free_slots)
+{
+    check_iteration_guard(mutex_, "reserve");
 
-        for (auto& page_ptr : pages_) {
-            auto& page = *page_ptr;
-            size_t num_words = bitmask_words(page.capacity);
-            for (size_t w = 0; w < num_words; ++w) {
-                uint64_t bits = page.active_bits[w];
-                while (bits) {
-                    unsigned bit = bitscan_forward64(bits);
-                    size_t i = w * 64 + bit;
-                    bits &= bits - 1;
+    std::lock_guard<HiveMutex> lock(mutex_);
+    return reserve_slots(free_slots) ? ReturnValue::Success : ReturnValue::NothingToDo;
+}
 
-                    clear_slot_active(page.active_bits, w, bit);
-                    page.state[i] = SlotState::Zombie;
-                    to_unref.push_back(static_cast<IObject*>(slot_ptr(page, i)));
-                }
-            }
-        }
-        live_count_ = 0;
+bool ObjectHive::reserve_slots(size_t free_slots)
+{
+    if (free_slots_ >= free_slots) {
+        return false;
     }
+    // A single page covers the whole shortfall.
+    size_t shortfall = free_slots - free_slots_;
+    size_t capacity = next_page_capacity();
+    alloc_page(capacity > shortfall ? capacity : shortfall);
+    return true;
+}
 
-    for (auto* obj : to_unref) {
-        obj->unref();
-    }
+size_t ObjectHive::compact()
+{
+    return trim(0);
 }
 
-bool ObjectHive::contains(const IObject& object) const
+void ObjectHive::push_free(HivePage& page, size_t index, size_t slot_sz)
 {
-    std::shared_lock lock(mutex_);
-    size_t page_idx, slot_idx;
-    return find_slot(&object, page_idx, slot_idx);
+    push_free_slot(page.slots, index, slot_sz, page.free_head);
 }
 
-/**
- * @brief Shared bitmask scan loop with prefetching.
- *
- * Iterates all active slots across all pages. For each active slot, prefetches
- * the next active slot at (slot_ptr + prefetch_offset), then calls the visitor.
- * The visitor returns false to stop early.
+size_t ObjectHive::next_page_capacity() const
+{
+    return ::velk::next_page_capacity(capacity_, pages_, slot_size_, growth_);
+}
+
+HivePage* ObjectHive::find_slot(const void* obj, size_t& slot_idx) const
+{
+    HivePage* page = find_sorted_page(sorted_pages_, obj, slot_size_, slot_idx);
+    if (page && is_slot_active(page->active_bits, slot_idx / 64, slot_idx % 64)) {
+        return page;
+    }
+    return nullptr;
+}
+
+IObject::Ptr ObjectHive::add()
+{
+    if (!factory_) {
+        return {};
+    }
+
+    check_iteration_guard(mutex_, "add");
+
+    std::lock_guard<HiveMutex> lock(mutex_);
+
+    // Check cached page hint first, then take any page from the free-page list.
+    HivePage* target = nullptr;
+    if (current_page_ && current_page_->free_head != PAGE_SENTINEL) {
+        target = current_page_;
+    } else {
+        target = free_pages_.head;
+    }
+
+    if (!target) {
+        alloc_page(next_page_capacity());
+        target = pages_.back().get();
+    }
+
+    current_page_ = target;
+    auto obj = construct_object(*target);
+    if (membership().observed()) {
+        membership().added(&obj, 1);
+    }
+    return obj;
+}
+
+size_t ObjectHive::add_n(size_t count, IObject::Ptr* out)
+{
+    if (!factory_ || !count) {
+        return 0;
+    }
+
+    check_iteration_guard(mutex_, "add_n");
+
+    std::lock_guard<HiveMutex> lock(mutex_);
+
+    // Reserve every slot up front so the loop never allocates.
+    reserve_slots(count);
+
+    // Without an output array the objects are only kept when the membership is observed.
+    std::vector<IObject::Ptr> recorded;
+    bool observed = membership().observed();
+    if (!out && observed) {
+        recorded.resize(count);
+        out = recorded.data();
+    }
+
+    HivePage* target = current_page_;
+    for (size_t i = 0; i < count; ++i) {
+        if (!target || target->free_head == PAGE_SENTINEL) {
+            target = free_pages_.head;
+        }
+        auto obj = construct_object(*target);
+        if (out) {
+            out[i] = std::move(obj);
+        }
+    }
+    current_page_ = target;
+    if (observed) {
+        membership().added(out, count);
+    }
+    return count;
+}
+
+size_t ObjectHive::add_detached_n(size_t count, IObject::Ptr* out)
+{
+    if (!factory_ || !count || !out) {
+        return 0;
+    }
+
+    // Cached slots are still zombies of their pages, so they are reused without the hive lock.
+    size_t cached = 0;
+    if (magazines_) {
+        auto& magazine = magazines_[thread_magazine_index()];
+        std::lock_guard<std::mutex> mlock(magazine.mutex);
+        magazine.slots.reserve(magazine_size_);
+        for (; cached < count && !magazine.slots.empty(); ++cached) {
+            auto slot = magazine.slots.back();
+            magazine.slots.pop_back();
+            out[cached] = construct_in_slot(*slot.page, slot.index, true);
+        }
+    }
+    if (cached == count) {
+        return count;
+    }
+
+    check_iteration_guard(mutex_, "add_detached_n");
+
+    std::lock_guard<HiveMutex> lock(mutex_);
+
+    // Refill the calling thread's magazine to half while we hold the lock anyway.
+    size_t refill = magazines_ ? magazine_size_ / 2 : 0;
+    reserve_slots(count - cached + refill);
+
+    HivePage* target = current_page_;
+    for (size_t i = cached; i < count; ++i) {
+        if (!target || target->free_head == PAGE_SENTINEL) {
+            target = free_pages_.head;
+        }
+        out[i] = construct_object(*target, true);
+    }
+    if (refill) {
+        auto& magazine = magazines_[thread_magazine_index()];
+        std::lock_guard<std::mutex> mlock(magazine.mutex);
+        while (magazine.slots.size() < refill) {
+            if (!target || target->free_head == PAGE_SENTINEL) {
+                target = free_pages_.head;
+            }
+            magazine.slots.push_back({target, take_free_slot(*target, true)});
+        }
+    }
+    current_page_ = target;
+    return count;
+}
+
+IObject::Ptr ObjectHive::construct_object(HivePage& target, bool detached)
+{
+    return construct_in_slot(target, take_free_slot(target, detached), detached);
+}
+
+size_t ObjectHive::take_free_slot(HivePage& target, bool zombie)
+{
+    // Pop slot from freelist.
+    size_t slot_idx = pop_free_slot(target.slots, slot_size_, target.free_head);
+    if (target.free_head == PAGE_SENTINEL) {
+        free_pages_.unlink(&target);
+    }
+    ++target.live_count;
+    --free_slots_;
+
+    // Set active bit, or the zombie bit for an object the hive does not own.
+    set_slot_active(zombie ? target.zombie_bits : target.active_bits, slot_idx / 64, slot_idx % 64);
+    return slot_idx;
+}
+
+IObject::Ptr ObjectHive::construct_in_slot(HivePage& target, size_t slot_idx, bool detached)
+{
+    size_t word = slot_idx / 64;
+    size_t bit = slot_idx % 64;
+
+    // Initialize the embedded HiveControlBlock (no heap allocation).
+    auto* hcb = &target.hcbs[slot_idx];
+    hcb->ecb.strong.store(1, std::memory_order_relaxed);
+    hcb->ecb.weak.store(1, std::memory_order_relaxed);
+    hcb->ecb.destroy = hive_destroy;
+    hcb->ecb.set_ptr(nullptr);
+    hcb->page = &target;
+
+    // Placement-construct the object, installing the hive's control block.
+    // The factory swaps in our block and returns the auto-allocated one to the pool.
+    void* slot = slot_ptr(target, slot_idx);
+    uint32_t flags = ObjectFlags::HiveManaged;
+    if (!state_columns_.empty()) {
+        flags |= ObjectFlags::StateColumn;
+    }
+    if (!dirty_tracking_.empty()) {
+        flags |= ObjectFlags::DirtyTracking;
+    }
+    auto* obj = factory_->construct_in_place(slot, &hcb->ecb, flags);
+
+    // Seed the state column entries from the freshly constructed inline States. The front
+    // copy is seeded too, so readers never see the previous object of the slot.
+    for (size_t c = 0; c < state_columns_.size(); ++c) {
+        auto& column = state_columns_[c];
+        const char* state = static_cast<char*>(slot) + column.inline_offset;
+        std::memcpy(target.columns[c].base + slot_idx * column.stride, state, column.size);
+        if (column.double_buffered) {
+            std::memcpy(target.columns[c].front + slot_idx * column.stride, state, column.size);
+        }
+    }
+    // A new object counts as changed for every tracked interface. Its constructed State is
+    // the journaled one: a journal only carries the changes made after construction.
+    for (size_t d = 0; d < dirty_tracking_.size(); ++d) {
+        auto& dirty = target.dirty[d];
+        if (dirty.bits) {
+            dirty.bits[word].fetch_or(uint64_t(1) << bit, std::memory_order_relaxed);
+        }
+        if (dirty.index_bits) {
+            dirty.index_bits[word].fetch_or(uint64_t(1) << bit, std::memory_order_relaxed);
+        }
+        if (dirty.journaled) {
+            auto& tracking = dirty_tracking_[d];
+            size_t stride = align_up(tracking.state_size, tracking.state_alignment);
+            std::memcpy(dirty.journaled + slot_idx * stride,
+                        state_ptr(target, slot_idx, column_index(tracking.uid), tracking), tracking.state_size);
+        }
+    }
+
+    // Set the self-pointer and external + embedded tags on the block.
+    hcb->ecb.set_ptr(static_cast<void*>(obj));
+    hcb->ecb.set_external_tag();
+    hcb->ecb.set_embedded_tag();
+
+    IObject::Ptr result(obj, &hcb->ecb, adopt_ref);
+    if (detached) {
+        // The returned shared_ptr holds the only strong ref.
+        return result;
+    }
+
+    // The hive owns one strong ref (keeps the object alive while in the hive).
+    // The returned shared_ptr will acquire a second strong ref via adopt_ref + ref().
+    ++live_count_;
+    obj->ref(); // Hive's strong ref
+    return result;
+}
+
+ReturnValue ObjectHive::remove(IObject& object)
+{
+    check_iteration_guard(mutex_, "remove");
+
+    {
+        std::lock_guard<HiveMutex> lock(mutex_);
+
+        size_t slot_idx;
+        HivePage* found = find_slot(&object, slot_idx);
+        if (!found) {
+            return ReturnValue::Fail;
+        }
+
+        // Transition Active -> Zombie. The object stays alive until external refs drop.
+        // When the last strong ref drops, unref() calls hive_destroy which transitions
+        // Zombie -> Free.
+        auto& page = *found;
+        size_t word = slot_idx / 64;
+        size_t bit = slot_idx % 64;
+        clear_slot_active(page.active_bits, word, bit);
+        set_slot_active(page.zombie_bits, word, bit);
+        page.generations[slot_idx] = next_generation(page.generations[slot_idx]);
+        mark_indexes(page, slot_idx);
+        --live_count_;
+    }
+
+    // Release the hive's strong ref outside the lock. If this is the last ref,
+    // unref() triggers hive_destroy which re-acquires the lock to reclaim the slot.
+    // An observed membership takes over the ref until the change is delivered.
+    if (membership().observed()) {
+        membership().removed(IObject::Ptr(&object));
+    } else {
+        object.unref();
+    }
+
+    return ReturnValue::Success;
+}
+
+void ObjectHive::clear()
+{
+    check_iteration_guard(mutex_, "clear");
+
+    // Deactivate all objects under the lock, then unref outside it.
+    // unref() may trigger hive_destroy which re-acquires the lock to reclaim slots.
+    release_objects(deactivate_all(), nullptr);
+}
+
+void ObjectHive::clear_parallel(IExecutor* executor, HivePageRelease release)
+{
+    check_iteration_guard(mutex_, "clear_parallel");
+
+    // The slots of a single-threaded hive must be reclaimed on its thread.
+    release_objects(deactivate_all(), mutex_.single_thread() ? nullptr : executor);
+
+    std::vector<PageMemory> deferred;
+    {
+        std::lock_guard<HiveMutex> lock(mutex_);
+        drain_magazines();
+        size_t released = 0;
+        for (auto& page_ptr : pages_) {
+            if (page_ptr->allocation && is_page_unused(*page_ptr)) {
+                release_page(*page_ptr, release == HivePageRelease::Background ? &deferred : nullptr);
+                ++released;
+            }
+        }
+        if (released) {
+            erase_released_pages();
+        }
+    }
+    free_page_memory_async(std::move(deferred));
+}
+
+std::vector<IObject*> ObjectHive::deactivate_all()
+{
+    std::vector<IObject*> objects;
+    std::lock_guard<HiveMutex> lock(mutex_);
+    objects.reserve(live_count_);
+    for (auto& page_ptr : pages_) {
+        auto& page = *page_ptr;
+        size_t num_words = bitmask_words(page.capacity);
+        for (size_t w = 0; w < num_words; ++w) {
+            uint64_t bits = page.active_bits[w];
+            // Every active object of the word becomes a zombie.
+            page.zombie_bits[w] |= bits;
+            page.active_bits[w] = 0;
+            while (bits) {
+                size_t i = w * 64 + bitscan_forward64(bits);
+                bits &= bits - 1;
+                page.generations[i] = next_generation(page.generations[i]);
+                mark_indexes(page, i);
+                objects.push_back(static_cast<IObject*>(slot_ptr(page, i)));
+            }
+        }
+    }
+    live_count_ = 0;
+    return objects;
+}
+
+void ObjectHive::release_objects(const std::vector<IObject*>& objects, IExecutor* executor)
+{
+    if (membership().observed()) {
+        std::vector<IObject::Ptr> removed;
+        removed.reserve(objects.size());
+        for (auto* obj : objects) {
+            removed.emplace_back(obj);
+        }
+        membership().removed(std::move(removed));
+        return;
+    }
+    // Each task releases a contiguous range; the slots are reclaimed under the lock as usual.
+    constexpr size_t min_chunk = 256;
+    size_t tasks = executor ? std::min((objects.size() + min_chunk - 1) / min_chunk,
+                                       std::max<size_t>(executor->get_concurrency(), 1) * 4)
+                            : 1;
+    if (tasks <= 1) {
+        for (auto* obj : objects) {
+            obj->unref();
+        }
+        return;
+    }
+    struct Work
+    {
+        IObject* const* objects;
+        size_t count;
+        size_t chunk;
+    } work{objects.data(), objects.size(), (objects.size() + tasks - 1) / tasks};
+    executor->parallel_for(tasks, &work, [](void* ctx, size_t index) {
+        auto& work = *static_cast<Work*>(ctx);
+        size_t end = std::min(work.count, (index + 1) * work.chunk);
+        for (size_t i = index * work.chunk; i < end; ++i) {
+            work.objects[i]->unref();
+        }
+    });
+}
+
+bool ObjectHive::contains(const IObject& object) const
+{
+    std::shared_lock lock(mutex_);
+    size_t slot_idx;
+    return find_slot(&object, slot_idx) != nullptr;
+}
+
+HiveHandle ObjectHive::get_handle(const IObject& object) const
+{
+    std::shared_lock lock(mutex_);
+    size_t slot_idx;
+    HivePage* page = find_slot(&object, slot_idx);
+    if (!page || page->id == NO_PAGE_ID || slot_idx >= (size_t(1) << HiveHandle::SLOT_BITS)) {
+        return {};
+    }
+    return HiveHandle::make(page->id, static_cast<uint32_t>(slot_idx), page->generations[slot_idx]);
+}
+
+IObject* ObjectHive::resolve(HiveHandle handle) const
+{
+    std::shared_lock lock(mutex_);
+    if (!handle || handle.page() >= page_ids_.size()) {
+        return nullptr;
+    }
+    HivePage* page = page_ids_[handle.page()];
+    size_t slot_idx = handle.slot();
+    if (!page || slot_idx >= page->capacity || page->generations[slot_idx] != handle.generation() ||
+        !is_slot_active(page->active_bits, slot_idx / 64, slot_idx % 64)) {
+        return nullptr;
+    }
+    return static_cast<IObject*>(slot_ptr(*page, slot_idx));
+}
+
+/**
+ * @brief Bitmask scan loop with prefetching over a word range of one page.
+ *
+ * For each active slot in words [word_begin, word_end), prefetches the next
+ * active slot at (slot_ptr + prefetch_offset), then calls the visitor.
+ *
+ * @tparam VisitFn bool(void* slot) - return false to stop.
+ * @return false if the visitor stopped the scan.
+ */
+template <class VisitFn>
+bool ObjectHive::scan_words(const HivePage& page, size_t word_begin, size_t word_end,
+                            ptrdiff_t prefetch_offset, VisitFn&& visit) const
+{
+    bool dense = page.live_count == page.capacity;
+    for (size_t w = word_begin; w < word_end; ++w) {
+        uint64_t bits = page.active_bits[w];
+        if (!bits) {
+            continue;
+        }
+        size_t base = w * 64;
+        // Fast path: all 64 slots active, skip bitscan and prefetch.
+        if (bits == ~uint64_t(0)) {
+            for (size_t i = 0; i < 64; ++i) {
+                if (!visit(slot_ptr(page, base + i))) {
+                    return false;
+                }
+            }
+            continue;
+        }
+        while (bits) {
+            unsigned b = bitscan_forward64(bits);
+            bits &= bits - 1;
+            size_t i = base + b;
+            // Re-check the live bit: a visitor callback may have triggered
+            // hive_destroy (via unref) which clears the bit for a slot in
+            // this same word.
+            if (!is_slot_active(page.active_bits, w, b)) {
+                continue;
+            }
+            // Prefetch next active slot (skip for fully dense pages).
+            if (!dense) {
+                uint64_t remaining = bits;
+                if (remaining) {
+                    unsigned nb = bitscan_forward64(remaining);
+                    prefetch_line(static_cast<char*>(slot_ptr(page, base + nb)) + prefetch_offset);
+                } else if (w + 1 < word_end) {
+                    for (size_t nw = w + 1; nw < word_end; ++nw) {
+                        uint64_t next_bits = page.active_bits[nw];
+                        if (next_bits) {
+                            prefetch_line(static_cast<char*>(
+                                              slot_ptr(page, nw * 64 + bitscan_forward64(next_bits))) +
+                                          prefetch_offset);
+                            break;
+                        }
+                    }
+                }
+            }
+            if (!visit(slot_ptr(page, i))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Shared bitmask scan loop with prefetching.
  *
- * @tparam VisitFn bool(IObject* obj, size_t slot_index) - return false to stop.
+ * Iterates all active slots across all pages. For each active slot, prefetches
+ * the next active slot at (slot_ptr + prefetch_offset), then calls the visitor.
+ * The visitor returns false to stop early.
+ *
+ * @tparam VisitFn bool(void* slot) - return false to stop.
  */
 template <class VisitFn>
 void ObjectHive::scan_active(ptrdiff_t prefetch_offset, VisitFn&& visit) const
 {
     for (auto& page_ptr : pages_) {
         auto& page = *page_ptr;
-        bool dense = page.live_count == page.capacity;
+        if (!scan_words(page, 0, bitmask_words(page.capacity), prefetch_offset, visit)) {
+            return;
+        }
+    }
+}
+
+void ObjectHive::for_each(void* context, VisitorFn visitor) const
+{
+    VELK_TRACE_ZONE("ObjectHive::for_each");
+    std::shared_lock lock(mutex_);
+    IterationGuard guard(&mutex_);
+    scan_active(0, [&](void* slot) { return visitor(context, *static_cast<IObject*>(slot)); });
+}
+
+void ObjectHive::for_each_state(ptrdiff_t state_offset, void* context, StateVisitorFn visitor) const
+{
+    VELK_TRACE_ZONE("ObjectHive::for_each_state");
+    std::shared_lock lock(mutex_);
+    IterationGuard guard(&mutex_);
+    scan_active(state_offset, [&](void* slot) {
+        auto* obj = static_cast<IObject*>(slot);
+        return visitor(context, *obj, reinterpret_cast<char*>(slot) + state_offset);
+    });
+}
+
+void ObjectHive::for_each_state_parallel(ptrdiff_t state_offset, void* context, StateVisitorFn visitor,
+                                         IExecutor* executor) const
+{
+    VELK_TRACE_ZONE("ObjectHive::for_each_state_parallel");
+    std::shared_lock lock(mutex_);
+    IterationGuard guard(&mutex_);
+    parallel_scan(pages_, &mutex_, executor, [&](const HivePage& page, size_t word_begin, size_t word_end) {
+        return scan_words(page, word_begin, word_end, state_offset, [&](void* slot) {
+            auto* obj = static_cast<IObject*>(slot);
+            return visitor(context, *obj, reinterpret_cast<char*>(slot) + state_offset);
+        });
+    });
+}
+
+ReturnValue ObjectHive::add_state_column(Uid interfaceUid, size_t state_size, size_t state_alignment)
+{
+    return add_column(interfaceUid, state_size, state_alignment, false);
+}
+
+ReturnValue ObjectHive::add_double_buffered_state(Uid interfaceUid, size_t state_size, size_t state_alignment)
+{
+    return add_column(interfaceUid, state_size, state_alignment, true);
+}
+
+ReturnValue ObjectHive::add_column(Uid interfaceUid, size_t state_size, size_t state_alignment,
+                                   bool double_buffered)
+{
+    if (!factory_ || !state_size || !state_alignment || (state_alignment & (state_alignment - 1))) {
+        return ReturnValue::InvalidArgument;
+    }
+
+    check_iteration_guard(mutex_, double_buffered ? string_view("add_double_buffered_state")
+                                                  : string_view("add_state_column"));
+
+    std::lock_guard<HiveMutex> lock(mutex_);
+    size_t c = column_index(interfaceUid);
+    if (c < state_columns_.size() && (state_columns_[c].double_buffered || !double_buffered)) {
+        return ReturnValue::NothingToDo;
+    }
+    if (!pages_.empty()) {
+        return ReturnValue::Fail;
+    }
+    if (c < state_columns_.size()) {
+        // Give an existing column its front copy.
+        state_columns_[c].double_buffered = true;
+        return ReturnValue::Success;
+    }
+
+    ptrdiff_t inline_offset = inline_state_offset(interfaceUid);
+    if (inline_offset < 0) {
+        return ReturnValue::InvalidArgument;
+    }
+    state_columns_.push_back({interfaceUid, state_size, state_alignment, align_up(state_size, state_alignment),
+                              inline_offset, double_buffered});
+    return ReturnValue::Success;
+}
+
+void ObjectHive::swap_state_buffers()
+{
+    VELK_TRACE_ZONE("ObjectHive::swap_state_buffers");
+    check_iteration_guard(mutex_, "swap_state_buffers");
+
+    // The exclusive lock waits for readers of the front copies to finish.
+    std::lock_guard<HiveMutex> lock(mutex_);
+    for (size_t c = 0; c < state_columns_.size(); ++c) {
+        if (!state_columns_[c].double_buffered) {
+            continue;
+        }
+        // Copying whole columns keeps the copy a single streaming memcpy per page; entries
+        // of free slots are never read.
+        for (auto& page : pages_) {
+            if (page->live_count) {
+                auto& column = page->columns[c];
+                std::memcpy(column.front, column.base, page->capacity * column.stride);
+            }
+        }
+    }
+}
+
+bool ObjectHive::has_state_column(Uid interfaceUid) const
+{
+    std::shared_lock lock(mutex_);
+    return column_index(interfaceUid) < state_columns_.size();
+}
+
+size_t ObjectHive::column_index(Uid interfaceUid) const
+{
+    size_t c = 0;
+    while (c < state_columns_.size() && state_columns_[c].uid != interfaceUid) {
+        ++c;
+    }
+    return c;
+}
+
+ptrdiff_t ObjectHive::inline_state_offset(Uid interfaceUid) const
+{
+    std::call_once(state_offsets_once_, [this] { compute_state_offsets(); });
+    for (auto& [uid, offset] : state_offsets_) {
+        if (uid == interfaceUid) {
+            return offset;
+        }
+    }
+    return -1;
+}
+
+void ObjectHive::compute_state_offsets() const
+{
+    if (!factory_) {
+        return;
+    }
+    // All objects share the class layout: locate the inline States on a prototype.
+    auto prototype = factory_->create_instance();
+    auto* ps = interface_cast<IPropertyState>(prototype.get());
+    if (!ps) {
+        return;
+    }
+    for (auto& info : factory_->get_class_info().interfaces) {
+        if (void* state = ps->get_property_state(info.uid)) {
+            state_offsets_.emplace_back(info.uid,
+                                        static_cast<ptrdiff_t>(reinterpret_cast<uintptr_t>(state) -
+                                                               reinterpret_cast<uintptr_t>(prototype.get())));
+        }
+    }
+}
+
+ptrdiff_t ObjectHive::get_state_offset(Uid interfaceUid) const
+{
+    return has_state_column(interfaceUid) ? -1 : inline_state_offset(interfaceUid);
+}
+
+void ObjectHive::for_each_page(void* context, PageVisitorFn visitor, IExecutor* executor) const
+{
+    VELK_TRACE_ZONE("ObjectHive::for_each_page");
+    std::shared_lock lock(mutex_);
+    IterationGuard guard(&mutex_);
+    auto visit = [&](const HivePage& page, size_t word_begin, size_t word_end) {
+        size_t first = word_begin * 64;
+        size_t end = word_end * 64 < page.capacity ? word_end * 64 : page.capacity;
+        HivePageView view{slot_ptr(page, first), slot_size_, page.active_bits + word_begin, end - first};
+        return visitor(context, view);
+    };
+
+    if (executor) {
+        parallel_scan(pages_, &mutex_, executor, visit);
+        return;
+    }
+    for (auto& page_ptr : pages_) {
+        auto& page = *page_ptr;
+        if (page.live_count && !visit(page, 0, bitmask_words(page.capacity))) {
+            return;
+        }
+    }
+}
+
+void ObjectHive::for_each_column(Uid interfaceUid, void* context, ColumnVisitorFn visitor,
+                                 IExecutor* executor) const
+{
+    VELK_TRACE_ZONE("ObjectHive::for_each_column");
+    visit_column(interfaceUid, false, context, visitor, executor);
+}
+
+void ObjectHive::for_each_front(Uid interfaceUid, void* context, ColumnVisitorFn visitor,
+                                IExecutor* executor) const
+{
+    VELK_TRACE_ZONE("ObjectHive::for_each_front");
+    visit_column(interfaceUid, true, context, visitor, executor);
+}
+
+void ObjectHive::visit_column(Uid interfaceUid, bool front, void* context, ColumnVisitorFn visitor,
+                              IExecutor* executor) const
+{
+    std::shared_lock lock(mutex_);
+    IterationGuard guard(&mutex_);
+    size_t c = column_index(interfaceUid);
+    if (c == state_columns_.size()) {
+        return;
+    }
+
+    auto visit = [&](const HivePage& page, size_t word_begin, size_t word_end) {
+        size_t first = word_begin * 64;
+        size_t end = word_end * 64 < page.capacity ? word_end * 64 : page.capacity;
+        auto& column = page.columns[c];
+        HivePageView objects{static_cast<char*>(page.slots) + first * slot_size_,
+                             slot_size_,
+                             page.active_bits + word_begin,
+                             end - first};
+        HivePageView states{(front ? column.front : column.base) + first * column.stride,
+                            column.stride,
+                            page.active_bits + word_begin,
+                            end - first};
+        return visitor(context, objects, states);
+    };
+
+    if (executor) {
+        parallel_scan(pages_, &mutex_, executor, visit);
+        return;
+    }
+    for (auto& page_ptr : pages_) {
+        auto& page = *page_ptr;
+        if (page.live_count && !visit(page, 0, bitmask_words(page.capacity))) {
+            return;
+        }
+    }
+}
+
+VELK_EXPORT void* detail::hive_state_column(const control_block* block, Uid interfaceUid)
+{
+    auto* hcb = reinterpret_cast<const HiveControlBlock*>(static_cast<const external_control_block*>(block));
+    HivePage* page = hcb->page;
+    size_t slot_index = static_cast<size_t>(hcb - page->hcbs);
+    for (auto& column : page->columns) {
+        if (column.uid == interfaceUid) {
+            return column.base + slot_index * column.stride;
+        }
+    }
+    return nullptr;
+}
+
+ReturnValue ObjectHive::add_dirty_tracking(Uid interfaceUid)
+{
+    if (!factory_) {
+        return ReturnValue::InvalidArgument;
+    }
+
+    check_iteration_guard(mutex_, "add_dirty_tracking");
+
+    std::lock_guard<HiveMutex> lock(mutex_);
+    size_t d = dirty_index(interfaceUid);
+    if (d < dirty_tracking_.size() && dirty_tracking_[d].tracked) {
+        return ReturnValue::NothingToDo;
+    }
+    if (!pages_.empty()) {
+        return ReturnValue::Fail;
+    }
+    auto* tracking = get_or_add_dirty_tracking(interfaceUid);
+    if (!tracking) {
+        return ReturnValue::InvalidArgument;
+    }
+    tracking->tracked = true;
+    return ReturnValue::Success;
+}
+
+ObjectHive::DirtyTracking* ObjectHive::get_or_add_dirty_tracking(Uid interfaceUid)
+{
+    size_t d = dirty_index(interfaceUid);
+    if (d < dirty_tracking_.size()) {
+        return &dirty_tracking_[d];
+    }
+    ptrdiff_t inline_offset = inline_state_offset(interfaceUid);
+    if (inline_offset < 0) {
+        return nullptr;
+    }
+    return &dirty_tracking_.emplace_back(DirtyTracking{interfaceUid, inline_offset, false, false});
+}
+
+bool ObjectHive::has_dirty_tracking(Uid interfaceUid) const
+{
+    std::shared_lock lock(mutex_);
+    size_t d = dirty_index(interfaceUid);
+    return d < dirty_tracking_.size() && dirty_tracking_[d].tracked;
+}
+
+size_t ObjectHive::dirty_index(Uid interfaceUid) const
+{
+    size_t d = 0;
+    while (d < dirty_tracking_.size() && dirty_tracking_[d].uid != interfaceUid) {
+        ++d;
+    }
+    return d;
+}
+
+size_t ObjectHive::for_each_dirty(Uid interfaceUid, void* context, StateVisitorFn visitor)
+{
+    VELK_TRACE_ZONE("ObjectHive::for_each_dirty");
+    std::shared_lock lock(mutex_);
+    IterationGuard guard(&mutex_);
+    size_t d = dirty_index(interfaceUid);
+    if (d == dirty_tracking_.size() || !dirty_tracking_[d].tracked) {
+        return 0;
+    }
+    size_t c = column_index(interfaceUid);
+
+    size_t visited = 0;
+    for (auto& page_ptr : pages_) {
+        auto& page = *page_ptr;
+        auto* dirty = page.dirty[d].bits;
         size_t num_words = bitmask_words(page.capacity);
         for (size_t w = 0; w < num_words; ++w) {
-            uint64_t bits = page.active_bits[w];
-            if (!bits) {
+            // Skip clean words without taking the cache line for writing.
+            if (!dirty[w].load(std::memory_order_relaxed)) {
                 continue;
             }
-            size_t base = w * 64;
-            // Fast path: all 64 slots active, skip bitscan and prefetch.
-            if (bits == ~uint64_t(0)) {
-                for (size_t i = 0; i < 64; ++i) {
-                    if (!visit(slot_ptr(page, base + i))) {
-                        return;
+            // Zombies may still be marked: clear their bits along with the live ones.
+            uint64_t bits = dirty[w].exchange(0, std::memory_order_acquire) & page.active_bits[w];
+            while (bits) {
+                unsigned b = bitscan_forward64(bits);
+                bits &= bits - 1;
+                // The visitor may have removed an object of this word.
+                if (!is_slot_active(page.active_bits, w, b)) {
+                    continue;
+                }
+                size_t i = w * 64 + b;
+                void* slot = slot_ptr(page, i);
+                void* state = state_ptr(page, i, c, dirty_tracking_[d]);
+                ++visited;
+                if (!visitor(context, *static_cast<IObject*>(slot), state)) {
+                    if (bits) {
+                        dirty[w].fetch_or(bits, std::memory_order_relaxed);
                     }
+                    return visited;
                 }
+            }
+        }
+    }
+    return visited;
+}
+
+ReturnValue ObjectHive::add_change_journal(Uid interfaceUid, size_t state_size, size_t state_alignment)
+{
+    if (!factory_ || !state_size || !state_alignment || (state_alignment & (state_alignment - 1))) {
+        return ReturnValue::InvalidArgument;
+    }
+
+    check_iteration_guard(mutex_, "add_change_journal");
+
+    std::lock_guard<HiveMutex> lock(mutex_);
+    size_t d = dirty_index(interfaceUid);
+    if (d < dirty_tracking_.size() && dirty_tracking_[d].journaled) {
+        return ReturnValue::NothingToDo;
+    }
+    if (!pages_.empty()) {
+        return ReturnValue::Fail;
+    }
+
+    // A property's index counts every member the interface declares, as its metadata does.
+    std::vector<JournalField> fields;
+    uint32_t member = 0;
+    for (auto& desc : factory_->get_class_info().members) {
+        if (!desc.interfaceInfo || desc.interfaceInfo->uid != interfaceUid) {
+            continue;
+        }
+        auto* pk = desc.kind == MemberKind::Property ? desc.propertyKind() : nullptr;
+        const IAny* def = pk && pk->stateOffset && pk->getDefault ? pk->getDefault() : nullptr;
+        if (def) {
+            size_t offset = pk->stateOffset();
+            size_t field_size = def->get_data_size(pk->typeUid);
+            if (!field_size || offset + field_size > state_size) {
+                return ReturnValue::InvalidArgument;
+            }
+            fields.push_back({member, static_cast<uint32_t>(offset), static_cast<uint32_t>(field_size)});
+        }
+        ++member;
+    }
+    auto* tracking = get_or_add_dirty_tracking(interfaceUid);
+    if (!tracking) {
+        return ReturnValue::InvalidArgument;
+    }
+    tracking->journaled = true;
+    tracking->state_size = state_size;
+    tracking->state_alignment = state_alignment;
+    tracking->fields = std::move(fields);
+    return ReturnValue::Success;
+}
+
+template <class Fn>
+void ObjectHive::visit_changes(size_t d, bool consume, Fn&& fn)
+{
+    auto& tracking = dirty_tracking_[d];
+    size_t c = column_index(tracking.uid);
+    size_t stride = align_up(tracking.state_size, tracking.state_alignment);
+    for (auto& page_ptr : pages_) {
+        auto& page = *page_ptr;
+        // Objects that handles cannot address cannot be journaled.
+        if (page.id == NO_PAGE_ID) {
+            continue;
+        }
+        auto* marks = page.dirty[d].journal_bits;
+        size_t num_words = bitmask_words(page.capacity);
+        for (size_t w = 0; w < num_words; ++w) {
+            if (!marks[w].load(std::memory_order_relaxed)) {
                 continue;
             }
+            // Zombies may still be marked: clear their bits along with the live ones.
+            uint64_t bits = (consume ? marks[w].exchange(0, std::memory_order_acquire)
+                                     : marks[w].load(std::memory_order_acquire)) &
+                            page.active_bits[w];
             while (bits) {
                 unsigned b = bitscan_forward64(bits);
                 bits &= bits - 1;
-                size_t i = base + b;
-                // Re-check the live bit: a visitor callback may have triggered
-                // hive_destroy (via unref) which clears the bit for a slot in
-                // this same word.
-                if (!is_slot_active(page.active_bits, w, b)) {
-                    continue;
+                size_t i = w * 64 + b;
+                if (i >= (size_t(1) << HiveHandle::SLOT_BITS)) {
+                    break;
                 }
-                // Prefetch next active slot (skip for fully dense pages).
-                if (!dense) {
-                    uint64_t remaining = bits;
-                    if (remaining) {
-                        unsigned nb = bitscan_forward64(remaining);
-                        prefetch_line(static_cast<char*>(slot_ptr(page, base + nb)) + prefetch_offset);
-                    } else if (w + 1 < num_words) {
-                        for (size_t nw = w + 1; nw < num_words; ++nw) {
-                            uint64_t next_bits = page.active_bits[nw];
-                            if (next_bits) {
-                                prefetch_line(static_cast<char*>(
-                                                  slot_ptr(page, nw * 64 + bitscan_forward64(next_bits))) +
-                                              prefetch_offset);
-                                break;
-                            }
-                        }
+                const char* state = static_cast<const char*>(state_ptr(page, i, c, tracking));
+                char* journaled = page.dirty[d].journaled + i * stride;
+                for (auto& field : tracking.fields) {
+                    if (std::memcmp(state + field.offset, journaled + field.offset, field.size) != 0) {
+                        fn(page, i, state, journaled, field);
                     }
                 }
-                if (!visit(slot_ptr(page, i))) {
-                    return;
+            }
+        }
+    }
+}
+
+size_t ObjectHive::write_changes(Uid interfaceUid, void* buffer, size_t size)
+{
+    VELK_TRACE_ZONE("ObjectHive::write_changes");
+    check_iteration_guard(mutex_, "write_changes");
+
+    // The exclusive lock keeps two writers from journaling the same change.
+    std::lock_guard<HiveMutex> lock(mutex_);
+    size_t d = dirty_index(interfaceUid);
+    if (d == dirty_tracking_.size() || !dirty_tracking_[d].journaled) {
+        return 0;
+    }
+
+    // Size the journal first, so that nothing is consumed if it does not fit.
+    size_t total = sizeof(HiveJournalHeader);
+    visit_changes(d, false, [&](HivePage&, size_t, const char*, char*, const JournalField& field) {
+        total += sizeof(HiveJournalRecord) + align_up(field.size, 8);
+    });
+    if (!buffer || total > size) {
+        return total;
+    }
+
+    char* out = static_cast<char*>(buffer);
+    size_t pos = sizeof(HiveJournalHeader);
+    size_t count = 0;
+    visit_changes(d, true, [&](HivePage& page, size_t i, const char* state, char* journaled,
+                               const JournalField& field) {
+        size_t value_size = align_up(field.size, 8);
+        if (pos + sizeof(HiveJournalRecord) + value_size > size) {
+            // A write overlapping the call changed another property: keep it for the next call.
+            page.dirty[d].journal_bits[i / 64].fetch_or(uint64_t(1) << (i % 64), std::memory_order_relaxed);
+            return;
+        }
+        HiveJournalRecord record{HiveHandle::make(page.id, i, page.generations[i]).value, field.member,
+                                 field.size};
+        std::memcpy(out + pos, &record, sizeof(record));
+        pos += sizeof(record);
+        std::memcpy(out + pos, state + field.offset, field.size);
+        std::memset(out + pos + field.size, 0, value_size - field.size);
+        pos += value_size;
+        std::memcpy(journaled + field.offset, state + field.offset, field.size);
+        ++count;
+    });
+
+    HiveJournalHeader header;
+    header.interface_uid = interfaceUid;
+    header.state_size = dirty_tracking_[d].state_size;
+    header.count = count;
+    header.size = pos;
+    std::memcpy(out, &header, sizeof(header));
+    return pos;
+}
+
+DirtyBit hive_dirty_bit(const control_block* block, Uid interfaceUid)
+{
+    auto* hcb = reinterpret_cast<const HiveControlBlock*>(static_cast<const external_control_block*>(block));
+    HivePage* page = hcb->page;
+    size_t slot_index = static_cast<size_t>(hcb - page->hcbs);
+    for (auto& dirty : page->dirty) {
+        if (dirty.uid == interfaceUid) {
+            size_t word = slot_index / 64;
+            return {dirty.bits ? dirty.bits + word : nullptr, dirty.index_bits ? dirty.index_bits + word : nullptr,
+                    dirty.journal_bits ? dirty.journal_bits + word : nullptr, uint64_t(1) << (slot_index % 64)};
+        }
+    }
+    return {};
+}
+
+void* ObjectHive::state_ptr(const HivePage& page, size_t slot_index, size_t column,
+                            const DirtyTracking& tracking) const
+{
+    if (column < page.columns.size()) {
+        return page.columns[column].base + slot_index * page.columns[column].stride;
+    }
+    return static_cast<char*>(slot_ptr(page, slot_index)) + tracking.inline_offset;
+}
+
+void ObjectHive::mark_indexes(HivePage& page, size_t slot_index)
+{
+    for (auto& dirty : page.dirty) {
+        if (dirty.index_bits) {
+            dirty.index_bits[slot_index / 64].fetch_or(uint64_t(1) << (slot_index % 64), std::memory_order_relaxed);
+        }
+    }
+}
+
+ReturnValue ObjectHive::add_index(const HiveIndexDesc& desc)
+{
+    if (!factory_) {
+        return ReturnValue::InvalidArgument;
+    }
+
+    check_iteration_guard(mutex_, "add_index");
+
+    std::lock_guard<HiveMutex> lock(mutex_);
+    for (auto& index : indexes_) {
+        if (index.desc().interfaceUid == desc.interfaceUid && index.desc().field_offset == desc.field_offset) {
+            return ReturnValue::NothingToDo;
+        }
+    }
+    if (!pages_.empty()) {
+        return ReturnValue::Fail;
+    }
+    size_t size = desc.field_size;
+    bool valid_size = desc.key_type == HiveKeyType::Float ? size == sizeof(float) || size == sizeof(double)
+                                                          : size == 1 || size == 2 || size == 4 || size == 8;
+    ptrdiff_t inline_offset = inline_state_offset(desc.interfaceUid);
+    if (!valid_size || inline_offset < 0) {
+        return ReturnValue::InvalidArgument;
+    }
+    // The inline State is only known to end with the object.
+    size_t c = column_index(desc.interfaceUid);
+    size_t state_size = c < state_columns_.size() ? state_columns_[c].size : slot_size_ - inline_offset;
+    if (desc.field_offset + size > state_size) {
+        return ReturnValue::InvalidArgument;
+    }
+    get_or_add_dirty_tracking(desc.interfaceUid)->indexed = true;
+    indexes_.emplace_back(desc);
+    return ReturnValue::Success;
+}
+
+void ObjectHive::refresh_indexes(Uid interfaceUid) const
+{
+    size_t d = dirty_index(interfaceUid);
+    size_t c = column_index(interfaceUid);
+    for (auto& page_ptr : pages_) {
+        auto& page = *page_ptr;
+        if (page.id == NO_PAGE_ID) {
+            continue;
+        }
+        auto* marks = page.dirty[d].index_bits;
+        size_t num_words = bitmask_words(page.capacity);
+        for (size_t w = 0; w < num_words; ++w) {
+            if (!marks[w].load(std::memory_order_relaxed)) {
+                continue;
+            }
+            uint64_t bits = marks[w].exchange(0, std::memory_order_acquire);
+            while (bits) {
+                size_t i = w * 64 + bitscan_forward64(bits);
+                bits &= bits - 1;
+                uint64_t position = (uint64_t(page.id) << HiveHandle::SLOT_BITS) | i;
+                bool active = is_slot_active(page.active_bits, w, i % 64);
+                void* state = active ? state_ptr(page, i, c, dirty_tracking_[d]) : nullptr;
+                for (auto& index : indexes_) {
+                    if (index.desc().interfaceUid != interfaceUid) {
+                        continue;
+                    }
+                    if (active) {
+                        index.update(position, state);
+                    } else {
+                        index.erase(position);
+                    }
                 }
             }
         }
     }
 }
 
-void ObjectHive::for_each(void* context, VisitorFn visitor) const
+size_t ObjectHive::find_indexed(Uid interfaceUid, size_t field_offset, uint64_t first, uint64_t last,
+                                void* context, StateVisitorFn visitor) const
 {
+    VELK_TRACE_ZONE("ObjectHive::find_indexed");
     std::shared_lock lock(mutex_);
     IterationGuard guard(&mutex_);
-    scan_active(0, [&](void* slot) { return visitor(context, *static_cast<IObject*>(slot)); });
+    std::vector<uint64_t> positions;
+    {
+        std::lock_guard<std::mutex> index_lock(index_mutex_);
+        auto it = std::find_if(indexes_.begin(), indexes_.end(), [&](const HiveIndex& index) {
+            return index.desc().interfaceUid == interfaceUid && index.desc().field_offset == field_offset;
+        });
+        if (it == indexes_.end()) {
+            return 0;
+        }
+        refresh_indexes(interfaceUid);
+        it->find(first, last, positions);
+    }
+
+    size_t d = dirty_index(interfaceUid);
+    size_t c = column_index(interfaceUid);
+    size_t visited = 0;
+    for (uint64_t position : positions) {
+        auto& page = *page_ids_[position >> HiveHandle::SLOT_BITS];
+        size_t i = position & ((uint64_t(1) << HiveHandle::SLOT_BITS) - 1);
+        ++visited;
+        if (!visitor(context, *static_cast<IObject*>(slot_ptr(page, i)), state_ptr(page, i, c, dirty_tracking_[d]))) {
+            break;
+        }
+    }
+    return visited;
 }
 
-void ObjectHive::for_each_state(ptrdiff_t state_offset, void* context, StateVisitorFn visitor) const
+IEvent::Ptr ObjectHive::on_membership_changed() const
+{
+    return membership_.event(get_self<IObjectHive>());
+}
+
+ReturnValue ObjectHive::set_threading(HiveThreading threading)
+{
+    check_iteration_guard(mutex_, "set_threading");
+    mutex_.set_single_thread(threading == HiveThreading::SingleThread);
+    return ReturnValue::Success;
+}
+
+HiveThreading ObjectHive::get_threading() const
+{
+    return mutex_.single_thread() ? HiveThreading::SingleThread : HiveThreading::MultiThread;
+}
+
+VELK_EXPORT void detail::hive_mark_dirty(const control_block* block, Uid interfaceUid)
+{
+    hive_dirty_bit(block, interfaceUid).mark();
+}
+
+size_t ObjectHive::snapshot_states(Uid interfaceUid, size_t state_size, void* buffer, size_t size) const
 {
     std::shared_lock lock(mutex_);
-    IterationGuard guard(&mutex_);
-    scan_active(state_offset, [&](void* slot) {
-        auto* obj = static_cast<IObject*>(slot);
-        return visitor(context, *obj, reinterpret_cast<char*>(slot) + state_offset);
-    });
+    size_t c = column_index(interfaceUid);
+    bool column = c < state_columns_.size();
+    ptrdiff_t offset = column ? 0 : inline_state_offset(interfaceUid);
+    if (!state_size || offset < 0 || (column && state_columns_[c].size != state_size)) {
+        return 0;
+    }
+    size_t total = sizeof(HiveSnapshotHeader) + live_count_ * state_size;
+    if (!buffer || size < total) {
+        return total;
+    }
+
+    HiveSnapshotHeader header;
+    header.element_uid = interfaceUid;
+    header.element_size = state_size;
+    header.count = live_count_;
+    header.size = total;
+    std::memcpy(buffer, &header, sizeof(header));
+
+    auto* out = static_cast<char*>(buffer) + sizeof(header);
+    for (auto& page_ptr : pages_) {
+        auto& page = *page_ptr;
+        size_t num_words = bitmask_words(page.capacity);
+        for (size_t w = 0; w < num_words; ++w) {
+            uint64_t bits = page.active_bits[w];
+            while (bits) {
+                size_t i = w * 64 + bitscan_forward64(bits);
+                bits &= bits - 1;
+                const char* state = column ? page.columns[c].base + i * state_columns_[c].stride
+                                           : static_cast<const char*>(slot_ptr(page, i)) + offset;
+                std::memcpy(out, state, state_size);
+                out += state_size;
+            }
+        }
+    }
+    return total;
+}
+
+ReturnValue ObjectHive::restore_states(Uid interfaceUid, size_t state_size, const void* buffer, size_t size)
+{
+    HiveSnapshotHeader header;
+    if (!factory_ || !buffer || size < sizeof(header)) {
+        return ReturnValue::InvalidArgument;
+    }
+    std::memcpy(&header, buffer, sizeof(header));
+    if (header.magic != HiveSnapshotHeader::MAGIC || header.version != HiveSnapshotHeader::VERSION ||
+        header.element_uid != interfaceUid || header.element_size != state_size || header.page_count ||
+        !state_size || header.count > (size - sizeof(header)) / state_size) {
+        return ReturnValue::InvalidArgument;
+    }
+
+    check_iteration_guard(mutex_, "restore_states");
+
+    std::lock_guard<HiveMutex> lock(mutex_);
+    size_t c = column_index(interfaceUid);
+    bool column = c < state_columns_.size();
+    ptrdiff_t offset = column ? 0 : inline_state_offset(interfaceUid);
+    if (offset < 0 || (column && state_columns_[c].size != state_size)) {
+        return ReturnValue::InvalidArgument;
+    }
+    if (!header.count) {
+        return ReturnValue::NothingToDo;
+    }
+
+    // Reserve every slot up front so the loop never allocates.
+    reserve_slots(header.count);
+
+    const char* in = static_cast<const char*>(buffer) + sizeof(header);
+    HivePage* target = current_page_;
+    for (size_t i = 0; i < header.count; ++i, in += state_size) {
+        if (!target || target->free_head == PAGE_SENTINEL) {
+            target = free_pages_.head;
+        }
+        auto obj = construct_object(*target);
+        if (membership().observed()) {
+            membership().added(&obj, 1);
+        }
+        auto* slot = reinterpret_cast<char*>(obj.get());
+        char* state = slot + offset;
+        if (column) {
+            size_t slot_idx = static_cast<size_t>(slot - static_cast<char*>(target->slots)) / slot_size_;
+            state = target->columns[c].base + slot_idx * state_columns_[c].stride;
+            if (state_columns_[c].double_buffered) {
+                std::memcpy(target->columns[c].front + slot_idx * state_columns_[c].stride, in, state_size);
+            }
+        }
+        std::memcpy(state, in, state_size);
+    }
+    current_page_ = target;
+    return ReturnValue::Success;
 }
 
 } // namespace velk
@@ -1,6 +1,8 @@
 #ifndef VELK_PLUGINS_OBJECT_HIVE_H
 #define VELK_PLUGINS_OBJECT_HIVE_H
 
+#include "hive_index.h"
+#include "hive_membership.h"
 #include "page_allocator.h"
 
 #include <velk/ext/core_object.h>
@@ -10,35 +12,64 @@
 #include <atomic>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <vector>
 
 namespace velk {
 
-enum class SlotState : uint8_t
+struct HiveControlBlock;
+class ObjectHive;
+
+/** @brief Location of one state column in a page (see ObjectHive::add_state_column()). */
+struct PageColumn
 {
-    Active = 0,
-    Zombie = 1,
-    Free = 2
+    Uid uid;       ///< Interface whose State is stored in the column.
+    char* base;    ///< Column entry of slot 0 (points into allocation).
+    char* front;   ///< Published copy of the column if double buffered, else equal to base.
+    size_t stride; ///< Byte distance between column entries.
 };
 
-struct HiveControlBlock;
+/** @brief Dirty bitmask of one tracked interface in a page (see ObjectHive::add_dirty_tracking()). */
+struct PageDirtyBits
+{
+    Uid uid;                           ///< Interface whose changes the bitmask tracks.
+    std::atomic<uint64_t>* bits;         ///< 1 bit per slot, set = dirty (points into allocation).
+    std::atomic<uint64_t>* index_bits;   ///< Marks not yet read by the indexes of the interface.
+    std::atomic<uint64_t>* journal_bits; ///< Marks not yet journaled (see ObjectHive::add_change_journal()).
+    char* journaled;                     ///< State of each slot as last journaled, or null.
+};
+
+/** @brief Page id of a page that handles cannot address. */
+inline constexpr uint32_t NO_PAGE_ID = ~uint32_t(0);
 
 struct HivePage
 {
     void* allocation{nullptr};              ///< Single aligned allocation for all arrays + slots.
-    SlotState* state{nullptr};              ///< Per-slot state array (points into allocation).
+    size_t allocation_size{0};              ///< Size of allocation in bytes.
+    size_t allocation_alignment{0};         ///< Alignment of allocation in bytes.
+    IHivePageSource::Ptr page_source;       ///< Source that owns allocation (null for heap memory).
+    int numa_node{-1};                      ///< NUMA node of allocation (-1 if unknown or several).
     uint64_t* active_bits{nullptr};         ///< Bitmask: 1 bit per slot, set = Active.
+    uint64_t* zombie_bits{nullptr};         ///< Bitmask: 1 bit per slot, set = Zombie (unused once orphaned).
+    uint32_t* generations{nullptr};         ///< Generation of each slot for HiveHandle (points into allocation).
+    uint32_t id{NO_PAGE_ID};                ///< Index in ObjectHive::page_ids_, or NO_PAGE_ID.
     HiveControlBlock* hcbs{nullptr};        ///< Contiguous HCB array (embedded, points into allocation).
     void* slots{nullptr};                   ///< Aligned contiguous slot memory (points into allocation).
     size_t capacity{0};                     ///< Total slots in page.
     size_t free_head{PAGE_SENTINEL};        ///< Intrusive freelist head.
     size_t live_count{0};                   ///< Active + Zombie count.
+    size_t weak_free_count{0};              ///< Dead slots kept off the freelist until hive_weak_release.
     size_t slot_size{0};                    ///< Aligned slot size in bytes.
     const IObjectFactory* factory{nullptr}; ///< Factory for objects in this page.
-    std::atomic<size_t> weak_hcb_count{0};  ///< Embedded HCBs with outstanding weak_ptrs (orphan tracking).
-    std::shared_mutex* hive_mutex{nullptr}; ///< Points to owning ObjectHive's mutex (null when orphaned).
+    std::atomic<size_t> weak_hcb_count{0};  ///< Embedded HCBs with outstanding weak_ptrs (orphans).
+    ObjectHive* hive{nullptr};              ///< Owning ObjectHive (null when orphaned).
+    HivePage* prev_free{nullptr};           ///< Previous page in the hive's free-page list.
+    HivePage* next_free{nullptr};           ///< Next page in the hive's free-page list.
+    bool in_free_list{false};               ///< True if linked into the hive's free-page list.
     bool orphaned{false};                   ///< Page detached from Hive (destructor ran).
+    std::vector<PageColumn> columns;        ///< State columns, in ObjectHive::state_columns_ order.
+    std::vector<PageDirtyBits> dirty;       ///< Dirty bitmasks, in ObjectHive::dirty_tracking_ order.
 };
 
 /**
@@ -67,48 +98,318 @@ public:
     bool empty() const override;
     void clear() override;
     HivePageCapacity get_page_capacity() const override;
+    HiveStats get_stats() const override;
     void set_page_capacity(const HivePageCapacity& capacity) override;
+    size_t get_slot_alignment() const override;
+    ReturnValue set_slot_alignment(size_t alignment) override;
+    IHivePageSource::Ptr get_page_source() const override;
+    void set_page_source(const IHivePageSource::Ptr& source) override;
+    size_t trim(size_t keep_free_slots) override;
+    ReturnValue reserve(size_t free_slots) override;
+    void for_each_page(void* context, PageVisitorFn visitor, IExecutor* executor) const override;
 
     // IObjectHive overrides
     IObject::Ptr add() override;
+    size_t add_n(size_t count, IObject::Ptr* out) override;
     ReturnValue remove(IObject& object) override;
+    void clear_parallel(IExecutor* executor, HivePageRelease release) override;
     bool contains(const IObject& object) const override;
+    HiveHandle get_handle(const IObject& object) const override;
+    IObject* resolve(HiveHandle handle) const override;
     void for_each(void* context, VisitorFn visitor) const override;
+    ptrdiff_t get_state_offset(Uid interfaceUid) const override;
     void for_each_state(ptrdiff_t state_offset, void* context, StateVisitorFn visitor) const override;
+    void for_each_state_parallel(ptrdiff_t state_offset, void* context, StateVisitorFn visitor,
+                                 IExecutor* executor) const override;
+    size_t compact() override;
+    ReturnValue add_state_column(Uid interfaceUid, size_t state_size, size_t state_alignment) override;
+    bool has_state_column(Uid interfaceUid) const override;
+    void for_each_column(Uid interfaceUid, void* context, ColumnVisitorFn visitor,
+                         IExecutor* executor) const override;
+    ReturnValue add_double_buffered_state(Uid interfaceUid, size_t state_size,
+                                          size_t state_alignment) override;
+    void for_each_front(Uid interfaceUid, void* context, ColumnVisitorFn visitor,
+                        IExecutor* executor) const override;
+    void swap_state_buffers() override;
+    size_t snapshot_states(Uid interfaceUid, size_t state_size, void* buffer, size_t size) const override;
+    ReturnValue restore_states(Uid interfaceUid, size_t state_size, const void* buffer, size_t size) override;
+    ReturnValue add_dirty_tracking(Uid interfaceUid) override;
+    bool has_dirty_tracking(Uid interfaceUid) const override;
+    size_t for_each_dirty(Uid interfaceUid, void* context, StateVisitorFn visitor) override;
+    ReturnValue add_change_journal(Uid interfaceUid, size_t state_size, size_t state_alignment) override;
+    size_t write_changes(Uid interfaceUid, void* buffer, size_t size) override;
+    ReturnValue add_index(const HiveIndexDesc& desc) override;
+    size_t find_indexed(Uid interfaceUid, size_t field_offset, uint64_t first, uint64_t last, void* context,
+                        StateVisitorFn visitor) const override;
+    IEvent::Ptr on_membership_changed() const override;
+    ReturnValue set_threading(HiveThreading threading) override;
+    HiveThreading get_threading() const override;
+
+    /** @brief Records membership changes into @p membership instead of the hive's own, or back with null. */
+    void set_membership(HiveMembership* membership) { membership_target_ = membership; }
+
+    /**
+     * @brief Constructs @p count objects that the hive does not keep alive.
+     *
+     * The objects start out in the zombie state that remove() leaves an object in: they are
+     * not visited or counted by the hive, and each slot is reclaimed when the last reference
+     * to its object drops. Used to pool objects that are owned elsewhere.
+     *
+     * @param count Number of objects to construct.
+     * @param out Receives the objects, must hold @p count elements.
+     * @return The number of objects constructed.
+     */
+    size_t add_detached_n(size_t count, IObject::Ptr* out);
+
+    /**
+     * @brief Caches up to @p slots released slots of detached objects per thread magazine.
+     *
+     * A cached slot is taken by the next add_detached_n() of a thread mapped to the magazine
+     * without locking the hive, and counts as a zombie of its page until the hive drains the
+     * magazines in trim() or its destructor. Must be called before the first add.
+     */
+    void set_magazine_size(size_t slots);
+
+    /**
+     * @brief Returns the number and slot bytes of the objects alive in the hive's slots.
+     *
+     * Counts the zombies, and so the detached objects, but not the slots cached in magazines.
+     */
+    MemoryCounter get_instance_memory() const;
+
+    /** @brief Returns the slot of a destroyed object to its page. Called from the hive destroy callback. */
+    void reclaim_slot(HivePage& page, size_t slot_index, bool last_weak);
+
+    /** @brief Returns the number of orphaned pages alive in the process. */
+    static size_t orphaned_page_count();
+
+    /** @brief Returns true if the memory of large orphaned pages is queued for reclaim_orphaned_page_memory(). */
+    static bool has_orphaned_page_memory();
+
+    /** @brief Frees the memory of the large orphaned pages queued so far. Safe to call from any thread. */
+    static void reclaim_orphaned_page_memory();
+
+    /**
+     * @brief With @p enabled, large orphaned pages are freed by the thread releasing them instead of queued.
+     *
+     * Enabling it frees the pages already queued. Set by the instance when it shuts down.
+     */
+    static void set_inline_page_reclaim(bool enabled);
+
+    /** @brief Called when the last weak_ptr to a destroyed object in @p page drops. */
+    void release_weak_block(HivePage& page, size_t slot_index);
+
+    /** @brief Caches a zombie slot whose last weak_ptr dropped. Called with magazines enabled. */
+    void release_cached_block(HivePage& page, size_t slot_index);
 
     /** @brief Scans all active slots with prefetching, calling visit(slot_ptr) for each. */
     template <class VisitFn>
     void scan_active(ptrdiff_t prefetch_offset, VisitFn&& visit) const;
 
+    /** @brief Scans the active slots in bitmask words [word_begin, word_end) of one page. */
+    template <class VisitFn>
+    bool scan_words(const HivePage& page, size_t word_begin, size_t word_end, ptrdiff_t prefetch_offset,
+                    VisitFn&& visit) const;
+
 private:
+    /** @brief A State struct stored in per-page columns instead of inside the objects. */
+    struct StateColumn
+    {
+        Uid uid;                 ///< Interface whose State is stored in the column.
+        size_t size;             ///< sizeof the State struct.
+        size_t alignment;        ///< alignof the State struct.
+        size_t stride;           ///< Byte distance between column entries.
+        ptrdiff_t inline_offset; ///< Offset of the inline State, which seeds new entries.
+        bool double_buffered;    ///< Pages keep a front copy, published by swap_state_buffers().
+    };
+
+    /** @brief A released slot cached in a magazine. */
+    struct MagazineSlot
+    {
+        HivePage* page;
+        size_t index;
+    };
+
+    /** @brief Cache of released slots shared by the threads mapped to it. */
+    struct alignas(64) Magazine
+    {
+        std::mutex mutex;
+        std::vector<MagazineSlot> slots; ///< Grows up to magazine_size_ on first use.
+    };
+
+    /** @brief A property of a journaled interface, see add_change_journal(). */
+    struct JournalField
+    {
+        uint32_t member; ///< Index of the property in the interface's metadata.
+        uint32_t offset; ///< Offset of the value in the State.
+        uint32_t size;   ///< Size of the value.
+    };
+
+    /** @brief An interface whose changes are tracked in per-page dirty bitmasks. */
+    struct DirtyTracking
+    {
+        Uid uid;                 ///< Interface whose changes are tracked.
+        ptrdiff_t inline_offset; ///< Offset of the inline State, used if it has no state column.
+        bool tracked;            ///< add_dirty_tracking() was called, not only add_index().
+        bool indexed;            ///< The interface has indexes.
+        bool journaled{};                 ///< add_change_journal() was called.
+        size_t state_size{};              ///< sizeof the State, if journaled.
+        size_t state_alignment{};         ///< alignof the State, if journaled.
+        std::vector<JournalField> fields; ///< Journaled properties, if journaled.
+    };
+
     /** @brief Returns the slot pointer for a given page and slot index. */
     void* slot_ptr(HivePage& page, size_t index) const;
     void* slot_ptr(const HivePage& page, size_t index) const;
 
+    /**
+     * @brief Constructs an object in a free slot of @p target. Exclusive lock.
+     * @param detached If true, the slot starts as a zombie and the hive takes no reference.
+     */
+    IObject::Ptr construct_object(HivePage& target, bool detached = false);
+
+    /** @brief Pops a free slot of @p target and marks it active, or a zombie. Exclusive lock. */
+    size_t take_free_slot(HivePage& target, bool zombie);
+
+    /** @brief Constructs an object in slot @p slot_idx of @p page, whose bits are already set. */
+    IObject::Ptr construct_in_slot(HivePage& page, size_t slot_idx, bool detached);
+
+    /** @brief Moves the zombie slot of a destroyed object to its page freelist. Takes the lock. */
+    void return_slot(HivePage& page, size_t slot_index, bool last_weak);
+
+    /** @brief Moves a zombie slot whose block is dead to its page freelist. Exclusive lock. */
+    void free_zombie_slot(HivePage& page, size_t slot_index);
+
+    /**
+     * @brief Caches a released slot in the calling thread's magazine.
+     *
+     * If the magazine is full, half of it is returned to the pages first.
+     */
+    void magazine_deallocate(HivePage& page, size_t slot_index);
+
+    /** @brief Returns the slots cached in the magazines to their pages. Exclusive lock. */
+    void drain_magazines();
+
     /** @brief Allocates a new page with the given capacity. */
     void alloc_page(size_t capacity);
 
+    /** @brief Allocates one page if the hive has fewer than @p free_slots free slots. Exclusive lock. */
+    bool reserve_slots(size_t free_slots);
+
     /** @brief Frees a page's memory. */
     static void free_page(HivePage& page);
 
+    /** @brief Returns true if a page holds no objects and no embedded block is weakly referenced. */
+    static bool is_page_unused(const HivePage& page);
+
+    /**
+     * @brief Frees an unused page and unlinks it. Call erase_released_pages() afterwards.
+     * @param deferred If set, receives the page memory instead of freeing it.
+     */
+    void release_page(HivePage& page, std::vector<PageMemory>* deferred = nullptr);
+
+    /** @brief Turns every active object into a zombie and returns them. Exclusive lock. */
+    std::vector<IObject*> deactivate_all();
+
+    /**
+     * @brief Releases the hive's strong ref on @p objects, or hands it to an observed membership.
+     * @param executor Executor running the releases, or nullptr for the calling thread.
+     */
+    void release_objects(const std::vector<IObject*>& objects, IExecutor* executor);
+
+    /** @brief Removes pages freed by release_page() from pages_. */
+    void erase_released_pages();
+
+    /** @brief Releases @p page if it is unused and the hive exceeds HivePageCapacity::max_free_slots. */
+    void auto_trim(HivePage& page);
+
+    /** @brief Gives @p page a page id and seeds the generations of its slots. */
+    void assign_page_id(HivePage& page);
+
+    /** @brief Returns the id of a released page for reuse, past the generations it issued. */
+    void release_page_id(HivePage& page);
+
+    /** @brief Returns the generation following @p generation, skipping 0. */
+    static uint32_t next_generation(uint32_t generation);
+
     /** @brief Pushes a slot onto a page's freelist. */
     static void push_free(HivePage& page, size_t index, size_t slot_size);
 
     /** @brief Returns the next page capacity based on current page count. */
     size_t next_page_capacity() const;
 
-    /** @brief Finds the page and slot index for a given object pointer. Returns false if not found. */
-    bool find_slot(const void* obj, size_t& page_idx, size_t& slot_idx) const;
+    /** @brief Returns the index of the state column of @p interfaceUid, or state_columns_.size() if none. */
+    size_t column_index(Uid interfaceUid) const;
+
+    /** @brief Adds a state column for add_state_column() and add_double_buffered_state(). */
+    ReturnValue add_column(Uid interfaceUid, size_t state_size, size_t state_alignment, bool double_buffered);
+
+    /** @brief Iterates the back (written) or front (published) entries of a state column. */
+    void visit_column(Uid interfaceUid, bool front, void* context, ColumnVisitorFn visitor,
+                      IExecutor* executor) const;
+
+    /** @brief Returns the index of the tracking of @p interfaceUid, or dirty_tracking_.size() if none. */
+    size_t dirty_index(Uid interfaceUid) const;
+
+    /** @brief Adds a dirty tracking entry for @p interfaceUid, or returns the existing one. */
+    DirtyTracking* get_or_add_dirty_tracking(Uid interfaceUid);
+
+    /** @brief Returns the State of @p interfaceUid of the object in a slot. */
+    void* state_ptr(const HivePage& page, size_t slot_index, size_t column, const DirtyTracking& tracking) const;
+
+    /**
+     * @brief Calls fn(page, slot_index, state, journaled, field) for each journaled property of
+     *        tracking @p d that differs from its journaled copy in an object marked for the journal.
+     * @param consume If true, clears the marks of the words visited.
+     */
+    template <class Fn>
+    void visit_changes(size_t d, bool consume, Fn&& fn);
+
+    /** @brief Marks an object leaving the hive for the indexes of every interface. */
+    static void mark_indexes(HivePage& page, size_t slot_index);
+
+    /** @brief Feeds the indexes of @p interfaceUid the objects marked since the last lookup. index_mutex_. */
+    void refresh_indexes(Uid interfaceUid) const;
+
+    /** @brief Returns the offset of the inline State of @p interfaceUid in an object, or -1 if none. */
+    ptrdiff_t inline_state_offset(Uid interfaceUid) const;
+
+    /** @brief Locates the inline States of every interface of the class on a prototype. */
+    void compute_state_offsets() const;
+
+    /** @brief Finds the page and slot index of an active object. Returns nullptr if not found. */
+    HivePage* find_slot(const void* obj, size_t& slot_idx) const;
+
+    /** @brief Returns the membership changes are recorded into. */
+    HiveMembership& membership() const { return membership_target_ ? *membership_target_ : membership_; }
 
-    mutable std::shared_mutex mutex_;
+    mutable HiveMutex mutex_;
     Uid element_class_uid_;
     const IObjectFactory* factory_{nullptr};
+    mutable std::once_flag state_offsets_once_;
+    mutable std::vector<std::pair<Uid, ptrdiff_t>> state_offsets_; ///< Inline State offset per interface.
     size_t slot_size_{0};
     size_t slot_alignment_{0};
     size_t live_count_{0};
-    HivePage* current_page_{nullptr}; ///< Hint: last page with free slots.
+    size_t free_slots_{0};              ///< Free slots over all pages.
+    HivePage* current_page_{nullptr};   ///< Hint: last page with free slots.
+    FreePageList<HivePage> free_pages_; ///< Pages with at least one free slot.
     std::vector<std::unique_ptr<HivePage>> pages_;
+    std::vector<HivePage*> sorted_pages_; ///< Pages sorted by slot address for pointer lookup.
+    std::vector<HivePage*> page_ids_;     ///< Pages by HiveHandle page id, null for free ids.
+    std::vector<uint32_t> id_generations_; ///< First generation of the next page given each id.
+    std::vector<uint32_t> free_page_ids_;  ///< Ids of released pages.
+    std::vector<StateColumn> state_columns_;
+    std::vector<DirtyTracking> dirty_tracking_;
+    mutable std::mutex index_mutex_;          ///< Guards indexes_ under the shared hive lock.
+    mutable std::vector<HiveIndex> indexes_;  ///< Indexes, refreshed lazily by find_indexed().
     HivePageCapacity capacity_;
+    PageGrowth growth_; ///< Drives HivePageGrowth::Adaptive.
+    IHivePageSource::Ptr page_source_;
+    size_t magazine_size_{0};               ///< Slots cached per magazine (0 = caching disabled).
+    std::unique_ptr<Magazine[]> magazines_; ///< MAGAZINE_COUNT magazines, or null when disabled.
+    mutable HiveMembership membership_;         ///< Backs on_membership_changed().
+    HiveMembership* membership_target_{nullptr}; ///< Set by a partitioned parent, else membership_ is used.
 };
 
 } // namespace velk
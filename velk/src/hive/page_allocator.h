@@ -1,46 +1,117 @@
 #ifndef VELK_PAGE_ALLOCATOR_H
 #define VELK_PAGE_ALLOCATOR_H
 
+#include <velk/allocator.h>
+#include <velk/api/callback.h>
+#include <velk/api/hive/page_view.h>
 #include <velk/api/velk.h>
 #include <velk/interface/hive/intf_hive.h>
+#include <velk/interface/intf_executor.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <shared_mutex>
+#include <thread>
+#include <vector>
 
 #ifdef _WIN32
 #include <intrin.h>
-#include <malloc.h>
-#else
-#include <cstdlib>
 #endif
 
 namespace velk {
 
 static constexpr size_t PAGE_SENTINEL = ~size_t(0);
 
-inline void* aligned_alloc_impl(size_t alignment, size_t size)
+inline size_t align_up(size_t size, size_t alignment)
 {
-#ifdef _WIN32
-    return _aligned_malloc(size, alignment);
-#else
-    return std::aligned_alloc(alignment, size);
-#endif
+    return (size + alignment - 1) & ~(alignment - 1);
 }
 
-inline void aligned_free_impl(void* ptr)
+/**
+ * @brief Allocates the memory block of @p page from @p source, falling back to the velk allocator.
+ *
+ * Sets page.allocation, page.allocation_size, page.allocation_alignment, page.page_source
+ * (null for heap memory) and page.numa_node (as reported by an INumaPageSource, -1 otherwise).
+ * The memory is tracked as MemoryCategory::HivePages whatever its source.
+ */
+template <class Page>
+void* allocate_page_memory(Page& page, const IHivePageSource::Ptr& source, size_t alignment, size_t size)
 {
-#ifdef _WIN32
-    _aligned_free(ptr);
-#else
-    std::free(ptr);
-#endif
+    void* mem = source ? source->allocate_page(size, alignment) : nullptr;
+    page.numa_node = -1;
+    if (mem) {
+        page.page_source = source;
+        if (auto* numa = interface_cast<INumaPageSource>(source)) {
+            page.numa_node = numa->get_page_node(mem, size);
+        }
+    } else {
+        mem = detail::velk_alloc(size, alignment, MemoryTag::Hive);
+    }
+    if (mem) {
+        detail::track_memory(MemoryCategory::HivePages, static_cast<ptrdiff_t>(size), 1);
+    }
+    page.allocation = mem;
+    page.allocation_size = size;
+    page.allocation_alignment = alignment;
+    return mem;
 }
 
-inline size_t align_up(size_t size, size_t alignment)
+/** @brief Releases the memory block of @p page to the source that allocated it. */
+template <class Page>
+void free_page_memory(Page& page)
 {
-    return (size + alignment - 1) & ~(alignment - 1);
+    if (page.allocation) {
+        detail::track_memory(MemoryCategory::HivePages, -static_cast<ptrdiff_t>(page.allocation_size), -1);
+    }
+    if (page.page_source) {
+        page.page_source->free_page(page.allocation, page.allocation_size);
+        page.page_source = {};
+    } else {
+        detail::velk_free(page.allocation, page.allocation_alignment, MemoryTag::Hive);
+    }
+    page.allocation = nullptr;
+}
+
+/** @brief Memory block of a released page, to be freed later by free_page_memory(). */
+struct PageMemory
+{
+    void* allocation{nullptr};
+    size_t allocation_size{0};
+    size_t allocation_alignment{0};
+    IHivePageSource::Ptr page_source;
+};
+
+/** @brief Moves the memory block of @p page to @p out, leaving the page without memory. */
+template <class Page>
+void take_page_memory(Page& page, std::vector<PageMemory>& out)
+{
+    out.push_back({page.allocation, page.allocation_size, page.allocation_alignment, std::move(page.page_source)});
+    page.page_source = {};
+    page.allocation = nullptr;
+}
+
+/** @brief Frees @p blocks on the instance thread pool, or on the calling thread if there is none. */
+inline void free_page_memory_async(std::vector<PageMemory>&& blocks)
+{
+    if (blocks.empty()) {
+        return;
+    }
+    auto pool = instance().get_thread_pool();
+    auto free_all = [blocks = std::move(blocks)](FnArgs) mutable -> ReturnValue {
+        for (auto& block : blocks) {
+            free_page_memory(block);
+        }
+        return ReturnValue::Success;
+    };
+    if (!pool) {
+        free_all({});
+        return;
+    }
+    pool->post(Callback(std::move(free_all)));
 }
 
 inline void prefetch_line(const void* addr)
@@ -52,22 +123,7 @@ inline void prefetch_line(const void* addr)
 #endif
 }
 
-/** @brief Returns the index of the lowest set bit, or 64 if none. */
-inline unsigned bitscan_forward64(uint64_t mask)
-{
-#ifdef _WIN32
-    unsigned long idx;
-    if (_BitScanForward64(&idx, mask)) {
-        return static_cast<unsigned>(idx);
-    }
-    return 64;
-#else
-    if (mask == 0) {
-        return 64;
-    }
-    return static_cast<unsigned>(__builtin_ctzll(mask));
-#endif
-}
+using detail::bitscan_forward64;
 
 /** @brief Number of uint64_t words needed for a bitmask covering @p capacity slots. */
 inline size_t bitmask_words(size_t capacity)
@@ -75,6 +131,16 @@ inline size_t bitmask_words(size_t capacity)
     return (capacity + 63) / 64;
 }
 
+/** @brief Returns the number of set bits in @p bits. */
+inline size_t popcount64(uint64_t bits)
+{
+#ifdef _WIN32
+    return static_cast<size_t>(__popcnt64(bits));
+#else
+    return static_cast<size_t>(__builtin_popcountll(bits));
+#endif
+}
+
 /** @brief Sets the active bit for slot @p bit in bitmask word @p word. */
 inline void set_slot_active(uint64_t* active_bits, size_t word, size_t bit)
 {
@@ -93,6 +159,50 @@ inline bool is_slot_active(const uint64_t* active_bits, size_t word, size_t bit)
     return (active_bits[word] & (uint64_t(1) << (bit & 63))) != 0;
 }
 
+/**
+ * @brief Atomically sets the active bit for slot @p bit in bitmask word @p word.
+ *
+ * Used where the bitmask is modified under a shared lock while other threads may
+ * modify other bits of the same word.
+ */
+inline void atomic_set_slot_active(uint64_t* active_bits, size_t word, size_t bit)
+{
+    uint64_t mask = uint64_t(1) << (bit & 63);
+#ifdef _WIN32
+    _InterlockedOr64(reinterpret_cast<volatile long long*>(active_bits + word), static_cast<long long>(mask));
+#else
+    __atomic_fetch_or(active_bits + word, mask, __ATOMIC_RELAXED);
+#endif
+}
+
+/** @brief Atomically clears the active bit for slot @p bit in bitmask word @p word. */
+inline void atomic_clear_slot_active(uint64_t* active_bits, size_t word, size_t bit)
+{
+    uint64_t mask = ~(uint64_t(1) << (bit & 63));
+#ifdef _WIN32
+    _InterlockedAnd64(reinterpret_cast<volatile long long*>(active_bits + word), static_cast<long long>(mask));
+#else
+    __atomic_fetch_and(active_bits + word, mask, __ATOMIC_RELAXED);
+#endif
+}
+
+/** @brief Number of magazines a hive spreads its threads over when slot caching is enabled. */
+static constexpr size_t MAGAZINE_COUNT = 16;
+
+/**
+ * @brief Returns the calling thread's magazine index in [0, MAGAZINE_COUNT).
+ *
+ * Threads are assigned round-robin on first use, so up to MAGAZINE_COUNT
+ * threads never share a magazine. The thread_local is trivially destructible
+ * (see the control block pool in velk.cpp for why that matters).
+ */
+inline size_t thread_magazine_index()
+{
+    static std::atomic<size_t> next{0};
+    thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % MAGAZINE_COUNT;
+    return index;
+}
+
 /**
  * @brief RAII guard that tracks which hive mutex is currently held for iteration
  * on this thread. Enables detection of illegal mutation from within a for_each
@@ -128,6 +238,75 @@ inline void check_iteration_guard(const std::shared_mutex& m, string_view operat
     }
 }
 
+/**
+ * @brief Hive lock that is elided for a hive confined to one thread (HiveThreading::SingleThread).
+ *
+ * Derives from std::shared_mutex so that IterationGuard and check_iteration_guard() identify it
+ * as before. Only locks taken through HiveMutex itself, not through the base, are elided.
+ * In debug builds the first thread to take an elided lock becomes its owner, and the others
+ * are reported.
+ */
+class HiveMutex : public std::shared_mutex
+{
+public:
+    /** @brief Enables or disables elision. Must not be called while the lock is held. */
+    void set_single_thread(bool single)
+    {
+        single_ = single;
+#ifndef NDEBUG
+        owner_ = {};
+#endif
+    }
+    bool single_thread() const { return single_; }
+
+    void lock()
+    {
+        if (single_) {
+            check_owner();
+            return;
+        }
+        std::shared_mutex::lock();
+    }
+    void unlock()
+    {
+        if (!single_) {
+            std::shared_mutex::unlock();
+        }
+    }
+    void lock_shared()
+    {
+        if (single_) {
+            check_owner();
+            return;
+        }
+        std::shared_mutex::lock_shared();
+    }
+    void unlock_shared()
+    {
+        if (!single_) {
+            std::shared_mutex::unlock_shared();
+        }
+    }
+
+private:
+    void check_owner()
+    {
+#ifndef NDEBUG
+        auto self = std::this_thread::get_id();
+        if (owner_ == std::thread::id{}) {
+            owner_ = self;
+        } else if (owner_ != self) {
+            VELK_LOG(E, "Single-threaded hive used from more than one thread");
+        }
+#endif
+    }
+
+    bool single_{false};
+#ifndef NDEBUG
+    std::thread::id owner_;
+#endif
+};
+
 /** @brief Returns the page capacity for a given page index. */
 inline size_t next_page_capacity(const HivePageCapacity& capacity, size_t page_count)
 {
@@ -143,6 +322,53 @@ inline size_t next_page_capacity(const HivePageCapacity& capacity, size_t page_c
     }
 }
 
+/** @brief Usage a hive observes for HivePageGrowth::Adaptive. Guarded by the hive's exclusive lock. */
+struct PageGrowth
+{
+    size_t peak_slots{0}; ///< Most slots the hive has had allocated at once.
+    size_t returned{0};   ///< Slots freed since the last page allocation.
+};
+
+/** @brief Returns the total capacity of the allocated pages in @p pages. */
+template <class Page>
+size_t allocated_slots(const std::vector<std::unique_ptr<Page>>& pages)
+{
+    size_t slots = 0;
+    for (auto& page : pages) {
+        slots += page->allocation ? page->capacity : 0;
+    }
+    return slots;
+}
+
+/** @brief Returns the capacity of the next page of a hive with @p pages under either growth policy. */
+template <class Page>
+size_t next_page_capacity(const HivePageCapacity& capacity, const std::vector<std::unique_ptr<Page>>& pages,
+                          size_t slot_size, const PageGrowth& growth)
+{
+    if (capacity.growth != HivePageGrowth::Adaptive) {
+        return next_page_capacity(capacity, pages.size());
+    }
+    size_t slots = allocated_slots(pages);
+    size_t regrow = growth.peak_slots > slots ? growth.peak_slots - slots : 0;
+    size_t target = std::max({capacity.page_1, slots, regrow});
+    if (slots && growth.returned >= slots / 2) {
+        target = std::max(capacity.page_1, target / 2);
+    }
+    size_t max_slots = std::max(capacity.max_page_bytes / slot_size, size_t(1));
+    return std::min(target, max_slots);
+}
+
+/** @brief Records a page allocation of a hive with @p pages in @p growth. */
+template <class Page>
+void note_page_alloc(const HivePageCapacity& capacity, const std::vector<std::unique_ptr<Page>>& pages,
+                     PageGrowth& growth)
+{
+    if (capacity.growth == HivePageGrowth::Adaptive) {
+        growth.peak_slots = std::max(growth.peak_slots, allocated_slots(pages));
+        growth.returned = 0;
+    }
+}
+
 inline HivePageCapacity check_capacity(const HivePageCapacity& capacity)
 {
     auto max = [](const size_t& lhs, const size_t& rhs) noexcept { return lhs < rhs ? rhs : lhs; };
@@ -184,6 +410,230 @@ inline size_t pop_free_slot(void* slots, size_t slot_size, size_t& free_head)
     return index;
 }
 
+/**
+ * @brief Intrusive doubly-linked list of pages that have at least one free slot.
+ *
+ * Lets allocation find a target page in O(1) instead of scanning every page.
+ * A page is linked when it gains its first free slot and unlinked when its
+ * last free slot is taken.
+ *
+ * @tparam Page A page type with @c prev_free, @c next_free and @c in_free_list members.
+ */
+template <class Page>
+struct FreePageList
+{
+    Page* head{nullptr};
+
+    /** @brief Links @p page at the front of the list. No-op if already linked. */
+    void push(Page* page)
+    {
+        if (page->in_free_list) {
+            return;
+        }
+        page->prev_free = nullptr;
+        page->next_free = head;
+        if (head) {
+            head->prev_free = page;
+        }
+        head = page;
+        page->in_free_list = true;
+    }
+
+    /** @brief Unlinks @p page from the list. No-op if not linked. */
+    void unlink(Page* page)
+    {
+        if (!page->in_free_list) {
+            return;
+        }
+        if (page->prev_free) {
+            page->prev_free->next_free = page->next_free;
+        } else {
+            head = page->next_free;
+        }
+        if (page->next_free) {
+            page->next_free->prev_free = page->prev_free;
+        }
+        page->prev_free = nullptr;
+        page->next_free = nullptr;
+        page->in_free_list = false;
+    }
+
+    /** @brief Forgets all linked pages without touching them (used when the pages are freed). */
+    void reset() { head = nullptr; }
+};
+
+/**
+ * @brief Inserts @p page into a page table kept sorted by slot base address.
+ *
+ * @tparam Page A page type with a @c slots member.
+ */
+template <class Page>
+void insert_sorted_page(std::vector<Page*>& table, Page* page)
+{
+    auto it = std::lower_bound(table.begin(), table.end(), page, [](const Page* lhs, const Page* rhs) {
+        return reinterpret_cast<uintptr_t>(lhs->slots) < reinterpret_cast<uintptr_t>(rhs->slots);
+    });
+    table.insert(it, page);
+}
+
+/**
+ * @brief Resolves the page and slot index owning @p ptr in a page table sorted by slot base address.
+ *
+ * Binary search over the page table, so the cost grows with log(pages) rather than with
+ * the number of pages. Pointers outside every page or not on a slot boundary are rejected
+ * without touching page memory, so foreign pointers are safe to pass.
+ *
+ * @tparam Page A page type with @c slots and @c capacity members.
+ * @param table Page table sorted with insert_sorted_page().
+ * @param ptr The pointer to resolve.
+ * @param slot_size Size of a slot in bytes.
+ * @param[out] slot_idx Receives the slot index within the returned page.
+ * @return The owning page, or nullptr if @p ptr is not a slot of any page.
+ */
+template <class Page>
+Page* find_sorted_page(const std::vector<Page*>& table, const void* ptr, size_t slot_size, size_t& slot_idx)
+{
+    auto addr = reinterpret_cast<uintptr_t>(ptr);
+    auto it = std::upper_bound(table.begin(), table.end(), addr, [](uintptr_t a, const Page* page) {
+        return a < reinterpret_cast<uintptr_t>(page->slots);
+    });
+    if (it == table.begin()) {
+        return nullptr;
+    }
+    Page* page = *(it - 1);
+    auto base = reinterpret_cast<uintptr_t>(page->slots);
+    size_t offset = static_cast<size_t>(addr - base);
+    if (offset >= page->capacity * slot_size || offset % slot_size != 0) {
+        return nullptr;
+    }
+    slot_idx = offset / slot_size;
+    return page;
+}
+
+/** @brief Number of bitmask words (64 slots each) per work chunk in parallel iteration. */
+static constexpr size_t PARALLEL_CHUNK_WORDS = 4;
+
+/**
+ * @brief Runs a page scan in parallel over an executor.
+ *
+ * Splits every page into chunks of PARALLEL_CHUNK_WORDS bitmask words. Each
+ * executor task is a worker that keeps claiming the next unprocessed chunk from
+ * a shared atomic cursor until none remain, which balances uneven pages across
+ * workers. The caller must hold the hive's shared lock for the duration of the call.
+ *
+ * If the executor implements INumaExecutor, chunks are queued per page NUMA node and
+ * each worker drains the queue of its own node before helping with the others.
+ *
+ * @tparam Page A page type with @c capacity and @c numa_node members.
+ * @tparam ScanFn bool(const Page& page, size_t word_begin, size_t word_end) - return false to stop.
+ * @param pages The hive's pages.
+ * @param mutex The hive mutex, registered with IterationGuard on each worker thread.
+ * @param executor Executor running the workers, or nullptr to scan on the calling thread.
+ * @param scan Scans the given word range of a page.
+ */
+template <class Page, class ScanFn>
+void parallel_scan(const std::vector<std::unique_ptr<Page>>& pages, const std::shared_mutex* mutex,
+                   IExecutor* executor, ScanFn&& scan)
+{
+    struct Chunk
+    {
+        const Page* page;
+        size_t word_begin;
+        size_t word_end;
+    };
+    /** @brief Chunks of one node, claimed through an atomic cursor. */
+    struct Queue
+    {
+        size_t begin{0};
+        size_t end{0};
+        std::atomic<size_t> next{0};
+    };
+    struct Work
+    {
+        std::vector<Chunk> chunks;
+        std::unique_ptr<Queue[]> queues; ///< One per node, the last for pages of unknown node.
+        size_t queue_count{1};
+        const INumaExecutor* numa{nullptr};
+        std::atomic<bool> stop{false};
+        const std::shared_mutex* mutex;
+        std::remove_reference_t<ScanFn>* scan;
+    } work;
+    work.mutex = mutex;
+    work.scan = &scan;
+    work.numa = executor ? interface_cast<INumaExecutor>(executor) : nullptr;
+
+    int max_node = -1;
+    for (auto& page_ptr : pages) {
+        if (!page_ptr->live_count) {
+            continue;
+        }
+        size_t num_words = bitmask_words(page_ptr->capacity);
+        for (size_t w = 0; w < num_words; w += PARALLEL_CHUNK_WORDS) {
+            size_t end = w + PARALLEL_CHUNK_WORDS < num_words ? w + PARALLEL_CHUNK_WORDS : num_words;
+            work.chunks.push_back({page_ptr.get(), w, end});
+        }
+        max_node = page_ptr->numa_node > max_node ? page_ptr->numa_node : max_node;
+    }
+    if (work.chunks.empty()) {
+        return;
+    }
+
+    auto queue_of = [&](const Chunk& chunk) {
+        int node = chunk.page->numa_node;
+        return work.queue_count == 1 || node < 0 ? work.queue_count - 1 : static_cast<size_t>(node);
+    };
+    if (work.numa && max_node >= 0) {
+        work.queue_count = static_cast<size_t>(max_node) + 2;
+        std::stable_sort(work.chunks.begin(), work.chunks.end(), [&](const Chunk& a, const Chunk& b) {
+            return queue_of(a) < queue_of(b);
+        });
+    }
+    work.queues.reset(new Queue[work.queue_count]);
+    // Chunks are grouped by queue, so each queue covers one contiguous range.
+    for (size_t i = 0; i < work.chunks.size(); ++i) {
+        auto& queue = work.queues[queue_of(work.chunks[i])];
+        if (queue.begin == queue.end) {
+            queue.begin = i;
+            queue.next.store(i, std::memory_order_relaxed);
+        }
+        queue.end = i + 1;
+    }
+
+    IExecutor::TaskFn worker = [](void* ctx, size_t index) {
+        auto& work = *static_cast<Work*>(ctx);
+        IterationGuard guard(work.mutex);
+        // Start with the queue of the worker's node, then help with the others.
+        int node = work.numa ? work.numa->get_task_node(index) : -1;
+        size_t home = work.queue_count - 1;
+        if (node >= 0 && static_cast<size_t>(node) < work.queue_count) {
+            home = static_cast<size_t>(node);
+        }
+        for (size_t q = 0; q < work.queue_count; ++q) {
+            auto& queue = work.queues[(home + q) % work.queue_count];
+            while (!work.stop.load(std::memory_order_relaxed)) {
+                size_t i = queue.next.fetch_add(1, std::memory_order_relaxed);
+                if (i >= queue.end) {
+                    break;
+                }
+                auto& chunk = work.chunks[i];
+                if (!(*work.scan)(*chunk.page, chunk.word_begin, chunk.word_end)) {
+                    work.stop.store(true, std::memory_order_relaxed);
+                }
+            }
+        }
+    };
+
+    size_t workers = executor ? executor->get_concurrency() : 1;
+    if (workers > work.chunks.size()) {
+        workers = work.chunks.size();
+    }
+    if (workers <= 1) {
+        worker(&work, 0);
+    } else {
+        executor->parallel_for(workers, &work, worker);
+    }
+}
+
 } // namespace velk
 
 #endif // VELK_PAGE_ALLOCATOR_H
@@ -0,0 +1,585 @@
+#include "partitioned_object_hive.h"
+
+#include "object_hive.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace velk {
+
+namespace {
+
+/**
+ * @brief Forwards a visitor to each partition in turn and records whether it stopped early.
+ *
+ * The flag is atomic because parallel iteration calls forward() from several workers.
+ */
+template <class... Args>
+struct PartitionVisit
+{
+    using Fn = bool (*)(void*, Args...);
+
+    void* context;
+    Fn visitor;
+    std::atomic<bool> stopped{false};
+
+    static bool forward(void* self, Args... args)
+    {
+        auto& visit = *static_cast<PartitionVisit*>(self);
+        if (visit.visitor(visit.context, args...)) {
+            return true;
+        }
+        visit.stopped.store(true, std::memory_order_relaxed);
+        return false;
+    }
+
+    bool done() const { return stopped.load(std::memory_order_relaxed); }
+};
+
+} // namespace
+
+void PartitionedObjectHive::init(Uid classUid, size_t partitions, const IHivePageSource::Ptr& source)
+{
+    element_class_uid_ = classUid;
+    partitions_.reserve(partitions);
+    for (size_t i = 0; i < partitions; ++i) {
+        auto hive_obj = ext::make_object<ObjectHive>();
+        auto* hive = static_cast<ObjectHive*>(hive_obj.get());
+        hive->init(classUid);
+        hive->set_page_source(source);
+        hive->set_membership(&membership_);
+        partitions_.push_back(interface_pointer_cast<IObjectHive>(hive_obj));
+    }
+}
+
+PartitionedObjectHive::~PartitionedObjectHive()
+{
+    // membership_ is destroyed before the partitions, which clear themselves on destruction.
+    membership_.reset();
+    for (auto& partition : partitions_) {
+        static_cast<ObjectHive*>(partition.get())->set_membership(nullptr);
+    }
+}
+
+IObjectHive& PartitionedObjectHive::local_partition() const
+{
+    // Threads are numbered on first use and spread round-robin over the partitions.
+    static std::atomic<size_t> next_thread{0};
+    thread_local size_t thread_index = next_thread.fetch_add(1, std::memory_order_relaxed);
+    return *partitions_[thread_index % partitions_.size()];
+}
+
+size_t PartitionedObjectHive::per_partition(size_t count) const
+{
+    return (count + partitions_.size() - 1) / partitions_.size();
+}
+
+Uid PartitionedObjectHive::get_element_uid() const
+{
+    return element_class_uid_;
+}
+
+size_t PartitionedObjectHive::size() const
+{
+    size_t total = 0;
+    for (auto& partition : partitions_) {
+        total += partition->size();
+    }
+    return total;
+}
+
+bool PartitionedObjectHive::empty() const
+{
+    for (auto& partition : partitions_) {
+        if (!partition->empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PartitionedObjectHive::clear()
+{
+    for (auto& partition : partitions_) {
+        partition->clear();
+    }
+}
+
+void PartitionedObjectHive::clear_parallel(IExecutor* executor, HivePageRelease release)
+{
+    for (auto& partition : partitions_) {
+        partition->clear_parallel(executor, release);
+    }
+}
+
+HivePageCapacity PartitionedObjectHive::get_page_capacity() const
+{
+    return partitions_.front()->get_page_capacity();
+}
+
+HiveStats PartitionedObjectHive::get_stats() const
+{
+    HiveStats total;
+    for (auto& partition : partitions_) {
+        HiveStats stats = partition->get_stats();
+        total.pages += stats.pages;
+        total.capacity += stats.capacity;
+        total.live += stats.live;
+        total.zombies += stats.zombies;
+        total.free_slots += stats.free_slots;
+        total.fragmented_slots += stats.fragmented_slots;
+        total.reserved_bytes += stats.reserved_bytes;
+    }
+    return total;
+}
+
+void PartitionedObjectHive::set_page_capacity(const HivePageCapacity& capacity)
+{
+    for (auto& partition : partitions_) {
+        partition->set_page_capacity(capacity);
+    }
+}
+
+size_t PartitionedObjectHive::get_slot_alignment() const
+{
+    return partitions_.front()->get_slot_alignment();
+}
+
+ReturnValue PartitionedObjectHive::set_slot_alignment(size_t alignment)
+{
+    // Check every partition first, so a failure leaves all of them unchanged.
+    if (alignment & (alignment - 1)) {
+        return ReturnValue::InvalidArgument;
+    }
+    for (auto& partition : partitions_) {
+        if (partition->get_stats().pages) {
+            return ReturnValue::Fail;
+        }
+    }
+    for (auto& partition : partitions_) {
+        partition->set_slot_alignment(alignment);
+    }
+    return ReturnValue::Success;
+}
+
+IHivePageSource::Ptr PartitionedObjectHive::get_page_source() const
+{
+    return partitions_.front()->get_page_source();
+}
+
+void PartitionedObjectHive::set_page_source(const IHivePageSource::Ptr& source)
+{
+    for (auto& partition : partitions_) {
+        partition->set_page_source(source);
+    }
+}
+
+size_t PartitionedObjectHive::trim(size_t keep_free_slots)
+{
+    size_t keep = per_partition(keep_free_slots);
+    size_t released = 0;
+    for (auto& partition : partitions_) {
+        released += partition->trim(keep);
+    }
+    return released;
+}
+
+ReturnValue PartitionedObjectHive::reserve(size_t free_slots)
+{
+    size_t slots = per_partition(free_slots);
+    ReturnValue result = ReturnValue::NothingToDo;
+    for (auto& partition : partitions_) {
+        if (partition->reserve(slots) == ReturnValue::Success) {
+            result = ReturnValue::Success;
+        }
+    }
+    return result;
+}
+
+void PartitionedObjectHive::for_each_page(void* context, PageVisitorFn visitor, IExecutor* executor) const
+{
+    PartitionVisit<const HivePageView&> visit{context, visitor};
+    for (auto& partition : partitions_) {
+        partition->for_each_page(&visit, &decltype(visit)::forward, executor);
+        if (visit.done()) {
+            return;
+        }
+    }
+}
+
+IObject::Ptr PartitionedObjectHive::add()
+{
+    return local_partition().add();
+}
+
+size_t PartitionedObjectHive::add_n(size_t count, IObject::Ptr* out)
+{
+    return local_partition().add_n(count, out);
+}
+
+ReturnValue PartitionedObjectHive::remove(IObject& object)
+{
+    // Objects are usually removed by the thread that added them, so try its partition first.
+    auto& local = local_partition();
+    if (local.remove(object) == ReturnValue::Success) {
+        return ReturnValue::Success;
+    }
+    for (auto& partition : partitions_) {
+        if (partition.get() != &local && partition->contains(object)) {
+            return partition->remove(object);
+        }
+    }
+    return ReturnValue::Fail;
+}
+
+bool PartitionedObjectHive::contains(const IObject& object) const
+{
+    for (auto& partition : partitions_) {
+        if (partition->contains(object)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+HiveHandle PartitionedObjectHive::get_handle(const IObject& object) const
+{
+    // The partition index is folded into the page id: page = inner_page * partitions + index.
+    uint64_t count = partitions_.size();
+    for (size_t p = 0; p < partitions_.size(); ++p) {
+        HiveHandle inner = partitions_[p]->get_handle(object);
+        if (!inner) {
+            continue;
+        }
+        uint64_t page = inner.page() * count + p;
+        if (page >= (uint64_t(1) << HiveHandle::PAGE_BITS)) {
+            return {};
+        }
+        return HiveHandle::make(page, inner.slot(), inner.generation());
+    }
+    return {};
+}
+
+IObject* PartitionedObjectHive::resolve(HiveHandle handle) const
+{
+    if (!handle || partitions_.empty()) {
+        return nullptr;
+    }
+    uint64_t count = partitions_.size();
+    auto& partition = partitions_[handle.page() % count];
+    return partition->resolve(HiveHandle::make(handle.page() / count, handle.slot(), handle.generation()));
+}
+
+void PartitionedObjectHive::for_each(void* context, VisitorFn visitor) const
+{
+    PartitionVisit<IObject&> visit{context, visitor};
+    for (auto& partition : partitions_) {
+        partition->for_each(&visit, &decltype(visit)::forward);
+        if (visit.done()) {
+            return;
+        }
+    }
+}
+
+ptrdiff_t PartitionedObjectHive::get_state_offset(Uid interfaceUid) const
+{
+    // All partitions hold the same class.
+    return partitions_.empty() ? -1 : partitions_.front()->get_state_offset(interfaceUid);
+}
+
+void PartitionedObjectHive::for_each_state(ptrdiff_t state_offset, void* context,
+                                           StateVisitorFn visitor) const
+{
+    PartitionVisit<IObject&, void*> visit{context, visitor};
+    for (auto& partition : partitions_) {
+        partition->for_each_state(state_offset, &visit, &decltype(visit)::forward);
+        if (visit.done()) {
+            return;
+        }
+    }
+}
+
+void PartitionedObjectHive::for_each_state_parallel(ptrdiff_t state_offset, void* context,
+                                                    StateVisitorFn visitor, IExecutor* executor) const
+{
+    PartitionVisit<IObject&, void*> visit{context, visitor};
+    for (auto& partition : partitions_) {
+        partition->for_each_state_parallel(state_offset, &visit, &decltype(visit)::forward, executor);
+        if (visit.done()) {
+            return;
+        }
+    }
+}
+
+size_t PartitionedObjectHive::compact()
+{
+    size_t released = 0;
+    for (auto& partition : partitions_) {
+        released += partition->compact();
+    }
+    return released;
+}
+
+ReturnValue PartitionedObjectHive::add_state_column(Uid interfaceUid, size_t state_size,
+                                                    size_t state_alignment)
+{
+    // Columns can only be added while no partition has pages. Otherwise all partitions
+    // hold the same class and return the same result.
+    for (auto& partition : partitions_) {
+        if (partition->get_stats().pages) {
+            return ReturnValue::Fail;
+        }
+    }
+    ReturnValue result = ReturnValue::Fail;
+    for (auto& partition : partitions_) {
+        result = partition->add_state_column(interfaceUid, state_size, state_alignment);
+    }
+    return result;
+}
+
+bool PartitionedObjectHive::has_state_column(Uid interfaceUid) const
+{
+    return partitions_.front()->has_state_column(interfaceUid);
+}
+
+void PartitionedObjectHive::for_each_column(Uid interfaceUid, void* context, ColumnVisitorFn visitor,
+                                            IExecutor* executor) const
+{
+    PartitionVisit<const HivePageView&, const HivePageView&> visit{context, visitor};
+    for (auto& partition : partitions_) {
+        partition->for_each_column(interfaceUid, &visit, &decltype(visit)::forward, executor);
+        if (visit.done()) {
+            return;
+        }
+    }
+}
+
+ReturnValue PartitionedObjectHive::add_double_buffered_state(Uid interfaceUid, size_t state_size,
+                                                             size_t state_alignment)
+{
+    // As for state columns, all partitions must still be empty.
+    for (auto& partition : partitions_) {
+        if (partition->get_stats().pages) {
+            return ReturnValue::Fail;
+        }
+    }
+    ReturnValue result = ReturnValue::Fail;
+    for (auto& partition : partitions_) {
+        result = partition->add_double_buffered_state(interfaceUid, state_size, state_alignment);
+    }
+    return result;
+}
+
+void PartitionedObjectHive::for_each_front(Uid interfaceUid, void* context, ColumnVisitorFn visitor,
+                                           IExecutor* executor) const
+{
+    PartitionVisit<const HivePageView&, const HivePageView&> visit{context, visitor};
+    for (auto& partition : partitions_) {
+        partition->for_each_front(interfaceUid, &visit, &decltype(visit)::forward, executor);
+        if (visit.done()) {
+            return;
+        }
+    }
+}
+
+void PartitionedObjectHive::swap_state_buffers()
+{
+    for (auto& partition : partitions_) {
+        partition->swap_state_buffers();
+    }
+}
+
+size_t PartitionedObjectHive::snapshot_states(Uid interfaceUid, size_t state_size, void* buffer,
+                                              size_t size) const
+{
+    // Concatenate the States of all partitions under a single header.
+    std::vector<char> part;
+    size_t total = sizeof(HiveSnapshotHeader);
+    size_t count = 0;
+    char* out = static_cast<char*>(buffer);
+    for (auto& partition : partitions_) {
+        size_t needed = partition->snapshot_states(interfaceUid, state_size, nullptr, 0);
+        if (!needed) {
+            return 0;
+        }
+        if (out && total + needed - sizeof(HiveSnapshotHeader) <= size) {
+            // The partition may grow between the calls, so retry until its snapshot fits.
+            part.resize(needed);
+            while ((needed = partition->snapshot_states(interfaceUid, state_size, part.data(), part.size())) >
+                   part.size()) {
+                part.resize(needed);
+            }
+            if (total + needed - sizeof(HiveSnapshotHeader) <= size) {
+                std::memcpy(out + total, part.data() + sizeof(HiveSnapshotHeader),
+                            needed - sizeof(HiveSnapshotHeader));
+            }
+        }
+        total += needed - sizeof(HiveSnapshotHeader);
+        count += (needed - sizeof(HiveSnapshotHeader)) / state_size;
+    }
+    if (out && total <= size) {
+        HiveSnapshotHeader header;
+        header.element_uid = interfaceUid;
+        header.element_size = state_size;
+        header.count = count;
+        header.size = total;
+        std::memcpy(out, &header, sizeof(header));
+    }
+    return total;
+}
+
+ReturnValue PartitionedObjectHive::restore_states(Uid interfaceUid, size_t state_size, const void* buffer,
+                                                  size_t size)
+{
+    return local_partition().restore_states(interfaceUid, state_size, buffer, size);
+}
+
+ReturnValue PartitionedObjectHive::add_dirty_tracking(Uid interfaceUid)
+{
+    // As for state columns, all partitions must still be empty.
+    for (auto& partition : partitions_) {
+        if (partition->get_stats().pages) {
+            return ReturnValue::Fail;
+        }
+    }
+    ReturnValue result = ReturnValue::Fail;
+    for (auto& partition : partitions_) {
+        result = partition->add_dirty_tracking(interfaceUid);
+    }
+    return result;
+}
+
+bool PartitionedObjectHive::has_dirty_tracking(Uid interfaceUid) const
+{
+    return partitions_.front()->has_dirty_tracking(interfaceUid);
+}
+
+size_t PartitionedObjectHive::for_each_dirty(Uid interfaceUid, void* context, StateVisitorFn visitor)
+{
+    PartitionVisit<IObject&, void*> visit{context, visitor};
+    size_t visited = 0;
+    for (auto& partition : partitions_) {
+        visited += partition->for_each_dirty(interfaceUid, &visit, &decltype(visit)::forward);
+        if (visit.done()) {
+            break;
+        }
+    }
+    return visited;
+}
+
+ReturnValue PartitionedObjectHive::add_change_journal(Uid interfaceUid, size_t state_size, size_t state_alignment)
+{
+    for (auto& partition : partitions_) {
+        if (partition->get_stats().pages) {
+            return ReturnValue::Fail;
+        }
+    }
+    ReturnValue result = ReturnValue::Fail;
+    for (auto& partition : partitions_) {
+        result = partition->add_change_journal(interfaceUid, state_size, state_alignment);
+    }
+    return result;
+}
+
+size_t PartitionedObjectHive::write_changes(Uid interfaceUid, void* buffer, size_t size)
+{
+    // Size every partition's journal first, so that nothing is consumed if the total does not fit.
+    size_t total = sizeof(HiveJournalHeader);
+    for (auto& partition : partitions_) {
+        size_t needed = partition->write_changes(interfaceUid, nullptr, 0);
+        if (!needed) {
+            return 0;
+        }
+        total += needed - sizeof(HiveJournalHeader);
+    }
+    if (!buffer || total > size) {
+        return total;
+    }
+
+    // Concatenate the records under a single header, folding the partition index into the
+    // page id of each handle as get_handle() does.
+    char* out = static_cast<char*>(buffer);
+    size_t pos = sizeof(HiveJournalHeader);
+    HiveJournalHeader header;
+    std::vector<char> part;
+    uint64_t count = partitions_.size();
+    for (size_t p = 0; p < partitions_.size(); ++p) {
+        part.resize(partitions_[p]->write_changes(interfaceUid, nullptr, 0));
+        size_t written = partitions_[p]->write_changes(interfaceUid, part.data(), part.size());
+        if (written > part.size() || pos + written - sizeof(HiveJournalHeader) > size) {
+            continue;
+        }
+        HiveJournalHeader part_header;
+        std::memcpy(&part_header, part.data(), sizeof(part_header));
+        header.state_size = part_header.state_size;
+        header.count += part_header.count;
+        size_t offset = sizeof(HiveJournalHeader);
+        while (offset < written) {
+            HiveJournalRecord record;
+            std::memcpy(&record, part.data() + offset, sizeof(record));
+            HiveHandle inner{record.handle};
+            uint64_t page = inner.page() * count + p;
+            record.handle = page < (uint64_t(1) << HiveHandle::PAGE_BITS)
+                                ? HiveHandle::make(page, inner.slot(), inner.generation()).value
+                                : 0;
+            size_t record_size = sizeof(record) + align_up(record.size, 8);
+            std::memcpy(out + pos, &record, sizeof(record));
+            std::memcpy(out + pos + sizeof(record), part.data() + offset + sizeof(record),
+                        record_size - sizeof(record));
+            pos += record_size;
+            offset += record_size;
+        }
+    }
+    header.interface_uid = interfaceUid;
+    header.size = pos;
+    std::memcpy(out, &header, sizeof(header));
+    return pos;
+}
+
+ReturnValue PartitionedObjectHive::add_index(const HiveIndexDesc& desc)
+{
+    for (auto& partition : partitions_) {
+        if (partition->get_stats().pages) {
+            return ReturnValue::Fail;
+        }
+    }
+    ReturnValue result = ReturnValue::Fail;
+    for (auto& partition : partitions_) {
+        result = partition->add_index(desc);
+    }
+    return result;
+}
+
+size_t PartitionedObjectHive::find_indexed(Uid interfaceUid, size_t field_offset, uint64_t first, uint64_t last,
+                                           void* context, StateVisitorFn visitor) const
+{
+    // Each partition has its own index: a Sorted lookup is in key order per partition only.
+    PartitionVisit<IObject&, void*> visit{context, visitor};
+    size_t visited = 0;
+    for (auto& partition : partitions_) {
+        visited += partition->find_indexed(interfaceUid, field_offset, first, last, &visit,
+                                           &decltype(visit)::forward);
+        if (visit.done()) {
+            break;
+        }
+    }
+    return visited;
+}
+
+IEvent::Ptr PartitionedObjectHive::on_membership_changed() const
+{
+    return membership_.event(get_self<IObjectHive>());
+}
+
+ReturnValue PartitionedObjectHive::set_threading(HiveThreading threading)
+{
+    // Partitions exist for concurrent spawning.
+    return threading == HiveThreading::MultiThread ? ReturnValue::Success : ReturnValue::Refused;
+}
+
+HiveThreading PartitionedObjectHive::get_threading() const
+{
+    return HiveThreading::MultiThread;
+}
+
+} // namespace velk
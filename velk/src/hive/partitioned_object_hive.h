@@ -0,0 +1,103 @@
+#ifndef VELK_PLUGINS_PARTITIONED_OBJECT_HIVE_H
+#define VELK_PLUGINS_PARTITIONED_OBJECT_HIVE_H
+
+#include "hive_membership.h"
+
+#include <velk/ext/core_object.h>
+#include <velk/interface/hive/intf_hive.h>
+
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief IObjectHive split into independent ObjectHive partitions to avoid lock contention.
+ *
+ * Each thread adds objects to its own partition, picked round-robin the first time the
+ * thread touches any partitioned hive, so concurrent spawners only share a lock when
+ * there are more threads than partitions. Removal is routed to the partition owning the
+ * object, trying the calling thread's partition first. Iteration and the other queries
+ * cover all partitions in turn, so the hive behaves as one logical hive.
+ */
+class PartitionedObjectHive final : public ext::ObjectCore<PartitionedObjectHive, IObjectHive>
+{
+public:
+    VELK_CLASS_UID(ClassId::PartitionedObjectHive);
+
+    ~PartitionedObjectHive() override;
+
+    /** @brief Initializes @p partitions partitions for the given class UID. */
+    void init(Uid classUid, size_t partitions, const IHivePageSource::Ptr& source);
+
+    // IHive overrides
+    HiveType get_hive_type() const override { return HiveType::ObjectHive; }
+    Uid get_element_uid() const override;
+    size_t size() const override;
+    bool empty() const override;
+    void clear() override;
+    HivePageCapacity get_page_capacity() const override;
+    HiveStats get_stats() const override;
+    void set_page_capacity(const HivePageCapacity& capacity) override;
+    size_t get_slot_alignment() const override;
+    ReturnValue set_slot_alignment(size_t alignment) override;
+    IHivePageSource::Ptr get_page_source() const override;
+    void set_page_source(const IHivePageSource::Ptr& source) override;
+    size_t trim(size_t keep_free_slots) override;
+    ReturnValue reserve(size_t free_slots) override;
+    void for_each_page(void* context, PageVisitorFn visitor, IExecutor* executor) const override;
+
+    // IObjectHive overrides
+    IObject::Ptr add() override;
+    size_t add_n(size_t count, IObject::Ptr* out) override;
+    ReturnValue remove(IObject& object) override;
+    void clear_parallel(IExecutor* executor, HivePageRelease release) override;
+    bool contains(const IObject& object) const override;
+    HiveHandle get_handle(const IObject& object) const override;
+    IObject* resolve(HiveHandle handle) const override;
+    void for_each(void* context, VisitorFn visitor) const override;
+    ptrdiff_t get_state_offset(Uid interfaceUid) const override;
+    void for_each_state(ptrdiff_t state_offset, void* context, StateVisitorFn visitor) const override;
+    void for_each_state_parallel(ptrdiff_t state_offset, void* context, StateVisitorFn visitor,
+                                 IExecutor* executor) const override;
+    size_t compact() override;
+    ReturnValue add_state_column(Uid interfaceUid, size_t state_size, size_t state_alignment) override;
+    bool has_state_column(Uid interfaceUid) const override;
+    void for_each_column(Uid interfaceUid, void* context, ColumnVisitorFn visitor,
+                         IExecutor* executor) const override;
+    ReturnValue add_double_buffered_state(Uid interfaceUid, size_t state_size,
+                                          size_t state_alignment) override;
+    void for_each_front(Uid interfaceUid, void* context, ColumnVisitorFn visitor,
+                        IExecutor* executor) const override;
+    void swap_state_buffers() override;
+    size_t snapshot_states(Uid interfaceUid, size_t state_size, void* buffer, size_t size) const override;
+    ReturnValue restore_states(Uid interfaceUid, size_t state_size, const void* buffer, size_t size) override;
+    ReturnValue add_dirty_tracking(Uid interfaceUid) override;
+    bool has_dirty_tracking(Uid interfaceUid) const override;
+    size_t for_each_dirty(Uid interfaceUid, void* context, StateVisitorFn visitor) override;
+    ReturnValue add_change_journal(Uid interfaceUid, size_t state_size, size_t state_alignment) override;
+    size_t write_changes(Uid interfaceUid, void* buffer, size_t size) override;
+    ReturnValue add_index(const HiveIndexDesc& desc) override;
+    size_t find_indexed(Uid interfaceUid, size_t field_offset, uint64_t first, uint64_t last, void* context,
+                        StateVisitorFn visitor) const override;
+    IEvent::Ptr on_membership_changed() const override;
+    ReturnValue set_threading(HiveThreading threading) override;
+    HiveThreading get_threading() const override;
+
+    /** @brief Returns the number of partitions. */
+    size_t partition_count() const { return partitions_.size(); }
+
+private:
+    /** @brief Returns the partition the calling thread adds to. */
+    IObjectHive& local_partition() const;
+
+    /** @brief Returns @p count split evenly over the partitions, rounded up. */
+    size_t per_partition(size_t count) const;
+
+    Uid element_class_uid_;
+    std::vector<IObjectHive::Ptr> partitions_; ///< Fixed after init(), so reads need no lock.
+    mutable HiveMembership membership_;        ///< Shared by the partitions, backs on_membership_changed().
+};
+
+} // namespace velk
+
+#endif // VELK_PLUGINS_PARTITIONED_OBJECT_HIVE_H
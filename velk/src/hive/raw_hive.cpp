@@ -1,5 +1,8 @@
 #include "raw_hive.h"
 
+#include <velk/trace.h>
+
+#include <algorithm>
 #include <cstring>
 
 namespace velk {
@@ -14,11 +17,13 @@ RawHiveImpl::~RawHiveImpl()
 void RawHiveImpl::init(Uid elementUid, size_t elementSize, size_t elementAlign)
 {
     element_uid_ = elementUid;
-    slot_size_ = align_up(elementSize, elementAlign);
-    if (slot_size_ < sizeof(size_t)) {
-        slot_size_ = sizeof(size_t);
+    element_size_ = align_up(elementSize, elementAlign);
+    if (element_size_ < sizeof(size_t)) {
+        element_size_ = sizeof(size_t);
     }
-    slot_align_ = elementAlign;
+    element_align_ = elementAlign;
+    slot_size_ = element_size_;
+    slot_align_ = element_align_;
 }
 
 Uid RawHiveImpl::get_element_uid() const
@@ -28,12 +33,31 @@ Uid RawHiveImpl::get_element_uid() const
 
 size_t RawHiveImpl::size() const
 {
-    return live_count_;
+    return live_count_.load(std::memory_order_relaxed);
 }
 
 bool RawHiveImpl::empty() const
 {
-    return live_count_ == 0;
+    return live_count_.load(std::memory_order_relaxed) == 0;
+}
+
+HiveStats RawHiveImpl::get_stats() const
+{
+    std::shared_lock lock(mutex_);
+    HiveStats stats;
+    stats.pages = pages_.size();
+    stats.live = live_count_.load(std::memory_order_relaxed);
+    for (auto& page_ptr : pages_) {
+        auto& page = *page_ptr;
+        stats.capacity += page.capacity;
+        stats.reserved_bytes += page.allocation_size;
+        // Slots cached in magazines count as used by their page.
+        if (page.live_count) {
+            stats.fragmented_slots += page.capacity - page.live_count;
+        }
+    }
+    stats.free_slots = stats.capacity - stats.live;
+    return stats;
 }
 
 HivePageCapacity RawHiveImpl::get_page_capacity() const
@@ -46,6 +70,42 @@ void RawHiveImpl::set_page_capacity(const HivePageCapacity& capacity)
     capacity_ = check_capacity(capacity);
 }
 
+size_t RawHiveImpl::get_slot_alignment() const
+{
+    std::shared_lock lock(mutex_);
+    return slot_align_;
+}
+
+ReturnValue RawHiveImpl::set_slot_alignment(size_t alignment)
+{
+    if (alignment & (alignment - 1)) {
+        return ReturnValue::InvalidArgument;
+    }
+    check_iteration_guard(mutex_, "set_slot_alignment");
+
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    if (!pages_.empty()) {
+        return ReturnValue::Fail;
+    }
+    slot_align_ = alignment > element_align_ ? alignment : element_align_;
+    slot_size_ = align_up(element_size_, slot_align_);
+    return ReturnValue::Success;
+}
+
+IHivePageSource::Ptr RawHiveImpl::get_page_source() const
+{
+    std::shared_lock lock(mutex_);
+    return page_source_;
+}
+
+void RawHiveImpl::set_page_source(const IHivePageSource::Ptr& source)
+{
+    check_iteration_guard(mutex_, "set_page_source");
+
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    page_source_ = source;
+}
+
 void* RawHiveImpl::slot_ptr(const RawHivePage& page, size_t index) const
 {
     return static_cast<char*>(page.slots) + index * slot_size_;
@@ -66,8 +126,7 @@ void RawHiveImpl::alloc_page(size_t capacity)
     size_t slots_bytes = capacity * slot_size_;
     size_t total = slots_offset + slots_bytes;
 
-    auto* mem = static_cast<char*>(aligned_alloc_impl(alloc_align, total));
-    page->allocation = mem;
+    auto* mem = static_cast<char*>(allocate_page_memory(*page, page_source_, alloc_align, total));
     page->active_bits = reinterpret_cast<uint64_t*>(mem);
     page->slots = mem + slots_offset;
 
@@ -77,147 +136,567 @@ void RawHiveImpl::alloc_page(size_t capacity)
     page->live_count = 0;
 
     current_page_ = page.get();
+    free_slots_ += capacity;
+    free_pages_.push(page.get());
+    insert_sorted_page(sorted_pages_, page.get());
     pages_.push_back(std::move(page));
+    note_page_alloc(capacity_, pages_, growth_);
 }
 
-void* RawHiveImpl::allocate()
+RawHivePage* RawHiveImpl::find_page(const void* ptr, size_t& slot_idx) const
 {
-    check_iteration_guard(mutex_, "allocate");
-
-    std::lock_guard<std::shared_mutex> lock(mutex_);
+    return find_sorted_page(sorted_pages_, ptr, slot_size_, slot_idx);
+}
 
+size_t RawHiveImpl::take_free_slot(RawHivePage*& page)
+{
+    // Check cached page hint first, then take any page from the free-page list.
     RawHivePage* target = nullptr;
     if (current_page_ && current_page_->free_head != PAGE_SENTINEL) {
         target = current_page_;
     } else {
-        for (auto& page_ptr : pages_) {
-            if (page_ptr->free_head != PAGE_SENTINEL) {
-                target = page_ptr.get();
-                break;
-            }
-        }
+        target = free_pages_.head;
     }
 
     if (!target) {
-        alloc_page(next_page_capacity(capacity_, pages_.size()));
+        alloc_page(next_page_capacity(capacity_, pages_, slot_size_, growth_));
         target = pages_.back().get();
     }
 
     current_page_ = target;
 
     size_t slot_idx = pop_free_slot(target->slots, slot_size_, target->free_head);
+    if (target->free_head == PAGE_SENTINEL) {
+        free_pages_.unlink(target);
+    }
+    ++target->live_count;
+    --free_slots_;
+    page = target;
+    return slot_idx;
+}
+
+void RawHiveImpl::return_free_slot(RawHivePage& page, size_t slot_idx)
+{
+    push_free_slot(page.slots, slot_idx, slot_size_, page.free_head);
+    free_pages_.push(&page);
+    --page.live_count;
+    ++free_slots_;
+    ++growth_.returned;
+}
+
+void RawHiveImpl::release_page(RawHivePage& page)
+{
+    free_pages_.unlink(&page);
+    if (current_page_ == &page) {
+        current_page_ = free_pages_.head;
+    }
+    free_slots_ -= page.capacity;
+    free_page_memory(page);
+}
+
+void RawHiveImpl::erase_released_pages()
+{
+    sorted_pages_.erase(std::remove_if(sorted_pages_.begin(),
+                                       sorted_pages_.end(),
+                                       [](const RawHivePage* page) { return !page->allocation; }),
+                        sorted_pages_.end());
+    pages_.erase(std::remove_if(pages_.begin(),
+                                pages_.end(),
+                                [](const std::unique_ptr<RawHivePage>& page) { return !page->allocation; }),
+                 pages_.end());
+}
+
+void* RawHiveImpl::allocate()
+{
+    check_iteration_guard(mutex_, "allocate");
+
+    if (magazine_size_.load(std::memory_order_relaxed)) {
+        if (void* slot = magazine_allocate()) {
+            return slot;
+        }
+    }
+
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+
+    RawHivePage* page;
+    size_t slot_idx = take_free_slot(page);
 
     size_t word = slot_idx / 64;
     size_t bit = slot_idx % 64;
-    set_slot_active(target->active_bits, word, bit);
-    ++target->live_count;
-    ++live_count_;
+    set_slot_active(page->active_bits, word, bit);
+    live_count_.fetch_add(1, std::memory_order_relaxed);
+
+    // Refill the calling thread's magazine while we hold the exclusive lock anyway.
+    if (magazines_) {
+        auto& magazine = magazines_[thread_magazine_index()];
+        std::lock_guard<std::mutex> mlock(magazine.mutex);
+        size_t refill = magazine_size_.load(std::memory_order_relaxed) / 2;
+        while (magazine.count < refill) {
+            RawHivePage* cached;
+            size_t cached_idx = take_free_slot(cached);
+            magazine.slots[magazine.count++] = {cached, cached_idx};
+        }
+    }
 
-    return slot_ptr(*target, slot_idx);
+    return slot_ptr(*page, slot_idx);
+}
+
+size_t RawHiveImpl::allocate_n(size_t count, void** out)
+{
+    if (!out || !count) {
+        return 0;
+    }
+
+    check_iteration_guard(mutex_, "allocate_n");
+
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+
+    // Reserve every slot up front so the loop never allocates.
+    reserve_slots(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        RawHivePage* page;
+        size_t slot_idx = take_free_slot(page);
+        set_slot_active(page->active_bits, slot_idx / 64, slot_idx % 64);
+        out[i] = slot_ptr(*page, slot_idx);
+    }
+    live_count_.fetch_add(count, std::memory_order_relaxed);
+    return count;
 }
 
 void RawHiveImpl::deallocate(void* ptr)
 {
     check_iteration_guard(mutex_, "deallocate");
 
+    if (magazine_size_.load(std::memory_order_relaxed) && magazine_deallocate(ptr)) {
+        return;
+    }
+
     std::lock_guard<std::shared_mutex> lock(mutex_);
-    auto ptr_addr = reinterpret_cast<uintptr_t>(ptr);
-    for (auto& page_ptr : pages_) {
-        auto& page = *page_ptr;
-        auto base = reinterpret_cast<uintptr_t>(page.slots);
-        auto end = base + page.capacity * slot_size_;
-        if (ptr_addr >= base && ptr_addr < end) {
-            size_t offset = static_cast<size_t>(ptr_addr - base);
-            if (offset % slot_size_ != 0) {
-                return;
-            }
-            size_t slot_idx = offset / slot_size_;
+    size_t slot_idx;
+    RawHivePage* page = find_page(ptr, slot_idx);
+    if (!page) {
+        return;
+    }
+
+    size_t word = slot_idx / 64;
+    size_t bit = slot_idx % 64;
+    clear_slot_active(page->active_bits, word, bit);
+    return_free_slot(*page, slot_idx);
+    live_count_.fetch_sub(1, std::memory_order_relaxed);
+
+    // High-water-mark shrink: release the page once it empties if the hive holds
+    // more free slots than the policy allows.
+    size_t max_free = capacity_.max_free_slots;
+    if (max_free && free_slots_ > max_free && page->live_count == 0) {
+        release_page(*page);
+        erase_released_pages();
+    }
 
-            size_t word = slot_idx / 64;
-            size_t bit = slot_idx % 64;
-            clear_slot_active(page.active_bits, word, bit);
+    // The calling thread's magazine was full: drain it to half so the next
+    // deallocations can be cached again.
+    if (magazines_) {
+        auto& magazine = magazines_[thread_magazine_index()];
+        std::lock_guard<std::mutex> mlock(magazine.mutex);
+        drain_magazine(magazine, magazine_size_.load(std::memory_order_relaxed) / 2);
+    }
+}
 
-            push_free_slot(page.slots, slot_idx, slot_size_, page.free_head);
-            --page.live_count;
-            --live_count_;
-            return;
+void* RawHiveImpl::magazine_allocate()
+{
+    std::shared_lock lock(mutex_);
+    if (!magazines_) {
+        return nullptr;
+    }
+    MagazineSlot slot;
+    {
+        auto& magazine = magazines_[thread_magazine_index()];
+        std::lock_guard<std::mutex> mlock(magazine.mutex);
+        if (!magazine.count) {
+            return nullptr;
+        }
+        slot = magazine.slots[--magazine.count];
+    }
+    // Other threads may concurrently flip bits in the same word under the shared lock.
+    atomic_set_slot_active(slot.page->active_bits, slot.index / 64, slot.index % 64);
+    live_count_.fetch_add(1, std::memory_order_relaxed);
+    return slot_ptr(*slot.page, slot.index);
+}
+
+bool RawHiveImpl::magazine_deallocate(void* ptr)
+{
+    std::shared_lock lock(mutex_);
+    if (!magazines_) {
+        return false;
+    }
+    size_t slot_idx;
+    RawHivePage* page = find_page(ptr, slot_idx);
+    if (!page) {
+        return true; // Not ours, nothing to do.
+    }
+    auto& magazine = magazines_[thread_magazine_index()];
+    std::lock_guard<std::mutex> mlock(magazine.mutex);
+    if (magazine.count >= magazine.slots.size()) {
+        return false;
+    }
+    atomic_clear_slot_active(page->active_bits, slot_idx / 64, slot_idx % 64);
+    magazine.slots[magazine.count++] = {page, slot_idx};
+    live_count_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void RawHiveImpl::drain_magazine(Magazine& magazine, size_t keep)
+{
+    while (magazine.count > keep) {
+        auto& slot = magazine.slots[--magazine.count];
+        return_free_slot(*slot.page, slot.index);
+    }
+}
+
+void RawHiveImpl::drain_magazines()
+{
+    if (magazines_) {
+        for (size_t i = 0; i < MAGAZINE_COUNT; ++i) {
+            drain_magazine(magazines_[i], 0);
+        }
+    }
+}
+
+void RawHiveImpl::set_magazine_size(size_t slots)
+{
+    check_iteration_guard(mutex_, "set_magazine_size");
+
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    drain_magazines();
+    magazines_.reset();
+    if (slots) {
+        magazines_ = std::make_unique<Magazine[]>(MAGAZINE_COUNT);
+        for (size_t i = 0; i < MAGAZINE_COUNT; ++i) {
+            magazines_[i].slots.resize(slots);
+        }
+    }
+    magazine_size_.store(slots, std::memory_order_relaxed);
+}
+
+size_t RawHiveImpl::get_magazine_size() const
+{
+    return magazine_size_.load(std::memory_order_relaxed);
+}
+
+void RawHiveImpl::flush_magazines()
+{
+    check_iteration_guard(mutex_, "flush_magazines");
+
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    drain_magazines();
+}
+
+size_t RawHiveImpl::trim(size_t keep_free_slots)
+{
+    check_iteration_guard(mutex_, "trim");
+
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    drain_magazines();
+    size_t freed = 0;
+    // Release from the back: later pages are the largest ones.
+    for (auto it = pages_.rbegin(); it != pages_.rend(); ++it) {
+        auto& page = **it;
+        if (page.live_count == 0 && free_slots_ >= keep_free_slots + page.capacity) {
+            release_page(page);
+            ++freed;
         }
     }
+    if (freed) {
+        erase_released_pages();
+    }
+    return freed;
+}
+
+ReturnValue RawHiveImpl::reserve(size_t free_slots)
+{
+    check_iteration_guard(mutex_, "reserve");
+
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    return reserve_slots(free_slots) ? ReturnValue::Success : ReturnValue::NothingToDo;
+}
+
+bool RawHiveImpl::reserve_slots(size_t free_slots)
+{
+    if (free_slots_ >= free_slots) {
+        return false;
+    }
+    // A single page covers the whole shortfall.
+    size_t shortfall = free_slots - free_slots_;
+    size_t capacity = next_page_capacity(capacity_, pages_, slot_size_, growth_);
+    alloc_page(capacity > shortfall ? capacity : shortfall);
+    return true;
 }
 
 bool RawHiveImpl::contains(const void* ptr) const
 {
     std::shared_lock lock(mutex_);
-    auto ptr_addr = reinterpret_cast<uintptr_t>(ptr);
-    for (auto& page_ptr : pages_) {
-        auto& page = *page_ptr;
-        auto base = reinterpret_cast<uintptr_t>(page.slots);
-        auto end = base + page.capacity * slot_size_;
-        if (ptr_addr >= base && ptr_addr < end) {
-            size_t offset = static_cast<size_t>(ptr_addr - base);
-            if (offset % slot_size_ != 0) {
+    size_t slot_idx;
+    const RawHivePage* page = find_page(ptr, slot_idx);
+    if (!page) {
+        return false;
+    }
+    size_t word = slot_idx / 64;
+    size_t bit = slot_idx % 64;
+    return is_slot_active(page->active_bits, word, bit);
+}
+
+bool RawHiveImpl::scan_words(const RawHivePage& page, size_t word_begin, size_t word_end, void* context,
+                             RawVisitorFn visitor) const
+{
+    bool dense = page.live_count == page.capacity;
+    for (size_t w = word_begin; w < word_end; ++w) {
+        uint64_t bits = page.active_bits[w];
+        if (!bits) {
+            continue;
+        }
+        size_t base = w * 64;
+        // Fast path: all 64 slots active, skip bitscan and prefetch.
+        if (bits == ~uint64_t(0)) {
+            for (size_t i = 0; i < 64; ++i) {
+                if (!visitor(context, slot_ptr(page, base + i))) {
+                    return false;
+                }
+            }
+            continue;
+        }
+        while (bits) {
+            unsigned b = bitscan_forward64(bits);
+            bits &= bits - 1;
+            size_t i = base + b;
+
+            // Prefetch next active slot (skip for fully dense pages).
+            if (!dense) {
+                uint64_t remaining = bits;
+                if (remaining) {
+                    unsigned nb = bitscan_forward64(remaining);
+                    prefetch_line(slot_ptr(page, base + nb));
+                } else if (w + 1 < word_end) {
+                    for (size_t nw = w + 1; nw < word_end; ++nw) {
+                        uint64_t next_bits = page.active_bits[nw];
+                        if (next_bits) {
+                            prefetch_line(slot_ptr(page, nw * 64 + bitscan_forward64(next_bits)));
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if (!visitor(context, slot_ptr(page, i))) {
                 return false;
             }
-            size_t slot_idx = offset / slot_size_;
-            size_t word = slot_idx / 64;
-            size_t bit = slot_idx % 64;
-            return is_slot_active(page.active_bits, word, bit);
         }
     }
-    return false;
+    return true;
 }
 
 void RawHiveImpl::for_each(void* context, RawVisitorFn visitor) const
 {
+    VELK_TRACE_ZONE("RawHive::for_each");
     std::shared_lock lock(mutex_);
     IterationGuard guard(&mutex_);
     for (auto& page_ptr : pages_) {
         auto& page = *page_ptr;
-        bool dense = page.live_count == page.capacity;
+        if (!scan_words(page, 0, bitmask_words(page.capacity), context, visitor)) {
+            return;
+        }
+    }
+}
+
+void RawHiveImpl::for_each_parallel(void* context, RawVisitorFn visitor, IExecutor* executor) const
+{
+    VELK_TRACE_ZONE("RawHive::for_each_parallel");
+    std::shared_lock lock(mutex_);
+    IterationGuard guard(&mutex_);
+    auto scan = [&](const RawHivePage& page, size_t word_begin, size_t word_end) {
+        return scan_words(page, word_begin, word_end, context, visitor);
+    };
+    parallel_scan(pages_, &mutex_, executor, scan);
+}
+
+void RawHiveImpl::for_each_page(void* context, PageVisitorFn visitor, IExecutor* executor) const
+{
+    VELK_TRACE_ZONE("RawHive::for_each_page");
+    std::shared_lock lock(mutex_);
+    IterationGuard guard(&mutex_);
+    auto visit = [&](const RawHivePage& page, size_t word_begin, size_t word_end) {
+        size_t first = word_begin * 64;
+        size_t end = word_end * 64 < page.capacity ? word_end * 64 : page.capacity;
+        HivePageView view{slot_ptr(page, first), slot_size_, page.active_bits + word_begin, end - first};
+        return visitor(context, view);
+    };
+
+    if (executor) {
+        parallel_scan(pages_, &mutex_, executor, visit);
+        return;
+    }
+    for (auto& page_ptr : pages_) {
+        auto& page = *page_ptr;
+        if (page.live_count && !visit(page, 0, bitmask_words(page.capacity))) {
+            return;
+        }
+    }
+}
+
+size_t RawHiveImpl::compact(void* context, RelocateFn relocate)
+{
+    check_iteration_guard(mutex_, "compact");
+
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    drain_magazines();
+    if (pages_.empty()) {
+        return 0;
+    }
+
+    // Keep the fullest pages until they can hold every live element, move the rest.
+    std::vector<RawHivePage*> order;
+    order.reserve(pages_.size());
+    for (auto& page_ptr : pages_) {
+        order.push_back(page_ptr.get());
+    }
+    std::sort(order.begin(), order.end(), [](const RawHivePage* lhs, const RawHivePage* rhs) {
+        return lhs->live_count != rhs->live_count ? lhs->live_count > rhs->live_count
+                                                  : lhs->capacity > rhs->capacity;
+    });
+    size_t live = live_count_.load(std::memory_order_relaxed);
+    size_t kept_capacity = 0;
+    size_t keep = 0;
+    while (keep < order.size() && kept_capacity < live) {
+        kept_capacity += order[keep++]->capacity;
+    }
+    if (keep == order.size()) {
+        return 0;
+    }
+
+    size_t target = 0;
+    for (size_t si = keep; si < order.size(); ++si) {
+        auto& src = *order[si];
+        size_t num_words = bitmask_words(src.capacity);
+        for (size_t w = 0; w < num_words && src.live_count; ++w) {
+            uint64_t bits = src.active_bits[w];
+            while (bits) {
+                unsigned b = bitscan_forward64(bits);
+                bits &= bits - 1;
+                while (order[target]->free_head == PAGE_SENTINEL) {
+                    ++target;
+                }
+                auto& dst = *order[target];
+                size_t dst_idx = pop_free_slot(dst.slots, slot_size_, dst.free_head);
+                set_slot_active(dst.active_bits, dst_idx / 64, dst_idx % 64);
+                ++dst.live_count;
+                --src.live_count;
+
+                void* old_ptr = slot_ptr(src, w * 64 + b);
+                void* new_ptr = slot_ptr(dst, dst_idx);
+                std::memcpy(new_ptr, old_ptr, slot_size_);
+                if (relocate) {
+                    relocate(context, old_ptr, new_ptr);
+                }
+            }
+        }
+        free_page_memory(src);
+    }
+
+    size_t freed = order.size() - keep;
+    erase_released_pages();
+    free_pages_.reset();
+    free_slots_ = 0;
+    for (auto& page_ptr : pages_) {
+        auto* page = page_ptr.get();
+        page->in_free_list = false;
+        if (page->free_head != PAGE_SENTINEL) {
+            free_pages_.push(page);
+        }
+        free_slots_ += page->capacity - page->live_count;
+    }
+    current_page_ = free_pages_.head;
+    return freed;
+}
+
+size_t RawHiveImpl::sort(void* context, LessFn less, RelocateFn relocate)
+{
+    check_iteration_guard(mutex_, "sort");
+
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    drain_magazines();
+    size_t live = live_count_.load(std::memory_order_relaxed);
+    if (!less || !live) {
+        return 0;
+    }
+
+    std::vector<void*> elements;
+    elements.reserve(live);
+    for (auto& page_ptr : pages_) {
+        auto& page = *page_ptr;
         size_t num_words = bitmask_words(page.capacity);
         for (size_t w = 0; w < num_words; ++w) {
             uint64_t bits = page.active_bits[w];
-            if (!bits) {
-                continue;
-            }
-            size_t base = w * 64;
-            // Fast path: all 64 slots active, skip bitscan and prefetch.
-            if (bits == ~uint64_t(0)) {
-                for (size_t i = 0; i < 64; ++i) {
-                    if (!visitor(context, slot_ptr(page, base + i))) {
-                        return;
-                    }
-                }
-                continue;
-            }
             while (bits) {
                 unsigned b = bitscan_forward64(bits);
                 bits &= bits - 1;
-                size_t i = base + b;
-
-                // Prefetch next active slot (skip for fully dense pages).
-                if (!dense) {
-                    uint64_t remaining = bits;
-                    if (remaining) {
-                        unsigned nb = bitscan_forward64(remaining);
-                        prefetch_line(slot_ptr(page, base + nb));
-                    } else if (w + 1 < num_words) {
-                        for (size_t nw = w + 1; nw < num_words; ++nw) {
-                            uint64_t next_bits = page.active_bits[nw];
-                            if (next_bits) {
-                                prefetch_line(slot_ptr(page, nw * 64 + bitscan_forward64(next_bits)));
-                                break;
-                            }
-                        }
-                    }
-                }
+                elements.push_back(slot_ptr(page, w * 64 + b));
+            }
+        }
+    }
+    std::stable_sort(elements.begin(), elements.end(), [&](const void* lhs, const void* rhs) {
+        return less(context, lhs, rhs);
+    });
+
+    // Elements are written back in sorted order, so take a copy of all of them first.
+    std::vector<char> copy(live * slot_size_);
+    for (size_t i = 0; i < live; ++i) {
+        std::memcpy(copy.data() + i * slot_size_, elements[i], slot_size_);
+    }
 
-                if (!visitor(context, slot_ptr(page, i))) {
-                    return;
+    // Fill the largest pages first. Iteration follows pages_, so they go to the front.
+    std::stable_sort(pages_.begin(), pages_.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs->capacity > rhs->capacity;
+    });
+    size_t next = 0;
+    size_t moved = 0;
+    for (auto& page_ptr : pages_) {
+        auto& page = *page_ptr;
+        size_t count = page.capacity < live - next ? page.capacity : live - next;
+        if (!count) {
+            free_page_memory(page);
+            continue;
+        }
+        std::memset(page.active_bits, 0, bitmask_words(page.capacity) * sizeof(uint64_t));
+        for (size_t i = 0; i < count; ++i, ++next) {
+            void* new_ptr = slot_ptr(page, i);
+            std::memcpy(new_ptr, copy.data() + next * slot_size_, slot_size_);
+            set_slot_active(page.active_bits, i / 64, i % 64);
+            if (new_ptr != elements[next]) {
+                ++moved;
+                if (relocate) {
+                    relocate(context, elements[next], new_ptr);
                 }
             }
         }
+        page.live_count = count;
+        page.free_head = PAGE_SENTINEL;
+        for (size_t i = page.capacity; i-- > count;) {
+            push_free_slot(page.slots, i, slot_size_, page.free_head);
+        }
     }
+
+    erase_released_pages();
+    free_pages_.reset();
+    free_slots_ = 0;
+    for (auto& page_ptr : pages_) {
+        auto* page = page_ptr.get();
+        page->in_free_list = false;
+        if (page->free_head != PAGE_SENTINEL) {
+            free_pages_.push(page);
+        }
+        free_slots_ += page->capacity - page->live_count;
+    }
+    current_page_ = free_pages_.head;
+    return moved;
 }
 
 void RawHiveImpl::clear(void* context, DestroyFn destroy)
@@ -225,25 +704,61 @@ void RawHiveImpl::clear(void* context, DestroyFn destroy)
     check_iteration_guard(mutex_, "clear");
 
     std::lock_guard<std::shared_mutex> lock(mutex_);
-    for (auto& page_ptr : pages_) {
-        auto& page = *page_ptr;
-        if (destroy) {
-            size_t num_words = bitmask_words(page.capacity);
-            for (size_t w = 0; w < num_words; ++w) {
-                uint64_t bits = page.active_bits[w];
-                while (bits) {
-                    unsigned b = bitscan_forward64(bits);
-                    bits &= bits - 1;
-                    size_t i = w * 64 + b;
-                    destroy(context, slot_ptr(page, i));
-                }
+    clear_pages(context, destroy);
+}
+
+void RawHiveImpl::clear_parallel(void* context, DestroyFn destroy, IExecutor* executor,
+                                 HivePageRelease release)
+{
+    check_iteration_guard(mutex_, "clear_parallel");
+
+    std::vector<PageMemory> deferred;
+    {
+        std::lock_guard<std::shared_mutex> lock(mutex_);
+        clear_pages(context, destroy, executor, release == HivePageRelease::Background ? &deferred : nullptr);
+    }
+    free_page_memory_async(std::move(deferred));
+}
+
+void RawHiveImpl::clear_pages(void* context, DestroyFn destroy, IExecutor* executor,
+                              std::vector<PageMemory>* deferred)
+{
+    auto destroy_words = [&](const RawHivePage& page, size_t word_begin, size_t word_end) {
+        for (size_t w = word_begin; w < word_end; ++w) {
+            uint64_t bits = page.active_bits[w];
+            while (bits) {
+                unsigned b = bitscan_forward64(bits);
+                bits &= bits - 1;
+                destroy(context, slot_ptr(page, w * 64 + b));
             }
         }
-        aligned_free_impl(page.allocation);
+        return true;
+    };
+    if (destroy && executor) {
+        parallel_scan(pages_, &mutex_, executor, destroy_words);
+    }
+    for (auto& page_ptr : pages_) {
+        if (destroy && !executor) {
+            destroy_words(*page_ptr, 0, bitmask_words(page_ptr->capacity));
+        }
+        if (deferred) {
+            take_page_memory(*page_ptr, *deferred);
+        } else {
+            free_page_memory(*page_ptr);
+        }
     }
     pages_.clear();
+    sorted_pages_.clear();
+    free_pages_.reset();
+    free_slots_ = 0;
+    if (magazines_) {
+        // Cached slots pointed into the freed pages.
+        for (size_t i = 0; i < MAGAZINE_COUNT; ++i) {
+            magazines_[i].count = 0;
+        }
+    }
     current_page_ = nullptr;
-    live_count_ = 0;
+    live_count_.store(0, std::memory_order_relaxed);
 }
 
 void RawHiveImpl::clear()
@@ -251,4 +766,231 @@ void RawHiveImpl::clear()
     clear(nullptr, nullptr);
 }
 
+size_t RawHiveImpl::snapshot_alignment() const
+{
+    return slot_align_ > alignof(uint64_t) ? slot_align_ : alignof(uint64_t);
+}
+
+size_t RawHiveImpl::snapshot_layout(HiveSnapshotPage* records) const
+{
+    size_t alignment = snapshot_alignment();
+    size_t offset = sizeof(HiveSnapshotHeader) + pages_.size() * sizeof(HiveSnapshotPage);
+    for (size_t i = 0; i < pages_.size(); ++i) {
+        auto& page = *pages_[i];
+        size_t bits_offset = align_up(offset, alignof(uint64_t));
+        size_t bits_bytes = bitmask_words(page.capacity) * sizeof(uint64_t);
+        size_t slots_offset = align_up(bits_offset + bits_bytes, alignment);
+        if (records) {
+            records[i] = {page.capacity, bits_offset, slots_offset};
+        }
+        offset = slots_offset + page.capacity * slot_size_;
+    }
+    return offset;
+}
+
+size_t RawHiveImpl::snapshot(void* buffer, size_t size) const
+{
+    std::shared_lock lock(mutex_);
+    size_t total = snapshot_layout(nullptr);
+    if (!buffer || size < total) {
+        return total;
+    }
+
+    std::vector<HiveSnapshotPage> records(pages_.size());
+    snapshot_layout(records.data());
+
+    auto* out = static_cast<char*>(buffer);
+    size_t offset = sizeof(HiveSnapshotHeader);
+    std::memcpy(out + offset, records.data(), records.size() * sizeof(HiveSnapshotPage));
+    offset += records.size() * sizeof(HiveSnapshotPage);
+
+    HiveSnapshotHeader header;
+    header.element_uid = element_uid_;
+    header.element_size = slot_size_;
+    header.alignment = snapshot_alignment();
+    header.page_count = pages_.size();
+    header.size = total;
+    for (size_t i = 0; i < pages_.size(); ++i) {
+        auto& page = *pages_[i];
+        auto& record = records[i];
+        size_t bits_bytes = bitmask_words(page.capacity) * sizeof(uint64_t);
+        std::memset(out + offset, 0, record.bits_offset - offset);
+        std::memcpy(out + record.bits_offset, page.active_bits, bits_bytes);
+        offset = record.bits_offset + bits_bytes;
+        std::memset(out + offset, 0, record.slots_offset - offset);
+        std::memcpy(out + record.slots_offset, page.slots, page.capacity * slot_size_);
+        offset = record.slots_offset + page.capacity * slot_size_;
+        // Count from the copied bits, which magazines may change under the shared lock.
+        auto* bits = reinterpret_cast<const unsigned char*>(out + record.bits_offset);
+        for (size_t w = 0; w < bits_bytes / sizeof(uint64_t); ++w) {
+            uint64_t word;
+            std::memcpy(&word, bits + w * sizeof(uint64_t), sizeof(word));
+            header.count += popcount64(word);
+        }
+    }
+    std::memcpy(out, &header, sizeof(header));
+    return total;
+}
+
+bool RawHiveImpl::read_snapshot(const char* buffer, size_t size, HiveSnapshotHeader& header,
+                                std::vector<HiveSnapshotPage>& records) const
+{
+    if (!buffer || size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, buffer, sizeof(header));
+    if (header.magic != HiveSnapshotHeader::MAGIC || header.version != HiveSnapshotHeader::VERSION ||
+        header.element_uid != element_uid_ || header.element_size != slot_size_ || header.size > size ||
+        header.size < sizeof(header) ||
+        header.page_count > (header.size - sizeof(header)) / sizeof(HiveSnapshotPage)) {
+        return false;
+    }
+
+    // Pages must lie within the snapshot, in order and without overlapping, and no bit
+    // beyond a page's capacity may be set.
+    records.resize(header.page_count);
+    std::memcpy(records.data(), buffer + sizeof(header), records.size() * sizeof(HiveSnapshotPage));
+    size_t offset = sizeof(header) + records.size() * sizeof(HiveSnapshotPage);
+    size_t count = 0;
+    for (auto& record : records) {
+        size_t num_words = bitmask_words(record.capacity);
+        size_t bits_bytes = num_words * sizeof(uint64_t);
+        if (record.capacity > header.size / slot_size_ || record.bits_offset < offset ||
+            record.bits_offset > header.size - bits_bytes ||
+            record.slots_offset < record.bits_offset + bits_bytes ||
+            record.slots_offset > header.size - record.capacity * slot_size_) {
+            return false;
+        }
+        for (size_t w = 0; w < num_words; ++w) {
+            uint64_t word;
+            std::memcpy(&word, buffer + record.bits_offset + w * sizeof(uint64_t), sizeof(word));
+            if (w == num_words - 1 && record.capacity % 64 && word >> (record.capacity % 64)) {
+                return false;
+            }
+            count += popcount64(word);
+        }
+        offset = record.slots_offset + record.capacity * slot_size_;
+    }
+    return count == header.count;
+}
+
+ReturnValue RawHiveImpl::restore(const void* buffer, size_t size)
+{
+    check_iteration_guard(mutex_, "restore");
+
+    auto* in = static_cast<const char*>(buffer);
+    HiveSnapshotHeader header;
+    std::vector<HiveSnapshotPage> records;
+    if (!read_snapshot(in, size, header, records)) {
+        return ReturnValue::InvalidArgument;
+    }
+    size_t count = header.count;
+
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    clear_pages(nullptr, nullptr);
+    if (!count) {
+        return ReturnValue::Success;
+    }
+
+    alloc_page(count);
+    auto& page = *pages_.back();
+    auto* dst = static_cast<char*>(page.slots);
+    for (auto& record : records) {
+        const char* slots = in + record.slots_offset;
+        for (size_t w = 0; w < bitmask_words(record.capacity); ++w) {
+            uint64_t word;
+            std::memcpy(&word, in + record.bits_offset + w * sizeof(uint64_t), sizeof(word));
+            size_t first = w * 64;
+            size_t word_slots = record.capacity - first < 64 ? record.capacity - first : 64;
+            HivePageView view{const_cast<char*>(slots) + first * slot_size_, slot_size_, &word, word_slots};
+            for_each_active_run(view, [&](size_t run_first, size_t run_count) {
+                size_t bytes = run_count * slot_size_;
+                std::memcpy(dst, page_view_at<char>(view, run_first), bytes);
+                dst += bytes;
+                return true;
+            });
+        }
+    }
+
+    // The page is full: every slot is live and the freelist is empty.
+    size_t num_words = bitmask_words(count);
+    std::memset(page.active_bits, 0xff, num_words * sizeof(uint64_t));
+    if (count % 64) {
+        page.active_bits[num_words - 1] = (uint64_t(1) << (count % 64)) - 1;
+    }
+    page.free_head = PAGE_SENTINEL;
+    page.live_count = count;
+    free_pages_.unlink(&page);
+    free_slots_ -= count;
+    live_count_.store(count, std::memory_order_relaxed);
+    return ReturnValue::Success;
+}
+
+ReturnValue RawHiveImpl::adopt(const IHiveSnapshotMapping::Ptr& mapping)
+{
+    check_iteration_guard(mutex_, "adopt");
+
+    auto* in = mapping ? static_cast<char*>(mapping->get_data()) : nullptr;
+    HiveSnapshotHeader header;
+    std::vector<HiveSnapshotPage> records;
+    if (!read_snapshot(in, in ? mapping->get_size() : 0, header, records)) {
+        return ReturnValue::InvalidArgument;
+    }
+    // The slots are used in place, so they must be aligned in memory and not just in the file.
+    size_t alignment = snapshot_alignment();
+    for (auto& record : records) {
+        if (reinterpret_cast<uintptr_t>(in + record.bits_offset) % alignof(uint64_t) ||
+            reinterpret_cast<uintptr_t>(in + record.slots_offset) % alignment) {
+            return ReturnValue::InvalidArgument;
+        }
+    }
+
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    clear_pages(nullptr, nullptr);
+
+    IHivePageSource::Ptr source = mapping;
+    for (auto& record : records) {
+        if (!record.capacity) {
+            continue;
+        }
+        auto page = std::make_unique<RawHivePage>();
+        page->capacity = record.capacity;
+        page->slot_size = slot_size_;
+        page->allocation = in + record.bits_offset;
+        page->allocation_size = record.slots_offset + record.capacity * slot_size_ - record.bits_offset;
+        page->page_source = source;
+        detail::track_memory(MemoryCategory::HivePages, static_cast<ptrdiff_t>(page->allocation_size), 1);
+        page->active_bits = reinterpret_cast<uint64_t*>(in + record.bits_offset);
+        page->slots = in + record.slots_offset;
+
+        // Link the free slots back to front, so that allocation fills them front to back.
+        // Fully live words are skipped without touching their slots.
+        size_t free = 0;
+        for (size_t w = bitmask_words(record.capacity); w-- > 0;) {
+            size_t word_slots = record.capacity - w * 64 < 64 ? record.capacity - w * 64 : 64;
+            uint64_t holes = ~page->active_bits[w];
+            if (word_slots < 64) {
+                holes &= (uint64_t(1) << word_slots) - 1;
+            }
+            for (size_t b = 64; holes && b-- > 0;) {
+                if (holes & (uint64_t(1) << b)) {
+                    holes &= ~(uint64_t(1) << b);
+                    push_free_slot(page->slots, w * 64 + b, slot_size_, page->free_head);
+                    ++free;
+                }
+            }
+        }
+        page->live_count = record.capacity - free;
+        free_slots_ += free;
+        if (free) {
+            free_pages_.push(page.get());
+        }
+        insert_sorted_page(sorted_pages_, page.get());
+        pages_.push_back(std::move(page));
+    }
+    current_page_ = free_pages_.head;
+    live_count_.store(header.count, std::memory_order_relaxed);
+    return ReturnValue::Success;
+}
+
 } // namespace velk
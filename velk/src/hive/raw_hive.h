@@ -6,8 +6,10 @@
 #include <velk/ext/core_object.h>
 #include <velk/interface/hive/intf_hive.h>
 
+#include <atomic>
 #include <cstddef>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <vector>
 
@@ -23,12 +25,19 @@ namespace velk {
 struct RawHivePage
 {
     void* allocation{nullptr};
+    size_t allocation_size{0};
+    size_t allocation_alignment{0};
+    IHivePageSource::Ptr page_source; ///< Source that owns allocation (null for heap memory).
+    int numa_node{-1};                ///< NUMA node of allocation (-1 if unknown or several).
     uint64_t* active_bits{nullptr};
     void* slots{nullptr};
     size_t capacity{0};
     size_t free_head{PAGE_SENTINEL};
     size_t live_count{0};
     size_t slot_size{0};
+    RawHivePage* prev_free{nullptr}; ///< Previous page in the hive's free-page list.
+    RawHivePage* next_free{nullptr}; ///< Next page in the hive's free-page list.
+    bool in_free_list{false};        ///< True if linked into the hive's free-page list.
 };
 
 /**
@@ -58,27 +67,116 @@ public:
     void clear() override;
 
     HivePageCapacity get_page_capacity() const override;
+    HiveStats get_stats() const override;
     void set_page_capacity(const HivePageCapacity& capacity) override;
+    size_t get_slot_alignment() const override;
+    ReturnValue set_slot_alignment(size_t alignment) override;
+    IHivePageSource::Ptr get_page_source() const override;
+    void set_page_source(const IHivePageSource::Ptr& source) override;
+    size_t trim(size_t keep_free_slots) override;
+    ReturnValue reserve(size_t free_slots) override;
+    void for_each_page(void* context, PageVisitorFn visitor, IExecutor* executor) const override;
 
     // IRawHive overrides
     void* allocate() override;
+    size_t allocate_n(size_t count, void** out) override;
     void deallocate(void* ptr) override;
     bool contains(const void* ptr) const override;
     void for_each(void* context, RawVisitorFn visitor) const override;
+    void for_each_parallel(void* context, RawVisitorFn visitor, IExecutor* executor) const override;
+    void set_magazine_size(size_t slots) override;
+    size_t get_magazine_size() const override;
+    void flush_magazines() override;
+    size_t compact(void* context, RelocateFn relocate) override;
+    size_t sort(void* context, LessFn less, RelocateFn relocate) override;
     void clear(void* context, DestroyFn destroy) override;
+    void clear_parallel(void* context, DestroyFn destroy, IExecutor* executor,
+                        HivePageRelease release) override;
+    size_t snapshot(void* buffer, size_t size) const override;
+    ReturnValue restore(const void* buffer, size_t size) override;
+    ReturnValue adopt(const IHiveSnapshotMapping::Ptr& mapping) override;
 
 private:
+    /** @brief A free slot reserved in a magazine. */
+    struct MagazineSlot
+    {
+        RawHivePage* page;
+        size_t index;
+    };
+
+    /** @brief Cache of reserved free slots shared by the threads mapped to it. */
+    struct alignas(64) Magazine
+    {
+        std::mutex mutex;
+        size_t count{0};
+        std::vector<MagazineSlot> slots;
+    };
+
+    /** @brief Pops a free slot from the page freelists, allocating a page if needed. Exclusive lock. */
+    size_t take_free_slot(RawHivePage*& page);
+    /** @brief Pushes a slot back onto its page freelist. Exclusive lock. */
+    void return_free_slot(RawHivePage& page, size_t slot_idx);
+    /** @brief Serves an allocation from the calling thread's magazine. Returns nullptr if empty. */
+    void* magazine_allocate();
+    /** @brief Caches a deallocated slot in the calling thread's magazine. Returns false if full. */
+    bool magazine_deallocate(void* ptr);
+    /** @brief Returns all cached slots of @p magazine above @p keep to the freelists. Exclusive lock. */
+    void drain_magazine(Magazine& magazine, size_t keep);
+    /** @brief Returns the cached slots of every magazine to the freelists. Exclusive lock. */
+    void drain_magazines();
+
+    /** @brief Frees an empty page and unlinks it. Call erase_released_pages() afterwards. */
+    void release_page(RawHivePage& page);
+    /** @brief Removes pages freed by release_page() or compact() from the page tables. */
+    void erase_released_pages();
+
+    /**
+     * @brief Discards all pages, calling @p destroy for each live element if set. Exclusive lock.
+     * @param executor Executor running the destroy calls, or nullptr for the calling thread.
+     * @param deferred If set, receives the page memory instead of freeing it.
+     */
+    void clear_pages(void* context, DestroyFn destroy, IExecutor* executor = nullptr,
+                     std::vector<PageMemory>* deferred = nullptr);
+    /** @brief Fills @p records (if not null) with the snapshot page layout and returns the snapshot size. */
+    size_t snapshot_layout(HiveSnapshotPage* records) const;
+    /** @brief Alignment of the slots of each page in a snapshot. */
+    size_t snapshot_alignment() const;
+    /**
+     * @brief Reads the header and page records of a snapshot of this hive.
+     * @return false if @p buffer is not a valid snapshot of a hive with this element UID and size.
+     */
+    bool read_snapshot(const char* buffer, size_t size, HiveSnapshotHeader& header,
+                       std::vector<HiveSnapshotPage>& records) const;
+
     void* slot_ptr(const RawHivePage& page, size_t index) const;
     void alloc_page(size_t capacity);
+    /** @brief Allocates one page if the hive has fewer than @p free_slots free slots. Exclusive lock. */
+    bool reserve_slots(size_t free_slots);
+
+    /** @brief Visits the active slots in bitmask words [word_begin, word_end) of one page. */
+    bool scan_words(const RawHivePage& page, size_t word_begin, size_t word_end, void* context,
+                    RawVisitorFn visitor) const;
+
+    /** @brief Finds the page and slot index for a given pointer. Returns nullptr if not found. */
+    RawHivePage* find_page(const void* ptr, size_t& slot_idx) const;
 
     mutable std::shared_mutex mutex_;
     Uid element_uid_;
+    size_t element_size_{0}; ///< Natural slot size, before set_slot_alignment() padding.
+    size_t element_align_{0};
     size_t slot_size_{0};
     size_t slot_align_{0};
-    size_t live_count_{0};
+    std::atomic<size_t> live_count_{0};
+    std::atomic<size_t> magazine_size_{0};  ///< Slots cached per magazine (0 = caching disabled).
+    std::unique_ptr<Magazine[]> magazines_; ///< MAGAZINE_COUNT magazines, or null when disabled.
+    size_t free_slots_{0};                  ///< Free slots over all pages (magazine slots count as used).
     RawHivePage* current_page_{nullptr};
+    FreePageList<RawHivePage> free_pages_; ///< Pages with at least one free slot.
     std::vector<std::unique_ptr<RawHivePage>> pages_;
+    std::vector<RawHivePage*> sorted_pages_; ///< Pages sorted by slot address for pointer lookup.
     HivePageCapacity capacity_;
+    PageGrowth growth_; ///< Drives HivePageGrowth::Adaptive.
+    IHivePageSource::Ptr page_source_;
 };
 
 } // namespace velk
@@ -0,0 +1,109 @@
+#include "virtual_memory_page_source.h"
+
+#include "page_allocator.h"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace velk {
+
+namespace {
+
+#ifndef _WIN32
+/** @brief Size of a transparent huge page on the common x86-64 and AArch64 configurations. */
+constexpr size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+size_t os_page_size()
+{
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+/** @brief Returns the granularity that a block of @p size bytes is mapped with. */
+size_t mapping_granularity(size_t size)
+{
+    return size >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : os_page_size();
+}
+#endif
+
+} // namespace
+
+void* map_page_memory(size_t size, size_t alignment)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    if (alignment > info.dwAllocationGranularity) {
+        return nullptr;
+    }
+    // Large pages need SeLockMemoryPrivilege; without it VirtualAlloc fails and we use regular pages.
+    size_t large = GetLargePageMinimum();
+    if (large && size >= large) {
+        DWORD type = MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES;
+        void* mem = VirtualAlloc(nullptr, align_up(size, large), type, PAGE_READWRITE);
+        if (mem) {
+            return mem;
+        }
+    }
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    size_t granularity = mapping_granularity(size);
+    size_t length = align_up(size, granularity);
+    // Huge pages are only used for huge-page-aligned ranges, so over-map and trim to the alignment.
+    size_t align = alignment > granularity ? alignment : granularity;
+    size_t mapped = length + align - os_page_size();
+    void* mem = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        return nullptr;
+    }
+    auto base = reinterpret_cast<uintptr_t>(mem);
+    auto start = (base + align - 1) & ~(uintptr_t(align) - 1);
+    if (start > base) {
+        munmap(mem, start - base);
+    }
+    size_t tail = (base + mapped) - (start + length);
+    if (tail) {
+        munmap(reinterpret_cast<void*>(start + length), tail);
+    }
+#ifdef MADV_HUGEPAGE
+    if (granularity == HUGE_PAGE_SIZE) {
+        madvise(reinterpret_cast<void*>(start), length, MADV_HUGEPAGE);
+    }
+#endif
+    return reinterpret_cast<void*>(start);
+#endif
+}
+
+void unmap_page_memory(void* page, size_t size)
+{
+    if (!page) {
+        return;
+    }
+#ifdef _WIN32
+    (void)size;
+    VirtualFree(page, 0, MEM_RELEASE);
+#else
+    munmap(page, align_up(size, mapping_granularity(size)));
+#endif
+}
+
+void* VirtualMemoryPageSource::allocate_page(size_t size, size_t alignment)
+{
+    return map_page_memory(size, alignment);
+}
+
+void VirtualMemoryPageSource::free_page(void* page, size_t size)
+{
+    unmap_page_memory(page, size);
+}
+
+} // namespace velk
@@ -0,0 +1,40 @@
+#ifndef VELK_SRC_VIRTUAL_MEMORY_PAGE_SOURCE_H
+#define VELK_SRC_VIRTUAL_MEMORY_PAGE_SOURCE_H
+
+#include <velk/ext/core_object.h>
+#include <velk/interface/hive/intf_hive_page_source.h>
+
+namespace velk {
+
+/**
+ * @brief Maps a block of at least @p size bytes aligned to @p alignment directly from the OS.
+ *
+ * Blocks of at least one huge page use huge/large pages where available.
+ * @return The block, or nullptr on failure.
+ */
+void* map_page_memory(size_t size, size_t alignment);
+
+/** @brief Unmaps a block returned by map_page_memory() with the same @p size. */
+void unmap_page_memory(void* page, size_t size);
+
+/**
+ * @brief IHivePageSource that maps every hive page directly from the OS.
+ *
+ * Blocks of at least one huge page are mapped with transparent huge pages
+ * (madvise(MADV_HUGEPAGE)) on Linux, or with large pages on Windows when the
+ * process holds the lock-pages privilege. Smaller blocks are rounded up to
+ * whole OS pages, so the source suits hives with large pages.
+ */
+class VirtualMemoryPageSource final : public ext::ObjectCore<VirtualMemoryPageSource, IHivePageSource>
+{
+public:
+    VELK_CLASS_UID(ClassId::VirtualMemoryPageSource);
+
+    // IHivePageSource overrides
+    void* allocate_page(size_t size, size_t alignment) override;
+    void free_page(void* page, size_t size) override;
+};
+
+} // namespace velk
+
+#endif // VELK_SRC_VIRTUAL_MEMORY_PAGE_SOURCE_H
@@ -0,0 +1,178 @@
+#include "inherited_properties.h"
+
+#include "hierarchy.h"
+
+#include <velk/api/velk.h>
+#include <velk/interface/intf_metadata.h>
+
+namespace velk {
+
+namespace {
+
+IProperty::Ptr find_property(const IObject::Ptr& object, string_view name, Resolve mode = Resolve::Create)
+{
+    return object ? get_property(interface_cast<IMetadata>(object), name, mode) : nullptr;
+}
+
+} // namespace
+
+std::shared_ptr<const InheritedProperties::Rules> InheritedProperties::snapshot() const
+{
+    if (empty()) {
+        return {};
+    }
+    std::lock_guard lock(mutex_);
+    return rules_;
+}
+
+void InheritedProperties::bind(const Rule& rule, const IObject::Ptr& parent, const IObject::Ptr& object)
+{
+    auto target = find_property(object, rule.target);
+    auto source = find_property(object, rule.source);
+    if (!target || !source) {
+        return;
+    }
+    auto& registry = instance().binding_registry();
+    if (auto inherited = find_property(parent, rule.target)) {
+        IProperty::ConstPtr sources[] = {inherited, source};
+        registry.bind(target, {sources, 2}, rule.combine);
+    } else {
+        IProperty::ConstPtr sources[] = {source};
+        registry.bind(target, {sources, 1});
+    }
+}
+
+void InheritedProperties::unbind(const Rule& rule, const IObject::Ptr& object)
+{
+    if (auto target = find_property(object, rule.target, Resolve::Existing)) {
+        instance().binding_registry().unbind(target);
+    }
+}
+
+// Tracks the ancestors of the current object by depth, as traverse() lists parents first.
+template <class Fn>
+void InheritedProperties::for_each_object(const IHierarchy& hierarchy, Fn&& fn)
+{
+    struct Context
+    {
+        Fn& fn;
+        std::vector<IObject::Ptr> ancestors;
+    } context{fn, {}};
+    hierarchy.traverse(hierarchy.root(), TraversalOrder::PreOrder, &context,
+                       [](void* ctx, const IObject::Ptr& object, size_t depth) -> bool {
+                           auto& c = *static_cast<Context*>(ctx);
+                           c.ancestors.resize(depth);
+                           c.fn(depth ? c.ancestors.back() : IObject::Ptr{}, object);
+                           c.ancestors.push_back(object);
+                           return true;
+                       });
+}
+
+ReturnValue InheritedProperties::add(const IHierarchy& hierarchy, string_view source, string_view target,
+                                     const IFunction::ConstPtr& combine)
+{
+    if (source.empty() || target.empty() || source == target || !combine) {
+        return ReturnValue::InvalidArgument;
+    }
+    Rule rule{string(source), string(target), combine};
+    {
+        std::lock_guard lock(mutex_);
+        auto rules = std::make_shared<Rules>();
+        if (rules_) {
+            for (auto& existing : *rules_) {
+                if (existing.target != target) {
+                    rules->push_back(existing);
+                }
+            }
+        }
+        rules->push_back(rule);
+        rules_ = std::move(rules);
+        any_.store(true, std::memory_order_release);
+    }
+    for_each_object(hierarchy, [&](const IObject::Ptr& parent, const IObject::Ptr& object) {
+        bind(rule, parent, object);
+    });
+    return ReturnValue::Success;
+}
+
+ReturnValue InheritedProperties::remove(const IHierarchy& hierarchy, string_view target)
+{
+    Rule removed;
+    {
+        std::lock_guard lock(mutex_);
+        if (!rules_) {
+            return ReturnValue::NothingToDo;
+        }
+        auto rules = std::make_shared<Rules>();
+        for (auto& existing : *rules_) {
+            if (existing.target == target) {
+                removed = existing;
+            } else {
+                rules->push_back(existing);
+            }
+        }
+        if (!removed.combine) {
+            return ReturnValue::NothingToDo;
+        }
+        any_.store(!rules->empty(), std::memory_order_release);
+        rules_ = std::move(rules);
+    }
+    for_each_object(hierarchy,
+                    [&](const IObject::Ptr&, const IObject::Ptr& object) { unbind(removed, object); });
+    return ReturnValue::Success;
+}
+
+void InheritedProperties::joined(const IObject::Ptr& parent, const IObject::Ptr& object) const
+{
+    if (auto rules = snapshot()) {
+        for (auto& rule : *rules) {
+            bind(rule, parent, object);
+        }
+    }
+}
+
+void InheritedProperties::joined(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                                 array_view<uint32_t> parents) const
+{
+    if (auto rules = snapshot()) {
+        // A batch lists parents before their children, so each binds to an already bound parent.
+        for (size_t k = 0; k < objects.size(); ++k) {
+            for (auto& rule : *rules) {
+                bind(rule, batch_parent(parent, objects, parents, k), objects[k]);
+            }
+        }
+    }
+}
+
+void InheritedProperties::rebind_children(const IHierarchy& hierarchy, const IObject::Ptr& object) const
+{
+    if (auto rules = snapshot()) {
+        for (auto& child : hierarchy.children_of(object)) {
+            for (auto& rule : *rules) {
+                bind(rule, object, child);
+            }
+        }
+    }
+}
+
+void InheritedProperties::left(const IObject::Ptr& object) const
+{
+    if (auto rules = snapshot()) {
+        for (auto& rule : *rules) {
+            unbind(rule, object);
+        }
+    }
+}
+
+void InheritedProperties::left(const std::vector<IObject::Ptr>& removed) const
+{
+    if (auto rules = snapshot()) {
+        for (auto& object : removed) {
+            for (auto& rule : *rules) {
+                unbind(rule, object);
+            }
+        }
+    }
+}
+
+} // namespace velk
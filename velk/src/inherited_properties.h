@@ -0,0 +1,75 @@
+#ifndef INHERITED_PROPERTIES_H
+#define INHERITED_PROPERTIES_H
+
+#include <velk/array_view.h>
+#include <velk/interface/intf_hierarchy.h>
+#include <velk/string.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief The inherited properties of a hierarchy, kept up to date with property bindings.
+ *
+ * The target property of each object is bound to combine(parent's target, object's source),
+ * or just to its source for the root and for objects whose parent lacks the target. The binding
+ * registry then re-evaluates only the bindings whose sources changed, parents before children,
+ * once per update(), and stops at descendants whose value came out unchanged.
+ *
+ * The owning hierarchy calls joined() and left() after each mutation, outside its lock.
+ */
+class InheritedProperties
+{
+public:
+    /** @brief Implements IHierarchy::add_inherited() for the objects of @p hierarchy. */
+    ReturnValue add(const IHierarchy& hierarchy, string_view source, string_view target,
+                    const IFunction::ConstPtr& combine);
+    /** @brief Implements IHierarchy::remove_inherited() for the objects of @p hierarchy. */
+    ReturnValue remove(const IHierarchy& hierarchy, string_view target);
+
+    /** @brief Returns true if no property is inherited. */
+    bool empty() const { return !any_.load(std::memory_order_acquire); }
+
+    /** @brief Binds the inherited properties of @p object, a child of @p parent or the root if null. */
+    void joined(const IObject::Ptr& parent, const IObject::Ptr& object) const;
+    /** @brief Binds the inherited properties of a batch added under @p parent, see add_subtree(). */
+    void joined(const IObject::Ptr& parent, array_view<IObject::Ptr> objects,
+                array_view<uint32_t> parents) const;
+    /** @brief Rebinds the children of @p object in @p hierarchy to it, e.g. after a replace(). */
+    void rebind_children(const IHierarchy& hierarchy, const IObject::Ptr& object) const;
+    /** @brief Unbinds the inherited properties of an object that left the hierarchy. */
+    void left(const IObject::Ptr& object) const;
+    /** @brief Unbinds the inherited properties of each object that left the hierarchy. */
+    void left(const std::vector<IObject::Ptr>& removed) const;
+
+private:
+    struct Rule
+    {
+        string source;
+        string target;
+        IFunction::ConstPtr combine;
+    };
+    using Rules = std::vector<Rule>;
+
+    // Returns the current rules, shared so that mutations need not copy them.
+    std::shared_ptr<const Rules> snapshot() const;
+    // Binds the target of rule on object to its parent's target and its source.
+    static void bind(const Rule& rule, const IObject::Ptr& parent, const IObject::Ptr& object);
+    // Unbinds the target of rule on object.
+    static void unbind(const Rule& rule, const IObject::Ptr& object);
+    // Calls fn(parent, object) for every object of hierarchy, parents first.
+    template <class Fn>
+    static void for_each_object(const IHierarchy& hierarchy, Fn&& fn);
+
+    mutable std::mutex mutex_;           // Guards rules_.
+    std::shared_ptr<const Rules> rules_; // Replaced, never modified, when a rule changes.
+    std::atomic<bool> any_{false};       // True if rules_ is not empty.
+};
+
+} // namespace velk
+
+#endif // INHERITED_PROPERTIES_H
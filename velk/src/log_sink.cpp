@@ -0,0 +1,142 @@
+#include "log_sink.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace velk {
+
+void write_stderr_log(LogLevel level, const char* file, int line, const char* message)
+{
+    // Written regardless of level; the instance filters before.
+    static const char* level_names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+    auto idx = static_cast<int>(level);
+    if (idx < 0 || idx > 3) {
+        idx = 3;
+    }
+    fprintf(stderr, "[%s] %s:%d: %s\n", level_names[idx], file, line, message);
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+    if (!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void AsyncLogSink::start(const ILogSink::Ptr& target, size_t capacity)
+{
+    size_t size = 1;
+    while (size < (capacity ? capacity : DEFAULT_CAPACITY)) {
+        size *= 2;
+    }
+    target_ = target;
+    records_ = std::make_unique<Record[]>(size);
+    for (size_t i = 0; i < size; ++i) {
+        records_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    mask_ = size - 1;
+    thread_ = std::thread([this] { run(); });
+}
+
+void AsyncLogSink::write(LogLevel level, const char* file, int line, const char* message)
+{
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Record* record;
+    for (;;) {
+        record = &records_[pos & mask_];
+        auto diff = static_cast<std::ptrdiff_t>(record->seq.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The slot a full lap back is not delivered yet.
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    size_t fileLength = file ? std::strlen(file) : 0;
+    const char* fileStart = file + (fileLength > MAX_FILE ? fileLength - MAX_FILE : 0);
+    fileLength = std::min(fileLength, MAX_FILE);
+    std::memcpy(record->text, fileStart, fileLength);
+    record->text[fileLength] = '\0';
+    char* text = record->text + fileLength + 1;
+    size_t length = message ? strnlen(message, TEXT_SIZE - fileLength - 2) : 0;
+    std::memcpy(text, message, length);
+    text[length] = '\0';
+    record->level = level;
+    record->line = line;
+    record->file = static_cast<uint32_t>(fileLength);
+
+    // Sequentially consistent with the store of sleeping_ in run(): either the thread sees the
+    // record, or this sees the thread asleep and wakes it.
+    record->seq.store(pos + 1);
+    if (sleeping_.load()) {
+        { std::lock_guard lock(mutex_); }
+        wake_.notify_one();
+    }
+}
+
+void AsyncLogSink::flush()
+{
+    size_t target = tail_.load();
+    std::unique_lock lock(mutex_);
+    delivered_cv_.wait(lock, [&] { return delivered_.load() >= target; });
+}
+
+bool AsyncLogSink::ready() const
+{
+    return records_[head_ & mask_].seq.load() == head_ + 1;
+}
+
+bool AsyncLogSink::drain()
+{
+    bool any = false;
+    while (ready()) {
+        auto& record = records_[head_ & mask_];
+        const char* file = record.text;
+        const char* message = record.text + record.file + 1;
+        if (target_) {
+            target_->write(record.level, file, record.line, message);
+        } else {
+            write_stderr_log(record.level, file, record.line, message);
+        }
+        // Frees the slot for the position a lap ahead.
+        record.seq.store(head_ + mask_ + 1, std::memory_order_release);
+        delivered_.store(++head_);
+        any = true;
+    }
+    return any;
+}
+
+void AsyncLogSink::run()
+{
+    for (;;) {
+        if (drain()) {
+            { std::lock_guard lock(mutex_); }
+            delivered_cv_.notify_all();
+            continue;
+        }
+        std::unique_lock lock(mutex_);
+        sleeping_.store(true);
+        while (!stopping_ && !ready()) {
+            wake_.wait(lock);
+        }
+        sleeping_.store(false);
+        if (stopping_ && !ready()) {
+            return;
+        }
+    }
+}
+
+} // namespace velk
@@ -0,0 +1,79 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <velk/ext/core_object.h>
+#include <velk/interface/intf_log.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace velk {
+
+/** @brief Writes a log message to stderr, the output of an instance without a sink. */
+void write_stderr_log(LogLevel level, const char* file, int line, const char* message);
+
+/**
+ * @brief IAsyncLogSink implementation with a bounded MPSC ring buffer and one delivery thread.
+ *
+ * Writers claim a slot by advancing tail_ and publish it through the sequence number of the slot,
+ * as in a Vyukov bounded queue; the thread delivers slots from head_ on. The thread sleeps on a
+ * condition variable, which writers only signal when it is asleep.
+ */
+class AsyncLogSink final : public ext::ObjectCore<AsyncLogSink, IAsyncLogSink>
+{
+public:
+    AsyncLogSink() = default;
+    ~AsyncLogSink() override;
+
+    /** @brief Allocates @p capacity slots (0 for the default) and starts delivering to @p target. */
+    void start(const ILogSink::Ptr& target, size_t capacity);
+
+public: // ILogSink
+    void write(LogLevel level, const char* file, int line, const char* message) override;
+
+public: // IAsyncLogSink
+    void flush() override;
+    size_t get_dropped_count() const override { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t DEFAULT_CAPACITY = 256;
+    static constexpr size_t TEXT_SIZE = 512;
+    static constexpr size_t MAX_FILE = 128; // Longer file names keep their last characters.
+
+    struct alignas(64) Record
+    {
+        std::atomic<size_t> seq; // Position + 1 once written, position + capacity once delivered.
+        LogLevel level;
+        int line;
+        uint32_t file;        // Length of the file name at the start of text.
+        char text[TEXT_SIZE]; // File name and message, each null-terminated.
+    };
+
+    // Returns true if the record at head_ is written.
+    bool ready() const;
+    // Delivers the written records; returns false if there were none.
+    bool drain();
+    // Delivers records until the sink is destroyed and none is left.
+    void run();
+
+    ILogSink::Ptr target_;                    // Empty for stderr.
+    std::unique_ptr<Record[]> records_;
+    size_t mask_ = 0;                         // Capacity - 1.
+    alignas(64) std::atomic<size_t> tail_{0}; // Next position to claim.
+    std::atomic<size_t> dropped_{0};
+    alignas(64) size_t head_ = 0;             // Next position to deliver, owned by thread_.
+    std::atomic<size_t> delivered_{0};        // head_ as seen by flush().
+    std::atomic<bool> sleeping_{false};       // Set while thread_ waits on wake_.
+    std::mutex mutex_;                        // Guards stopping_ and the waits.
+    std::condition_variable wake_;            // Signalled when a record is written or on stop.
+    std::condition_variable delivered_cv_;    // Signalled when records were delivered.
+    bool stopping_ = false;                   // Set by the destructor.
+    std::thread thread_;                      // Runs run().
+};
+
+} // namespace velk
+
+#endif // LOG_SINK_H
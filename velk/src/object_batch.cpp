@@ -0,0 +1,121 @@
+#include <velk/ext/core_object.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace velk {
+
+namespace {
+
+struct ObjectBatch;
+
+/**
+ * @brief Control block of an object in an ObjectBatch.
+ *
+ * Embedded in the batch allocation, like HiveControlBlock in a hive page. The slot of the object
+ * is at the same index as the block.
+ */
+struct BatchControlBlock
+{
+    external_control_block ecb;
+    ObjectBatch* batch;
+};
+
+/**
+ * @brief Header of one allocation holding the control blocks and the objects of a batch.
+ *
+ * Layout: the header, @c count BatchControlBlocks, then @c count slots of @c slot_size bytes at
+ * @c slots. The allocation is freed when every object is destroyed and no weak_ptr refers to
+ * its block any more.
+ */
+struct ObjectBatch
+{
+    std::atomic<size_t> refs;        ///< Blocks whose object is alive or which weak_ptrs still refer to.
+    const IObjectFactory* factory;   ///< Factory the objects were constructed by.
+    size_t slot_size;                ///< Instance size rounded up to the alignment.
+    size_t alignment;                ///< Alignment of the allocation.
+    char* slots;                     ///< First slot, inside the allocation.
+
+    BatchControlBlock* blocks() { return reinterpret_cast<BatchControlBlock*>(this + 1); }
+};
+
+/** @brief Releases one block of @p batch, freeing the allocation with the last one. */
+void release_batch_block(ObjectBatch* batch)
+{
+    if (batch->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        size_t alignment = batch->alignment;
+        batch->~ObjectBatch();
+        detail::velk_free(batch, alignment, MemoryTag::Objects);
+    }
+}
+
+/** @brief Weak dealloc notification for the block of a destroyed object. */
+void batch_weak_release(external_control_block* ecb)
+{
+    release_batch_block(reinterpret_cast<BatchControlBlock*>(ecb)->batch);
+}
+
+/** @brief Called from unref() when the last strong reference to an object of a batch drops. */
+void batch_destroy(external_control_block* ecb)
+{
+    auto* bcb = reinterpret_cast<BatchControlBlock*>(ecb);
+    ObjectBatch* batch = bcb->batch;
+    auto index = static_cast<size_t>(bcb - batch->blocks());
+
+    // Keeps the block alive through ~RefCountedDispatch, which releases a weak ref, as in a hive.
+    ecb->add_weak();
+    batch->factory->destroy_in_place(batch->slots + index * batch->slot_size);
+
+    // From here on the last weak_ptr to drop, on whichever thread, releases the block.
+    ecb->destroy = batch_weak_release;
+    if (ecb->release_weak()) {
+        release_batch_block(batch);
+    }
+}
+
+} // namespace
+
+VELK_EXPORT size_t detail::create_object_batch(const IObjectFactory& factory, size_t count, uint32_t flags,
+                                               IObject::Ptr* out)
+{
+    if (!count) {
+        return 0;
+    }
+    if (flags & ObjectFlags::ThreadConfined) {
+        // Confining needs the concrete class, which only create_instance() knows.
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = factory.create_instance(flags);
+        }
+        return count;
+    }
+
+    size_t alignment = std::max({factory.get_instance_alignment(), alignof(ObjectBatch),
+                                 alignof(BatchControlBlock)});
+    size_t slot_size = (factory.get_instance_size() + alignment - 1) & ~(alignment - 1);
+    size_t header = sizeof(ObjectBatch) + count * sizeof(BatchControlBlock);
+    size_t offset = (header + alignment - 1) & ~(alignment - 1);
+    void* memory = velk_alloc(offset + count * slot_size, alignment, MemoryTag::Objects);
+    if (!memory) {
+        return 0;
+    }
+
+    auto* batch = new (memory) ObjectBatch{{count}, &factory, slot_size, alignment,
+                                           static_cast<char*>(memory) + offset};
+    auto* blocks = batch->blocks();
+    for (size_t i = 0; i < count; ++i) {
+        auto* bcb = new (&blocks[i]) BatchControlBlock{};
+        bcb->ecb.strong.store(1, std::memory_order_relaxed);
+        bcb->ecb.weak.store(1, std::memory_order_relaxed);
+        bcb->ecb.destroy = batch_destroy;
+        bcb->batch = batch;
+
+        auto* obj = factory.construct_in_place(batch->slots + i * slot_size, &bcb->ecb, flags);
+        bcb->ecb.set_ptr(static_cast<void*>(obj));
+        bcb->ecb.set_external_tag();
+        bcb->ecb.set_embedded_tag();
+        out[i] = IObject::Ptr(obj, &bcb->ecb, adopt_ref);
+    }
+    return count;
+}
+
+} // namespace velk
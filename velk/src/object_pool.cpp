@@ -0,0 +1,60 @@
+#include "object_pool.h"
+
+#include "hive/object_hive.h"
+
+#include <velk/ext/core_object.h>
+
+#include <algorithm>
+
+namespace velk {
+
+ObjectPool::ObjectPool(array_view<Uid> classes)
+{
+    for (auto& uid : classes) {
+        entries_.push_back({uid, {}});
+    }
+    std::sort(entries_.begin(), entries_.end());
+}
+
+const ObjectPool::Entry* ObjectPool::find(Uid classUid) const
+{
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), Entry{classUid, {}});
+    return it != entries_.end() && it->classUid == classUid ? &*it : nullptr;
+}
+
+bool ObjectPool::contains(Uid classUid) const
+{
+    return find(classUid) != nullptr;
+}
+
+size_t ObjectPool::acquire(Uid classUid, size_t count, IObject::Ptr* out)
+{
+    auto* entry = find(classUid);
+    if (!entry) {
+        return 0;
+    }
+    // The hives look up their factories, so they cannot be created with the instance.
+    std::call_once(init_, [this] {
+        for (auto& e : entries_) {
+            e.hive = ext::make_object<ObjectHive>();
+            auto* hive = static_cast<ObjectHive*>(e.hive.get());
+            hive->init(e.classUid);
+            // Released instances are cached per thread, so a create and release cycle does not
+            // take the hive lock.
+            hive->set_magazine_size(32);
+        }
+        ready_.store(true, std::memory_order_release);
+    });
+    return static_cast<ObjectHive*>(entry->hive.get())->add_detached_n(count, out);
+}
+
+MemoryCounter ObjectPool::get_memory(Uid classUid) const
+{
+    auto* entry = find(classUid);
+    if (!entry || !ready_.load(std::memory_order_acquire)) {
+        return {};
+    }
+    return static_cast<const ObjectHive*>(entry->hive.get())->get_instance_memory();
+}
+
+} // namespace velk
@@ -0,0 +1,67 @@
+#ifndef VELK_SRC_OBJECT_POOL_H
+#define VELK_SRC_OBJECT_POOL_H
+
+#include <velk/allocator.h>
+#include <velk/array_view.h>
+#include <velk/interface/intf_object.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief Hives that hand out instances of a fixed set of classes in contiguous pages.
+ *
+ * Holds one ObjectHive per pooled class, created on first use. Replaces one heap allocation
+ * and control block per instance with a slot of a page whose control blocks are embedded,
+ * and reuses the slots of released instances. The hives do not keep the instances alive: an
+ * instance belongs to whoever holds a reference, and its slot is reclaimed when the last
+ * reference drops. Instances outliving the pool keep their page alive.
+ *
+ * VelkInstance pools the metadata member implementations (PropertyImpl, ArrayPropertyImpl,
+ * EventImpl, FunctionImpl) and the AnyValue<T> of the built-in scalar types.
+ *
+ * Thread-safe. Owned as a stack member by VelkInstance.
+ */
+class ObjectPool
+{
+public:
+    /** @brief Constructs a pool for the registered classes @p classes. */
+    explicit ObjectPool(array_view<Uid> classes);
+
+    /** @brief Returns true if instances of @p classUid are pooled. */
+    bool contains(Uid classUid) const;
+
+    /**
+     * @brief Creates @p count instances of @p classUid.
+     * @param out Receives the instances, must hold @p count elements.
+     * @return The number of instances created, 0 if @p classUid is not pooled.
+     */
+    size_t acquire(Uid classUid, size_t count, IObject::Ptr* out);
+
+    /** @brief Returns the number and slot bytes of the live pooled instances of @p classUid. */
+    MemoryCounter get_memory(Uid classUid) const;
+
+private:
+    /** @brief A pooled class and its hive. */
+    struct Entry
+    {
+        Uid classUid;
+        IObject::Ptr hive; ///< ObjectHive, null until the first acquire().
+
+        bool operator<(const Entry& o) const { return classUid < o.classUid; }
+    };
+
+    /** @brief Returns the entry of @p classUid, or null. */
+    const Entry* find(Uid classUid) const;
+
+    std::once_flag init_;
+    std::atomic<bool> ready_{false}; ///< Set once the hives are created.
+    std::vector<Entry> entries_; ///< Sorted by class UID.
+};
+
+} // namespace velk
+
+#endif // VELK_SRC_OBJECT_POOL_H
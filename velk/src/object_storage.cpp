@@ -3,6 +3,7 @@
 #include "array_property.h"
 #include "event.h"
 #include "function.h"
+#include "object_pool.h"
 #include "property.h"
 
 #include <velk/api/velk.h>
@@ -11,31 +12,80 @@
 #include <velk/interface/types.h>
 
 #include <algorithm>
-#include <limits>
 
 namespace velk {
 
-static constexpr size_t AttachmentSentinel = std::numeric_limits<size_t>::max();
+namespace {
 
-ObjectStorage::ObjectStorage(array_view<MemberDesc> members, IInterface* owner)
+/** @brief Returns @p pooled with the member @p flags added, or a new T if there is none. */
+template <class T>
+IObject::Ptr take_or_make(IObject::Ptr pooled, uint32_t flags)
+{
+    if (!pooled) {
+        return ext::make_object<T>(flags);
+    }
+    auto* impl = static_cast<T*>(pooled.get());
+    detail::BlockAccess::set_flags(*impl, impl->get_object_flags() | flags);
+    return pooled;
+}
+
+/** @brief Returns the class UID of the implementation of members of @p kind. */
+Uid member_class(MemberKind kind)
+{
+    switch (kind) {
+    case MemberKind::Property:
+        return PropertyImpl::class_id();
+    case MemberKind::Event:
+        return EventImpl::class_id();
+    case MemberKind::Function:
+        return FunctionImpl::class_id();
+    case MemberKind::ArrayProperty:
+        return ArrayPropertyImpl::class_id();
+    }
+    return {};
+}
+
+} // namespace
+
+ObjectStorage::ObjectStorage(array_view<MemberDesc> members, const MemberTable* table, IInterface* owner,
+                             ObjectPool* pool)
     : members_(members),
-      owner_(owner)
-{}
+      table_(table),
+      owner_(owner),
+      pool_(pool),
+      instances_(std::make_unique<IInterface::Ptr[]>(members.size()))
+{
+    detail::track_memory(MemoryCategory::Metadata, static_cast<ptrdiff_t>(tracked_size()), 1);
+}
+
+ObjectStorage::~ObjectStorage()
+{
+    detail::track_memory(MemoryCategory::Metadata, -static_cast<ptrdiff_t>(tracked_size()), -1);
+}
+
+size_t ObjectStorage::tracked_size() const
+{
+    return sizeof(ObjectStorage) + members_.size() * sizeof(IInterface::Ptr);
+}
 
 array_view<MemberDesc> ObjectStorage::get_static_metadata() const
 {
     return members_;
 }
 
-IInterface::Ptr ObjectStorage::create(MemberDesc desc) const
+IInterface::Ptr ObjectStorage::create(MemberDesc desc, IObject::Ptr pooled) const
 {
     // instantiate directly to avoid factory lookups
     IInterface::Ptr created;
     switch (desc.kind) {
     case MemberKind::Property: {
+        PropertyImpl* impl;
         {
             auto* pk = desc.propertyKind();
-            created = ext::make_object<PropertyImpl>(pk ? pk->flags : ObjectFlags::None);
+            auto property = take_or_make<PropertyImpl>(std::move(pooled), pk ? pk->flags : ObjectFlags::None);
+            impl = static_cast<PropertyImpl*>(property.get());
+            impl->set_dirty_bit(dirty_bit(desc));
+            created = std::move(property);
         }
         if (auto* pi = created->get_interface<IPropertyInternal>()) {
             if (auto* pk = desc.propertyKind()) {
@@ -45,7 +95,11 @@ IInterface::Ptr ObjectStorage::create(MemberDesc desc) const
                         if (void* base = ps->get_property_state(desc.interfaceInfo->uid)) {
                             if (auto ref = pk->createRef(base)) {
                                 pi->set_any(ref);
+                                if (pk->stateData) {
+                                    impl->set_state(pk->stateData(base), ref.get(), pk->typeUid);
+                                }
                             }
+                            impl->set_stale_flags(stale_flags(desc, base));
                         }
                     }
                 }
@@ -63,7 +117,11 @@ IInterface::Ptr ObjectStorage::create(MemberDesc desc) const
     }
     case MemberKind::ArrayProperty: {
         auto* pk = desc.propertyKind();
-        created = ext::make_object<ArrayPropertyImpl>(pk ? pk->flags : ObjectFlags::None);
+        auto property =
+            take_or_make<ArrayPropertyImpl>(std::move(pooled), pk ? pk->flags : ObjectFlags::None);
+        auto* impl = static_cast<ArrayPropertyImpl*>(property.get());
+        impl->set_dirty_bit(dirty_bit(desc));
+        created = std::move(property);
         if (auto* pi = created->get_interface<IPropertyInternal>()) {
             if (pk) {
                 if (pk->createRef && owner_) {
@@ -72,6 +130,7 @@ IInterface::Ptr ObjectStorage::create(MemberDesc desc) const
                             if (auto ref = pk->createRef(base)) {
                                 pi->set_any(ref);
                             }
+                            impl->set_stale_flags(stale_flags(desc, base));
                         }
                     }
                 }
@@ -87,15 +146,40 @@ IInterface::Ptr ObjectStorage::create(MemberDesc desc) const
         break;
     }
     case MemberKind::Event:
-        created = ext::make_object<EventImpl>();
+        created = take_or_make<EventImpl>(std::move(pooled), ObjectFlags::None);
         break;
     case MemberKind::Function:
-        created = ext::make_object<FunctionImpl>();
+        created = take_or_make<FunctionImpl>(std::move(pooled), ObjectFlags::None);
         break;
     }
     return created;
 }
 
+DirtyBit ObjectStorage::dirty_bit(const MemberDesc& desc) const
+{
+    auto* object = interface_cast<IObject>(owner_);
+    if (!object || !desc.interfaceInfo || !(object->get_object_flags() & ObjectFlags::DirtyTracking)) {
+        return {};
+    }
+    auto self = object->get_self();
+    return self ? hive_dirty_bit(self.block(), desc.interfaceInfo->uid) : DirtyBit{};
+}
+
+std::vector<bool*> ObjectStorage::stale_flags(const MemberDesc& desc, void* base) const
+{
+    std::vector<bool*> flags;
+    for (auto& m : members_) {
+        auto* ck = m.computedKind();
+        if (!ck || m.interfaceInfo != desc.interfaceInfo) {
+            continue;
+        }
+        if (std::find(ck->inputs.begin(), ck->inputs.end(), desc.name) != ck->inputs.end()) {
+            flags.push_back(ck->stale(base));
+        }
+    }
+    return flags;
+}
+
 void ObjectStorage::bind(const MemberDesc& m, const IInterface::Ptr& fn) const
 {
     auto* fk = m.functionKind();
@@ -103,76 +187,152 @@ void ObjectStorage::bind(const MemberDesc& m, const IInterface::Ptr& fn) const
         if (auto* fi = interface_cast<IFunctionInternal>(fn)) {
             void* intf_ptr = owner_->get_interface(m.interfaceInfo->uid);
             if (intf_ptr) {
-                fi->bind(intf_ptr, fk->trampoline);
+                fi->bind(intf_ptr, fk->trampoline, fk->typed, fk->into);
             }
         }
     }
 }
 
-IInterface::Ptr ObjectStorage::find_or_create(string_view name, MemberKind kind, Resolve mode) const
+size_t ObjectStorage::find_member(string_view name, MemberKind kind) const
 {
-    auto matches = [&](const MemberDesc& m) { return m.kind == kind && m.name == name; };
-
-    // Check cache first (skip attachment region)
-    for (size_t i = attachment_end_; i < instances_.size(); ++i) {
-        if (matches(members_[instances_[i].first])) {
-            return instances_[i].second;
+    if (table_) {
+        auto index = table_->find(member_key(MemberId(name), kind));
+        if (index != MemberTable::Empty && members_[index].name == name) {
+            return index;
+        }
+        if (index == MemberTable::Empty) {
+            return members_.size();
         }
+        // A different name with the same hash; the table only holds the first one.
     }
-    if (mode == Resolve::Existing) {
-        return {};
+    for (size_t i = 0; i < members_.size(); ++i) {
+        auto& m = members_[i];
+        if (m.kind == kind && m.name == name) {
+            return i;
+        }
+    }
+    return members_.size();
+}
+
+size_t ObjectStorage::find_member(MemberId id, MemberKind kind) const
+{
+    if (table_) {
+        auto index = table_->find(member_key(id, kind));
+        return index != MemberTable::Empty ? index : members_.size();
     }
-    IInterface::Ptr created;
-    // Find in static metadata and create if found
     for (size_t i = 0; i < members_.size(); ++i) {
         auto& m = members_[i];
-        if (matches(m)) {
-            // Create
-            created = create(m);
-            // Bind (if function)
-            bind(m, created);
-            // Add to metadata
-            instances_.emplace_back(i, created);
+        if (m.kind == kind && MemberId(m.name) == id) {
+            return i;
         }
     }
-    return created;
+    return members_.size();
+}
+
+IInterface::Ptr ObjectStorage::get_or_create(size_t index, Resolve mode) const
+{
+    if (index == members_.size()) {
+        return {};
+    }
+    auto& cached = instances_[index];
+    if (!cached && mode != Resolve::Existing) {
+        IObject::Ptr pooled;
+        if (pool_) {
+            pool_->acquire(member_class(members_[index].kind), 1, &pooled);
+        }
+        cached = create(members_[index], std::move(pooled));
+        // Bind (if function)
+        bind(members_[index], cached);
+    }
+    return cached;
 }
 
 IProperty::Ptr ObjectStorage::get_property(string_view name, Resolve mode) const
 {
-    auto result = find_or_create(name, MemberKind::Property, mode);
+    auto result = get_or_create(find_member(name, MemberKind::Property), mode);
     if (!result) {
-        result = find_or_create(name, MemberKind::ArrayProperty, mode);
+        result = get_or_create(find_member(name, MemberKind::ArrayProperty), mode);
     }
     return interface_pointer_cast<IProperty>(result);
 }
 
 IEvent::Ptr ObjectStorage::get_event(string_view name, Resolve mode) const
 {
-    return interface_pointer_cast<IEvent>(find_or_create(name, MemberKind::Event, mode));
+    return interface_pointer_cast<IEvent>(get_or_create(find_member(name, MemberKind::Event), mode));
 }
 
 IFunction::Ptr ObjectStorage::get_function(string_view name, Resolve mode) const
 {
-    return interface_pointer_cast<IFunction>(find_or_create(name, MemberKind::Function, mode));
+    return interface_pointer_cast<IFunction>(get_or_create(find_member(name, MemberKind::Function), mode));
+}
+
+IInterface::Ptr ObjectStorage::get_member(MemberId id, MemberKind kind, Resolve mode) const
+{
+    return get_or_create(find_member(id, kind), mode);
+}
+
+IInterface::Ptr ObjectStorage::get_member_at(size_t index, Resolve mode) const
+{
+    return get_or_create(index < members_.size() ? index : members_.size(), mode);
+}
+
+size_t ObjectStorage::materialize_all(uint32_t kinds) const
+{
+    // Count the missing instances of each kind and take them from the pool with one call per
+    // kind, so each kind fills consecutive pool slots.
+    constexpr size_t KIND_COUNT = 4;
+    size_t offsets[KIND_COUNT + 1] = {};
+    for (size_t i = 0; i < members_.size(); ++i) {
+        auto kind = members_[i].kind;
+        if (!instances_[i] && (kinds & member_kind_bit(kind))) {
+            ++offsets[static_cast<size_t>(kind) + 1];
+        }
+    }
+    for (size_t k = 0; k < KIND_COUNT; ++k) {
+        offsets[k + 1] += offsets[k];
+    }
+    const size_t total = offsets[KIND_COUNT];
+    if (!total) {
+        return 0;
+    }
+    std::vector<IObject::Ptr> pooled(total);
+    if (pool_) {
+        for (size_t k = 0; k < KIND_COUNT; ++k) {
+            if (auto count = offsets[k + 1] - offsets[k]) {
+                pool_->acquire(member_class(static_cast<MemberKind>(k)), count, pooled.data() + offsets[k]);
+            }
+        }
+    }
+    // offsets[k] now walks the instances of kind k; a slot the pool did not fill is allocated.
+    for (size_t i = 0; i < members_.size(); ++i) {
+        auto& m = members_[i];
+        if (!instances_[i] && (kinds & member_kind_bit(m.kind))) {
+            instances_[i] = create(m, std::move(pooled[offsets[static_cast<size_t>(m.kind)]++]));
+            bind(m, instances_[i]);
+        }
+    }
+    return total;
 }
 
 void ObjectStorage::notify(MemberKind kind, Uid interfaceUid, Notification notification) const
 {
-    // Iterate only metadata entries (skip attachment region)
-    for (size_t i = attachment_end_; i < instances_.size(); ++i) {
-        auto idx = instances_[i].first;
-        auto& ptr = instances_[i].second;
-        auto& m = members_[idx];
-        if (m.kind != kind || !m.interfaceInfo || m.interfaceInfo->uid != interfaceUid) {
+    if (frozen_) {
+        return;
+    }
+    for (size_t i = 0; i < members_.size(); ++i) {
+        auto& ptr = instances_[i];
+        auto& m = members_[i];
+        if (!ptr || m.kind != kind || !m.interfaceInfo || m.interfaceInfo->uid != interfaceUid) {
             continue;
         }
 
         switch (notification) {
         case Notification::Changed:
             if (kind == MemberKind::Property || kind == MemberKind::ArrayProperty) {
-                if (auto* prop = interface_cast<IProperty>(ptr)) {
-                    invoke_event(prop->on_changed(), prop->get_value().get());
+                if (auto* pi = interface_cast<IPropertyInternal>(ptr)) {
+                    pi->notify_changed();
+                } else if (auto* prop = interface_cast<IProperty>(ptr)) {
+                    invoke_event(prop->on_changed(), prop->borrow_value().get());
                 }
             }
             break;
@@ -182,13 +342,70 @@ void ObjectStorage::notify(MemberKind kind, Uid interfaceUid, Notification notif
     }
 }
 
+ReturnValue ObjectStorage::freeze()
+{
+    if (frozen_) {
+        return ReturnValue::NothingToDo;
+    }
+    materialize_all();
+    for (size_t i = 0; i < members_.size(); ++i) {
+        auto* object = interface_cast<IObject>(instances_[i]);
+        if (!object) {
+            continue;
+        }
+        // The instances are created by this storage, so their class tells the implementation.
+        switch (members_[i].kind) {
+        case MemberKind::Property:
+            if (object->get_class_uid() == PropertyImpl::class_id()) {
+                static_cast<PropertyImpl*>(object)->freeze();
+            }
+            break;
+        case MemberKind::ArrayProperty:
+            if (object->get_class_uid() == ArrayPropertyImpl::class_id()) {
+                static_cast<ArrayPropertyImpl*>(object)->freeze();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    frozen_ = true;
+    return ReturnValue::Success;
+}
+
+borrowed_ptr<IInterface> ObjectStorage::borrow_member(MemberId id, MemberKind kind) const
+{
+    if (!frozen_) {
+        return nullptr;
+    }
+    size_t index = find_member(id, kind);
+    return index < members_.size() ? instances_[index].get() : nullptr;
+}
+
 ReturnValue ObjectStorage::add_attachment(const IInterface::Ptr& attachment)
 {
     if (!attachment) {
         return ReturnValue::InvalidArgument;
     }
-    instances_.insert(instances_.begin() + attachment_end_, {AttachmentSentinel, attachment});
-    attachment_end_++;
+    if (frozen_) {
+        return ReturnValue::ReadOnly;
+    }
+    auto position = static_cast<uint32_t>(attachments_.size());
+    Attachment entry{attachment, {}, false};
+    if (auto* object = attachment->get_interface<IObject>()) {
+        entry.classUid = object->get_class_uid();
+        if (auto* info = instance().type_registry().get_class_info(entry.classUid)) {
+            // The keys of the new attachment sort after the existing keys of each UID.
+            for (auto& intf : info->interfaces) {
+                AttachmentKey key{intf.uid, position};
+                attachmentIndex_.insert(
+                    std::upper_bound(attachmentIndex_.begin(), attachmentIndex_.end(), key), key);
+            }
+            entry.indexed = true;
+        }
+    }
+    unindexedCount_ += !entry.indexed;
+    attachments_.push_back(std::move(entry));
     return ReturnValue::Success;
 }
 
@@ -197,25 +414,39 @@ ReturnValue ObjectStorage::remove_attachment(const IInterface::Ptr& attachment)
     if (!attachment) {
         return ReturnValue::InvalidArgument;
     }
-    for (uint32_t i = 0; i < attachment_end_; ++i) {
-        if (instances_[i].second.get() == attachment.get()) {
-            instances_.erase(instances_.begin() + i);
-            attachment_end_--;
-            return ReturnValue::Success;
-        }
+    if (frozen_) {
+        return ReturnValue::ReadOnly;
+    }
+    auto it = std::find_if(attachments_.begin(), attachments_.end(),
+                           [&](const Attachment& a) { return a.object.get() == attachment.get(); });
+    if (it == attachments_.end()) {
+        return ReturnValue::NothingToDo;
     }
-    return ReturnValue::NothingToDo;
+    auto position = static_cast<uint32_t>(it - attachments_.begin());
+    if (it->indexed) {
+        attachmentIndex_.erase(std::remove_if(attachmentIndex_.begin(), attachmentIndex_.end(),
+                                              [&](const AttachmentKey& k) { return k.position == position; }),
+                               attachmentIndex_.end());
+    } else {
+        --unindexedCount_;
+    }
+    // Shifting the later positions down keeps the keys of each UID sorted.
+    for (auto& key : attachmentIndex_) {
+        key.position -= key.position > position;
+    }
+    attachments_.erase(it);
+    return ReturnValue::Success;
 }
 
 size_t ObjectStorage::attachment_count() const
 {
-    return attachment_end_;
+    return attachments_.size();
 }
 
 IInterface::Ptr ObjectStorage::get_attachment(size_t index) const
 {
-    if (index < attachment_end_) {
-        return instances_[index].second;
+    if (index < attachments_.size()) {
+        return attachments_[index].object;
     }
     return {};
 }
@@ -224,20 +455,36 @@ IInterface::Ptr ObjectStorage::find_attachment(const AttachmentQuery& query, Res
 {
     const bool matchInterface = query.interfaceUid != Uid{};
     const bool matchClass = query.classUid != Uid{};
+    auto matchesClass = [&](const Attachment& a) {
+        return !matchClass || a.classUid == Uid{} || a.classUid == query.classUid;
+    };
 
-    for (uint32_t i = 0; i < attachment_end_; ++i) {
-        auto& att = instances_[i].second;
-        if (matchInterface && !att->get_interface(query.interfaceUid)) {
-            continue;
+    size_t found = attachments_.size();
+    if (matchInterface) {
+        auto it = std::lower_bound(attachmentIndex_.begin(), attachmentIndex_.end(),
+                                   AttachmentKey{query.interfaceUid, 0});
+        for (; it != attachmentIndex_.end() && it->interfaceUid == query.interfaceUid; ++it) {
+            if (matchesClass(attachments_[it->position])) {
+                found = it->position;
+                break;
+            }
         }
-        if (matchClass) {
-            if (auto* obj = att->get_interface<IObject>()) {
-                if (obj->get_class_uid() != query.classUid) {
-                    continue;
-                }
+        // An earlier attachment of an unregistered class may match too.
+        for (size_t i = 0; unindexedCount_ && i < found; ++i) {
+            auto& a = attachments_[i];
+            if (!a.indexed && a.object->get_interface(query.interfaceUid) && matchesClass(a)) {
+                found = i;
             }
         }
-        return att;
+    } else {
+        for (size_t i = 0; i < attachments_.size() && found == attachments_.size(); ++i) {
+            if (matchesClass(attachments_[i])) {
+                found = i;
+            }
+        }
+    }
+    if (found < attachments_.size()) {
+        return attachments_[found].object;
     }
     if (mode == Resolve::Create && matchClass) {
         auto created = instance().create<IInterface>(query.classUid);
@@ -1,6 +1,8 @@
 #ifndef OBJECT_STORAGE_H
 #define OBJECT_STORAGE_H
 
+#include "hive/dirty_bit.h"
+
 #include <velk/ext/refcounted_dispatch.h>
 #include <velk/interface/intf_object_storage.h>
 
@@ -9,17 +11,24 @@
 
 namespace velk {
 
+class ObjectPool;
+
 /**
  * @brief Runtime object storage that lazily creates property/event/function instances
  *        and supports arbitrary attachments.
  *
  * Holds a static array_view<MemberDesc> (from VELK_INTERFACE) and creates runtime
  * PropertyImpl/FunctionImpl instances on first access via get_property()/get_event()/
- * get_function(). Created instances are cached for subsequent lookups.
+ * get_function(). Created instances are cached for subsequent lookups. The instances are
+ * taken from the slots of an ObjectPool rather than allocated one by one.
+ *
+ * Metadata instances are cached in a fixed array parallel to the member descriptors, so a
+ * member is looked up with a single pass over the descriptors and its instance by index.
+ * Attachments are kept in a separate vector, indexed by the UIDs of the interfaces their
+ * registered class implements, so an interface query is a binary search.
  *
- * The instances_ vector is partitioned: [0, attachment_end_) holds attachments,
- * [attachment_end_, size()) holds metadata instances. Attachment entries use SIZE_MAX
- * as the index sentinel.
+ * materialize_all() creates the missing instances in one pass instead, drawing them in bulk
+ * from the pool so that the members of a storage fill consecutive slots.
  *
  * Does not inherit RefCountedDispatch; lifetime is managed by the owning Object
  * (allocated by VelkInstance at construction, deleted in Object's destructor).
@@ -30,9 +39,13 @@ public:
     /**
      * @brief Constructs an object storage from static member descriptors.
      * @param members The static metadata array (from VELK_INTERFACE).
+     * @param table Perfect hash of @p members, or null to search them linearly.
      * @param owner The owning object, used to bind function trampolines and resolve property state.
+     * @param pool Pool the member instances are taken from, or null to allocate them one by one.
      */
-    explicit ObjectStorage(array_view<MemberDesc> members, IInterface* owner = nullptr);
+    explicit ObjectStorage(array_view<MemberDesc> members, const MemberTable* table = nullptr,
+                           IInterface* owner = nullptr, ObjectPool* pool = nullptr);
+    ~ObjectStorage();
 
 public: // IObject (inherited via IObjectStorage; not used as an IObject)
     Uid get_class_uid() const override { return {}; }
@@ -42,12 +55,16 @@ public: // IObject (inherited via IObjectStorage; not used as an IObject)
 
 public: // IPropertyState (inherited via IMetadata; state lives in the Object, not here)
     void* get_property_state(Uid) override { return nullptr; }
+    array_view<StateLayout> get_state_layouts() const override { return {}; }
 
 public: // IMetadata
     array_view<MemberDesc> get_static_metadata() const override;
     IProperty::Ptr get_property(string_view name, Resolve mode = Resolve::Create) const override;
     IEvent::Ptr get_event(string_view name, Resolve mode = Resolve::Create) const override;
     IFunction::Ptr get_function(string_view name, Resolve mode = Resolve::Create) const override;
+    IInterface::Ptr get_member(MemberId id, MemberKind kind, Resolve mode = Resolve::Create) const override;
+    IInterface::Ptr get_member_at(size_t index, Resolve mode = Resolve::Create) const override;
+    size_t materialize_all(uint32_t kinds = MemberKinds::All) const override;
     void notify(MemberKind kind, Uid interfaceUid, Notification notification) const override;
 
 public: // IObjectStorage (attachment operations)
@@ -56,20 +73,62 @@ public: // IObjectStorage (attachment operations)
     size_t attachment_count() const override;
     IInterface::Ptr get_attachment(size_t index) const override;
     IInterface::Ptr find_attachment(const AttachmentQuery& query, Resolve mode) override;
+    ReturnValue freeze() override;
+    borrowed_ptr<IInterface> borrow_member(MemberId id, MemberKind kind) const override;
 
 private:
     array_view<MemberDesc> members_; ///< Static metadata descriptors from VELK_INTERFACE.
+    const MemberTable* table_{};     ///< Perfect hash of members_, or null.
     IInterface* owner_{};            ///< Owning object for trampoline binding and state access.
+    ObjectPool* pool_{};             ///< Source of the member instances, or null.
+
+    /// Lazily populated cache of metadata instances, instances_[i] belongs to members_[i].
+    std::unique_ptr<IInterface::Ptr[]> instances_;
+
+    /** @brief An attachment and what queries match it against. */
+    struct Attachment
+    {
+        IInterface::Ptr object;
+        Uid classUid;  ///< Class UID if the attachment is an IObject, otherwise null (matches any class).
+        bool indexed{}; ///< True if the interfaces of the attachment are in attachmentIndex_.
+    };
+    /** @brief An interface implemented by an attachment. */
+    struct AttachmentKey
+    {
+        Uid interfaceUid;
+        uint32_t position; ///< Index of the attachment in attachments_.
 
-    /// Lazily populated cache: [0, attachment_end_) = attachments (idx == SIZE_MAX),
-    ///                         [attachment_end_, size()) = metadata instances.
-    mutable std::vector<std::pair<size_t, IInterface::Ptr>> instances_;
-    mutable uint32_t attachment_end_{0}; ///< Boundary between attachments and metadata entries.
+        bool operator<(const AttachmentKey& o) const
+        {
+            return interfaceUid < o.interfaceUid || (interfaceUid == o.interfaceUid && position < o.position);
+        }
+    };
 
-    /** @brief Finds a static member by name and kind, creating its runtime instance if needed. */
-    IInterface::Ptr find_or_create(string_view name, MemberKind kind, Resolve mode) const;
-    /** @brief Creates a runtime instance (PropertyImpl or FunctionImpl) from a member descriptor. */
-    IInterface::Ptr create(MemberDesc desc) const;
+    std::vector<Attachment> attachments_;         ///< Attachments in the order they were added.
+    std::vector<AttachmentKey> attachmentIndex_;  ///< Sorted interfaces of the indexed attachments.
+    uint32_t unindexedCount_{}; ///< Attachments of unregistered classes, which queries scan.
+    bool frozen_{};             ///< freeze() was called: instances_ and attachments_ never change.
+
+    /** @brief Returns the bytes tracked as MemoryCategory::Metadata: the storage and its member cache. */
+    size_t tracked_size() const;
+    /** @brief Returns the index of the static member @p name of @p kind, or members_.size(). */
+    size_t find_member(string_view name, MemberKind kind) const;
+    /** @brief Returns the index of the static member @p id of @p kind, or members_.size(). */
+    size_t find_member(MemberId id, MemberKind kind) const;
+    /** @brief Returns the instance of static member @p index, creating it if needed. */
+    IInterface::Ptr get_or_create(size_t index, Resolve mode) const;
+    /**
+     * @brief Creates a runtime instance (PropertyImpl or FunctionImpl) from a member descriptor.
+     * @param pooled An instance of the matching implementation taken from pool_, or null to allocate one.
+     */
+    IInterface::Ptr create(MemberDesc desc, IObject::Ptr pooled = {}) const;
+    /** @brief Returns the hive dirty bit a property created from @p desc marks on change. */
+    DirtyBit dirty_bit(const MemberDesc& desc) const;
+    /**
+     * @brief Returns the stale flags of the COMPUTED members that list @p desc as an input.
+     * @param base The State struct of the interface of @p desc.
+     */
+    std::vector<bool*> stale_flags(const MemberDesc& desc, void* base) const;
     /** @brief Binds a function instance to the owner's virtual trampoline. */
     void bind(const MemberDesc& m, const IInterface::Ptr& fn) const;
 };
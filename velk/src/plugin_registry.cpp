@@ -2,6 +2,7 @@
 
 #include <velk/ext/plugin.h>
 #include <velk/interface/intf_log.h>
+#include <velk/trace.h>
 
 #include <algorithm>
 #include <chrono>
@@ -57,12 +58,9 @@ ReturnValue PluginRegistry::check_dependencies(const PluginInfo& info)
     return ReturnValue::Success;
 }
 
-ReturnValue PluginRegistry::load_plugin(const IPlugin::Ptr& plugin)
+ReturnValue PluginRegistry::add_entry(const IPlugin::Ptr& plugin, Uid id)
 {
-    if (!plugin) {
-        return ReturnValue::InvalidArgument;
-    }
-    Uid id = interface_cast<IObject>(plugin.get())->get_class_uid();
+    auto lock = guard();
     PluginEntry key{id, {}};
     auto it = std::lower_bound(plugins_.begin(), plugins_.end(), key);
     if (it != plugins_.end() && it->uid == id) {
@@ -71,13 +69,21 @@ ReturnValue PluginRegistry::load_plugin(const IPlugin::Ptr& plugin)
     if (auto rv = check_dependencies(plugin->get_plugin_info()); failed(rv)) {
         return rv;
     }
-    it = plugins_.insert(it, PluginEntry{id, plugin});
+    plugins_.insert(it, PluginEntry{id, plugin});
+    return ReturnValue::Success;
+}
 
+ReturnValue PluginRegistry::initialize_entry(const IPlugin::Ptr& plugin, Uid id)
+{
+    // Not locked while initializing, so that concurrently initializing plugins can use the registry.
     PluginConfig config;
-    types_.set_owner(id);
+    Uid owner = types_.set_owner(id);
     ReturnValue rv = plugin->initialize(velk_, config);
-    types_.set_owner(Uid{});
+    types_.set_owner(owner);
 
+    auto lock = guard();
+    PluginEntry key{id, {}};
+    auto it = std::lower_bound(plugins_.begin(), plugins_.end(), key);
     it->config = config;
 
     if (failed(rv)) {
@@ -86,13 +92,128 @@ ReturnValue PluginRegistry::load_plugin(const IPlugin::Ptr& plugin)
     }
 
     if (config.enableUpdate) {
-        update_plugins_.push_back(plugin.get());
+        update_plugins_.push_back({plugin.get(), config.updateReads, config.updateWrites});
     }
     return ReturnValue::Success;
 }
 
+ReturnValue PluginRegistry::load_plugin(const IPlugin::Ptr& plugin)
+{
+    if (!plugin) {
+        return ReturnValue::InvalidArgument;
+    }
+    Uid id = interface_cast<IObject>(plugin.get())->get_class_uid();
+    auto rv = add_entry(plugin, id);
+    return rv == ReturnValue::Success ? initialize_entry(plugin, id) : rv;
+}
+
+ReturnValue PluginRegistry::load_plugins(array_view<IPlugin::Ptr> plugins, IExecutor* executor)
+{
+    struct Pending
+    {
+        const IPlugin::Ptr* plugin;
+        Uid uid;
+        ReturnValue result;
+    };
+    std::vector<Pending> pending;
+    for (auto& plugin : plugins) {
+        if (!plugin) {
+            return ReturnValue::InvalidArgument;
+        }
+        Uid id = interface_cast<IObject>(plugin.get())->get_class_uid();
+        bool listed = std::any_of(pending.begin(), pending.end(), [id](auto& p) { return p.uid == id; });
+        if (!listed && !find_plugin(id)) {
+            pending.push_back({&plugin, id, ReturnValue::Success});
+        }
+    }
+    if (pending.empty()) {
+        return ReturnValue::NothingToDo;
+    }
+
+    auto is_pending = [&pending](Uid uid) {
+        return std::any_of(pending.begin(), pending.end(), [uid](auto& p) { return p.uid == uid; });
+    };
+    ReturnValue result = ReturnValue::Success;
+    std::vector<Pending> wave;
+    while (!pending.empty()) {
+        // The next wave: plugins none of whose dependencies is still waiting to load.
+        wave.clear();
+        for (auto& p : pending) {
+            auto deps = (*p.plugin)->get_plugin_info().dependencies;
+            if (std::none_of(deps.begin(), deps.end(), [&](auto& dep) { return is_pending(dep.uid); })) {
+                wave.push_back(p);
+            }
+        }
+        if (wave.empty()) {
+            for (auto& p : pending) {
+                auto name = (*p.plugin)->get_name();
+                detail::velk_log(log_,
+                                 LogLevel::Error,
+                                 __FILE__,
+                                 __LINE__,
+                                 "Plugin '%.*s' is part of a dependency cycle",
+                                 static_cast<int>(name.size()),
+                                 name.data());
+            }
+            return ReturnValue::Fail;
+        }
+        pending.erase(std::remove_if(pending.begin(),
+                                     pending.end(),
+                                     [&](auto& p) {
+                                         return std::any_of(wave.begin(), wave.end(), [&](auto& w) {
+                                             return w.uid == p.uid;
+                                         });
+                                     }),
+                      pending.end());
+
+        // Entries are added up front, so that the wave sees its own plugins as loaded. A plugin
+        // whose dependency failed to load fails here and takes its dependents with it.
+        for (auto& p : wave) {
+            p.result = add_entry(*p.plugin, p.uid);
+        }
+        wave.erase(std::remove_if(wave.begin(),
+                                  wave.end(),
+                                  [&](auto& p) {
+                                      if (failed(p.result)) {
+                                          result = ReturnValue::Fail;
+                                      }
+                                      return p.result != ReturnValue::Success;
+                                  }),
+                   wave.end());
+
+        struct Context
+        {
+            PluginRegistry* self;
+            Pending* wave;
+        } context{this, wave.data()};
+        auto task = [](void* ctx, size_t index) {
+            auto& c = *static_cast<Context*>(ctx);
+            auto& p = c.wave[index];
+            p.result = c.self->initialize_entry(*p.plugin, p.uid);
+        };
+        if (executor && wave.size() > 1) {
+            concurrent_.fetch_add(1, std::memory_order_relaxed);
+            executor->parallel_for(wave.size(), &context, task);
+            concurrent_.fetch_sub(1, std::memory_order_relaxed);
+        } else {
+            for (size_t i = 0; i < wave.size(); ++i) {
+                task(&context, i);
+            }
+        }
+        for (auto& p : wave) {
+            if (failed(p.result)) {
+                result = ReturnValue::Fail;
+            }
+        }
+    }
+    return result;
+}
+
 ReturnValue PluginRegistry::load_plugin(Uid pluginUid)
 {
+    if (load_provider(pluginUid)) {
+        return find_plugin(pluginUid) ? ReturnValue::Success : ReturnValue::Fail;
+    }
     auto plugin = interface_pointer_cast<IPlugin>(types_.create(pluginUid));
     if (!plugin) {
         detail::velk_log(log_,
@@ -135,9 +256,7 @@ ReturnValue PluginRegistry::load_plugin_from_path(const char* path)
 
     // Check for duplicates and dependencies before instantiating.
     Uid id = info.uid();
-    PluginEntry key{id, {}};
-    auto it = std::lower_bound(plugins_.begin(), plugins_.end(), key);
-    if (it != plugins_.end() && it->uid == id) {
+    if (find_plugin(id)) {
         lib.close();
         return ReturnValue::NothingToDo;
     }
@@ -157,7 +276,8 @@ ReturnValue PluginRegistry::load_plugin_from_path(const char* path)
 
     ReturnValue rv = load_plugin(plugin);
     if (succeeded(rv)) {
-        it = std::lower_bound(plugins_.begin(), plugins_.end(), key);
+        auto lock = guard();
+        auto it = std::lower_bound(plugins_.begin(), plugins_.end(), PluginEntry{id, {}});
         it->library = std::move(lib);
     } else {
         lib.close();
@@ -165,8 +285,48 @@ ReturnValue PluginRegistry::load_plugin_from_path(const char* path)
     return rv;
 }
 
+ReturnValue PluginRegistry::register_plugin_library(Uid pluginId, const char* path, array_view<Uid> classUids)
+{
+    if (!path || !*path) {
+        return ReturnValue::InvalidArgument;
+    }
+    auto lock = guard();
+    if (find_plugin(pluginId)) {
+        return ReturnValue::NothingToDo;
+    }
+    for (auto& entry : libraries_) {
+        if (entry.plugin == pluginId) {
+            return ReturnValue::NothingToDo;
+        }
+    }
+    libraries_.push_back({pluginId, string(path), std::vector<Uid>(classUids.begin(), classUids.end())});
+    return ReturnValue::Success;
+}
+
+bool PluginRegistry::load_provider(Uid uid)
+{
+    string path;
+    {
+        auto lock = guard();
+        auto it = std::find_if(libraries_.begin(), libraries_.end(), [uid](const LibraryEntry& entry) {
+            return entry.plugin == uid || std::find(entry.classes.begin(), entry.classes.end(), uid) !=
+                                              entry.classes.end();
+        });
+        if (it == libraries_.end()) {
+            return false;
+        }
+        // Taken out first, so that a failed load is not retried and the plugin may create its own
+        // classes while it initializes.
+        path = std::move(it->path);
+        libraries_.erase(it);
+    }
+    load_plugin_from_path(path.c_str());
+    return true;
+}
+
 ReturnValue PluginRegistry::unload_plugin(Uid pluginId)
 {
+    auto lock = guard();
     PluginEntry key{pluginId, {}};
     auto it = std::lower_bound(plugins_.begin(), plugins_.end(), key);
     if (it == plugins_.end() || it->uid != pluginId) {
@@ -198,11 +358,15 @@ ReturnValue PluginRegistry::unload_plugin(Uid pluginId)
     it->plugin->shutdown(velk_);
 
     // Remove from update cache.
-    auto uit = std::find(update_plugins_.begin(), update_plugins_.end(), raw);
+    auto uit = std::find_if(
+        update_plugins_.begin(), update_plugins_.end(), [raw](auto& u) { return u.plugin == raw; });
     if (uit != update_plugins_.end()) {
         update_plugins_.erase(uit);
     }
 
+    if (unload_hook_) {
+        unload_hook_(unload_context_);
+    }
     // Sweep types owned by this plugin unless it opted to retain them.
     if (!it->config.retainTypesOnUnload) {
         types_.sweep_owner(pluginId);
@@ -217,6 +381,7 @@ ReturnValue PluginRegistry::unload_plugin(Uid pluginId)
 
 IPlugin* PluginRegistry::find_plugin(Uid pluginId) const
 {
+    auto lock = guard();
     PluginEntry key{pluginId, {}};
     auto it = std::lower_bound(plugins_.begin(), plugins_.end(), key);
     if (it != plugins_.end() && it->uid == pluginId) {
@@ -227,6 +392,7 @@ IPlugin* PluginRegistry::find_plugin(Uid pluginId) const
 
 size_t PluginRegistry::plugin_count() const
 {
+    auto lock = guard();
     return plugins_.size();
 }
 
@@ -240,6 +406,9 @@ void PluginRegistry::shutdown_all()
         auto& entry = plugins_.back();
         entry.plugin->shutdown(velk_);
 
+        if (unload_hook_) {
+            unload_hook_(unload_context_);
+        }
         // Sweep types owned by this plugin unless it opted to retain them.
         if (!entry.config.retainTypesOnUnload) {
             types_.sweep_owner(entry.uid);
@@ -277,9 +446,24 @@ UpdateInfo PluginRegistry::pre_update_plugins(Duration time) const
 
     // Snapshot: plugins may load/unload other plugins during callbacks.
     auto plugins = update_plugins_;
-    for (auto* plugin : plugins) {
-        plugin->pre_update({info});
+    timings_.clear();
+    for (auto& u : plugins) {
+        timings_.push_back({u.plugin, {}, {}});
     }
+    struct Context
+    {
+        const std::vector<UpdatePlugin>& plugins;
+        std::vector<PluginUpdateTiming>& timings;
+        const UpdateInfo& info;
+    } context{plugins, timings_, info};
+    run_update_phase(plugins, &context, [](void* ctx, size_t i) {
+        auto& c = *static_cast<Context*>(ctx);
+        IPlugin* plugin = c.plugins[i].plugin;
+        VELK_TRACE_ZONE_TEXT("IPlugin::pre_update", plugin->get_name());
+        int64_t start = now_us();
+        plugin->pre_update({c.info});
+        c.timings[i].preUpdate = {now_us() - start};
+    });
 
     return info;
 }
@@ -287,8 +471,86 @@ UpdateInfo PluginRegistry::pre_update_plugins(Duration time) const
 void PluginRegistry::post_update_plugins(const IPlugin::PostUpdateInfo& info) const
 {
     auto plugins = update_plugins_;
-    for (auto* plugin : plugins) {
-        plugin->post_update(info);
+    struct Context
+    {
+        const std::vector<UpdatePlugin>& plugins;
+        std::vector<PluginUpdateTiming>& timings;
+        const IPlugin::PostUpdateInfo& info;
+    } context{plugins, timings_, info};
+    run_update_phase(plugins, &context, [](void* ctx, size_t i) {
+        auto& c = *static_cast<Context*>(ctx);
+        IPlugin* plugin = c.plugins[i].plugin;
+        VELK_TRACE_ZONE_TEXT("IPlugin::post_update", plugin->get_name());
+        int64_t start = now_us();
+        plugin->post_update(c.info);
+        Duration elapsed{now_us() - start};
+        // The plugins usually match the pre-update ones. A plugin loaded in between has no
+        // entry; adding one here would invalidate the timings that the plugins are reading.
+        // Each plugin only writes its own entry, so plugins called in parallel do not race.
+        if (i < c.timings.size() && c.timings[i].plugin == plugin) {
+            c.timings[i].postUpdate = elapsed;
+            return;
+        }
+        for (auto& timing : c.timings) {
+            if (timing.plugin == plugin) {
+                timing.postUpdate = elapsed;
+                break;
+            }
+        }
+    });
+}
+
+/** @brief True if neither plugin writes state that the other reads or writes. */
+static bool can_run_together(uint64_t reads, uint64_t writes, uint64_t otherReads, uint64_t otherWrites)
+{
+    return !(writes & (otherReads | otherWrites)) && !(otherWrites & reads);
+}
+
+void PluginRegistry::run_update_phase(const std::vector<UpdatePlugin>& plugins, void* context,
+                                      void (*call)(void* context, size_t index)) const
+{
+    auto executor = velk_.get_executor();
+    bool parallel = executor && executor->get_concurrency() > 1;
+    std::vector<size_t> wave;
+    size_t next = 0;
+    while (next < plugins.size()) {
+        // Idleness is checked as late as possible, so that work queued by the plugins called
+        // before is seen.
+        auto& first = plugins[next++];
+        if (first.plugin->is_update_idle()) {
+            continue;
+        }
+        wave.assign(1, next - 1);
+        // Extend the wave with the following plugins for as long as each can run alongside
+        // all plugins already in it, which keeps conflicting plugins in their order.
+        uint64_t reads = first.reads;
+        uint64_t writes = first.writes;
+        while (parallel && next < plugins.size()) {
+            auto& u = plugins[next];
+            if (!can_run_together(reads, writes, u.reads, u.writes)) {
+                break;
+            }
+            ++next;
+            if (!u.plugin->is_update_idle()) {
+                wave.push_back(next - 1);
+                reads |= u.reads;
+                writes |= u.writes;
+            }
+        }
+        if (wave.size() == 1) {
+            call(context, wave[0]);
+            continue;
+        }
+        struct Wave
+        {
+            const size_t* indices;
+            void* context;
+            void (*call)(void*, size_t);
+        } w{wave.data(), context, call};
+        executor->parallel_for(wave.size(), &w, [](void* ctx, size_t k) {
+            auto& w = *static_cast<Wave*>(ctx);
+            w.call(w.context, w.indices[k]);
+        });
     }
 }
 
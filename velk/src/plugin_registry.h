@@ -10,6 +10,8 @@
 #include <velk/interface/intf_velk.h>
 #include <velk/string.h>
 
+#include <atomic>
+#include <mutex>
 #include <vector>
 
 namespace velk {
@@ -20,6 +22,8 @@ namespace velk {
  * Maintains a sorted vector of loaded plugins and handles loading,
  * initialization, dependency checking, and shutdown.
  * Owned as a stack member by VelkInstance.
+ *
+ * Not synchronized, except while load_plugins() initializes plugins on several threads.
  */
 class PluginRegistry final : public ext::InterfaceDispatch<IPluginRegistry>
 {
@@ -30,6 +34,8 @@ public:
     ReturnValue load_plugin(const IPlugin::Ptr& plugin) override;
     ReturnValue load_plugin(Uid pluginUid) override;
     ReturnValue load_plugin_from_path(const char* path) override;
+    ReturnValue load_plugins(array_view<IPlugin::Ptr> plugins, IExecutor* executor) override;
+    ReturnValue register_plugin_library(Uid pluginId, const char* path, array_view<Uid> classUids) override;
     ReturnValue unload_plugin(Uid pluginId) override;
     IPlugin* find_plugin(Uid pluginId) const override;
     size_t plugin_count() const override;
@@ -39,6 +45,23 @@ public:
     UpdateInfo pre_update_plugins(Duration time) const;
     /** @brief Calls post_update on opted-in plugins with the same UpdateInfo from pre_update. */
     void post_update_plugins(const IPlugin::PostUpdateInfo& info) const;
+    /**
+     * @brief Sets a function called before a plugin's types are swept, to destroy objects of
+     *        those types that the instance keeps for reuse.
+     */
+    void set_unload_hook(void (*hook)(void* context), void* context)
+    {
+        unload_hook_ = hook;
+        unload_context_ = context;
+    }
+    /**
+     * @brief Loads the library registered with register_plugin_library() as the provider of
+     *        plugin or class @p uid.
+     * @return false if no library is registered for @p uid.
+     */
+    bool load_provider(Uid uid);
+    /** @brief Returns how long each plugin spent in the callbacks of the latest update. */
+    array_view<PluginUpdateTiming> get_update_timings() const { return {timings_.data(), timings_.size()}; }
 
 private:
     /** @brief Plugin registry entry. */
@@ -51,13 +74,59 @@ private:
         bool operator<(const PluginEntry& o) const { return uid < o.uid; }
     };
 
+    /** @brief A plugin that opted into update notifications, with its PluginConfig access sets. */
+    struct UpdatePlugin
+    {
+        IPlugin* plugin;
+        uint64_t reads;
+        uint64_t writes;
+    };
+
+    /** @brief A plugin library registered with register_plugin_library(), not loaded yet. */
+    struct LibraryEntry
+    {
+        Uid plugin;               ///< Uid of the plugin in the library.
+        string path;              ///< Path of the library.
+        std::vector<Uid> classes; ///< Classes the plugin provides.
+    };
+
     /** @brief Checks that all dependencies declared in info are loaded. Logs and returns Fail if not. */
     ReturnValue check_dependencies(const PluginInfo& info);
+    /**
+     * @brief Adds the entry of @p plugin, whose class UID is @p id, if its dependencies are loaded.
+     * @return NothingToDo if the plugin is loaded already, Fail on unmet dependencies.
+     */
+    ReturnValue add_entry(const IPlugin::Ptr& plugin, Uid id);
+    /** @brief Initializes @p plugin, added by add_entry(), and removes its entry if that fails. */
+    ReturnValue initialize_entry(const IPlugin::Ptr& plugin, Uid id);
+    /**
+     * @brief Calls @p call with the index of each plugin in @p plugins that is not idle.
+     *
+     * Adjacent plugins whose access sets do not conflict are called in parallel on the executor
+     * of the instance, if it has one. Conflicting plugins are called in order.
+     */
+    void run_update_phase(const std::vector<UpdatePlugin>& plugins, void* context,
+                          void (*call)(void* context, size_t index)) const;
+    /** @brief Locks the registry while load_plugins() initializes concurrently, else nothing. */
+    std::unique_lock<std::recursive_mutex> guard() const
+    {
+        std::unique_lock<std::recursive_mutex> lock(mutex_, std::defer_lock);
+        if (concurrent_.load(std::memory_order_relaxed)) {
+            lock.lock();
+        }
+        return lock;
+    }
 
     std::vector<PluginEntry> plugins_;        ///< Sorted registry of loaded plugins.
-    std::vector<IPlugin*> update_plugins_;    ///< Plugins that opted into update notifications.
+    std::vector<UpdatePlugin> update_plugins_; ///< Plugins that opted into update notifications.
+    std::vector<LibraryEntry> libraries_;     ///< Plugin libraries to load on demand.
     mutable UpdateInfo update_timestamps_;    ///< Absolute timestamps for init, first update, last update.
     mutable bool last_update_was_explicit_{}; ///< Whether previous update used explicit time.
+    mutable std::vector<PluginUpdateTiming> timings_; ///< Callback timings of the latest update.
+    void (*unload_hook_)(void*){}; ///< Called before a plugin is swept, see set_unload_hook().
+    void* unload_context_{};
+    std::atomic<uint32_t> concurrent_{};      ///< Depth of concurrent initialization in load_plugins().
+    mutable std::recursive_mutex mutex_;      ///< Guards the vectors above while concurrent_.
     ILog& log_;
     TypeRegistry& types_;
     IVelk& velk_;
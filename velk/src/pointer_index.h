@@ -0,0 +1,120 @@
+#ifndef VELK_SRC_POINTER_INDEX_H
+#define VELK_SRC_POINTER_INDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace velk {
+
+/**
+ * @brief Open-addressed map from a non-null pointer to an index, for tables rebuilt every frame.
+ *
+ * Uses linear probing over a power-of-two table at most half full. clear() keeps the table,
+ * so an index refilled every update() stops allocating once it has grown to the working set.
+ * Not thread-safe.
+ */
+class PointerIndex
+{
+public:
+    /**
+     * @brief Inserts @p key with @p value unless present.
+     * @return The value stored for @p key, and true if it was inserted.
+     */
+    std::pair<size_t*, bool> try_emplace(const void* key, size_t value)
+    {
+        if ((size_ + 1) * 2 > capacity_) {
+            grow(capacity_ ? capacity_ * 2 : MIN_CAPACITY);
+        }
+        Slot* slot = probe(key);
+        if (slot->key) {
+            return {&slot->value, false};
+        }
+        *slot = {key, value};
+        ++size_;
+        return {&slot->value, true};
+    }
+
+    /** @brief Returns the value stored for @p key, or null. */
+    size_t* find(const void* key) const
+    {
+        if (!size_) {
+            return nullptr;
+        }
+        Slot* slot = probe(key);
+        return slot->key ? &slot->value : nullptr;
+    }
+
+    /** @brief Removes all entries and keeps the table. */
+    void clear()
+    {
+        if (size_) {
+            std::fill_n(slots_.get(), capacity_, Slot{});
+            size_ = 0;
+        }
+    }
+
+    /** @brief Removes all entries and frees the table. */
+    void release()
+    {
+        slots_.reset();
+        capacity_ = 0;
+        size_ = 0;
+        shift_ = 64;
+    }
+
+    /** @brief Returns the number of entries. */
+    size_t size() const { return size_; }
+    /** @brief Returns the number of slots in the table. */
+    size_t capacity() const { return capacity_; }
+
+private:
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    struct Slot
+    {
+        const void* key;
+        size_t value;
+    };
+
+    /** @brief Returns the slot holding @p key, or the empty slot where it belongs. */
+    Slot* probe(const void* key) const
+    {
+        size_t mask = capacity_ - 1;
+        // Fibonacci hashing: the top bits of the product mix all bits of the pointer.
+        uint64_t hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key)) * 0x9E3779B97F4A7C15ull;
+        size_t i = static_cast<size_t>(hash >> shift_);
+        while (slots_[i].key && slots_[i].key != key) {
+            i = (i + 1) & mask;
+        }
+        return &slots_[i];
+    }
+
+    void grow(size_t capacity)
+    {
+        auto old = std::move(slots_);
+        size_t oldCapacity = capacity_;
+        slots_ = std::make_unique<Slot[]>(capacity);
+        capacity_ = capacity;
+        shift_ = 64;
+        for (size_t c = capacity; c > 1; c >>= 1) {
+            --shift_;
+        }
+        for (size_t i = 0; i < oldCapacity; ++i) {
+            if (old[i].key) {
+                *probe(old[i].key) = old[i];
+            }
+        }
+    }
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_{0};
+    size_t size_{0};
+    unsigned shift_{64}; ///< 64 - log2(capacity_).
+};
+
+} // namespace velk
+
+#endif // VELK_SRC_POINTER_INDEX_H
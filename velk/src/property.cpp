@@ -5,8 +5,55 @@
 #include <velk/interface/intf_external_any.h>
 #include <velk/interface/types.h>
 
+#include <cstring>
+
 namespace velk {
 
+namespace {
+
+/** @brief Copies N bytes from @p src to @p dst, returning false if they were already equal. */
+template <size_t N>
+bool store_changed(void* dst, const void* src)
+{
+    if (std::memcmp(dst, src, N) == 0) {
+        return false;
+    }
+    std::memcpy(dst, src, N);
+    return true;
+}
+
+/**
+ * @brief Copies @p size bytes from @p src to @p dst, returning false if they were already equal.
+ *
+ * Common value sizes get a fixed-size compare and copy, which compile to plain loads and stores
+ * instead of library calls.
+ */
+bool store_changed(void* dst, const void* src, size_t size)
+{
+    switch (size) {
+    case 1:
+        return store_changed<1>(dst, src);
+    case 2:
+        return store_changed<2>(dst, src);
+    case 4:
+        return store_changed<4>(dst, src);
+    case 8:
+        return store_changed<8>(dst, src);
+    case 12:
+        return store_changed<12>(dst, src);
+    case 16:
+        return store_changed<16>(dst, src);
+    default:
+        if (std::memcmp(dst, src, size) == 0) {
+            return false;
+        }
+        std::memcpy(dst, src, size);
+        return true;
+    }
+}
+
+} // namespace
+
 ReturnValue PropertyImpl::set_value(const IAny& from, InvokeType type)
 {
     if (get_object_data().flags & ObjectFlags::ReadOnly) {
@@ -15,11 +62,11 @@ ReturnValue PropertyImpl::set_value(const IAny& from, InvokeType type)
     if (!data_) {
         return ReturnValue::Fail;
     }
-    if (type == Deferred) {
-        // Create a clone with value "from" and store it in the deferred callback
-        auto clone = data_->clone();
-        if (clone && clone->copy_from(from) == ReturnValue::Success) {
-            instance().queue_deferred_property({get_self<IPropertyInternal>(), std::move(clone)});
+    if (invoke_mode(type) != Immediate) {
+        // Stage value "from" in a recycled or cloned any and store it in the deferred queue
+        auto clone = instance().acquire_deferred_value(*data_);
+        if (clone && succeeded(clone->copy_from(from))) {
+            instance().queue_deferred_property({get_self<IPropertyInternal>(), std::move(clone), true});
             return ReturnValue::Success;
         }
         return ReturnValue::Fail;
@@ -27,7 +74,7 @@ ReturnValue PropertyImpl::set_value(const IAny& from, InvokeType type)
     // type == Immediate, just copy the value
     auto ret = data_->copy_from(from);
     if (ret == ReturnValue::Success && !external_) {
-        invoke_event(on_changed(), data_.get());
+        notify_changed();
     }
     return ret;
 }
@@ -35,6 +82,21 @@ const IAny::ConstPtr PropertyImpl::get_value() const
 {
     return data_;
 }
+borrowed_ptr<const IAny> PropertyImpl::borrow_value() const
+{
+    return data_;
+}
+const void* PropertyImpl::get_state_data(Uid type) const
+{
+    return direct_state(type);
+}
+void PropertyImpl::set_state(void* data, const IAny* any, Uid type)
+{
+    state_ = any ? data : nullptr;
+    stateAny_ = state_ ? any : nullptr;
+    stateType_ = type;
+    stateSize_ = stateAny_ ? stateAny_->get_data_size(type) : 0;
+}
 bool PropertyImpl::set_any(const IAny::Ptr& value, IAny::Ptr* previous)
 {
     if (previous) {
@@ -59,6 +121,13 @@ bool PropertyImpl::set_any(const IAny::Ptr& value, IAny::Ptr* previous)
         // our on_changed. PropertyImpl skips its own explicit fire for external anys.
         external->on_data_changed()->add_handler(on_changed());
     }
+    if ((get_object_data().flags & ObjectFlags::CompareOnWrite) && data_ && !external_) {
+        if (!lastNotified_ || failed(lastNotified_->copy_from(*data_))) {
+            lastNotified_ = data_->clone();
+        }
+    } else {
+        lastNotified_ = {};
+    }
     return succeeded(invoke_event(on_changed(), data_.get()));
 }
 IAny::ConstPtr PropertyImpl::get_any() const
@@ -82,6 +151,64 @@ ReturnValue PropertyImpl::set_value_silent(const IAny& from)
     return ret;
 }
 
+ReturnValue PropertyImpl::apply_trivial_data(const void* data, size_t size, Uid type)
+{
+    if (get_object_data().flags & ObjectFlags::ReadOnly) {
+        return ReturnValue::ReadOnly;
+    }
+    auto* state = direct_state(type);
+    if (!state || !data || size != stateSize_) {
+        return ReturnValue::Refused;
+    }
+    if (!store_changed(state, data, size)) {
+        return ReturnValue::NothingToDo;
+    }
+    // Without an event or a last notified value to compare, notify_changed() would only mark.
+    if (!onChanged_.get_if_created() && !lastNotified_) {
+        mark_changed();
+        return ReturnValue::NothingToDo;
+    }
+    return ReturnValue::Success;
+}
+
+void PropertyImpl::freeze()
+{
+    if (external_) {
+        if (auto* ext = interface_cast<IExternalAny>(data_)) {
+            if (auto& event = onChanged_.get_if_created()) {
+                ext->on_data_changed()->remove_handler(event);
+            }
+        }
+    }
+    detail::BlockAccess::set_flags(*this, get_object_data().flags | ObjectFlags::ReadOnly);
+    onChanged_ = {};
+    lastNotified_ = {};
+    dirty_ = {};
+    stale_ = {};
+}
+
+ReturnValue PropertyImpl::notify_changed()
+{
+    // copy_from() returns NothingToDo if the values are equal.
+    if (lastNotified_ && data_ && lastNotified_->copy_from(*data_) == ReturnValue::NothingToDo) {
+        return ReturnValue::NothingToDo;
+    }
+    mark_changed();
+    invoke_event(onChanged_.get_if_created(), data_.get());
+    return ReturnValue::Success;
+}
+
+void PropertyImpl::mark_changed()
+{
+    dirty_.mark();
+    for (auto* stale : stale_) {
+        // The cache of a State with a seqlock was marked within the write already.
+        if (!*stale) {
+            *stale = true;
+        }
+    }
+}
+
 ReturnValue PropertyImpl::set_data(const void* data, size_t size, Uid type, InvokeType invokeType)
 {
     if (get_object_data().flags & ObjectFlags::ReadOnly) {
@@ -90,21 +217,53 @@ ReturnValue PropertyImpl::set_data(const void* data, size_t size, Uid type, Invo
     if (!data_) {
         return ReturnValue::Fail;
     }
-    if (invokeType == Deferred) {
-        auto clone = data_->clone();
-        if (clone && clone->set_data(data, size, type) == ReturnValue::Success) {
-            instance().queue_deferred_property({get_self<IPropertyInternal>(), std::move(clone)});
+    if (invoke_mode(invokeType) != Immediate) {
+        auto clone = instance().acquire_deferred_value(*data_);
+        if (clone && succeeded(clone->set_data(data, size, type))) {
+            instance().queue_deferred_property({get_self<IPropertyInternal>(), std::move(clone), true});
             return ReturnValue::Success;
         }
         return ReturnValue::Fail;
     }
     auto ret = data_->set_data(data, size, type);
     if (ret == ReturnValue::Success && !external_) {
-        invoke_event(on_changed(), data_.get());
+        notify_changed();
     }
     return ret;
 }
 
+ReturnValue PropertyImpl::set_trivial_data(const void* data, size_t size, Uid type, InvokeType invokeType)
+{
+    if (invoke_mode(invokeType) == Immediate) {
+        // Write straight into the State field, skipping the backing any.
+        auto* state = direct_state(type);
+        if (!state || !data || size != stateSize_ || (get_object_data().flags & ObjectFlags::ReadOnly)) {
+            return set_data(data, size, type, invokeType);
+        }
+        if (!store_changed(state, data, size)) {
+            return ReturnValue::NothingToDo;
+        }
+        notify_changed();
+        return ReturnValue::Success;
+    }
+    if (size > DeferredPropertySet::INLINE_SIZE) {
+        return set_data(data, size, type, invokeType);
+    }
+    if (get_object_data().flags & ObjectFlags::ReadOnly) {
+        return ReturnValue::ReadOnly;
+    }
+    // The backing value must accept the data, as a clone of it would have to.
+    if (!data || !data_ || data_->get_data_size(type) != size) {
+        return ReturnValue::Fail;
+    }
+    DeferredPropertySet set{get_self<IPropertyInternal>()};
+    set.inlineSize = static_cast<uint8_t>(size);
+    set.inlineType = type;
+    std::memcpy(set.inlineData, data, size);
+    instance().queue_deferred_property(std::move(set));
+    return ReturnValue::Success;
+}
+
 bool PropertyImpl::install_extension(const IAnyExtension::Ptr& extension)
 {
     if (!extension) {
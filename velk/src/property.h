@@ -1,12 +1,16 @@
 #ifndef PROPERTY_H
 #define PROPERTY_H
 
+#include "hive/dirty_bit.h"
+
 #include <velk/common.h>
 #include <velk/ext/core_object.h>
 #include <velk/ext/event.h>
 #include <velk/interface/intf_property.h>
 #include <velk/interface/types.h>
 
+#include <vector>
+
 namespace velk {
 
 /**
@@ -16,6 +20,11 @@ namespace velk {
  * set_value/set_data modifies the value. Supports read-only mode via
  * ObjectFlags::ReadOnly. When the backing IAny implements IExternalAny,
  * automatically relays its on_data_changed event to the property's on_changed.
+ * With ObjectFlags::CompareOnWrite, keeps a copy of the last notified value and
+ * suppresses on_changed for writes that leave the value equal to it.
+ *
+ * A property backed by a State field (see set_state()) reads and writes the field directly
+ * for as long as the State any is the backing any, i.e. until an extension is installed.
  */
 class PropertyImpl final : public ext::ObjectCore<PropertyImpl, IPropertyInternal>
 {
@@ -24,22 +33,57 @@ public:
 
     PropertyImpl() = default;
 
+    /** @brief Sets the hive dirty bit that notify_changed() marks. */
+    void set_dirty_bit(const DirtyBit& bit) { dirty_ = bit; }
+    /** @brief Sets the stale flags of the COMPUTED members that notify_changed() invalidates. */
+    void set_stale_flags(std::vector<bool*> flags) { stale_ = std::move(flags); }
+    /**
+     * @brief Sets the State field that @p any refers to, enabling direct access to it.
+     * @param data Address of the field, or nullptr to disable direct access.
+     * @param any The any referring to @p data. Direct access is used while it is the backing any.
+     * @param type Type of the field.
+     */
+    void set_state(void* data, const IAny* any, Uid type);
+    /** @brief Makes the property read-only and drops its change notification (see IObjectStorage::freeze()). */
+    void freeze();
+
 protected: // IProperty
     ReturnValue set_value(const IAny& from, InvokeType type = Immediate) override;
     const IAny::ConstPtr get_value() const override;
+    borrowed_ptr<const IAny> borrow_value() const override;
+    const void* get_state_data(Uid type) const override;
     IEvent::Ptr on_changed() const override { return onChanged_; }
 
 protected: // IPropertyInternal
     bool set_any(const IAny::Ptr& value, IAny::Ptr* previous = nullptr) override;
     IAny::ConstPtr get_any() const override;
     ReturnValue set_data(const void* data, size_t size, Uid type, InvokeType invokeType = Immediate) override;
+    ReturnValue set_trivial_data(const void* data, size_t size, Uid type,
+                                 InvokeType invokeType = Immediate) override;
     ReturnValue set_value_silent(const IAny& from) override;
+    ReturnValue apply_trivial_data(const void* data, size_t size, Uid type) override;
+    ReturnValue notify_changed() override;
     bool install_extension(const IAnyExtension::Ptr& extension) override;
     bool remove_extension(const IAnyExtension::Ptr& extension) override;
 
 private:
+    /** @brief Returns the State field if it can be accessed directly as @p type, nullptr otherwise. */
+    void* direct_state(Uid type) const
+    {
+        return data_.get() == stateAny_ && type == stateType_ ? state_ : nullptr;
+    }
+    /** @brief Marks the dependents of the property changed: the hive dirty bit and COMPUTED members. */
+    void mark_changed();
+
     IAny::Ptr data_;
+    void* state_{};          ///< State field referred to by stateAny_, if any.
+    const IAny* stateAny_{}; ///< The any referring to state_.
+    Uid stateType_{};        ///< Type of state_.
+    size_t stateSize_{};     ///< Size of state_ in bytes.
+    IAny::Ptr lastNotified_; ///< Value last notified, if ObjectFlags::CompareOnWrite is set.
     ext::LazyEvent onChanged_;
+    DirtyBit dirty_;
+    std::vector<bool*> stale_; ///< Stale flags of the COMPUTED members derived from this property.
     bool external_{}; ///< True if data_ implements IExternalAny (on_data_changed fires on_changed
                       ///< automatically).
 };
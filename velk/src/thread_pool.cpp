@@ -0,0 +1,228 @@
+#include "thread_pool.h"
+
+#include <velk/api/velk.h>
+
+#include <algorithm>
+
+namespace velk {
+
+namespace {
+
+// Pool and deque of the worker running on this thread, if any.
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+// A function posted with its cloned args.
+struct PostedCall
+{
+    IFunction::ConstPtr fn;
+    std::vector<IAny::Ptr> args;
+
+    static void run(void* context)
+    {
+        std::unique_ptr<PostedCall> call(static_cast<PostedCall*>(context));
+        std::vector<const IAny*> views(call->args.size());
+        for (size_t i = 0; i < views.size(); ++i) {
+            views[i] = call->args[i].get();
+        }
+        call->fn->invoke({views.data(), views.size()});
+    }
+};
+
+// A function run by async() and the future it resolves.
+struct AsyncCall
+{
+    IFunction::ConstPtr fn;
+    IFuture::Ptr future;
+
+    static void run(void* context)
+    {
+        std::unique_ptr<AsyncCall> call(static_cast<AsyncCall*>(context));
+        // Work whose future was cancelled while queued is dropped.
+        if (call->future->is_cancelled()) {
+            return;
+        }
+        auto result = call->fn->invoke({});
+        if (auto* internal = interface_cast<IFutureInternal>(call->future)) {
+            internal->set_result(std::move(result));
+        }
+    }
+};
+
+// The indices of a parallel_for(), shared by the calling thread and the helper tasks.
+struct ParallelJob
+{
+    void* context;
+    IExecutor::TaskFn task;
+    size_t count;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    // Runs indices until none are left.
+    void work()
+    {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+            task(context, i);
+            if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+                { std::lock_guard lock(mutex); }
+                finished.notify_all();
+            }
+        }
+    }
+
+    // Runs a helper task, whose context is a shared_ptr to the job.
+    static void run(void* context)
+    {
+        using Ref = std::shared_ptr<ParallelJob>;
+        std::unique_ptr<Ref> job(static_cast<Ref*>(context));
+        (*job)->work();
+    }
+};
+
+} // namespace
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+void ThreadPool::start(size_t count)
+{
+    if (!count) {
+        auto hardware = std::thread::hardware_concurrency();
+        count = hardware > 1 ? hardware - 1 : 1;
+    }
+    workers_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    // Started once all deques exist, as workers steal from each other.
+    for (size_t i = 0; i < count; ++i) {
+        workers_[i]->thread = std::thread([this, i] { run_worker(i); });
+    }
+}
+
+void ThreadPool::push(Task task)
+{
+    bool own = current_pool == this;
+    size_t index = own ? current_worker : next_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    auto& worker = *workers_[index];
+    {
+        std::lock_guard lock(worker.mutex);
+        if (own) {
+            worker.tasks.push_front(task);
+        } else {
+            worker.tasks.push_back(task);
+        }
+    }
+    // Sequentially consistent with the increment of sleeping_ in run_worker(): either the
+    // sleeper sees the task, or this sees the sleeper and wakes it.
+    queued_.fetch_add(1);
+    if (sleeping_.load()) {
+        { std::lock_guard lock(sleep_mutex_); }
+        wake_.notify_one();
+    }
+}
+
+bool ThreadPool::pop(size_t self, Task& task)
+{
+    size_t count = workers_.size();
+    for (size_t n = 0; n < count; ++n) {
+        size_t index = (self + n) % count;
+        auto& worker = *workers_[index];
+        std::lock_guard lock(worker.mutex);
+        if (worker.tasks.empty()) {
+            continue;
+        }
+        if (index == self) {
+            task = worker.tasks.front();
+            worker.tasks.pop_front();
+        } else {
+            task = worker.tasks.back();
+            worker.tasks.pop_back();
+        }
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run_worker(size_t index)
+{
+    current_pool = this;
+    current_worker = index;
+    for (;;) {
+        Task task;
+        if (pop(index, task)) {
+            task.run(task.context);
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex_);
+        sleeping_.fetch_add(1);
+        wake_.wait(lock, [this] { return stopping_ || queued_.load() > 0; });
+        sleeping_.fetch_sub(1);
+        // Tasks still queued at destruction run before the worker exits.
+        if (stopping_ && queued_.load() == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, void* context, TaskFn task)
+{
+    if (!task || !count) {
+        return;
+    }
+    if (count == 1 || workers_.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            task(context, i);
+        }
+        return;
+    }
+    auto job = std::make_shared<ParallelJob>();
+    job->context = context;
+    job->task = task;
+    job->count = count;
+    // Helpers that start after the calling thread ran the last index return at once.
+    size_t helpers = std::min(count - 1, workers_.size());
+    for (size_t i = 0; i < helpers; ++i) {
+        push({&ParallelJob::run, new std::shared_ptr<ParallelJob>(job)});
+    }
+    job->work();
+    std::unique_lock lock(job->mutex);
+    job->finished.wait(lock, [&] { return job->done.load(std::memory_order_acquire) == count; });
+}
+
+void ThreadPool::post(const IFunction::ConstPtr& fn, FnArgs args)
+{
+    if (!fn) {
+        return;
+    }
+    auto* call = new PostedCall{fn, {}};
+    call->args.reserve(args.count);
+    for (auto* arg : args) {
+        call->args.push_back(arg ? arg->clone() : nullptr);
+    }
+    push({&PostedCall::run, call});
+}
+
+IFuture::Ptr ThreadPool::async(const IFunction::ConstPtr& fn)
+{
+    if (!fn) {
+        return nullptr;
+    }
+    auto future = instance().create_future();
+    push({&AsyncCall::run, new AsyncCall{fn, future}});
+    return future;
+}
+
+} // namespace velk
@@ -0,0 +1,77 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <velk/ext/core_object.h>
+#include <velk/interface/intf_thread_pool.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief IThreadPool implementation with a work-stealing deque per worker.
+ *
+ * A worker takes tasks from the front of its own deque and, once that is empty, steals from the
+ * back of the others' deques. Workers with nothing to do sleep on one condition variable, which
+ * posters only signal when a worker is asleep.
+ *
+ * parallel_for() runs tasks on the calling thread as well, so get_concurrency() counts it.
+ */
+class ThreadPool final : public ext::ObjectCore<ThreadPool, IThreadPool>
+{
+public:
+    ThreadPool() = default;
+    ~ThreadPool() override;
+
+    /** @brief Starts @p count workers; 0 starts one per hardware thread but the calling one. */
+    void start(size_t count);
+
+public: // IExecutor
+    size_t get_concurrency() const override { return workers_.size() + 1; }
+    void parallel_for(size_t count, void* context, TaskFn task) override;
+
+public: // IThreadPool
+    size_t get_thread_count() const override { return workers_.size(); }
+    void post(const IFunction::ConstPtr& fn, FnArgs args) override;
+    IFuture::Ptr async(const IFunction::ConstPtr& fn) override;
+
+private:
+    // A unit of work. run() also frees context.
+    struct Task
+    {
+        void (*run)(void* context);
+        void* context;
+    };
+
+    struct alignas(64) Worker
+    {
+        std::mutex mutex;       // Guards tasks.
+        std::deque<Task> tasks; // Own tasks at the front, stolen from the back.
+        std::thread thread;     // Runs run_worker().
+    };
+
+    // Queues task, on the deque of the calling worker if it is one of ours.
+    void push(Task task);
+    // Takes a task from the deque of worker self, or steals one from another worker.
+    bool pop(size_t self, Task& task);
+    // Runs tasks until the pool is destroyed and no task is left.
+    void run_worker(size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers_; // Fixed once started.
+    std::atomic<size_t> queued_{0};                // Tasks in all deques.
+    std::atomic<size_t> sleeping_{0};              // Workers waiting on wake_.
+    std::atomic<size_t> next_{0};                  // Deque of the next task posted from elsewhere.
+    std::mutex sleep_mutex_;                       // Guards stopping_ and the waits on wake_.
+    std::condition_variable wake_;                 // Signalled when a task is queued.
+    bool stopping_ = false;                        // Set by the destructor.
+};
+
+} // namespace velk
+
+#endif // THREAD_POOL_H
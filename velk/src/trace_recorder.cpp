@@ -0,0 +1,244 @@
+#include "trace_recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace velk {
+
+namespace {
+
+struct ThreadSlot
+{
+    uint64_t generation = 0;
+    void* buffer = nullptr;
+};
+
+thread_local ThreadSlot t_slot;
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void write_json_string(std::FILE* file, const char* str, size_t length)
+{
+    std::fputc('"', file);
+    for (size_t i = 0; i < length; ++i) {
+        auto c = static_cast<unsigned char>(str[i]);
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', file);
+            std::fputc(c, file);
+        } else if (c < 0x20) {
+            std::fprintf(file, "\\u%04x", c);
+        } else {
+            std::fputc(c, file);
+        }
+    }
+    std::fputc('"', file);
+}
+
+void write_json_string(std::FILE* file, const char* str)
+{
+    write_json_string(file, str, std::strlen(str));
+}
+
+} // namespace
+
+TraceRecorder& TraceRecorder::get()
+{
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    stop();
+}
+
+void TraceRecorder::start(size_t capacity)
+{
+    {
+        std::lock_guard lock(mutex_);
+        retired_ = std::move(buffers_);
+        buffers_.clear();
+        capacity_ = capacity ? capacity : DEFAULT_CAPACITY;
+        start_.store(now_ns(), std::memory_order_relaxed);
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+    set_trace_backend(this);
+}
+
+void TraceRecorder::stop()
+{
+    if (get_trace_backend() == this) {
+        set_trace_backend(nullptr);
+    }
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::buffer()
+{
+    uint64_t generation = generation_.load(std::memory_order_acquire);
+    if (t_slot.generation == generation) {
+        return static_cast<ThreadBuffer*>(t_slot.buffer);
+    }
+    std::lock_guard lock(mutex_);
+    if (generation != generation_.load(std::memory_order_relaxed)) {
+        // A recording started meanwhile; the event belongs to the previous one.
+        return nullptr;
+    }
+    buffers_.push_back(std::make_unique<ThreadBuffer>(capacity_, static_cast<uint32_t>(buffers_.size() + 1)));
+    t_slot = {generation, buffers_.back().get()};
+    return buffers_.back().get();
+}
+
+void TraceRecorder::push(ThreadBuffer& buffer, Phase phase, const TraceZone* zone, const char* counter,
+                         int64_t value, string_view text) const
+{
+    // Sets every field, as the buffer is not initialized.
+    size_t index = buffer.size.load(std::memory_order_relaxed);
+    auto& event = buffer.events[index];
+    event.ns = now_ns() - start_.load(std::memory_order_relaxed);
+    event.zone = zone;
+    event.counter = counter;
+    event.value = value;
+    event.phase = phase;
+    size_t length = std::min(text.size(), TEXT_SIZE - 1);
+    if (length) {
+        // A zone without text passes a null data pointer, which memcpy must not get.
+        std::memcpy(event.text, text.data(), length);
+    }
+    event.text[length] = '\0';
+    buffer.size.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::begin_zone(const TraceZone& zone, string_view text)
+{
+    auto* b = buffer();
+    if (!b) {
+        return;
+    }
+    // Keeps room for the ends of the open zones and this one.
+    if (b->skipped || b->size.load(std::memory_order_relaxed) + b->open + 2 > b->capacity) {
+        ++b->skipped;
+        b->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    push(*b, Phase::Begin, &zone, nullptr, 0, text);
+    ++b->open;
+}
+
+void TraceRecorder::end_zone(const TraceZone& zone)
+{
+    auto* b = buffer();
+    if (!b) {
+        return;
+    }
+    if (b->skipped) {
+        --b->skipped;
+        return;
+    }
+    if (!b->open) {
+        // Begun in a previous recording.
+        return;
+    }
+    push(*b, Phase::End, &zone, nullptr, 0);
+    --b->open;
+}
+
+void TraceRecorder::counter(const char* name, int64_t value)
+{
+    auto* b = buffer();
+    if (!b) {
+        return;
+    }
+    if (b->size.load(std::memory_order_relaxed) + b->open + 1 > b->capacity) {
+        b->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    push(*b, Phase::Counter, nullptr, name, value);
+}
+
+void TraceRecorder::write_events(std::FILE* file, const ThreadBuffer& buffer, bool& first) const
+{
+    auto separate = [&] {
+        std::fputs(first ? "\n" : ",\n", file);
+        first = false;
+    };
+    separate();
+    std::fprintf(file,
+                 "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,"
+                 "\"args\":{\"name\":\"thread %u\"}}",
+                 buffer.tid,
+                 buffer.tid);
+
+    size_t size = buffer.size.load(std::memory_order_acquire);
+    for (size_t i = 0; i < size; ++i) {
+        const auto& event = buffer.events[i];
+        separate();
+        const char* phase = event.phase == Phase::Begin ? "B" : event.phase == Phase::End ? "E" : "C";
+        std::fprintf(file, "{\"ph\":\"%s\",\"name\":", phase);
+        write_json_string(file, event.zone ? event.zone->name : event.counter);
+        std::fprintf(file,
+                     ",\"cat\":\"velk\",\"pid\":1,\"tid\":%u,\"ts\":%lld.%03lld",
+                     buffer.tid,
+                     static_cast<long long>(event.ns / 1000),
+                     static_cast<long long>(event.ns % 1000));
+        if (event.phase == Phase::Begin) {
+            std::fputs(",\"args\":{\"file\":", file);
+            write_json_string(file, event.zone->file);
+            std::fprintf(file, ",\"line\":%d", event.zone->line);
+            if (event.text[0]) {
+                std::fputs(",\"text\":", file);
+                write_json_string(file, event.text);
+            }
+            std::fputc('}', file);
+        } else if (event.phase == Phase::Counter) {
+            std::fprintf(file, ",\"args\":{\"value\":%lld}", static_cast<long long>(event.value));
+        }
+        std::fputc('}', file);
+    }
+}
+
+bool TraceRecorder::write(const char* path) const
+{
+    if (!path || !generation_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    std::FILE* file = std::fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    size_t dropped = 0;
+    bool first = true;
+    std::fputs("{\"traceEvents\":[", file);
+    {
+        std::lock_guard lock(mutex_);
+        for (auto& buffer : buffers_) {
+            write_events(file, *buffer, first);
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    std::fprintf(
+        file, "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"droppedEvents\":\"%zu\"}}\n", dropped);
+    return std::fclose(file) == 0;
+}
+
+VELK_EXPORT void start_trace_recording(size_t capacity)
+{
+    TraceRecorder::get().start(capacity);
+}
+
+VELK_EXPORT void stop_trace_recording()
+{
+    TraceRecorder::get().stop();
+}
+
+VELK_EXPORT bool write_trace_recording(const char* path)
+{
+    return TraceRecorder::get().write(path);
+}
+
+} // namespace velk
@@ -0,0 +1,96 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <velk/trace.h>
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace velk {
+
+/**
+ * @brief ITraceBackend recording the events of each thread into a buffer of its own, behind
+ *        start_trace_recording() and write_trace_recording().
+ *
+ * A thread registers its buffer on its first event of a recording, under the lock; after that it
+ * appends without locking and publishes each event through the size of the buffer, so that
+ * write() can read a buffer while its thread keeps recording. Buffers never grow.
+ */
+class TraceRecorder final : public ITraceBackend
+{
+public:
+    /** @brief Returns the recorder of the process. */
+    static TraceRecorder& get();
+
+    ~TraceRecorder();
+
+    /** @brief Discards the current recording and starts one with @p capacity events per thread. */
+    void start(size_t capacity);
+    /** @brief Stops recording new zones, keeping the events. */
+    void stop();
+    /** @brief Writes the recorded events to @p path, see write_trace_recording(). */
+    bool write(const char* path) const;
+
+public: // ITraceBackend
+    void begin_zone(const TraceZone& zone, string_view text) override;
+    void end_zone(const TraceZone& zone) override;
+    void counter(const char* name, int64_t value) override;
+
+private:
+    static constexpr size_t DEFAULT_CAPACITY = 65536;
+    static constexpr size_t TEXT_SIZE = 24;
+
+    enum class Phase : uint8_t
+    {
+        Begin,
+        End,
+        Counter
+    };
+
+    struct Event
+    {
+        int64_t ns;            // Time since the start of the recording.
+        const TraceZone* zone; // Zone of a Begin or End.
+        const char* counter;   // Name of a Counter.
+        int64_t value;         // Value of a Counter.
+        Phase phase;
+        char text[TEXT_SIZE];  // Text of a Begin, truncated.
+    };
+
+    struct ThreadBuffer
+    {
+        ThreadBuffer(size_t capacity, uint32_t tid)
+            : events(new Event[capacity]), capacity(capacity), tid(tid) // Not zeroed, see push().
+        {}
+
+        std::unique_ptr<Event[]> events;
+        size_t capacity;
+        uint32_t tid;                    // Thread id in the trace.
+        std::atomic<size_t> size{0};     // Published events.
+        std::atomic<size_t> dropped{0};
+        size_t open = 0;                 // Recorded zones not ended yet.
+        size_t skipped = 0;              // Dropped zones not ended yet, nested in the open ones.
+    };
+
+    // Returns the buffer of the calling thread in the current recording, or null.
+    ThreadBuffer* buffer();
+    // Appends and publishes an event to buffer, which the caller checked has room for it.
+    void push(ThreadBuffer& buffer, Phase phase, const TraceZone* zone, const char* counter, int64_t value,
+              string_view text = {}) const;
+    // Writes the events of buffer to file.
+    void write_events(std::FILE* file, const ThreadBuffer& buffer, bool& first) const;
+
+    mutable std::mutex mutex_;                           // Guards the containers and capacity_.
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+    std::vector<std::unique_ptr<ThreadBuffer>> retired_; // Of the previous recording, for late events.
+    size_t capacity_ = DEFAULT_CAPACITY;
+    std::atomic<uint64_t> generation_{0};                // Of the current recording, 0 before the first.
+    std::atomic<int64_t> start_{0};                      // Start of the recording, in steady clock ns.
+};
+
+} // namespace velk
+
+#endif // TRACE_RECORDER_H
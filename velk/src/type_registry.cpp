@@ -2,12 +2,17 @@
 
 #include "array_property.h"
 #include "event.h"
+#include "flat_hierarchy.h"
 #include "function.h"
 #include "future.h"
 #include "hierarchy.h"
+#include "hive/hive_snapshot_mapping.h"
 #include "hive/hive_store.h"
+#include "hive/numa_page_source.h"
 #include "hive/object_hive.h"
+#include "hive/partitioned_object_hive.h"
 #include "hive/raw_hive.h"
+#include "hive/virtual_memory_page_source.h"
 #include "property.h"
 
 #include <velk/ext/any.h>
@@ -18,88 +23,105 @@
 
 namespace velk {
 
+namespace {
+
+// Owner of the types registered on this thread, set while a plugin initializes. Per thread, so
+// that plugins initializing concurrently each own the types they register.
+thread_local Uid t_owner;
+
+} // namespace
+
 TypeRegistry::TypeRegistry(ILog& log) : log_(log)
 {
-    ITypeRegistry::register_type<PropertyImpl>();
-    ITypeRegistry::register_type<ArrayPropertyImpl>();
-    ITypeRegistry::register_type<FunctionImpl>();
-    ITypeRegistry::register_type<EventImpl>();
-    ITypeRegistry::register_type<FutureImpl>();
-    ITypeRegistry::register_type<HiveStore>();
-    ITypeRegistry::register_type<ObjectHive>();
-    ITypeRegistry::register_type<RawHiveImpl>();
-    ITypeRegistry::register_type<HierarchyImpl>();
-
-    ITypeRegistry::register_type<ext::AnyValue<float>>();
-    ITypeRegistry::register_type<ext::AnyValue<double>>();
-    ITypeRegistry::register_type<ext::AnyValue<uint8_t>>();
-    ITypeRegistry::register_type<ext::AnyValue<uint16_t>>();
-    ITypeRegistry::register_type<ext::AnyValue<uint32_t>>();
-    ITypeRegistry::register_type<ext::AnyValue<uint64_t>>();
-    ITypeRegistry::register_type<ext::AnyValue<int8_t>>();
-    ITypeRegistry::register_type<ext::AnyValue<int16_t>>();
-    ITypeRegistry::register_type<ext::AnyValue<int32_t>>();
-    ITypeRegistry::register_type<ext::AnyValue<int64_t>>();
-    ITypeRegistry::register_type<ext::AnyValue<string>>();
-    ITypeRegistry::register_type<ext::AnyValue<Duration>>();
-
-    ITypeRegistry::register_type<ext::ArrayAnyValue<float>>();
-    ITypeRegistry::register_type<ext::ArrayAnyValue<double>>();
-    ITypeRegistry::register_type<ext::ArrayAnyValue<uint8_t>>();
-    ITypeRegistry::register_type<ext::ArrayAnyValue<uint16_t>>();
-    ITypeRegistry::register_type<ext::ArrayAnyValue<uint32_t>>();
-    ITypeRegistry::register_type<ext::ArrayAnyValue<uint64_t>>();
-    ITypeRegistry::register_type<ext::ArrayAnyValue<int8_t>>();
-    ITypeRegistry::register_type<ext::ArrayAnyValue<int16_t>>();
-    ITypeRegistry::register_type<ext::ArrayAnyValue<int32_t>>();
-    ITypeRegistry::register_type<ext::ArrayAnyValue<int64_t>>();
-    ITypeRegistry::register_type<ext::ArrayAnyValue<string>>();
+    ITypeRegistry::register_types<PropertyImpl,
+                                  ArrayPropertyImpl,
+                                  FunctionImpl,
+                                  EventImpl,
+                                  FutureImpl,
+                                  HiveStore,
+                                  ObjectHive,
+                                  PartitionedObjectHive,
+                                  RawHiveImpl,
+                                  VirtualMemoryPageSource,
+                                  NumaPageSource,
+                                  HiveSnapshotMapping,
+                                  HierarchyImpl,
+                                  FlatHierarchyImpl,
+
+                                  ext::AnyValue<float>,
+                                  ext::AnyValue<double>,
+                                  ext::AnyValue<uint8_t>,
+                                  ext::AnyValue<uint16_t>,
+                                  ext::AnyValue<uint32_t>,
+                                  ext::AnyValue<uint64_t>,
+                                  ext::AnyValue<int8_t>,
+                                  ext::AnyValue<int16_t>,
+                                  ext::AnyValue<int32_t>,
+                                  ext::AnyValue<int64_t>,
+                                  ext::AnyValue<string>,
+                                  ext::AnyValue<Duration>,
+
+                                  ext::ArrayAnyValue<float>,
+                                  ext::ArrayAnyValue<double>,
+                                  ext::ArrayAnyValue<uint8_t>,
+                                  ext::ArrayAnyValue<uint16_t>,
+                                  ext::ArrayAnyValue<uint32_t>,
+                                  ext::ArrayAnyValue<uint64_t>,
+                                  ext::ArrayAnyValue<int8_t>,
+                                  ext::ArrayAnyValue<int16_t>,
+                                  ext::ArrayAnyValue<int32_t>,
+                                  ext::ArrayAnyValue<int64_t>,
+                                  ext::ArrayAnyValue<string>>();
 }
 
-const IObjectFactory* TypeRegistry::find(Uid uid) const
+ReturnValue TypeRegistry::register_type(const IObjectFactory& factory)
 {
-    Entry key{uid, nullptr};
-    auto it = std::lower_bound(types_.begin(), types_.end(), key);
-    if (it != types_.end() && it->uid == uid) {
-        return it->factory;
-    }
-    return nullptr;
+    const IObjectFactory* factories[] = {&factory};
+    return register_types({factories, 1});
 }
 
-ReturnValue TypeRegistry::register_type(const IObjectFactory& factory)
+ReturnValue TypeRegistry::register_types(array_view<const IObjectFactory*> factories)
 {
-    auto& info = factory.get_class_info();
-    detail::velk_log(log_,
-                     LogLevel::Debug,
-                     __FILE__,
-                     __LINE__,
-                     "Register %.*s",
-                     static_cast<int>(info.name.size()),
-                     info.name.data());
-    Entry entry{info.uid, &factory, current_owner_};
-    auto it = std::lower_bound(types_.begin(), types_.end(), entry);
-    if (it != types_.end() && it->uid == info.uid) {
-        it->factory = &factory;
-        it->owner = current_owner_;
-    } else {
-        types_.insert(it, entry);
+    for (auto* factory : factories) {
+        if (!factory) {
+            return ReturnValue::InvalidArgument;
+        }
+    }
+    // Names are only looked up with debug logging on, as velk_log() filters before formatting.
+    if (detail::log_compiled(LogLevel::Debug) && log_.get_level() <= LogLevel::Debug) {
+        for (auto* factory : factories) {
+            auto& info = factory->get_class_info();
+            detail::velk_log(log_,
+                             LogLevel::Debug,
+                             __FILE__,
+                             __LINE__,
+                             "Register %.*s",
+                             static_cast<int>(info.name.size()),
+                             info.name.data());
+        }
+    }
+    std::unique_lock lock(mutex_);
+    types_.reserve_entries(factories.size());
+    for (auto* factory : factories) {
+        types_.set(factory->get_class_info().uid, factory, t_owner);
     }
     return ReturnValue::Success;
 }
 
 ReturnValue TypeRegistry::unregister_type(const IObjectFactory& factory)
 {
-    Entry key{factory.get_class_info().uid, nullptr};
-    auto it = std::lower_bound(types_.begin(), types_.end(), key);
-    if (it != types_.end() && it->uid == key.uid) {
-        types_.erase(it);
-    }
+    std::unique_lock lock(mutex_);
+    types_.set(factory.get_class_info().uid, nullptr, {});
     return ReturnValue::Success;
 }
 
 IInterface::Ptr TypeRegistry::create(Uid uid, uint32_t flags) const
 {
-    if (auto* factory = find(uid)) {
+    auto* factory = find(uid);
+    if (!factory && missing_hook_ && missing_hook_(missing_context_, uid)) {
+        factory = find(uid);
+    }
+    if (factory) {
         auto object = factory->create_instance(flags);
         if (!object) {
             VELK_LOG(
@@ -124,28 +146,38 @@ const IObjectFactory* TypeRegistry::find_factory(Uid classUid) const
     return find(classUid);
 }
 
-void TypeRegistry::set_owner(Uid uid)
+FactoryHandle TypeRegistry::get_factory_handle(Uid classUid) const
+{
+    return FactoryHandle(types_.find_slot(classUid));
+}
+
+Uid TypeRegistry::set_owner(Uid uid)
 {
-    current_owner_ = uid;
+    Uid previous = t_owner;
+    t_owner = uid;
+    return previous;
 }
 
 void TypeRegistry::sweep_owner(Uid uid)
 {
-    types_.erase(std::remove_if(types_.begin(), types_.end(), [&](const Entry& e) { return e.owner == uid; }),
-                 types_.end());
+    std::unique_lock lock(mutex_);
+    types_.remove_owner(uid);
     interpolators_.erase(std::remove_if(interpolators_.begin(),
                                         interpolators_.end(),
                                         [&](const InterpolatorEntry& e) { return e.owner == uid; }),
                          interpolators_.end());
 }
 
-ReturnValue TypeRegistry::register_interpolator(Uid typeUid, InterpolatorFn fn)
+ReturnValue TypeRegistry::register_interpolator(Uid typeUid, InterpolatorFn fn, RawInterpolatorFn raw)
 {
-    InterpolatorEntry entry{typeUid, fn, current_owner_};
+    std::unique_lock lock(mutex_);
+    InterpolatorEntry entry{typeUid, fn, raw, t_owner};
     auto it = std::lower_bound(interpolators_.begin(), interpolators_.end(), entry);
     if (it != interpolators_.end() && it->typeUid == typeUid) {
         it->fn = fn;
-        it->owner = current_owner_;
+        // A replacement without a raw function must not keep the one of the previous interpolator.
+        it->raw = raw;
+        it->owner = t_owner;
     } else {
         interpolators_.insert(it, entry);
     }
@@ -154,7 +186,8 @@ ReturnValue TypeRegistry::register_interpolator(Uid typeUid, InterpolatorFn fn)
 
 ReturnValue TypeRegistry::unregister_interpolator(Uid typeUid)
 {
-    InterpolatorEntry key{typeUid, nullptr, {}};
+    std::unique_lock lock(mutex_);
+    InterpolatorEntry key{typeUid, nullptr, nullptr, {}};
     auto it = std::lower_bound(interpolators_.begin(), interpolators_.end(), key);
     if (it != interpolators_.end() && it->typeUid == typeUid) {
         interpolators_.erase(it);
@@ -165,7 +198,8 @@ ReturnValue TypeRegistry::unregister_interpolator(Uid typeUid)
 
 InterpolatorFn TypeRegistry::find_interpolator(Uid typeUid) const
 {
-    InterpolatorEntry key{typeUid, nullptr, {}};
+    std::shared_lock lock(mutex_);
+    InterpolatorEntry key{typeUid, nullptr, nullptr, {}};
     auto it = std::lower_bound(interpolators_.begin(), interpolators_.end(), key);
     if (it != interpolators_.end() && it->typeUid == typeUid) {
         return it->fn;
@@ -173,4 +207,15 @@ InterpolatorFn TypeRegistry::find_interpolator(Uid typeUid) const
     return nullptr;
 }
 
+RawInterpolatorFn TypeRegistry::find_raw_interpolator(Uid typeUid) const
+{
+    std::shared_lock lock(mutex_);
+    InterpolatorEntry key{typeUid, nullptr, nullptr, {}};
+    auto it = std::lower_bound(interpolators_.begin(), interpolators_.end(), key);
+    if (it != interpolators_.end() && it->typeUid == typeUid) {
+        return it->raw;
+    }
+    return nullptr;
+}
+
 } // namespace velk
@@ -1,10 +1,13 @@
 #ifndef VELK_TYPE_REGISTRY_H
 #define VELK_TYPE_REGISTRY_H
 
+#include "factory_table.h"
+
 #include <velk/ext/interface_dispatch.h>
 #include <velk/interface/intf_log.h>
 #include <velk/interface/intf_type_registry.h>
 
+#include <shared_mutex>
 #include <vector>
 
 namespace velk {
@@ -12,7 +15,10 @@ namespace velk {
 /**
  * @brief Concrete implementation of ITypeRegistry.
  *
- * Maintains a sorted vector of type factories keyed by class UID.
+ * Keeps the class factories in a FactoryTable, which create(), find_factory() and
+ * get_class_info() read without locking, so that they are safe on any thread while plugins
+ * register types. The interpolators are kept in a sorted vector behind a shared mutex.
+ * Registration takes the mutex exclusively.
  * Owned as a stack member by VelkInstance.
  */
 class TypeRegistry final : public ext::InterfaceDispatch<ITypeRegistry>
@@ -22,45 +28,55 @@ public:
 
     // ITypeRegistry overrides
     ReturnValue register_type(const IObjectFactory& factory) override;
+    ReturnValue register_types(array_view<const IObjectFactory*> factories) override;
     ReturnValue unregister_type(const IObjectFactory& factory) override;
     const ClassInfo* get_class_info(Uid classUid) const override;
     const IObjectFactory* find_factory(Uid classUid) const override;
-    ReturnValue register_interpolator(Uid typeUid, InterpolatorFn fn) override;
+    FactoryHandle get_factory_handle(Uid classUid) const override;
+    ReturnValue register_interpolator(Uid typeUid, InterpolatorFn fn, RawInterpolatorFn raw) override;
     ReturnValue unregister_interpolator(Uid typeUid) override;
     InterpolatorFn find_interpolator(Uid typeUid) const override;
+    RawInterpolatorFn find_raw_interpolator(Uid typeUid) const override;
 
     /** @brief Creates an instance of a registered type by its UID. */
     IInterface::Ptr create(Uid uid, uint32_t flags = ObjectFlags::None) const;
-    /** @brief Sets the current owner context for subsequent register_type calls. */
-    void set_owner(Uid uid);
+    /**
+     * @brief Sets the owner of the types the calling thread registers from now on.
+     * @return The previous owner, to restore once the plugin has initialized.
+     */
+    Uid set_owner(Uid uid);
     /** @brief Erases all entries owned by the given plugin UID. */
     void sweep_owner(Uid uid);
-
-private:
-    /** @brief Registry entry mapping a class UID to its factory. */
-    struct Entry
+    /**
+     * @brief Sets a function create() calls for a class UID that is not registered, before it
+     *        fails. The function returns true if it may have registered the class, e.g. by
+     *        loading a plugin, in which case create() looks again.
+     */
+    void set_missing_type_hook(bool (*hook)(void* context, Uid uid), void* context)
     {
-        Uid uid;                       ///< Class UID.
-        const IObjectFactory* factory; ///< Factory that creates instances of this class.
-        Uid owner;                     ///< Plugin that registered this type (Uid{} = builtin).
-        bool operator<(const Entry& o) const { return uid < o.uid; }
-    };
+        missing_hook_ = hook;
+        missing_context_ = context;
+    }
 
+private:
     /** @brief Finds the factory for the given class UID, or nullptr if not registered. */
-    const IObjectFactory* find(Uid uid) const;
+    const IObjectFactory* find(Uid uid) const { return types_.find(uid); }
 
-    /** @brief Registry entry mapping a type UID to its interpolator function. */
+    /** @brief Registry entry mapping a type UID to its interpolator functions. */
     struct InterpolatorEntry
     {
         Uid typeUid;
         InterpolatorFn fn;
+        RawInterpolatorFn raw;
         Uid owner;
         bool operator<(const InterpolatorEntry& o) const { return typeUid < o.typeUid; }
     };
 
-    std::vector<Entry> types_;                     ///< Sorted registry of class factories.
+    FactoryTable types_;                           ///< Class factories by class UID.
     std::vector<InterpolatorEntry> interpolators_; ///< Sorted registry of interpolator functions.
-    Uid current_owner_;                            ///< Owner context for type registration.
+    mutable std::shared_mutex mutex_;              ///< Serializes changes; guards interpolators_.
+    bool (*missing_hook_)(void*, Uid){};           ///< See set_missing_type_hook().
+    void* missing_context_{};
     ILog& log_;
 };
 
@@ -1,9 +1,23 @@
 #include "velk_instance.h"
 
+#include <velk/allocator.h>
+#include <velk/arena.h>
+#include <velk/trace.h>
 #include <velk/velk_export.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdarg>
 #include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
 namespace velk {
 
@@ -16,6 +30,9 @@ VELK_EXPORT IVelk& instance()
 
 VELK_EXPORT void detail::velk_log(ILog& log, LogLevel level, const char* file, int line, const char* fmt, ...)
 {
+    if (level < log.get_level()) {
+        return;
+    }
     char buf[1024];
     va_list args;
     va_start(args, fmt);
@@ -24,11 +41,417 @@ VELK_EXPORT void detail::velk_log(ILog& log, LogLevel level, const char* file, i
     log.dispatch(level, file, line, buf);
 }
 
+// Allocator
+//
+// g_allocator is constant-initialized, so it is usable during static initialization.
+// g_allocated is set by the first allocation and makes set_allocator() fail from then on.
+
+namespace {
+
+std::atomic<IAllocator*> g_allocator{nullptr};
+std::atomic<bool> g_allocated{false};
+
+bool is_overaligned(size_t alignment)
+{
+    return alignment > alignof(std::max_align_t);
+}
+
+static_assert(alignof(external_control_block) == alignof(control_block));
+
+constexpr size_t memory_categories = static_cast<size_t>(MemoryCategory::Count);
+
+// Live memory per MemoryCategory, as bytes followed by counts. With the block pool enabled each
+// thread counts into the cells of its pool, which only that thread writes, and g_memory holds
+// what threads without a pool counted and what exited threads left behind.
+struct memory_cells
+{
+    std::atomic<ptrdiff_t> bytes[memory_categories]{};
+    std::atomic<ptrdiff_t> count[memory_categories]{};
+
+    // Adds to cells written by one thread only, which needs no atomic read-modify-write.
+    void add_single_writer(size_t category, ptrdiff_t b, ptrdiff_t c)
+    {
+        bytes[category].store(bytes[category].load(std::memory_order_relaxed) + b, std::memory_order_relaxed);
+        count[category].store(count[category].load(std::memory_order_relaxed) + c, std::memory_order_relaxed);
+    }
+    void add_shared(size_t category, ptrdiff_t b, ptrdiff_t c)
+    {
+        bytes[category].fetch_add(b, std::memory_order_relaxed);
+        count[category].fetch_add(c, std::memory_order_relaxed);
+    }
+};
+
+memory_cells g_memory;
+
+void add_cells(MemoryStats& stats, const memory_cells& cells)
+{
+    for (size_t i = 0; i < memory_categories; ++i) {
+        // The sums are unsigned, so a negative cell still adds up to the right total.
+        stats.categories[i].bytes += static_cast<size_t>(cells.bytes[i].load(std::memory_order_relaxed));
+        stats.categories[i].count += static_cast<size_t>(cells.count[i].load(std::memory_order_relaxed));
+    }
+}
+
+// A free on one thread may be counted before the allocation it releases on another.
+MemoryStats clamp_negative(MemoryStats stats)
+{
+    for (auto& counter : stats.categories) {
+        if (static_cast<ptrdiff_t>(counter.bytes) < 0) {
+            counter.bytes = 0;
+        }
+        if (static_cast<ptrdiff_t>(counter.count) < 0) {
+            counter.count = 0;
+        }
+    }
+    return stats;
+}
+
+template <class Block>
+Block* new_block()
+{
+    detail::track_memory(MemoryCategory::ControlBlocks, sizeof(Block), 1);
+    return new (detail::velk_alloc(sizeof(Block), alignof(control_block), MemoryTag::ControlBlocks)) Block;
+}
+
+// Control blocks are trivially destructible, so they are freed without running a destructor.
+template <class Block>
+void delete_block(Block* block)
+{
+    detail::track_memory(MemoryCategory::ControlBlocks, -static_cast<ptrdiff_t>(sizeof(Block)), -1);
+    detail::velk_free(block, alignof(control_block), MemoryTag::ControlBlocks);
+}
+
+} // anonymous namespace
+
+VELK_EXPORT bool set_allocator(IAllocator* allocator)
+{
+    if (g_allocated.load(std::memory_order_acquire)) {
+        return false;
+    }
+    g_allocator.store(allocator, std::memory_order_release);
+    return true;
+}
+
+VELK_EXPORT IAllocator* get_allocator()
+{
+    return g_allocator.load(std::memory_order_acquire);
+}
+
+// Tracing
+
+namespace {
+
+std::atomic<ITraceBackend*> g_trace_backend{nullptr};
+
+} // anonymous namespace
+
+VELK_EXPORT void set_trace_backend(ITraceBackend* backend)
+{
+    g_trace_backend.store(backend, std::memory_order_release);
+}
+
+VELK_EXPORT ITraceBackend* get_trace_backend()
+{
+    return g_trace_backend.load(std::memory_order_acquire);
+}
+
+VELK_EXPORT void* detail::velk_alloc(size_t size, size_t alignment, MemoryTag tag)
+{
+    if (!g_allocated.load(std::memory_order_relaxed)) {
+        g_allocated.store(true, std::memory_order_release);
+    }
+    if (auto* allocator = g_allocator.load(std::memory_order_acquire)) {
+        return allocator->allocate(size, alignment, tag);
+    }
+    if (!is_overaligned(alignment)) {
+        return std::malloc(size);
+    }
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    // aligned_alloc() requires the size to be a multiple of the alignment.
+    return std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+}
+
+VELK_EXPORT void detail::velk_free(void* ptr, size_t alignment, MemoryTag tag)
+{
+    if (!ptr) {
+        return;
+    }
+    if (auto* allocator = g_allocator.load(std::memory_order_acquire)) {
+        allocator->deallocate(ptr, alignment, tag);
+        return;
+    }
+#ifdef _WIN32
+    if (is_overaligned(alignment)) {
+        _aligned_free(ptr);
+        return;
+    }
+#endif
+    std::free(ptr);
+}
+
+// A trivially destructible thread_local, so it has no cleanup concerns at DLL unload.
+VELK_EXPORT uint32_t detail::current_thread_tag()
+{
+    static std::atomic<uint32_t> next{0};
+    thread_local uint32_t tag = 0;
+    if (!tag) {
+        tag = next.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    return tag;
+}
+
+// Reclaim scopes
+//
+// Epoch-based: each thread that opens a scope or retires an object claims a record. A reader
+// publishes the global epoch in its record when it enters its outermost scope, issues a
+// seq_cst fence and only then loads the strong count of the objects it peeks at. A releasing
+// thread drops the strong count to zero, issues a seq_cst fence and then scans the records. At
+// least one side sees the other, so an object a reader saw alive is retired rather than
+// destroyed. The retired object is stamped with the global epoch and kept in the record of the
+// releasing thread, which destroys it once every open scope has a later epoch, that is once the
+// readers that could have seen it left their scopes. Scopes opened later do not hold it back,
+// so overlapping scopes do not delay it indefinitely, and a release only touches the list of
+// its own thread. A thread that exits with objects still retired hands its record back, and the
+// next thread that leaves a scope or claims the record destroys them.
+//
+// The records are a constant-initialized array, so that the scan of a release reads adjacent
+// cache lines rather than chasing pointers, and releases during static initialization and
+// destruction remain safe.
+
+namespace {
+
+struct retired_object
+{
+    void (*destroy)(void*);
+    void* object;
+    uint64_t epoch; ///< Global epoch when the object was retired.
+};
+
+/** @brief Reclaim state of one thread. */
+struct alignas(64) reclaim_thread
+{
+    std::atomic<uint64_t> epoch{0}; ///< Epoch of the outermost open scope, 0 outside scopes.
+    std::atomic<bool> in_use{false}; ///< Claimed by a thread.
+    bool reclaiming{false};          ///< Set while reclaim_retired() runs destructors.
+    uint32_t depth{0};               ///< Nesting depth of the open scopes.
+    /// Objects retired by the owning thread. Allocated on first use and kept for later owners.
+    std::vector<retired_object>* retired{nullptr};
+
+    bool has_retired() const { return retired && !retired->empty(); }
+};
+
+/** @brief Number of threads that may hold a record at the same time. */
+constexpr uint32_t max_reclaim_threads = 1024;
+
+std::atomic<uint64_t> g_reclaim_epoch{1};
+reclaim_thread g_reclaim_threads[max_reclaim_threads];
+/// One past the highest record ever claimed; the scans stop there.
+std::atomic<uint32_t> g_reclaim_thread_end{0};
+/// Released records that still hold retired objects.
+std::atomic<uint32_t> g_abandoned_records{0};
+
+// Trivially destructible, so they remain usable after the exit guard of the thread ran.
+thread_local reclaim_thread* t_reclaim = nullptr;
+thread_local bool t_reclaim_exited = false;
+
+/** @brief Returns the oldest epoch of the scopes open on any thread, or UINT64_MAX if none is. */
+uint64_t oldest_scope_epoch()
+{
+    uint64_t oldest = UINT64_MAX;
+    uint32_t end = g_reclaim_thread_end.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < end; ++i) {
+        uint64_t epoch = g_reclaim_threads[i].epoch.load(std::memory_order_acquire);
+        if (epoch && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    return oldest;
+}
+
+/** @brief Destroys the objects retired by @p self that no open scope can refer to any more. */
+void reclaim_retired(reclaim_thread& self)
+{
+    if (!self.has_retired() || self.reclaiming) {
+        return;
+    }
+    // Scopes opened from now on cannot hold back the objects retired so far.
+    g_reclaim_epoch.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest = oldest_scope_epoch();
+    auto& retired = *self.retired;
+    auto kept = std::stable_partition(retired.begin(), retired.end(),
+                                      [oldest](const retired_object& r) { return r.epoch >= oldest; });
+    if (kept == retired.end()) {
+        return;
+    }
+    // Destructors may retire further objects into the list.
+    std::vector<retired_object> expired(kept, retired.end());
+    retired.erase(kept, retired.end());
+    self.reclaiming = true;
+    for (auto& r : expired) {
+        r.destroy(r.object);
+    }
+    self.reclaiming = false;
+}
+
+/** @brief Claims the record at @p index if it is free. */
+bool try_claim(reclaim_thread& record)
+{
+    bool free = false;
+    return !record.in_use.load(std::memory_order_relaxed) &&
+           record.in_use.compare_exchange_strong(free, true, std::memory_order_acquire);
+}
+
+/** @brief Moves the objects retired in the released records to @p self. */
+void adopt_abandoned(reclaim_thread& self)
+{
+    uint32_t end = g_reclaim_thread_end.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < end; ++i) {
+        auto& record = g_reclaim_threads[i];
+        if (!try_claim(record)) {
+            continue;
+        }
+        if (record.has_retired()) {
+            if (!self.retired) {
+                self.retired = new std::vector<retired_object>;
+            }
+            self.retired->insert(self.retired->end(), record.retired->begin(), record.retired->end());
+            record.retired->clear();
+            g_abandoned_records.fetch_sub(1, std::memory_order_relaxed);
+        }
+        record.in_use.store(false, std::memory_order_release);
+    }
+}
+
+/** @brief Hands the record of a thread back when the thread exits. */
+void release_reclaim_thread(reclaim_thread& self)
+{
+    reclaim_retired(self);
+    if (self.has_retired()) {
+        g_abandoned_records.fetch_add(1, std::memory_order_relaxed);
+    }
+    self.in_use.store(false, std::memory_order_release);
+}
+
+struct reclaim_thread_exit
+{
+    ~reclaim_thread_exit()
+    {
+        if (auto* self = t_reclaim) {
+            t_reclaim = nullptr;
+            release_reclaim_thread(*self);
+        }
+        t_reclaim_exited = true;
+    }
+};
+
+/** @brief Returns the record of the calling thread, claiming a free one on first use. */
+reclaim_thread& current_reclaim_thread()
+{
+    if (t_reclaim) {
+        return *t_reclaim;
+    }
+    reclaim_thread* self = nullptr;
+    while (!self) {
+        for (uint32_t i = 0; i < max_reclaim_threads; ++i) {
+            if (try_claim(g_reclaim_threads[i])) {
+                self = &g_reclaim_threads[i];
+                // Published before the thread can open a scope, so the scans include the record.
+                uint32_t end = g_reclaim_thread_end.load(std::memory_order_relaxed);
+                while (end <= i && !g_reclaim_thread_end.compare_exchange_weak(end, i + 1)) {
+                }
+                break;
+            }
+        }
+        if (!self) {
+            // Every record is held; one frees up when its thread exits.
+            std::this_thread::yield();
+        }
+    }
+    if (self->has_retired()) {
+        // Claimed with the objects its previous thread left; they are this thread's now.
+        g_abandoned_records.fetch_sub(1, std::memory_order_relaxed);
+    }
+    t_reclaim = self;
+    // Releases after the exit guard of the thread ran, e.g. from other thread_local
+    // destructors, claim a record that is handed back as soon as it is done with.
+    if (!t_reclaim_exited) {
+        thread_local reclaim_thread_exit guard;
+        (void)guard;
+    }
+    return *self;
+}
+
+/** @brief Hands the record back if the exit guard of the calling thread already ran. */
+void release_if_exited(reclaim_thread& self)
+{
+    if (t_reclaim_exited && !self.depth) {
+        t_reclaim = nullptr;
+        release_reclaim_thread(self);
+    }
+}
+
+} // anonymous namespace
+
+VELK_EXPORT void detail::enter_reclaim_scope()
+{
+    auto& self = current_reclaim_thread();
+    if (self.depth++) {
+        return;
+    }
+    // Release: a releasing thread that reads this epoch has seen the reads of earlier scopes.
+    self.epoch.store(g_reclaim_epoch.load(std::memory_order_relaxed), std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+VELK_EXPORT void detail::leave_reclaim_scope()
+{
+    auto& self = current_reclaim_thread();
+    if (--self.depth) {
+        return;
+    }
+    self.epoch.store(0, std::memory_order_release);
+    if (g_abandoned_records.load(std::memory_order_relaxed)) {
+        adopt_abandoned(self);
+    }
+    reclaim_retired(self);
+    release_if_exited(self);
+}
+
+VELK_EXPORT bool detail::retire_object(void (*destroy)(void*), void* object)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (oldest_scope_epoch() == UINT64_MAX) {
+        // Objects retired earlier by this thread can go too.
+        if (auto* self = t_reclaim; self && self->has_retired()) {
+            reclaim_retired(*self);
+        }
+        return false;
+    }
+    auto& self = current_reclaim_thread();
+    if (!self.retired) {
+        self.retired = new std::vector<retired_object>;
+    }
+    self.retired->push_back({destroy, object, g_reclaim_epoch.load(std::memory_order_relaxed)});
+    // Outside its own scopes the thread also destroys what the readers have moved past since. The
+    // list thus holds at most the objects this thread released during the longest open scope.
+    if (!self.depth) {
+        reclaim_retired(self);
+        release_if_exited(self);
+    }
+    return true;
+}
+
 // Control-block pool
 //
 // Each thread keeps a free-list of recycled control_blocks to avoid hitting
 // the global allocator on every shared_ptr create/destroy. Pooled alloc is
-// ~2.5x faster than new/delete in benchmarks.
+// ~2.5x faster than new/delete in benchmarks. Full pools move batches of
+// blocks to a shared depot that empty pools refill from, so blocks freed on
+// one thread are reused by threads that allocate them.
 //
 // Use platform TLS APIs (FLS on Windows, pthread_key on POSIX) instead of
 // C++ thread_local for two reasons:
@@ -57,32 +480,407 @@ VELK_EXPORT void detail::velk_log(ILog& log, LogLevel level, const char* file, i
 
 namespace {
 
-// Limit our pool max size to 256 control blocks (4kB at 16B/block)
-constexpr int32_t block_pool_max_size = 256;
+// Capacity of a thread's pool until set_block_pool_config() changes it, 256 control blocks (4kB at
+// 16B/block).
+constexpr int32_t block_pool_default_capacity = 256;
 
-struct block_pool
+// A full pool hands this many blocks to the depot at once, and an empty pool takes as many back.
+constexpr int32_t block_batch_size = 128;
+constexpr size_t block_depot_slots = 32;
+
+// BlockPoolConfig, read by each pool when it overflows or checks for idle blocks.
+std::atomic<int32_t> g_pool_capacity{block_pool_default_capacity};
+std::atomic<int32_t> g_pool_max_capacity{0};
+std::atomic<uint32_t> g_pool_idle_updates{BlockPoolConfig{}.idleUpdates};
+
+// Advanced by every update(); a pool that sees it change counts the update() calls it was idle for.
+std::atomic<uint32_t> g_pool_epoch{0};
+
+// Object memory is recycled in buckets of 16 bytes, up to 512 bytes; larger objects are not.
+constexpr size_t recycle_granularity = 16;
+constexpr size_t recycle_buckets = 32;
+
+// Advanced by trim_recycled_objects(); a pool that sees it change frees its recycled memory.
+std::atomic<uint32_t> g_recycle_trims{0};
+
+template <class Block>
+Block* next_block(Block* block)
+{
+    return static_cast<Block*>(static_cast<control_block*>(block->get_ptr()));
+}
+
+template <class Block>
+void track_pooled(ptrdiff_t count)
+{
+    detail::track_memory(MemoryCategory::PooledControlBlocks, count * static_cast<ptrdiff_t>(sizeof(Block)),
+                         count);
+}
+
+// Singly-linked free-list that reuses the block's ptr field as the next pointer.
+template <class Block>
+struct block_list
 {
-    control_block* head{nullptr};
+    Block* head{nullptr};
     int32_t size{0};
-    external_control_block* ext_head{nullptr};
-    int32_t ext_size{0};
+    int32_t low{0}; // Smallest size since the pool last checked for idle blocks.
+
+    Block* pop()
+    {
+        auto* block = head;
+        head = next_block(block);
+        if (--size < low) {
+            low = size;
+        }
+        return block;
+    }
+    void push(Block* block)
+    {
+        block->set_ptr(head);
+        head = block;
+        ++size;
+    }
+    // Frees the first @p count blocks.
+    void release(int32_t count)
+    {
+        track_pooled<Block>(-count);
+        for (int32_t i = 0; i < count; ++i) {
+            auto* next = next_block(head);
+            delete_block(head);
+            head = next;
+        }
+        size -= count;
+        low = std::min(low, size);
+    }
+};
+
+// Memory of destroyed objects of one size bucket, linked through its first word.
+struct recycle_list
+{
+    void* head{nullptr};
+    uint32_t size{0};
+
+    // Frees all memory of blocks of @p bytes.
+    void release(size_t bytes)
+    {
+        detail::track_memory(MemoryCategory::RecycledObjects, -static_cast<ptrdiff_t>(size * bytes),
+                             -static_cast<ptrdiff_t>(size));
+        while (head) {
+            void* next = *static_cast<void**>(head);
+            detail::velk_free(head, alignof(std::max_align_t), MemoryTag::Objects);
+            head = next;
+        }
+        size = 0;
+    }
+};
+
+// BlockPoolStats fields, counted by each pool's own thread.
+enum pool_counter : size_t
+{
+    pool_hits,
+    pool_misses,
+    pool_refills,
+    pool_spills,
+    pool_overflows,
+    pool_trimmed,
+    pool_counter_count
+};
+
+struct pool_counters
+{
+    std::atomic<uint64_t> values[pool_counter_count]{};
+
+    void add_single_writer(pool_counter counter, uint64_t n = 1)
+    {
+        values[counter].store(values[counter].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    void add_shared(const pool_counters& other)
+    {
+        for (size_t i = 0; i < pool_counter_count; ++i) {
+            values[i].fetch_add(other.values[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+};
+
+// What exited threads counted.
+pool_counters g_pool_counters;
+
+struct block_pool
+{
+    block_list<control_block> blocks;
+    block_list<external_control_block> ext_blocks;
+    int32_t capacity{};        // Blocks each list holds before spilling, see BlockPoolConfig.
+    int32_t misses{};          // Misses since the capacity last grew.
+    uint32_t epoch{};          // g_pool_epoch when the pool last checked for idle blocks.
+    uint32_t idle{};           // update() calls since the low marks were reset.
+    pool_counters counters;    // Counted by the owning thread.
+    memory_cells memory;       // Memory counted by the owning thread.
+    recycle_list recycled[recycle_buckets]; // Memory of destroyed VELK_RECYCLE_INSTANCES() objects.
+    uint32_t recycle_trims{};  // g_recycle_trims when the recycled memory was last freed.
+    Arena frame;               // The thread's frame_arena().
+    block_pool* prev{nullptr}; // Links of g_pools.
+    block_pool* next{nullptr};
+};
+
+// Every live pool, so get_tracked_memory() can sum their cells.
+std::mutex g_pools_mutex;
+block_pool* g_pools{nullptr};
+
+block_pool* new_pool()
+{
+    auto* pool = new block_pool;
+    pool->capacity = g_pool_capacity.load(std::memory_order_relaxed);
+    pool->epoch = g_pool_epoch.load(std::memory_order_relaxed);
+    pool->recycle_trims = g_recycle_trims.load(std::memory_order_relaxed);
+    std::lock_guard lock(g_pools_mutex);
+    pool->next = g_pools;
+    if (g_pools) {
+        g_pools->prev = pool;
+    }
+    g_pools = pool;
+    return pool;
+}
+
+// Keeps the memory and counters of the pool's thread in g_memory and g_pool_counters.
+void delete_pool(block_pool* pool)
+{
+    {
+        std::lock_guard lock(g_pools_mutex);
+        for (size_t i = 0; i < memory_categories; ++i) {
+            g_memory.add_shared(i, pool->memory.bytes[i].load(std::memory_order_relaxed),
+                                pool->memory.count[i].load(std::memory_order_relaxed));
+        }
+        g_pool_counters.add_shared(pool->counters);
+        if (pool->prev) {
+            pool->prev->next = pool->next;
+        } else {
+            g_pools = pool->next;
+        }
+        if (pool->next) {
+            pool->next->prev = pool->prev;
+        }
+    }
+    delete pool;
+}
+
+// Batches of pooled blocks shared by all threads, so that blocks released on a consumer thread
+// are reused by the producer instead of going back to the allocator. Each slot holds a list of
+// block_batch_size blocks or null. A thread takes a batch by exchanging its slot with null, so
+// unlike popping from a shared list there is no ABA problem and no lock.
+template <class Block>
+struct block_depot
+{
+    std::atomic<Block*> slots[block_depot_slots]{};
+
+    ~block_depot()
+    {
+        for (auto& slot : slots) {
+            block_list<Block> batch;
+            batch.head = slot.exchange(nullptr, std::memory_order_acquire);
+            if (batch.head) {
+                batch.size = block_batch_size;
+                batch.release(block_batch_size);
+            }
+        }
+    }
+
+    bool has_room() const
+    {
+        for (auto& slot : slots) {
+            if (!slot.load(std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool push(Block* batch)
+    {
+        for (auto& slot : slots) {
+            Block* expected = nullptr;
+            if (!slot.load(std::memory_order_relaxed) &&
+                slot.compare_exchange_strong(expected, batch, std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Block* pop()
+    {
+        for (auto& slot : slots) {
+            if (slot.load(std::memory_order_relaxed)) {
+                if (auto* batch = slot.exchange(nullptr, std::memory_order_acquire)) {
+                    return batch;
+                }
+            }
+        }
+        return nullptr;
+    }
 };
 
+// Destroyed after the TLS keys below, once no pool can reach the depot anymore.
+block_depot<control_block> g_depot;
+block_depot<external_control_block> g_ext_depot;
+
+// Moves the first block_batch_size blocks of a list to the depot. The blocks stay counted as pooled.
+template <class Block>
+bool spill_batch(block_depot<Block>& depot, block_list<Block>& list)
+{
+    if (list.size < block_batch_size || !depot.has_room()) {
+        return false;
+    }
+    auto* last = list.head;
+    for (int32_t i = 1; i < block_batch_size; ++i) {
+        last = next_block(last);
+    }
+    auto* rest = next_block(last);
+    last->set_ptr(nullptr);
+    if (!depot.push(list.head)) {
+        last->set_ptr(rest);
+        return false;
+    }
+    list.head = rest;
+    list.size -= block_batch_size;
+    list.low = std::min(list.low, list.size);
+    return true;
+}
+
+// Refills an empty list with a batch from the depot.
+template <class Block>
+bool take_batch(block_depot<Block>& depot, block_list<Block>& list)
+{
+    auto* batch = depot.pop();
+    if (!batch) {
+        return false;
+    }
+    list.head = batch;
+    list.size = block_batch_size;
+    return true;
+}
+
+bool is_adaptive()
+{
+    return g_pool_max_capacity.load(std::memory_order_relaxed) >
+           g_pool_capacity.load(std::memory_order_relaxed);
+}
+
+// Frees the blocks of an adaptive pool that went unused for BlockPoolConfig::idleUpdates update()
+// calls, down to the configured capacity, and shrinks the capacity by as much.
+void on_new_epoch(block_pool* pool, uint32_t epoch)
+{
+    pool->idle += epoch - pool->epoch;
+    pool->epoch = epoch;
+    if (pool->idle < g_pool_idle_updates.load(std::memory_order_relaxed)) {
+        return;
+    }
+    pool->idle = 0;
+    if (is_adaptive()) {
+        int32_t base = g_pool_capacity.load(std::memory_order_relaxed);
+        auto trim = [&](auto& list) {
+            int32_t count = std::max(0, std::min(list.low, list.size - base));
+            list.release(count);
+            pool->counters.add_single_writer(pool_trimmed, static_cast<uint64_t>(count));
+            return count;
+        };
+        int32_t trimmed = std::max(trim(pool->blocks), trim(pool->ext_blocks));
+        pool->capacity = std::max(base, pool->capacity - trimmed);
+    }
+    pool->blocks.low = pool->blocks.size;
+    pool->ext_blocks.low = pool->ext_blocks.size;
+}
+
+// Called when a block is released, since that is when idle blocks pile up.
+void check_idle(block_pool* pool)
+{
+    uint32_t epoch = g_pool_epoch.load(std::memory_order_relaxed);
+    if (epoch != pool->epoch) {
+        on_new_epoch(pool, epoch);
+    }
+}
+
+// An adaptive pool grows by a batch for every batch of allocations it could not serve.
+void grow_on_miss(block_pool* pool)
+{
+    int32_t max = g_pool_max_capacity.load(std::memory_order_relaxed);
+    if (max > pool->capacity && ++pool->misses >= block_batch_size) {
+        pool->capacity = std::min(max, pool->capacity + block_batch_size);
+        pool->misses = 0;
+    }
+}
+
+// Picks up capacity changes made with set_block_pool_config().
+void sync_capacity(block_pool* pool)
+{
+    int32_t base = g_pool_capacity.load(std::memory_order_relaxed);
+    int32_t max = g_pool_max_capacity.load(std::memory_order_relaxed);
+    pool->capacity = max > base ? std::min(std::max(pool->capacity, base), max) : base;
+}
+
+template <class Block>
+Block* pool_alloc(block_pool* pool, block_list<Block>& list, block_depot<Block>& depot)
+{
+    if (!list.head) {
+        if (!take_batch(depot, list)) {
+            pool->counters.add_single_writer(pool_misses);
+            grow_on_miss(pool);
+            return nullptr;
+        }
+        pool->counters.add_single_writer(pool_refills);
+    }
+    pool->counters.add_single_writer(pool_hits);
+    track_pooled<Block>(-1);
+    return list.pop();
+}
+
+template <class Block>
+bool pool_dealloc(block_pool* pool, block_list<Block>& list, block_depot<Block>& depot, Block* block)
+{
+    check_idle(pool);
+    if (list.size >= pool->capacity) {
+        sync_capacity(pool);
+        if (list.size >= pool->capacity) {
+            if (!spill_batch(depot, list)) {
+                pool->counters.add_single_writer(pool_overflows);
+                return false;
+            }
+            pool->counters.add_single_writer(pool_spills);
+        }
+    }
+    list.push(block);
+    track_pooled<Block>(1);
+    return true;
+}
+
+// Hands full batches to the depot for other threads and frees the rest.
 void drain_pool(block_pool* pool)
 {
-    while (pool->head) {
-        auto* next = static_cast<control_block*>(pool->head->get_ptr());
-        delete pool->head;
-        pool->head = next;
+    while (spill_batch(g_depot, pool->blocks)) {
+    }
+    while (spill_batch(g_ext_depot, pool->ext_blocks)) {
+    }
+    pool->blocks.release(pool->blocks.size);
+    pool->ext_blocks.release(pool->ext_blocks.size);
+    for (size_t i = 0; i < recycle_buckets; ++i) {
+        pool->recycled[i].release((i + 1) * recycle_granularity);
+    }
+}
+
+// Returns the recycle list of the calling thread for objects of @p size bytes, or null if they are
+// not recycled. Frees the recycled memory first if trim_recycled_objects() was called since.
+recycle_list* find_recycle_list(block_pool* pool, size_t size)
+{
+    if (!pool || !size || size > recycle_buckets * recycle_granularity) {
+        return nullptr;
     }
-    pool->size = 0;
-    while (pool->ext_head) {
-        auto* next =
-            static_cast<external_control_block*>(static_cast<control_block*>(pool->ext_head->get_ptr()));
-        delete pool->ext_head;
-        pool->ext_head = next;
+    uint32_t trims = g_recycle_trims.load(std::memory_order_relaxed);
+    if (trims != pool->recycle_trims) {
+        pool->recycle_trims = trims;
+        for (size_t i = 0; i < recycle_buckets; ++i) {
+            pool->recycled[i].release((i + 1) * recycle_granularity);
+        }
     }
-    pool->ext_size = 0;
+    return &pool->recycled[(size - 1) / recycle_granularity];
 }
 
 #ifdef _WIN32
@@ -104,7 +902,7 @@ void WINAPI fls_callback(void* data)
     t_cache = nullptr;
     if (auto* pool = static_cast<block_pool*>(data)) {
         drain_pool(pool);
-        delete pool;
+        delete_pool(pool);
     }
 }
 
@@ -152,10 +950,10 @@ block_pool* get_pool_ptr()
     auto* pool = static_cast<block_pool*>(FlsGetValue(g_fls_index));
     if (!pool) {
         // Not in FLS, create a new pool
-        pool = new block_pool;
+        pool = new_pool();
         // Store the pointer to FLS
         if (!FlsSetValue(g_fls_index, pool)) {
-            delete pool;
+            delete_pool(pool);
             return nullptr;
         }
     }
@@ -185,7 +983,7 @@ void pthread_key_callback(void* data)
     }
     auto* pool = static_cast<block_pool*>(data);
     drain_pool(pool);
-    delete pool;
+    delete_pool(pool);
 }
 
 // Global key shared by all threads. Same role as g_fls_index on Windows.
@@ -230,9 +1028,9 @@ block_pool* get_pool_ptr()
     }
     auto* pool = static_cast<block_pool*>(pthread_getspecific(g_pool_key));
     if (!pool) {
-        pool = new block_pool;
+        pool = new_pool();
         if (pthread_setspecific(g_pool_key, pool) != 0) {
-            delete pool;
+            delete_pool(pool);
             return nullptr;
         }
     }
@@ -244,39 +1042,144 @@ block_pool* get_pool_ptr()
 
 } // anonymous namespace
 
+// Counts into the pool of the calling thread if it has one. Only t_cache is consulted, since
+// get_pool_ptr() would create a pool again while a thread's pool is being deleted on exit.
+VELK_EXPORT void detail::track_memory(MemoryCategory category, ptrdiff_t bytes, ptrdiff_t count)
+{
+    if (auto* pool = t_cache) {
+        pool->memory.add_single_writer(static_cast<size_t>(category), bytes, count);
+    } else {
+        g_memory.add_shared(static_cast<size_t>(category), bytes, count);
+    }
+}
+
+VELK_EXPORT MemoryStats detail::get_tracked_memory()
+{
+    MemoryStats stats;
+    std::lock_guard lock(g_pools_mutex);
+    add_cells(stats, g_memory);
+    for (auto* pool = g_pools; pool; pool = pool->next) {
+        add_cells(stats, pool->memory);
+    }
+    return clamp_negative(stats);
+}
+
+VELK_EXPORT void detail::set_block_pool_config(const BlockPoolConfig& config)
+{
+    constexpr uint32_t limit = INT32_MAX;
+    g_pool_capacity.store(static_cast<int32_t>(std::min(config.capacity, limit)), std::memory_order_relaxed);
+    g_pool_max_capacity.store(static_cast<int32_t>(std::min(config.maxCapacity, limit)),
+                              std::memory_order_relaxed);
+    g_pool_idle_updates.store(config.idleUpdates, std::memory_order_relaxed);
+}
+
+VELK_EXPORT BlockPoolConfig detail::get_block_pool_config()
+{
+    BlockPoolConfig config;
+    config.capacity = static_cast<uint32_t>(g_pool_capacity.load(std::memory_order_relaxed));
+    config.maxCapacity = static_cast<uint32_t>(g_pool_max_capacity.load(std::memory_order_relaxed));
+    config.idleUpdates = g_pool_idle_updates.load(std::memory_order_relaxed);
+    return config;
+}
+
+VELK_EXPORT BlockPoolStats detail::get_block_pool_stats()
+{
+    pool_counters sum;
+    {
+        std::lock_guard lock(g_pools_mutex);
+        sum.add_shared(g_pool_counters);
+        for (auto* pool = g_pools; pool; pool = pool->next) {
+            sum.add_shared(pool->counters);
+        }
+    }
+    auto value = [&](pool_counter counter) { return sum.values[counter].load(std::memory_order_relaxed); };
+    BlockPoolStats stats;
+    stats.hits = value(pool_hits);
+    stats.misses = value(pool_misses);
+    stats.refills = value(pool_refills);
+    stats.spills = value(pool_spills);
+    stats.overflows = value(pool_overflows);
+    stats.trimmed = value(pool_trimmed);
+    return stats;
+}
+
+void detail::advance_block_pool_epoch()
+{
+    g_pool_epoch.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Allocates the whole bucket, so that the memory fits any object of the bucket when recycled.
+VELK_EXPORT void* detail::recycle_alloc(size_t size)
+{
+    auto* list = find_recycle_list(get_pool_ptr(), size);
+    if (!list) {
+        return velk_alloc(size, alignof(std::max_align_t), MemoryTag::Objects);
+    }
+    size_t bytes = ((size - 1) / recycle_granularity + 1) * recycle_granularity;
+    if (!list->head) {
+        return velk_alloc(bytes, alignof(std::max_align_t), MemoryTag::Objects);
+    }
+    void* ptr = list->head;
+    list->head = *static_cast<void**>(ptr);
+    --list->size;
+    track_memory(MemoryCategory::RecycledObjects, -static_cast<ptrdiff_t>(bytes), -1);
+    return ptr;
+}
+
+VELK_EXPORT void detail::recycle_free(void* ptr, size_t size, uint32_t capacity)
+{
+    auto* list = find_recycle_list(get_pool_ptr(), size);
+    if (!list || list->size >= capacity) {
+        velk_free(ptr, alignof(std::max_align_t), MemoryTag::Objects);
+        return;
+    }
+    size_t bytes = ((size - 1) / recycle_granularity + 1) * recycle_granularity;
+    *static_cast<void**>(ptr) = list->head;
+    list->head = ptr;
+    ++list->size;
+    track_memory(MemoryCategory::RecycledObjects, static_cast<ptrdiff_t>(bytes), 1);
+}
+
+VELK_EXPORT void detail::trim_recycled_objects()
+{
+    g_recycle_trims.fetch_add(1, std::memory_order_relaxed);
+    // Picks up the new count at once on the calling thread.
+    find_recycle_list(t_cache, 1);
+}
+
+// The frame arena lives in the thread's pool, so it is freed by the same TLS callbacks.
+VELK_EXPORT Arena* frame_arena()
+{
+    auto* pool = get_pool_ptr();
+    return pool ? &pool->frame : nullptr;
+}
+
 // alloc/dealloc fall through to plain new/delete when get_pool_ptr() returns
 // nullptr (FLS/key freed, or allocation failure). This keeps shared_ptr
 // functional during shutdown even after the pool infrastructure is torn down.
 
 VELK_EXPORT control_block* detail::alloc_control_block(bool external)
 {
+    auto* pool = get_pool_ptr();
     if (external) {
-        auto* pool = get_pool_ptr();
-        if (pool && pool->ext_head) {
-            auto* b = pool->ext_head;
-            pool->ext_head = static_cast<external_control_block*>(static_cast<control_block*>(b->get_ptr()));
-            --pool->ext_size;
+        if (auto* b = pool ? pool_alloc(pool, pool->ext_blocks, g_ext_depot) : nullptr) {
             b->strong.store(1, std::memory_order_relaxed);
             b->weak.store(1, std::memory_order_relaxed);
             b->set_ptr(nullptr);
             b->destroy = nullptr;
             return b;
         }
-        auto* b = new external_control_block;
+        auto* b = new_block<external_control_block>();
         b->strong.store(1, std::memory_order_relaxed);
         return b;
     }
-    auto* pool = get_pool_ptr();
-    if (pool && pool->head) {
-        auto* b = pool->head;
-        pool->head = static_cast<control_block*>(b->get_ptr());
-        --pool->size;
+    if (auto* b = pool ? pool_alloc(pool, pool->blocks, g_depot) : nullptr) {
         b->strong.store(1, std::memory_order_relaxed);
         b->weak.store(1, std::memory_order_relaxed);
         b->set_ptr(nullptr);
         return b;
     }
-    auto* b = new control_block;
+    auto* b = new_block<control_block>();
     b->strong.store(1, std::memory_order_relaxed);
     return b;
 }
@@ -296,37 +1199,85 @@ VELK_EXPORT void detail::dealloc_control_block(control_block* block, bool extern
         return;
     }
 
+    auto* pool = get_pool_ptr();
     if (external) {
-        auto* pool = get_pool_ptr();
-        if (!pool || pool->ext_size >= block_pool_max_size) {
-            delete static_cast<external_control_block*>(block);
-            return;
-        }
-        block->set_ptr(pool->ext_head);
-        pool->ext_head = static_cast<external_control_block*>(block);
-        ++pool->ext_size;
+        auto* ecb = static_cast<external_control_block*>(block);
+        if (!pool || !pool_dealloc(pool, pool->ext_blocks, g_ext_depot, ecb)) {
+            delete_block(ecb);
+        }
         return;
     }
-    auto* pool = get_pool_ptr();
-    if (!pool || pool->size >= block_pool_max_size) {
-        delete block;
-        return;
+    if (!pool || !pool_dealloc(pool, pool->blocks, g_depot, block)) {
+        delete_block(block);
     }
-    block->set_ptr(pool->head);
-    pool->head = block;
-    ++pool->size;
 }
 
 #else // !VELK_ENABLE_BLOCK_POOL
 
+VELK_EXPORT void detail::track_memory(MemoryCategory category, ptrdiff_t bytes, ptrdiff_t count)
+{
+    g_memory.add_shared(static_cast<size_t>(category), bytes, count);
+}
+
+VELK_EXPORT MemoryStats detail::get_tracked_memory()
+{
+    MemoryStats stats;
+    add_cells(stats, g_memory);
+    return clamp_negative(stats);
+}
+
+// Without pools the configuration is only stored, and nothing is counted.
+namespace {
+std::mutex g_pool_config_mutex;
+BlockPoolConfig g_pool_config;
+} // namespace
+
+VELK_EXPORT void detail::set_block_pool_config(const BlockPoolConfig& config)
+{
+    std::lock_guard lock(g_pool_config_mutex);
+    g_pool_config = config;
+}
+
+VELK_EXPORT BlockPoolConfig detail::get_block_pool_config()
+{
+    std::lock_guard lock(g_pool_config_mutex);
+    return g_pool_config;
+}
+
+VELK_EXPORT BlockPoolStats detail::get_block_pool_stats()
+{
+    return {};
+}
+
+void detail::advance_block_pool_epoch() {}
+
+// Without pools there is no thread-local storage to keep recycled memory in.
+VELK_EXPORT void* detail::recycle_alloc(size_t size)
+{
+    return velk_alloc(size, alignof(std::max_align_t), MemoryTag::Objects);
+}
+
+VELK_EXPORT void detail::recycle_free(void* ptr, size_t, uint32_t)
+{
+    velk_free(ptr, alignof(std::max_align_t), MemoryTag::Objects);
+}
+
+VELK_EXPORT void detail::trim_recycled_objects() {}
+
+VELK_EXPORT Arena* frame_arena()
+{
+    thread_local Arena arena;
+    return &arena;
+}
+
 VELK_EXPORT control_block* detail::alloc_control_block(bool external)
 {
     if (external) {
-        auto* b = new external_control_block;
+        auto* b = new_block<external_control_block>();
         b->strong.store(1, std::memory_order_relaxed);
         return b;
     }
-    auto* b = new control_block;
+    auto* b = new_block<control_block>();
     b->strong.store(1, std::memory_order_relaxed);
     return b;
 }
@@ -344,9 +1295,9 @@ VELK_EXPORT void detail::dealloc_control_block(control_block* block, bool extern
     }
 
     if (external) {
-        delete static_cast<external_control_block*>(block);
+        delete_block(static_cast<external_control_block*>(block));
     } else {
-        delete block;
+        delete_block(block);
     }
 }
 
@@ -1,30 +1,156 @@
 #include "velk_instance.h"
 
 #include "function.h"
+#include "future.h"
+#include "log_sink.h"
+#include "thread_pool.h"
+#include "hive/object_hive.h"
 #include "hive/raw_hive.h"
 #include "object_storage.h"
 
+#include <velk/ext/any.h>
 #include <velk/interface/types.h>
+#include <velk/trace.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
 
 namespace velk {
 
+/** @brief Converts a steady clock interval to a Duration. */
+static Duration to_duration(std::chrono::steady_clock::duration d)
+{
+    return {std::chrono::duration_cast<std::chrono::microseconds>(d).count()};
+}
+
+/** @brief Returns the lane of DeferredQueues::records that @p priority work is queued in. */
+static size_t lane_index(DeferredPriority priority)
+{
+    switch (priority) {
+    case HighPriority:
+        return 0;
+    case BackgroundPriority:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Read-only any over the inline bytes of a DeferredPropertySet.
+ *
+ * Lets flush_deferred_properties() apply an inline value that IPropertyInternal::apply_trivial_data()
+ * refused through set_value_silent(), so it reaches the backing value by copy_from() like a cloned one.
+ */
+class InlineValueView final : public ext::AnyBase<InlineValueView>
+{
+public:
+    void set_target(const DeferredPropertySet& set) { set_ = &set; }
+
+    array_view<Uid> get_compatible_types() const override { return {&set_->inlineType, 1}; }
+    size_t get_data_size(Uid type) const override { return type == set_->inlineType ? set_->inlineSize : 0; }
+    ReturnValue get_data(void* to, size_t toSize, Uid type) const override
+    {
+        if (!to || type != set_->inlineType || toSize != set_->inlineSize) {
+            return ReturnValue::Fail;
+        }
+        std::memcpy(to, set_->inlineData, toSize);
+        return ReturnValue::Success;
+    }
+    ReturnValue set_data(void const*, size_t, Uid) override { return ReturnValue::Fail; }
+    ReturnValue copy_from(const IAny&) override { return ReturnValue::Fail; }
+
+private:
+    const DeferredPropertySet* set_{};
+};
+
 static IRawHive::Ptr create_metadata_hive()
 {
     auto obj = ext::make_object<RawHiveImpl>();
     auto* hive = static_cast<RawHiveImpl*>(obj.get());
     hive->init(type_uid<ObjectStorage>(), sizeof(ObjectStorage), alignof(ObjectStorage));
+    // Objects are commonly created from worker threads; cache slots per thread to
+    // avoid serializing every metadata container creation on the hive lock.
+    hive->set_magazine_size(32);
     return interface_pointer_cast<IRawHive>(obj);
 }
 
+/** @brief Returns the classes whose instances VelkInstance takes from its object pool. */
+/** @brief Number of member implementations at the start of pooled_classes(). */
+static constexpr size_t POOLED_MEMBER_CLASSES = 4;
+
+static array_view<Uid> pooled_classes()
+{
+    // The member implementations come first.
+    static const Uid classes[] = {ClassId::Property,    ClassId::ArrayProperty, ClassId::Event,
+                                  ClassId::Function,    type_uid<float>(),      type_uid<double>(),
+                                  type_uid<uint8_t>(),  type_uid<uint16_t>(),   type_uid<uint32_t>(),
+                                  type_uid<uint64_t>(), type_uid<int8_t>(),     type_uid<int16_t>(),
+                                  type_uid<int32_t>(),  type_uid<int64_t>(),    type_uid<Duration>()};
+    return {classes, std::size(classes)};
+}
+
+/** @brief True if @p uid is one of the member implementations of pooled_classes(). */
+static bool is_pooled_member(Uid uid)
+{
+    auto classes = pooled_classes();
+    for (size_t i = 0; i < POOLED_MEMBER_CLASSES; ++i) {
+        if (classes[i] == uid) {
+            return true;
+        }
+    }
+    return false;
+}
+
 VelkInstance::VelkInstance()
-    : metadata_hive_(create_metadata_hive()),
+    : object_pool_(pooled_classes()),
+      metadata_hive_(create_metadata_hive()),
       type_registry_(*this),
-      plugin_registry_(*this, type_registry_)
-{}
+      plugin_registry_(*this, type_registry_),
+      binding_registry_(*this)
+{
+    plugin_registry_.set_unload_hook(
+        [](void* self) { static_cast<VelkInstance*>(self)->release_deferred_values(); }, this);
+    type_registry_.set_missing_type_hook(
+        [](void* plugins, Uid uid) { return static_cast<PluginRegistry*>(plugins)->load_provider(uid); },
+        &plugin_registry_);
+}
+
+/** @brief Pool task freeing the memory of the large orphaned hive pages queued so far. */
+static IAny::Ptr reclaim_orphaned_pages(FnArgs)
+{
+    ObjectHive::reclaim_orphaned_page_memory();
+    return {};
+}
 
 VelkInstance::~VelkInstance()
 {
+    // Nothing drains the orphaned page queue from now on; pages released below are freed in place.
+    ObjectHive::set_inline_page_reclaim(true);
+    // The workers may run plugin code and queue deferred work; join them first.
+    thread_pool_ = nullptr;
+    release_deferred_values();
+    // Transforms and handlers may be implemented by plugins.
+    binding_registry_.clear();
     plugin_registry_.shutdown_all();
+    // The arena does not destroy the args of records that were never run.
+    for (auto& shard : deferred_shards_) {
+        for (auto& lane : shard.queued.records) {
+            for (auto& record : lane) {
+                release_arena_args(record);
+            }
+        }
+    }
+    for (auto& frame : carried_) {
+        for (auto& lane : frame.queues.records) {
+            for (auto& record : lane) {
+                release_arena_args(record);
+            }
+        }
+    }
 }
 
 ILog& get_logger(const VelkInstance& instance)
@@ -34,7 +160,7 @@ ILog& get_logger(const VelkInstance& instance)
 
 IObjectStorage* VelkInstance::create_metadata_container(const ClassInfo& info, IInterface* owner) const
 {
-    return metadata_hive_.emplace(info.members, owner);
+    return metadata_hive_.emplace(info.members, info.memberTable, owner, &object_pool_);
 }
 
 void VelkInstance::destroy_metadata_container(IObjectStorage* storage) const
@@ -42,9 +168,31 @@ void VelkInstance::destroy_metadata_container(IObjectStorage* storage) const
     metadata_hive_.deallocate(static_cast<ObjectStorage*>(storage));
 }
 
+IObjectStorage* VelkInstance::construct_metadata_container(void* location, const ClassInfo& info,
+                                                           IInterface* owner) const
+{
+    static_assert(sizeof(ObjectStorage) <= OBJECT_STORAGE_SIZE, "OBJECT_STORAGE_SIZE too small");
+    static_assert(alignof(ObjectStorage) <= OBJECT_STORAGE_ALIGNMENT, "OBJECT_STORAGE_ALIGNMENT too small");
+    return new (location) ObjectStorage(info.members, info.memberTable, owner, &object_pool_);
+}
+
+void VelkInstance::destruct_metadata_container(IObjectStorage* storage) const
+{
+    static_cast<ObjectStorage*>(storage)->~ObjectStorage();
+}
+
 IInterface::Ptr VelkInstance::create(Uid uid, uint32_t flags) const
 {
-    return type_registry_.create(uid, flags);
+    // Pooled instances carry no flags of their own. The member implementations always come
+    // from the pool; the scalar anys only on request, since the allocator's thread cache
+    // creates and releases them faster.
+    if (flags == ObjectFlags::Pooled || (flags == ObjectFlags::None && is_pooled_member(uid))) {
+        IObject::Ptr pooled;
+        if (object_pool_.acquire(uid, 1, &pooled)) {
+            return pooled;
+        }
+    }
+    return type_registry_.create(uid, flags & ~ObjectFlags::Pooled);
 }
 
 IAny::Ptr VelkInstance::create_any(Uid type) const
@@ -78,97 +226,756 @@ IProperty::Ptr VelkInstance::create_property(Uid type, const IAny::Ptr& value, u
 
 void VelkInstance::queue_deferred_tasks(array_view<DeferredTask> tasks) const
 {
-    std::lock_guard lock(deferred_mutex_);
-    deferred_queue_.insert(deferred_queue_.end(), tasks.begin(), tasks.end());
+    auto& shard = local_shard();
+    std::lock_guard lock(shard.mutex);
+    for (auto& task : tasks) {
+        size_t lane = lane_index(task.priority);
+        auto& records = shard.queued.records[lane];
+        if (!task.coalesce) {
+            DeferredRecord record{task.fn, task.args};
+            record.key = task.key;
+            records.push_back(std::move(record));
+            continue;
+        }
+        uint64_t seq = deferred_seq_.fetch_add(1, std::memory_order_relaxed);
+        if (auto* queued = find_coalesced(shard, task.fn.get(), false)) {
+            release_arena_args(*queued);
+            queued->args = task.args;
+            queued->seq = seq;
+            continue;
+        }
+        shard.coalesced_tasks.try_emplace(task.fn.get(), records.size() * DEFERRED_PRIORITY_COUNT + lane);
+        DeferredRecord record{task.fn, task.args};
+        record.coalesced = true;
+        record.seq = seq;
+        record.key = task.key;
+        records.push_back(std::move(record));
+    }
 }
 
-void VelkInstance::queue_deferred_property(DeferredPropertySet task) const
+void VelkInstance::queue_deferred_handlers(const IEvent::ConstPtr& event, FnArgs args, InvokeType type) const
 {
-    std::lock_guard lock(deferred_mutex_);
-    deferred_property_queue_.push_back(std::move(task));
+    if (event) {
+        queue_arena_record(event, args, type, 0, true);
+    }
 }
 
-void VelkInstance::flush_deferred_properties(std::vector<DeferredPropertySet>& propSets) const
+void VelkInstance::queue_deferred_call(const IFunction::ConstPtr& fn, FnArgs args, InvokeType type,
+                                       uint64_t key) const
 {
-    // Coalesce property sets: walk backwards, lock each weak_ptr once, keep last-write-wins.
-    // Entries with null value are notification-only (value already written via set_value_silent).
-    struct CoalescedEntry
+    if (!fn) {
+        return;
+    }
+    if (invoke_mode(type) == Pool) {
+        get_thread_pool()->post(fn, args);
+    } else if (invoke_mode(type) == DeferredOnce) {
+        // A function that is already queued drops the call before its args are cloned.
+        auto* internal = interface_cast<IFunctionInternal>(fn);
+        if (!internal) {
+            queue_arena_record(fn, args, Deferred | invoke_priority(type), key, false);
+        } else if (!internal->set_queued_once(true)) {
+            queue_arena_record(fn, args, type, key, false);
+        }
+    } else {
+        queue_arena_record(fn, args, type, key, false);
+    }
+}
+
+void VelkInstance::queue_arena_record(const IFunction::ConstPtr& fn, FnArgs args, InvokeType type,
+                                      uint64_t key, bool handlers) const
+{
+    // Clone outside the lock: clone() may run user code that queues deferred work itself.
+    constexpr size_t inline_args = 4;
+    IAny::Ptr inline_clones[inline_args];
+    std::vector<IAny::Ptr> heap_clones;
+    IAny::Ptr* clones = inline_clones;
+    if (args.count > inline_args) {
+        heap_clones.resize(args.count);
+        clones = heap_clones.data();
+    }
+    for (size_t i = 0; i < args.count; ++i) {
+        clones[i] = args[i] ? args[i]->clone() : nullptr;
+    }
+
+    auto& shard = local_shard();
+    std::lock_guard lock(shard.mutex);
+    bool coalesce = invoke_mode(type) == DeferredCoalesced;
+    size_t lane = lane_index(invoke_priority(type));
+    auto& records = shard.queued.records[lane];
+    uint64_t seq = coalesce ? deferred_seq_.fetch_add(1, std::memory_order_relaxed) : 0;
+    if (coalesce) {
+        if (auto* queued = find_coalesced(shard, fn.get(), handlers)) {
+            // The replaced args stay in the arena until it is reset.
+            release_arena_args(*queued);
+            queued->args = {};
+            place_arena_args(shard, *queued, clones, args.count);
+            queued->seq = seq;
+            return;
+        }
+        auto& index = handlers ? shard.coalesced_handlers : shard.coalesced_tasks;
+        index.try_emplace(fn.get(), records.size() * DEFERRED_PRIORITY_COUNT + lane);
+    }
+    DeferredRecord record;
+    record.fn = fn;
+    record.handlers = handlers;
+    record.coalesced = coalesce;
+    record.once = invoke_mode(type) == DeferredOnce;
+    record.seq = seq;
+    record.key = key;
+    place_arena_args(shard, record, clones, args.count);
+    records.push_back(std::move(record));
+}
+
+void VelkInstance::place_arena_args(DeferredShard& shard, DeferredRecord& record, IAny::Ptr* clones,
+                                    size_t count)
+{
+    if (!count) {
+        return;
+    }
+    // [ IAny::Ptr owned[count] | const IAny* view[count] ]
+    size_t size = count * (sizeof(IAny::Ptr) + sizeof(const IAny*));
+    void* mem = shard.queued.arena.allocate(size, alignof(IAny::Ptr));
+    record.arena_args = static_cast<IAny::Ptr*>(mem);
+    auto** view = reinterpret_cast<const IAny**>(record.arena_args + count);
+    for (size_t i = 0; i < count; ++i) {
+        new (record.arena_args + i) IAny::Ptr(std::move(clones[i]));
+        view[i] = record.arena_args[i].get();
+    }
+    record.arena_count = count;
+}
+
+VelkInstance::DeferredRecord* VelkInstance::find_coalesced(DeferredShard& shard, const IFunction* fn,
+                                                           bool handlers)
+{
+    auto& index = handlers ? shard.coalesced_handlers : shard.coalesced_tasks;
+    auto* i = index.find(fn);
+    return i ? &shard.queued.records[*i % DEFERRED_PRIORITY_COUNT][*i / DEFERRED_PRIORITY_COUNT] : nullptr;
+}
+
+void VelkInstance::coalesce_across_shards(array_view<DeferredQueues*> frames)
+{
+    // Every shard holds at most one coalesced record per function. The first one, in the
+    // highest lane, keeps its position and takes the args of the latest invocation; the
+    // others are emptied.
+    struct Key
     {
-        IPropertyInternal::Ptr property;
-        IAny* value; // null = notification-only (value already applied)
+        const IFunction* fn;
+        bool handlers;
+        bool operator==(const Key& o) const { return fn == o.fn && handlers == o.handlers; }
     };
-    std::vector<CoalescedEntry> unique;
-    unique.reserve(propSets.size()); // Assume we have mostly unique properties
-    for (auto it = propSets.rbegin(); it != propSets.rend(); ++it) {
-        auto locked = it->property.lock();
-        if (!locked) {
-            continue;
-        }
-        bool found = false;
-        for (auto& u : unique) {
-            if (u.property == locked) {
-                // If existing entry is notification-only but this one has a value,
-                // upgrade to the value entry (last-write-wins for value entries).
-                if (!u.value && it->value) {
-                    u.value = it->value.get();
+    struct KeyHash
+    {
+        size_t operator()(const Key& k) const { return std::hash<const void*>()(k.fn) ^ k.handlers; }
+    };
+    std::unordered_map<Key, DeferredRecord*, KeyHash> first;
+    for (size_t lane = 0; lane < DEFERRED_PRIORITY_COUNT; ++lane) {
+        for (auto* frame : frames) {
+            for (auto& record : frame->records[lane]) {
+                if (!record.coalesced || !record.fn) {
+                    continue;
                 }
-                found = true;
-                break;
+                auto [it, inserted] = first.try_emplace(Key{record.fn.get(), record.handlers}, &record);
+                if (!inserted) {
+                    DeferredRecord& kept = *it->second;
+                    if (record.seq > kept.seq) {
+                        std::swap(kept.args, record.args);
+                        std::swap(kept.arena_args, record.arena_args);
+                        std::swap(kept.arena_count, record.arena_count);
+                        kept.seq = record.seq;
+                    }
+                    // Emptied records are skipped by run_deferred(); their arena args are still released.
+                    record.fn = {};
+                }
+            }
+        }
+    }
+}
+
+void VelkInstance::queue_deferred_property(DeferredPropertySet task) const
+{
+    // The caller holds a reference, so the property is alive and its address identifies it.
+    auto live = task.property.lock();
+    if (!live) {
+        return;
+    }
+    auto& shard = local_shard();
+    std::lock_guard lock(shard.mutex);
+    uint64_t seq = deferred_seq_.fetch_add(1, std::memory_order_relaxed);
+    queue_property_locked(shard, live.get(), std::move(task), seq);
+}
+
+void VelkInstance::queue_deferred_properties(array_view<DeferredPropertySet> tasks) const
+{
+    if (tasks.empty()) {
+        return;
+    }
+    // Properties released while the scope is open stay allocated, so peeked ones are alive.
+    ReclaimScope scope;
+    auto& shard = local_shard();
+    std::lock_guard lock(shard.mutex);
+    uint64_t seq = deferred_seq_.fetch_add(tasks.size(), std::memory_order_relaxed);
+    for (auto& task : tasks) {
+        if (auto* live = task.property.peek(scope)) {
+            queue_property_locked(shard, live, task, seq);
+        }
+        ++seq;
+    }
+}
+
+void VelkInstance::queue_property_locked(DeferredShard& shard, const IPropertyInternal* live,
+                                         DeferredPropertySet task, uint64_t seq) const
+{
+    auto& sets = shard.queued.property_sets;
+    auto& seqs = shard.queued.property_seq;
+    auto [index, inserted] = shard.property_index.try_emplace(live, sets.size());
+    if (inserted) {
+        sets.push_back(std::move(task));
+        seqs.push_back(seq);
+        return;
+    }
+    auto& queued = sets[*index];
+    // A notification-only set keeps the queued value, which has not been applied yet, unless
+    // the queued property died and its address was reused by this one.
+    if (task.has_value() || queued.property.expired()) {
+        recycle_value(shard.values, queued, deferred_retain_limit_.load(std::memory_order_relaxed));
+        queued = std::move(task);
+        seqs[*index] = seq;
+    }
+}
+
+IAny::Ptr VelkInstance::acquire_deferred_value(const IAny& prototype) const
+{
+    auto types = prototype.get_compatible_types();
+    if (!types.empty()) {
+        auto& shard = local_shard();
+        std::lock_guard lock(shard.mutex);
+        auto& pool = shard.values;
+        auto it = pool.count ? pool.values.find(types[0]) : pool.values.end();
+        if (it != pool.values.end() && !it->second.empty()) {
+            // A value of another any class may share the first type; only reuse an exact match.
+            auto pooled = it->second.back()->get_compatible_types();
+            if (std::equal(types.begin(), types.end(), pooled.begin(), pooled.end())) {
+                IAny::Ptr value = std::move(it->second.back());
+                it->second.pop_back();
+                --pool.count;
+                return value;
             }
         }
-        if (!found) {
-            unique.push_back({std::move(locked), it->value.get()});
+    }
+    // Clone outside the lock: clone() may run user code that queues deferred work itself.
+    return prototype.clone();
+}
+
+void VelkInstance::recycle_value(ValuePool& pool, DeferredPropertySet& set, size_t limit)
+{
+    if (!set.recycle || !set.value || pool.count >= limit) {
+        return;
+    }
+    auto types = set.value->get_compatible_types();
+    if (!types.empty()) {
+        pool.values[types[0]].push_back(std::move(set.value));
+        ++pool.count;
+    }
+}
+
+void VelkInstance::collect_values(DeferredQueues& queues, size_t limit)
+{
+    for (auto& set : queues.property_sets) {
+        recycle_value(queues.applied, set, limit);
+    }
+    queues.property_sets.clear();
+    queues.property_seq.clear();
+}
+
+void VelkInstance::merge_values(ValuePool& into, ValuePool& from, size_t limit)
+{
+    for (auto& [type, values] : from.values) {
+        auto& target = into.values[type];
+        size_t take = std::min(values.size(), limit > into.count ? limit - into.count : 0);
+        std::move(values.begin(), values.begin() + static_cast<ptrdiff_t>(take), std::back_inserter(target));
+        into.count += take;
+        values.clear();
+    }
+    from.count = 0;
+}
+
+void VelkInstance::release_deferred_values()
+{
+    // Destroy outside the locks, the anys may run user code.
+    std::vector<ValuePool> released;
+    auto release = [&](ValuePool& pool) {
+        if (pool.count) {
+            released.emplace_back().values.swap(pool.values);
+            pool.count = 0;
+        }
+    };
+    for (auto& shard : deferred_shards_) {
+        std::lock_guard lock(shard.mutex);
+        release(shard.values);
+    }
+    std::lock_guard lock(carried_mutex_);
+    for (auto& frame : carried_) {
+        release(frame.queues.applied);
+    }
+}
+
+size_t VelkInstance::flush_deferred_properties(array_view<DeferredQueues*> frames,
+                                               UpdateTimings& timings) const
+{
+    VELK_TRACE_ZONE("VelkInstance::flush_deferred_properties");
+    auto start = std::chrono::steady_clock::now();
+    // Borrow the scratch buffers; a nested update() from an on_changed handler gets fresh ones.
+    PropertyFlushScratch scratch;
+    {
+        std::lock_guard lock(flush_scratch_mutex_);
+        std::swap(scratch, flush_scratch_);
+    }
+    // Sets are already unique per property within a frame. Combine those from several frames
+    // by hashing the property, keeping the position of the first and the latest stamped value.
+    // Entries with null value are notification-only (value already written via set_value_silent).
+    // Properties released by a handler are destroyed after the flush, so they need not be locked.
+    ReclaimScope scope;
+    auto& unique = scratch.unique;
+    bool merged = frames.size() > 1;
+    for (auto* frame : frames) {
+        auto& sets = frame->property_sets;
+        for (size_t i = 0; i < sets.size(); ++i) {
+            auto* locked = sets[i].property.peek(scope);
+            if (!locked) {
+                continue;
+            }
+            const DeferredPropertySet* value = sets[i].has_value() ? &sets[i] : nullptr;
+            uint64_t seq = frame->property_seq[i];
+            if (merged) {
+                auto [index, inserted] = scratch.index.try_emplace(locked, unique.size());
+                if (!inserted) {
+                    auto& entry = unique[*index];
+                    if (value && (!entry.value || seq > entry.seq)) {
+                        entry.value = value;
+                        entry.seq = seq;
+                    }
+                    continue;
+                }
+            }
+            unique.push_back({locked, value, seq});
         }
     }
     // First pass: apply all values silently in original queue order, collect those needing notification.
-    std::vector<IPropertyInternal*> notify;
-    notify.reserve(unique.size()); // Assume that values mostly change
-    for (auto it = unique.rbegin(); it != unique.rend(); ++it) {
-        if (it->value) {
-            // Standard deferred write: apply value and notify if changed.
-            if (it->property->set_value_silent(*it->value) == ReturnValue::Success) {
-                notify.push_back(it->property.get());
+    auto& notify = scratch.notify;
+    for (auto& entry : unique) {
+        if (auto* set = entry.value) {
+            // Standard deferred write: apply value and notify if changed. Inline data goes straight
+            // to the State field where possible; unobserved properties then skip the second pass.
+            const IAny* value = set->value.get();
+            if (!value) {
+                auto ret = entry.property->apply_trivial_data(set->inlineData, set->inlineSize, set->inlineType);
+                if (ret != ReturnValue::Refused) {
+                    if (ret == ReturnValue::Success) {
+                        notify.push_back(entry.property);
+                    }
+                    continue;
+                }
+                if (!scratch.inline_view) {
+                    scratch.inline_view = ext::make_object<InlineValueView, IAny>();
+                }
+                static_cast<InlineValueView*>(scratch.inline_view.get())->set_target(*set);
+                value = scratch.inline_view.get();
+            }
+            if (entry.property->set_value_silent(*value) == ReturnValue::Success) {
+                notify.push_back(entry.property);
             }
         } else {
             // Notification-only: value was already written, just fire on_changed.
-            notify.push_back(it->property.get());
+            notify.push_back(entry.property);
         }
     }
+    auto applied = std::chrono::steady_clock::now();
+    timings.properties = to_duration(applied - start);
     // Second pass: fire on_changed for all properties that changed.
     for (auto* prop : notify) {
-        invoke_event(prop->on_changed(), prop->get_any().get());
+        prop->notify_changed();
+    }
+    timings.notifications = to_duration(std::chrono::steady_clock::now() - applied);
+
+    size_t count = unique.size();
+    unique.clear();
+    notify.clear();
+    scratch.index.clear();
+    if (unique.capacity() > deferred_retain_limit_.load(std::memory_order_relaxed)) {
+        scratch = {};
+    }
+    std::lock_guard lock(flush_scratch_mutex_);
+    if (!flush_scratch_.unique.capacity()) {
+        std::swap(scratch, flush_scratch_);
+    }
+    return count;
+}
+
+void VelkInstance::invoke_record(const DeferredRecord& record)
+{
+    if (record.once) {
+        // Cleared first, so a call the task makes to itself queues it for the next update().
+        if (auto* internal = interface_cast<IFunctionInternal>(record.fn)) {
+            internal->set_queued_once(false);
+        }
+    }
+    record.fn->invoke(record_args(record));
+}
+
+FnArgs VelkInstance::record_args(const DeferredRecord& record)
+{
+    if (record.arena_count) {
+        auto* view = reinterpret_cast<const IAny* const*>(record.arena_args + record.arena_count);
+        return {view, record.arena_count};
+    }
+    return record.args ? record.args->view() : FnArgs{};
+}
+
+size_t VelkInstance::run_deferred(std::vector<DeferredRecord>& records, size_t& next, EventBatches& batches,
+                                  std::vector<const DeferredRecord*>* keyed,
+                                  const std::chrono::steady_clock::time_point* deadline)
+{
+    if (next >= records.size()) {
+        return 0;
+    }
+    VELK_TRACE_ZONE("VelkInstance::run_deferred");
+    size_t calls = 0;
+    while (next < records.size()) {
+        // Reading the clock costs about as much as a small task, so only check every few records.
+        if (deadline && calls && (next & 7) == 0 && std::chrono::steady_clock::now() >= *deadline) {
+            break;
+        }
+        auto& record = records[next++];
+        if (!record.handlers) {
+            if (keyed && record.key && record.fn) {
+                if (record.args) {
+                    record.args->view(); // Build the pointer array before tasks share it across threads.
+                }
+                keyed->push_back(&record);
+            } else if (record.fn) {
+                invoke_record(record);
+                ++calls;
+            }
+            continue;
+        }
+        if (auto* event = interface_cast<IFunctionInternal>(record.fn)) {
+            InvokeType type = record.coalesced ? DeferredCoalesced : Deferred;
+            calls += event->invoke_deferred_handlers(record_args(record), type, batches);
+        }
+    }
+    return calls;
+}
+
+size_t VelkInstance::run_keyed(array_view<const DeferredRecord*> records, IExecutor& executor)
+{
+    VELK_TRACE_ZONE("VelkInstance::run_keyed");
+    // Bucket the tasks by key, keeping queue order within a bucket, and run the buckets in
+    // parallel. More buckets than workers balances uneven keys.
+    size_t concurrency = std::max<size_t>(executor.get_concurrency(), 1);
+    size_t bucketCount = std::min(records.size(), concurrency * 4);
+    auto bucket_of = [bucketCount](uint64_t key) {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) % bucketCount;
+    };
+    std::vector<size_t> offsets(bucketCount + 1);
+    for (auto* record : records) {
+        ++offsets[bucket_of(record->key) + 1];
+    }
+    for (size_t b = 0; b < bucketCount; ++b) {
+        offsets[b + 1] += offsets[b];
+    }
+    std::vector<const DeferredRecord*> sorted(records.size());
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (auto* record : records) {
+        sorted[fill[bucket_of(record->key)]++] = record;
+    }
+
+    struct Context
+    {
+        const DeferredRecord* const* sorted;
+        const size_t* offsets;
+    } context{sorted.data(), offsets.data()};
+    executor.parallel_for(bucketCount, &context, [](void* ctx, size_t bucket) {
+        auto& c = *static_cast<Context*>(ctx);
+        for (size_t i = c.offsets[bucket]; i < c.offsets[bucket + 1]; ++i) {
+            invoke_record(*c.sorted[i]);
+        }
+    });
+    return records.size();
+}
+
+void VelkInstance::set_executor(const IExecutor::Ptr& executor)
+{
+    executor_ = executor;
+}
+
+IExecutor::Ptr VelkInstance::get_executor() const
+{
+    return executor_;
+}
+
+void VelkInstance::release_arena_args(DeferredRecord& record)
+{
+    for (size_t i = 0; i < record.arena_count; ++i) {
+        std::destroy_at(record.arena_args + i);
+    }
+    record.arena_count = 0;
+}
+
+void VelkInstance::recycle(DeferredQueues& queues, size_t limit)
+{
+    for (auto& lane : queues.records) {
+        for (auto& record : lane) {
+            release_arena_args(record);
+        }
+        lane.clear();
+        if (lane.capacity() > limit) {
+            std::vector<DeferredRecord>().swap(lane);
+        }
+    }
+    queues.arena.reset();
+    queues.property_sets.clear();
+    queues.property_seq.clear();
+    if (queues.property_sets.capacity() > limit) {
+        std::vector<DeferredPropertySet>().swap(queues.property_sets);
+        std::vector<uint64_t>().swap(queues.property_seq);
     }
 }
 
-void VelkInstance::update(Duration time) const
+void VelkInstance::set_deferred_retain_limit(size_t entries)
 {
+    deferred_retain_limit_.store(entries, std::memory_order_relaxed);
+}
+
+void VelkInstance::add_queue_memory(const DeferredQueues& queues, MemoryCounter& counter)
+{
+    for (auto& lane : queues.records) {
+        counter.bytes += lane.capacity() * sizeof(DeferredRecord);
+        counter.count += lane.size();
+    }
+    counter.bytes += queues.arena.capacity();
+    counter.bytes += queues.property_sets.capacity() * sizeof(DeferredPropertySet);
+    counter.bytes += queues.property_seq.capacity() * sizeof(uint64_t);
+    counter.count += queues.property_sets.size();
+}
+
+void VelkInstance::set_block_pool_config(const BlockPoolConfig& config)
+{
+    detail::set_block_pool_config(config);
+}
+
+BlockPoolConfig VelkInstance::get_block_pool_config() const
+{
+    return detail::get_block_pool_config();
+}
+
+BlockPoolStats VelkInstance::get_block_pool_stats() const
+{
+    return detail::get_block_pool_stats();
+}
+
+void VelkInstance::trim_recycled_objects()
+{
+    detail::trim_recycled_objects();
+}
+
+MemoryStats VelkInstance::get_memory_stats() const
+{
+    auto stats = detail::get_tracked_memory();
+    // The pooled members are counted by the pool rather than one by one. Any values count
+    // themselves, also when taken from the pool.
+    auto classes = pooled_classes();
+    auto& members = stats.categories[static_cast<size_t>(MemoryCategory::RuntimeMembers)];
+    for (size_t i = 0; i < POOLED_MEMBER_CLASSES; ++i) {
+        auto pooled = object_pool_.get_memory(classes[i]);
+        members.bytes += pooled.bytes;
+        members.count += pooled.count;
+    }
+    MemoryCounter deferred;
+    for (auto& shard : deferred_shards_) {
+        std::lock_guard lock(shard.mutex);
+        add_queue_memory(shard.queued, deferred);
+        add_queue_memory(shard.spare, deferred);
+    }
+    {
+        std::lock_guard lock(carried_mutex_);
+        for (auto& frame : carried_) {
+            add_queue_memory(frame.queues, deferred);
+        }
+    }
+    stats.categories[static_cast<size_t>(MemoryCategory::DeferredQueues)] = deferred;
+    return stats;
+}
+
+void VelkInstance::update(Duration time, Duration budget) const
+{
+    VELK_TRACE_ZONE("VelkInstance::update");
+    using Clock = std::chrono::steady_clock;
+    UpdateTimings timings;
+    auto phaseStart = Clock::now();
+
+    // Memory taken from this thread's frame arena during the previous frame is released.
+    if (auto* arena = frame_arena()) {
+        arena->reset();
+    }
+    detail::advance_block_pool_epoch();
+    if (ObjectHive::has_orphaned_page_memory()) {
+        get_thread_pool()->post(create_callback(reclaim_orphaned_pages));
+    }
+
     // Pre-update: let plugins produce work (tasks, deferred property updates).
     auto info = plugin_registry_.pre_update_plugins(time);
+    auto now = Clock::now();
+    timings.preUpdate = to_duration(now - phaseStart);
+    phaseStart = now;
 
-    // Swap the queues under lock, then invoke outside the lock.
-    // Tasks queued during invocation (by deferred handlers) will be picked up at the next update().
-    std::vector<DeferredTask> tasks;
-    std::vector<DeferredPropertySet> propSets;
+    // Work carried over by a previous update() that ran out of budget runs first.
+    std::vector<CarriedFrame> carried;
     {
-        std::lock_guard lock(deferred_mutex_);
-        tasks.swap(deferred_queue_);
-        propSets.swap(deferred_property_queue_);
+        std::lock_guard lock(carried_mutex_);
+        carried.swap(carried_);
     }
 
-    // Run deferred tasks
-    for (auto& task : tasks) {
-        if (task.fn) {
-            task.fn->invoke(task.args ? task.args->view() : FnArgs{});
+    // Swap the shard queues under their locks, then invoke outside the locks.
+    // Tasks queued during invocation (by deferred handlers) will be picked up at the next update().
+    // Producers continue in the spare buffers, which kept their capacity from the previous frame.
+    size_t limit = deferred_retain_limit_.load(std::memory_order_relaxed);
+    DeferredQueues taken[DEFERRED_SHARDS];
+    size_t takenNext[DEFERRED_SHARDS][DEFERRED_PRIORITY_COUNT]{};
+    DeferredQueues* frames[DEFERRED_SHARDS];
+    size_t frameCount = 0;
+    bool anyCoalesced = !carried.empty();
+    for (size_t i = 0; i < DEFERRED_SHARDS; ++i) {
+        auto& shard = deferred_shards_[i];
+        std::lock_guard lock(shard.mutex);
+        if (shard.queued.empty()) {
+            continue;
+        }
+        anyCoalesced |= shard.coalesced_tasks.size() || shard.coalesced_handlers.size();
+        for (auto* index : {&shard.coalesced_tasks, &shard.coalesced_handlers, &shard.property_index}) {
+            // An index is at most half full, so twice the limit matches the queue buffers.
+            if (index->capacity() > 2 * limit) {
+                index->release();
+            } else {
+                index->clear();
+            }
         }
+        taken[i].swap(shard.queued);
+        shard.queued.swap(shard.spare);
+        frames[frameCount++] = &taken[i];
+    }
+    if (anyCoalesced && frameCount + carried.size() > 1) {
+        // A coalesced record carried over takes the args of its latest invocation.
+        std::vector<DeferredQueues*> all;
+        all.reserve(carried.size() + frameCount);
+        for (auto& frame : carried) {
+            all.push_back(&frame.queues);
+        }
+        all.insert(all.end(), frames, frames + frameCount);
+        coalesce_across_shards({all.data(), all.size()});
     }
 
-    // Set deferred properties
-    if (!propSets.empty()) {
-        flush_deferred_properties(propSets);
+    // Run deferred tasks lane by lane until the budget is spent. The batches reference the
+    // arena args and events of the records until they are dispatched.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budget.us);
+    const auto* stop = budget.us > 0 ? &deadline : nullptr;
+    size_t tasksRun = 0;
+    bool outOfBudget = false;
+    EventBatches batches;
+    std::vector<const DeferredRecord*> keyed;
+    auto run = [&](std::vector<DeferredRecord>& records, size_t& next) {
+        if (!outOfBudget) {
+            tasksRun += run_deferred(records, next, batches, executor_ ? &keyed : nullptr, stop);
+            outOfBudget = next < records.size();
+        }
+    };
+    for (size_t lane = 0; lane < DEFERRED_PRIORITY_COUNT; ++lane) {
+        for (auto& frame : carried) {
+            run(frame.queues.records[lane], frame.next[lane]);
+        }
+        for (size_t i = 0; i < frameCount; ++i) {
+            run(frames[i]->records[lane], takenNext[frames[i] - taken][lane]);
+        }
+        // Keyed tasks of a lane finish before the next lane starts.
+        if (!keyed.empty()) {
+            tasksRun += run_keyed({keyed.data(), keyed.size()}, *executor_);
+            keyed.clear();
+        }
+    }
+    tasksRun += batches.dispatch();
+    timings.deferredTasks = to_duration(Clock::now() - phaseStart);
+
+    // Set deferred properties, whatever the budget.
+    size_t propertiesSet = 0;
+    size_t propFrameCount = 0;
+    for (size_t i = 0; i < frameCount; ++i) {
+        if (!frames[i]->property_sets.empty()) {
+            frames[propFrameCount++] = frames[i];
+        }
+    }
+    if (propFrameCount) {
+        propertiesSet = flush_deferred_properties({frames, propFrameCount}, timings);
+    }
+
+    // Re-evaluate bindings whose sources changed since the last update(), including through
+    // the deferred sets just applied.
+    phaseStart = Clock::now();
+    size_t bindingsEvaluated = binding_registry_.evaluate();
+    timings.bindings = to_duration(Clock::now() - phaseStart);
+
+    // Carry over the records the budget did not reach, and hand emptied buffers back to their
+    // shards for the frame after the next.
+    std::vector<CarriedFrame> leftover;
+    size_t tasksPending = 0;
+    auto settle = [&](size_t shardIndex, DeferredQueues& frame, const size_t* next) {
+        size_t pending = 0;
+        bool allocated = frame.property_sets.capacity() || !frame.arena.empty();
+        for (size_t lane = 0; lane < DEFERRED_PRIORITY_COUNT; ++lane) {
+            pending += frame.records[lane].size() - next[lane];
+            allocated |= frame.records[lane].capacity() != 0;
+        }
+        collect_values(frame, limit);
+        if (pending) {
+            for (size_t lane = 0; lane < DEFERRED_PRIORITY_COUNT; ++lane) {
+                auto& records = frame.records[lane];
+                for (size_t i = 0; i < next[lane]; ++i) {
+                    release_arena_args(records[i]);
+                }
+                records.erase(records.begin(), records.begin() + static_cast<ptrdiff_t>(next[lane]));
+            }
+            tasksPending += pending;
+            leftover.push_back({shardIndex, std::move(frame)});
+            return;
+        }
+        if (allocated) {
+            recycle(frame, limit);
+            auto& shard = deferred_shards_[shardIndex];
+            std::lock_guard lock(shard.mutex);
+            merge_values(shard.values, frame.applied, limit);
+            shard.spare.swap(frame);
+        }
+    };
+    for (auto& frame : carried) {
+        settle(frame.shard, frame.queues, frame.next);
+    }
+    for (size_t i = 0; i < DEFERRED_SHARDS; ++i) {
+        settle(i, taken[i], takenNext[i]);
+    }
+    if (!leftover.empty()) {
+        std::lock_guard lock(carried_mutex_);
+        // A nested update() may have carried over newer work in the meantime.
+        std::move(carried_.begin(), carried_.end(), std::back_inserter(leftover));
+        carried_.swap(leftover);
     }
 
     // Post-update: Let plugins observe resolved state.
-    plugin_registry_.post_update_plugins({info, tasks.size(), propSets.size()});
+    timings.plugins = plugin_registry_.get_update_timings();
+    phaseStart = Clock::now();
+    plugin_registry_.post_update_plugins({info, tasksRun, propertiesSet, tasksPending, timings});
+    timings.postUpdate = to_duration(Clock::now() - phaseStart);
+    VELK_TRACE_COUNTER("velk.tasksRun", tasksRun);
+    VELK_TRACE_COUNTER("velk.tasksPending", tasksPending);
+    VELK_TRACE_COUNTER("velk.propertiesSet", propertiesSet);
+    stats_ = {tasksRun, propertiesSet, tasksPending, bindingsEvaluated, timings};
 }
 
 IFuture::Ptr VelkInstance::create_future() const
@@ -176,6 +983,39 @@ IFuture::Ptr VelkInstance::create_future() const
     return interface_pointer_cast<IFuture>(create(ClassId::Future));
 }
 
+IFuture::Ptr VelkInstance::when_all(array_view<IFuture::Ptr> futures) const
+{
+    return FutureImpl::when_all(futures);
+}
+
+IFuture::Ptr VelkInstance::when_any(array_view<IFuture::Ptr> futures) const
+{
+    return FutureImpl::when_any(futures);
+}
+
+IThreadPool::Ptr VelkInstance::create_thread_pool(size_t thread_count) const
+{
+    auto pool = ext::make_object<ThreadPool, IThreadPool>();
+    static_cast<ThreadPool&>(*pool).start(thread_count);
+    return pool;
+}
+
+void VelkInstance::set_thread_pool(const IThreadPool::Ptr& pool)
+{
+    IThreadPool::Ptr replaced;
+    std::lock_guard lock(thread_pool_mutex_);
+    replaced = std::exchange(thread_pool_, pool);
+}
+
+IThreadPool::Ptr VelkInstance::get_thread_pool() const
+{
+    std::lock_guard lock(thread_pool_mutex_);
+    if (!thread_pool_) {
+        thread_pool_ = create_thread_pool(0);
+    }
+    return thread_pool_;
+}
+
 IFunction::Ptr VelkInstance::create_callback(IFunction::CallableFn* fn) const
 {
     auto func = interface_pointer_cast<IFunction>(create(ClassId::Function));
@@ -224,13 +1064,14 @@ void VelkInstance::dispatch(LogLevel level, const char* file, int line, const ch
         sink_->write(level, file, line, message);
         return;
     }
-    // No sink defined, currently writes to stderr regardless of level.
-    static const char* level_names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
-    auto idx = static_cast<int>(level);
-    if (idx < 0 || idx > 3) {
-        idx = 3;
-    }
-    fprintf(stderr, "[%s] %s:%d: %s\n", level_names[idx], file, line, message);
+    write_stderr_log(level, file, line, message);
+}
+
+IAsyncLogSink::Ptr VelkInstance::create_async_sink(const ILogSink::Ptr& target, size_t capacity) const
+{
+    auto sink = ext::make_object<AsyncLogSink, IAsyncLogSink>();
+    static_cast<AsyncLogSink&>(*sink).start(target, capacity);
+    return sink;
 }
 
 } // namespace velk
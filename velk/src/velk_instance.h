@@ -1,21 +1,35 @@
 #ifndef VELK_INSTANCE_H
 #define VELK_INSTANCE_H
 
+#include "binding_registry.h"
+#include "event_batch.h"
+#include "hive/page_allocator.h"
+#include "object_pool.h"
 #include "plugin_registry.h"
+#include "pointer_index.h"
 #include "type_registry.h"
 
 #include <velk/api/hive/raw_hive.h>
+#include <velk/arena.h>
 #include <velk/common.h>
 #include <velk/ext/core_object.h>
 #include <velk/interface/intf_velk.h>
 
+#include <atomic>
+#include <chrono>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace velk {
 
 class ObjectStorage;
 
+namespace detail {
+/** @brief Counts an update() call towards the idle time of the adaptive control block pools. */
+void advance_block_pool_epoch();
+} // namespace detail
+
 /**
  * @brief Singleton implementation of IVelk.
  *
@@ -35,18 +49,44 @@ public:
     IPluginRegistry& plugin_registry() override { return plugin_registry_; }
     const IPluginRegistry& plugin_registry() const override { return plugin_registry_; }
 
+    IBindingRegistry& binding_registry() override { return binding_registry_; }
+    const IBindingRegistry& binding_registry() const override { return binding_registry_; }
+
     ILog& log() override { return *this; }
     const ILog& log() const override { return const_cast<VelkInstance&>(*this); }
 
     IObjectStorage* create_metadata_container(const ClassInfo& info, IInterface* owner) const override;
     void destroy_metadata_container(IObjectStorage* storage) const override;
+    IObjectStorage* construct_metadata_container(void* location, const ClassInfo& info,
+                                                 IInterface* owner) const override;
+    void destruct_metadata_container(IObjectStorage* storage) const override;
     IInterface::Ptr create(Uid uid, uint32_t flags = ObjectFlags::None) const override;
     IAny::Ptr create_any(Uid type) const override;
     IProperty::Ptr create_property(Uid type, const IAny::Ptr& value, uint32_t flags) const override;
     void queue_deferred_tasks(array_view<DeferredTask> tasks) const override;
     void queue_deferred_property(DeferredPropertySet task) const override;
-    void update(Duration time) const override;
+    void queue_deferred_properties(array_view<DeferredPropertySet> tasks) const override;
+    IAny::Ptr acquire_deferred_value(const IAny& prototype) const override;
+    void queue_deferred_call(const IFunction::ConstPtr& fn, FnArgs args, InvokeType type = Deferred,
+                             uint64_t key = 0) const override;
+    void queue_deferred_handlers(const IEvent::ConstPtr& event, FnArgs args,
+                                 InvokeType type = Deferred) const override;
+    void update(Duration time, Duration budget) const override;
+    void set_deferred_retain_limit(size_t entries) override;
+    const UpdateStats& get_update_stats() const override { return stats_; }
+    MemoryStats get_memory_stats() const override;
+    void set_block_pool_config(const BlockPoolConfig& config) override;
+    BlockPoolConfig get_block_pool_config() const override;
+    BlockPoolStats get_block_pool_stats() const override;
+    void trim_recycled_objects() override;
+    void set_executor(const IExecutor::Ptr& executor) override;
+    IExecutor::Ptr get_executor() const override;
     IFuture::Ptr create_future() const override;
+    IFuture::Ptr when_all(array_view<IFuture::Ptr> futures) const override;
+    IFuture::Ptr when_any(array_view<IFuture::Ptr> futures) const override;
+    IThreadPool::Ptr create_thread_pool(size_t thread_count) const override;
+    void set_thread_pool(const IThreadPool::Ptr& pool) override;
+    IThreadPool::Ptr get_thread_pool() const override;
     IFunction::Ptr create_callback(IFunction::CallableFn* fn) const override;
     IFunction::Ptr create_owned_callback(void* context, IFunction::BoundFn* fn,
                                          IFunction::ContextDeleter* deleter) const override;
@@ -55,21 +95,205 @@ public:
     void set_level(LogLevel level) override;
     LogLevel get_level() const override;
     void dispatch(LogLevel level, const char* file, int line, const char* message) override;
+    IAsyncLogSink::Ptr create_async_sink(const ILogSink::Ptr& target, size_t capacity) const override;
 
 private:
-    /** @brief Coalesces and applies queued deferred property sets (last-write-wins). */
-    void flush_deferred_properties(std::vector<DeferredPropertySet>& propSets) const;
+    /** @brief Entry of the deferred queue: a task, or the deferred handlers of one event firing. */
+    struct DeferredRecord
+    {
+        IFunction::ConstPtr fn;        ///< Task function, or event whose deferred handlers to invoke.
+        shared_ptr<DeferredArgs> args; ///< Args of a task from queue_deferred_tasks().
+        IAny::Ptr* arena_args{};       ///< Args cloned into the queue's arena; replaces @c args.
+        size_t arena_count{};          ///< Number of arena_args, followed by the raw pointer array.
+        bool handlers{};               ///< True if fn is an event from queue_deferred_handlers().
+        bool coalesced{};              ///< True if later invocations in the frame replace the args.
+        bool once{};                   ///< True if fn was queued with DeferredOnce.
+        uint64_t seq{};                ///< Stamp of the latest invocation of a coalesced record.
+        uint64_t key{};                ///< Ordering key of a task, see DeferredTask::key.
+    };
+
+    /** @brief Number of deferred queue shards; threads map to them like to hive magazines. */
+    static constexpr size_t DEFERRED_SHARDS = MAGAZINE_COUNT;
+    /** @brief Default of set_deferred_retain_limit(). */
+    static constexpr size_t DEFAULT_DEFERRED_RETAIN_LIMIT = 64 * 1024;
+
+    struct UidHash
+    {
+        size_t operator()(const Uid& uid) const
+        {
+            return static_cast<size_t>(uid.hi ^ (uid.lo * 0x9E3779B97F4A7C15ull));
+        }
+    };
+
+    /** @brief Applied staging values kept for acquire_deferred_value(), by their first compatible type. */
+    struct ValuePool
+    {
+        std::unordered_map<Uid, std::vector<IAny::Ptr>, UidHash> values;
+        size_t count{}; ///< Number of anys in @c values.
+    };
+
+    /** @brief The buffers of deferred work queued for one update() call. */
+    struct DeferredQueues
+    {
+        /// Tasks and event firings in queue order, per lane in the order update() runs them.
+        std::vector<DeferredRecord> records[DEFERRED_PRIORITY_COUNT];
+        Arena arena;                                    ///< Arena of the args in @c records.
+        std::vector<DeferredPropertySet> property_sets; ///< Property sets, one per property.
+        std::vector<uint64_t> property_seq;             ///< Stamp of the latest value in each property set.
+        ValuePool applied; ///< Recyclable values of applied property sets, returned to the shard.
+
+        bool empty() const
+        {
+            for (auto& lane : records) {
+                if (!lane.empty()) {
+                    return false;
+                }
+            }
+            return property_sets.empty();
+        }
+        void swap(DeferredQueues& other) noexcept
+        {
+            for (size_t i = 0; i < DEFERRED_PRIORITY_COUNT; ++i) {
+                records[i].swap(other.records[i]);
+            }
+            arena.swap(other.arena);
+            property_sets.swap(other.property_sets);
+            property_seq.swap(other.property_seq);
+            applied.values.swap(other.applied.values);
+            std::swap(applied.count, other.applied.count);
+        }
+    };
+
+    /**
+     * @brief Deferred work queued by the threads mapped to one shard.
+     *
+     * Each producer thread always uses the same shard, so its work stays in FIFO order,
+     * and up to DEFERRED_SHARDS threads queue work without contending for a lock.
+     * The queues are double-buffered: update() takes @c queued and producers continue in
+     * @c spare, which holds the emptied buffers of the previous frame.
+     */
+    struct alignas(64) DeferredShard
+    {
+        std::mutex mutex;      ///< Guards the members below.
+        DeferredQueues queued; ///< Work queued for the next update() call.
+        DeferredQueues spare;  ///< Empty buffers that keep their capacity, swapped in at update().
+        /// Position in @c queued.records of the coalesced task and coalesced handler record of each
+        /// function, as index * DEFERRED_PRIORITY_COUNT + lane.
+        PointerIndex coalesced_tasks, coalesced_handlers;
+        /// Index in @c queued.property_sets of the set queued for each property.
+        PointerIndex property_index;
+        ValuePool values; ///< Staging values handed out by acquire_deferred_value().
+    };
+
+    /** @brief Deferred records that a time-budgeted update() did not reach, with their args. */
+    struct CarriedFrame
+    {
+        size_t shard;                           ///< Shard the buffers are handed back to once run.
+        DeferredQueues queues;                  ///< The records left to run, and the arena of their args.
+        size_t next[DEFERRED_PRIORITY_COUNT]{}; ///< Index of the next record to run in each lane.
+    };
+
+    /** @brief Reusable buffers of flush_deferred_properties(). */
+    struct PropertyFlushScratch
+    {
+        struct Entry
+        {
+            IPropertyInternal* property;      ///< Peeked under the ReclaimScope of the flush.
+            const DeferredPropertySet* value; ///< Null = notification-only (value already applied).
+            uint64_t seq;
+        };
+        std::vector<Entry> unique;
+        std::vector<IPropertyInternal*> notify;
+        PointerIndex index;
+        IAny::Ptr inline_view; ///< View over the inline value of the set being applied.
+    };
+
+    /** @brief Adds the buffer capacity and queued entries of @p queues to @p counter. */
+    static void add_queue_memory(const DeferredQueues& queues, MemoryCounter& counter);
+
+    /** @brief Returns the calling thread's deferred shard. */
+    DeferredShard& local_shard() const { return deferred_shards_[thread_magazine_index() % DEFERRED_SHARDS]; }
+
+    /**
+     * @brief Runs @p records from index @p next on, adding batch handler invocations to @p batches.
+     * @param next Index of the first record to run. Set to the index of the first record not run.
+     * @param keyed If not null, receives the keyed tasks instead of running them.
+     * @param deadline If not null, stops once this time has passed.
+     * @return The calls made.
+     */
+    static size_t run_deferred(std::vector<DeferredRecord>& records, size_t& next, EventBatches& batches,
+                               std::vector<const DeferredRecord*>* keyed,
+                               const std::chrono::steady_clock::time_point* deadline);
+    /** @brief Runs the keyed tasks @p records on @p executor. Returns the calls made. */
+    static size_t run_keyed(array_view<const DeferredRecord*> records, IExecutor& executor);
+    /** @brief Invokes the task of @p record, allowing a DeferredOnce task to be queued again. */
+    static void invoke_record(const DeferredRecord& record);
+    /** @brief Returns the args of @p record, from its arena or its DeferredArgs. */
+    static FnArgs record_args(const DeferredRecord& record);
+    /** @brief Destroys the arena args of @p record. */
+    static void release_arena_args(DeferredRecord& record);
+    /** @brief Moves @p clones into the arena of @p shard as the args of @p record. Requires its mutex. */
+    static void place_arena_args(DeferredShard& shard, DeferredRecord& record, IAny::Ptr* clones,
+                                 size_t count);
+    /** @brief Clones @p args into the arena of the calling thread's shard and queues them with @p fn. */
+    void queue_arena_record(const IFunction::ConstPtr& fn, FnArgs args, InvokeType type, uint64_t key,
+                            bool handlers) const;
+    /** @brief Returns the coalesced record for @p fn queued in @p shard, or null. Requires its mutex. */
+    static DeferredRecord* find_coalesced(DeferredShard& shard, const IFunction* fn, bool handlers);
+    /** @brief Merges coalesced records for the same function queued from different shards. */
+    static void coalesce_across_shards(array_view<DeferredQueues*> frames);
+    /** @brief Empties @p queues for reuse, freeing buffers that grew beyond @p limit entries. */
+    static void recycle(DeferredQueues& queues, size_t limit);
+    /**
+     * @brief Queues @p task for the live property @p live in @p shard, whose mutex the caller holds,
+     *        coalescing it with a set already queued for the property.
+     */
+    void queue_property_locked(DeferredShard& shard, const IPropertyInternal* live, DeferredPropertySet task,
+                               uint64_t seq) const;
+    /** @brief Moves the value of @p set to @p pool if it is recyclable and the pool holds under @p limit. */
+    static void recycle_value(ValuePool& pool, DeferredPropertySet& set, size_t limit);
+    /** @brief Empties the property sets of @p queues, moving their recyclable values to its applied pool. */
+    static void collect_values(DeferredQueues& queues, size_t limit);
+    /** @brief Moves the values of @p from to @p into, up to @p limit values, and empties @p from. */
+    static void merge_values(ValuePool& into, ValuePool& from, size_t limit);
+    /** @brief Frees the recycled staging values, which may be instances of plugin types. */
+    void release_deferred_values();
+
+    /**
+     * @brief Applies the property sets of @p frames (last-write-wins).
+     *
+     * The sets of one frame are unique per property. Sets of the same property from several
+     * frames are merged, keeping the value with the latest stamp.
+     *
+     * @param timings Receives the time spent applying values and firing notifications.
+     * @return The number of properties set.
+     */
+    size_t flush_deferred_properties(array_view<DeferredQueues*> frames, UpdateTimings& timings) const;
 
+    /// Pooled metadata member implementations and AnyValues of the built-in scalar types.
+    /// Destroyed last, since the storages and objects destroyed before it release members into it.
+    mutable ObjectPool object_pool_;
     mutable RawHive<ObjectStorage>
-        metadata_hive_;                 ///< Pool allocator for ObjectStorage instances (destroyed last).
+        metadata_hive_;                 ///< Pool allocator for ObjectStorage instances.
     LogLevel level_{LogLevel::Info};    ///< Minimum log level (before type_registry_ for init order).
     ILogSink::Ptr sink_;                ///< Custom log sink (empty = default stderr).
     TypeRegistry type_registry_;        ///< Registry of class factories.
     PluginRegistry plugin_registry_;    ///< Registry of loaded plugins.
-    mutable std::mutex deferred_mutex_; ///< Guards @c deferred_queue_.
-    mutable std::vector<DeferredTask> deferred_queue_; ///< Tasks queued for the next update() call.
-    mutable std::vector<DeferredPropertySet>
-        deferred_property_queue_; ///< Property sets queued for the next update() call.
+    /// Property bindings; mutable because update() evaluates them.
+    mutable BindingRegistry binding_registry_;
+    mutable DeferredShard deferred_shards_[DEFERRED_SHARDS]; ///< Deferred work, sharded by producer thread.
+    /// Stamps coalesced work so that the latest write wins when several shards queued it.
+    mutable std::atomic<uint64_t> deferred_seq_{};
+    /// Capacity in entries above which deferred buffers are freed after update().
+    std::atomic<size_t> deferred_retain_limit_{DEFAULT_DEFERRED_RETAIN_LIMIT};
+    IExecutor::Ptr executor_;                       ///< Runs keyed deferred tasks (may be null).
+    mutable UpdateStats stats_;                     ///< Stats of the last update().
+    mutable std::mutex carried_mutex_;              ///< Guards carried_.
+    mutable std::vector<CarriedFrame> carried_;     ///< Work carried over by update(), oldest first.
+    mutable std::mutex flush_scratch_mutex_;        ///< Guards flush_scratch_.
+    mutable PropertyFlushScratch flush_scratch_;    ///< Buffers lent to flush_deferred_properties().
+    mutable std::mutex thread_pool_mutex_;          ///< Guards thread_pool_.
+    mutable IThreadPool::Ptr thread_pool_;          ///< Runs InvokeType::Pool work; created on first use.
 };
 
 } // namespace velk